@@ -26,7 +26,10 @@ ChannelStats::ChannelStats(channel_id_t cid)
       total_bytes_(0),
       prev_total_bytes_(0),
       bytes_per_second_(0),
-      desire_bytes_per_second_() {}
+      desire_bytes_per_second_(),
+      ts_quality_(),
+      shm_fanout_(),
+      dropped_(0) {}
 
 channel_id_t ChannelStats::GetID() const {
   return id_;
@@ -89,4 +92,28 @@ common::media::DesireBytesPerSec ChannelStats::GetDesireBytesPerSecond() const {
   return desire_bytes_per_second_;
 }
 
+void ChannelStats::SetTsQuality(const utils::mpegts::TsQuality& quality) {
+  ts_quality_ = quality;
+}
+
+utils::mpegts::TsQuality ChannelStats::GetTsQuality() const {
+  return ts_quality_;
+}
+
+void ChannelStats::SetShmFanout(const utils::ShmRingFanout& fanout) {
+  shm_fanout_ = fanout;
+}
+
+utils::ShmRingFanout ChannelStats::GetShmFanout() const {
+  return shm_fanout_;
+}
+
+void ChannelStats::SetDropped(uint64_t count) {
+  dropped_ = count;
+}
+
+uint64_t ChannelStats::GetDropped() const {
+  return dropped_;
+}
+
 }  // namespace iptv_cloud
@@ -18,6 +18,9 @@
 
 #include "base/types.h"
 
+#include "utils/mpegts.h"
+#include "utils/shm_ring.h"
+
 namespace iptv_cloud {
 
 class ChannelStats {  // only compile time size fields
@@ -47,6 +50,18 @@ class ChannelStats {  // only compile time size fields
   void SetDesireBytesPerSecond(const common::media::DesireBytesPerSec& bps);
   common::media::DesireBytesPerSec GetDesireBytesPerSecond() const;
 
+  // filled only for inputs with analyze_ts
+  void SetTsQuality(const utils::mpegts::TsQuality& quality);
+  utils::mpegts::TsQuality GetTsQuality() const;
+
+  // filled only for shm:// outputs
+  void SetShmFanout(const utils::ShmRingFanout& fanout);
+  utils::ShmRingFanout GetShmFanout() const;
+
+  // datagrams not sent, filled only for outputs of relay engine
+  void SetDropped(uint64_t count);
+  uint64_t GetDropped() const;
+
  private:
   channel_id_t id_;
 
@@ -56,6 +71,9 @@ class ChannelStats {  // only compile time size fields
   size_t bytes_per_second_;                // bps
 
   common::media::DesireBytesPerSec desire_bytes_per_second_;
+  utils::mpegts::TsQuality ts_quality_;
+  utils::ShmRingFanout shm_fanout_;
+  uint64_t dropped_;
 };
 
 }  // namespace iptv_cloud
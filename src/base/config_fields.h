@@ -51,5 +51,8 @@
 #define ASPECT_RATIO_FIELD "aspect_ratio"
 #define RELAY_AUDIO_FIELD "relay_audio"
 #define RELAY_VIDEO_FIELD "relay_video"
+#define NATIVE_RELAY_FIELD "native_relay"    // udp relay inside service process
+#define ANALYZE_TS_FIELD "analyze_ts"        // mpeg-ts quality counters of inputs
+#define PUBLISH_INPUT_FIELD "publish_input"  // set by service, socket path of input shared with other streams
 
 #define DECKLINK_VIDEO_MODE_FILELD "decklink_video_mode"
@@ -24,3 +24,5 @@
 #define DEFAULT_AVFORMAT false
 
 #define TEST_URL "test"
+#define INTERNAL_URL "internal://"  // input shared by other stream of the same service, unix socket path follows
+#define SHM_URL "shm://"            // muxed output of other stream of the same node, shared ring name follows
@@ -171,6 +171,7 @@
 #define TS_PARSE "tsparse"
 #define AVDEC_H264 "avdec_h264"
 #define TS_DEMUX "tsdemux"
+#define FLV_DEMUX "flvdemux"
 
 #define AVDEC_AC3 "avdec_ac3"
 #define AVDEC_AC3_FIXED "avdec_ac3_fixed"
@@ -185,6 +186,10 @@
 #define MFX_VPP "mfxvpp"
 #define MFX_H264_DEC "mfxh264dec"
 
+#define SHM_SRC "shmsrc"
+#define SHM_SINK "shmsink"
+#define APP_SINK "appsink"
+
 #define SUPPORTED_VIDEO_PARSERS_COUNT 3
 #define SUPPORTED_AUDIO_PARSERS_COUNT 3
 
@@ -98,4 +98,34 @@ bool IsTestInputUrl(const InputUri& url) {
   return url.GetInput() == common::uri::Url(TEST_URL);
 }
 
+bool IsInternalInputUrl(const InputUri& url, std::string* socket_path) {
+  const std::string input = url.GetInput().GetUrl();
+  const size_t prefix_len = SIZEOFMASS(INTERNAL_URL) - 1;
+  if (input.compare(0, prefix_len, INTERNAL_URL) != 0) {
+    return false;
+  }
+
+  if (socket_path) {
+    *socket_path = input.substr(prefix_len);
+  }
+  return true;
+}
+
+InputUri MakeInternalInputUrl(InputUri::uri_id_t id, const std::string& socket_path) {
+  return InputUri(id, common::uri::Url(INTERNAL_URL + socket_path));
+}
+
+bool IsShmInputUrl(const InputUri& url, std::string* name) {
+  const std::string input = url.GetInput().GetUrl();
+  const size_t prefix_len = SIZEOFMASS(SHM_URL) - 1;
+  if (input.compare(0, prefix_len, SHM_URL) != 0) {
+    return false;
+  }
+
+  if (name) {
+    *name = input.substr(prefix_len);
+  }
+  return true;
+}
+
 }  // namespace iptv_cloud
@@ -63,5 +63,8 @@ inline bool operator!=(const InputUri& left, const InputUri& right) {
 }
 
 bool IsTestInputUrl(const InputUri& url);
+bool IsInternalInputUrl(const InputUri& url, std::string* socket_path = nullptr);
+InputUri MakeInternalInputUrl(InputUri::uri_id_t id, const std::string& socket_path);
+bool IsShmInputUrl(const InputUri& url, std::string* name = nullptr);
 
 }  // namespace iptv_cloud
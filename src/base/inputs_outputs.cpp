@@ -38,63 +38,79 @@ bool ConvertFromString(const std::string& output_urls, iptv_cloud::output_t* out
     return false;
   }
 
+  bool res = iptv_cloud::read_output(obj, out);
+  json_object_put(obj);
+  return res;
+}
+
+bool ConvertFromString(const std::string& input_urls, iptv_cloud::input_t* out) {
+  if (!out) {
+    return false;
+  }
+
+  json_object* obj = json_tokener_parse(input_urls.c_str());
+  if (!obj) {
+    return false;
+  }
+
+  bool res = iptv_cloud::read_input(obj, out);
+  json_object_put(obj);
+  return res;
+}
+
+}  // namespace common
+
+namespace iptv_cloud {
+bool read_input(json_object* config_urls, input_t* input) {
+  if (!config_urls || !input) {
+    return false;
+  }
+
   json_object* jurls = nullptr;
-  json_bool jurls_exists = json_object_object_get_ex(obj, FIELD_OUTPUT_URLS, &jurls);
+  json_bool jurls_exists = json_object_object_get_ex(config_urls, FIELD_INPUT_URLS, &jurls);
   if (!jurls_exists) {
-    json_object_put(obj);
     return false;
   }
 
-  iptv_cloud::output_t output;
+  input_t linput;
   int len = json_object_array_length(jurls);
   for (int i = 0; i < len; ++i) {
     json_object* jurl = json_object_array_get_idx(jurls, i);
-    iptv_cloud::OutputUri lurl;
-    common::Error err = lurl.DeSerialize(jurl);
+    InputUri url;
+    common::Error err = url.DeSerialize(jurl);
     if (!err) {
-      output.push_back(lurl);
+      linput.push_back(url);
     }
   }
-  json_object_put(obj);
-  *out = output;
+  *input = linput;
   return true;
 }
 
-bool ConvertFromString(const std::string& input_urls, iptv_cloud::input_t* out) {
-  if (!out) {
-    return false;
-  }
-
-  json_object* obj = json_tokener_parse(input_urls.c_str());
-  if (!obj) {
+bool read_output(json_object* config_urls, output_t* output) {
+  if (!config_urls || !output) {
     return false;
   }
 
   json_object* jurls = nullptr;
-  json_bool jurls_exists = json_object_object_get_ex(obj, FIELD_INPUT_URLS, &jurls);
+  json_bool jurls_exists = json_object_object_get_ex(config_urls, FIELD_OUTPUT_URLS, &jurls);
   if (!jurls_exists) {
-    json_object_put(obj);
     return false;
   }
 
-  iptv_cloud::input_t input;
+  output_t loutput;
   int len = json_object_array_length(jurls);
   for (int i = 0; i < len; ++i) {
     json_object* jurl = json_object_array_get_idx(jurls, i);
-    iptv_cloud::InputUri url;
-    common::Error err = url.DeSerialize(jurl);
+    OutputUri lurl;
+    common::Error err = lurl.DeSerialize(jurl);
     if (!err) {
-      input.push_back(url);
+      loutput.push_back(lurl);
     }
   }
-  json_object_put(obj);
-  *out = input;
+  *output = loutput;
   return true;
 }
 
-}  // namespace common
-
-namespace iptv_cloud {
 bool read_input(const utils::ArgsMap& config, input_t* input) {
   if (!input) {
     return false;
@@ -24,11 +24,17 @@
 
 #include "utils/arg_reader.h"  // for ArgsMap
 
+struct json_object;
+
 namespace iptv_cloud {
 
 typedef std::vector<InputUri> input_t;
 typedef std::vector<OutputUri> output_t;
 
+// from already parsed json, {"urls" : [...]}
+bool read_input(json_object* config_urls, input_t* input);
+bool read_output(json_object* config_urls, output_t* output);
+
 bool read_input(const utils::ArgsMap& config, input_t* input);
 bool read_output(const utils::ArgsMap& config, output_t* output);
 
@@ -24,13 +24,14 @@
 #define FIELD_OUTPUT_ID "id"
 #define FIELD_OUTPUT_URI "uri"
 #define FIELD_OUTPUT_HTTP_ROOT "http_root"
+#define FIELD_OUTPUT_HLS_TYPE "hls_type"
 
 namespace iptv_cloud {
 
 OutputUri::OutputUri() : OutputUri(0, common::uri::Url()) {}
 
 OutputUri::OutputUri(uri_id_t id, const common::uri::Url& output)
-    : base_class(), id_(id), output_(output), http_root_() {}
+    : base_class(), id_(id), output_(output), http_root_(), hls_type_(HLS_PULL) {}
 
 OutputUri::uri_id_t OutputUri::GetID() const {
   return id_;
@@ -56,8 +57,16 @@ void OutputUri::SetHttpRoot(const http_root_t& root) {
   http_root_ = root;
 }
 
+OutputUri::hls_type_t OutputUri::GetHlsType() const {
+  return hls_type_;
+}
+
+void OutputUri::SetHlsType(hls_type_t type) {
+  hls_type_ = type;
+}
+
 bool OutputUri::Equals(const OutputUri& inf) const {
-  return id_ == inf.id_ && output_ == inf.output_ && http_root_ == inf.http_root_;
+  return id_ == inf.id_ && output_ == inf.output_ && http_root_ == inf.http_root_ && hls_type_ == inf.hls_type_;
 }
 
 common::Error OutputUri::DoDeSerialize(json_object* serialized) {
@@ -82,6 +91,12 @@ common::Error OutputUri::DoDeSerialize(json_object* serialized) {
     res.SetHttpRoot(http_root);
   }
 
+  json_object* jhls_type = nullptr;
+  json_bool jhls_type_exists = json_object_object_get_ex(serialized, FIELD_OUTPUT_HLS_TYPE, &jhls_type);
+  if (jhls_type_exists) {
+    res.SetHlsType(static_cast<hls_type_t>(json_object_get_int(jhls_type)));
+  }
+
   *this = res;
   return common::Error();
 }
@@ -94,6 +109,9 @@ common::Error OutputUri::SerializeFields(json_object* out) const {
   std::string url_str = common::ConvertToString(GetOutput());
   json_object_object_add(out, FIELD_OUTPUT_URI, json_object_new_string(url_str.c_str()));
   json_object_object_add(out, FIELD_OUTPUT_HTTP_ROOT, json_object_new_string(http_root_str.c_str()));
+  if (hls_type_ != HLS_PULL) {  // default one is omitted, configs of plain hls stay as they were
+    json_object_object_add(out, FIELD_OUTPUT_HLS_TYPE, json_object_new_int(hls_type_));
+  }
   return common::Error();
 }
 
@@ -101,4 +119,17 @@ bool IsTestOutputUrl(const OutputUri& url) {
   return url.GetOutput() == common::uri::Url(TEST_URL);
 }
 
+bool IsShmOutputUrl(const OutputUri& url, std::string* name) {
+  const std::string output = url.GetOutput().GetUrl();
+  const size_t prefix_len = SIZEOFMASS(SHM_URL) - 1;
+  if (output.compare(0, prefix_len, SHM_URL) != 0) {
+    return false;
+  }
+
+  if (name) {
+    *name = output.substr(prefix_len);
+  }
+  return true;
+}
+
 }  // namespace iptv_cloud
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <string>
+
 #include <common/file_system/path.h>
 #include <common/serializer/json_serializer.h>
 #include <common/uri/url.h>
@@ -27,6 +29,11 @@ class OutputUri : public common::serializer::JsonSerializer<OutputUri> {
   typedef JsonSerializer<OutputUri> base_class;
   typedef common::file_system::ascii_directory_string_path http_root_t;
   typedef channel_id_t uri_id_t;
+  // LL_HLS - low latency packager with partial segments, HLS_MEMORY - the same packager
+  // writing to shared memory served by daemon, no files on disk (live only)
+  enum HlsType { HLS_PULL = 0, LL_HLS, HLS_MEMORY };
+  typedef HlsType hls_type_t;
+
   OutputUri();
   explicit OutputUri(uri_id_t id, const common::uri::Url& output);
 
@@ -39,6 +46,9 @@ class OutputUri : public common::serializer::JsonSerializer<OutputUri> {
   http_root_t GetHttpRoot() const;
   void SetHttpRoot(const http_root_t& root);
 
+  hls_type_t GetHlsType() const;
+  void SetHlsType(hls_type_t type);
+
   bool Equals(const OutputUri& inf) const;
 
  protected:
@@ -49,6 +59,7 @@ class OutputUri : public common::serializer::JsonSerializer<OutputUri> {
   uri_id_t id_;
   common::uri::Url output_;
   http_root_t http_root_;
+  hls_type_t hls_type_;
 };
 
 inline bool operator==(const OutputUri& left, const OutputUri& right) {
@@ -60,5 +71,6 @@ inline bool operator!=(const OutputUri& left, const OutputUri& right) {
 }
 
 bool IsTestOutputUrl(const OutputUri& url);
+bool IsShmOutputUrl(const OutputUri& url, std::string* name = nullptr);
 
 }  // namespace iptv_cloud
@@ -27,6 +27,29 @@ protocol::response_t RestartStreamResponceSuccess(protocol::sequance_id_t id) {
   return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage());
 }
 
+protocol::request_t ReconfigureStreamRequest(protocol::sequance_id_t id, protocol::serializet_params_t params) {
+  protocol::request_t req;
+  req.id = id;
+  req.method = RECONFIGURE_STREAM;
+  req.params = params;
+  return req;
+}
+
+protocol::response_t ReconfigureStreamResponceSuccess(protocol::sequance_id_t id) {
+  return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage());
+}
+
+protocol::request_t ResumeStreamRequest(protocol::sequance_id_t id) {
+  protocol::request_t req;
+  req.id = id;
+  req.method = RESUME_STREAM;
+  return req;
+}
+
+protocol::response_t ResumeStreamResponceSuccess(protocol::sequance_id_t id) {
+  return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage());
+}
+
 protocol::request_t StopStreamRequest(protocol::sequance_id_t id) {
   protocol::request_t req;
   req.id = id;
@@ -38,6 +61,22 @@ protocol::response_t StopStreamResponceSuccess(protocol::sequance_id_t id) {
   return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage());
 }
 
+protocol::request_t GetProfileStreamRequest(protocol::sequance_id_t id) {
+  protocol::request_t req;
+  req.id = id;
+  req.method = GET_PROFILE_STREAM;
+  return req;
+}
+
+protocol::response_t GetProfileStreamResponceSuccess(protocol::sequance_id_t id, const std::string& result) {
+  return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage(result));
+}
+
+protocol::response_t GetProfileStreamResponceFail(protocol::sequance_id_t id, const std::string& error_text) {
+  return protocol::response_t::MakeError(
+      id, common::protocols::json_rpc::JsonRPCError::MakeServerErrorFromText(error_text));
+}
+
 protocol::request_t ChangedSourcesStreamBroadcast(protocol::serializet_params_t params) {
   return protocol::request_t::MakeNotification(CHANGED_SOURCES_STREAM, params);
 }
@@ -46,4 +85,8 @@ protocol::request_t StatisticStreamBroadcast(protocol::serializet_params_t param
   return protocol::request_t::MakeNotification(STATISTIC_STREAM, params);
 }
 
+protocol::request_t RestartScheduleStreamBroadcast(protocol::serializet_params_t params) {
+  return protocol::request_t::MakeNotification(RESTART_SCHEDULE_STREAM, params);
+}
+
 }  // namespace iptv_cloud
@@ -14,24 +14,43 @@
 
 #pragma once
 
+#include <string>
+
 #include "protocol/types.h"
 
 #define STOP_STREAM "stop"
 #define RESTART_STREAM "restart"
+#define RECONFIGURE_STREAM "reconfigure"
+#define RESUME_STREAM "resume"  // restart permitted by service scheduler
+#define GET_PROFILE_STREAM "get_profile"
 
 #define CHANGED_SOURCES_STREAM "changed_source_stream"
 #define STATISTIC_STREAM "statistic_stream"
+#define RESTART_SCHEDULE_STREAM "restart_schedule_stream"
 
 namespace iptv_cloud {
 
 protocol::request_t RestartStreamRequest(protocol::sequance_id_t id);
 protocol::response_t RestartStreamResponceSuccess(protocol::sequance_id_t id);
 
+protocol::request_t ReconfigureStreamRequest(protocol::sequance_id_t id,
+                                             protocol::serializet_params_t params);  // ReconfigureInfo
+protocol::response_t ReconfigureStreamResponceSuccess(protocol::sequance_id_t id);
+
+protocol::request_t ResumeStreamRequest(protocol::sequance_id_t id);
+protocol::response_t ResumeStreamResponceSuccess(protocol::sequance_id_t id);
+
 protocol::request_t StopStreamRequest(protocol::sequance_id_t id);
 protocol::response_t StopStreamResponceSuccess(protocol::sequance_id_t id);
 
+protocol::request_t GetProfileStreamRequest(protocol::sequance_id_t id);
+protocol::response_t GetProfileStreamResponceSuccess(protocol::sequance_id_t id,
+                                                     const std::string& result);  // ProfileInfo
+protocol::response_t GetProfileStreamResponceFail(protocol::sequance_id_t id, const std::string& error_text);
+
 // Broadcast
 protocol::request_t ChangedSourcesStreamBroadcast(protocol::serializet_params_t params);  // ChangedSouresInfo
 protocol::request_t StatisticStreamBroadcast(protocol::serializet_params_t params);       // StatisticInfo
+protocol::request_t RestartScheduleStreamBroadcast(protocol::serializet_params_t params);  // RestartScheduleInfo
 
 }  // namespace iptv_cloud
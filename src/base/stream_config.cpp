@@ -0,0 +1,73 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "base/stream_config.h"
+
+#include <string>
+
+#include "base/config_fields.h"
+
+#include "utils/arg_converter.h"
+
+namespace iptv_cloud {
+
+StreamConfig::StreamConfig()
+    : id(), type(SCREEN), feedback_dir(), log_level(common::logging::LOG_LEVEL_DEBUG), input(), output(), args() {}
+
+bool StreamConfig::IsValid() const {
+  return !id.empty() && type <= SCREEN && !feedback_dir.empty();
+}
+
+bool MakeStreamConfig(const utils::ArgsMap& config_args, StreamConfig* config) {
+  if (!config) {
+    return false;
+  }
+
+  StreamConfig lconfig;
+  for (auto it = config_args.begin(); it != config_args.end(); ++it) {
+    const std::string& key = it->first;
+    const std::string& value = it->second;
+    if (key == ID_FIELD) {
+      lconfig.id = value;
+    } else if (key == TYPE_FIELD) {
+      uint8_t type;
+      if (!common::ConvertFromString(value, &type)) {
+        return false;
+      }
+      lconfig.type = static_cast<StreamType>(type);
+    } else if (key == FEEDBACK_DIR_FIELD) {
+      lconfig.feedback_dir = value;
+    } else if (key == LOG_LEVEL_FIELD) {
+      int log_level;
+      if (common::ConvertFromString(value, &log_level)) {
+        lconfig.log_level = log_level;
+      }
+    } else if (key == INPUT_FIELD) {
+      if (!common::ConvertFromString(value, &lconfig.input)) {
+        return false;
+      }
+    } else if (key == OUTPUT_FIELD) {
+      if (!common::ConvertFromString(value, &lconfig.output)) {
+        return false;
+      }
+    } else {
+      lconfig.args[key] = value;
+    }
+  }
+
+  *config = lconfig;
+  return true;
+}
+
+}  // namespace iptv_cloud
@@ -0,0 +1,47 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+
+#include <common/macros.h>
+
+#include "base/inputs_outputs.h"
+#include "base/types.h"
+
+#include "utils/arg_reader.h"
+
+namespace iptv_cloud {
+
+// Stream config parsed once by the service, child process gets the same object after fork.
+// Fields needed by every stream are typed, type specific options stay in args as validated strings.
+struct StreamConfig {
+  StreamConfig();
+
+  bool IsValid() const;
+
+  stream_id_t id;
+  StreamType type;
+  std::string feedback_dir;
+  int log_level;
+  input_t input;
+  output_t output;
+  utils::ArgsMap args;
+};
+
+// for configs built as ArgsMap (tests, tools)
+bool MakeStreamConfig(const utils::ArgsMap& config_args, StreamConfig* config) WARN_UNUSED_RESULT;
+
+}  // namespace iptv_cloud
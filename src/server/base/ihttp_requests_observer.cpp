@@ -20,6 +20,11 @@ namespace base {
 
 void IHttpRequestsObserver::OnHttpRequest(common::libev::http::HttpClient* client, const file_path_t& file) {}
 
+bool IHttpRequestsObserver::IsFileInProgress(const file_path_t& file) const {
+  UNUSED(file);
+  return false;
+}
+
 IHttpRequestsObserver::~IHttpRequestsObserver() {}
 
 }  // namespace base
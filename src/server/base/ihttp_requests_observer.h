@@ -26,6 +26,8 @@ class IHttpRequestsObserver {
   typedef common::file_system::ascii_file_string_path file_path_t;
 
   virtual void OnHttpRequest(common::libev::http::HttpClient* client, const file_path_t& file) = 0;
+  // file will be produced later (vod transcoding in flight), requests for it can be held
+  virtual bool IsFileInProgress(const file_path_t& file) const;
   virtual ~IHttpRequestsObserver();
 };
 
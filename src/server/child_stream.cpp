@@ -14,6 +14,8 @@
 
 #include "server/child_stream.h"
 
+#include <stdlib.h>
+
 #include "base/stream_commands.h"
 #include "base/stream_struct.h"
 
@@ -52,13 +54,41 @@ common::ErrnoError Child::SendRestart(protocol::sequance_id_t id) {
   return client_->WriteRequest(req);
 }
 
+common::ErrnoError Child::SendReconfigure(protocol::sequance_id_t id, protocol::serializet_params_t params) {
+  if (!client_) {
+    return common::make_errno_error_inval();
+  }
+
+  protocol::request_t req = ReconfigureStreamRequest(id, params);
+  return client_->WriteRequest(req);
+}
+
+common::ErrnoError Child::SendResume(protocol::sequance_id_t id) {
+  if (!client_) {
+    return common::make_errno_error_inval();
+  }
+
+  protocol::request_t req = ResumeStreamRequest(id);
+  return client_->WriteRequest(req);
+}
+
+common::ErrnoError Child::SendGetProfile(protocol::sequance_id_t id) {
+  if (!client_) {
+    return common::make_errno_error_inval();
+  }
+
+  protocol::request_t req = GetProfileStreamRequest(id);
+  return client_->WriteRequest(req);
+}
+
 ChildVod::ChildVod(common::libev::IoLoop* server, stream_id_t vid) : base_class(server, VOD), vid_(vid) {}
 
 stream_id_t ChildVod::GetStreamID() const {
   return vid_;
 }
 
-ChildStream::ChildStream(common::libev::IoLoop* server, StreamStruct* mem) : base_class(server, STREAM), mem_(mem) {}
+ChildStream::ChildStream(common::libev::IoLoop* server, StreamStruct* mem, bool adopted)
+    : base_class(server, STREAM), mem_(mem), adopted_(adopted), exit_status_(EXIT_FAILURE) {}
 
 stream_id_t ChildStream::GetStreamID() const {
   return mem_->id;
@@ -68,5 +98,17 @@ StreamStruct* ChildStream::GetMem() const {
   return mem_;
 }
 
+bool ChildStream::IsAdopted() const {
+  return adopted_;
+}
+
+int ChildStream::GetExitStatus() const {
+  return exit_status_;
+}
+
+void ChildStream::SetExitStatus(int status) {
+  exit_status_ = status;
+}
+
 }  // namespace server
 }  // namespace iptv_cloud
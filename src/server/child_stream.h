@@ -38,6 +38,10 @@ class Child : public common::libev::IoChild {
 
   common::ErrnoError SendStop(protocol::sequance_id_t id) WARN_UNUSED_RESULT;
   common::ErrnoError SendRestart(protocol::sequance_id_t id) WARN_UNUSED_RESULT;
+  common::ErrnoError SendReconfigure(protocol::sequance_id_t id,
+                                     protocol::serializet_params_t params) WARN_UNUSED_RESULT;  // ReconfigureInfo
+  common::ErrnoError SendResume(protocol::sequance_id_t id) WARN_UNUSED_RESULT;
+  common::ErrnoError SendGetProfile(protocol::sequance_id_t id) WARN_UNUSED_RESULT;
 
   client_t* GetClient() const;
   void SetClient(client_t* pipe);
@@ -61,14 +65,22 @@ class ChildVod : public Child {
 class ChildStream : public Child {
  public:
   typedef Child base_class;
-  ChildStream(common::libev::IoLoop* server, StreamStruct* mem);
+  // adopted stream was forked by previous service instance, its memory is not shared with service
+  ChildStream(common::libev::IoLoop* server, StreamStruct* mem, bool adopted = false);
 
   stream_id_t GetStreamID() const override;
 
   StreamStruct* GetMem() const;
+  bool IsAdopted() const;
+
+  // reported by process before exit, adopted process can't be waited by service
+  int GetExitStatus() const;
+  void SetExitStatus(int status);
 
  private:
   StreamStruct* const mem_;
+  const bool adopted_;
+  int exit_status_;
 
   DISALLOW_COPY_AND_ASSIGN(ChildStream);
 };
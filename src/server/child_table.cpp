@@ -0,0 +1,182 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/child_table.h"
+
+#include <errno.h>
+#include <stdio.h>
+
+#include <fstream>
+#include <sstream>
+
+#include <json-c/json_object.h>
+#include <json-c/json_tokener.h>
+
+#define CHILD_TABLE_ID_FIELD "id"
+#define CHILD_TABLE_PID_FIELD "pid"
+#define CHILD_TABLE_SHARED_INPUT_FIELD "shared_input"
+#define CHILD_TABLE_PUBLISHER_FIELD "publisher"
+
+namespace iptv_cloud {
+namespace server {
+
+ChildTable::ChildTable() : children_() {}
+
+void ChildTable::Add(stream_id_t sid, pid_t pid) {
+  children_[sid] = {sid, pid, std::string(), false};
+}
+
+void ChildTable::SetSharedInput(stream_id_t sid, const std::string& original_config, bool publisher) {
+  auto it = children_.find(sid);
+  if (it == children_.end()) {
+    return;
+  }
+
+  it->second.shared_input = original_config;
+  it->second.publisher = !original_config.empty() && publisher;
+}
+
+void ChildTable::Remove(stream_id_t sid) {
+  children_.erase(sid);
+}
+
+bool ChildTable::Find(stream_id_t sid, pid_t* pid) const {
+  const auto it = children_.find(sid);
+  if (it == children_.end()) {
+    return false;
+  }
+
+  if (pid) {
+    *pid = it->second.pid;
+  }
+  return true;
+}
+
+std::vector<ChildTable::Entry> ChildTable::GetEntries() const {
+  std::vector<Entry> entries;
+  for (const auto& child : children_) {
+    entries.push_back(child.second);
+  }
+  return entries;
+}
+
+size_t ChildTable::GetSize() const {
+  return children_.size();
+}
+
+std::string ChildTable::Serialize() const {
+  json_object* jchildren = json_object_new_array();
+  for (const auto& child : children_) {
+    json_object* jchild = json_object_new_object();
+    json_object_object_add(jchild, CHILD_TABLE_ID_FIELD, json_object_new_string(child.first.c_str()));
+    json_object_object_add(jchild, CHILD_TABLE_PID_FIELD, json_object_new_int64(child.second.pid));
+    if (!child.second.shared_input.empty()) {
+      json_object_object_add(jchild, CHILD_TABLE_SHARED_INPUT_FIELD,
+                             json_object_new_string(child.second.shared_input.c_str()));
+      json_object_object_add(jchild, CHILD_TABLE_PUBLISHER_FIELD, json_object_new_boolean(child.second.publisher));
+    }
+    json_object_array_add(jchildren, jchild);
+  }
+
+  const std::string result = json_object_to_json_string(jchildren);
+  json_object_put(jchildren);
+  return result;
+}
+
+bool ChildTable::Parse(const std::string& data) {
+  json_object* jchildren = json_tokener_parse(data.c_str());
+  if (!jchildren) {
+    return false;
+  }
+
+  if (!json_object_is_type(jchildren, json_type_array)) {
+    json_object_put(jchildren);
+    return false;
+  }
+
+  std::map<stream_id_t, Entry> children;
+  const size_t len = json_object_array_length(jchildren);
+  for (size_t i = 0; i < len; ++i) {
+    json_object* jchild = json_object_array_get_idx(jchildren, i);
+    json_object* jid = nullptr;
+    json_object* jpid = nullptr;
+    if (!json_object_object_get_ex(jchild, CHILD_TABLE_ID_FIELD, &jid) ||
+        !json_object_object_get_ex(jchild, CHILD_TABLE_PID_FIELD, &jpid)) {
+      json_object_put(jchildren);
+      return false;
+    }
+
+    const pid_t pid = json_object_get_int64(jpid);
+    if (pid <= 0) {
+      json_object_put(jchildren);
+      return false;
+    }
+    Entry entry = {json_object_get_string(jid), pid, std::string(), false};
+    json_object* jshared_input = nullptr;
+    if (json_object_object_get_ex(jchild, CHILD_TABLE_SHARED_INPUT_FIELD, &jshared_input)) {
+      entry.shared_input = json_object_get_string(jshared_input);
+      json_object* jpublisher = nullptr;
+      if (json_object_object_get_ex(jchild, CHILD_TABLE_PUBLISHER_FIELD, &jpublisher)) {
+        entry.publisher = json_object_get_boolean(jpublisher);
+      }
+    }
+    children[entry.id] = entry;
+  }
+
+  json_object_put(jchildren);
+  children_ = children;
+  return true;
+}
+
+common::ErrnoError ChildTable::Save(const std::string& path) const {
+  const std::string temp_path = path + ".tmp";
+  {
+    std::ofstream file(temp_path, std::ios::trunc);
+    if (!file) {
+      return common::make_errno_error(errno);
+    }
+
+    file << Serialize();
+    file.flush();
+    if (!file) {
+      const int err = errno;
+      remove(temp_path.c_str());
+      return common::make_errno_error(err);
+    }
+  }
+
+  if (rename(temp_path.c_str(), path.c_str()) == -1) {
+    const int err = errno;
+    remove(temp_path.c_str());
+    return common::make_errno_error(err);
+  }
+  return common::ErrnoError();
+}
+
+common::ErrnoError ChildTable::Load(const std::string& path) {
+  std::ifstream file(path);
+  if (!file) {
+    return common::make_errno_error(errno);
+  }
+
+  std::stringstream data;
+  data << file.rdbuf();
+  if (!Parse(data.str())) {
+    return common::make_errno_error("Invalid child table: " + path, EINVAL);
+  }
+  return common::ErrnoError();
+}
+
+}  // namespace server
+}  // namespace iptv_cloud
@@ -0,0 +1,66 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <common/error.h>
+
+#include "base/types.h"
+
+namespace iptv_cloud {
+namespace server {
+
+// stream children of the service, persisted in run directory:
+// next service instance started after crash or upgrade adopts only processes listed here
+// and restores their roles in shared inputs.
+// streams relayed inside service process are not listed, they stop with the service.
+class ChildTable {
+ public:
+  struct Entry {
+    stream_id_t id;
+    pid_t pid;
+    std::string shared_input;  // original config of stream sharing its input, empty if input is not shared
+    bool publisher;
+  };
+
+  ChildTable();
+
+  // replaces previous process of the stream
+  void Add(stream_id_t sid, pid_t pid);
+  void SetSharedInput(stream_id_t sid, const std::string& original_config, bool publisher);
+  void Remove(stream_id_t sid);
+  bool Find(stream_id_t sid, pid_t* pid) const;
+  std::vector<Entry> GetEntries() const;
+  size_t GetSize() const;
+
+  std::string Serialize() const;
+  // table is not changed by invalid data
+  bool Parse(const std::string& data);
+
+  // via temporary file and rename, readers never see partial table
+  common::ErrnoError Save(const std::string& path) const WARN_UNUSED_RESULT;
+  common::ErrnoError Load(const std::string& path) WARN_UNUSED_RESULT;
+
+ private:
+  std::map<stream_id_t, Entry> children_;
+};
+
+}  // namespace server
+}  // namespace iptv_cloud
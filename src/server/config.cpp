@@ -27,6 +27,12 @@
 #define SERVICE_SUBSCRIBERS_HOST_FIELD "subscribers_host"
 #define SERVICE_BANDWIDTH_HOST_FIELD "bandwidth_host"
 #define SERVICE_TTL_FILES_FIELD "ttl_files"
+#define SERVICE_RELAY_WORKERS_FIELD "relay_workers"
+#define SERVICE_STARTUP_BUDGET_FIELD "startup_budget"
+#define SERVICE_HISTORY_BUDGET_FIELD "history_budget"
+#define SERVICE_SHARE_INPUTS_FIELD "share_inputs"
+#define SERVICE_CPU_PLACEMENT_FIELD "cpu_placement"
+#define SERVICE_CPUSET_CGROUP_FIELD "cpuset_cgroup"
 
 #define DUMMY_LOG_FILE_PATH "/dev/null"
 
@@ -65,6 +71,18 @@ common::ErrnoError ReadSlaveConfig(const std::string& path, iptv_cloud::utils::A
       options.insert(pair);
     } else if (pair.first == SERVICE_TTL_FILES_FIELD) {
       options.insert(pair);
+    } else if (pair.first == SERVICE_RELAY_WORKERS_FIELD) {
+      options.insert(pair);
+    } else if (pair.first == SERVICE_STARTUP_BUDGET_FIELD) {
+      options.insert(pair);
+    } else if (pair.first == SERVICE_HISTORY_BUDGET_FIELD) {
+      options.insert(pair);
+    } else if (pair.first == SERVICE_SHARE_INPUTS_FIELD) {
+      options.insert(pair);
+    } else if (pair.first == SERVICE_CPU_PLACEMENT_FIELD) {
+      options.insert(pair);
+    } else if (pair.first == SERVICE_CPUSET_CGROUP_FIELD) {
+      options.insert(pair);
     }
   }
 
@@ -81,7 +99,13 @@ Config::Config()
     : host(GetDefaultHost()),
       log_path(DUMMY_LOG_FILE_PATH),
       log_level(common::logging::LOG_LEVEL_INFO),
-      ttl_files_(TTL_FILES) {}
+      ttl_files_(TTL_FILES),
+      relay_workers(RELAY_WORKERS),
+      startup_budget(STARTUP_BUDGET),
+      history_budget(HISTORY_BUDGET),
+      share_inputs(SHARE_INPUTS),
+      cpu_placement(CPU_PLACEMENT),
+      cpuset_cgroup() {}
 
 common::net::HostAndPort Config::GetDefaultHost() {
   return common::net::HostAndPort::CreateLocalHost(CLIENT_PORT);
@@ -150,6 +174,41 @@ common::ErrnoError load_config_from_file(const std::string& config_absolute_path
   }
   lconfig.ttl_files_ = ttl_files;
 
+  size_t relay_workers;
+  if (!utils::ArgsGetValue(slave_config_args, SERVICE_RELAY_WORKERS_FIELD, &relay_workers)) {
+    relay_workers = RELAY_WORKERS;
+  }
+  lconfig.relay_workers = relay_workers;
+
+  size_t startup_budget;
+  if (!utils::ArgsGetValue(slave_config_args, SERVICE_STARTUP_BUDGET_FIELD, &startup_budget)) {
+    startup_budget = STARTUP_BUDGET;
+  }
+  lconfig.startup_budget = startup_budget;
+
+  size_t history_budget;
+  if (!utils::ArgsGetValue(slave_config_args, SERVICE_HISTORY_BUDGET_FIELD, &history_budget)) {
+    history_budget = HISTORY_BUDGET;
+  }
+  lconfig.history_budget = history_budget;
+
+  bool share_inputs;
+  if (!utils::ArgsGetValue(slave_config_args, SERVICE_SHARE_INPUTS_FIELD, &share_inputs)) {
+    share_inputs = SHARE_INPUTS;
+  }
+  lconfig.share_inputs = share_inputs;
+
+  bool cpu_placement;
+  if (!utils::ArgsGetValue(slave_config_args, SERVICE_CPU_PLACEMENT_FIELD, &cpu_placement)) {
+    cpu_placement = CPU_PLACEMENT;
+  }
+  lconfig.cpu_placement = cpu_placement;
+
+  std::string cpuset_cgroup;
+  if (utils::ArgsGetValue(slave_config_args, SERVICE_CPUSET_CGROUP_FIELD, &cpuset_cgroup)) {
+    lconfig.cpuset_cgroup = cpuset_cgroup;
+  }
+
   *config = lconfig;
   return common::ErrnoError();
 }
@@ -35,6 +35,12 @@ struct Config {
   common::net::HostAndPort subscribers_host;
   common::net::HostAndPort bandwidth_host;
   time_t ttl_files_;  // in seconds
+  size_t relay_workers;
+  size_t startup_budget;      // streams restarting at the same time
+  size_t history_budget;      // MB for per second statistic history of all streams
+  bool share_inputs;          // streams with the same live upstream read it once
+  bool cpu_placement;         // stream children pinned to cores and numa node by occupancy
+  std::string cpuset_cgroup;  // cgroup directory for per stream cpusets, empty - affinity only
 };
 
 common::ErrnoError load_config_from_file(const std::string& config_absolute_path, Config* config) WARN_UNUSED_RESULT;
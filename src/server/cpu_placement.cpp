@@ -0,0 +1,433 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/cpu_placement.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iterator>
+#include <fstream>
+#include <sstream>
+
+#include <common/convert2string.h>
+#include <common/sprintf.h>
+
+#include "base/config_fields.h"
+#include "base/gst_constants.h"
+#include "utils/arg_converter.h"
+
+#define SYSFS_NODES_PATH "/sys/devices/system/node"
+
+namespace {
+// kernel cpu list format: "0-3,8,10-11"
+std::vector<int> ParseCpuList(const std::string& list) {
+  std::vector<int> cpus;
+  std::stringstream stream(list);
+  std::string range;
+  while (std::getline(stream, range, ',')) {
+    int first = 0;
+    int last = 0;
+    const int parsed = sscanf(range.c_str(), "%d-%d", &first, &last);
+    if (parsed == 1) {
+      last = first;
+    } else if (parsed != 2) {
+      continue;
+    }
+    for (int cpu = first; cpu <= last; ++cpu) {
+      cpus.push_back(cpu);
+    }
+  }
+  return cpus;
+}
+
+std::string MakeCpuList(const std::vector<int>& cpus) {
+  std::string list;
+  for (size_t i = 0; i < cpus.size(); ++i) {
+    if (i) {
+      list += ",";
+    }
+    list += common::ConvertToString(cpus[i]);
+  }
+  return list;
+}
+
+// cpu -> node
+std::map<int, int> ReadCpuNodes() {
+  std::map<int, int> cpu_nodes;
+  DIR* dir = opendir(SYSFS_NODES_PATH);
+  if (!dir) {
+    return cpu_nodes;
+  }
+
+  struct dirent* entry = nullptr;
+  while ((entry = readdir(dir)) != nullptr) {
+    int node = 0;
+    char tail = 0;
+    if (sscanf(entry->d_name, "node%d%c", &node, &tail) != 1) {
+      continue;
+    }
+
+    std::ifstream cpulist(std::string(SYSFS_NODES_PATH "/") + entry->d_name + "/cpulist");
+    std::string list;
+    if (!std::getline(cpulist, list)) {
+      continue;
+    }
+    for (int cpu : ParseCpuList(list)) {
+      cpu_nodes[cpu] = node;
+    }
+  }
+  closedir(dir);
+  return cpu_nodes;
+}
+
+common::ErrnoError WriteCgroupFile(const std::string& path, const std::string& value) {
+  int fd = open(path.c_str(), O_WRONLY | O_CLOEXEC);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  const ssize_t written = write(fd, value.c_str(), value.size());
+  const int write_errno = errno;
+  close(fd);
+  if (written != static_cast<ssize_t>(value.size())) {
+    return common::make_errno_error(common::MemSPrintf("Failed to write %s: %s", path, strerror(write_errno)),
+                                    write_errno);
+  }
+  return common::ErrnoError();
+}
+}  // namespace
+
+namespace iptv_cloud {
+namespace server {
+
+CpuPlacement::CpuPlacement(const topology_t& topology)
+    : topology_(topology), nodes_(), load_(topology.size(), 0), streams_() {
+  for (size_t i = 0; i < topology_.size(); ++i) {
+    nodes_[topology_[i].node].push_back(i);
+  }
+}
+
+CpuPlacement::topology_t CpuPlacement::ReadMachineTopology() {
+  std::vector<int> allowed;
+  common::ErrnoError err = GetAffinity(0, &allowed);
+  if (err) {
+    const long online = sysconf(_SC_NPROCESSORS_ONLN);
+    for (long i = 0; i < online; ++i) {
+      allowed.push_back(i);
+    }
+  }
+
+  const std::map<int, int> cpu_nodes = ReadCpuNodes();
+  topology_t topology;
+  for (int cpu : allowed) {
+    const auto it = cpu_nodes.find(cpu);
+    topology.push_back({cpu, it == cpu_nodes.end() ? 0 : it->second});
+  }
+  return topology;
+}
+
+size_t CpuPlacement::GetRequiredCpus(StreamType type, const utils::ArgsMap& args) {
+  if (type != ENCODE && type != VOD_ENCODE) {
+    return 0;
+  }
+
+  bool relay_video = false;
+  if (utils::ArgsGetValue(args, RELAY_VIDEO_FIELD, &relay_video) && relay_video) {
+    return 0;
+  }
+
+  std::string video_codec = X264_ENC;
+  utils::ArgsGetValue(args, VIDEO_CODEC_FIELD, &video_codec);
+  if (video_codec == X264_ENC) {
+    int threads = 0;
+    if (utils::ArgsGetValue(args, X264_ENC_THREADS, &threads) && threads > 0) {
+      return threads;
+    }
+    return DEFAULT_ENCODE_CPUS;
+  }
+
+  if (video_codec == X265_ENC || video_codec == OPEN_H264_ENC || video_codec == EAVC_ENC) {
+    return DEFAULT_ENCODE_CPUS;
+  }
+  return 0;  // hardware encoders
+}
+
+common::ErrnoError CpuPlacement::SetAffinity(pid_t pid, const Assignment& assignment) {
+  if (assignment.cpus.empty()) {
+    return common::ErrnoError();
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (int cpu : assignment.cpus) {
+    CPU_SET(cpu, &set);
+  }
+  if (sched_setaffinity(pid, sizeof(set), &set) == ERROR_RESULT_VALUE) {
+    return common::make_errno_error(errno);
+  }
+  return common::ErrnoError();
+}
+
+common::ErrnoError CpuPlacement::GetAffinity(pid_t pid, std::vector<int>* cpus) {
+  if (!cpus) {
+    return common::make_errno_error_inval();
+  }
+
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  if (sched_getaffinity(pid, sizeof(set), &set) == ERROR_RESULT_VALUE) {
+    return common::make_errno_error(errno);
+  }
+
+  std::vector<int> lcpus;
+  for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+    if (CPU_ISSET(cpu, &set)) {
+      lcpus.push_back(cpu);
+    }
+  }
+  *cpus = lcpus;
+  return common::ErrnoError();
+}
+
+common::ErrnoError CpuPlacement::JoinCpusetCgroup(const std::string& cgroup_root,
+                                                  const std::string& name,
+                                                  pid_t pid,
+                                                  const Assignment& assignment) {
+  if (cgroup_root.empty() || name.empty() || assignment.cpus.empty()) {
+    return common::make_errno_error_inval();
+  }
+
+  const std::string dir = cgroup_root + "/" + name;
+  if (mkdir(dir.c_str(), S_IRWXU | S_IRGRP | S_IXGRP | S_IROTH | S_IXOTH) == ERROR_RESULT_VALUE && errno != EEXIST) {
+    return common::make_errno_error(common::MemSPrintf("Failed to create cgroup %s: %s", dir, strerror(errno)), errno);
+  }
+
+  common::ErrnoError err = WriteCgroupFile(dir + "/cpuset.cpus", MakeCpuList(assignment.cpus));
+  if (err) {
+    return err;
+  }
+
+  if (assignment.node >= 0) {
+    err = WriteCgroupFile(dir + "/cpuset.mems", common::ConvertToString(assignment.node));
+    if (err) {
+      return err;
+    }
+  }
+
+  return WriteCgroupFile(dir + "/cgroup.procs", common::ConvertToString(pid));
+}
+
+common::ErrnoError CpuPlacement::RemoveCpusetCgroup(const std::string& cgroup_root, const std::string& name) {
+  if (cgroup_root.empty() || name.empty()) {
+    return common::make_errno_error_inval();
+  }
+
+  const std::string dir = cgroup_root + "/" + name;
+  if (rmdir(dir.c_str()) == ERROR_RESULT_VALUE && errno != ENOENT) {
+    return common::make_errno_error(common::MemSPrintf("Failed to remove cgroup %s: %s", dir, strerror(errno)), errno);
+  }
+  return common::ErrnoError();
+}
+
+CpuPlacement::Assignment CpuPlacement::Assign(stream_id_t sid, size_t cpus) {
+  Release(sid);
+  if (topology_.empty()) {
+    return {-1, std::vector<int>()};
+  }
+
+  const Entry entry = cpus ? PlaceOwned(cpus) : PlaceShared();
+  Occupy(sid, entry);
+  return entry.assignment;
+}
+
+void CpuPlacement::Restore(stream_id_t sid, const std::vector<int>& cpus) {
+  Release(sid);
+  std::vector<size_t> indexes;
+  for (size_t i = 0; i < topology_.size(); ++i) {
+    if (std::find(cpus.begin(), cpus.end(), topology_[i].id) != cpus.end()) {
+      indexes.push_back(i);
+    }
+  }
+  if (indexes.empty()) {
+    return;
+  }
+
+  const int node = topology_[indexes[0]].node;
+  bool one_node = true;
+  for (size_t index : indexes) {
+    if (topology_[index].node != node) {
+      one_node = false;
+      break;
+    }
+  }
+
+  Entry entry;
+  entry.assignment.node = one_node ? node : -1;
+  for (size_t index : indexes) {
+    entry.assignment.cpus.push_back(topology_[index].id);
+  }
+  if (one_node && indexes.size() < nodes_[node].size()) {
+    entry.loaded = indexes;
+    entry.weight = encode_weight;
+  } else {  // whole node or not placed, counted as light stream
+    size_t least = indexes[0];
+    for (size_t index : indexes) {
+      if (load_[index] < load_[least]) {
+        least = index;
+      }
+    }
+    entry.loaded.push_back(least);
+    entry.weight = shared_weight;
+  }
+  Occupy(sid, entry);
+}
+
+void CpuPlacement::Release(stream_id_t sid) {
+  const auto it = streams_.find(sid);
+  if (it == streams_.end()) {
+    return;
+  }
+
+  const Entry& entry = it->second;
+  for (size_t index : entry.loaded) {
+    load_[index] -= entry.weight;
+  }
+  streams_.erase(it);
+}
+
+bool CpuPlacement::Find(stream_id_t sid, Assignment* assignment) const {
+  const auto it = streams_.find(sid);
+  if (it == streams_.end()) {
+    return false;
+  }
+
+  if (assignment) {
+    *assignment = it->second.assignment;
+  }
+  return true;
+}
+
+size_t CpuPlacement::GetNodesCount() const {
+  return nodes_.size();
+}
+
+size_t CpuPlacement::GetPlacedCount() const {
+  return streams_.size();
+}
+
+std::vector<uint32_t> CpuPlacement::GetCpusLoad() const {
+  return load_;
+}
+
+std::vector<int> CpuPlacement::GetCpusIds() const {
+  std::vector<int> ids;
+  for (const Cpu& cpu : topology_) {
+    ids.push_back(cpu.id);
+  }
+  return ids;
+}
+
+CpuPlacement::Entry CpuPlacement::PlaceShared() const {
+  // node with the least average load, compared without division
+  auto best = nodes_.begin();
+  uint64_t best_load = 0;
+  for (size_t index : best->second) {
+    best_load += load_[index];
+  }
+  for (auto it = std::next(nodes_.begin()); it != nodes_.end(); ++it) {
+    uint64_t node_load = 0;
+    for (size_t index : it->second) {
+      node_load += load_[index];
+    }
+    if (node_load * best->second.size() < best_load * it->second.size()) {
+      best = it;
+      best_load = node_load;
+    }
+  }
+
+  Entry entry;
+  entry.assignment.node = best->first;
+  size_t least = best->second[0];
+  for (size_t index : best->second) {
+    entry.assignment.cpus.push_back(topology_[index].id);
+    if (load_[index] < load_[least]) {
+      least = index;
+    }
+  }
+  entry.loaded.push_back(least);
+  entry.weight = shared_weight;
+  return entry;
+}
+
+CpuPlacement::Entry CpuPlacement::PlaceOwned(size_t cpus) const {
+  size_t max_node_size = 0;
+  for (const auto& node : nodes_) {
+    max_node_size = std::max(max_node_size, node.second.size());
+  }
+  const size_t count = std::min(cpus, max_node_size);  // encode never spans nodes
+
+  // node where the least loaded cores are the least loaded
+  Entry entry;
+  entry.assignment.node = -1;
+  uint64_t best_cost = 0;
+  uint64_t best_node_load = 0;
+  for (const auto& node : nodes_) {
+    if (node.second.size() < count) {
+      continue;
+    }
+
+    std::vector<size_t> indexes = node.second;
+    std::stable_sort(indexes.begin(), indexes.end(), [this](size_t a, size_t b) { return load_[a] < load_[b]; });
+    indexes.resize(count);
+    uint64_t cost = 0;
+    for (size_t index : indexes) {
+      cost += load_[index];
+    }
+    uint64_t node_load = 0;
+    for (size_t index : node.second) {
+      node_load += load_[index];
+    }
+    // on equal cores spread encodes over nodes
+    if (entry.assignment.node == -1 || cost < best_cost || (cost == best_cost && node_load < best_node_load)) {
+      entry.assignment.node = node.first;
+      entry.loaded = indexes;
+      best_cost = cost;
+      best_node_load = node_load;
+    }
+  }
+
+  std::sort(entry.loaded.begin(), entry.loaded.end());
+  for (size_t index : entry.loaded) {
+    entry.assignment.cpus.push_back(topology_[index].id);
+  }
+  entry.weight = encode_weight;
+  return entry;
+}
+
+void CpuPlacement::Occupy(stream_id_t sid, const Entry& entry) {
+  for (size_t index : entry.loaded) {
+    load_[index] += entry.weight;
+  }
+  streams_[sid] = entry;
+}
+
+}  // namespace server
+}  // namespace iptv_cloud
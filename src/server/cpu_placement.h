@@ -0,0 +1,103 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <common/error.h>
+
+#include "base/types.h"
+#include "utils/arg_reader.h"
+
+namespace iptv_cloud {
+namespace server {
+
+// cpu and numa placement of stream children:
+// software encodes own the least loaded cores of one numa node, so encoder threads don't migrate across sockets
+// and heavy encodes don't pile onto the same cores, light streams share all cores of the least loaded node.
+// every (re)start of stream places it again by current occupancy.
+class CpuPlacement {
+ public:
+  enum constants : uint32_t {
+    DEFAULT_ENCODE_CPUS = 4,  // x264enc threads=0 (auto) and other software encoders
+    encode_weight = 4,        // load of core owned by encode
+    shared_weight = 1         // load of light stream, counted on the least loaded core of node
+  };
+
+  struct Cpu {
+    int id;
+    int node;
+  };
+  typedef std::vector<Cpu> topology_t;
+
+  struct Assignment {
+    int node;               // -1 if not placed
+    std::vector<int> cpus;  // affinity of process
+  };
+
+  explicit CpuPlacement(const topology_t& topology);
+
+  // cpus allowed for service grouped by numa node, all on node 0 if sysfs has no numa info
+  static topology_t ReadMachineTopology();
+  // cpus to own for stream, 0 - stream shares node
+  static size_t GetRequiredCpus(StreamType type, const utils::ArgsMap& args);
+
+  static common::ErrnoError SetAffinity(pid_t pid, const Assignment& assignment) WARN_UNUSED_RESULT;
+  static common::ErrnoError GetAffinity(pid_t pid, std::vector<int>* cpus) WARN_UNUSED_RESULT;
+  // moves pid to cgroup_root/name cpuset with assignment cpus and memory of its node
+  static common::ErrnoError JoinCpusetCgroup(const std::string& cgroup_root,
+                                             const std::string& name,
+                                             pid_t pid,
+                                             const Assignment& assignment) WARN_UNUSED_RESULT;
+  // removes cgroup_root/name after its processes exited, missing cgroup is not an error
+  static common::ErrnoError RemoveCpusetCgroup(const std::string& cgroup_root,
+                                               const std::string& name) WARN_UNUSED_RESULT;
+
+  // previous placement of stream is released first
+  Assignment Assign(stream_id_t sid, size_t cpus);
+  // stream placed by previous service instance, occupancy restored from its affinity
+  void Restore(stream_id_t sid, const std::vector<int>& cpus);
+  void Release(stream_id_t sid);
+  bool Find(stream_id_t sid, Assignment* assignment) const;
+
+  size_t GetNodesCount() const;
+  size_t GetPlacedCount() const;
+  // per cpu load in topology order
+  std::vector<uint32_t> GetCpusLoad() const;
+  std::vector<int> GetCpusIds() const;
+
+ private:
+  struct Entry {
+    Assignment assignment;
+    std::vector<size_t> loaded;  // topology indexes with added weight
+    uint32_t weight;
+  };
+
+  Entry PlaceShared() const;
+  Entry PlaceOwned(size_t cpus) const;
+  void Occupy(stream_id_t sid, const Entry& entry);
+
+  topology_t topology_;
+  std::map<int, std::vector<size_t>> nodes_;  // node -> topology indexes
+  std::vector<uint32_t> load_;
+  std::map<stream_id_t, Entry> streams_;
+};
+
+}  // namespace server
+}  // namespace iptv_cloud
@@ -56,8 +56,13 @@ protocol::response_t StateServiceResponce(protocol::sequance_id_t id, const std:
   return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage(result));
 }
 
-protocol::response_t SyncServiceResponceSuccess(protocol::sequance_id_t id) {
-  return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage());
+protocol::response_t SyncServiceResponceSuccess(protocol::sequance_id_t id, const std::string& result) {
+  return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage(result));
+}
+
+protocol::response_t SyncServiceResponceFail(protocol::sequance_id_t id, const std::string& error_text) {
+  return protocol::response_t::MakeError(
+      id, common::protocols::json_rpc::JsonRPCError::MakeServerErrorFromText(error_text));
 }
 
 protocol::response_t StartStreamResponceSuccess(protocol::sequance_id_t id) {
@@ -87,6 +92,15 @@ protocol::response_t RestartStreamResponceFail(protocol::sequance_id_t id, const
       id, common::protocols::json_rpc::JsonRPCError::MakeServerErrorFromText(error_text));
 }
 
+protocol::response_t ReconfigureStreamResponceSuccess(protocol::sequance_id_t id) {
+  return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage());
+}
+
+protocol::response_t ReconfigureStreamResponceFail(protocol::sequance_id_t id, const std::string& error_text) {
+  return protocol::response_t::MakeError(
+      id, common::protocols::json_rpc::JsonRPCError::MakeServerErrorFromText(error_text));
+}
+
 protocol::response_t GetLogStreamResponceSuccess(protocol::sequance_id_t id) {
   return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage());
 }
@@ -96,6 +110,24 @@ protocol::response_t GetLogStreamResponceFail(protocol::sequance_id_t id, const
       id, common::protocols::json_rpc::JsonRPCError::MakeServerErrorFromText(error_text));
 }
 
+protocol::response_t GetProfileStreamResponceSuccess(protocol::sequance_id_t id, const std::string& result) {
+  return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage(result));
+}
+
+protocol::response_t GetProfileStreamResponceFail(protocol::sequance_id_t id, const std::string& error_text) {
+  return protocol::response_t::MakeError(
+      id, common::protocols::json_rpc::JsonRPCError::MakeServerErrorFromText(error_text));
+}
+
+protocol::response_t GetHistoryStreamResponceSuccess(protocol::sequance_id_t id, const std::string& result) {
+  return protocol::response_t::MakeMessage(id, common::protocols::json_rpc::JsonRPCMessage::MakeSuccessMessage(result));
+}
+
+protocol::response_t GetHistoryStreamResponceFail(protocol::sequance_id_t id, const std::string& error_text) {
+  return protocol::response_t::MakeError(
+      id, common::protocols::json_rpc::JsonRPCError::MakeServerErrorFromText(error_text));
+}
+
 protocol::request_t PingDaemonRequest(protocol::sequance_id_t id, protocol::serializet_params_t params) {
   protocol::request_t req;
   req.id = id;
@@ -24,8 +24,11 @@
 #define DAEMON_START_STREAM "start_stream"  // {"config": {...}, "command_line": {...} }
 #define DAEMON_STOP_STREAM "stop_stream"
 #define DAEMON_RESTART_STREAM "restart_stream"
+#define DAEMON_RECONFIGURE_STREAM "reconfigure_stream"  // {"config": {...} }, applied without restart if possible
 #define DAEMON_GET_LOG_STREAM "get_log_stream"
 #define DAEMON_GET_PIPELINE_STREAM "get_pipeline_stream"
+#define DAEMON_GET_PROFILE_STREAM "get_profile_stream"  // {"id": "..."}, per element timings history, starts profiling
+#define DAEMON_GET_HISTORY_STREAM "get_history_stream"  // {"id": "...", "from": 0, "to": 0}, per second statistic
 
 #define DAEMON_ACTIVATE "activate_request"  // {"key": "XXXXXXXXXXXXXXXXXX"}
 #define DAEMON_STOP_SERVICE "stop_service"  // {"delay": 0 }
@@ -33,6 +36,9 @@
   "prepare_service"  // { "feedback_directory": "", "timeshifts_directory": "", "hls_directory": "",
                      // "playlists_directory": "", "dvb_directory": "", "capture_card_directory": "" }
 #define DAEMON_SYNC_SERVICE "sync_service"
+#define DAEMON_SYNC_SERVICE_DELTA \
+  "sync_service_delta"  // {"base_version": 1, "version": 2, "streams": {"add": [], "update": [], "remove": []},
+                        // "subscribers": {"add": [], "update": [], "remove": []} }
 #define DAEMON_PING_SERVICE "ping_service"
 #define DAEMON_GET_LOG_SERVICE "get_log_service"  // {"path":"http://localhost/service/id"}
 
@@ -65,7 +71,8 @@ protocol::response_t ActivateResponceFail(protocol::sequance_id_t id, const std:
 
 protocol::response_t StateServiceResponce(protocol::sequance_id_t id, const std::string& result);  // Directories
 
-protocol::response_t SyncServiceResponceSuccess(protocol::sequance_id_t id);
+protocol::response_t SyncServiceResponceSuccess(protocol::sequance_id_t id, const std::string& result);  // SyncAckInfo
+protocol::response_t SyncServiceResponceFail(protocol::sequance_id_t id, const std::string& error_text);
 
 protocol::response_t PingServiceResponce(protocol::sequance_id_t id,
                                          const std::string& result);  // ServerPingInfo
@@ -81,9 +88,20 @@ protocol::response_t StopStreamResponceFail(protocol::sequance_id_t id, const st
 protocol::response_t RestartStreamResponceSuccess(protocol::sequance_id_t id);
 protocol::response_t RestartStreamResponceFail(protocol::sequance_id_t id, const std::string& error_text);
 
+protocol::response_t ReconfigureStreamResponceSuccess(protocol::sequance_id_t id);
+protocol::response_t ReconfigureStreamResponceFail(protocol::sequance_id_t id, const std::string& error_text);
+
 protocol::response_t GetLogStreamResponceSuccess(protocol::sequance_id_t id);
 protocol::response_t GetLogStreamResponceFail(protocol::sequance_id_t id, const std::string& error_text);
 
+protocol::response_t GetProfileStreamResponceSuccess(protocol::sequance_id_t id,
+                                                     const std::string& result);  // ProfileInfo
+protocol::response_t GetProfileStreamResponceFail(protocol::sequance_id_t id, const std::string& error_text);
+
+protocol::response_t GetHistoryStreamResponceSuccess(protocol::sequance_id_t id,
+                                                     const std::string& result);  // HistoryInfo
+protocol::response_t GetHistoryStreamResponceFail(protocol::sequance_id_t id, const std::string& error_text);
+
 // Broadcast
 protocol::request_t ChangedSourcesStreamBroadcast(protocol::serializet_params_t params);  // ChangedSouresInfo
 protocol::request_t StatisitcStreamBroadcast(protocol::serializet_params_t params);       // StatisticInfo
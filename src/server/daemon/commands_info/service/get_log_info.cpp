@@ -17,18 +17,20 @@
 #include <string>
 
 #define GET_LOG_INFO_PATH_FIELD "path"
+#define GET_LOG_INFO_TAIL_SIZE_FIELD "tail_size"
 
 namespace iptv_cloud {
 namespace server {
 namespace service {
 
-GetLogInfo::GetLogInfo() : base_class(), path_() {}
+GetLogInfo::GetLogInfo() : base_class(), path_(), tail_size_(0) {}
 
-GetLogInfo::GetLogInfo(const url_t& path) : path_(path) {}
+GetLogInfo::GetLogInfo(const url_t& path, size_t tail_size) : path_(path), tail_size_(tail_size) {}
 
 common::Error GetLogInfo::SerializeFields(json_object* out) const {
   const std::string path_str = path_.GetUrl();
   json_object_object_add(out, GET_LOG_INFO_PATH_FIELD, json_object_new_string(path_str.c_str()));
+  json_object_object_add(out, GET_LOG_INFO_TAIL_SIZE_FIELD, json_object_new_int64(tail_size_));
   return common::Error();
 }
 
@@ -40,6 +42,12 @@ common::Error GetLogInfo::DoDeSerialize(json_object* serialized) {
     inf.path_ = url_t(json_object_get_string(jpath));
   }
 
+  json_object* jtail_size = nullptr;
+  json_bool jtail_size_exists = json_object_object_get_ex(serialized, GET_LOG_INFO_TAIL_SIZE_FIELD, &jtail_size);
+  if (jtail_size_exists) {
+    inf.tail_size_ = json_object_get_int64(jtail_size);
+  }
+
   *this = inf;
   return common::Error();
 }
@@ -48,6 +56,10 @@ GetLogInfo::url_t GetLogInfo::GetLogPath() const {
   return path_;
 }
 
+size_t GetLogInfo::GetTailSize() const {
+  return tail_size_;
+}
+
 }  // namespace service
 }  // namespace server
 }  // namespace iptv_cloud
@@ -27,9 +27,10 @@ class GetLogInfo : public common::serializer::JsonSerializer<GetLogInfo> {
   typedef common::serializer::JsonSerializer<GetLogInfo> base_class;
   typedef common::uri::Url url_t;
   GetLogInfo();
-  explicit GetLogInfo(const url_t& log_path);
+  explicit GetLogInfo(const url_t& log_path, size_t tail_size = 0);
 
   url_t GetLogPath() const;
+  size_t GetTailSize() const;  // bytes from end of file, 0 means whole file
 
  protected:
   common::Error DoDeSerialize(json_object* serialized) override;
@@ -37,6 +38,7 @@ class GetLogInfo : public common::serializer::JsonSerializer<GetLogInfo> {
 
  private:
   common::uri::Url path_;
+  size_t tail_size_;
 };
 
 }  // namespace service
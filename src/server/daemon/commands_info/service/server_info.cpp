@@ -31,6 +31,8 @@
 #define STATISTIC_SERVICE_INFO_BANDWIDTH_OUT_FIELD "bandwidth_out"
 
 #define STATISTIC_SERVICE_INFO_ONLINE_USERS_FIELD "online_users"
+#define STATISTIC_SERVICE_INFO_VODS_FIELD "vods"
+#define STATISTIC_SERVICE_INFO_PLACEMENT_FIELD "placement"
 
 #define FULL_SERVICE_INFO_VERSION_FIELD "version"
 #define FULL_SERVICE_INFO_HTTP_HOST_FIELD "http_host"
@@ -43,6 +45,16 @@
 #define ONLINE_USERS_VODS_FIELD "vods"
 #define ONLINE_USERS_SUBSCRIBER_FIELD "subscriber"
 
+#define VODS_STATUS_ABSENT_FIELD "absent"
+#define VODS_STATUS_IN_PROGRESS_FIELD "in_progress"
+#define VODS_STATUS_COMPLETE_FIELD "complete"
+
+#define PLACEMENT_STATUS_NODES_FIELD "nodes"
+#define PLACEMENT_STATUS_STREAMS_FIELD "streams"
+#define PLACEMENT_STATUS_CPUS_FIELD "cpus"
+#define PLACEMENT_STATUS_CPU_ID_FIELD "id"
+#define PLACEMENT_STATUS_CPU_LOAD_FIELD "load"
+
 namespace iptv_cloud {
 namespace server {
 namespace service {
@@ -90,6 +102,100 @@ common::Error OnlineUsers::SerializeFields(json_object* out) const {
   return common::Error();
 }
 
+VodsStatus::VodsStatus() : VodsStatus(0, 0, 0) {}
+
+VodsStatus::VodsStatus(size_t absent, size_t in_progress, size_t complete)
+    : absent_(absent), in_progress_(in_progress), complete_(complete) {}
+
+common::Error VodsStatus::DoDeSerialize(json_object* serialized) {
+  VodsStatus inf;
+  json_object* jabsent = nullptr;
+  json_bool jabsent_exists = json_object_object_get_ex(serialized, VODS_STATUS_ABSENT_FIELD, &jabsent);
+  if (jabsent_exists) {
+    inf.absent_ = json_object_get_int64(jabsent);
+  }
+
+  json_object* jin_progress = nullptr;
+  json_bool jin_progress_exists = json_object_object_get_ex(serialized, VODS_STATUS_IN_PROGRESS_FIELD, &jin_progress);
+  if (jin_progress_exists) {
+    inf.in_progress_ = json_object_get_int64(jin_progress);
+  }
+
+  json_object* jcomplete = nullptr;
+  json_bool jcomplete_exists = json_object_object_get_ex(serialized, VODS_STATUS_COMPLETE_FIELD, &jcomplete);
+  if (jcomplete_exists) {
+    inf.complete_ = json_object_get_int64(jcomplete);
+  }
+
+  *this = inf;
+  return common::Error();
+}
+
+common::Error VodsStatus::SerializeFields(json_object* out) const {
+  json_object_object_add(out, VODS_STATUS_ABSENT_FIELD, json_object_new_int64(absent_));
+  json_object_object_add(out, VODS_STATUS_IN_PROGRESS_FIELD, json_object_new_int64(in_progress_));
+  json_object_object_add(out, VODS_STATUS_COMPLETE_FIELD, json_object_new_int64(complete_));
+  return common::Error();
+}
+
+PlacementStatus::PlacementStatus() : PlacementStatus(0, 0, std::vector<CpuLoad>()) {}
+
+PlacementStatus::PlacementStatus(size_t nodes, size_t streams, const std::vector<CpuLoad>& cpus)
+    : nodes_(nodes), streams_(streams), cpus_(cpus) {}
+
+std::vector<PlacementStatus::CpuLoad> PlacementStatus::GetCpus() const {
+  return cpus_;
+}
+
+common::Error PlacementStatus::DoDeSerialize(json_object* serialized) {
+  PlacementStatus inf;
+  json_object* jnodes = nullptr;
+  json_bool jnodes_exists = json_object_object_get_ex(serialized, PLACEMENT_STATUS_NODES_FIELD, &jnodes);
+  if (jnodes_exists) {
+    inf.nodes_ = json_object_get_int64(jnodes);
+  }
+
+  json_object* jstreams = nullptr;
+  json_bool jstreams_exists = json_object_object_get_ex(serialized, PLACEMENT_STATUS_STREAMS_FIELD, &jstreams);
+  if (jstreams_exists) {
+    inf.streams_ = json_object_get_int64(jstreams);
+  }
+
+  json_object* jcpus = nullptr;
+  json_bool jcpus_exists = json_object_object_get_ex(serialized, PLACEMENT_STATUS_CPUS_FIELD, &jcpus);
+  if (jcpus_exists) {
+    size_t len = json_object_array_length(jcpus);
+    for (size_t i = 0; i < len; ++i) {
+      json_object* jcpu = json_object_array_get_idx(jcpus, i);
+      json_object* jid = nullptr;
+      json_object* jload = nullptr;
+      if (!json_object_object_get_ex(jcpu, PLACEMENT_STATUS_CPU_ID_FIELD, &jid) ||
+          !json_object_object_get_ex(jcpu, PLACEMENT_STATUS_CPU_LOAD_FIELD, &jload)) {
+        continue;
+      }
+      inf.cpus_.push_back({json_object_get_int(jid), static_cast<uint32_t>(json_object_get_int64(jload))});
+    }
+  }
+
+  *this = inf;
+  return common::Error();
+}
+
+common::Error PlacementStatus::SerializeFields(json_object* out) const {
+  json_object* jcpus = json_object_new_array();
+  for (const CpuLoad& cpu : cpus_) {
+    json_object* jcpu = json_object_new_object();
+    json_object_object_add(jcpu, PLACEMENT_STATUS_CPU_ID_FIELD, json_object_new_int(cpu.id));
+    json_object_object_add(jcpu, PLACEMENT_STATUS_CPU_LOAD_FIELD, json_object_new_int64(cpu.load));
+    json_object_array_add(jcpus, jcpu);
+  }
+
+  json_object_object_add(out, PLACEMENT_STATUS_NODES_FIELD, json_object_new_int64(nodes_));
+  json_object_object_add(out, PLACEMENT_STATUS_STREAMS_FIELD, json_object_new_int64(streams_));
+  json_object_object_add(out, PLACEMENT_STATUS_CPUS_FIELD, jcpus);
+  return common::Error();
+}
+
 ServerInfo::ServerInfo()
     : base_class(),
       cpu_load_(),
@@ -101,7 +207,9 @@ ServerInfo::ServerInfo()
       net_bytes_send_(),
       current_ts_(),
       sys_shot_(),
-      online_users_() {}
+      online_users_(),
+      vods_(),
+      placement_() {}
 
 ServerInfo::ServerInfo(int cpu_load,
                        int gpu_load,
@@ -112,7 +220,9 @@ ServerInfo::ServerInfo(int cpu_load,
                        uint64_t net_bytes_send,
                        const utils::SysinfoShot& sys,
                        fastotv::timestamp_t timestamp,
-                       const OnlineUsers& online_users)
+                       const OnlineUsers& online_users,
+                       const VodsStatus& vods,
+                       const PlacementStatus& placement)
     : base_class(),
       cpu_load_(cpu_load),
       gpu_load_(gpu_load),
@@ -123,7 +233,9 @@ ServerInfo::ServerInfo(int cpu_load,
       net_bytes_send_(net_bytes_send),
       current_ts_(timestamp),
       sys_shot_(sys),
-      online_users_(online_users) {}
+      online_users_(online_users),
+      vods_(vods),
+      placement_(placement) {}
 
 common::Error ServerInfo::SerializeFields(json_object* out) const {
   json_object* obj = json_object_new_object();
@@ -133,6 +245,23 @@ common::Error ServerInfo::SerializeFields(json_object* out) const {
     return err;
   }
 
+  json_object* jvods = json_object_new_object();
+  err = vods_.Serialize(&jvods);
+  if (err) {
+    json_object_put(jvods);
+    json_object_put(obj);
+    return err;
+  }
+
+  json_object* jplacement = json_object_new_object();
+  err = placement_.Serialize(&jplacement);
+  if (err) {
+    json_object_put(jplacement);
+    json_object_put(jvods);
+    json_object_put(obj);
+    return err;
+  }
+
   json_object_object_add(out, STATISTIC_SERVICE_INFO_CPU_FIELD, json_object_new_int(cpu_load_));
   json_object_object_add(out, STATISTIC_SERVICE_INFO_GPU_FIELD, json_object_new_int(gpu_load_));
   json_object_object_add(out, STATISTIC_SERVICE_INFO_LOAD_AVERAGE_FIELD, json_object_new_string(uptime_.c_str()));
@@ -149,6 +278,8 @@ common::Error ServerInfo::SerializeFields(json_object* out) const {
   json_object_object_add(out, STATISTIC_SERVICE_INFO_UPTIME_FIELD, json_object_new_int64(sys_shot_.uptime));
   json_object_object_add(out, STATISTIC_SERVICE_INFO_TIMESTAMP_FIELD, json_object_new_int64(current_ts_));
   json_object_object_add(out, STATISTIC_SERVICE_INFO_ONLINE_USERS_FIELD, obj);
+  json_object_object_add(out, STATISTIC_SERVICE_INFO_VODS_FIELD, jvods);
+  json_object_object_add(out, STATISTIC_SERVICE_INFO_PLACEMENT_FIELD, jplacement);
   return common::Error();
 }
 
@@ -164,6 +295,25 @@ common::Error ServerInfo::DoDeSerialize(json_object* serialized) {
     }
   }
 
+  json_object* jvods = nullptr;
+  json_bool jvods_exists = json_object_object_get_ex(serialized, STATISTIC_SERVICE_INFO_VODS_FIELD, &jvods);
+  if (jvods_exists) {
+    common::Error err = inf.vods_.DeSerialize(jvods);
+    if (err) {
+      return err;
+    }
+  }
+
+  json_object* jplacement = nullptr;
+  json_bool jplacement_exists =
+      json_object_object_get_ex(serialized, STATISTIC_SERVICE_INFO_PLACEMENT_FIELD, &jplacement);
+  if (jplacement_exists) {
+    common::Error err = inf.placement_.DeSerialize(jplacement);
+    if (err) {
+      return err;
+    }
+  }
+
   json_object* jcpu_load = nullptr;
   json_bool jcpu_load_exists = json_object_object_get_ex(serialized, STATISTIC_SERVICE_INFO_CPU_FIELD, &jcpu_load);
   if (jcpu_load_exists) {
@@ -282,6 +432,14 @@ OnlineUsers ServerInfo::GetOnlineUsers() const {
   return online_users_;
 }
 
+VodsStatus ServerInfo::GetVods() const {
+  return vods_;
+}
+
+PlacementStatus ServerInfo::GetPlacement() const {
+  return placement_;
+}
+
 FullServiceInfo::FullServiceInfo() : base_class(), http_host_(), proj_ver_(PROJECT_VERSION_HUMAN) {}
 
 FullServiceInfo::FullServiceInfo(const common::net::HostAndPort& http_host,
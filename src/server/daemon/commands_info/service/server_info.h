@@ -15,6 +15,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include <common/net/types.h>
 #include <common/serializer/json_serializer.h>
@@ -44,6 +45,45 @@ class OnlineUsers : public common::serializer::JsonSerializer<OnlineUsers> {
   size_t subscriber_;
 };
 
+class VodsStatus : public common::serializer::JsonSerializer<VodsStatus> {
+ public:
+  typedef JsonSerializer<VodsStatus> base_class;
+  VodsStatus();
+  explicit VodsStatus(size_t absent, size_t in_progress, size_t complete);
+
+ protected:
+  common::Error DoDeSerialize(json_object* serialized) override;
+  common::Error SerializeFields(json_object* out) const override;
+
+ private:
+  size_t absent_;
+  size_t in_progress_;
+  size_t complete_;
+};
+
+class PlacementStatus : public common::serializer::JsonSerializer<PlacementStatus> {
+ public:
+  typedef JsonSerializer<PlacementStatus> base_class;
+  struct CpuLoad {
+    int id;
+    uint32_t load;
+  };
+
+  PlacementStatus();
+  explicit PlacementStatus(size_t nodes, size_t streams, const std::vector<CpuLoad>& cpus);
+
+  std::vector<CpuLoad> GetCpus() const;
+
+ protected:
+  common::Error DoDeSerialize(json_object* serialized) override;
+  common::Error SerializeFields(json_object* out) const override;
+
+ private:
+  size_t nodes_;
+  size_t streams_;
+  std::vector<CpuLoad> cpus_;
+};
+
 class ServerInfo : public common::serializer::JsonSerializer<ServerInfo> {
  public:
   typedef JsonSerializer<ServerInfo> base_class;
@@ -57,7 +97,9 @@ class ServerInfo : public common::serializer::JsonSerializer<ServerInfo> {
                       fastotv::bandwidth_t net_bytes_send,
                       const utils::SysinfoShot& sys,
                       fastotv::timestamp_t timestamp,
-                      const OnlineUsers& online_users);
+                      const OnlineUsers& online_users,
+                      const VodsStatus& vods,
+                      const PlacementStatus& placement);
 
   int GetCpuLoad() const;
   int GetGpuLoad() const;
@@ -68,6 +110,8 @@ class ServerInfo : public common::serializer::JsonSerializer<ServerInfo> {
   fastotv::bandwidth_t GetNetBytesSend() const;
   fastotv::timestamp_t GetTimestamp() const;
   OnlineUsers GetOnlineUsers() const;
+  VodsStatus GetVods() const;
+  PlacementStatus GetPlacement() const;
 
  protected:
   common::Error DoDeSerialize(json_object* serialized) override;
@@ -84,6 +128,8 @@ class ServerInfo : public common::serializer::JsonSerializer<ServerInfo> {
   fastotv::timestamp_t current_ts_;
   utils::SysinfoShot sys_shot_;
   OnlineUsers online_users_;
+  VodsStatus vods_;
+  PlacementStatus placement_;
 };
 
 class FullServiceInfo : public ServerInfo {
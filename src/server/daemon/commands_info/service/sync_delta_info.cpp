@@ -0,0 +1,194 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/daemon/commands_info/service/sync_delta_info.h"
+
+#define SYNC_DELTA_INFO_BASE_VERSION_FIELD "base_version"
+#define SYNC_DELTA_INFO_VERSION_FIELD "version"
+#define SYNC_DELTA_INFO_STREAMS_FIELD "streams"
+#define SYNC_DELTA_INFO_USERS_FIELD "subscribers"
+
+#define SYNC_DELTA_INFO_ADD_FIELD "add"
+#define SYNC_DELTA_INFO_UPDATE_FIELD "update"
+#define SYNC_DELTA_INFO_REMOVE_FIELD "remove"
+
+namespace iptv_cloud {
+namespace server {
+namespace service {
+
+namespace {
+
+json_object* MakeStringsArray(const std::vector<std::string>& strings) {
+  json_object* jarray = json_object_new_array();
+  for (const std::string& str : strings) {
+    json_object_array_add(jarray, json_object_new_string(str.c_str()));
+  }
+  return jarray;
+}
+
+std::vector<std::string> GetStringsArray(json_object* parent, const char* field) {
+  std::vector<std::string> result;
+  json_object* jarray = nullptr;
+  json_bool jarray_exists = json_object_object_get_ex(parent, field, &jarray);
+  if (!jarray_exists) {
+    return result;
+  }
+
+  int len = json_object_array_length(jarray);
+  for (int i = 0; i < len; ++i) {
+    json_object* jstr = json_object_array_get_idx(jarray, i);
+    result.push_back(json_object_get_string(jstr));
+  }
+  return result;
+}
+
+json_object* MakeDelta(const std::vector<std::string>& added,
+                       const std::vector<std::string>& updated,
+                       const std::vector<std::string>& removed) {
+  json_object* jdelta = json_object_new_object();
+  json_object_object_add(jdelta, SYNC_DELTA_INFO_ADD_FIELD, MakeStringsArray(added));
+  json_object_object_add(jdelta, SYNC_DELTA_INFO_UPDATE_FIELD, MakeStringsArray(updated));
+  json_object_object_add(jdelta, SYNC_DELTA_INFO_REMOVE_FIELD, MakeStringsArray(removed));
+  return jdelta;
+}
+
+void GetDelta(json_object* serialized,
+              const char* field,
+              std::vector<std::string>* added,
+              std::vector<std::string>* updated,
+              std::vector<std::string>* removed) {
+  json_object* jdelta = nullptr;
+  json_bool jdelta_exists = json_object_object_get_ex(serialized, field, &jdelta);
+  if (!jdelta_exists) {
+    return;
+  }
+
+  *added = GetStringsArray(jdelta, SYNC_DELTA_INFO_ADD_FIELD);
+  *updated = GetStringsArray(jdelta, SYNC_DELTA_INFO_UPDATE_FIELD);
+  *removed = GetStringsArray(jdelta, SYNC_DELTA_INFO_REMOVE_FIELD);
+}
+
+}  // namespace
+
+SyncDeltaInfo::SyncDeltaInfo() : SyncDeltaInfo(0, 0) {}
+
+SyncDeltaInfo::SyncDeltaInfo(sync_version_t base_version, sync_version_t version)
+    : base_class(),
+      base_version_(base_version),
+      version_(version),
+      added_streams_(),
+      updated_streams_(),
+      removed_streams_(),
+      added_users_(),
+      updated_users_(),
+      removed_users_() {}
+
+bool SyncDeltaInfo::IsValid() const {
+  return version_ > base_version_;
+}
+
+sync_version_t SyncDeltaInfo::GetBaseVersion() const {
+  return base_version_;
+}
+
+sync_version_t SyncDeltaInfo::GetVersion() const {
+  return version_;
+}
+
+SyncDeltaInfo::streams_t SyncDeltaInfo::GetAddedStreams() const {
+  return added_streams_;
+}
+
+void SyncDeltaInfo::SetAddedStreams(const streams_t& streams) {
+  added_streams_ = streams;
+}
+
+SyncDeltaInfo::streams_t SyncDeltaInfo::GetUpdatedStreams() const {
+  return updated_streams_;
+}
+
+void SyncDeltaInfo::SetUpdatedStreams(const streams_t& streams) {
+  updated_streams_ = streams;
+}
+
+SyncDeltaInfo::streams_ids_t SyncDeltaInfo::GetRemovedStreams() const {
+  return removed_streams_;
+}
+
+void SyncDeltaInfo::SetRemovedStreams(const streams_ids_t& streams) {
+  removed_streams_ = streams;
+}
+
+SyncDeltaInfo::users_t SyncDeltaInfo::GetAddedUsers() const {
+  return added_users_;
+}
+
+void SyncDeltaInfo::SetAddedUsers(const users_t& users) {
+  added_users_ = users;
+}
+
+SyncDeltaInfo::users_t SyncDeltaInfo::GetUpdatedUsers() const {
+  return updated_users_;
+}
+
+void SyncDeltaInfo::SetUpdatedUsers(const users_t& users) {
+  updated_users_ = users;
+}
+
+SyncDeltaInfo::logins_t SyncDeltaInfo::GetRemovedUsers() const {
+  return removed_users_;
+}
+
+void SyncDeltaInfo::SetRemovedUsers(const logins_t& users) {
+  removed_users_ = users;
+}
+
+common::Error SyncDeltaInfo::SerializeFields(json_object* out) const {
+  json_object_object_add(out, SYNC_DELTA_INFO_BASE_VERSION_FIELD, json_object_new_int64(base_version_));
+  json_object_object_add(out, SYNC_DELTA_INFO_VERSION_FIELD, json_object_new_int64(version_));
+  json_object_object_add(out, SYNC_DELTA_INFO_STREAMS_FIELD,
+                         MakeDelta(added_streams_, updated_streams_, removed_streams_));
+  json_object_object_add(out, SYNC_DELTA_INFO_USERS_FIELD, MakeDelta(added_users_, updated_users_, removed_users_));
+  return common::Error();
+}
+
+common::Error SyncDeltaInfo::DoDeSerialize(json_object* serialized) {
+  json_object* jbase_version = nullptr;
+  json_bool jbase_version_exists =
+      json_object_object_get_ex(serialized, SYNC_DELTA_INFO_BASE_VERSION_FIELD, &jbase_version);
+  if (!jbase_version_exists) {
+    return common::make_error_inval();
+  }
+
+  json_object* jversion = nullptr;
+  json_bool jversion_exists = json_object_object_get_ex(serialized, SYNC_DELTA_INFO_VERSION_FIELD, &jversion);
+  if (!jversion_exists) {
+    return common::make_error_inval();
+  }
+
+  SyncDeltaInfo inf(json_object_get_int64(jbase_version), json_object_get_int64(jversion));
+  if (!inf.IsValid()) {
+    return common::make_error_inval();
+  }
+
+  GetDelta(serialized, SYNC_DELTA_INFO_STREAMS_FIELD, &inf.added_streams_, &inf.updated_streams_,
+           &inf.removed_streams_);
+  GetDelta(serialized, SYNC_DELTA_INFO_USERS_FIELD, &inf.added_users_, &inf.updated_users_, &inf.removed_users_);
+  *this = inf;
+  return common::Error();
+}
+
+}  // namespace service
+}  // namespace server
+}  // namespace iptv_cloud
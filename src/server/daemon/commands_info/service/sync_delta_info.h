@@ -0,0 +1,80 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <common/serializer/json_serializer.h>
+
+#include "base/types.h"
+
+#include "server/daemon/commands_info/service/sync_info.h"
+
+namespace iptv_cloud {
+namespace server {
+namespace service {
+
+// changes between base version and version, applied only if service is on base version
+class SyncDeltaInfo : public common::serializer::JsonSerializer<SyncDeltaInfo> {
+ public:
+  typedef JsonSerializer<SyncDeltaInfo> base_class;
+  typedef std::vector<std::string> streams_t;  // stream configs
+  typedef std::vector<stream_id_t> streams_ids_t;
+  typedef std::vector<std::string> users_t;  // UserInfo
+  typedef std::vector<std::string> logins_t;
+
+  SyncDeltaInfo();
+  SyncDeltaInfo(sync_version_t base_version, sync_version_t version);
+
+  bool IsValid() const;
+
+  sync_version_t GetBaseVersion() const;
+  sync_version_t GetVersion() const;
+
+  streams_t GetAddedStreams() const;
+  void SetAddedStreams(const streams_t& streams);
+  streams_t GetUpdatedStreams() const;
+  void SetUpdatedStreams(const streams_t& streams);
+  streams_ids_t GetRemovedStreams() const;
+  void SetRemovedStreams(const streams_ids_t& streams);
+
+  users_t GetAddedUsers() const;
+  void SetAddedUsers(const users_t& users);
+  users_t GetUpdatedUsers() const;
+  void SetUpdatedUsers(const users_t& users);
+  logins_t GetRemovedUsers() const;
+  void SetRemovedUsers(const logins_t& users);
+
+ protected:
+  common::Error DoDeSerialize(json_object* serialized) override;
+  common::Error SerializeFields(json_object* out) const override;
+
+ private:
+  sync_version_t base_version_;
+  sync_version_t version_;
+
+  streams_t added_streams_;
+  streams_t updated_streams_;
+  streams_ids_t removed_streams_;
+
+  users_t added_users_;
+  users_t updated_users_;
+  logins_t removed_users_;
+};
+
+}  // namespace service
+}  // namespace server
+}  // namespace iptv_cloud
@@ -14,6 +14,7 @@
 
 #include "server/daemon/commands_info/service/sync_info.h"
 
+#define SYNC_INFO_VERSION_FIELD "version"
 #define SYNC_INFO_STREAMS_FIELD "streams"
 #define SYNC_INFO_USERS_FIELD "subscribers"
 
@@ -21,7 +22,11 @@ namespace iptv_cloud {
 namespace server {
 namespace service {
 
-SyncInfo::SyncInfo() : base_class(), streams_(), users_() {}
+SyncInfo::SyncInfo() : base_class(), version_(0), streams_(), users_() {}
+
+sync_version_t SyncInfo::GetVersion() const {
+  return version_;
+}
 
 SyncInfo::streams_t SyncInfo::GetStreams() const {
   return streams_;
@@ -32,6 +37,8 @@ SyncInfo::users_t SyncInfo::GetUsers() const {
 }
 
 common::Error SyncInfo::SerializeFields(json_object* out) const {
+  json_object_object_add(out, SYNC_INFO_VERSION_FIELD, json_object_new_int64(version_));
+
   json_object* jstreams = json_object_new_array();
   for (const std::string& stream : streams_) {
     json_object* jstream = json_object_new_string(stream.c_str());
@@ -50,6 +57,12 @@ common::Error SyncInfo::SerializeFields(json_object* out) const {
 
 common::Error SyncInfo::DoDeSerialize(json_object* serialized) {
   SyncInfo inf;
+  json_object* jversion = nullptr;
+  json_bool jversion_exists = json_object_object_get_ex(serialized, SYNC_INFO_VERSION_FIELD, &jversion);
+  if (jversion_exists) {
+    inf.version_ = json_object_get_int64(jversion);
+  }
+
   json_object* jstreams = nullptr;
   json_bool jstreams_exists = json_object_object_get_ex(serialized, SYNC_INFO_STREAMS_FIELD, &jstreams);
   if (jstreams_exists) {
@@ -78,6 +91,32 @@ common::Error SyncInfo::DoDeSerialize(json_object* serialized) {
   return common::Error();
 }
 
+SyncAckInfo::SyncAckInfo() : base_class(), version_(0) {}
+
+SyncAckInfo::SyncAckInfo(sync_version_t version) : base_class(), version_(version) {}
+
+sync_version_t SyncAckInfo::GetVersion() const {
+  return version_;
+}
+
+common::Error SyncAckInfo::SerializeFields(json_object* out) const {
+  json_object_object_add(out, SYNC_INFO_VERSION_FIELD, json_object_new_int64(version_));
+  return common::Error();
+}
+
+common::Error SyncAckInfo::DoDeSerialize(json_object* serialized) {
+  SyncAckInfo inf;
+  json_object* jversion = nullptr;
+  json_bool jversion_exists = json_object_object_get_ex(serialized, SYNC_INFO_VERSION_FIELD, &jversion);
+  if (!jversion_exists) {
+    return common::make_error_inval();
+  }
+
+  inf.version_ = json_object_get_int64(jversion);
+  *this = inf;
+  return common::Error();
+}
+
 }  // namespace service
 }  // namespace server
 }  // namespace iptv_cloud
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <stdint.h>
+
 #include <string>
 #include <vector>
 
@@ -23,6 +25,8 @@ namespace iptv_cloud {
 namespace server {
 namespace service {
 
+typedef uint64_t sync_version_t;  // 0 - not versioned
+
 class SyncInfo : public common::serializer::JsonSerializer<SyncInfo> {
  public:
   typedef JsonSerializer<SyncInfo> base_class;
@@ -31,6 +35,7 @@ class SyncInfo : public common::serializer::JsonSerializer<SyncInfo> {
 
   SyncInfo();
 
+  sync_version_t GetVersion() const;
   streams_t GetStreams() const;
   users_t GetUsers() const;
 
@@ -39,10 +44,29 @@ class SyncInfo : public common::serializer::JsonSerializer<SyncInfo> {
   common::Error SerializeFields(json_object* out) const override;
 
  private:
+  sync_version_t version_;
   streams_t streams_;
   users_t users_;
 };
 
+// responce on sync_service and sync_service_delta, version applied by service
+class SyncAckInfo : public common::serializer::JsonSerializer<SyncAckInfo> {
+ public:
+  typedef JsonSerializer<SyncAckInfo> base_class;
+
+  SyncAckInfo();
+  explicit SyncAckInfo(sync_version_t version);
+
+  sync_version_t GetVersion() const;
+
+ protected:
+  common::Error DoDeSerialize(json_object* serialized) override;
+  common::Error SerializeFields(json_object* out) const override;
+
+ private:
+  sync_version_t version_;
+};
+
 }  // namespace service
 }  // namespace server
 }  // namespace iptv_cloud
@@ -0,0 +1,68 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/daemon/commands_info/stream/get_history_info.h"
+
+#define GET_HISTORY_INFO_FROM_FIELD "from"
+#define GET_HISTORY_INFO_TO_FIELD "to"
+
+namespace iptv_cloud {
+namespace server {
+namespace stream {
+
+GetHistoryInfo::GetHistoryInfo() : base_class(), from_(0), to_(0) {}
+
+GetHistoryInfo::GetHistoryInfo(stream_id_t stream_id, fastotv::timestamp_t from, fastotv::timestamp_t to)
+    : base_class(stream_id), from_(from), to_(to) {}
+
+fastotv::timestamp_t GetHistoryInfo::GetFrom() const {
+  return from_;
+}
+
+fastotv::timestamp_t GetHistoryInfo::GetTo() const {
+  return to_;
+}
+
+common::Error GetHistoryInfo::DoDeSerialize(json_object* serialized) {
+  GetHistoryInfo inf;
+  common::Error err = inf.base_class::DoDeSerialize(serialized);
+  if (err) {
+    return err;
+  }
+
+  json_object* jfrom = nullptr;
+  json_bool jfrom_exists = json_object_object_get_ex(serialized, GET_HISTORY_INFO_FROM_FIELD, &jfrom);
+  if (jfrom_exists) {
+    inf.from_ = json_object_get_int64(jfrom);
+  }
+
+  json_object* jto = nullptr;
+  json_bool jto_exists = json_object_object_get_ex(serialized, GET_HISTORY_INFO_TO_FIELD, &jto);
+  if (jto_exists) {
+    inf.to_ = json_object_get_int64(jto);
+  }
+
+  *this = inf;
+  return common::Error();
+}
+
+common::Error GetHistoryInfo::SerializeFields(json_object* out) const {
+  json_object_object_add(out, GET_HISTORY_INFO_FROM_FIELD, json_object_new_int64(from_));
+  json_object_object_add(out, GET_HISTORY_INFO_TO_FIELD, json_object_new_int64(to_));
+  return base_class::SerializeFields(out);
+}
+
+}  // namespace stream
+}  // namespace server
+}  // namespace iptv_cloud
@@ -0,0 +1,44 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "server/daemon/commands_info/stream/stream_info.h"
+
+namespace iptv_cloud {
+namespace server {
+namespace stream {
+
+class GetHistoryInfo : public StreamInfo {
+ public:
+  typedef StreamInfo base_class;
+
+  GetHistoryInfo();
+  GetHistoryInfo(stream_id_t stream_id, fastotv::timestamp_t from, fastotv::timestamp_t to);
+
+  fastotv::timestamp_t GetFrom() const;  // utc msec, 0 means oldest sample
+  fastotv::timestamp_t GetTo() const;    // utc msec, 0 means newest sample
+
+ protected:
+  common::Error DoDeSerialize(json_object* serialized) override;
+  common::Error SerializeFields(json_object* out) const override;
+
+ private:
+  fastotv::timestamp_t from_;
+  fastotv::timestamp_t to_;
+};
+
+}  // namespace stream
+}  // namespace server
+}  // namespace iptv_cloud
@@ -18,15 +18,16 @@
 
 #define GET_LOG_INFO_PATH_FIELD "path"
 #define GET_LOG_INFO_FEEDBACK_DIR_FIELD "feedback_directory"
+#define GET_LOG_INFO_TAIL_SIZE_FIELD "tail_size"
 
 namespace iptv_cloud {
 namespace server {
 namespace stream {
 
-GetLogInfo::GetLogInfo() : base_class(), feedback_dir_(), path_() {}
+GetLogInfo::GetLogInfo() : base_class(), feedback_dir_(), path_(), tail_size_(0) {}
 
-GetLogInfo::GetLogInfo(stream_id_t stream_id, const std::string& feedback_dir, const url_t& path)
-    : base_class(stream_id), feedback_dir_(feedback_dir), path_(path) {}
+GetLogInfo::GetLogInfo(stream_id_t stream_id, const std::string& feedback_dir, const url_t& path, size_t tail_size)
+    : base_class(stream_id), feedback_dir_(feedback_dir), path_(path), tail_size_(tail_size) {}
 
 GetLogInfo::url_t GetLogInfo::GetLogPath() const {
   return path_;
@@ -36,6 +37,10 @@ std::string GetLogInfo::GetFeedbackDir() const {
   return feedback_dir_;
 }
 
+size_t GetLogInfo::GetTailSize() const {
+  return tail_size_;
+}
+
 common::Error GetLogInfo::DoDeSerialize(json_object* serialized) {
   GetLogInfo inf;
   common::Error err = inf.base_class::DoDeSerialize(serialized);
@@ -57,6 +62,12 @@ common::Error GetLogInfo::DoDeSerialize(json_object* serialized) {
     inf.path_ = url_t(json_object_get_string(jpath));
   }
 
+  json_object* jtail_size = nullptr;
+  json_bool jtail_size_exists = json_object_object_get_ex(serialized, GET_LOG_INFO_TAIL_SIZE_FIELD, &jtail_size);
+  if (jtail_size_exists) {
+    inf.tail_size_ = json_object_get_int64(jtail_size);
+  }
+
   *this = inf;
   return common::Error();
 }
@@ -65,6 +76,7 @@ common::Error GetLogInfo::SerializeFields(json_object* out) const {
   const std::string path_str = path_.GetUrl();
   json_object_object_add(out, GET_LOG_INFO_PATH_FIELD, json_object_new_string(path_str.c_str()));
   json_object_object_add(out, GET_LOG_INFO_FEEDBACK_DIR_FIELD, json_object_new_string(feedback_dir_.c_str()));
+  json_object_object_add(out, GET_LOG_INFO_TAIL_SIZE_FIELD, json_object_new_int64(tail_size_));
   return base_class::SerializeFields(out);
 }
 
@@ -30,10 +30,14 @@ class GetLogInfo : public StreamInfo {
   typedef common::uri::Url url_t;
 
   GetLogInfo();
-  explicit GetLogInfo(stream_id_t stream_id, const std::string& feedback_dir, const url_t& log_path);
+  explicit GetLogInfo(stream_id_t stream_id,
+                      const std::string& feedback_dir,
+                      const url_t& log_path,
+                      size_t tail_size = 0);
 
   url_t GetLogPath() const;
   std::string GetFeedbackDir() const;
+  size_t GetTailSize() const;  // bytes from end of file, 0 means whole file
 
  protected:
   common::Error DoDeSerialize(json_object* serialized) override;
@@ -42,6 +46,7 @@ class GetLogInfo : public StreamInfo {
  private:
   std::string feedback_dir_;
   common::uri::Url path_;
+  size_t tail_size_;
 };
 
 }  // namespace stream
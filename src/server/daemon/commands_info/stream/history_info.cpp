@@ -0,0 +1,115 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/daemon/commands_info/stream/history_info.h"
+
+#define HISTORY_INFO_RUNS_FIELD "runs"
+#define HISTORY_RUN_START_FIELD "start"
+#define HISTORY_RUN_INPUT_BPS_FIELD "input_bps"
+#define HISTORY_RUN_OUTPUT_BPS_FIELD "output_bps"
+#define HISTORY_RUN_STATUS_FIELD "status"
+#define HISTORY_RUN_RESTARTS_FIELD "restarts"
+
+namespace {
+
+template <typename T>
+json_object* MakeArray(const std::vector<T>& values) {
+  json_object* jarray = json_object_new_array();
+  for (const T& value : values) {
+    json_object_array_add(jarray, json_object_new_int64(value));
+  }
+  return jarray;
+}
+
+template <typename T>
+void ReadArray(json_object* jrun, const char* field, std::vector<T>* values) {
+  json_object* jarray = nullptr;
+  json_bool jarray_exists = json_object_object_get_ex(jrun, field, &jarray);
+  if (!jarray_exists) {
+    return;
+  }
+
+  const size_t len = json_object_array_length(jarray);
+  values->reserve(len);
+  for (size_t i = 0; i < len; ++i) {
+    values->push_back(static_cast<T>(json_object_get_int64(json_object_array_get_idx(jarray, i))));
+  }
+}
+
+}  // namespace
+
+namespace iptv_cloud {
+namespace server {
+namespace stream {
+
+HistoryRun::HistoryRun() : start(0), input_bps(), output_bps(), status(), restarts() {}
+
+HistoryInfo::HistoryInfo() : base_class(), runs_() {}
+
+HistoryInfo::HistoryInfo(stream_id_t stream_id, const runs_t& runs) : base_class(stream_id), runs_(runs) {}
+
+HistoryInfo::runs_t HistoryInfo::GetRuns() const {
+  return runs_;
+}
+
+common::Error HistoryInfo::DoDeSerialize(json_object* serialized) {
+  HistoryInfo inf;
+  common::Error err = inf.base_class::DoDeSerialize(serialized);
+  if (err) {
+    return err;
+  }
+
+  json_object* jruns = nullptr;
+  json_bool jruns_exists = json_object_object_get_ex(serialized, HISTORY_INFO_RUNS_FIELD, &jruns);
+  if (jruns_exists) {
+    const size_t len = json_object_array_length(jruns);
+    for (size_t i = 0; i < len; ++i) {
+      json_object* jrun = json_object_array_get_idx(jruns, i);
+      HistoryRun run;
+      json_object* jstart = nullptr;
+      json_bool jstart_exists = json_object_object_get_ex(jrun, HISTORY_RUN_START_FIELD, &jstart);
+      if (!jstart_exists) {
+        return common::make_error_inval();
+      }
+      run.start = json_object_get_int64(jstart);
+      ReadArray(jrun, HISTORY_RUN_INPUT_BPS_FIELD, &run.input_bps);
+      ReadArray(jrun, HISTORY_RUN_OUTPUT_BPS_FIELD, &run.output_bps);
+      ReadArray(jrun, HISTORY_RUN_STATUS_FIELD, &run.status);
+      ReadArray(jrun, HISTORY_RUN_RESTARTS_FIELD, &run.restarts);
+      inf.runs_.push_back(run);
+    }
+  }
+
+  *this = inf;
+  return common::Error();
+}
+
+common::Error HistoryInfo::SerializeFields(json_object* out) const {
+  json_object* jruns = json_object_new_array();
+  for (const HistoryRun& run : runs_) {
+    json_object* jrun = json_object_new_object();
+    json_object_object_add(jrun, HISTORY_RUN_START_FIELD, json_object_new_int64(run.start));
+    json_object_object_add(jrun, HISTORY_RUN_INPUT_BPS_FIELD, MakeArray(run.input_bps));
+    json_object_object_add(jrun, HISTORY_RUN_OUTPUT_BPS_FIELD, MakeArray(run.output_bps));
+    json_object_object_add(jrun, HISTORY_RUN_STATUS_FIELD, MakeArray(run.status));
+    json_object_object_add(jrun, HISTORY_RUN_RESTARTS_FIELD, MakeArray(run.restarts));
+    json_object_array_add(jruns, jrun);
+  }
+  json_object_object_add(out, HISTORY_INFO_RUNS_FIELD, jruns);
+  return base_class::SerializeFields(out);
+}
+
+}  // namespace stream
+}  // namespace server
+}  // namespace iptv_cloud
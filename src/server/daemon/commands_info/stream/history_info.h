@@ -0,0 +1,56 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <vector>
+
+#include "base/stream_struct.h"
+#include "server/daemon/commands_info/stream/stream_info.h"
+
+namespace iptv_cloud {
+namespace server {
+namespace stream {
+
+struct HistoryRun {  // samples of consecutive seconds
+  HistoryRun();
+
+  fastotv::timestamp_t start;  // utc msec of first sample
+  std::vector<uint64_t> input_bps;
+  std::vector<uint64_t> output_bps;
+  std::vector<StreamStatus> status;
+  std::vector<uint64_t> restarts;
+};
+
+class HistoryInfo : public StreamInfo {
+ public:
+  typedef StreamInfo base_class;
+  typedef std::vector<HistoryRun> runs_t;
+
+  HistoryInfo();
+  HistoryInfo(stream_id_t stream_id, const runs_t& runs);
+
+  runs_t GetRuns() const;
+
+ protected:
+  common::Error DoDeSerialize(json_object* serialized) override;
+  common::Error SerializeFields(json_object* out) const override;
+
+ private:
+  runs_t runs_;
+};
+
+}  // namespace stream
+}  // namespace server
+}  // namespace iptv_cloud
@@ -31,6 +31,7 @@
 #include <common/utils.h>
 
 #include "server/process_slave_wrapper.h"
+#include "utils/async_logger.h"
 
 #define HELP_TEXT                          \
   "Usage: " STREAMER_SERVICE_NAME          \
@@ -112,8 +113,16 @@ int main(int argc, char** argv, char** envp) {
     }
   }
 
-  common::logging::INIT_LOGGER(STREAMER_SERVICE_NAME, config.log_path, config.log_level,
-                               kMaxSizeLogFile);  // initialization of logging system
+  // console logging is routed into async logger, loops never wait for log file
+  common::logging::INIT_LOGGER(STREAMER_SERVICE_NAME, config.log_level);  // initialization of logging system
+  iptv_cloud::utils::AsyncLogger async_logger(config.log_path, kMaxSizeLogFile);
+  common::ErrnoError errn = async_logger.Start();
+  if (errn) {  // logging library handles file as before
+    common::logging::INIT_LOGGER(STREAMER_SERVICE_NAME, config.log_path, config.log_level, kMaxSizeLogFile);
+    WARNING_LOG() << "Async logging disabled, error: " << errn->GetDescription();
+  } else {
+    async_logger.AttachStreams();
+  }
 
   const pid_t daemon_pid = getpid();
   const std::string folder_path_to_pid = common::file_system::get_dir_path(PIDFILE_PATH);
@@ -14,26 +14,79 @@
 
 #include "server/http/handler.h"
 
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/stat.h>
+#include <time.h>
 #include <unistd.h>
 
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
 #include <string>
 #include <utility>
 
+#include <common/libev/io_loop.h>
+#include <common/time.h>
+
 #include "server/base/ihttp_requests_observer.h"
 #include "server/http/client.h"
+#include "server/metrics_registry.h"
+
+#include "utils/hls_shm.h"
+#include "utils/ll_hls.h"
+
+#define METRICS_FILE_NAME "metrics"
+
+namespace {
+const double kBlockingCheckIntervalSec = 0.05;
+const fastotv::timestamp_t kMemoryStoreCheckMsec = 1000;  // restarted streams replace their stores, misses expire
+
+bool IsPlaylistName(const std::string& file_name) {
+  const std::string ext = "." M3U8_EXTENSION;
+  return file_name.size() > ext.size() && file_name.compare(file_name.size() - ext.size(), ext.size(), ext) == 0;
+}
+
+bool ReadFile(const std::string& file_path, std::string* data) {
+  std::ifstream file(file_path);
+  if (!file) {
+    return false;
+  }
+
+  std::stringstream content;
+  content << file.rdbuf();
+  *data = content.str();
+  return true;
+}
+}  // namespace
 
 namespace iptv_cloud {
 namespace server {
 
 HttpHandler::HttpHandler(base::IHttpRequestsObserver* observer)
-    : base_class(), http_root_(http_directory_path_t::MakeHomeDir()), observer_(observer) {}
+    : base_class(),
+      http_root_(http_directory_path_t::MakeHomeDir()),
+      observer_(observer),
+      metrics_(nullptr),
+      blocking_requests_(),
+      blocking_timer_(INVALID_TIMER_ID),
+      memory_stores_() {}
+
+HttpHandler::~HttpHandler() {
+  for (auto& store : memory_stores_) {
+    delete store.second.reader;
+  }
+}
 
 void HttpHandler::SetHttpRoot(const http_directory_path_t& http_root) {
   http_root_ = http_root;
 }
 
+void HttpHandler::SetMetrics(MetricsRegistry* metrics) {
+  metrics_ = metrics;
+}
+
 void HttpHandler::PreLooped(common::libev::IoLoop* server) {
   base_class::PreLooped(server);
 }
@@ -47,10 +100,19 @@ void HttpHandler::Moved(common::libev::IoLoop* server, common::libev::IoClient*
 }
 
 void HttpHandler::Closed(common::libev::IoClient* client) {
+  HttpClient* hclient = static_cast<HttpClient*>(client);
+  blocking_requests_.erase(std::remove_if(blocking_requests_.begin(), blocking_requests_.end(),
+                                          [hclient](const HlsRequest& request) {
+                                            return request.client == hclient;
+                                          }),
+                           blocking_requests_.end());
   base_class::Closed(client);
 }
 
 void HttpHandler::TimerEmited(common::libev::IoLoop* server, common::libev::timer_id_t id) {
+  if (blocking_timer_ == id) {
+    ServeBlockingRequests(server);
+  }
   base_class::TimerEmited(server, id);
 }
 
@@ -88,6 +150,11 @@ void HttpHandler::DataReadyToWrite(common::libev::IoClient* client) {
 }
 
 void HttpHandler::PostLooped(common::libev::IoLoop* server) {
+  if (blocking_timer_ != INVALID_TIMER_ID) {
+    server->RemoveTimer(blocking_timer_);
+    blocking_timer_ = INVALID_TIMER_ID;
+  }
+  blocking_requests_.clear();
   base_class::PostLooped(server);
 }
 
@@ -130,6 +197,15 @@ void HttpHandler::ProcessReceived(HttpClient* hclient, const char* request, size
     }
 
     const std::string url_dirs = path.GetHpath();
+    if (metrics_ && url_dirs == "/" && path.GetFileName() == METRICS_FILE_NAME) {
+      SendMetrics(hclient, protocol, hrequest.GetMethod() == common::http::http_method::HM_GET, IsKeepAlive);
+      if (!IsKeepAlive) {
+        hclient->Close();
+        delete hclient;
+      }
+      return;
+    }
+
     auto dirs_path = http_root_.MakeDirectoryStringPath(url_dirs.substr(1));
     if (!dirs_path) {
       dirs_path = http_root_;
@@ -149,64 +225,296 @@ void HttpHandler::ProcessReceived(HttpClient* hclient, const char* request, size
       observer_->OnHttpRequest(hclient, *file_path);
     }
 
-    const std::string file_path_str = file_path->GetPath();
-    int open_flags = O_RDONLY;
-    struct stat sb;
-    if (stat(file_path_str.c_str(), &sb) < 0) {
-      common::ErrnoError err =
-          hclient->SendError(protocol, common::http::HS_NOT_FOUND, extra_header, "File not found.", IsKeepAlive, hinf);
-      WARNING_LOG() << "File path: " << file_path_str << ", not found";
-      if (err) {
-        DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+    HlsRequest hls_request;
+    hls_request.client = hclient;
+    hls_request.protocol = protocol;
+    hls_request.with_body = hrequest.GetMethod() == common::http::http_method::HM_GET;
+    hls_request.keep_alive = IsKeepAlive;
+    hls_request.directory = dirs_path->GetPath();
+    hls_request.file_name = path.GetFileName();
+    hls_request.file_path = file_path->GetPath();
+    hls_request.mime = path.GetMime();
+    hls_request.is_playlist = false;
+    hls_request.msn = 0;
+    hls_request.part = -1;
+    hls_request.expire_time = common::time::current_utc_mstime();
+
+    utils::LLHlsPlaylistState state;
+    if (IsPlaylistName(hls_request.file_name) &&
+        utils::ParseBlockingReload(path.GetQuery(), &hls_request.msn, &hls_request.part) &&
+        ReadPlaylistState(hls_request, &state)) {
+      const utils::BlockingReload reload = utils::CheckBlockingReload(state, hls_request.msn, hls_request.part);
+      if (reload == utils::BLOCKING_TOO_FAR) {
+        common::ErrnoError err = hclient->SendError(protocol, common::http::HS_BAD_REQUEST, extra_header,
+                                                    "Media sequence is too far.", IsKeepAlive, hinf);
+        if (err) {
+          DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+        }
+        return;
       }
-      return;
-    }
 
-    if (S_ISDIR(sb.st_mode)) {
-      common::ErrnoError err =
-          hclient->SendError(protocol, common::http::HS_BAD_REQUEST, extra_header, "Bad filename.", IsKeepAlive, hinf);
-      if (err) {
-        DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+      if (reload == utils::BLOCKING_WAIT) {
+        // rfc8216bis 6.2.5.2, hold up to 3 target durations
+        const size_t target_duration =
+            state.target_duration ? state.target_duration : utils::LLHlsPackager::TARGET_DURATION;
+        hls_request.is_playlist = true;
+        hls_request.expire_time += target_duration * 3 * 1000;
+        HoldRequest(hls_request);
+        return;
       }
+    } else if (utils::IsLLHlsPartName(hls_request.file_name) && !IsHlsFileExists(hls_request)) {
+      // preload hint, part is being cut now
+      hls_request.expire_time += utils::LLHlsPackager::PART_TARGET_MSEC * 3;
+      HoldRequest(hls_request);
       return;
     }
 
-    int file = open(file_path_str.c_str(), open_flags);
-    if (file == INVALID_DESCRIPTOR) { /* open the file for reading */
-      common::ErrnoError err = hclient->SendError(protocol, common::http::HS_FORBIDDEN, extra_header,
-                                                  "File is protected.", IsKeepAlive, hinf);
-      if (err) {
-        DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
-      }
+    if (!SendHlsFile(hls_request)) {
       return;
     }
+  }
+
+  if (!IsKeepAlive) {
+    hclient->Close();
+    delete hclient;
+  }
+}
 
-    const std::string mime = path.GetMime();
-    common::ErrnoError err = hclient->SendHeaders(protocol, common::http::HS_OK, extra_header, mime.c_str(),
-                                                  &sb.st_size, &sb.st_mtime, IsKeepAlive, hinf);
+bool HttpHandler::SendFile(HttpClient* hclient,
+                           common::http::http_protocol protocol,
+                           const std::string& file_path,
+                           const std::string& mime,
+                           bool with_body,
+                           bool keep_alive) {
+  static const common::libev::http::HttpServerInfo hinf(PROJECT_NAME_TITLE, PROJECT_DOMAIN);
+  const char* extra_header = nullptr;
+  int open_flags = O_RDONLY;
+  struct stat sb;
+  if (stat(file_path.c_str(), &sb) < 0) {
+    common::ErrnoError err =
+        hclient->SendError(protocol, common::http::HS_NOT_FOUND, extra_header, "File not found.", keep_alive, hinf);
+    WARNING_LOG() << "File path: " << file_path << ", not found";
     if (err) {
       DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
-      ::close(file);
-      return;
     }
+    return false;
+  }
 
-    if (hrequest.GetMethod() == common::http::http_method::HM_GET) {
-      common::ErrnoError err = hclient->SendFileByFd(protocol, file, sb.st_size);
-      if (err) {
-        DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
-      } else {
-        DEBUG_LOG() << "Sent file path: " << file_path_str << ", size: " << sb.st_size;
-      }
+  if (S_ISDIR(sb.st_mode)) {
+    common::ErrnoError err =
+        hclient->SendError(protocol, common::http::HS_BAD_REQUEST, extra_header, "Bad filename.", keep_alive, hinf);
+    if (err) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
     }
+    return false;
+  }
 
+  int file = open(file_path.c_str(), open_flags);
+  if (file == INVALID_DESCRIPTOR) { /* open the file for reading */
+    common::ErrnoError err = hclient->SendError(protocol, common::http::HS_FORBIDDEN, extra_header,
+                                                "File is protected.", keep_alive, hinf);
+    if (err) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+    }
+    return false;
+  }
+
+  common::ErrnoError err = hclient->SendHeaders(protocol, common::http::HS_OK, extra_header, mime.c_str(), &sb.st_size,
+                                                &sb.st_mtime, keep_alive, hinf);
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
     ::close(file);
+    return false;
   }
 
-  if (!IsKeepAlive) {
+  if (with_body) {
+    common::ErrnoError err = hclient->SendFileByFd(protocol, file, sb.st_size);
+    if (err) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+    } else {
+      DEBUG_LOG() << "Sent file path: " << file_path << ", size: " << sb.st_size;
+    }
+  }
+
+  ::close(file);
+  return true;
+}
+
+bool HttpHandler::SendBuffer(HttpClient* hclient,
+                             common::http::http_protocol protocol,
+                             const char* mime,
+                             const char* data,
+                             size_t size,
+                             bool with_body,
+                             bool keep_alive) {
+  static const common::libev::http::HttpServerInfo hinf(PROJECT_NAME_TITLE, PROJECT_DOMAIN);
+  off_t data_size = size;
+  time_t render_time = time(nullptr);
+  common::ErrnoError err =
+      hclient->SendHeaders(protocol, common::http::HS_OK, nullptr, mime, &data_size, &render_time, keep_alive, hinf);
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+    return false;
+  }
+
+  if (with_body) {
+    size_t nwrite = 0;
+    err = hclient->Write(data, size, &nwrite);
+    if (err) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+    }
+  }
+  return true;
+}
+
+utils::HlsShmStoreReader* HttpHandler::FindMemoryStore(const std::string& directory) {
+  const fastotv::timestamp_t now = common::time::current_utc_mstime();
+  auto it = memory_stores_.find(directory);
+  if (it != memory_stores_.end()) {
+    MemoryStore* store = &it->second;
+    if (now - store->checked_time < kMemoryStoreCheckMsec) {
+      return store->reader;
+    }
+
+    if (store->reader && !store->reader->IsStale()) {
+      store->checked_time = now;
+      return store->reader;
+    }
+
+    delete store->reader;
+    memory_stores_.erase(it);
+  }
+
+  // disk outputs don't have store, misses are cached as well so files are not slowed by shm_open
+  utils::HlsShmStoreReader* reader = new utils::HlsShmStoreReader(utils::MakeHlsShmName(directory));
+  common::ErrnoError err = reader->Open();
+  if (err) {
+    delete reader;
+    reader = nullptr;
+  }
+
+  MemoryStore store = {reader, now};
+  memory_stores_.insert(std::make_pair(directory, store));
+  return reader;
+}
+
+bool HttpHandler::SendHlsFile(const HlsRequest& request) {
+  utils::HlsShmStoreReader* store = FindMemoryStore(request.directory);
+  if (!store) {
+    return SendFile(request.client, request.protocol, request.file_path, request.mime, request.with_body,
+                    request.keep_alive);
+  }
+
+  std::string data;
+  if (!store->Get(request.file_name, &data)) {
+    static const common::libev::http::HttpServerInfo hinf(PROJECT_NAME_TITLE, PROJECT_DOMAIN);
+    common::ErrnoError err = request.client->SendError(request.protocol, common::http::HS_NOT_FOUND, nullptr,
+                                                       "File not found.", request.keep_alive, hinf);
+    if (err) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+    }
+    return false;
+  }
+
+  return SendBuffer(request.client, request.protocol, request.mime.c_str(), data.data(), data.size(),
+                    request.with_body, request.keep_alive);
+}
+
+bool HttpHandler::IsHlsFileExists(const HlsRequest& request) {
+  utils::HlsShmStoreReader* store = FindMemoryStore(request.directory);
+  if (store) {
+    return store->Exists(request.file_name);
+  }
+  return access(request.file_path.c_str(), F_OK) == 0;
+}
+
+bool HttpHandler::ReadPlaylistState(const HlsRequest& request, utils::LLHlsPlaylistState* state) {
+  utils::HlsShmStoreReader* store = FindMemoryStore(request.directory);
+  std::string playlist;
+  const bool have_playlist = store ? store->Get(request.file_name, &playlist) : ReadFile(request.file_path, &playlist);
+  return have_playlist && utils::ParseLLHlsPlaylist(playlist, state);
+}
+
+void HttpHandler::HoldRequest(const HlsRequest& request) {
+  blocking_requests_.push_back(request);
+  if (blocking_timer_ == INVALID_TIMER_ID) {
+    blocking_timer_ = request.client->GetServer()->CreateTimer(kBlockingCheckIntervalSec, true);
+  }
+}
+
+void HttpHandler::ServeBlockingRequests(common::libev::IoLoop* server) {
+  const fastotv::timestamp_t now = common::time::current_utc_mstime();
+  std::map<std::string, utils::LLHlsPlaylistState> playlists;  // every playlist read once per check
+  auto is_ready = [this, &playlists](const HlsRequest& request) {
+    if (!request.is_playlist) {
+      return IsHlsFileExists(request);
+    }
+
+    auto it = playlists.find(request.file_path);
+    if (it == playlists.end()) {
+      utils::LLHlsPlaylistState state;
+      if (!ReadPlaylistState(request, &state)) {
+        return false;
+      }
+      it = playlists.insert(std::make_pair(request.file_path, state)).first;
+    }
+    // stream restarted with new media sequence, client gets current playlist
+    return utils::CheckBlockingReload(it->second, request.msn, request.part) != utils::BLOCKING_WAIT;
+  };
+
+  // served client may be closed and its requests removed, so search again after every reply
+  while (true) {
+    bool ready = false;
+    auto it = std::find_if(blocking_requests_.begin(), blocking_requests_.end(),
+                           [&is_ready, &ready, now](const HlsRequest& request) {
+                             ready = is_ready(request);
+                             return ready || request.expire_time <= now;
+                           });
+    if (it == blocking_requests_.end()) {
+      break;
+    }
+
+    const HlsRequest request = *it;
+    blocking_requests_.erase(it);
+    ServeBlockingRequest(request, ready);
+  }
+
+  if (blocking_requests_.empty()) {
+    server->RemoveTimer(blocking_timer_);
+    blocking_timer_ = INVALID_TIMER_ID;
+  }
+}
+
+void HttpHandler::ServeBlockingRequest(const HlsRequest& request, bool ready) {
+  static const common::libev::http::HttpServerInfo hinf(PROJECT_NAME_TITLE, PROJECT_DOMAIN);
+  HttpClient* hclient = request.client;
+  if (ready || request.is_playlist) {
+    if (!SendHlsFile(request)) {
+      return;
+    }
+  } else {
+    common::ErrnoError err = hclient->SendError(request.protocol, common::http::HS_NOT_FOUND, nullptr,
+                                                "File not found.", request.keep_alive, hinf);
+    if (err) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+    }
+    return;
+  }
+
+  if (!request.keep_alive) {
     hclient->Close();
     delete hclient;
   }
 }
 
+void HttpHandler::SendMetrics(HttpClient* hclient,
+                              common::http::http_protocol protocol,
+                              bool with_body,
+                              bool keep_alive) {
+  size_t text_len = 0;
+  const char* text = metrics_->Render(&text_len);
+  SendBuffer(hclient, protocol, MetricsRegistry::GetContentType(), text, text_len, with_body, keep_alive);
+}
+
 }  // namespace server
 }  // namespace iptv_cloud
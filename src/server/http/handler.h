@@ -14,14 +14,27 @@
 
 #pragma once
 
+#include <map>
+#include <string>
+#include <vector>
+
 #include <common/file_system/path.h>
+#include <common/http/http.h>
+#include <common/libev/types.h>
+
+#include "base/types.h"
 
 #include "server/base/iserver_handler.h"
 
 namespace iptv_cloud {
+namespace utils {
+class HlsShmStoreReader;
+struct LLHlsPlaylistState;
+}  // namespace utils
 namespace server {
 
 class HttpClient;
+class MetricsRegistry;
 namespace base {
 class IHttpRequestsObserver;
 }
@@ -32,8 +45,11 @@ class HttpHandler : public base::IServerHandler {
   typedef base::IServerHandler base_class;
   typedef common::file_system::ascii_directory_string_path http_directory_path_t;
   explicit HttpHandler(base::IHttpRequestsObserver* observer);
+  ~HttpHandler() override;
 
   void SetHttpRoot(const http_directory_path_t& http_root);
+  // serve /metrics, handler doesn't own registry
+  void SetMetrics(MetricsRegistry* metrics);
 
   void PreLooped(common::libev::IoLoop* server) override;
 
@@ -53,10 +69,63 @@ class HttpHandler : public base::IServerHandler {
   void PostLooped(common::libev::IoLoop* server) override;
 
  private:
+  // file request, low latency hls ones are held until playlist has requested segment or part file is cut
+  struct HlsRequest {
+    HttpClient* client;
+    common::http::http_protocol protocol;
+    bool with_body;
+    bool keep_alive;
+    std::string directory;
+    std::string file_name;
+    std::string file_path;
+    std::string mime;
+    bool is_playlist;
+    uint64_t msn;
+    int64_t part;
+    fastotv::timestamp_t expire_time;
+  };
+
+  struct MemoryStore {
+    utils::HlsShmStoreReader* reader;  // nullptr - disk output, miss is cached too
+    fastotv::timestamp_t checked_time;
+  };
+
   void ProcessReceived(HttpClient* hclient, const char* request, size_t req_len);
+  // false if error was sent instead of file
+  bool SendFile(HttpClient* hclient,
+                common::http::http_protocol protocol,
+                const std::string& file_path,
+                const std::string& mime,
+                bool with_body,
+                bool keep_alive);
+  bool SendBuffer(HttpClient* hclient,
+                  common::http::http_protocol protocol,
+                  const char* mime,
+                  const char* data,
+                  size_t size,
+                  bool with_body,
+                  bool keep_alive);
+  void SendMetrics(HttpClient* hclient, common::http::http_protocol protocol, bool with_body, bool keep_alive);
+
+  // memory outputs first, then disk
+  utils::HlsShmStoreReader* FindMemoryStore(const std::string& directory);
+  bool SendHlsFile(const HlsRequest& request);
+  bool IsHlsFileExists(const HlsRequest& request);
+  bool ReadPlaylistState(const HlsRequest& request, utils::LLHlsPlaylistState* state);
+
+  void HoldRequest(const HlsRequest& request);
+  void ServeBlockingRequests(common::libev::IoLoop* server);
+  void ServeBlockingRequest(const HlsRequest& request, bool ready);
 
   http_directory_path_t http_root_;
   base::IHttpRequestsObserver* observer_;
+  MetricsRegistry* metrics_;
+
+  // waiting clients don't take threads, they are checked by timer of http loop
+  std::vector<HlsRequest> blocking_requests_;
+  common::libev::timer_id_t blocking_timer_;
+
+  std::map<std::string, MemoryStore> memory_stores_;  // by directory
 };
 
 }  // namespace server
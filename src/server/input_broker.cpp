@@ -0,0 +1,224 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/input_broker.h"
+
+#include <algorithm>
+
+#include <common/sprintf.h>
+
+#include "base/config_fields.h"
+
+namespace {
+uint64_t fnv1a64(const std::string& data) {
+  uint64_t hash = 14695981039346656037ULL;
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+}  // namespace
+
+namespace iptv_cloud {
+namespace server {
+
+InputBroker::InputBroker(const std::string& sockets_prefix)
+    : sockets_prefix_(sockets_prefix), inputs_(), streams_() {}
+
+bool InputBroker::IsShareableInput(const StreamConfig& config) {
+  if (config.type != RELAY && config.type != ENCODE && config.type != TIMESHIFT_RECORDER && config.type != CATCHUP) {
+    return false;
+  }
+
+  if (config.input.size() != 1) {  // mosaic and playlists
+    return false;
+  }
+
+  // network upstreams only, files are cheap to open twice
+  const common::uri::Url::scheme scheme = config.input[0].GetInput().GetScheme();
+  return scheme == common::uri::Url::http || scheme == common::uri::Url::https || scheme == common::uri::Url::udp ||
+         scheme == common::uri::Url::rtmp || scheme == common::uri::Url::tcp;
+}
+
+bool InputBroker::Attach(StreamConfig* config) {
+  if (!config || !IsShareableInput(*config)) {
+    return false;
+  }
+
+  if (streams_.find(config->id) != streams_.end()) {
+    return Update(config);
+  }
+
+  const std::string upstream = GetUpstream(*config);
+  auto it = inputs_.find(upstream);
+  if (it == inputs_.end()) {
+    SharedInput input = {config->id, std::vector<stream_id_t>(), MakeSocketPath(upstream)};
+    it = inputs_.insert(std::make_pair(upstream, input)).first;
+  } else {
+    it->second.readers.push_back(config->id);
+  }
+
+  Entry entry = {upstream, *config};
+  streams_[config->id] = entry;
+  ApplyRole(it->second, config->id, config);
+  return true;
+}
+
+bool InputBroker::Update(StreamConfig* config) {
+  if (!config) {
+    return false;
+  }
+
+  auto sit = streams_.find(config->id);
+  if (sit == streams_.end() || !IsShareableInput(*config) || sit->second.upstream != GetUpstream(*config)) {
+    return false;
+  }
+
+  sit->second.original = *config;
+  ApplyRole(inputs_[sit->second.upstream], config->id, config);
+  return true;
+}
+
+bool InputBroker::Detach(stream_id_t sid, StreamConfig* promoted) {
+  auto sit = streams_.find(sid);
+  if (sit == streams_.end()) {
+    return false;
+  }
+
+  const std::string upstream = sit->second.upstream;
+  streams_.erase(sit);
+  auto it = inputs_.find(upstream);
+  if (it == inputs_.end()) {
+    return false;
+  }
+
+  SharedInput* input = &it->second;
+  if (input->publisher != sid) {
+    input->readers.erase(std::remove(input->readers.begin(), input->readers.end(), sid), input->readers.end());
+    return false;
+  }
+
+  if (input->readers.empty()) {
+    inputs_.erase(it);
+    return false;
+  }
+
+  // same socket path, so other readers find the new publisher without reconfiguration
+  input->publisher = input->readers.front();
+  input->readers.erase(input->readers.begin());
+  if (!promoted) {
+    return false;
+  }
+
+  StreamConfig lpromoted = streams_[input->publisher].original;
+  ApplyRole(*input, input->publisher, &lpromoted);
+  *promoted = lpromoted;
+  return true;
+}
+
+bool InputBroker::GetRole(stream_id_t sid, StreamConfig* original, bool* publisher) const {
+  auto sit = streams_.find(sid);
+  if (sit == streams_.end()) {
+    return false;
+  }
+
+  if (original) {
+    *original = sit->second.original;
+  }
+  if (publisher) {
+    *publisher = IsPublisher(sid);
+  }
+  return true;
+}
+
+bool InputBroker::Restore(const StreamConfig& original, bool publisher, StreamConfig* promoted) {
+  if (!IsShareableInput(original) || streams_.find(original.id) != streams_.end()) {
+    return false;
+  }
+
+  const std::string upstream = GetUpstream(original);
+  auto it = inputs_.find(upstream);
+  bool promote = false;
+  if (it == inputs_.end()) {
+    SharedInput input = {original.id, std::vector<stream_id_t>(), MakeSocketPath(upstream)};
+    it = inputs_.insert(std::make_pair(upstream, input)).first;
+    promote = !publisher;
+  } else {
+    it->second.readers.push_back(original.id);
+  }
+
+  Entry entry = {upstream, original};
+  streams_[original.id] = entry;
+  if (!promote || !promoted) {
+    return false;
+  }
+
+  StreamConfig lpromoted = original;
+  ApplyRole(it->second, original.id, &lpromoted);
+  *promoted = lpromoted;
+  return true;
+}
+
+bool InputBroker::IsPublisher(stream_id_t sid) const {
+  auto sit = streams_.find(sid);
+  if (sit == streams_.end()) {
+    return false;
+  }
+
+  auto it = inputs_.find(sit->second.upstream);
+  return it != inputs_.end() && it->second.publisher == sid;
+}
+
+bool InputBroker::IsReader(stream_id_t sid) const {
+  return streams_.find(sid) != streams_.end() && !IsPublisher(sid);
+}
+
+size_t InputBroker::GetReadersCount(stream_id_t publisher) const {
+  auto sit = streams_.find(publisher);
+  if (sit == streams_.end()) {
+    return 0;
+  }
+
+  auto it = inputs_.find(sit->second.upstream);
+  if (it == inputs_.end() || it->second.publisher != publisher) {
+    return 0;
+  }
+  return it->second.readers.size();
+}
+
+size_t InputBroker::GetSharedInputsCount() const {
+  return inputs_.size();
+}
+
+std::string InputBroker::GetUpstream(const StreamConfig& config) {
+  return config.input[0].GetInput().GetUrl();
+}
+
+std::string InputBroker::MakeSocketPath(const std::string& upstream) const {
+  return common::MemSPrintf("%s%016llx.sock", sockets_prefix_, static_cast<unsigned long long>(fnv1a64(upstream)));
+}
+
+void InputBroker::ApplyRole(const SharedInput& input, stream_id_t sid, StreamConfig* config) {
+  if (input.publisher == sid) {
+    config->args[PUBLISH_INPUT_FIELD] = input.socket_path;
+    return;
+  }
+
+  config->args.erase(PUBLISH_INPUT_FIELD);
+  config->input[0] = MakeInternalInputUrl(config->input[0].GetID(), input.socket_path);
+}
+
+}  // namespace server
+}  // namespace iptv_cloud
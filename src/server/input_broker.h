@@ -0,0 +1,81 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <common/macros.h>
+
+#include "base/stream_config.h"
+
+namespace iptv_cloud {
+namespace server {
+
+// streams of the service reading the same live upstream share one connection:
+// the first stream publishes its raw input into shared memory, later streams read it via internal:// input.
+// when the publisher exits the oldest reader becomes publisher on the same socket,
+// other readers reconnect with their next pipeline restart: shmsrc has no reconnect, its error
+// (publisher gone or not listening yet) restarts reader with usual back-off until socket is served again.
+class InputBroker {
+ public:
+  // sockets are created by publishers in service run directory, not world writable one
+  explicit InputBroker(const std::string& sockets_prefix);
+
+  static bool IsShareableInput(const StreamConfig& config);
+
+  // stream is starting, config is rewritten for its role, false if input is not shared
+  bool Attach(StreamConfig* config);
+  // stream reconfigured, keeps its role if upstream is the same, otherwise false and caller detaches/attaches it
+  bool Update(StreamConfig* config);
+  // stream exited or changed upstream, true if promoted reader must be reconfigured with promoted config
+  bool Detach(stream_id_t sid, StreamConfig* promoted);
+
+  // warm restart of service: roles are persisted with stream children and restored by next instance,
+  // publishers before their readers; true if reader lost its publisher meanwhile and must be reconfigured
+  bool GetRole(stream_id_t sid, StreamConfig* original, bool* publisher) const;
+  bool Restore(const StreamConfig& original, bool publisher, StreamConfig* promoted);
+
+  bool IsPublisher(stream_id_t sid) const;
+  bool IsReader(stream_id_t sid) const;
+  size_t GetReadersCount(stream_id_t publisher) const;
+  size_t GetSharedInputsCount() const;
+
+ private:
+  struct SharedInput {
+    stream_id_t publisher;
+    std::vector<stream_id_t> readers;  // oldest first
+    std::string socket_path;
+  };
+
+  struct Entry {
+    std::string upstream;
+    StreamConfig original;
+  };
+
+  static std::string GetUpstream(const StreamConfig& config);
+  std::string MakeSocketPath(const std::string& upstream) const;
+  static void ApplyRole(const SharedInput& input, stream_id_t sid, StreamConfig* config);
+
+  const std::string sockets_prefix_;
+  std::map<std::string, SharedInput> inputs_;  // by upstream url
+  std::map<stream_id_t, Entry> streams_;
+
+  DISALLOW_COPY_AND_ASSIGN(InputBroker);
+};
+
+}  // namespace server
+}  // namespace iptv_cloud
@@ -0,0 +1,420 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/log_uploader.h"
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <string>
+#include <utility>
+
+#include <common/convert2string.h>
+#include <common/sprintf.h>
+
+namespace {
+
+void CloseDescriptor(int* fd) {
+  if (*fd != INVALID_DESCRIPTOR) {
+    close(*fd);
+    *fd = INVALID_DESCRIPTOR;
+  }
+}
+
+// socket ready for events, ECANCELED as soon as cancel_fd becomes readable
+common::ErrnoError WaitSocket(int sock, short events, int cancel_fd) {
+  struct pollfd fds[2];
+  fds[0] = {sock, events, 0};
+  fds[1] = {cancel_fd, POLLIN, 0};
+  const nfds_t count = cancel_fd == INVALID_DESCRIPTOR ? 1 : 2;
+  while (true) {
+    int res = poll(fds, count, iptv_cloud::server::LogUploader::io_timeout_sec * 1000);
+    if (res == ERROR_RESULT_VALUE) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return common::make_errno_error(errno);
+    }
+
+    if (res == 0) {
+      return common::make_errno_error("Upload timed out", ETIMEDOUT);
+    }
+
+    if (count == 2 && fds[1].revents) {
+      return common::make_errno_error("Upload canceled", ECANCELED);
+    }
+    return common::ErrnoError();
+  }
+}
+
+common::ErrnoError ConnectSocket(int fd, const struct sockaddr* addr, socklen_t addrlen, int cancel_fd) {
+  if (connect(fd, addr, addrlen) != ERROR_RESULT_VALUE) {
+    return common::ErrnoError();
+  }
+
+  if (errno != EINPROGRESS) {
+    return common::make_errno_error(errno);
+  }
+
+  common::ErrnoError err = WaitSocket(fd, POLLOUT, cancel_fd);
+  if (err) {
+    return err;
+  }
+
+  int so_error = 0;
+  socklen_t len = sizeof(so_error);
+  if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &so_error, &len) == ERROR_RESULT_VALUE) {
+    return common::make_errno_error(errno);
+  }
+
+  if (so_error) {
+    return common::make_errno_error(so_error);
+  }
+  return common::ErrnoError();
+}
+
+common::ErrnoError ConnectToServer(const common::net::HostAndPort& server, int cancel_fd, int* out) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+
+  struct addrinfo* result = nullptr;
+  const std::string port_str = common::ConvertToString(server.GetPort());
+  int res = getaddrinfo(server.GetHost().c_str(), port_str.c_str(), &hints, &result);
+  if (res != 0 || !result) {
+    return common::make_errno_error(common::MemSPrintf("Can't resolve host: %s", server.GetHost()), EINVAL);
+  }
+
+  int fd = INVALID_DESCRIPTOR;
+  for (struct addrinfo* rp = result; rp; rp = rp->ai_next) {
+    fd = socket(rp->ai_family, rp->ai_socktype | SOCK_CLOEXEC | SOCK_NONBLOCK, rp->ai_protocol);
+    if (fd == INVALID_DESCRIPTOR) {
+      continue;
+    }
+
+    common::ErrnoError err = ConnectSocket(fd, rp->ai_addr, rp->ai_addrlen, cancel_fd);
+    if (!err) {
+      break;
+    }
+    CloseDescriptor(&fd);
+    if (err->GetErrorCode() == ECANCELED) {
+      freeaddrinfo(result);
+      return err;
+    }
+  }
+  freeaddrinfo(result);
+
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(common::MemSPrintf("Can't connect to: %s", server.GetHost()), ECONNREFUSED);
+  }
+
+  *out = fd;
+  return common::ErrnoError();
+}
+
+common::ErrnoError WriteAll(int fd, int cancel_fd, const char* data, size_t size) {
+  while (size) {
+    ssize_t nwrite = send(fd, data, size, MSG_NOSIGNAL);
+    if (nwrite == ERROR_RESULT_VALUE) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        return common::make_errno_error(errno);
+      }
+      common::ErrnoError err = WaitSocket(fd, POLLOUT, cancel_fd);
+      if (err) {
+        return err;
+      }
+      continue;
+    }
+    data += nwrite;
+    size -= nwrite;
+  }
+  return common::ErrnoError();
+}
+
+common::ErrnoError WriteChunk(int fd, int cancel_fd, const char* data, size_t size) {
+  if (!size) {
+    return common::ErrnoError();
+  }
+
+  char header[32];
+  int header_len = snprintf(header, sizeof(header), "%zx\r\n", size);
+  common::ErrnoError err = WriteAll(fd, cancel_fd, header, header_len);
+  if (err) {
+    return err;
+  }
+
+  err = WriteAll(fd, cancel_fd, data, size);
+  if (err) {
+    return err;
+  }
+  return WriteAll(fd, cancel_fd, "\r\n", 2);
+}
+
+// streams file (from offset) through gzip deflate as chunked body
+common::Error StreamBody(int sock, int cancel_fd, int file) {
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  if (deflateInit2(&zs, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+    return common::make_error("Can't init deflate");
+  }
+
+  std::string in(iptv_cloud::server::LogUploader::chunk_size, 0);
+  std::string out(iptv_cloud::server::LogUploader::chunk_size, 0);
+  int flush = Z_NO_FLUSH;
+  while (flush != Z_FINISH) {
+    ssize_t nread = read(file, &in[0], in.size());
+    if (nread == ERROR_RESULT_VALUE) {
+      if (errno == EINTR) {
+        continue;
+      }
+      deflateEnd(&zs);
+      return common::make_error_from_errno(common::make_errno_error(errno));
+    }
+
+    flush = nread == 0 ? Z_FINISH : Z_NO_FLUSH;
+    zs.next_in = reinterpret_cast<Bytef*>(&in[0]);
+    zs.avail_in = nread;
+    do {
+      zs.next_out = reinterpret_cast<Bytef*>(&out[0]);
+      zs.avail_out = out.size();
+      deflate(&zs, flush);
+      common::ErrnoError err = WriteChunk(sock, cancel_fd, out.data(), out.size() - zs.avail_out);
+      if (err) {
+        deflateEnd(&zs);
+        return common::make_error_from_errno(err);
+      }
+    } while (zs.avail_out == 0);
+  }
+
+  deflateEnd(&zs);
+  common::ErrnoError err = WriteAll(sock, cancel_fd, "0\r\n\r\n", 5);
+  if (err) {
+    return common::make_error_from_errno(err);
+  }
+  return common::Error();
+}
+
+common::Error ReadStatus(int sock, int cancel_fd) {
+  char buff[1024] = {0};
+  size_t total = 0;
+  while (total < sizeof(buff) - 1 && !strstr(buff, "\r\n")) {
+    ssize_t nread = recv(sock, buff + total, sizeof(buff) - 1 - total, 0);
+    if (nread == ERROR_RESULT_VALUE && errno == EINTR) {
+      continue;
+    }
+    if (nread == ERROR_RESULT_VALUE && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+      common::ErrnoError err = WaitSocket(sock, POLLIN, cancel_fd);
+      if (err) {
+        return common::make_error_from_errno(err);
+      }
+      continue;
+    }
+    if (nread <= 0) {
+      break;
+    }
+    total += nread;
+  }
+
+  int status = 0;
+  if (sscanf(buff, "HTTP/%*d.%*d %d", &status) != 1) {
+    return common::make_error("Invalid http response");
+  }
+
+  if (status < 200 || status >= 300) {
+    return common::make_error(common::MemSPrintf("Upload failed, http status: %d", status));
+  }
+  return common::Error();
+}
+
+}  // namespace
+
+namespace iptv_cloud {
+namespace server {
+
+LogUploader::LogUploader(size_t workers_count, size_t queue_size)
+    : workers_count_(workers_count ? workers_count : 1),
+      queue_size_(queue_size ? queue_size : 1),
+      workers_(),
+      jobs_mutex_(),
+      jobs_cond_(),
+      jobs_(),
+      stop_(false),
+      cancel_fd_(INVALID_DESCRIPTOR) {}
+
+LogUploader::~LogUploader() {
+  Stop();
+}
+
+void LogUploader::Start() {
+  std::unique_lock<std::mutex> lock(jobs_mutex_);
+  if (!workers_.empty()) {
+    return;
+  }
+
+  stop_ = false;
+  cancel_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (cancel_fd_ == INVALID_DESCRIPTOR) {
+    DEBUG_MSG_ERROR(common::make_errno_error(errno), common::logging::LOG_LEVEL_WARNING);
+  }
+  for (size_t i = 0; i < workers_count_; ++i) {
+    workers_.push_back(std::thread([this] { Run(); }));
+  }
+}
+
+void LogUploader::Stop() {
+  std::vector<std::thread> workers;
+  std::deque<Job> canceled;
+  {
+    std::unique_lock<std::mutex> lock(jobs_mutex_);
+    stop_ = true;
+    workers.swap(workers_);
+    canceled.swap(jobs_);
+  }
+  jobs_cond_.notify_all();
+
+  // never read, stays readable and aborts every running upload
+  const eventfd_t cancel = 1;
+  if (cancel_fd_ != INVALID_DESCRIPTOR && write(cancel_fd_, &cancel, sizeof(cancel)) == ERROR_RESULT_VALUE) {
+    DEBUG_MSG_ERROR(common::make_errno_error(errno), common::logging::LOG_LEVEL_WARNING);
+  }
+
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+  CloseDescriptor(&cancel_fd_);
+
+  for (const Job& job : canceled) {
+    if (job.done) {
+      job.done(common::make_error("Upload canceled"));
+    }
+  }
+}
+
+common::ErrnoError LogUploader::Post(const file_path_t& file,
+                                     const common::net::HostAndPort& server,
+                                     const std::string& path,
+                                     size_t tail_size,
+                                     done_callback_t done) {
+  {
+    std::unique_lock<std::mutex> lock(jobs_mutex_);
+    if (stop_ || workers_.empty()) {
+      return common::make_errno_error("Upload workers not started", EINVAL);
+    }
+
+    if (jobs_.size() >= queue_size_) {
+      return common::make_errno_error("Upload queue is full", EAGAIN);
+    }
+
+    Job job = {file, server, path, tail_size, done};
+    jobs_.push_back(job);
+  }
+  jobs_cond_.notify_one();
+  return common::ErrnoError();
+}
+
+size_t LogUploader::GetPendingCount() const {
+  std::unique_lock<std::mutex> lock(jobs_mutex_);
+  return jobs_.size();
+}
+
+void LogUploader::Run() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> lock(jobs_mutex_);
+      jobs_cond_.wait(lock, [this] { return stop_ || !jobs_.empty(); });
+      if (stop_) {
+        return;
+      }
+      job = jobs_.front();
+      jobs_.pop_front();
+    }
+
+    common::Error err = UploadFile(job.file, job.server, job.path, job.tail_size, cancel_fd_);
+    if (job.done) {
+      job.done(err);
+    }
+  }
+}
+
+common::Error LogUploader::UploadFile(const file_path_t& file,
+                                      const common::net::HostAndPort& server,
+                                      const std::string& path,
+                                      size_t tail_size,
+                                      int cancel_fd) {
+  const std::string file_path_str = file.GetPath();
+  int fd = open(file_path_str.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_error_from_errno(common::make_errno_error(errno));
+  }
+
+  struct stat sb;
+  if (fstat(fd, &sb) == ERROR_RESULT_VALUE) {
+    common::ErrnoError errn = common::make_errno_error(errno);
+    CloseDescriptor(&fd);
+    return common::make_error_from_errno(errn);
+  }
+
+  if (tail_size && static_cast<size_t>(sb.st_size) > tail_size) {
+    lseek(fd, sb.st_size - tail_size, SEEK_SET);
+  }
+
+  int sock = INVALID_DESCRIPTOR;
+  common::ErrnoError errn = ConnectToServer(server, cancel_fd, &sock);
+  if (errn) {
+    CloseDescriptor(&fd);
+    return common::make_error_from_errno(errn);
+  }
+
+  const std::string headers = common::MemSPrintf(
+      "POST %s HTTP/1.1\r\n"
+      "Host: %s\r\n"
+      "Content-Type: text/plain\r\n"
+      "Content-Encoding: gzip\r\n"
+      "Transfer-Encoding: chunked\r\n"
+      "Connection: close\r\n\r\n",
+      path.empty() ? "/" : path, common::ConvertToString(server));
+  errn = WriteAll(sock, cancel_fd, headers.data(), headers.size());
+  if (errn) {
+    CloseDescriptor(&sock);
+    CloseDescriptor(&fd);
+    return common::make_error_from_errno(errn);
+  }
+
+  common::Error err = StreamBody(sock, cancel_fd, fd);
+  CloseDescriptor(&fd);
+  if (err) {
+    CloseDescriptor(&sock);
+    return err;
+  }
+
+  err = ReadStatus(sock, cancel_fd);
+  CloseDescriptor(&sock);
+  return err;
+}
+
+}  // namespace server
+}  // namespace iptv_cloud
@@ -0,0 +1,86 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <common/error.h>
+#include <common/file_system/path.h>
+#include <common/net/types.h>
+
+namespace iptv_cloud {
+namespace server {
+
+// posts log/pipeline files to http collectors outside of main loop,
+// bounded queue served by fixed workers, body streamed gzip compressed with chunked encoding.
+class LogUploader {
+ public:
+  enum { DEFAULT_WORKERS_COUNT = 2, DEFAULT_QUEUE_SIZE = 16, chunk_size = 64 * 1024, io_timeout_sec = 30 };
+  typedef common::file_system::ascii_file_string_path file_path_t;
+  typedef std::function<void(common::Error err)> done_callback_t;  // called from worker thread
+
+  LogUploader(size_t workers_count, size_t queue_size);
+  ~LogUploader();
+
+  void Start();
+  void Stop();
+
+  // tail_size 0 means whole file, EAGAIN when queue is full
+  common::ErrnoError Post(const file_path_t& file,
+                          const common::net::HostAndPort& server,
+                          const std::string& path,
+                          size_t tail_size,
+                          done_callback_t done) WARN_UNUSED_RESULT;
+  size_t GetPendingCount() const;
+
+  // readable cancel_fd aborts upload with ECANCELED, Stop uses it to not wait io timeouts
+  static common::Error UploadFile(const file_path_t& file,
+                                  const common::net::HostAndPort& server,
+                                  const std::string& path,
+                                  size_t tail_size,
+                                  int cancel_fd = INVALID_DESCRIPTOR) WARN_UNUSED_RESULT;
+
+ private:
+  struct Job {
+    file_path_t file;
+    common::net::HostAndPort server;
+    std::string path;
+    size_t tail_size;
+    done_callback_t done;
+  };
+
+  void Run();
+
+  const size_t workers_count_;
+  const size_t queue_size_;
+  std::vector<std::thread> workers_;
+
+  mutable std::mutex jobs_mutex_;
+  std::condition_variable jobs_cond_;
+  std::deque<Job> jobs_;
+  bool stop_;
+  int cancel_fd_;  // eventfd signaled by Stop
+
+  DISALLOW_COPY_AND_ASSIGN(LogUploader);
+};
+
+}  // namespace server
+}  // namespace iptv_cloud
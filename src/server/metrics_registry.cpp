@@ -0,0 +1,269 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/metrics_registry.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace iptv_cloud {
+namespace server {
+
+namespace {
+
+void CopyChannels(const std::vector<ChannelStats>& from, std::vector<ChannelMetrics>* to) {
+  to->resize(from.size());
+  for (size_t i = 0; i < from.size(); ++i) {
+    ChannelMetrics* chan = &(*to)[i];
+    chan->id = from[i].GetID();
+    chan->total_bytes = from[i].GetTotalBytes();
+    chan->bps = from[i].GetBps();
+  }
+}
+
+}  // namespace
+
+MetricsSnapshot::MetricsSnapshot() : timestamp(0), online(), streams() {}
+
+MetricsRegistry::MetricsRegistry()
+    : streams_(), online_(), back_(0), buffers_(), middle_(1), front_(2), text_(DEFAULT_TEXT_CAPACITY), pos_(nullptr) {
+  for (size_t i = 0; i < SIZEOFMASS(buffers_); ++i) {
+    buffers_[i].streams.reserve(DEFAULT_STREAMS_CAPACITY);
+  }
+}
+
+void MetricsRegistry::UpdateStream(const StreamStruct& stream, double cpu_load, uint64_t rss_bytes) {
+  StreamMetrics* metrics = &streams_[stream.id];
+  metrics->id = stream.id;
+  metrics->type = stream.type;
+  metrics->status = stream.status;
+  metrics->restarts = stream.restarts;
+  metrics->cpu_load = cpu_load;
+  metrics->rss_bytes = rss_bytes;
+  CopyChannels(stream.input, &metrics->input);
+  CopyChannels(stream.output, &metrics->output);
+}
+
+void MetricsRegistry::RemoveStream(const stream_id_t& sid) {
+  streams_.erase(sid);
+}
+
+void MetricsRegistry::SetOnline(const OnlineMetrics& online) {
+  online_ = online;
+}
+
+void MetricsRegistry::Publish(fastotv::timestamp_t now) {
+  MetricsSnapshot* snap = &buffers_[back_];
+  snap->timestamp = now;
+  snap->online = online_;
+  snap->streams.resize(streams_.size());  // assignments below reuse capacity of previous snapshots
+  size_t i = 0;
+  for (const auto& stream : streams_) {
+    snap->streams[i++] = stream.second;
+  }
+  back_ = middle_.exchange(back_ | FRESH_BIT, std::memory_order_acq_rel) & INDEX_MASK;
+}
+
+const char* MetricsRegistry::Render(size_t* size) {
+  if (middle_.load(std::memory_order_acquire) & FRESH_BIT) {
+    front_ = middle_.exchange(front_, std::memory_order_acq_rel) & INDEX_MASK;
+  }
+
+  const MetricsSnapshot& snap = buffers_[front_];
+  const size_t bound = GetTextBound(snap);
+  if (text_.size() < bound) {
+    text_.resize(bound * 2);
+  }
+
+  pos_ = text_.data();
+  RenderSnapshot(snap);
+  *size = pos_ - text_.data();
+  return text_.data();
+}
+
+const char* MetricsRegistry::GetContentType() {
+  return "text/plain; version=0.0.4";
+}
+
+size_t MetricsRegistry::GetTextBound(const MetricsSnapshot& snap) {
+  // longest metric name with label syntax, channel label and 20 digits value
+  static const size_t line_bound = 128;
+  size_t bound = 4096;  // help/type lines and node metrics
+  for (const StreamMetrics& stream : snap.streams) {
+    const size_t lines = 4 + 2 * (stream.input.size() + stream.output.size());
+    bound += lines * (line_bound + stream.id.size() * 2);
+  }
+  return bound;
+}
+
+void MetricsRegistry::RenderSnapshot(const MetricsSnapshot& snap) {
+  static const struct {
+    const char* label;
+    size_t OnlineMetrics::*count;
+  } online_servers[] = {{"iptv_online_clients{server=\"daemon\"} ", &OnlineMetrics::daemon},
+                        {"iptv_online_clients{server=\"http\"} ", &OnlineMetrics::http},
+                        {"iptv_online_clients{server=\"vods\"} ", &OnlineMetrics::vods},
+                        {"iptv_online_clients{server=\"subscribers\"} ", &OnlineMetrics::subscribers}};
+
+  WriteHeader("iptv_online_clients", "Connected clients per daemon server.", "gauge");
+  for (size_t i = 0; i < SIZEOFMASS(online_servers); ++i) {
+    Write(online_servers[i].label, strlen(online_servers[i].label));
+    WriteUInt(snap.online.*online_servers[i].count);
+    Write("\n");
+  }
+
+  WriteHeader("iptv_streams", "Streams reporting statistic.", "gauge");
+  Write("iptv_streams ");
+  WriteUInt(snap.streams.size());
+  Write("\n");
+
+  WriteHeader("iptv_metrics_timestamp_seconds", "Time of the rendered snapshot.", "gauge");
+  Write("iptv_metrics_timestamp_seconds ");
+  WriteUInt(snap.timestamp / 1000);
+  Write("\n");
+
+  WriteHeader("iptv_stream_status", "Stream status: 0 new, 1 init, 2 started, 3 ready, 4 playing, 5 frozen, 6 waiting.",
+              "gauge");
+  for (const StreamMetrics& stream : snap.streams) {
+    Write("iptv_stream_status");
+    WriteStreamLabel(stream);
+    Write("} ");
+    WriteUInt(stream.status);
+    Write("\n");
+  }
+
+  WriteHeader("iptv_stream_restarts_total", "Stream pipeline restarts.", "counter");
+  for (const StreamMetrics& stream : snap.streams) {
+    Write("iptv_stream_restarts_total");
+    WriteStreamLabel(stream);
+    Write("} ");
+    WriteUInt(stream.restarts);
+    Write("\n");
+  }
+
+  WriteHeader("iptv_stream_cpu_load", "Stream process cpu load.", "gauge");
+  for (const StreamMetrics& stream : snap.streams) {
+    Write("iptv_stream_cpu_load");
+    WriteStreamLabel(stream);
+    Write("} ");
+    WriteDouble(stream.cpu_load);
+    Write("\n");
+  }
+
+  WriteHeader("iptv_stream_rss_bytes", "Stream process resident memory.", "gauge");
+  for (const StreamMetrics& stream : snap.streams) {
+    Write("iptv_stream_rss_bytes");
+    WriteStreamLabel(stream);
+    Write("} ");
+    WriteUInt(stream.rss_bytes);
+    Write("\n");
+  }
+
+  RenderChannels(snap, "iptv_stream_input_bytes_total", true, true);
+  RenderChannels(snap, "iptv_stream_input_bytes_per_second", true, false);
+  RenderChannels(snap, "iptv_stream_output_bytes_total", false, true);
+  RenderChannels(snap, "iptv_stream_output_bytes_per_second", false, false);
+}
+
+void MetricsRegistry::RenderChannels(const MetricsSnapshot& snap, const char* name, bool input, bool bytes) {
+  if (bytes) {
+    WriteHeader(name, input ? "Bytes received by stream input." : "Bytes sent by stream output.", "counter");
+  } else {
+    WriteHeader(name, input ? "Stream input bitrate." : "Stream output bitrate.", "gauge");
+  }
+
+  const size_t name_len = strlen(name);
+  for (const StreamMetrics& stream : snap.streams) {
+    const std::vector<ChannelMetrics>& channels = input ? stream.input : stream.output;
+    for (const ChannelMetrics& chan : channels) {
+      Write(name, name_len);
+      WriteStreamLabel(stream);
+      Write(",channel=\"");
+      WriteUInt(chan.id);
+      Write("\"} ");
+      WriteUInt(bytes ? chan.total_bytes : chan.bps);
+      Write("\n");
+    }
+  }
+}
+
+void MetricsRegistry::Write(const char* data, size_t size) {
+  memcpy(pos_, data, size);
+  pos_ += size;
+}
+
+void MetricsRegistry::WriteHeader(const char* name, const char* help, const char* type) {
+  const size_t name_len = strlen(name);
+  Write("# HELP ");
+  Write(name, name_len);
+  Write(" ");
+  Write(help, strlen(help));
+  Write("\n# TYPE ");
+  Write(name, name_len);
+  Write(" ");
+  Write(type, strlen(type));
+  Write("\n");
+}
+
+void MetricsRegistry::WriteStreamLabel(const StreamMetrics& stream) {
+  Write("{stream=\"");
+  if (stream.id.find_first_of("\\\"\n") == std::string::npos) {
+    Write(stream.id.data(), stream.id.size());
+  } else {
+    for (char c : stream.id) {
+      if (c == '\\' || c == '"') {
+        *pos_++ = '\\';
+        *pos_++ = c;
+      } else if (c == '\n') {
+        Write("\\n");
+      } else {
+        *pos_++ = c;
+      }
+    }
+  }
+  Write("\"");
+}
+
+void MetricsRegistry::WriteUInt(uint64_t value) {
+  char buff[24];
+  char* end = buff + sizeof(buff);
+  char* pos = end;
+  do {
+    *--pos = static_cast<char>('0' + value % 10);
+    value /= 10;
+  } while (value);
+  Write(pos, end - pos);
+}
+
+void MetricsRegistry::WriteDouble(double value) {
+  if (isnan(value) || isinf(value)) {
+    Write("NaN");
+    return;
+  }
+
+  if (value < 0) {
+    Write("-");
+    value = -value;
+  }
+  // fixed 3 digits after point, snprintf costs more than the whole stream line
+  const uint64_t millis = static_cast<uint64_t>(value * 1000 + 0.5);
+  WriteUInt(millis / 1000);
+  const uint64_t frac = millis % 1000;
+  const char digits[4] = {'.', static_cast<char>('0' + frac / 100), static_cast<char>('0' + frac / 10 % 10),
+                          static_cast<char>('0' + frac % 10)};
+  Write(digits, sizeof(digits));
+}
+
+}  // namespace server
+}  // namespace iptv_cloud
@@ -0,0 +1,116 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <common/macros.h>
+
+#include "base/stream_struct.h"
+
+namespace iptv_cloud {
+namespace server {
+
+struct ChannelMetrics {
+  channel_id_t id;
+  uint64_t total_bytes;
+  uint64_t bps;
+};
+
+struct StreamMetrics {
+  stream_id_t id;
+  StreamType type;
+  StreamStatus status;
+  uint64_t restarts;
+  double cpu_load;
+  uint64_t rss_bytes;
+  std::vector<ChannelMetrics> input;
+  std::vector<ChannelMetrics> output;
+};
+
+struct OnlineMetrics {
+  size_t daemon;
+  size_t http;
+  size_t vods;
+  size_t subscribers;
+};
+
+struct MetricsSnapshot {
+  MetricsSnapshot();
+
+  fastotv::timestamp_t timestamp;
+  OnlineMetrics online;
+  std::vector<StreamMetrics> streams;
+};
+
+// prometheus /metrics for the daemon http server:
+// loop thread collects stream statistics and publishes snapshots,
+// http thread renders the latest one, sides never lock, they swap buffers of a triple buffer.
+class MetricsRegistry {
+ public:
+  enum : size_t { DEFAULT_STREAMS_CAPACITY = 512, DEFAULT_TEXT_CAPACITY = 512 * 1024 };
+
+  MetricsRegistry();
+
+  // loop thread
+  void UpdateStream(const StreamStruct& stream, double cpu_load, uint64_t rss_bytes);
+  void RemoveStream(const stream_id_t& sid);
+  void SetOnline(const OnlineMetrics& online);
+  void Publish(fastotv::timestamp_t now);
+
+  // http thread, text is valid until next call
+  const char* Render(size_t* size);
+
+  static const char* GetContentType();
+
+ private:
+  enum : uint8_t { INDEX_MASK = 0x3, FRESH_BIT = 0x4 };
+
+  static size_t GetTextBound(const MetricsSnapshot& snap);
+  void RenderSnapshot(const MetricsSnapshot& snap);
+  void RenderChannels(const MetricsSnapshot& snap, const char* name, bool input, bool bytes);
+
+  // writers don't check space, text_ is sized by GetTextBound before rendering
+  void Write(const char* data, size_t size);
+  template <size_t N>
+  void Write(const char (&str)[N]) {
+    Write(str, N - 1);
+  }
+  void WriteHeader(const char* name, const char* help, const char* type);
+  void WriteStreamLabel(const StreamMetrics& stream);
+  void WriteUInt(uint64_t value);
+  void WriteDouble(double value);
+
+  // loop thread state
+  std::map<stream_id_t, StreamMetrics> streams_;
+  OnlineMetrics online_;
+  uint8_t back_;
+
+  MetricsSnapshot buffers_[3];
+  std::atomic<uint8_t> middle_;
+
+  // http thread state
+  uint8_t front_;
+  std::vector<char> text_;
+  char* pos_;
+
+  DISALLOW_COPY_AND_ASSIGN(MetricsRegistry);
+};
+
+}  // namespace server
+}  // namespace iptv_cloud
@@ -14,6 +14,8 @@
 
 #include "server/options/options.h"
 
+#include <string.h>
+
 #include <limits>
 #include <string>
 #include <utility>
@@ -376,6 +378,31 @@ bool FindCmdOption(const std::string& key, option_t* opt) {
   return false;
 }
 
+namespace {
+
+bool ValidateOption(const char* key, const std::string& value_str, option_t* option) {
+  if (!FindOption(key, option)) {
+    WARNING_LOG() << "Unknown option: " << key;
+    return false;
+  }
+
+  switch (option->second(value_str)) {
+    case Validity::VALID:
+      return true;
+    case Validity::INVALID:
+      WARNING_LOG() << "Invalid value \"" << value_str << "\" of option " << key;
+      return false;
+    case Validity::FATAL:
+      CRITICAL_LOG() << "Invalid value \"" << value_str << "\" of option " << key;
+      return false;
+    default:
+      NOTREACHED();
+      return false;
+  }
+}
+
+}  // namespace
+
 utils::ArgsMap ValidateConfig(const std::string& full_config) {
   if (full_config.empty()) {
     CRITICAL_LOG() << "Invalid config data!";
@@ -389,24 +416,9 @@ utils::ArgsMap ValidateConfig(const std::string& full_config) {
   utils::ArgsMap options;
   json_object_object_foreach(obj, key, val) {
     option_t option;
-    if (!FindOption(key, &option)) {
-      WARNING_LOG() << "Unknown option: " << key;
-    } else {
-      const std::string value_str = val ? json_object_get_string(val) : "null";
-      switch (option.second(value_str)) {
-        case Validity::VALID:
-          options[key] = value_str;
-          break;
-        case Validity::INVALID:
-          WARNING_LOG() << "Invalid value \"" << value_str << "\" of option " << key;
-          break;
-        case Validity::FATAL:
-          CRITICAL_LOG() << "Invalid value \"" << value_str << "\" of option " << key;
-          break;
-        default:
-          NOTREACHED();
-          break;
-      }
+    const std::string value_str = val ? json_object_get_string(val) : "null";
+    if (ValidateOption(key, value_str, &option)) {
+      options[key] = value_str;
     }
   }
 
@@ -414,6 +426,79 @@ utils::ArgsMap ValidateConfig(const std::string& full_config) {
   return options;
 }
 
+common::Error ParseStreamConfig(const std::string& full_config, StreamConfig* config) {
+  if (full_config.empty() || !config) {
+    return common::make_error_inval();
+  }
+
+  json_object* obj = json_tokener_parse(full_config.c_str());
+  if (!obj) {
+    return common::make_error("Invalid config data!");
+  }
+
+  StreamConfig lconfig;
+  bool have_type = false;
+  bool have_input = false;
+  bool have_output = false;
+  json_object_object_foreach(obj, key, val) {
+    if (strcmp(key, INPUT_FIELD) == 0) {
+      if (!read_input(val, &lconfig.input)) {
+        json_object_put(obj);
+        return common::make_error("Define " INPUT_FIELD " variable and make it valid.");
+      }
+      have_input = true;
+      continue;
+    } else if (strcmp(key, OUTPUT_FIELD) == 0) {
+      if (!read_output(val, &lconfig.output)) {
+        WARNING_LOG() << "Invalid value of option " << key;
+        continue;
+      }
+      have_output = true;
+      continue;
+    }
+
+    option_t option;
+    const std::string value_str = val ? json_object_get_string(val) : "null";
+    if (!ValidateOption(key, value_str, &option)) {
+      continue;
+    }
+
+    if (strcmp(key, ID_FIELD) == 0) {
+      lconfig.id = value_str;
+    } else if (strcmp(key, TYPE_FIELD) == 0) {
+      lconfig.type = static_cast<StreamType>(json_object_get_int(val));
+      have_type = true;
+    } else if (strcmp(key, FEEDBACK_DIR_FIELD) == 0) {
+      lconfig.feedback_dir = value_str;
+    } else if (strcmp(key, LOG_LEVEL_FIELD) == 0) {
+      lconfig.log_level = json_object_get_int(val);
+    } else {
+      lconfig.args[key] = value_str;
+    }
+  }
+  json_object_put(obj);
+
+  if (lconfig.id.empty()) {
+    return common::make_error("Define " ID_FIELD " variable and make it valid.");
+  }
+
+  if (!have_type) {
+    return common::make_error("Define " TYPE_FIELD " variable and make it valid.");
+  }
+
+  if (!have_input) {
+    return common::make_error("Define " INPUT_FIELD " variable and make it valid.");
+  }
+
+  bool is_timeshift_rec_or_catchup = lconfig.type == TIMESHIFT_RECORDER || lconfig.type == CATCHUP;  // no outputs
+  if (!is_timeshift_rec_or_catchup && !have_output) {
+    return common::make_error("Define " OUTPUT_FIELD " variable and make it valid.");
+  }
+
+  *config = lconfig;
+  return common::Error();
+}
+
 bool FindOption(const std::string& key, option_t* opt) {
   if (!opt) {
     return false;
@@ -444,6 +529,9 @@ bool FindOption(const std::string& key, option_t* opt) {
                                                   {DEINTERLACE_FIELD, dont_validate},
                                                   {RELAY_AUDIO_FIELD, dont_validate},
                                                   {RELAY_VIDEO_FIELD, dont_validate},
+                                                  {NATIVE_RELAY_FIELD, dont_validate},
+                                                  {ANALYZE_TS_FIELD, dont_validate},
+                                                  {PUBLISH_INPUT_FIELD, dont_validate},
                                                   {LOOP_FIELD, dont_validate},
                                                   {AVFORMAT_FIELD, dont_validate},
                                                   {SIZE_FIELD, validate_size},
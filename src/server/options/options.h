@@ -17,6 +17,10 @@
 #include <string>
 #include <utility>
 
+#include <common/error.h>
+
+#include "base/stream_config.h"
+
 #include "utils/arg_reader.h"
 
 namespace iptv_cloud {
@@ -30,6 +34,8 @@ typedef Validity (*validate_callback_t)(const std::string&);
 typedef std::pair<std::string, validate_callback_t> option_t;
 
 utils::ArgsMap ValidateConfig(const std::string& config);
+// single pass json -> StreamConfig, input/output deserialized without string round-trip
+common::Error ParseStreamConfig(const std::string& config, StreamConfig* out) WARN_UNUSED_RESULT;
 
 bool FindOption(const std::string& key, option_t* opt);
 
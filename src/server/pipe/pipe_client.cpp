@@ -14,6 +14,8 @@
 
 #include "server/pipe/pipe_client.h"
 
+#include <poll.h>
+
 namespace iptv_cloud {
 namespace server {
 namespace pipe {
@@ -36,6 +38,11 @@ descriptor_t ProtocoledPipeClient::GetFd() const {
   return read_fd_;
 }
 
+bool ProtocoledPipeClient::IsReadReady() const {
+  struct pollfd pfd = {read_fd_, POLLIN, 0};
+  return poll(&pfd, 1, 0) > 0;
+}
+
 common::ErrnoError ProtocoledPipeClient::DoClose() {
   common::ErrnoError err = pipe_write_client_->Close();
   err = pipe_read_client_->Close();
@@ -31,6 +31,9 @@ class ProtocoledPipeClient : public protocol::ProtocolClient<common::libev::IoCl
 
   ProtocoledPipeClient(common::libev::IoLoop* server, descriptor_t read_fd, descriptor_t write_fd);
 
+  // data or end of pipe can be read without blocking
+  bool IsReadReady() const;
+
  protected:
   common::ErrnoError SingleWrite(const void* data, size_t size, size_t* nwrite_out) override;
   common::ErrnoError SingleRead(void* out, size_t max_size, size_t* nread) override;
@@ -18,7 +18,10 @@
 #include <sys/wait.h>
 
 #include <dlfcn.h>
+#include <signal.h>
+#include <unistd.h>
 
+#include <limits>
 #include <string>
 #include <thread>
 #include <utility>
@@ -26,7 +29,6 @@
 
 #include <common/file_system/file_system.h>
 #include <common/file_system/string_path_utils.h>
-#include <common/net/http_client.h>
 #include <common/net/net.h>
 #include <common/string_util.h>
 #include <common/system_info/system_info.h>
@@ -42,6 +44,8 @@
 #include "pipe/pipe_client.h"
 
 #include "server/child_stream.h"
+#include "server/child_table.h"
+#include "server/cpu_placement.h"
 #include "server/daemon/client.h"
 #include "server/daemon/commands.h"
 #include "server/daemon/commands_info/service/activate_info.h"
@@ -50,31 +54,50 @@
 #include "server/daemon/commands_info/service/prepare_info.h"
 #include "server/daemon/commands_info/service/server_info.h"
 #include "server/daemon/commands_info/service/stop_info.h"
+#include "server/daemon/commands_info/service/sync_delta_info.h"
 #include "server/daemon/commands_info/service/sync_info.h"
+#include "server/daemon/commands_info/stream/get_history_info.h"
 #include "server/daemon/commands_info/stream/get_log_info.h"
+#include "server/daemon/commands_info/stream/history_info.h"
 #include "server/daemon/commands_info/stream/quit_status_info.h"
+#include "server/daemon/commands_info/stream/reconfigure_info.h"
 #include "server/daemon/commands_info/stream/restart_info.h"
 #include "server/daemon/commands_info/stream/start_info.h"
 #include "server/daemon/commands_info/stream/stop_info.h"
+#include "server/daemon/commands_info/stream/stream_info.h"
 #include "server/daemon/server.h"
 #include "server/http/handler.h"
 #include "server/http/server.h"
+#include "server/log_uploader.h"
 #include "server/options/options.h"
+#include "server/relay/relay_engine.h"
+#include "server/input_broker.h"
+#include "server/metrics_registry.h"
+#include "server/restart_scheduler.h"
+#include "server/stream_history.h"
 #include "server/stream_struct_utils.h"
 #include "server/subscribers/handler.h"
 #include "server/subscribers/server.h"
 #include "server/sync_finder.h"
 #include "server/vods/handler.h"
 #include "server/vods/server.h"
+#include "server/vods/vods_cache.h"
 
 #include "stream_commands_info/changed_sources_info.h"
+#include "stream_commands_info/reconfigure_info.h"
+#include "stream_commands_info/restart_schedule_info.h"
 #include "stream_commands_info/statistic_info.h"
 
 #include "gpu_stats/perf_monitor.h"
 
+#include "utils/adopt_socket.h"
 #include "utils/arg_converter.h"
 #include "utils/utils.h"
 
+#define CHILD_TABLE_PATH RUN_DIR_PATH "/" STREAMER_SERVICE_NAME "_childs.json"
+#define ADOPT_SOCKET_PATH RUN_DIR_PATH "/" STREAMER_SERVICE_NAME "_adopt.sock"
+#define INPUT_SOCKETS_PREFIX RUN_DIR_PATH "/" STREAMER_SERVICE_NAME "_input_"
+
 namespace {
 
 bool GetHttpHostAndPort(const std::string& host, common::net::HostAndPort* out) {
@@ -118,41 +141,6 @@ common::Optional<common::file_system::ascii_file_string_path> MakeStreamPipeline
   return dir.MakeFileStringPath(DUMP_FILE_NAME);
 }
 
-common::Error PostHttpFile(const common::file_system::ascii_file_string_path& file_path, const common::uri::Url& url) {
-  common::net::HostAndPort http_server_address;
-  if (!GetPostServerFromUrl(url, &http_server_address)) {
-    return common::make_error_inval();
-  }
-
-  common::net::HttpClient cl(http_server_address);
-  common::ErrnoError errn = cl.Connect();
-  if (errn) {
-    return common::make_error_from_errno(errn);
-  }
-
-  const auto path = url.GetPath();
-  common::Error err = cl.PostFile(path, file_path);
-  if (err) {
-    cl.Disconnect();
-    return err;
-  }
-
-  common::http::HttpResponse lresp;
-  err = cl.ReadResponse(&lresp);
-  if (err) {
-    cl.Disconnect();
-    return err;
-  }
-
-  if (lresp.IsEmptyBody()) {
-    cl.Disconnect();
-    return common::make_error("Empty body");
-  }
-
-  cl.Disconnect();
-  return common::Error();
-}
-
 common::ErrnoError CreatePipe(int* read_client_fd, int* write_client_fd) {
   if (!read_client_fd || !write_client_fd) {
     return common::make_errno_error_inval();
@@ -174,56 +162,31 @@ common::ErrnoError CreatePipe(int* read_client_fd, int* write_client_fd) {
 namespace iptv_cloud {
 namespace {
 
-common::ErrnoError MakeStreamInfo(const utils::ArgsMap& config_args,
-                                  StreamInfo* sha,
-                                  std::string* feedback_dir,
-                                  common::logging::LOG_LEVEL* logs_level) {
-  if (!sha || !feedback_dir || !logs_level) {
+common::ErrnoError MakeStreamInfo(const StreamConfig& config, StreamInfo* sha) {
+  if (!sha) {
     return common::make_errno_error_inval();
   }
 
-  StreamInfo lsha;
-  if (!utils::ArgsGetValue(config_args, ID_FIELD, &lsha.id)) {
-    return common::make_errno_error("Define " ID_FIELD " variable and make it valid.", EAGAIN);
-  }
-
-  uint8_t type;
-  if (!utils::ArgsGetValue(config_args, TYPE_FIELD, &type)) {
-    return common::make_errno_error("Define " TYPE_FIELD " variable and make it valid.", EAGAIN);
-  }
-  lsha.type = static_cast<StreamType>(type);
-  if (lsha.type == PROXY) {
-    return common::make_errno_error("Proxy streams not handled for now", EINVAL);
-  }
-
-  std::string lfeedback_dir;
-  if (!utils::ArgsGetValue(config_args, FEEDBACK_DIR_FIELD, &lfeedback_dir)) {
+  if (config.feedback_dir.empty()) {
     return common::make_errno_error("Define " FEEDBACK_DIR_FIELD " variable and make it valid.", EAGAIN);
   }
 
-  int llogs_level;
-  if (!utils::ArgsGetValue(config_args, LOG_LEVEL_FIELD, &llogs_level)) {
-    llogs_level = common::logging::LOG_LEVEL_DEBUG;
-  }
-
-  common::ErrnoError errn = utils::CreateAndCheckDir(lfeedback_dir);
+  common::ErrnoError errn = utils::CreateAndCheckDir(config.feedback_dir);
   if (errn) {
     return errn;
   }
 
-  input_t input;
-  if (!read_input(config_args, &input)) {
-    return common::make_errno_error("Define " INPUT_FIELD " variable and make it valid.", EAGAIN);
-  }
-
-  for (auto input_uri : input) {
+  StreamInfo lsha;
+  lsha.id = config.id;
+  lsha.type = config.type;
+  for (auto input_uri : config.input) {
     lsha.input.push_back(input_uri.GetID());
   }
 
-  bool is_timeshift_rec_or_catchup = type == TIMESHIFT_RECORDER || type == CATCHUP;  // no outputs
+  bool is_timeshift_rec_or_catchup = config.type == TIMESHIFT_RECORDER || config.type == CATCHUP;  // no outputs
   if (is_timeshift_rec_or_catchup) {
     std::string timeshift_dir;
-    if (!utils::ArgsGetValue(config_args, TIMESHIFT_DIR_FIELD, &timeshift_dir)) {
+    if (!utils::ArgsGetValue(config.args, TIMESHIFT_DIR_FIELD, &timeshift_dir)) {
       return common::make_errno_error("Define " TIMESHIFT_DIR_FIELD " variable and make it valid.", EAGAIN);
     }
 
@@ -232,14 +195,14 @@ common::ErrnoError MakeStreamInfo(const utils::ArgsMap& config_args,
       return errn;
     }
   } else {
-    output_t output;
-    if (!read_output(config_args, &output)) {
+    if (config.output.empty()) {
       return common::make_errno_error("Define " OUTPUT_FIELD " variable and make it valid.", EAGAIN);
     }
 
-    for (auto out_uri : output) {
+    for (auto out_uri : config.output) {
       common::uri::Url ouri = out_uri.GetOutput();
-      if (ouri.GetScheme() == common::uri::Url::http) {
+      // memory outputs are served from shared memory, http_root only names them
+      if (ouri.GetScheme() == common::uri::Url::http && out_uri.GetHlsType() != OutputUri::HLS_MEMORY) {
         const common::file_system::ascii_directory_string_path http_root = out_uri.GetHttpRoot();
         const std::string http_root_str = http_root.GetPath();
         common::ErrnoError errn = utils::CreateAndCheckDir(http_root_str);
@@ -251,11 +214,22 @@ common::ErrnoError MakeStreamInfo(const utils::ArgsMap& config_args,
     }
   }
 
-  *logs_level = static_cast<common::logging::LOG_LEVEL>(llogs_level);
-  *feedback_dir = lfeedback_dir;
   *sha = lsha;
   return common::ErrnoError();
 }
+
+bool IsNativeRelayStream(const StreamConfig& config) {
+  if (config.type == RELAY) {
+    bool native = false;
+    if (!utils::ArgsGetValue(config.args, NATIVE_RELAY_FIELD, &native) || !native) {
+      return false;
+    }
+  } else if (config.type != PROXY) {
+    return false;
+  }
+
+  return server::relay::RelayEngine::IsSupported(config.input, config.output);
+}
 }  // namespace
 namespace server {
 namespace {
@@ -308,13 +282,34 @@ ProcessSlaveWrapper::ProcessSlaveWrapper(const std::string& license_key, const C
       node_stats_timer_(INVALID_TIMER_ID),
       cleanup_files_timer_(INVALID_TIMER_ID),
       quit_cleanup_timer_(INVALID_TIMER_ID),
+      restart_schedule_timer_(INVALID_TIMER_ID),
+      metrics_timer_(INVALID_TIMER_ID),
+      adopt_timer_(INVALID_TIMER_ID),
       node_stats_(new NodeStats),
       stream_exec_func_(nullptr),
-      vods_links_() {
+      vods_cache_(nullptr),
+      finder_(nullptr),
+      sync_version_(0),
+      relay_engine_(nullptr),
+      restart_scheduler_(nullptr),
+      log_uploader_(nullptr),
+      metrics_(nullptr),
+      history_(nullptr),
+      input_broker_(nullptr),
+      cpu_placement_(nullptr),
+      child_table_(nullptr),
+      adopt_listener_(nullptr),
+      adopt_deadline_(0),
+      adopt_promotions_(),
+      profile_requests_(),
+      upload_requests_(),
+      next_upload_id_(0) {
   loop_ = new DaemonServer(config.host, this);
   loop_->SetName("client_server");
 
+  metrics_ = new MetricsRegistry;
   http_handler_ = new HttpHandler(this);
+  static_cast<HttpHandler*>(http_handler_)->SetMetrics(metrics_);
   http_server_ = new HttpServer(config.http_host, http_handler_);
   http_server_->SetName("http_server");
 
@@ -326,6 +321,20 @@ ProcessSlaveWrapper::ProcessSlaveWrapper(const std::string& license_key, const C
   subscribers_handler_ = new subscribers::SubscribersHandler(finder_, config.bandwidth_host);
   subscribers_server_ = new subscribers::SubscribersServer(config.subscribers_host, subscribers_handler_);
   subscribers_server_->SetName("subscribers_server");
+
+  relay_engine_ = new relay::RelayEngine(config.relay_workers);
+  restart_scheduler_ = new RestartScheduler(config.startup_budget);
+  log_uploader_ = new LogUploader(LogUploader::DEFAULT_WORKERS_COUNT, LogUploader::DEFAULT_QUEUE_SIZE);
+  vods_cache_ = new VodsCache;
+  history_ = new HistoryStore(config.history_budget * 1024 * 1024);
+  child_table_ = new ChildTable;
+  adopt_listener_ = new utils::AdoptListener(ADOPT_SOCKET_PATH);
+  if (config.share_inputs) {
+    input_broker_ = new InputBroker(INPUT_SOCKETS_PREFIX);
+  }
+  if (config.cpu_placement) {
+    cpu_placement_ = new CpuPlacement(CpuPlacement::ReadMachineTopology());
+  }
 }
 
 int ProcessSlaveWrapper::SendStopDaemonRequest(const std::string& license) {
@@ -360,6 +369,15 @@ int ProcessSlaveWrapper::SendStopDaemonRequest(const std::string& license) {
 }
 
 ProcessSlaveWrapper::~ProcessSlaveWrapper() {
+  destroy(&adopt_listener_);
+  destroy(&child_table_);
+  destroy(&cpu_placement_);
+  destroy(&input_broker_);
+  destroy(&history_);
+  destroy(&log_uploader_);
+  destroy(&vods_cache_);
+  destroy(&restart_scheduler_);
+  destroy(&relay_engine_);
   destroy(&subscribers_server_);
   destroy(&subscribers_handler_);
   destroy(&finder_);
@@ -367,6 +385,7 @@ ProcessSlaveWrapper::~ProcessSlaveWrapper() {
   destroy(&vods_handler_);
   destroy(&http_server_);
   destroy(&http_handler_);
+  destroy(&metrics_);
   destroy(&loop_);
   destroy(&node_stats_);
 }
@@ -468,12 +487,21 @@ int ProcessSlaveWrapper::Exec(int argc, char** argv) {
     goto finished;
   }
 
+  err = relay_engine_->Start();
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+    goto finished;
+  }
+  log_uploader_->Start();
+
   node_stats_->prev = utils::GetMachineCpuShot();
   node_stats_->prev_nshot = utils::GetMachineNetShot();
   node_stats_->timestamp = common::time::current_utc_mstime();
   res = server->Exec();
 
 finished:
+  log_uploader_->Stop();
+  relay_engine_->Stop();
   subscribers_thread.join();
   vods_thread.join();
   http_thread.join();
@@ -493,6 +521,15 @@ void ProcessSlaveWrapper::PreLooped(common::libev::IoLoop* server) {
   ping_client_timer_ = server->CreateTimer(ping_timeout_clients_seconds, true);
   node_stats_timer_ = server->CreateTimer(node_stats_send_seconds, true);
   cleanup_files_timer_ = server->CreateTimer(config_.ttl_files_, true);
+  restart_schedule_timer_ = server->CreateTimer(restart_schedule_seconds, true);
+  metrics_timer_ = server->CreateTimer(metrics_publish_seconds, true);
+
+  LoadChildTable();
+  common::ErrnoError err = adopt_listener_->Listen();
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+  }
+  adopt_timer_ = server->CreateTimer(adopt_check_seconds, true);
 }
 
 void ProcessSlaveWrapper::Accepted(common::libev::IoClient* client) {
@@ -505,7 +542,21 @@ void ProcessSlaveWrapper::Moved(common::libev::IoLoop* server, common::libev::Io
 }
 
 void ProcessSlaveWrapper::Closed(common::libev::IoClient* client) {
-  UNUSED(client);
+  for (auto it = profile_requests_.begin(); it != profile_requests_.end();) {
+    if (it->dclient == client) {
+      it = profile_requests_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  for (auto it = upload_requests_.begin(); it != upload_requests_.end();) {
+    if (it->dclient == client) {
+      it = upload_requests_.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
 void ProcessSlaveWrapper::TimerEmited(common::libev::IoLoop* server, common::libev::timer_id_t id) {
@@ -537,10 +588,20 @@ void ProcessSlaveWrapper::TimerEmited(common::libev::IoLoop* server, common::lib
   } else if (node_stats_timer_ == id) {
     const std::string node_stats = MakeServiceStats(false);
     BroadcastClients(StatisitcServiceBroadcast(node_stats));
+    BroadcastRelayStatistic();
+    history_->RemoveStale(common::time::current_utc_mstime() / 1000);
+  } else if (restart_schedule_timer_ == id) {
+    ProcessRestartSchedule();
+  } else if (metrics_timer_ == id) {
+    PublishMetrics();
+  } else if (adopt_timer_ == id) {
+    ProcessAdoptRequests();
+    CheckAdoptedChilds();
   } else if (cleanup_files_timer_ == id) {
-    for (auto it = vods_links_.begin(); it != vods_links_.end(); ++it) {
-      utils::RemoveFilesByExtension((*it).first, CHUNK_EXT);
+    for (const auto& http_root : vods_cache_->GetHttpRoots()) {
+      utils::RemoveFilesByExtension(http_root, CHUNK_EXT);
     }
+    vods_cache_->ResetCompleted();
   } else if (quit_cleanup_timer_ == id) {
     subscribers_server_->Stop();
     vods_server_->Stop();
@@ -575,10 +636,39 @@ void ProcessSlaveWrapper::ChildStatusChanged(common::libev::IoChild* child, int
   if (WIFSIGNALED(status)) {
     signal_number = WTERMSIG(status);
   }
+  FinishChildStream(channel, stabled_status, signal_number);
+}
+#endif
+
+void ProcessSlaveWrapper::FinishChildStream(ChildStream* channel, int stabled_status, int signal_number) {
+  const auto sid = channel->GetStreamID();
   INFO_LOG() << "Stream id: " << sid << ", exit with status: " << (stabled_status ? "FAILURE" : "SUCCESS")
              << ", signal: " << signal_number;
 
-  loop_->UnRegisterChild(child);
+  loop_->UnRegisterChild(channel);
+  child_table_->Remove(sid);
+  restart_scheduler_->RemoveStream(sid);
+  metrics_->RemoveStream(sid);
+  if (cpu_placement_) {
+    cpu_placement_->Release(sid);
+    if (!config_.cpuset_cgroup.empty()) {  // child left its cpuset, empty cgroup can go
+      common::ErrnoError errn = CpuPlacement::RemoveCpusetCgroup(config_.cpuset_cgroup, sid);
+      if (errn) {
+        DEBUG_MSG_ERROR(errn, common::logging::LOG_LEVEL_WARNING);
+      }
+    }
+  }
+  if (input_broker_) {
+    serialized_stream_t promoted;
+    if (input_broker_->Detach(sid, &promoted)) {
+      PromoteInputPublisher(promoted);
+    }
+  }
+  SaveChildTable();
+  FailProfileRequests(sid, "Stream finished.");
+  if (vods_cache_->IsVodStream(sid)) {
+    UpdateVodState(sid, stabled_status == EXIT_SUCCESS);
+  }
 
   StreamStruct* mem = channel->GetMem();
   FreeSharedStreamStruct(&mem);
@@ -596,7 +686,6 @@ void ProcessSlaveWrapper::ChildStatusChanged(common::libev::IoChild* child, int
 
   BroadcastClients(QuitStatusStreamBroadcast(quit_json));
 }
-#endif
 
 Child* ProcessSlaveWrapper::FindChildByID(stream_id_t cid) const {
   auto childs = loop_->GetChilds();
@@ -748,25 +837,93 @@ void ProcessSlaveWrapper::PostLooped(common::libev::IoLoop* server) {
     server->RemoveTimer(node_stats_timer_);
     node_stats_timer_ = INVALID_TIMER_ID;
   }
+
+  if (restart_schedule_timer_ != INVALID_TIMER_ID) {
+    server->RemoveTimer(restart_schedule_timer_);
+    restart_schedule_timer_ = INVALID_TIMER_ID;
+  }
+
+  if (metrics_timer_ != INVALID_TIMER_ID) {
+    server->RemoveTimer(metrics_timer_);
+    metrics_timer_ = INVALID_TIMER_ID;
+  }
+
+  if (adopt_timer_ != INVALID_TIMER_ID) {
+    server->RemoveTimer(adopt_timer_);
+    adopt_timer_ = INVALID_TIMER_ID;
+  }
+
+  // clean stop, streams were stopped and nobody waits for adoption
+  adopt_listener_->Close();
+  common::ErrnoError err = common::file_system::remove_file(CHILD_TABLE_PATH);
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+  }
 }
 
 void ProcessSlaveWrapper::OnHttpRequest(common::libev::http::HttpClient* client, const file_path_t& file) {
   if (client->GetServer() == vods_server_) {
     const std::string ext = file.GetExtension();
     if (common::EqualsASCII(ext, M3U8_EXTENSION, false)) {
-      loop_->ExecInLoopThread([this, file]() {
-        const common::file_system::ascii_directory_string_path http_root(file.GetDirectory());
-        auto it = vods_links_.find(http_root);
-        if (it == vods_links_.end()) {
-          return;
-        }
+      const common::file_system::ascii_directory_string_path http_root(file.GetDirectory());
+      if (vods_cache_->IsComplete(http_root)) {
+        return;
+      }
 
-        bool is_full_vod = CheckIsFullVod(file);
-        if (!is_full_vod) {
-          const serialized_stream_t config = it->second;
-          CreateChildStream(config);
-        }
-      });
+      // marked here, not in loop, so handler holds first request of cold vod
+      const bool start = vods_cache_->MarkRequested(http_root);
+      loop_->ExecInLoopThread([this, file, start]() { ProcessVodRequest(file, start); });
+    }
+  }
+}
+
+bool ProcessSlaveWrapper::IsFileInProgress(const file_path_t& file) const {
+  const common::file_system::ascii_directory_string_path http_root(file.GetDirectory());
+  return vods_cache_->IsPending(http_root);
+}
+
+void ProcessSlaveWrapper::ProcessVodRequest(const file_path_t& playlist, bool start) {
+  CHECK(loop_->IsLoopThread());
+  const common::file_system::ascii_directory_string_path http_root(playlist.GetDirectory());
+  serialized_stream_t config;
+  VodsCache::VodState state;
+  if (!vods_cache_->FindVod(http_root, &config, &state)) {
+    return;
+  }
+
+  vods_cache_->SetPlaylist(http_root, playlist);
+  if (!start) {  // complete or transcode already started by previous request
+    return;
+  }
+
+  if (CheckIsFullVod(playlist)) {
+    vods_cache_->SetRootState(http_root, VodsCache::COMPLETE);
+    return;
+  }
+
+  if (!FindChildByID(config.id)) {
+    common::ErrnoError err = CreateChildStream(config);
+    if (err) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+      vods_cache_->SetRootState(http_root, VodsCache::ABSENT);  // release held requests
+      return;
+    }
+  }
+  vods_cache_->SetStreamState(config.id, VodsCache::IN_PROGRESS);
+}
+
+void ProcessSlaveWrapper::UpdateVodState(stream_id_t sid, bool success) {
+  CHECK(loop_->IsLoopThread());
+  vods_cache_->SetStreamState(sid, VodsCache::ABSENT);
+  if (!success) {
+    return;
+  }
+
+  // one check when transcode finished, next requests answered by cache
+  for (const file_path_t& playlist : vods_cache_->GetPlaylists(sid)) {
+    if (CheckIsFullVod(playlist)) {
+      const common::file_system::ascii_directory_string_path http_root(playlist.GetDirectory());
+      vods_cache_->SetRootState(http_root, VodsCache::COMPLETE);
     }
   }
 }
@@ -808,6 +965,10 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientStopService(Protocole
       channel->SendStop(NextRequestID());
     }
 
+    for (const stream_id_t& sid : relay_engine_->GetStreamsIDs()) {
+      StopRelayStream(sid);
+    }
+
     protocol::response_t resp = StopServiceResponceSuccess(req->id);
     dclient->WriteResponce(resp);
 
@@ -843,26 +1004,37 @@ common::ErrnoError ProcessSlaveWrapper::HandleResponcePingService(ProtocoledDaem
 
 common::ErrnoError ProcessSlaveWrapper::CreateChildStream(const std::string& config) {
   CHECK(loop_->IsLoopThread());
-  utils::ArgsMap config_args = options::ValidateConfig(config);
+  serialized_stream_t config_args;
+  common::Error err = options::ParseStreamConfig(config, &config_args);
+  if (err) {
+    return common::make_errno_error(err->GetDescription(), EINVAL);
+  }
   return CreateChildStream(config_args);
 }
 
 common::ErrnoError ProcessSlaveWrapper::CreateChildStream(const serialized_stream_t& config_args) {
   CHECK(loop_->IsLoopThread());
   StreamInfo sha;
-  std::string feedback_dir;
-  common::logging::LOG_LEVEL logs_level;
-  common::ErrnoError err = MakeStreamInfo(config_args, &sha, &feedback_dir, &logs_level);
+  common::ErrnoError err = MakeStreamInfo(config_args, &sha);
   if (err) {
     return err;
   }
 
   Child* stream = FindChildByID(sha.id);
-  if (stream) {
+  if (stream || relay_engine_->IsRelaying(sha.id)) {
     NOTICE_LOG() << "Skip request to start stream id: " << sha.id;
     return common::make_errno_error(common::MemSPrintf("Stream with id: %s exist, skip request.", sha.id), EINVAL);
   }
 
+  if (IsNativeRelayStream(config_args)) {
+    INFO_LOG() << "Stream id: " << sha.id << " relayed by service.";
+    return relay_engine_->AddStream(sha, config_args.input, config_args.output);
+  }
+
+  if (sha.type == PROXY) {
+    return common::make_errno_error("Proxy streams supported only with one udp input and udp outputs.", EINVAL);
+  }
+
   StreamStruct* mem = nullptr;
   err = AllocSharedStreamStruct(sha, &mem);
   if (err) {
@@ -885,13 +1057,27 @@ common::ErrnoError ProcessSlaveWrapper::CreateChildStream(const serialized_strea
     return err;
   }
 
+  // readers of shared upstream get internal:// input, publisher gets socket to write
+  serialized_stream_t child_config = config_args;
+  if (input_broker_ && input_broker_->Attach(&child_config)) {
+    INFO_LOG() << "Stream id: " << sha.id << (input_broker_->IsPublisher(sha.id) ? " publishes" : " reads")
+               << " shared input: " << config_args.input[0].GetInput().GetUrl();
+  }
+
+  // placed again on every start, restarted stream goes to the least loaded cores of now
+  CpuPlacement::Assignment placement = {-1, std::vector<int>()};
+  if (cpu_placement_) {
+    placement = cpu_placement_->Assign(sha.id, CpuPlacement::GetRequiredCpus(config_args.type, config_args.args));
+  }
+
 #if !defined(TEST)
   pid_t pid = fork();
 #else
   pid_t pid = 0;
 #endif
   if (pid == 0) {  // child
-    const struct cmd_args client_args = {feedback_dir.c_str(), logs_level};
+    const struct cmd_args client_args = {config_args.feedback_dir.c_str(), config_args.log_level, ADOPT_SOCKET_PATH,
+                                         read_command_client, write_responce_client};
     const std::string new_process_name = common::MemSPrintf(STREAMER_NAME "_%s", sha.id);
     for (int i = 0; i < process_argc_; ++i) {
       memset(process_argv_[i], 0, strlen(process_argv_[i]));
@@ -903,26 +1089,50 @@ common::ErrnoError ProcessSlaveWrapper::CreateChildStream(const serialized_strea
     prctl(PR_SET_NAME, new_name);
 
 #if !defined(TEST)
-    // close not needed pipes
-    common::ErrnoError errn = common::file_system::close_descriptor(read_responce_client);
-    if (errn) {
-      DEBUG_MSG_ERROR(errn, common::logging::LOG_LEVEL_WARNING);
-    }
-    errn = common::file_system::close_descriptor(write_requests_client);
-    if (errn) {
-      DEBUG_MSG_ERROR(errn, common::logging::LOG_LEVEL_WARNING);
+    // close not needed pipes and sockets of service, child may outlive it and must not hold its ports
+    utils::CloseInheritedDescriptors({read_command_client, write_responce_client});
+
+    // before pipeline threads are created, they inherit affinity
+    if (!placement.cpus.empty()) {
+      if (!config_.cpuset_cgroup.empty()) {  // cgroup cpuset also keeps memory on node
+        common::ErrnoError errn = CpuPlacement::JoinCpusetCgroup(config_.cpuset_cgroup, sha.id, getpid(), placement);
+        if (errn) {
+          DEBUG_MSG_ERROR(errn, common::logging::LOG_LEVEL_WARNING);
+        }
+      }
+      common::ErrnoError errn = CpuPlacement::SetAffinity(0, placement);
+      if (errn) {
+        DEBUG_MSG_ERROR(errn, common::logging::LOG_LEVEL_WARNING);
+      }
     }
 #endif
 
     pipe::ProtocoledPipeClient* client =
         new pipe::ProtocoledPipeClient(nullptr, read_command_client, write_responce_client);
     client->SetName(sha.id);
-    int res = stream_exec_func_(new_name, &client_args, &config_args, client, mem);
+    int res = stream_exec_func_(new_name, &client_args, &child_config, client, mem);
+    // service which adopted process is not its parent and can't wait it, pipes are the same after adoption
+    std::string quit_json;
+    stream::QuitStatusInfo quit_info(sha.id, res, 0);
+    common::Error err_ser = quit_info.SerializeToString(&quit_json);
+    if (!err_ser) {
+      common::ErrnoError errn = client->WriteRequest(QuitStatusStreamBroadcast(quit_json));
+      UNUSED(errn);
+    }
     client->Close();
     delete client;
     _exit(res);
   } else if (pid < 0) {
     NOTICE_LOG() << "Failed to start children!";
+    if (cpu_placement_) {
+      cpu_placement_->Release(sha.id);
+    }
+    if (input_broker_) {
+      serialized_stream_t promoted;
+      if (input_broker_->Detach(sha.id, &promoted)) {
+        PromoteInputPublisher(promoted);
+      }
+    }
   } else {
     // close not needed pipes
     common::ErrnoError errn = common::file_system::close_descriptor(read_command_client);
@@ -941,121 +1151,552 @@ common::ErrnoError ProcessSlaveWrapper::CreateChildStream(const serialized_strea
     ChildStream* new_channel = new ChildStream(loop_, mem);
     new_channel->SetClient(pipe_client);
     loop_->RegisterChild(new_channel, pid);
+    child_table_->Add(sha.id, pid);
+    SaveChildTable();
+    if (!placement.cpus.empty()) {
+      INFO_LOG() << "Stream id: " << sha.id << " placed on node: " << placement.node
+                 << ", cpus: " << placement.cpus.size();
+    }
   }
 
   return common::ErrnoError();
 }
 
-common::ErrnoError ProcessSlaveWrapper::HandleRequestChangedSourcesStream(pipe::ProtocoledPipeClient* pclient,
-                                                                          protocol::request_t* req) {
-  UNUSED(pclient);
-  CHECK(loop_->IsLoopThread());
-  if (req->params) {
-    const char* params_ptr = req->params->c_str();
-    json_object* jrequest_changed_sources = json_tokener_parse(params_ptr);
-    if (!jrequest_changed_sources) {
-      return common::make_errno_error_inval();
+void ProcessSlaveWrapper::LoadChildTable() {
+  common::ErrnoError err = child_table_->Load(CHILD_TABLE_PATH);
+  if (err) {
+    if (err->GetErrorCode() != ENOENT) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
     }
+    return;
+  }
 
-    ChangedSouresInfo ch_sources_info;
-    common::Error err_des = ch_sources_info.DeSerialize(jrequest_changed_sources);
-    json_object_put(jrequest_changed_sources);
-    if (err_des) {
-      const std::string err_str = err_des->GetDescription();
-      return common::make_errno_error(err_str, EAGAIN);
+  for (const ChildTable::Entry& entry : child_table_->GetEntries()) {
+    if (kill(entry.pid, 0) == ERROR_RESULT_VALUE && errno == ESRCH) {
+      child_table_->Remove(entry.id);
     }
+  }
 
-    std::string changed_json;
-    common::Error err_ser = ch_sources_info.SerializeToString(&changed_json);
-    if (err_ser) {
-      const std::string err_str = err_ser->GetDescription();
-      return common::make_errno_error(err_str, EAGAIN);
+  if (child_table_->GetSize()) {
+    adopt_deadline_ = common::time::current_utc_mstime() + utils::AdoptListener::WAIT_SECONDS * 1000;
+    NOTICE_LOG() << "Waiting adoption of " << child_table_->GetSize() << " stream(s) of previous service instance.";
+  }
+  if (input_broker_) {
+    RestoreSharedInputs();
+  }
+  SaveChildTable();
+}
+
+void ProcessSlaveWrapper::RestoreSharedInputs() {
+  // before any new stream starts, so it reads live publisher of previous instance instead of replacing its socket
+  for (bool publishers : {true, false}) {
+    for (const ChildTable::Entry& entry : child_table_->GetEntries()) {
+      if (entry.shared_input.empty() || entry.publisher != publishers) {
+        continue;
+      }
+
+      json_object* jconfig = json_tokener_parse(entry.shared_input.c_str());
+      if (!jconfig) {
+        WARNING_LOG() << "Stream id: " << entry.id << " invalid shared input config.";
+        continue;
+      }
+
+      ReconfigureInfo info;
+      common::Error err = info.DeSerialize(jconfig);
+      json_object_put(jconfig);
+      if (err) {
+        const std::string err_str = err->GetDescription();
+        WARNING_LOG() << "Stream id: " << entry.id << " invalid shared input config: " << err_str;
+        continue;
+      }
+
+      serialized_stream_t promoted;
+      if (input_broker_->Restore(info.GetConfig(), entry.publisher, &promoted)) {  // publisher exited meanwhile
+        adopt_promotions_[entry.id] = promoted;
+      }
     }
+  }
+}
 
-    BroadcastClients(ChangedSourcesStreamBroadcast(changed_json));
-    return common::ErrnoError();
+void ProcessSlaveWrapper::SaveChildTable() {
+  if (input_broker_) {  // roles change with promotions and reconfigurations
+    for (const ChildTable::Entry& entry : child_table_->GetEntries()) {
+      serialized_stream_t original;
+      bool publisher = false;
+      std::string original_json;
+      if (input_broker_->GetRole(entry.id, &original, &publisher)) {
+        ReconfigureInfo info(original);
+        common::Error err_ser = info.SerializeToString(&original_json);
+        if (err_ser) {
+          const std::string err_str = err_ser->GetDescription();
+          WARNING_LOG() << "Failed to serialize shared input of stream id: " << entry.id << ", " << err_str;
+          original_json.clear();
+        }
+      }
+      child_table_->SetSharedInput(entry.id, original_json, publisher);
+    }
   }
 
-  return common::make_errno_error_inval();
+  common::ErrnoError err = child_table_->Save(CHILD_TABLE_PATH);
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+  }
 }
 
-common::ErrnoError ProcessSlaveWrapper::HandleRequestStatisticStream(pipe::ProtocoledPipeClient* pclient,
-                                                                     protocol::request_t* req) {
-  UNUSED(pclient);
+void ProcessSlaveWrapper::ProcessAdoptRequests() {
   CHECK(loop_->IsLoopThread());
-  if (req->params) {
-    const char* params_ptr = req->params->c_str();
-    json_object* jrequest_stat = json_tokener_parse(params_ptr);
-    if (!jrequest_stat) {
-      return common::make_errno_error_inval();
+  while (adopt_listener_->IsListening()) {
+    utils::AdoptRequest request;
+    common::ErrnoError err = adopt_listener_->Accept(&request);
+    if (err) {
+      if (err->GetErrorCode() == EINVAL) {  // broken request, others may be fine
+        DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+        continue;
+      }
+      if (err->GetErrorCode() != EAGAIN) {
+        DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+      }
+      break;
     }
 
-    StatisticInfo stat;
-    common::Error err_des = stat.DeSerialize(jrequest_stat);
-    json_object_put(jrequest_stat);
-    if (err_des) {
-      const std::string err_str = err_des->GetDescription();
-      return common::make_errno_error(err_str, EAGAIN);
+    err = AdoptChildStream(&request);
+    if (err) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+    }
+    utils::AdoptListener::Reply(&request, !err);
+  }
+
+  // not adopted processes of previous instance stop by themselves
+  if (adopt_deadline_ && common::time::current_utc_mstime() > adopt_deadline_) {
+    for (const ChildTable::Entry& entry : child_table_->GetEntries()) {
+      if (!FindChildByID(entry.id)) {
+        WARNING_LOG() << "Stream id: " << entry.id << ", pid: " << entry.pid << " not adopted.";
+        child_table_->Remove(entry.id);
+        if (input_broker_) {
+          serialized_stream_t promoted;
+          if (input_broker_->Detach(entry.id, &promoted)) {
+            PromoteInputPublisher(promoted);
+          }
+        }
+        adopt_promotions_.erase(entry.id);
+      }
     }
+    adopt_deadline_ = 0;
+    adopt_promotions_.clear();
+    SaveChildTable();
+  }
+}
 
-    std::string stream_stats;
-    common::Error err_ser = stat.SerializeToString(&stream_stats);
-    if (err_ser) {
-      const std::string err_str = err_ser->GetDescription();
-      return common::make_errno_error(err_str, EAGAIN);
-    }
+common::ErrnoError ProcessSlaveWrapper::AdoptChildStream(utils::AdoptRequest* request) {
+  CHECK(loop_->IsLoopThread());
+  if (request->uid != getuid()) {
+    return common::make_errno_error("Adopt request from process of other user.", EPERM);
+  }
 
-    BroadcastClients(StatisitcStreamBroadcast(stream_stats));
-    return common::ErrnoError();
+  json_object* jstat = json_tokener_parse(request->hello.c_str());
+  if (!jstat) {
+    return common::make_errno_error_inval();
   }
 
-  return common::make_errno_error_inval();
-}
+  StatisticInfo stat;
+  common::Error err_des = stat.DeSerialize(jstat);
+  json_object_put(jstat);
+  if (err_des) {
+    const std::string err_str = err_des->GetDescription();
+    return common::make_errno_error(err_str, EINVAL);
+  }
 
-common::ErrnoError ProcessSlaveWrapper::HandleRequestClientStartStream(ProtocoledDaemonClient* dclient,
-                                                                       protocol::request_t* req) {
-  CHECK(loop_->IsLoopThread());
-  if (!dclient->IsVerified()) {
+  const StreamStruct stream = stat.GetStreamStruct();
+  pid_t pid = 0;
+  if (!child_table_->Find(stream.id, &pid) || pid != request->pid) {
+    return common::make_errno_error(
+        common::MemSPrintf("Stream id: %s, pid: %d is not a child of service.", stream.id, request->pid), EPERM);
+  }
+
+  Child* chan = FindChildByID(stream.id);
+  if (chan && chan->GetType() != Child::STREAM) {
     return common::make_errno_error_inval();
   }
 
-  if (req->params) {
-    const char* params_ptr = req->params->c_str();
-    json_object* jstart_info = json_tokener_parse(params_ptr);
-    if (!jstart_info) {
-      return common::make_errno_error_inval();
+  ChildStream* channel = static_cast<ChildStream*>(chan);
+  StreamStruct* mem = nullptr;
+  if (!channel) {
+    StreamInfo sha;
+    sha.id = stream.id;
+    sha.type = stream.type;
+    for (const ChannelStats& input : stream.input) {
+      sha.input.push_back(input.GetID());
     }
-
-    stream::StartInfo start_info;
-    common::Error err_des = start_info.DeSerialize(jstart_info);
-    json_object_put(jstart_info);
-    if (err_des) {
-      const std::string err_str = err_des->GetDescription();
-      return common::make_errno_error(err_str, EAGAIN);
+    for (const ChannelStats& output : stream.output) {
+      sha.output.push_back(output.GetID());
     }
 
-    common::ErrnoError err = CreateChildStream(start_info.GetConfig());
+    common::ErrnoError err = AllocSharedStreamStruct(sha, &mem);
     if (err) {
-      protocol::response_t resp = StartStreamResponceFail(req->id, err->GetDescription());
-      dclient->WriteResponce(resp);
       return err;
     }
+    *mem = stream;
+  }
 
-    protocol::response_t resp = StartStreamResponceSuccess(req->id);
-    dclient->WriteResponce(resp);
+  pipe::ProtocoledPipeClient* pipe_client =
+      new pipe::ProtocoledPipeClient(loop_, request->read_fd, request->write_fd);
+  pipe_client->SetName(stream.id);
+  loop_->RegisterClient(pipe_client);
+  if (channel) {  // known process lost its pipes, service keeps the rest
+    Child::client_t* old_client = channel->GetClient();
+    if (old_client) {
+      old_client->Close();
+      delete old_client;
+    }
+    channel->SetClient(pipe_client);
+    NOTICE_LOG() << "Stream id: " << stream.id << ", pid: " << pid << " reattached.";
     return common::ErrnoError();
   }
 
-  return common::make_errno_error_inval();
+  ChildStream* new_channel = new ChildStream(loop_, mem, true);
+  new_channel->SetClient(pipe_client);
+  loop_->RegisterChild(new_channel, pid);
+  PlaceChildStream(stream.id, pid);
+  NOTICE_LOG() << "Stream id: " << stream.id << ", pid: " << pid << " adopted.";
+  const auto promotion = adopt_promotions_.find(stream.id);
+  if (promotion != adopt_promotions_.end()) {
+    const serialized_stream_t promoted = promotion->second;
+    adopt_promotions_.erase(promotion);
+    PromoteInputPublisher(promoted);
+  }
+  return common::ErrnoError();
 }
 
-protocol::sequance_id_t ProcessSlaveWrapper::NextRequestID() {
-  const protocol::seq_id_t next_id = id_++;
-  return common::protocols::json_rpc::MakeRequestID(next_id);
-}
+void ProcessSlaveWrapper::PlaceChildStream(stream_id_t sid, pid_t pid) {
+  if (!cpu_placement_) {
+    return;
+  }
 
-common::ErrnoError ProcessSlaveWrapper::HandleRequestClientStopStream(ProtocoledDaemonClient* dclient,
-                                                                      protocol::request_t* req) {
+  // stream keeps cores given by previous instance, they are counted till its restart
+  std::vector<int> cpus;
+  common::ErrnoError err = CpuPlacement::GetAffinity(pid, &cpus);
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+    return;
+  }
+  cpu_placement_->Restore(sid, cpus);
+}
+
+void ProcessSlaveWrapper::CheckAdoptedChilds() {
+  CHECK(loop_->IsLoopThread());
+  auto childs = loop_->GetChilds();
+  for (auto* child : childs) {
+    Child* chan = static_cast<Child*>(child);
+    if (chan->GetType() != Child::STREAM || !static_cast<ChildStream*>(chan)->IsAdopted()) {
+      continue;
+    }
+
+    // not own children, exit is noticed by polling
+    pid_t pid = 0;
+    if (!child_table_->Find(chan->GetStreamID(), &pid) || kill(pid, 0) == ERROR_RESULT_VALUE) {
+      // quit status written before exit can still wait in pipe
+      while (chan->GetClient() && static_cast<pipe::ProtocoledPipeClient*>(chan->GetClient())->IsReadReady()) {
+        DataReceived(chan->GetClient());
+      }
+
+      Child::client_t* client = chan->GetClient();
+      if (client) {
+        chan->SetClient(nullptr);
+        client->Close();
+        delete client;
+      }
+      ChildStream* channel = static_cast<ChildStream*>(chan);
+      FinishChildStream(channel, channel->GetExitStatus(), 0);
+    }
+  }
+}
+
+void ProcessSlaveWrapper::StopRelayStream(stream_id_t sid) {
+  CHECK(loop_->IsLoopThread());
+  common::ErrnoError err = relay_engine_->RemoveStream(sid);
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+    return;
+  }
+
+  std::string quit_json;
+  stream::QuitStatusInfo ch_status_info(sid, true, 0);
+  common::Error err_ser = ch_status_info.SerializeToString(&quit_json);
+  if (err_ser) {
+    const std::string err_str = err_ser->GetDescription();
+    WARNING_LOG() << "Failed to generate strean exit message: " << err_str;
+    return;
+  }
+
+  BroadcastClients(QuitStatusStreamBroadcast(quit_json));
+}
+
+void ProcessSlaveWrapper::BroadcastRelayStatistic() {
+  CHECK(loop_->IsLoopThread());
+  const fastotv::timestamp_t current_time = common::time::current_utc_mstime();
+  const auto relays = relay_engine_->CollectStatistic(node_stats_send_seconds);
+  for (const StreamStruct& relay : relays) {
+    std::string stream_stats;
+    StatisticInfo stat(relay, 0, 0, current_time);
+    common::Error err_ser = stat.SerializeToString(&stream_stats);
+    if (err_ser) {
+      const std::string err_str = err_ser->GetDescription();
+      WARNING_LOG() << "Failed to generate relay statistic: " << err_str;
+      continue;
+    }
+
+    BroadcastClients(StatisitcStreamBroadcast(stream_stats));
+  }
+}
+
+void ProcessSlaveWrapper::ProcessRestartSchedule() {
+  CHECK(loop_->IsLoopThread());
+  const fastotv::timestamp_t current_time = common::time::current_utc_mstime();
+  for (const stream_id_t& sid : restart_scheduler_->GetStartingStreams()) {
+    Child* chan = FindChildByID(sid);
+    if (!chan || chan->GetType() != Child::STREAM) {
+      restart_scheduler_->RemoveStream(sid);
+      continue;
+    }
+
+    const StreamStruct* mem = static_cast<ChildStream*>(chan)->GetMem();
+    if (mem->status == PLAYING) {
+      restart_scheduler_->OnStreamStarted(sid, current_time);
+    }
+  }
+
+  const std::vector<stream_id_t> ready = restart_scheduler_->CollectReady(current_time);
+  for (const stream_id_t& sid : ready) {
+    Child* chan = FindChildByID(sid);
+    if (!chan) {
+      restart_scheduler_->RemoveStream(sid);
+      continue;
+    }
+
+    common::ErrnoError err = chan->SendResume(NextRequestID());
+    if (err) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+      restart_scheduler_->RemoveStream(sid);
+      continue;
+    }
+
+    INFO_LOG() << "Restart permitted for stream id: " << sid << ", starting: "
+               << restart_scheduler_->GetStartingCount() << "/" << restart_scheduler_->GetStartupBudget()
+               << ", waiting: " << restart_scheduler_->GetWaitingCount();
+  }
+}
+
+void ProcessSlaveWrapper::PromoteInputPublisher(const serialized_stream_t& config_args) {
+  CHECK(loop_->IsLoopThread());
+  Child* chan = FindChildByID(config_args.id);
+  if (!chan) {
+    if (adopt_deadline_) {  // reader of previous instance, promoted when adopted
+      adopt_promotions_[config_args.id] = config_args;
+    }
+    return;
+  }
+
+  std::string reconfigure_json;
+  ReconfigureInfo pipe_info(config_args);
+  common::Error err_ser = pipe_info.SerializeToString(&reconfigure_json);
+  if (err_ser) {
+    const std::string err_str = err_ser->GetDescription();
+    WARNING_LOG() << "Failed to generate reconfigure message: " << err_str;
+    return;
+  }
+
+  // reader restarts with upstream url and publishes it on the same socket
+  common::ErrnoError err = chan->SendReconfigure(NextRequestID(), reconfigure_json);
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+    return;
+  }
+  INFO_LOG() << "Stream id: " << config_args.id << " publishes shared input now.";
+}
+
+common::ErrnoError ProcessSlaveWrapper::HandleRequestRestartScheduleStream(pipe::ProtocoledPipeClient* pclient,
+                                                                           protocol::request_t* req) {
+  UNUSED(pclient);
+  CHECK(loop_->IsLoopThread());
+  if (req->params) {
+    const char* params_ptr = req->params->c_str();
+    json_object* jrequest_schedule = json_tokener_parse(params_ptr);
+    if (!jrequest_schedule) {
+      return common::make_errno_error_inval();
+    }
+
+    RestartScheduleInfo schedule_info;
+    common::Error err_des = schedule_info.DeSerialize(jrequest_schedule);
+    json_object_put(jrequest_schedule);
+    if (err_des) {
+      const std::string err_str = err_des->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    const stream_id_t sid = schedule_info.GetStreamID();
+    if (!FindChildByID(sid)) {
+      return common::make_errno_error(common::MemSPrintf("Stream with id: %s not found.", sid), EINVAL);
+    }
+
+    restart_scheduler_->ScheduleRestart(sid, schedule_info.GetUpstreamHost(), common::time::current_utc_mstime());
+    INFO_LOG() << "Stream id: " << sid << " scheduled for restart, upstream: " << schedule_info.GetUpstreamHost()
+               << ", attempts: " << schedule_info.GetAttempts();
+    return common::ErrnoError();
+  }
+
+  return common::make_errno_error_inval();
+}
+
+common::ErrnoError ProcessSlaveWrapper::HandleRequestQuitStatusStream(pipe::ProtocoledPipeClient* pclient,
+                                                                      protocol::request_t* req) {
+  UNUSED(pclient);
+  CHECK(loop_->IsLoopThread());
+  if (req->params) {
+    const char* params_ptr = req->params->c_str();
+    json_object* jquit_status = json_tokener_parse(params_ptr);
+    if (!jquit_status) {
+      return common::make_errno_error_inval();
+    }
+
+    stream::QuitStatusInfo quit_info;
+    common::Error err_des = quit_info.DeSerialize(jquit_status);
+    json_object_put(jquit_status);
+    if (err_des) {
+      const std::string err_str = err_des->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    const stream_id_t sid = quit_info.GetStreamID();
+    Child* chan = FindChildByID(sid);
+    if (!chan || chan->GetType() != Child::STREAM) {
+      return common::make_errno_error(common::MemSPrintf("Stream with id: %s not found.", sid), EINVAL);
+    }
+
+    static_cast<ChildStream*>(chan)->SetExitStatus(quit_info.GetExitStatus());
+    return common::ErrnoError();
+  }
+
+  return common::make_errno_error_inval();
+}
+
+common::ErrnoError ProcessSlaveWrapper::HandleRequestChangedSourcesStream(pipe::ProtocoledPipeClient* pclient,
+                                                                          protocol::request_t* req) {
+  UNUSED(pclient);
+  CHECK(loop_->IsLoopThread());
+  if (req->params) {
+    const char* params_ptr = req->params->c_str();
+    json_object* jrequest_changed_sources = json_tokener_parse(params_ptr);
+    if (!jrequest_changed_sources) {
+      return common::make_errno_error_inval();
+    }
+
+    ChangedSouresInfo ch_sources_info;
+    common::Error err_des = ch_sources_info.DeSerialize(jrequest_changed_sources);
+    json_object_put(jrequest_changed_sources);
+    if (err_des) {
+      const std::string err_str = err_des->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    std::string changed_json;
+    common::Error err_ser = ch_sources_info.SerializeToString(&changed_json);
+    if (err_ser) {
+      const std::string err_str = err_ser->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    BroadcastClients(ChangedSourcesStreamBroadcast(changed_json));
+    return common::ErrnoError();
+  }
+
+  return common::make_errno_error_inval();
+}
+
+common::ErrnoError ProcessSlaveWrapper::HandleRequestStatisticStream(pipe::ProtocoledPipeClient* pclient,
+                                                                     protocol::request_t* req) {
+  UNUSED(pclient);
+  CHECK(loop_->IsLoopThread());
+  if (req->params) {
+    const char* params_ptr = req->params->c_str();
+    json_object* jrequest_stat = json_tokener_parse(params_ptr);
+    if (!jrequest_stat) {
+      return common::make_errno_error_inval();
+    }
+
+    StatisticInfo stat;
+    common::Error err_des = stat.DeSerialize(jrequest_stat);
+    json_object_put(jrequest_stat);
+    if (err_des) {
+      const std::string err_str = err_des->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    const StreamStruct stream = stat.GetStreamStruct();
+    Child* chan = FindChildByID(stream.id);
+    if (chan && chan->GetType() == Child::STREAM && static_cast<ChildStream*>(chan)->IsAdopted()) {
+      *static_cast<ChildStream*>(chan)->GetMem() = stream;  // adopted process writes its own copy
+    }
+
+    metrics_->UpdateStream(stream, stat.GetCpuLoad(), stat.GetRssBytes());
+    SampleHistory(stream);
+    std::string stream_stats;
+    common::Error err_ser = stat.SerializeToString(&stream_stats);
+    if (err_ser) {
+      const std::string err_str = err_ser->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    BroadcastClients(StatisitcStreamBroadcast(stream_stats));
+    return common::ErrnoError();
+  }
+
+  return common::make_errno_error_inval();
+}
+
+common::ErrnoError ProcessSlaveWrapper::HandleRequestClientStartStream(ProtocoledDaemonClient* dclient,
+                                                                       protocol::request_t* req) {
+  CHECK(loop_->IsLoopThread());
+  if (!dclient->IsVerified()) {
+    return common::make_errno_error_inval();
+  }
+
+  if (req->params) {
+    const char* params_ptr = req->params->c_str();
+    json_object* jstart_info = json_tokener_parse(params_ptr);
+    if (!jstart_info) {
+      return common::make_errno_error_inval();
+    }
+
+    stream::StartInfo start_info;
+    common::Error err_des = start_info.DeSerialize(jstart_info);
+    json_object_put(jstart_info);
+    if (err_des) {
+      const std::string err_str = err_des->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    common::ErrnoError err = CreateChildStream(start_info.GetConfig());
+    if (err) {
+      protocol::response_t resp = StartStreamResponceFail(req->id, err->GetDescription());
+      dclient->WriteResponce(resp);
+      return err;
+    }
+
+    protocol::response_t resp = StartStreamResponceSuccess(req->id);
+    dclient->WriteResponce(resp);
+    return common::ErrnoError();
+  }
+
+  return common::make_errno_error_inval();
+}
+
+protocol::sequance_id_t ProcessSlaveWrapper::NextRequestID() {
+  const protocol::seq_id_t next_id = id_++;
+  return common::protocols::json_rpc::MakeRequestID(next_id);
+}
+
+common::ErrnoError ProcessSlaveWrapper::HandleRequestClientStopStream(ProtocoledDaemonClient* dclient,
+                                                                      protocol::request_t* req) {
   CHECK(loop_->IsLoopThread());
   if (!dclient->IsVerified()) {
     return common::make_errno_error_inval();
@@ -1077,6 +1718,13 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientStopStream(Protocoled
     }
 
     Child* chan = FindChildByID(stop_info.GetStreamID());
+    if (!chan && relay_engine_->IsRelaying(stop_info.GetStreamID())) {
+      StopRelayStream(stop_info.GetStreamID());
+      protocol::response_t resp = StopStreamResponceSuccess(req->id);
+      dclient->WriteResponce(resp);
+      return common::ErrnoError();
+    }
+
     if (!chan) {
       protocol::response_t resp = StopStreamResponceFail(req->id, "Stream not found.");
       dclient->WriteResponce(resp);
@@ -1115,12 +1763,26 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientRestartStream(Protoco
     }
 
     Child* chan = FindChildByID(restart_info.GetStreamID());
+    if (!chan && relay_engine_->IsRelaying(restart_info.GetStreamID())) {
+      common::ErrnoError err = relay_engine_->RestartStream(restart_info.GetStreamID());
+      if (err) {
+        protocol::response_t resp = RestartStreamResponceFail(req->id, err->GetDescription());
+        dclient->WriteResponce(resp);
+        return err;
+      }
+
+      protocol::response_t resp = RestartStreamResponceSuccess(req->id);
+      dclient->WriteResponce(resp);
+      return common::ErrnoError();
+    }
+
     if (!chan) {
       protocol::response_t resp = RestartStreamResponceFail(req->id, "Stream not found.");
       dclient->WriteResponce(resp);
       return common::ErrnoError();
     }
 
+    restart_scheduler_->RemoveStream(restart_info.GetStreamID());  // restart by request skips back-off
     chan->SendRestart(NextRequestID());
     protocol::response_t resp = RestartStreamResponceSuccess(req->id);
     dclient->WriteResponce(resp);
@@ -1130,6 +1792,116 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientRestartStream(Protoco
   return common::make_errno_error_inval();
 }
 
+common::ErrnoError ProcessSlaveWrapper::HandleRequestClientReconfigureStream(ProtocoledDaemonClient* dclient,
+                                                                             protocol::request_t* req) {
+  CHECK(loop_->IsLoopThread());
+  if (!dclient->IsVerified()) {
+    return common::make_errno_error_inval();
+  }
+
+  if (req->params) {
+    const char* params_ptr = req->params->c_str();
+    json_object* jreconfigure_info = json_tokener_parse(params_ptr);
+    if (!jreconfigure_info) {
+      return common::make_errno_error_inval();
+    }
+
+    stream::ReconfigureInfo reconfigure_info;
+    common::Error err_des = reconfigure_info.DeSerialize(jreconfigure_info);
+    json_object_put(jreconfigure_info);
+    if (err_des) {
+      const std::string err_str = err_des->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    serialized_stream_t config_args;
+    common::Error err_parse = options::ParseStreamConfig(reconfigure_info.GetConfig(), &config_args);
+    if (err_parse) {
+      const std::string err_str = err_parse->GetDescription();
+      protocol::response_t resp = ReconfigureStreamResponceFail(req->id, err_str);
+      dclient->WriteResponce(resp);
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    Child* chan = FindChildByID(config_args.id);
+    if (!chan && relay_engine_->IsRelaying(config_args.id)) {
+      // relay channel is cheap to reopen, sockets only
+      common::ErrnoError err = ReconfigureRelayStream(config_args);
+      if (err) {
+        protocol::response_t resp = ReconfigureStreamResponceFail(req->id, err->GetDescription());
+        dclient->WriteResponce(resp);
+        return err;
+      }
+
+      protocol::response_t resp = ReconfigureStreamResponceSuccess(req->id);
+      dclient->WriteResponce(resp);
+      return common::ErrnoError();
+    }
+
+    if (!chan) {
+      protocol::response_t resp = ReconfigureStreamResponceFail(req->id, "Stream not found.");
+      dclient->WriteResponce(resp);
+      return common::ErrnoError();
+    }
+
+    // the same checks as on start, also makes http_root of added outputs
+    StreamInfo sha;
+    common::ErrnoError err_info = MakeStreamInfo(config_args, &sha);
+    if (err_info) {
+      protocol::response_t resp = ReconfigureStreamResponceFail(req->id, err_info->GetDescription());
+      dclient->WriteResponce(resp);
+      return err_info;
+    }
+
+    if (input_broker_ && !input_broker_->Update(&config_args)) {  // upstream changed
+      serialized_stream_t promoted;
+      if (input_broker_->Detach(config_args.id, &promoted)) {
+        PromoteInputPublisher(promoted);
+      }
+      input_broker_->Attach(&config_args);
+      SaveChildTable();
+    }
+
+    std::string reconfigure_json;
+    ReconfigureInfo pipe_info(config_args);
+    common::Error err_ser = pipe_info.SerializeToString(&reconfigure_json);
+    if (err_ser) {
+      const std::string err_str = err_ser->GetDescription();
+      protocol::response_t resp = ReconfigureStreamResponceFail(req->id, err_str);
+      dclient->WriteResponce(resp);
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    common::ErrnoError err = chan->SendReconfigure(NextRequestID(), reconfigure_json);
+    if (err) {
+      protocol::response_t resp = ReconfigureStreamResponceFail(req->id, err->GetDescription());
+      dclient->WriteResponce(resp);
+      return err;
+    }
+
+    protocol::response_t resp = ReconfigureStreamResponceSuccess(req->id);
+    dclient->WriteResponce(resp);
+    return common::ErrnoError();
+  }
+
+  return common::make_errno_error_inval();
+}
+
+common::ErrnoError ProcessSlaveWrapper::ReconfigureRelayStream(const serialized_stream_t& config_args) {
+  CHECK(loop_->IsLoopThread());
+  if (!IsNativeRelayStream(config_args)) {
+    return common::make_errno_error("Stream can't be relayed by service with new config, restart it.", EINVAL);
+  }
+
+  StreamInfo sha;
+  common::ErrnoError err = MakeStreamInfo(config_args, &sha);
+  if (err) {
+    return err;
+  }
+
+  return relay_engine_->ReconfigureStream(sha, config_args.input, config_args.output);
+}
+
 common::ErrnoError ProcessSlaveWrapper::HandleRequestClientGetLogStream(ProtocoledDaemonClient* dclient,
                                                                         protocol::request_t* req) {
   CHECK(loop_->IsLoopThread());
@@ -1156,7 +1928,9 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientGetLogStream(Protocol
     if (remote_log_path.GetScheme() == common::uri::Url::http) {
       const auto stream_log_file = MakeStreamLogPath(log_info.GetFeedbackDir());
       if (stream_log_file) {
-        PostHttpFile(*stream_log_file, remote_log_path);
+        PostLogFile(dclient, req->id, *stream_log_file, remote_log_path, log_info.GetTailSize(),
+                    GetLogStreamResponceSuccess, GetLogStreamResponceFail);
+        return common::ErrnoError();
       }
     } else if (remote_log_path.GetScheme() == common::uri::Url::https) {
     }
@@ -1194,7 +1968,9 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientGetPipelineStream(Pro
     if (remote_log_path.GetScheme() == common::uri::Url::http) {
       const auto stream_log_file = MakeStreamPipelinePath(log_info.GetFeedbackDir());
       if (stream_log_file) {
-        PostHttpFile(*stream_log_file, remote_log_path);
+        PostLogFile(dclient, req->id, *stream_log_file, remote_log_path, log_info.GetTailSize(),
+                    GetLogStreamResponceSuccess, GetLogStreamResponceFail);
+        return common::ErrnoError();
       }
     } else if (remote_log_path.GetScheme() == common::uri::Url::https) {
     }
@@ -1206,6 +1982,135 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientGetPipelineStream(Pro
   return common::make_errno_error_inval();
 }
 
+common::ErrnoError ProcessSlaveWrapper::HandleRequestClientGetProfileStream(ProtocoledDaemonClient* dclient,
+                                                                            protocol::request_t* req) {
+  CHECK(loop_->IsLoopThread());
+  if (!dclient->IsVerified()) {
+    return common::make_errno_error_inval();
+  }
+
+  if (req->params) {
+    const char* params_ptr = req->params->c_str();
+    json_object* jstream_info = json_tokener_parse(params_ptr);
+    if (!jstream_info) {
+      return common::make_errno_error_inval();
+    }
+
+    stream::StreamInfo stream_info;
+    common::Error err_des = stream_info.DeSerialize(jstream_info);
+    json_object_put(jstream_info);
+    if (err_des) {
+      const std::string err_str = err_des->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    Child* chan = FindChildByID(stream_info.GetStreamID());
+    if (!chan) {
+      protocol::response_t resp = GetProfileStreamResponceFail(req->id, "Stream not found.");
+      dclient->WriteResponce(resp);
+      return common::ErrnoError();
+    }
+
+    const protocol::sequance_id_t pipe_request_id = NextRequestID();
+    common::ErrnoError err = chan->SendGetProfile(pipe_request_id);
+    if (err) {
+      protocol::response_t resp = GetProfileStreamResponceFail(req->id, err->GetDescription());
+      dclient->WriteResponce(resp);
+      return err;
+    }
+
+    profile_requests_.push_back({*pipe_request_id, chan->GetStreamID(), dclient, req->id});
+    return common::ErrnoError();
+  }
+
+  return common::make_errno_error_inval();
+}
+
+common::ErrnoError ProcessSlaveWrapper::HandleRequestClientGetHistoryStream(ProtocoledDaemonClient* dclient,
+                                                                            protocol::request_t* req) {
+  CHECK(loop_->IsLoopThread());
+  if (!dclient->IsVerified()) {
+    return common::make_errno_error_inval();
+  }
+
+  if (req->params) {
+    const char* params_ptr = req->params->c_str();
+    json_object* jhistory_info = json_tokener_parse(params_ptr);
+    if (!jhistory_info) {
+      return common::make_errno_error_inval();
+    }
+
+    stream::GetHistoryInfo history_info;
+    common::Error err_des = history_info.DeSerialize(jhistory_info);
+    json_object_put(jhistory_info);
+    if (err_des) {
+      const std::string err_str = err_des->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    const time_t from = history_info.GetFrom() / 1000;
+    const time_t to = history_info.GetTo() ? history_info.GetTo() / 1000 : std::numeric_limits<time_t>::max();
+    stream::HistoryInfo::runs_t runs;
+    if (!history_->Query(history_info.GetStreamID(), from, to, &runs)) {
+      protocol::response_t resp = GetHistoryStreamResponceFail(req->id, "Stream history not found.");
+      dclient->WriteResponce(resp);
+      return common::ErrnoError();
+    }
+
+    std::string history_json;
+    stream::HistoryInfo result(history_info.GetStreamID(), runs);
+    common::Error err_ser = result.SerializeToString(&history_json);
+    if (err_ser) {
+      const std::string err_str = err_ser->GetDescription();
+      protocol::response_t resp = GetHistoryStreamResponceFail(req->id, err_str);
+      dclient->WriteResponce(resp);
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    protocol::response_t resp = GetHistoryStreamResponceSuccess(req->id, history_json);
+    dclient->WriteResponce(resp);
+    return common::ErrnoError();
+  }
+
+  return common::make_errno_error_inval();
+}
+
+void ProcessSlaveWrapper::FinishProfileRequest(const std::string& pipe_request_id,
+                                               const protocol::response_t& child_resp) {
+  CHECK(loop_->IsLoopThread());
+  for (auto it = profile_requests_.begin(); it != profile_requests_.end(); ++it) {
+    if (it->pipe_request_id != pipe_request_id) {
+      continue;
+    }
+
+    const ProfileRequest request = *it;
+    profile_requests_.erase(it);
+    if (child_resp.IsMessage()) {
+      protocol::response_t resp = GetProfileStreamResponceSuccess(request.id, child_resp.message->result);
+      request.dclient->WriteResponce(resp);
+    } else {
+      const std::string err_str = child_resp.IsError() ? child_resp.error->message : "Invalid responce.";
+      protocol::response_t resp = GetProfileStreamResponceFail(request.id, err_str);
+      request.dclient->WriteResponce(resp);
+    }
+    return;
+  }
+}
+
+void ProcessSlaveWrapper::FailProfileRequests(const stream_id_t& sid, const std::string& error_text) {
+  CHECK(loop_->IsLoopThread());
+  for (auto it = profile_requests_.begin(); it != profile_requests_.end();) {
+    if (it->sid != sid) {
+      ++it;
+      continue;
+    }
+
+    protocol::response_t resp = GetProfileStreamResponceFail(it->id, error_text);
+    it->dclient->WriteResponce(resp);
+    it = profile_requests_.erase(it);
+  }
+}
+
 common::ErrnoError ProcessSlaveWrapper::HandleRequestClientPrepareService(ProtocoledDaemonClient* dclient,
                                                                           protocol::request_t* req) {
   CHECK(loop_->IsLoopThread());
@@ -1267,7 +2172,7 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientSyncService(Protocole
     }
 
     // refresh vods
-    vods_links_.clear();
+    vods_cache_->Clear();
     for (const std::string& config : sync_info.GetStreams()) {
       AddStreamLine(config);
     }
@@ -1283,7 +2188,92 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientSyncService(Protocole
       }
     }
 
-    protocol::response_t resp = StopStreamResponceSuccess(req->id);
+    sync_version_ = sync_info.GetVersion();
+    std::string ack_str;
+    service::SyncAckInfo ack(sync_version_);
+    common::Error err_ser = ack.SerializeToString(&ack_str);
+    if (err_ser) {
+      const std::string err_str = err_ser->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    protocol::response_t resp = SyncServiceResponceSuccess(req->id, ack_str);
+    dclient->WriteResponce(resp);
+    return common::ErrnoError();
+  }
+
+  return common::make_errno_error_inval();
+}
+
+common::ErrnoError ProcessSlaveWrapper::HandleRequestClientSyncServiceDelta(ProtocoledDaemonClient* dclient,
+                                                                            protocol::request_t* req) {
+  CHECK(loop_->IsLoopThread());
+  if (!dclient->IsVerified()) {
+    return common::make_errno_error_inval();
+  }
+
+  if (req->params) {
+    const char* params_ptr = req->params->c_str();
+    json_object* jdelta = json_tokener_parse(params_ptr);
+    if (!jdelta) {
+      return common::make_errno_error_inval();
+    }
+
+    service::SyncDeltaInfo delta_info;
+    common::Error err_des = delta_info.DeSerialize(jdelta);
+    json_object_put(jdelta);
+    if (err_des) {
+      const std::string err_str = err_des->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    // client should fallback to full sync_service
+    if (delta_info.GetBaseVersion() != sync_version_) {
+      const std::string err_str = "Sync version mismatch, service version: " +
+                                  common::ConvertToString(sync_version_) + ", full sync required.";
+      protocol::response_t resp = SyncServiceResponceFail(req->id, err_str);
+      dclient->WriteResponce(resp);
+      return common::make_errno_error(err_str, EINVAL);
+    }
+
+    for (const stream_id_t& sid : delta_info.GetRemovedStreams()) {
+      RemoveStreamLine(sid);
+    }
+    for (const std::string& config : delta_info.GetAddedStreams()) {
+      UpdateStreamLine(config);
+    }
+    for (const std::string& config : delta_info.GetUpdatedStreams()) {
+      UpdateStreamLine(config);
+    }
+
+    SyncFinder* sfinder = static_cast<SyncFinder*>(finder_);
+    for (const fastotv::login_t& login : delta_info.GetRemovedUsers()) {
+      sfinder->RemoveUser(login);
+    }
+    auto update_user = [sfinder](const std::string& user) {
+      subscribers::commands_info::UserInfo uinf;
+      common::Error err = uinf.DeSerializeFromString(user);
+      if (!err) {
+        sfinder->UpdateUser(uinf);
+      }
+    };
+    for (const std::string& user : delta_info.GetAddedUsers()) {
+      update_user(user);
+    }
+    for (const std::string& user : delta_info.GetUpdatedUsers()) {
+      update_user(user);
+    }
+
+    sync_version_ = delta_info.GetVersion();
+    std::string ack_str;
+    service::SyncAckInfo ack(sync_version_);
+    common::Error err_ser = ack.SerializeToString(&ack_str);
+    if (err_ser) {
+      const std::string err_str = err_ser->GetDescription();
+      return common::make_errno_error(err_str, EAGAIN);
+    }
+
+    protocol::response_t resp = SyncServiceResponceSuccess(req->id, ack_str);
     dclient->WriteResponce(resp);
     return common::ErrnoError();
   }
@@ -1293,30 +2283,54 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientSyncService(Protocole
 
 void ProcessSlaveWrapper::AddStreamLine(const std::string& config) {
   CHECK(loop_->IsLoopThread());
-  serialized_stream_t config_args = options::ValidateConfig(config);
-  StreamInfo sha;
-  std::string feedback_dir;
-  common::logging::LOG_LEVEL logs_level;
-  common::ErrnoError err = MakeStreamInfo(config_args, &sha, &feedback_dir, &logs_level);
+  serialized_stream_t config_args;
+  common::Error err = options::ParseStreamConfig(config, &config_args);
   if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+    return;
+  }
+
+  AddStreamLine(config_args);
+}
+
+void ProcessSlaveWrapper::AddStreamLine(serialized_stream_t config_args) {
+  CHECK(loop_->IsLoopThread());
+  StreamInfo sha;
+  common::ErrnoError errn = MakeStreamInfo(config_args, &sha);
+  if (errn) {
     return;
   }
 
   if (sha.type == VOD_ENCODE || sha.type == VOD_RELAY) {
-    output_t output;
-    if (read_output(config_args, &output)) {
-      for (const OutputUri& out_uri : output) {
-        common::uri::Url ouri = out_uri.GetOutput();
-        if (ouri.GetScheme() == common::uri::Url::http) {
-          const common::file_system::ascii_directory_string_path http_root = out_uri.GetHttpRoot();
-          config_args[CLEANUP_TS_FIELD] = common::ConvertToString(false);
-          vods_links_[http_root] = config_args;
-        }
+    for (const OutputUri& out_uri : config_args.output) {
+      common::uri::Url ouri = out_uri.GetOutput();
+      if (ouri.GetScheme() == common::uri::Url::http) {
+        const common::file_system::ascii_directory_string_path http_root = out_uri.GetHttpRoot();
+        config_args.args[CLEANUP_TS_FIELD] = common::ConvertToString(false);
+        vods_cache_->AddVod(http_root, config_args);
       }
     }
   }
 }
 
+void ProcessSlaveWrapper::UpdateStreamLine(const std::string& config) {
+  CHECK(loop_->IsLoopThread());
+  serialized_stream_t config_args;
+  common::Error err = options::ParseStreamConfig(config, &config_args);
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+    return;
+  }
+
+  RemoveStreamLine(config_args.id);  // outputs may be changed
+  AddStreamLine(config_args);
+}
+
+void ProcessSlaveWrapper::RemoveStreamLine(const stream_id_t& sid) {
+  CHECK(loop_->IsLoopThread());
+  vods_cache_->RemoveStream(sid);
+}
+
 common::ErrnoError ProcessSlaveWrapper::HandleRequestClientActivate(ProtocoledDaemonClient* dclient,
                                                                     protocol::request_t* req) {
   CHECK(loop_->IsLoopThread());
@@ -1416,7 +2430,9 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientGetLogService(Protoco
 
     const auto remote_log_path = get_log_info.GetLogPath();
     if (remote_log_path.GetScheme() == common::uri::Url::http) {
-      PostHttpFile(common::file_system::ascii_file_string_path(config_.log_path), remote_log_path);
+      PostLogFile(dclient, req->id, common::file_system::ascii_file_string_path(config_.log_path), remote_log_path,
+                  get_log_info.GetTailSize(), GetLogServiceResponceSuccess, GetLogServiceResponceFail);
+      return common::ErrnoError();
     } else if (remote_log_path.GetScheme() == common::uri::Url::https) {
     }
 
@@ -1428,6 +2444,65 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestClientGetLogService(Protoco
   return common::make_errno_error_inval();
 }
 
+void ProcessSlaveWrapper::PostLogFile(ProtocoledDaemonClient* dclient,
+                                      protocol::sequance_id_t id,
+                                      const common::file_system::ascii_file_string_path& file,
+                                      const common::uri::Url& url,
+                                      size_t tail_size,
+                                      upload_success_responce_t success,
+                                      upload_fail_responce_t fail) {
+  CHECK(loop_->IsLoopThread());
+  common::net::HostAndPort http_server_address;
+  if (!GetPostServerFromUrl(url, &http_server_address)) {
+    protocol::response_t resp = fail(id, "Invalid upload url.");
+    dclient->WriteResponce(resp);
+    return;
+  }
+
+  const uint64_t upload_id = next_upload_id_++;
+  auto done = [this, upload_id, id, success, fail](common::Error err) {
+    loop_->ExecInLoopThread([this, upload_id, id, success, fail, err]() {
+      ProtocoledDaemonClient* dclient = TakeUploadRequest(upload_id);
+      if (!dclient) {  // client disconnected while uploading
+        return;
+      }
+
+      if (err) {
+        DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+        protocol::response_t resp = fail(id, err->GetDescription());
+        dclient->WriteResponce(resp);
+        return;
+      }
+
+      protocol::response_t resp = success(id);
+      dclient->WriteResponce(resp);
+    });
+  };
+
+  const common::uri::Upath upath = url.GetPath();
+  common::ErrnoError errn = log_uploader_->Post(file, http_server_address, upath.GetPath(), tail_size, done);
+  if (errn) {
+    DEBUG_MSG_ERROR(errn, common::logging::LOG_LEVEL_WARNING);
+    protocol::response_t resp = fail(id, errn->GetDescription());
+    dclient->WriteResponce(resp);
+    return;
+  }
+
+  upload_requests_.push_back({upload_id, dclient});  // done runs in loop thread after this returns
+}
+
+ProtocoledDaemonClient* ProcessSlaveWrapper::TakeUploadRequest(uint64_t upload_id) {
+  CHECK(loop_->IsLoopThread());
+  for (auto it = upload_requests_.begin(); it != upload_requests_.end(); ++it) {
+    if (it->upload_id == upload_id) {
+      ProtocoledDaemonClient* dclient = it->dclient;
+      upload_requests_.erase(it);
+      return dclient;
+    }
+  }
+  return nullptr;
+}
+
 common::ErrnoError ProcessSlaveWrapper::HandleRequestServiceCommand(ProtocoledDaemonClient* dclient,
                                                                     protocol::request_t* req) {
   if (req->method == DAEMON_START_STREAM) {
@@ -1436,14 +2511,22 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestServiceCommand(ProtocoledDa
     return HandleRequestClientStopStream(dclient, req);
   } else if (req->method == DAEMON_RESTART_STREAM) {
     return HandleRequestClientRestartStream(dclient, req);
+  } else if (req->method == DAEMON_RECONFIGURE_STREAM) {
+    return HandleRequestClientReconfigureStream(dclient, req);
   } else if (req->method == DAEMON_GET_LOG_STREAM) {
     return HandleRequestClientGetLogStream(dclient, req);
   } else if (req->method == DAEMON_GET_PIPELINE_STREAM) {
     return HandleRequestClientGetPipelineStream(dclient, req);
+  } else if (req->method == DAEMON_GET_PROFILE_STREAM) {
+    return HandleRequestClientGetProfileStream(dclient, req);
+  } else if (req->method == DAEMON_GET_HISTORY_STREAM) {
+    return HandleRequestClientGetHistoryStream(dclient, req);
   } else if (req->method == DAEMON_PREPARE_SERVICE) {
     return HandleRequestClientPrepareService(dclient, req);
   } else if (req->method == DAEMON_SYNC_SERVICE) {
     return HandleRequestClientSyncService(dclient, req);
+  } else if (req->method == DAEMON_SYNC_SERVICE_DELTA) {
+    return HandleRequestClientSyncServiceDelta(dclient, req);
   } else if (req->method == DAEMON_STOP_SERVICE) {
     return HandleRequestClientStopService(dclient, req);
   } else if (req->method == DAEMON_ACTIVATE) {
@@ -1483,6 +2566,10 @@ common::ErrnoError ProcessSlaveWrapper::HandleRequestStreamsCommand(pipe::Protoc
     return HandleRequestChangedSourcesStream(pclient, req);
   } else if (req->method == STATISTIC_STREAM) {
     return HandleRequestStatisticStream(pclient, req);
+  } else if (req->method == RESTART_SCHEDULE_STREAM) {
+    return HandleRequestRestartScheduleStream(pclient, req);
+  } else if (req->method == STREAM_QUIT_STATUS_STREAM) {
+    return HandleRequestQuitStatusStream(pclient, req);
   }
 
   WARNING_LOG() << "Received unknown command: " << req->method;
@@ -1495,6 +2582,9 @@ common::ErrnoError ProcessSlaveWrapper::HandleResponceStreamsCommand(pipe::Proto
   if (pclient->PopRequestByID(resp->id, &req)) {
     if (req.method == STOP_STREAM) {
     } else if (req.method == RESTART_STREAM) {
+    } else if (req.method == RESUME_STREAM) {
+    } else if (req.method == GET_PROFILE_STREAM) {
+      FinishProfileRequest(*resp->id, *resp);
     } else {
       WARNING_LOG() << "HandleResponceStreamsCommand not handled command: " << req.method;
     }
@@ -1502,6 +2592,39 @@ common::ErrnoError ProcessSlaveWrapper::HandleResponceStreamsCommand(pipe::Proto
   return common::ErrnoError();
 }
 
+size_t ProcessSlaveWrapper::GetVerifiedDaemonClientsCount() const {
+  size_t daemons_client_count = 0;
+  std::vector<common::libev::IoClient*> clients = loop_->GetClients();
+  for (size_t i = 0; i < clients.size(); ++i) {
+    ProtocoledDaemonClient* dclient = dynamic_cast<ProtocoledDaemonClient*>(clients[i]);
+    if (dclient && dclient->IsVerified()) {
+      daemons_client_count++;
+    }
+  }
+  return daemons_client_count;
+}
+
+void ProcessSlaveWrapper::SampleHistory(const StreamStruct& stream) {
+  StreamHistory::Sample sample = {0, 0, stream.status, stream.restarts};
+  for (const ChannelStats& input : stream.input) {
+    sample.input_bps += input.GetBps();
+  }
+  for (const ChannelStats& output : stream.output) {
+    sample.output_bps += output.GetBps();
+  }
+  history_->Append(stream.id, common::time::current_utc_mstime() / 1000, sample);
+}
+
+void ProcessSlaveWrapper::PublishMetrics() {
+  OnlineMetrics online;
+  online.daemon = GetVerifiedDaemonClientsCount();
+  online.http = static_cast<HttpHandler*>(http_handler_)->GetOnlineClients();
+  online.vods = static_cast<HttpHandler*>(vods_handler_)->GetOnlineClients();
+  online.subscribers = static_cast<HttpHandler*>(subscribers_handler_)->GetOnlineClients();
+  metrics_->SetOnline(online);
+  metrics_->Publish(common::time::current_utc_mstime());
+}
+
 std::string ProcessSlaveWrapper::MakeServiceStats(bool full_stat) const {
   utils::CpuShot next = utils::GetMachineCpuShot();
   long double cpu_load = utils::GetCpuMachineLoad(node_stats_->prev, next);
@@ -1523,19 +2646,23 @@ std::string ProcessSlaveWrapper::MakeServiceStats(bool full_stat) const {
   }
   node_stats_->timestamp = current_time;
 
-  size_t daemons_client_count = 0;
-  std::vector<common::libev::IoClient*> clients = loop_->GetClients();
-  for (size_t i = 0; i < clients.size(); ++i) {
-    ProtocoledDaemonClient* dclient = dynamic_cast<ProtocoledDaemonClient*>(clients[i]);
-    if (dclient && dclient->IsVerified()) {
-      daemons_client_count++;
-    }
-  }
-  service::OnlineUsers online(daemons_client_count, static_cast<HttpHandler*>(http_handler_)->GetOnlineClients(),
+  service::OnlineUsers online(GetVerifiedDaemonClientsCount(), static_cast<HttpHandler*>(http_handler_)->GetOnlineClients(),
                               static_cast<HttpHandler*>(vods_handler_)->GetOnlineClients(),
                               static_cast<HttpHandler*>(subscribers_handler_)->GetOnlineClients());
+  const VodsCache::Stats vods_stats = vods_cache_->GetStats();
+  service::VodsStatus vods(vods_stats.absent, vods_stats.in_progress, vods_stats.complete);
+  service::PlacementStatus placement;
+  if (cpu_placement_) {
+    const std::vector<int> cpus_ids = cpu_placement_->GetCpusIds();
+    const std::vector<uint32_t> cpus_load = cpu_placement_->GetCpusLoad();
+    std::vector<service::PlacementStatus::CpuLoad> cpus;
+    for (size_t i = 0; i < cpus_ids.size(); ++i) {
+      cpus.push_back({cpus_ids[i], cpus_load[i]});
+    }
+    placement = service::PlacementStatus(cpu_placement_->GetNodesCount(), cpu_placement_->GetPlacedCount(), cpus);
+  }
   service::ServerInfo stat(cpu_load * 100, node_stats_->gpu_load, uptime_str, mem_shot, hdd_shot, bytes_recv / ts_diff,
-                           bytes_send / ts_diff, sshot, current_time, online);
+                           bytes_send / ts_diff, sshot, current_time, online, vods, placement);
 
   std::string node_stats;
   if (full_stat) {
@@ -16,18 +16,25 @@
 
 #include <map>
 #include <string>
+#include <vector>
 
 #include <common/libev/io_loop_observer.h>
 #include <common/net/types.h>
 
+#include "base/stream_config.h"
 #include "base/types.h"
 #include "protocol/types.h"
-#include "utils/arg_reader.h"
 
 #include "server/base/ihttp_requests_observer.h"
 #include "server/config.h"
+#include "server/daemon/commands_info/service/sync_info.h"
 
 namespace iptv_cloud {
+struct StreamStruct;
+namespace utils {
+class AdoptListener;
+struct AdoptRequest;
+}
 namespace server {
 namespace pipe {
 class ProtocoledPipeClient;
@@ -35,14 +42,33 @@ class ProtocoledPipeClient;
 namespace subscribers {
 class ISubscribeFinder;
 }
+namespace relay {
+class RelayEngine;
+}
+class ChildTable;
+class CpuPlacement;
+class HistoryStore;
+class InputBroker;
+class LogUploader;
+class MetricsRegistry;
+class RestartScheduler;
+class VodsCache;
 
 class Child;
+class ChildStream;
 class ProtocoledDaemonClient;
 
 class ProcessSlaveWrapper : public common::libev::IoLoopObserver, public server::base::IHttpRequestsObserver {
  public:
-  enum { node_stats_send_seconds = 10, ping_timeout_clients_seconds = 60, cleanup_seconds = 3 };
-  typedef utils::ArgsMap serialized_stream_t;
+  enum {
+    node_stats_send_seconds = 10,
+    ping_timeout_clients_seconds = 60,
+    cleanup_seconds = 3,
+    restart_schedule_seconds = 1,
+    metrics_publish_seconds = 1,
+    adopt_check_seconds = 1
+  };
+  typedef StreamConfig serialized_stream_t;
 
   explicit ProcessSlaveWrapper(const std::string& licensy_key, const Config& config);
   ~ProcessSlaveWrapper() override;
@@ -71,6 +97,7 @@ class ProcessSlaveWrapper : public common::libev::IoLoopObserver, public server:
   void PostLooped(common::libev::IoLoop* server) override;
 
   void OnHttpRequest(common::libev::http::HttpClient* client, const file_path_t& file) override;
+  bool IsFileInProgress(const file_path_t& file) const override;
 
   virtual common::ErrnoError HandleRequestServiceCommand(ProtocoledDaemonClient* dclient,
                                                          protocol::request_t* req) WARN_UNUSED_RESULT;
@@ -99,6 +126,33 @@ class ProcessSlaveWrapper : public common::libev::IoLoopObserver, public server:
 
   common::ErrnoError CreateChildStream(const std::string& config);
   common::ErrnoError CreateChildStream(const serialized_stream_t& config_args);
+  void FinishChildStream(ChildStream* channel, int stabled_status, int signal_number);
+
+  // warm restart, streams of previous service instance re-attach by adopt socket
+  void LoadChildTable();
+  void RestoreSharedInputs();
+  void SaveChildTable();
+  void ProcessAdoptRequests();
+  common::ErrnoError AdoptChildStream(utils::AdoptRequest* request) WARN_UNUSED_RESULT;
+  void CheckAdoptedChilds();
+
+  // cpu placement
+  void PlaceChildStream(stream_id_t sid, pid_t pid);
+  common::ErrnoError ReconfigureRelayStream(const serialized_stream_t& config_args) WARN_UNUSED_RESULT;
+
+  // native relay
+  void StopRelayStream(stream_id_t sid);
+  void BroadcastRelayStatistic();
+
+  // restart scheduler
+  void ProcessRestartSchedule();
+
+  // shared inputs
+  void PromoteInputPublisher(const serialized_stream_t& config_args);
+
+  // vods
+  void ProcessVodRequest(const file_path_t& playlist, bool start);
+  void UpdateVodState(stream_id_t sid, bool success);
 
   // stream
   common::ErrnoError HandleRequestChangedSourcesStream(pipe::ProtocoledPipeClient* pclient,
@@ -106,6 +160,10 @@ class ProcessSlaveWrapper : public common::libev::IoLoopObserver, public server:
 
   common::ErrnoError HandleRequestStatisticStream(pipe::ProtocoledPipeClient* pclient,
                                                   protocol::request_t* req) WARN_UNUSED_RESULT;
+  common::ErrnoError HandleRequestRestartScheduleStream(pipe::ProtocoledPipeClient* pclient,
+                                                        protocol::request_t* req) WARN_UNUSED_RESULT;
+  common::ErrnoError HandleRequestQuitStatusStream(pipe::ProtocoledPipeClient* pclient,
+                                                   protocol::request_t* req) WARN_UNUSED_RESULT;
 
   common::ErrnoError HandleRequestClientStartStream(ProtocoledDaemonClient* dclient,
                                                     protocol::request_t* req) WARN_UNUSED_RESULT;
@@ -113,16 +171,24 @@ class ProcessSlaveWrapper : public common::libev::IoLoopObserver, public server:
                                                    protocol::request_t* req) WARN_UNUSED_RESULT;
   common::ErrnoError HandleRequestClientRestartStream(ProtocoledDaemonClient* dclient,
                                                       protocol::request_t* req) WARN_UNUSED_RESULT;
+  common::ErrnoError HandleRequestClientReconfigureStream(ProtocoledDaemonClient* dclient,
+                                                          protocol::request_t* req) WARN_UNUSED_RESULT;
   common::ErrnoError HandleRequestClientGetLogStream(ProtocoledDaemonClient* dclient,
                                                      protocol::request_t* req) WARN_UNUSED_RESULT;
   common::ErrnoError HandleRequestClientGetPipelineStream(ProtocoledDaemonClient* dclient,
                                                           protocol::request_t* req) WARN_UNUSED_RESULT;
+  common::ErrnoError HandleRequestClientGetProfileStream(ProtocoledDaemonClient* dclient,
+                                                         protocol::request_t* req) WARN_UNUSED_RESULT;
+  common::ErrnoError HandleRequestClientGetHistoryStream(ProtocoledDaemonClient* dclient,
+                                                         protocol::request_t* req) WARN_UNUSED_RESULT;
 
   // service
   common::ErrnoError HandleRequestClientPrepareService(ProtocoledDaemonClient* dclient,
                                                        protocol::request_t* req) WARN_UNUSED_RESULT;
   common::ErrnoError HandleRequestClientSyncService(ProtocoledDaemonClient* dclient,
                                                     protocol::request_t* req) WARN_UNUSED_RESULT;
+  common::ErrnoError HandleRequestClientSyncServiceDelta(ProtocoledDaemonClient* dclient,
+                                                         protocol::request_t* req) WARN_UNUSED_RESULT;
   common::ErrnoError HandleRequestClientActivate(ProtocoledDaemonClient* dclient,
                                                  protocol::request_t* req) WARN_UNUSED_RESULT;
   common::ErrnoError HandleRequestClientPingService(ProtocoledDaemonClient* dclient,
@@ -132,11 +198,45 @@ class ProcessSlaveWrapper : public common::libev::IoLoopObserver, public server:
   common::ErrnoError HandleRequestClientStopService(ProtocoledDaemonClient* dclient,
                                                     protocol::request_t* req) WARN_UNUSED_RESULT;
 
+  // upload done in LogUploader workers, responce written to dclient when finished
+  typedef protocol::response_t (*upload_success_responce_t)(protocol::sequance_id_t id);
+  typedef protocol::response_t (*upload_fail_responce_t)(protocol::sequance_id_t id, const std::string& error_text);
+  void PostLogFile(ProtocoledDaemonClient* dclient,
+                   protocol::sequance_id_t id,
+                   const common::file_system::ascii_file_string_path& file,
+                   const common::uri::Url& url,
+                   size_t tail_size,
+                   upload_success_responce_t success,
+                   upload_fail_responce_t fail);
+
+  // client waiting for upload, forgotten when it closes
+  struct UploadRequest {
+    uint64_t upload_id;
+    ProtocoledDaemonClient* dclient;
+  };
+  ProtocoledDaemonClient* TakeUploadRequest(uint64_t upload_id);  // nullptr if client closed
+
   common::ErrnoError HandleResponcePingService(ProtocoledDaemonClient* dclient,
                                                protocol::response_t* resp) WARN_UNUSED_RESULT;
 
+  // profile collected by child, responce forwarded to dclient
+  struct ProfileRequest {
+    std::string pipe_request_id;
+    stream_id_t sid;
+    ProtocoledDaemonClient* dclient;
+    protocol::sequance_id_t id;
+  };
+  void FinishProfileRequest(const std::string& pipe_request_id, const protocol::response_t& child_resp);
+  void FailProfileRequests(const stream_id_t& sid, const std::string& error_text);
+
+  size_t GetVerifiedDaemonClientsCount() const;
   std::string MakeServiceStats(bool full_stat) const;
+  void PublishMetrics();
+  void SampleHistory(const StreamStruct& stream);
   void AddStreamLine(const std::string& config);
+  void AddStreamLine(serialized_stream_t config_args);
+  void UpdateStreamLine(const std::string& config);
+  void RemoveStreamLine(const stream_id_t& sid);
 
   struct NodeStats;
 
@@ -159,11 +259,29 @@ class ProcessSlaveWrapper : public common::libev::IoLoopObserver, public server:
   common::libev::timer_id_t node_stats_timer_;
   common::libev::timer_id_t cleanup_files_timer_;
   common::libev::timer_id_t quit_cleanup_timer_;
+  common::libev::timer_id_t restart_schedule_timer_;
+  common::libev::timer_id_t metrics_timer_;
+  common::libev::timer_id_t adopt_timer_;
   NodeStats* node_stats_;
   stream_exec_t stream_exec_func_;
 
-  std::map<common::file_system::ascii_directory_string_path, serialized_stream_t> vods_links_;
+  VodsCache* vods_cache_;
   subscribers::ISubscribeFinder* finder_;
+  service::sync_version_t sync_version_;  // last applied SyncInfo/SyncDeltaInfo version
+  relay::RelayEngine* relay_engine_;
+  RestartScheduler* restart_scheduler_;
+  LogUploader* log_uploader_;
+  MetricsRegistry* metrics_;
+  HistoryStore* history_;
+  InputBroker* input_broker_;  // nullptr if inputs not shared
+  CpuPlacement* cpu_placement_;  // nullptr if placement disabled
+  ChildTable* child_table_;
+  utils::AdoptListener* adopt_listener_;
+  fastotv::timestamp_t adopt_deadline_;  // streams of previous instance not adopted till are forgotten, 0 - none
+  std::map<stream_id_t, serialized_stream_t> adopt_promotions_;  // readers promoted before their adoption
+  std::vector<ProfileRequest> profile_requests_;
+  std::vector<UploadRequest> upload_requests_;
+  uint64_t next_upload_id_;
 };
 
 }  // namespace server
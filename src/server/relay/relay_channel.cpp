@@ -0,0 +1,339 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/relay/relay_channel.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <limits>
+#include <string>
+
+#include <common/sprintf.h>
+
+namespace {
+const int kInputBufferSize = 4 * 1024 * 1024;
+const int kMulticastTTL = 16;
+
+common::ErrnoError ResolveHost(const common::net::HostAndPort& host, struct sockaddr_in* out) {
+  struct addrinfo hints;
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_DGRAM;
+
+  struct addrinfo* result = nullptr;
+  const std::string port_str = common::ConvertToString(host.GetPort());
+  int res = getaddrinfo(host.GetHost().c_str(), port_str.c_str(), &hints, &result);
+  if (res != 0 || !result) {
+    return common::make_errno_error(common::MemSPrintf("Can't resolve host: %s", host.GetHost()), EINVAL);
+  }
+
+  memcpy(out, result->ai_addr, sizeof(struct sockaddr_in));
+  freeaddrinfo(result);
+  return common::ErrnoError();
+}
+
+bool IsMulticast(const struct sockaddr_in& addr) {
+  return IN_MULTICAST(ntohl(addr.sin_addr.s_addr));
+}
+
+void CloseSocket(int* fd) {
+  if (*fd != INVALID_DESCRIPTOR) {
+    close(*fd);
+    *fd = INVALID_DESCRIPTOR;
+  }
+}
+
+common::ErrnoError OpenInputSocket(const common::net::HostAndPort& host, int* out) {
+  struct sockaddr_in addr;
+  common::ErrnoError err = ResolveHost(host, &addr);
+  if (err) {
+    return err;
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  int reuse = 1;
+  setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &kInputBufferSize, sizeof(kInputBufferSize));
+
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == ERROR_RESULT_VALUE) {
+    common::ErrnoError err = common::make_errno_error(errno);
+    close(fd);
+    return err;
+  }
+
+  if (IsMulticast(addr)) {
+    struct ip_mreq mreq;
+    mreq.imr_multiaddr = addr.sin_addr;
+    mreq.imr_interface.s_addr = htonl(INADDR_ANY);
+    if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) == ERROR_RESULT_VALUE) {
+      common::ErrnoError err = common::make_errno_error(errno);
+      close(fd);
+      return err;
+    }
+  }
+
+  *out = fd;
+  return common::ErrnoError();
+}
+
+common::ErrnoError OpenOutputSocket(const common::net::HostAndPort& host, int* out) {
+  struct sockaddr_in addr;
+  common::ErrnoError err = ResolveHost(host, &addr);
+  if (err) {
+    return err;
+  }
+
+  int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  if (IsMulticast(addr)) {
+    setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &kMulticastTTL, sizeof(kMulticastTTL));
+  }
+
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == ERROR_RESULT_VALUE) {
+    common::ErrnoError err = common::make_errno_error(errno);
+    close(fd);
+    return err;
+  }
+
+  *out = fd;
+  return common::ErrnoError();
+}
+}  // namespace
+
+namespace iptv_cloud {
+namespace server {
+namespace relay {
+
+RelayChannel::Counters::Counters(size_t outputs_count)
+    : input_bytes(0), input_packets(0), cc_errors(0), output_bytes(outputs_count), dropped(outputs_count) {}
+
+RelayChannel::RelayChannel(const StreamInfo& info,
+                           const common::net::HostAndPort& input,
+                           const std::vector<Output>& outputs,
+                           const std::shared_ptr<Counters>& counters)
+    : info_(info),
+      input_(input),
+      outputs_(outputs),
+      input_fd_(INVALID_DESCRIPTOR),
+      output_fds_(),
+      slots_(),
+      head_(0),
+      count_(0),
+      msgs_(),
+      iovs_(),
+      cc_checker_(),
+      pacer_(),
+      pcr_pid_(-1),
+      last_send_time_(0),
+      counters_(counters) {}
+
+RelayChannel::~RelayChannel() {
+  Close();
+}
+
+common::ErrnoError RelayChannel::Open(bool open_input) {
+  if (open_input) {
+    common::ErrnoError err = OpenInputSocket(input_, &input_fd_);
+    if (err) {
+      return err;
+    }
+  }
+
+  for (const Output& out : outputs_) {
+    int fd = INVALID_DESCRIPTOR;
+    common::ErrnoError err = OpenOutputSocket(out.host, &fd);
+    if (err) {
+      Close();
+      return err;
+    }
+    output_fds_.push_back(fd);
+  }
+
+  return common::ErrnoError();
+}
+
+void RelayChannel::Close() {
+  CloseSocket(&input_fd_);
+  for (int& fd : output_fds_) {
+    CloseSocket(&fd);
+  }
+  output_fds_.clear();
+}
+
+stream_id_t RelayChannel::GetStreamID() const {
+  return info_.id;
+}
+
+const StreamInfo& RelayChannel::GetStreamInfo() const {
+  return info_;
+}
+
+const common::net::HostAndPort& RelayChannel::GetInput() const {
+  return input_;
+}
+
+int RelayChannel::GetFd() const {
+  return input_fd_;
+}
+
+common::ErrnoError RelayChannel::ReadBatch(int64_t now_usec) {
+  for (size_t batch = 0; batch < MAX_BATCHES_PER_READ; ++batch) {
+    if (head_ + count_ == SLOTS_COUNT) {
+      if (head_ == 0) {  // queue full, send without pacing
+        Flush(std::numeric_limits<int64_t>::max());
+      } else {
+        memmove(slots_, slots_ + head_, sizeof(Slot) * count_);
+        head_ = 0;
+      }
+    }
+
+    const size_t free_pos = head_ + count_;
+    const size_t can_read = std::min<size_t>(BATCH_SIZE, SLOTS_COUNT - free_pos);
+    for (size_t i = 0; i < can_read; ++i) {
+      iovs_[i].iov_base = slots_[free_pos + i].data;
+      iovs_[i].iov_len = MAX_DATAGRAM_SIZE;
+      memset(&msgs_[i], 0, sizeof(struct mmsghdr));
+      msgs_[i].msg_hdr.msg_iov = &iovs_[i];
+      msgs_[i].msg_hdr.msg_iovlen = 1;
+    }
+
+    int received = recvmmsg(input_fd_, msgs_, can_read, MSG_DONTWAIT, nullptr);
+    if (received == ERROR_RESULT_VALUE) {
+      if (errno == EAGAIN || errno == EWOULDBLOCK) {
+        return common::ErrnoError();
+      }
+      return common::make_errno_error(errno);
+    }
+
+    for (int i = 0; i < received; ++i) {
+      Slot* slot = &slots_[free_pos + i];
+      slot->size = msgs_[i].msg_len;
+      slot->send_time = Analyze(slot, now_usec);
+      counters_->input_bytes += slot->size;
+    }
+    count_ += received;
+
+    if (static_cast<size_t>(received) < can_read) {
+      return common::ErrnoError();
+    }
+  }
+
+  return common::ErrnoError();  // level triggered, rest will be read on next wakeup
+}
+
+int64_t RelayChannel::Analyze(Slot* slot, int64_t now_usec) {
+  // skip rtp header if present
+  const size_t offset = slot->size % utils::mpegts::TS_PACKET_SIZE;
+  int64_t send_time = last_send_time_;
+  counters_->input_packets += (slot->size - offset) / utils::mpegts::TS_PACKET_SIZE;
+  for (size_t pos = offset; pos + utils::mpegts::TS_PACKET_SIZE <= slot->size;
+       pos += utils::mpegts::TS_PACKET_SIZE) {
+    const uint8_t* packet = slot->data + pos;
+    if (!cc_checker_.CheckPacket(packet)) {
+      counters_->cc_errors++;
+    }
+
+    uint64_t pcr;
+    if (!utils::mpegts::GetPcr(packet, &pcr)) {
+      continue;
+    }
+
+    const int pid = utils::mpegts::GetPid(packet);
+    if (pcr_pid_ == -1) {
+      pcr_pid_ = pid;
+    }
+    if (pid == pcr_pid_) {
+      send_time = pacer_.GetSendTime(pcr, now_usec);
+    }
+  }
+
+  if (!pacer_.IsLocked() || send_time < last_send_time_) {  // no pcr yet, or keep order
+    send_time = std::max(now_usec, last_send_time_);
+  }
+  last_send_time_ = send_time;
+  return send_time;
+}
+
+int64_t RelayChannel::Flush(int64_t now_usec) {
+  size_t due = 0;
+  while (due < count_ && slots_[head_ + due].send_time <= now_usec) {
+    due++;
+  }
+
+  if (due) {
+    Send(due);
+    head_ += due;
+    count_ -= due;
+  }
+
+  if (count_ == 0) {
+    head_ = 0;
+    return -1;
+  }
+
+  return slots_[head_].send_time;
+}
+
+void RelayChannel::Send(size_t count) {
+  for (size_t i = 0; i < count; ++i) {
+    Slot* slot = &slots_[head_ + i];
+    iovs_[i].iov_base = slot->data;
+    iovs_[i].iov_len = slot->size;
+    memset(&msgs_[i], 0, sizeof(struct mmsghdr));
+    msgs_[i].msg_hdr.msg_iov = &iovs_[i];
+    msgs_[i].msg_hdr.msg_iovlen = 1;
+  }
+
+  for (size_t i = 0; i < output_fds_.size(); ++i) {
+    size_t sent = 0;
+    while (sent < count) {
+      int res = sendmmsg(output_fds_[i], msgs_ + sent, count - sent, MSG_DONTWAIT);
+      if (res == ERROR_RESULT_VALUE || res == 0) {
+        counters_->dropped[i] += count - sent;  // udp, don't block worker
+        break;
+      }
+
+      for (int j = 0; j < res; ++j) {
+        counters_->output_bytes[i] += msgs_[sent + j].msg_len;
+      }
+      sent += res;
+    }
+  }
+}
+
+void RelayChannel::TakeInput(RelayChannel* replaced) {
+  if (input_fd_ != INVALID_DESCRIPTOR || !replaced) {
+    return;
+  }
+
+  input_fd_ = replaced->input_fd_;
+  replaced->input_fd_ = INVALID_DESCRIPTOR;
+}
+
+}  // namespace relay
+}  // namespace server
+}  // namespace iptv_cloud
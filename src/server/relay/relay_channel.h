@@ -0,0 +1,113 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <sys/socket.h>
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <common/error.h>
+#include <common/net/types.h>
+
+#include "base/stream_struct.h"
+
+#include "utils/mpegts.h"
+
+namespace iptv_cloud {
+namespace server {
+namespace relay {
+
+// udp(ts) input -> udp(ts) outputs, lives in worker thread
+class RelayChannel {
+ public:
+  enum { MAX_DATAGRAM_SIZE = 1500, BATCH_SIZE = 32, SLOTS_COUNT = BATCH_SIZE * 2, MAX_BATCHES_PER_READ = 4 };
+
+  struct Output {
+    channel_id_t id;
+    common::net::HostAndPort host;
+  };
+
+  // totals of stream, shared by channels which replace each other on restart, read by any thread
+  struct Counters {
+    explicit Counters(size_t outputs_count);
+
+    std::atomic<uint64_t> input_bytes;
+    std::atomic<uint64_t> input_packets;
+    std::atomic<uint64_t> cc_errors;
+    std::vector<std::atomic<uint64_t>> output_bytes;
+    std::vector<std::atomic<uint64_t>> dropped;  // datagrams not sent to output
+  };
+
+  RelayChannel(const StreamInfo& info,
+               const common::net::HostAndPort& input,
+               const std::vector<Output>& outputs,
+               const std::shared_ptr<Counters>& counters);
+  ~RelayChannel();
+
+  // without input socket channel takes it from replaced one, see TakeInput
+  common::ErrnoError Open(bool open_input = true) WARN_UNUSED_RESULT;
+  void Close();
+
+  stream_id_t GetStreamID() const;
+  const StreamInfo& GetStreamInfo() const;
+  const common::net::HostAndPort& GetInput() const;
+  int GetFd() const;
+
+  // worker thread
+  common::ErrnoError ReadBatch(int64_t now_usec) WARN_UNUSED_RESULT;
+  // returns time of next not sent datagram or -1 if queue is empty
+  int64_t Flush(int64_t now_usec);
+  // datagrams queued in socket of replaced channel are read by this one
+  void TakeInput(RelayChannel* replaced);
+
+ private:
+  struct Slot {
+    uint8_t data[MAX_DATAGRAM_SIZE];
+    size_t size;
+    int64_t send_time;
+  };
+
+  int64_t Analyze(Slot* slot, int64_t now_usec);
+  void Send(size_t count);
+
+  const StreamInfo info_;
+  const common::net::HostAndPort input_;
+  const std::vector<Output> outputs_;
+
+  int input_fd_;
+  std::vector<int> output_fds_;
+
+  Slot slots_[SLOTS_COUNT];
+  size_t head_;
+  size_t count_;
+  struct mmsghdr msgs_[SLOTS_COUNT];
+  struct iovec iovs_[SLOTS_COUNT];
+
+  utils::mpegts::ContinuityChecker cc_checker_;
+  utils::mpegts::PcrPacer pacer_;
+  int pcr_pid_;
+  int64_t last_send_time_;
+
+  const std::shared_ptr<Counters> counters_;
+
+  DISALLOW_COPY_AND_ASSIGN(RelayChannel);
+};
+
+}  // namespace relay
+}  // namespace server
+}  // namespace iptv_cloud
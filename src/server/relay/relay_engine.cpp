@@ -0,0 +1,513 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/relay/relay_engine.h"
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <set>
+#include <string>
+#include <thread>
+#include <utility>
+
+#include <common/sprintf.h>
+#include <common/time.h>
+
+#include "server/relay/relay_channel.h"
+
+namespace {
+const int kMaxEvents = 256;
+const int kIdleTimeoutMsec = 100;
+
+int64_t GetMonotonicUsec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<int64_t>(ts.tv_sec) * 1000000 + ts.tv_nsec / 1000;
+}
+
+bool GetUdpHost(const common::uri::Url& url, common::net::HostAndPort* host) {
+  if (url.GetScheme() != common::uri::Url::udp) {
+    return false;
+  }
+
+  return common::ConvertFromString(url.GetHost(), host);
+}
+}  // namespace
+
+namespace iptv_cloud {
+namespace server {
+namespace relay {
+
+class RelayEngine::Worker {
+ public:
+  Worker()
+      : epoll_fd_(INVALID_DESCRIPTOR),
+        event_fd_(INVALID_DESCRIPTOR),
+        thread_(),
+        stop_(false),
+        commands_mutex_(),
+        commands_(),
+        channels_(),
+        pending_(),
+        channels_count_(0) {}
+
+  ~Worker() {
+    Stop();
+    std::set<RelayChannel*> owned(channels_);
+    for (auto command : commands_) {
+      owned.insert(command.first);
+      owned.insert(command.second);
+    }
+    owned.erase(nullptr);
+    for (RelayChannel* channel : owned) {
+      delete channel;
+    }
+    channels_.clear();
+    commands_.clear();
+  }
+
+  common::ErrnoError Start() WARN_UNUSED_RESULT {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ == INVALID_DESCRIPTOR) {
+      return common::make_errno_error(errno);
+    }
+
+    event_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (event_fd_ == INVALID_DESCRIPTOR) {
+      return common::make_errno_error(errno);
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = nullptr;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, event_fd_, &ev) == ERROR_RESULT_VALUE) {
+      return common::make_errno_error(errno);
+    }
+
+    thread_ = std::thread([this] { Run(); });
+    return common::ErrnoError();
+  }
+
+  void Stop() {
+    if (thread_.joinable()) {
+      stop_ = true;
+      Wakeup();
+      thread_.join();
+    }
+
+    if (event_fd_ != INVALID_DESCRIPTOR) {
+      close(event_fd_);
+      event_fd_ = INVALID_DESCRIPTOR;
+    }
+    if (epoll_fd_ != INVALID_DESCRIPTOR) {
+      close(epoll_fd_);
+      epoll_fd_ = INVALID_DESCRIPTOR;
+    }
+  }
+
+  void Add(RelayChannel* channel) { PostCommand(channel, nullptr); }
+
+  // channel deleted in worker thread
+  void Remove(RelayChannel* channel) { PostCommand(nullptr, channel); }
+
+  // queued datagrams of old channel are sent before it is deleted, input socket is handed over to new one
+  void Replace(RelayChannel* old_channel, RelayChannel* new_channel) { PostCommand(new_channel, old_channel); }
+
+  size_t GetChannelsCount() const { return channels_count_; }
+
+ private:
+  void PostCommand(RelayChannel* added, RelayChannel* removed) {
+    {
+      std::unique_lock<std::mutex> lock(commands_mutex_);
+      commands_.push_back(std::make_pair(added, removed));
+    }
+    if (added) {
+      channels_count_++;
+    }
+    if (removed) {
+      channels_count_--;
+    }
+    Wakeup();
+  }
+
+  void Wakeup() {
+    uint64_t value = 1;
+    ssize_t res = write(event_fd_, &value, sizeof(value));
+    UNUSED(res);
+  }
+
+  void ProcessCommands() {
+    uint64_t value;
+    ssize_t res = read(event_fd_, &value, sizeof(value));
+    UNUSED(res);
+
+    std::vector<std::pair<RelayChannel*, RelayChannel*>> commands;
+    {
+      std::unique_lock<std::mutex> lock(commands_mutex_);
+      commands.swap(commands_);
+    }
+
+    for (auto command : commands) {
+      RelayChannel* added = command.first;
+      RelayChannel* removed = command.second;
+      if (removed) {
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, removed->GetFd(), nullptr);
+        pending_.erase(removed);
+        channels_.erase(removed);
+        if (added) {
+          removed->Flush(std::numeric_limits<int64_t>::max());
+          added->TakeInput(removed);
+        }
+        delete removed;
+      }
+
+      if (added) {
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = added;
+        if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, added->GetFd(), &ev) == ERROR_RESULT_VALUE) {
+          WARNING_LOG() << "Relay stream id: " << added->GetStreamID()
+                        << ", failed to watch input: " << common::common_strerror(errno);
+        }
+        channels_.insert(added);
+      }
+    }
+  }
+
+  void Run() {
+    struct epoll_event events[kMaxEvents];
+    int64_t next_send_time = -1;
+    while (!stop_) {
+      int timeout = kIdleTimeoutMsec;
+      if (next_send_time != -1) {
+        const int64_t wait_usec = next_send_time - GetMonotonicUsec();
+        timeout = wait_usec <= 0 ? 0 : std::min<int64_t>((wait_usec + 999) / 1000, kIdleTimeoutMsec);
+      }
+
+      int count = epoll_wait(epoll_fd_, events, kMaxEvents, timeout);
+      if (count == ERROR_RESULT_VALUE) {
+        if (errno == EINTR) {
+          continue;
+        }
+        ERROR_LOG() << "Relay worker epoll failed: " << common::common_strerror(errno);
+        return;
+      }
+
+      const int64_t now = GetMonotonicUsec();
+      for (int i = 0; i < count; ++i) {
+        RelayChannel* channel = static_cast<RelayChannel*>(events[i].data.ptr);
+        if (!channel) {
+          ProcessCommands();
+          continue;
+        }
+
+        common::ErrnoError err = channel->ReadBatch(now);
+        if (err) {
+          DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+        }
+        pending_.insert(channel);
+      }
+
+      next_send_time = -1;
+      for (auto it = pending_.begin(); it != pending_.end();) {
+        const int64_t send_time = (*it)->Flush(now);
+        if (send_time == -1) {
+          it = pending_.erase(it);
+          continue;
+        }
+
+        if (next_send_time == -1 || send_time < next_send_time) {
+          next_send_time = send_time;
+        }
+        ++it;
+      }
+    }
+  }
+
+  int epoll_fd_;
+  int event_fd_;
+  std::thread thread_;
+  std::atomic<bool> stop_;
+
+  std::mutex commands_mutex_;
+  std::vector<std::pair<RelayChannel*, RelayChannel*>> commands_;  // added, removed
+
+  std::set<RelayChannel*> channels_;
+  std::set<RelayChannel*> pending_;  // channels with not sent data
+  std::atomic<size_t> channels_count_;
+
+  DISALLOW_COPY_AND_ASSIGN(Worker);
+};
+
+RelayEngine::RelayEngine(size_t workers_count)
+    : workers_count_(workers_count ? workers_count : DEFAULT_WORKERS_COUNT), workers_(), channels_mutex_(), channels_() {}
+
+RelayEngine::~RelayEngine() {
+  Stop();
+}
+
+bool RelayEngine::IsSupported(const input_t& input, const output_t& output) {
+  if (input.size() != 1 || output.empty()) {
+    return false;
+  }
+
+  common::net::HostAndPort host;
+  if (!GetUdpHost(input[0].GetInput(), &host)) {
+    return false;
+  }
+
+  for (const OutputUri& out : output) {
+    if (!GetUdpHost(out.GetOutput(), &host)) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+common::ErrnoError RelayEngine::Start() {
+  for (size_t i = 0; i < workers_count_; ++i) {
+    Worker* worker = new Worker;
+    common::ErrnoError err = worker->Start();
+    if (err) {
+      delete worker;
+      Stop();
+      return err;
+    }
+    workers_.push_back(worker);
+  }
+
+  return common::ErrnoError();
+}
+
+void RelayEngine::Stop() {
+  for (Worker* worker : workers_) {
+    worker->Stop();
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(channels_mutex_);
+    channels_.clear();
+  }
+
+  for (Worker* worker : workers_) {
+    delete worker;
+  }
+  workers_.clear();
+}
+
+bool RelayEngine::IsRelaying(stream_id_t sid) const {
+  std::unique_lock<std::mutex> lock(channels_mutex_);
+  return channels_.find(sid) != channels_.end();
+}
+
+size_t RelayEngine::GetChannelsCount() const {
+  std::unique_lock<std::mutex> lock(channels_mutex_);
+  return channels_.size();
+}
+
+std::vector<stream_id_t> RelayEngine::GetStreamsIDs() const {
+  std::vector<stream_id_t> result;
+  std::unique_lock<std::mutex> lock(channels_mutex_);
+  for (auto it = channels_.begin(); it != channels_.end(); ++it) {
+    result.push_back(it->first);
+  }
+  return result;
+}
+
+common::ErrnoError RelayEngine::AddStream(const StreamInfo& info, const input_t& input, const output_t& output) {
+  if (workers_.empty()) {
+    return common::make_errno_error("Relay engine not started.", EINVAL);
+  }
+
+  if (IsRelaying(info.id)) {
+    return common::make_errno_error(common::MemSPrintf("Stream with id: %s exist, skip request.", info.id), EINVAL);
+  }
+
+  auto counters = std::make_shared<RelayChannel::Counters>(output.size());
+  RelayChannel* channel = nullptr;
+  common::ErrnoError err = CreateChannel(info, input, output, counters, nullptr, &channel);
+  if (err) {
+    return err;
+  }
+
+  Worker* worker = SelectWorker();
+  StreamStruct stats(info);
+  stats.loop_start_time = stats.start_time;
+  stats.status = STARTED;
+  {
+    std::unique_lock<std::mutex> lock(channels_mutex_);
+    channels_[info.id] = {channel, worker, input, output, stats, counters};
+  }
+  worker->Add(channel);
+  return common::ErrnoError();
+}
+
+common::ErrnoError RelayEngine::RemoveStream(stream_id_t sid) {
+  Entry entry;
+  {
+    std::unique_lock<std::mutex> lock(channels_mutex_);
+    auto it = channels_.find(sid);
+    if (it == channels_.end()) {
+      return common::make_errno_error("Stream not found.", EINVAL);
+    }
+
+    entry = it->second;
+    channels_.erase(it);
+  }
+
+  entry.worker->Remove(entry.channel);
+  return common::ErrnoError();
+}
+
+common::ErrnoError RelayEngine::RestartStream(stream_id_t sid) {
+  std::unique_lock<std::mutex> lock(channels_mutex_);
+  auto it = channels_.find(sid);
+  if (it == channels_.end()) {
+    return common::make_errno_error("Stream not found.", EINVAL);
+  }
+
+  Entry* entry = &it->second;
+  StreamInfo info;
+  info.id = entry->stats.id;
+  info.type = entry->stats.type;
+  for (const InputUri& in : entry->input) {
+    info.input.push_back(in.GetID());
+  }
+  for (const OutputUri& out : entry->output) {
+    info.output.push_back(out.GetID());
+  }
+
+  RelayChannel* channel = nullptr;
+  common::ErrnoError err =
+      CreateChannel(info, entry->input, entry->output, entry->counters, entry->channel, &channel);
+  if (err) {
+    entry->worker->Remove(entry->channel);
+    channels_.erase(it);
+    return err;
+  }
+
+  entry->worker->Replace(entry->channel, channel);
+  entry->channel = channel;
+  entry->stats.restarts++;
+  entry->stats.loop_start_time = common::time::current_utc_mstime();
+  entry->stats.status = STARTED;
+  return common::ErrnoError();
+}
+
+common::ErrnoError RelayEngine::ReconfigureStream(const StreamInfo& info,
+                                                  const input_t& input,
+                                                  const output_t& output) {
+  std::unique_lock<std::mutex> lock(channels_mutex_);
+  auto it = channels_.find(info.id);
+  if (it == channels_.end()) {
+    return common::make_errno_error("Stream not found.", EINVAL);
+  }
+
+  Entry* entry = &it->second;
+  auto counters = std::make_shared<RelayChannel::Counters>(output.size());
+  RelayChannel* channel = nullptr;
+  common::ErrnoError err = CreateChannel(info, input, output, counters, entry->channel, &channel);
+  if (err) {
+    return err;
+  }
+
+  StreamStruct stats(info);
+  stats.loop_start_time = stats.start_time;
+  stats.status = STARTED;
+  entry->worker->Replace(entry->channel, channel);
+  *entry = {channel, entry->worker, input, output, stats, counters};
+  return common::ErrnoError();
+}
+
+std::vector<StreamStruct> RelayEngine::CollectStatistic(time_t elapsed_sec) {
+  std::vector<StreamStruct> result;
+  std::unique_lock<std::mutex> lock(channels_mutex_);
+  for (auto it = channels_.begin(); it != channels_.end(); ++it) {
+    Entry* entry = &it->second;
+    StreamStruct* stats = &entry->stats;
+    const RelayChannel::Counters* counters = entry->counters.get();
+    for (size_t i = 0; i < stats->input.size(); ++i) {
+      utils::mpegts::TsQuality quality = stats->input[i].GetTsQuality();
+      quality.packets = counters->input_packets;
+      quality.cc_errors = counters->cc_errors;
+      stats->input[i].SetTsQuality(quality);
+      stats->input[i].SetTotalBytes(counters->input_bytes);
+      stats->input[i].UpdateBps(elapsed_sec);
+    }
+    for (size_t i = 0; i < stats->output.size() && i < counters->output_bytes.size(); ++i) {
+      stats->output[i].SetDropped(counters->dropped[i]);
+      stats->output[i].SetTotalBytes(counters->output_bytes[i]);
+      stats->output[i].UpdateBps(elapsed_sec);
+    }
+
+    bool have_data = !stats->input.empty() && stats->input[0].GetDiffTotalBytes() != 0;
+    stats->status = have_data ? PLAYING : WAITING;
+    stats->ResetDataWait();
+    result.push_back(*stats);
+  }
+  return result;
+}
+
+common::ErrnoError RelayEngine::CreateChannel(const StreamInfo& info,
+                                              const input_t& input,
+                                              const output_t& output,
+                                              const std::shared_ptr<RelayChannel::Counters>& counters,
+                                              const RelayChannel* replaced,
+                                              RelayChannel** channel) {
+  if (!IsSupported(input, output)) {
+    return common::make_errno_error("Only udp input and outputs supported by relay engine.", EINVAL);
+  }
+
+  common::net::HostAndPort input_host;
+  GetUdpHost(input[0].GetInput(), &input_host);
+  std::vector<RelayChannel::Output> outputs;
+  for (const OutputUri& out : output) {
+    RelayChannel::Output rout;
+    rout.id = out.GetID();
+    GetUdpHost(out.GetOutput(), &rout.host);
+    outputs.push_back(rout);
+  }
+
+  const bool same_input = replaced && replaced->GetInput() == input_host;
+  RelayChannel* lchannel = new RelayChannel(info, input_host, outputs, counters);
+  common::ErrnoError err = lchannel->Open(!same_input);
+  if (err) {
+    delete lchannel;
+    return err;
+  }
+
+  *channel = lchannel;
+  return common::ErrnoError();
+}
+
+RelayEngine::Worker* RelayEngine::SelectWorker() const {
+  Worker* result = workers_[0];
+  for (Worker* worker : workers_) {
+    if (worker->GetChannelsCount() < result->GetChannelsCount()) {
+      result = worker;
+    }
+  }
+  return result;
+}
+
+}  // namespace relay
+}  // namespace server
+}  // namespace iptv_cloud
@@ -0,0 +1,93 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <common/error.h>
+
+#include "base/inputs_outputs.h"
+#include "base/stream_struct.h"
+
+#include "server/relay/relay_channel.h"
+
+namespace iptv_cloud {
+namespace server {
+namespace relay {
+
+// relays udp ts streams inside service process, without gstreamer pipelines
+class RelayEngine {
+ public:
+  enum { DEFAULT_WORKERS_COUNT = 4 };
+
+  explicit RelayEngine(size_t workers_count);
+  ~RelayEngine();
+
+  static bool IsSupported(const input_t& input, const output_t& output);
+
+  common::ErrnoError Start() WARN_UNUSED_RESULT;
+  void Stop();
+
+  bool IsRelaying(stream_id_t sid) const;
+  size_t GetChannelsCount() const;
+  std::vector<stream_id_t> GetStreamsIDs() const;
+
+  common::ErrnoError AddStream(const StreamInfo& info, const input_t& input, const output_t& output)
+      WARN_UNUSED_RESULT;
+  common::ErrnoError RemoveStream(stream_id_t sid) WARN_UNUSED_RESULT;
+  common::ErrnoError RestartStream(stream_id_t sid) WARN_UNUSED_RESULT;
+  // replaces channel in place, statistic starts from zero as for new stream
+  common::ErrnoError ReconfigureStream(const StreamInfo& info, const input_t& input, const output_t& output)
+      WARN_UNUSED_RESULT;
+
+  // updates ChannelStats of relayed streams, elapsed_sec since previous call
+  std::vector<StreamStruct> CollectStatistic(time_t elapsed_sec);
+
+ private:
+  class Worker;
+
+  struct Entry {
+    RelayChannel* channel;
+    Worker* worker;
+    input_t input;
+    output_t output;
+    StreamStruct stats;
+    std::shared_ptr<RelayChannel::Counters> counters;  // kept by restarts
+  };
+
+  // replaced channel with same input hands its socket over to new one
+  common::ErrnoError CreateChannel(const StreamInfo& info,
+                                   const input_t& input,
+                                   const output_t& output,
+                                   const std::shared_ptr<RelayChannel::Counters>& counters,
+                                   const RelayChannel* replaced,
+                                   RelayChannel** channel) WARN_UNUSED_RESULT;
+  Worker* SelectWorker() const;
+
+  const size_t workers_count_;
+  std::vector<Worker*> workers_;
+
+  mutable std::mutex channels_mutex_;
+  std::map<stream_id_t, Entry> channels_;
+
+  DISALLOW_COPY_AND_ASSIGN(RelayEngine);
+};
+
+}  // namespace relay
+}  // namespace server
+}  // namespace iptv_cloud
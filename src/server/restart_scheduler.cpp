@@ -0,0 +1,226 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/restart_scheduler.h"
+
+#include <algorithm>
+
+namespace iptv_cloud {
+namespace server {
+
+RestartScheduler::RestartScheduler(size_t startup_budget, uint32_t seed)
+    : startup_budget_(startup_budget ? startup_budget : 1), random_(seed), groups_(), streams_() {}
+
+void RestartScheduler::ScheduleRestart(stream_id_t sid, const std::string& upstream_host, fastotv::timestamp_t now) {
+  const std::string key = MakeGroupKey(sid, upstream_host);
+  bool was_starting = false;
+  auto sit = streams_.find(sid);
+  if (sit != streams_.end()) {
+    was_starting = sit->second.starting;
+    if (sit->second.group != key) {  // input changed
+      RemoveStream(sid);
+      was_starting = false;
+    }
+  }
+
+  auto git = groups_.find(key);
+  if (git == groups_.end()) {
+    Group group = {GROUP_HEALTHY, 0, 0, stream_id_t()};
+    git = groups_.insert(std::make_pair(key, group)).first;
+  }
+
+  Group* group = &git->second;
+  if (group->state == GROUP_HEALTHY) {
+    // first failure, streams failing after it join the same back-off
+    OnGroupFailed(group, now);
+  } else if (group->state == GROUP_PROBING && group->probe == sid && was_starting) {
+    OnGroupFailed(group, now);
+  }
+
+  Entry entry = {key, false, now};
+  streams_[sid] = entry;
+}
+
+void RestartScheduler::OnStreamStarted(stream_id_t sid, fastotv::timestamp_t now) {
+  UNUSED(now);
+  auto sit = streams_.find(sid);
+  if (sit == streams_.end() || !sit->second.starting) {
+    return;
+  }
+
+  const std::string key = sit->second.group;
+  auto git = groups_.find(key);
+  if (git != groups_.end()) {  // upstream is alive, release the rest of group
+    Group* group = &git->second;
+    group->state = GROUP_HEALTHY;
+    group->failures = 0;
+    group->next_attempt = 0;
+    group->probe.clear();
+  }
+  streams_.erase(sit);
+  ReleaseEmptyGroup(key);
+}
+
+void RestartScheduler::RemoveStream(stream_id_t sid) {
+  auto sit = streams_.find(sid);
+  if (sit == streams_.end()) {
+    return;
+  }
+
+  const std::string key = sit->second.group;
+  auto git = groups_.find(key);
+  if (git != groups_.end() && git->second.probe == sid) {
+    git->second.probe.clear();  // next waiting stream probes
+  }
+  streams_.erase(sit);
+  ReleaseEmptyGroup(key);
+}
+
+std::vector<stream_id_t> RestartScheduler::CollectReady(fastotv::timestamp_t now) {
+  std::vector<stream_id_t> timeouted;
+  for (auto it = streams_.begin(); it != streams_.end(); ++it) {
+    if (it->second.starting && now - it->second.since >= startup_timeout_msec) {
+      timeouted.push_back(it->first);
+    }
+  }
+
+  for (const stream_id_t& sid : timeouted) {
+    auto git = groups_.find(streams_[sid].group);
+    if (git != groups_.end() && git->second.state == GROUP_PROBING && git->second.probe == sid) {
+      OnGroupFailed(&git->second, now);
+    }
+    RemoveStream(sid);
+  }
+
+  for (auto it = groups_.begin(); it != groups_.end(); ++it) {
+    Group* group = &it->second;
+    if (group->state == GROUP_BACKOFF && now >= group->next_attempt) {
+      group->state = GROUP_PROBING;
+      group->probe.clear();
+    }
+  }
+
+  std::vector<stream_id_t> result;
+  size_t starting = GetStartingCount();
+  if (starting >= startup_budget_) {
+    return result;
+  }
+
+  std::vector<std::pair<fastotv::timestamp_t, stream_id_t>> waiting;
+  for (auto it = streams_.begin(); it != streams_.end(); ++it) {
+    if (!it->second.starting) {
+      waiting.push_back(std::make_pair(it->second.since, it->first));
+    }
+  }
+  std::sort(waiting.begin(), waiting.end());
+
+  for (size_t i = 0; i < waiting.size() && starting < startup_budget_; ++i) {
+    const stream_id_t sid = waiting[i].second;
+    Entry* entry = &streams_[sid];
+    Group* group = &groups_[entry->group];
+    if (group->state == GROUP_BACKOFF) {
+      continue;
+    }
+
+    if (group->state == GROUP_PROBING) {
+      if (!group->probe.empty()) {
+        continue;
+      }
+      group->probe = sid;
+    }
+
+    entry->starting = true;
+    entry->since = now;
+    starting++;
+    result.push_back(sid);
+  }
+
+  return result;
+}
+
+bool RestartScheduler::IsStarting(stream_id_t sid) const {
+  auto sit = streams_.find(sid);
+  return sit != streams_.end() && sit->second.starting;
+}
+
+std::vector<stream_id_t> RestartScheduler::GetStartingStreams() const {
+  std::vector<stream_id_t> result;
+  for (auto it = streams_.begin(); it != streams_.end(); ++it) {
+    if (it->second.starting) {
+      result.push_back(it->first);
+    }
+  }
+  return result;
+}
+
+size_t RestartScheduler::GetWaitingCount() const {
+  return streams_.size() - GetStartingCount();
+}
+
+size_t RestartScheduler::GetStartingCount() const {
+  size_t count = 0;
+  for (auto it = streams_.begin(); it != streams_.end(); ++it) {
+    if (it->second.starting) {
+      count++;
+    }
+  }
+  return count;
+}
+
+size_t RestartScheduler::GetStartupBudget() const {
+  return startup_budget_;
+}
+
+std::string RestartScheduler::MakeGroupKey(stream_id_t sid, const std::string& upstream_host) {
+  if (upstream_host.empty()) {
+    return "#" + sid;
+  }
+  return upstream_host;
+}
+
+fastotv::timestamp_t RestartScheduler::NextDelay(size_t failures) {
+  fastotv::timestamp_t delay = max_delay_msec;
+  if (failures <= 16) {
+    delay = std::min<fastotv::timestamp_t>(static_cast<fastotv::timestamp_t>(base_delay_msec) << (failures - 1),
+                                           max_delay_msec);
+  }
+  // equal jitter, [delay / 2, delay]
+  std::uniform_int_distribution<fastotv::timestamp_t> jitter(delay / 2, delay);
+  return jitter(random_);
+}
+
+void RestartScheduler::OnGroupFailed(Group* group, fastotv::timestamp_t now) {
+  group->failures++;
+  group->state = GROUP_BACKOFF;
+  group->next_attempt = now + NextDelay(group->failures);
+  group->probe.clear();
+}
+
+void RestartScheduler::ReleaseEmptyGroup(const std::string& key) {
+  if (IsGroupEmpty(key)) {
+    groups_.erase(key);
+  }
+}
+
+bool RestartScheduler::IsGroupEmpty(const std::string& key) const {
+  for (auto it = streams_.begin(); it != streams_.end(); ++it) {
+    if (it->second.group == key) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace server
+}  // namespace iptv_cloud
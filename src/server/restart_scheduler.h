@@ -0,0 +1,91 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <common/macros.h>
+
+#include "base/types.h"
+
+namespace iptv_cloud {
+namespace server {
+
+// node wide restart scheduler for failed streams:
+// streams with the same upstream host back off together with jittered exponential delay,
+// after back-off the host is probed with one stream, others wait for its result,
+// not more than startup_budget streams are starting at the same time.
+class RestartScheduler {
+ public:
+  enum constants : uint32_t {
+    DEFAULT_STARTUP_BUDGET = 8,
+    base_delay_msec = 1000,
+    max_delay_msec = 300000,
+    startup_timeout_msec = 30000
+  };
+
+  explicit RestartScheduler(size_t startup_budget, uint32_t seed = std::random_device()());
+
+  // stream failed and waits for permission, empty upstream_host means stream is a group itself
+  void ScheduleRestart(stream_id_t sid, const std::string& upstream_host, fastotv::timestamp_t now);
+  // stream reached playing state
+  void OnStreamStarted(stream_id_t sid, fastotv::timestamp_t now);
+  // stream stopped, exited or was restarted by request
+  void RemoveStream(stream_id_t sid);
+
+  // streams allowed to restart now, they are counted as starting until started/failed/timeout
+  std::vector<stream_id_t> CollectReady(fastotv::timestamp_t now);
+
+  bool IsStarting(stream_id_t sid) const;
+  std::vector<stream_id_t> GetStartingStreams() const;
+  size_t GetWaitingCount() const;
+  size_t GetStartingCount() const;
+  size_t GetStartupBudget() const;
+
+ private:
+  enum GroupState { GROUP_HEALTHY, GROUP_BACKOFF, GROUP_PROBING };
+
+  struct Group {
+    GroupState state;
+    size_t failures;
+    fastotv::timestamp_t next_attempt;
+    stream_id_t probe;
+  };
+
+  struct Entry {
+    std::string group;
+    bool starting;
+    fastotv::timestamp_t since;  // wait or start time
+  };
+
+  static std::string MakeGroupKey(stream_id_t sid, const std::string& upstream_host);
+  fastotv::timestamp_t NextDelay(size_t failures);
+  void OnGroupFailed(Group* group, fastotv::timestamp_t now);
+  void ReleaseEmptyGroup(const std::string& key);
+  bool IsGroupEmpty(const std::string& key) const;
+
+  const size_t startup_budget_;
+  std::mt19937 random_;
+  std::map<std::string, Group> groups_;
+  std::map<stream_id_t, Entry> streams_;
+
+  DISALLOW_COPY_AND_ASSIGN(RestartScheduler);
+};
+
+}  // namespace server
+}  // namespace iptv_cloud
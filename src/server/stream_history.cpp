@@ -0,0 +1,254 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/stream_history.h"
+
+namespace iptv_cloud {
+namespace server {
+
+namespace {
+
+const uint64_t kStatusChanged = 1;
+const uint64_t kRestartsChanged = 2;
+const unsigned kFlagsBits = 2;
+
+uint64_t ZigZag(int64_t value) {
+  return (static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63);
+}
+
+int64_t UnZigZag(uint64_t value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+void PutVarint(uint64_t value, std::vector<uint8_t>* out) {
+  while (value >= 0x80) {
+    out->push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  out->push_back(static_cast<uint8_t>(value));
+}
+
+uint64_t GetVarint(const uint8_t** pos) {
+  uint64_t result = 0;
+  for (unsigned shift = 0;; shift += 7) {
+    const uint8_t byte = *(*pos)++;
+    result |= static_cast<uint64_t>(byte & 0x7F) << shift;
+    if (!(byte & 0x80)) {
+      return result;
+    }
+  }
+}
+
+void AddToRun(time_t time, const StreamHistory::Sample& sample, std::vector<stream::HistoryRun>* runs) {
+  const fastotv::timestamp_t msec = static_cast<fastotv::timestamp_t>(time) * 1000;
+  if (runs->empty() || runs->back().start + static_cast<fastotv::timestamp_t>(runs->back().status.size()) * 1000 !=
+                           msec) {
+    stream::HistoryRun run;
+    run.start = msec;
+    runs->push_back(run);
+  }
+
+  stream::HistoryRun* run = &runs->back();
+  run->input_bps.push_back(sample.input_bps);
+  run->output_bps.push_back(sample.output_bps);
+  run->status.push_back(sample.status);
+  run->restarts.push_back(sample.restarts);
+}
+
+}  // namespace
+
+StreamHistory::StreamHistory() : blocks_(), samples_(0), bytes_(0) {}
+
+void StreamHistory::Append(time_t time, const Sample& sample) {
+  if (!blocks_.empty() && time <= GetLastTime()) {
+    return;
+  }
+
+  if (!blocks_.empty() && time - GetLastTime() <= static_cast<time_t>(hold_samples)) {
+    const Sample last = blocks_.back().last;
+    for (time_t hold = GetLastTime() + 1; hold < time; ++hold) {
+      AppendSample(hold, last);
+    }
+  }
+  AppendSample(time, sample);
+}
+
+void StreamHistory::AppendSample(time_t time, const Sample& sample) {
+  if (blocks_.empty() || blocks_.back().count == block_samples ||
+      blocks_.back().start + static_cast<time_t>(blocks_.back().count) != time) {
+    if (!blocks_.empty()) {
+      Block* closed = &blocks_.back();
+      bytes_ -= GetBlockSize(*closed);
+      closed->deltas.shrink_to_fit();
+      bytes_ += GetBlockSize(*closed);
+    }
+
+    Block block;
+    block.start = time;
+    block.count = 1;
+    block.first = sample;
+    block.last = sample;
+    blocks_.push_back(block);
+    samples_++;
+    bytes_ += GetBlockSize(blocks_.back());
+    return;
+  }
+
+  Block* block = &blocks_.back();
+  bytes_ -= GetBlockSize(*block);
+  const bool status_changed = sample.status != block->last.status;
+  const bool restarts_changed = sample.restarts != block->last.restarts;
+  const int64_t input_delta = static_cast<int64_t>(sample.input_bps - block->last.input_bps);
+  const int64_t output_delta = static_cast<int64_t>(sample.output_bps - block->last.output_bps);
+  // flags share the varint with input delta, steady samples take two bytes
+  const uint64_t tag = (ZigZag(input_delta) << kFlagsBits) | (status_changed ? kStatusChanged : 0u) |
+                       (restarts_changed ? kRestartsChanged : 0u);
+  PutVarint(tag, &block->deltas);
+  PutVarint(ZigZag(output_delta), &block->deltas);
+  if (status_changed) {
+    block->deltas.push_back(static_cast<uint8_t>(sample.status));
+  }
+  if (restarts_changed) {
+    PutVarint(ZigZag(static_cast<int64_t>(sample.restarts - block->last.restarts)), &block->deltas);
+  }
+  block->last = sample;
+  block->count++;
+  samples_++;
+  bytes_ += GetBlockSize(*block);
+}
+
+void StreamHistory::Query(time_t from, time_t to, std::vector<stream::HistoryRun>* runs) const {
+  for (const Block& block : blocks_) {
+    const time_t end = block.start + static_cast<time_t>(block.count) - 1;
+    if (end < from || block.start > to) {
+      continue;
+    }
+
+    Sample sample = block.first;
+    if (block.start >= from) {
+      AddToRun(block.start, sample, runs);
+    }
+
+    const uint8_t* pos = block.deltas.data();
+    for (time_t time = block.start + 1; time <= end && time <= to; ++time) {
+      const uint64_t tag = GetVarint(&pos);
+      sample.input_bps += UnZigZag(tag >> kFlagsBits);
+      sample.output_bps += UnZigZag(GetVarint(&pos));
+      if (tag & kStatusChanged) {
+        sample.status = static_cast<StreamStatus>(*pos++);
+      }
+      if (tag & kRestartsChanged) {
+        sample.restarts += UnZigZag(GetVarint(&pos));
+      }
+      if (time >= from) {
+        AddToRun(time, sample, runs);
+      }
+    }
+  }
+}
+
+void StreamHistory::DropBefore(time_t time) {
+  while (blocks_.size() > 1) {
+    const Block& block = blocks_.front();
+    if (block.start + static_cast<time_t>(block.count) > time) {
+      break;
+    }
+    DropOldestBlock();
+  }
+}
+
+bool StreamHistory::DropOldestBlock() {
+  if (blocks_.size() < 2) {
+    return false;
+  }
+
+  samples_ -= blocks_.front().count;
+  bytes_ -= GetBlockSize(blocks_.front());
+  blocks_.pop_front();
+  return true;
+}
+
+bool StreamHistory::IsEmpty() const {
+  return blocks_.empty();
+}
+
+time_t StreamHistory::GetLastTime() const {
+  if (blocks_.empty()) {
+    return 0;
+  }
+
+  const Block& block = blocks_.back();
+  return block.start + static_cast<time_t>(block.count) - 1;
+}
+
+size_t StreamHistory::GetSamplesCount() const {
+  return samples_;
+}
+
+size_t StreamHistory::GetMemoryUsage() const {
+  return bytes_;
+}
+
+size_t StreamHistory::GetBlockSize(const Block& block) {
+  return sizeof(Block) + block.deltas.capacity();
+}
+
+HistoryStore::HistoryStore(size_t budget_bytes) : budget_(budget_bytes), streams_() {}
+
+void HistoryStore::Append(const stream_id_t& sid, time_t time, const StreamHistory::Sample& sample) {
+  StreamHistory* history = &streams_[sid];
+  history->Append(time, sample);
+  history->DropBefore(time - static_cast<time_t>(StreamHistory::max_samples) + 1);
+  const size_t stream_budget = budget_ / streams_.size();
+  while (history->GetMemoryUsage() > stream_budget && history->DropOldestBlock()) {
+  }
+}
+
+bool HistoryStore::Query(const stream_id_t& sid,
+                         time_t from,
+                         time_t to,
+                         std::vector<stream::HistoryRun>* runs) const {
+  const auto it = streams_.find(sid);
+  if (it == streams_.end()) {
+    return false;
+  }
+
+  it->second.Query(from, to, runs);
+  return true;
+}
+
+void HistoryStore::RemoveStale(time_t now) {
+  for (auto it = streams_.begin(); it != streams_.end();) {
+    if (it->second.GetLastTime() + static_cast<time_t>(StreamHistory::max_samples) < now) {
+      it = streams_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+size_t HistoryStore::GetBudget() const {
+  return budget_;
+}
+
+size_t HistoryStore::GetMemoryUsage() const {
+  size_t total = 0;
+  for (const auto& stream : streams_) {
+    total += stream.second.GetMemoryUsage();
+  }
+  return total;
+}
+
+}  // namespace server
+}  // namespace iptv_cloud
@@ -0,0 +1,95 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <time.h>
+
+#include <deque>
+#include <map>
+#include <vector>
+
+#include "base/stream_struct.h"
+#include "server/daemon/commands_info/stream/history_info.h"
+
+namespace iptv_cloud {
+namespace server {
+
+// per second samples of one stream, delta encoded in blocks of one minute:
+// first sample of a block is stored as is, next ones as zigzag varint differences,
+// gaps up to hold_samples seconds repeat the last sample, longer gaps start a new block.
+class StreamHistory {
+ public:
+  enum : size_t { block_samples = 60, max_samples = 24 * 60 * 60, hold_samples = 20 };  // streams report each 10 sec
+
+  struct Sample {
+    uint64_t input_bps;
+    uint64_t output_bps;
+    StreamStatus status;
+    uint64_t restarts;
+  };
+
+  StreamHistory();
+
+  // samples not newer than the last one are ignored
+  void Append(time_t time, const Sample& sample);
+  // appends runs of samples in [from, to] seconds
+  void Query(time_t from, time_t to, std::vector<stream::HistoryRun>* runs) const;
+
+  void DropBefore(time_t time);
+  // last block is never dropped
+  bool DropOldestBlock();
+
+  bool IsEmpty() const;
+  time_t GetLastTime() const;
+  size_t GetSamplesCount() const;
+  size_t GetMemoryUsage() const;
+
+ private:
+  struct Block {
+    time_t start;
+    size_t count;
+    Sample first;
+    Sample last;
+    std::vector<uint8_t> deltas;
+  };
+
+  void AppendSample(time_t time, const Sample& sample);
+  static size_t GetBlockSize(const Block& block);
+
+  std::deque<Block> blocks_;
+  size_t samples_;
+  size_t bytes_;
+};
+
+// histories of node streams within a memory budget shared equally between streams
+class HistoryStore {
+ public:
+  explicit HistoryStore(size_t budget_bytes);
+
+  void Append(const stream_id_t& sid, time_t time, const StreamHistory::Sample& sample);
+  bool Query(const stream_id_t& sid, time_t from, time_t to, std::vector<stream::HistoryRun>* runs) const;
+  // forget streams without samples for max_samples seconds
+  void RemoveStale(time_t now);
+
+  size_t GetBudget() const;
+  size_t GetMemoryUsage() const;
+
+ private:
+  const size_t budget_;
+  std::map<stream_id_t, StreamHistory> streams_;
+};
+
+}  // namespace server
+}  // namespace iptv_cloud
@@ -44,5 +44,15 @@ void SyncFinder::AddUser(const user_t& user) {
   users_.insert(std::make_pair(user.GetLogin(), user));
 }
 
+void SyncFinder::UpdateUser(const user_t& user) {
+  std::unique_lock<std::mutex> lock(users_mutex_);
+  users_[user.GetLogin()] = user;
+}
+
+void SyncFinder::RemoveUser(const fastotv::login_t& login) {
+  std::unique_lock<std::mutex> lock(users_mutex_);
+  users_.erase(login);
+}
+
 }  // namespace server
 }  // namespace iptv_cloud
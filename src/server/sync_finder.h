@@ -31,6 +31,8 @@ class SyncFinder : public subscribers::ISubscribeFinder {
   common::Error FindUser(const fastotv::commands_info::AuthInfo& user, user_t* uinf) const override;
   void Clear();
   void AddUser(const user_t& user);
+  void UpdateUser(const user_t& user);  // add or replace
+  void RemoveUser(const fastotv::login_t& login);
 
  private:
   users_t users_;
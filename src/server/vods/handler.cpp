@@ -18,23 +18,87 @@
 #include <sys/stat.h>
 #include <unistd.h>
 
+#include <fstream>
+#include <iterator>
 #include <string>
 #include <utility>
 
+#include <common/libev/io_loop.h>  // for IoLoop
+#include <common/time.h>
+
+#include "base/types.h"
+
 #include "server/base/ihttp_requests_observer.h"
 #include "server/vods/client.h"
 
+namespace {
+bool IsPlaylist(const common::file_system::ascii_file_string_path& file) {
+  return common::EqualsASCII(file.GetExtension(), M3U8_EXTENSION, false);
+}
+
+bool ReadPlaylist(const std::string& path, std::string* content) {
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+
+  content->assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  return true;
+}
+
+// hlssink writes playlist without type, while chunks are still produced player should treat it as growing
+std::string MakeEventPlaylist(const std::string& content) {
+  static const std::string header = "#EXTM3U";
+  if (content.compare(0, header.size(), header) != 0 || content.find("#EXT-X-PLAYLIST-TYPE") != std::string::npos ||
+      content.find("#EXT-X-ENDLIST") != std::string::npos) {
+    return content;
+  }
+
+  std::string result = content;
+  size_t line_end = result.find('\n');
+  if (line_end == std::string::npos) {
+    return result;
+  }
+  result.insert(line_end + 1, "#EXT-X-PLAYLIST-TYPE:EVENT\n");
+  return result;
+}
+
+// playlist is usable when it lists at least one chunk, chunk when it is on disk
+bool IsReadyToServe(const common::file_system::ascii_file_string_path& file) {
+  const std::string file_path_str = file.GetPath();
+  struct stat sb;
+  if (stat(file_path_str.c_str(), &sb) < 0) {
+    return false;
+  }
+
+  if (!IsPlaylist(file)) {
+    return true;
+  }
+
+  std::string content;
+  if (!ReadPlaylist(file_path_str, &content)) {
+    return false;
+  }
+  return content.find(M3U8_CHUNK_MARKER) != std::string::npos;
+}
+}  // namespace
+
 namespace iptv_cloud {
 namespace server {
 
 VodsHandler::VodsHandler(base::IHttpRequestsObserver* observer)
-    : base_class(), vods_root_(vods_directory_path_t::MakeHomeDir()), observer_(observer) {}
+    : base_class(),
+      vods_root_(vods_directory_path_t::MakeHomeDir()),
+      held_requests_(),
+      hold_timer_(INVALID_TIMER_ID),
+      observer_(observer) {}
 
 void VodsHandler::SetVodsRoot(const vods_directory_path_t& vods_root) {
   vods_root_ = vods_root;
 }
 
 void VodsHandler::PreLooped(common::libev::IoLoop* server) {
+  hold_timer_ = server->CreateTimer(static_cast<double>(hold_check_msec) / 1000, true);
   base_class::PreLooped(server);
 }
 
@@ -47,10 +111,20 @@ void VodsHandler::Moved(common::libev::IoLoop* server, common::libev::IoClient*
 }
 
 void VodsHandler::Closed(common::libev::IoClient* client) {
+  for (auto it = held_requests_.begin(); it != held_requests_.end();) {
+    if (it->client == client) {
+      it = held_requests_.erase(it);
+    } else {
+      ++it;
+    }
+  }
   base_class::Closed(client);
 }
 
 void VodsHandler::TimerEmited(common::libev::IoLoop* server, common::libev::timer_id_t id) {
+  if (id == hold_timer_) {
+    CheckHeldRequests();
+  }
   base_class::TimerEmited(server, id);
 }
 
@@ -88,6 +162,11 @@ void VodsHandler::DataReadyToWrite(common::libev::IoClient* client) {
 }
 
 void VodsHandler::PostLooped(common::libev::IoLoop* server) {
+  if (hold_timer_ != INVALID_TIMER_ID) {
+    server->RemoveTimer(hold_timer_);
+    hold_timer_ = INVALID_TIMER_ID;
+  }
+  held_requests_.clear();
   base_class::PostLooped(server);
 }
 
@@ -111,6 +190,41 @@ void VodsHandler::ProcessReceived(VodsClient* hclient, const char* request, size
     return;
   }
 
+  ProcessRequest(hclient, hrequest, true);
+}
+
+void VodsHandler::CheckHeldRequests() {
+  if (held_requests_.empty()) {
+    return;
+  }
+
+  const common::time64_t current_time = common::time::current_utc_mstime();
+  std::vector<HeldRequest> ready;
+  for (auto it = held_requests_.begin(); it != held_requests_.end();) {
+    common::uri::Upath path = it->request.GetPath();
+    const std::string url_dirs = path.GetHpath();
+    auto dirs_path = vods_root_.MakeDirectoryStringPath(url_dirs.substr(1));
+    if (!dirs_path) {
+      dirs_path = vods_root_;
+    }
+    auto file_path = dirs_path->MakeFileStringPath(path.GetFileName());
+    if (!file_path || it->deadline <= current_time || IsReadyToServe(*file_path) ||
+        !observer_->IsFileInProgress(*file_path)) {
+      ready.push_back(*it);
+      it = held_requests_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+
+  // answered outside of iteration, client can be closed while processing
+  for (const HeldRequest& held : ready) {
+    ProcessRequest(held.client, held.request, false);
+  }
+}
+
+void VodsHandler::ProcessRequest(VodsClient* hclient, const common::http::HttpRequest& hrequest, bool first_time) {
+  static const common::libev::http::HttpServerInfo hinf(PROJECT_NAME_TITLE, PROJECT_DOMAIN);
   // keep alive
   common::http::header_t connection_field;
   bool is_find_connection = hrequest.FindHeaderByKey("Connection", false, &connection_field);
@@ -145,8 +259,13 @@ void VodsHandler::ProcessReceived(VodsClient* hclient, const char* request, size
       return;
     }
 
-    if (observer_) {
+    if (observer_ && first_time) {
       observer_->OnHttpRequest(hclient, *file_path);
+      if (!IsReadyToServe(*file_path) && observer_->IsFileInProgress(*file_path)) {
+        const HeldRequest held = {hclient, hrequest, common::time::current_utc_mstime() + hold_timeout_msec};
+        held_requests_.push_back(held);
+        return;
+      }
     }
 
     const std::string file_path_str = file_path->GetPath();
@@ -170,6 +289,42 @@ void VodsHandler::ProcessReceived(VodsClient* hclient, const char* request, size
       return;
     }
 
+    const std::string mime = path.GetMime();
+    if (observer_ && IsPlaylist(*file_path) && observer_->IsFileInProgress(*file_path)) {
+      std::string content;
+      if (!ReadPlaylist(file_path_str, &content)) {
+        common::ErrnoError err = hclient->SendError(protocol, common::http::HS_FORBIDDEN, extra_header,
+                                                    "File is protected.", IsKeepAlive, hinf);
+        if (err) {
+          DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+        }
+        return;
+      }
+
+      const std::string playlist = MakeEventPlaylist(content);
+      off_t playlist_size = playlist.size();
+      common::ErrnoError err = hclient->SendHeaders(protocol, common::http::HS_OK, extra_header, mime.c_str(),
+                                                    &playlist_size, &sb.st_mtime, IsKeepAlive, hinf);
+      if (err) {
+        DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+        return;
+      }
+
+      if (hrequest.GetMethod() == common::http::http_method::HM_GET) {
+        size_t nwrite = 0;
+        err = hclient->Write(playlist.data(), playlist.size(), &nwrite);
+        if (err) {
+          DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+        }
+      }
+
+      if (!IsKeepAlive) {
+        hclient->Close();
+        delete hclient;
+      }
+      return;
+    }
+
     int file = open(file_path_str.c_str(), open_flags);
     if (file == INVALID_DESCRIPTOR) { /* open the file for reading */
       common::ErrnoError err = hclient->SendError(protocol, common::http::HS_FORBIDDEN, extra_header,
@@ -180,7 +335,6 @@ void VodsHandler::ProcessReceived(VodsClient* hclient, const char* request, size
       return;
     }
 
-    const std::string mime = path.GetMime();
     common::ErrnoError err = hclient->SendHeaders(protocol, common::http::HS_OK, extra_header, mime.c_str(),
                                                   &sb.st_size, &sb.st_mtime, IsKeepAlive, hinf);
     if (err) {
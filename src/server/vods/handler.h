@@ -14,7 +14,11 @@
 
 #pragma once
 
+#include <string>
+#include <vector>
+
 #include <common/file_system/path.h>
+#include <common/http/http.h>
 
 #include "server/base/iserver_handler.h"
 
@@ -28,7 +32,7 @@ class IHttpRequestsObserver;
 
 class VodsHandler : public base::IServerHandler {
  public:
-  enum { BUF_SIZE = 4096 };
+  enum { BUF_SIZE = 4096, hold_timeout_msec = 30000, hold_check_msec = 250 };
   typedef base::IServerHandler base_class;
   typedef common::file_system::ascii_directory_string_path vods_directory_path_t;
   explicit VodsHandler(base::IHttpRequestsObserver* observer);
@@ -53,9 +57,20 @@ class VodsHandler : public base::IServerHandler {
   void PostLooped(common::libev::IoLoop* server) override;
 
  private:
+  // request for file of vod which is still transcoding, answered when file is ready or on timeout
+  struct HeldRequest {
+    VodsClient* client;
+    common::http::HttpRequest request;
+    common::time64_t deadline;
+  };
+
   void ProcessReceived(VodsClient* hclient, const char* request, size_t req_len);
+  void ProcessRequest(VodsClient* hclient, const common::http::HttpRequest& hrequest, bool first_time);
+  void CheckHeldRequests();
 
   vods_directory_path_t vods_root_;
+  std::vector<HeldRequest> held_requests_;
+  common::libev::timer_id_t hold_timer_;
   base::IHttpRequestsObserver* const observer_;
 };
 
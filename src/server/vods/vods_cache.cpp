@@ -0,0 +1,171 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "server/vods/vods_cache.h"
+
+namespace iptv_cloud {
+namespace server {
+
+VodsCache::VodsCache() : vods_mutex_(), vods_() {}
+
+void VodsCache::Clear() {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  vods_.clear();
+}
+
+void VodsCache::AddVod(const http_root_t& http_root, const StreamConfig& config) {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  auto it = vods_.find(http_root);
+  if (it != vods_.end()) {
+    it->second.config = config;  // keep state, files are the same
+    return;
+  }
+
+  Entry entry;
+  entry.config = config;
+  entry.state = ABSENT;
+  vods_[http_root] = entry;
+}
+
+void VodsCache::RemoveStream(stream_id_t sid) {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  for (auto it = vods_.begin(); it != vods_.end();) {
+    if (it->second.config.id == sid) {
+      it = vods_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+std::vector<VodsCache::http_root_t> VodsCache::GetHttpRoots() const {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  std::vector<http_root_t> result;
+  for (auto it = vods_.begin(); it != vods_.end(); ++it) {
+    result.push_back(it->first);
+  }
+  return result;
+}
+
+bool VodsCache::IsComplete(const http_root_t& http_root) const {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  auto it = vods_.find(http_root);
+  return it != vods_.end() && it->second.state == COMPLETE;
+}
+
+bool VodsCache::IsPending(const http_root_t& http_root) const {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  auto it = vods_.find(http_root);
+  return it != vods_.end() && it->second.state == IN_PROGRESS;
+}
+
+bool VodsCache::MarkRequested(const http_root_t& http_root) {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  auto it = vods_.find(http_root);
+  if (it == vods_.end() || it->second.state != ABSENT) {
+    return false;
+  }
+
+  it->second.state = IN_PROGRESS;
+  return true;
+}
+
+bool VodsCache::FindVod(const http_root_t& http_root, StreamConfig* config, VodState* state) const {
+  if (!config || !state) {
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  auto it = vods_.find(http_root);
+  if (it == vods_.end()) {
+    return false;
+  }
+
+  *config = it->second.config;
+  *state = it->second.state;
+  return true;
+}
+
+bool VodsCache::IsVodStream(stream_id_t sid) const {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  for (auto it = vods_.begin(); it != vods_.end(); ++it) {
+    if (it->second.config.id == sid) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void VodsCache::SetPlaylist(const http_root_t& http_root, const playlist_path_t& playlist) {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  auto it = vods_.find(http_root);
+  if (it != vods_.end()) {
+    it->second.playlist = playlist;
+  }
+}
+
+std::vector<VodsCache::playlist_path_t> VodsCache::GetPlaylists(stream_id_t sid) const {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  std::vector<playlist_path_t> result;
+  for (auto it = vods_.begin(); it != vods_.end(); ++it) {
+    if (it->second.config.id == sid && it->second.playlist.IsValid()) {
+      result.push_back(it->second.playlist);
+    }
+  }
+  return result;
+}
+
+void VodsCache::SetStreamState(stream_id_t sid, VodState state) {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  for (auto it = vods_.begin(); it != vods_.end(); ++it) {
+    if (it->second.config.id == sid) {
+      it->second.state = state;
+    }
+  }
+}
+
+void VodsCache::SetRootState(const http_root_t& http_root, VodState state) {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  auto it = vods_.find(http_root);
+  if (it != vods_.end()) {
+    it->second.state = state;
+  }
+}
+
+void VodsCache::ResetCompleted() {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  for (auto it = vods_.begin(); it != vods_.end(); ++it) {
+    if (it->second.state == COMPLETE) {
+      it->second.state = ABSENT;
+    }
+  }
+}
+
+VodsCache::Stats VodsCache::GetStats() const {
+  std::unique_lock<std::mutex> lock(vods_mutex_);
+  Stats stats = {0, 0, 0};
+  for (auto it = vods_.begin(); it != vods_.end(); ++it) {
+    if (it->second.state == COMPLETE) {
+      stats.complete++;
+    } else if (it->second.state == IN_PROGRESS) {
+      stats.in_progress++;
+    } else {
+      stats.absent++;
+    }
+  }
+  return stats;
+}
+
+}  // namespace server
+}  // namespace iptv_cloud
@@ -0,0 +1,79 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <map>
+#include <mutex>
+#include <vector>
+
+#include <common/file_system/path.h>
+
+#include "base/stream_config.h"
+
+namespace iptv_cloud {
+namespace server {
+
+// per http_root state of on-demand vods, transcode started on first playlist request,
+// state is changed by main loop only except MarkRequested, which http threads call before the loop hop,
+// IsComplete/IsPending can be called from any thread.
+class VodsCache {
+ public:
+  enum VodState { ABSENT = 0, IN_PROGRESS = 1, COMPLETE = 2 };
+  typedef common::file_system::ascii_directory_string_path http_root_t;
+  typedef common::file_system::ascii_file_string_path playlist_path_t;
+
+  struct Stats {
+    size_t absent;
+    size_t in_progress;
+    size_t complete;
+  };
+
+  VodsCache();
+
+  void Clear();
+  void AddVod(const http_root_t& http_root, const StreamConfig& config);
+  void RemoveStream(stream_id_t sid);
+  std::vector<http_root_t> GetHttpRoots() const;
+
+  bool IsComplete(const http_root_t& http_root) const;
+  bool IsPending(const http_root_t& http_root) const;  // transcode of vod is running now
+  // ABSENT -> IN_PROGRESS, so first request is held, true if caller must start transcode
+  bool MarkRequested(const http_root_t& http_root);
+  bool FindVod(const http_root_t& http_root, StreamConfig* config, VodState* state) const WARN_UNUSED_RESULT;
+  bool IsVodStream(stream_id_t sid) const;
+
+  void SetPlaylist(const http_root_t& http_root, const playlist_path_t& playlist);
+  std::vector<playlist_path_t> GetPlaylists(stream_id_t sid) const;  // known playlists of stream
+  void SetStreamState(stream_id_t sid, VodState state);
+  void SetRootState(const http_root_t& http_root, VodState state);
+  void ResetCompleted();  // chunks removed
+
+  Stats GetStats() const;
+
+ private:
+  struct Entry {
+    StreamConfig config;
+    VodState state;
+    playlist_path_t playlist;
+  };
+
+  mutable std::mutex vods_mutex_;
+  std::map<http_root_t, Entry> vods_;
+
+  DISALLOW_COPY_AND_ASSIGN(VodsCache);
+};
+
+}  // namespace server
+}  // namespace iptv_cloud
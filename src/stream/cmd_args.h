@@ -19,4 +19,7 @@
 struct cmd_args {
   const char* feedback_dir;
   int log_level;
+  const char* adopt_socket;  // service to re-attach to when pipes are lost, null - stop with service
+  int command_read_fd;
+  int command_write_fd;
 };
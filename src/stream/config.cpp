@@ -18,7 +18,13 @@ namespace iptv_cloud {
 namespace stream {
 
 Config::Config(StreamType type, size_t max_restart_attempts, const input_t& input, const output_t& output)
-    : type_(type), max_restart_attempts_(max_restart_attempts), ttl_sec_(), input_(input), output_(output) {}
+    : type_(type),
+      max_restart_attempts_(max_restart_attempts),
+      ttl_sec_(),
+      analyze_ts_(false),
+      publish_input_(),
+      input_(input),
+      output_(output) {}
 
 StreamType Config::GetType() const {
   return type_;
@@ -60,5 +66,21 @@ void Config::SetTimeToLigeStream(ttl_t ttl) {
   ttl_sec_ = ttl;
 }
 
+bool Config::IsAnalyzeTs() const {
+  return analyze_ts_;
+}
+
+void Config::SetAnalyzeTs(bool analyze) {
+  analyze_ts_ = analyze;
+}
+
+std::string Config::GetPublishInput() const {
+  return publish_input_;
+}
+
+void Config::SetPublishInput(const std::string& socket_path) {
+  publish_input_ = socket_path;
+}
+
 }  // namespace stream
 }  // namespace iptv_cloud
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <string>
+
 #include "base/inputs_outputs.h"
 
 namespace iptv_cloud {
@@ -40,10 +42,18 @@ class Config {
   ttl_t GetTimeToLifeStream() const;
   void SetTimeToLigeStream(ttl_t ttl);
 
+  bool IsAnalyzeTs() const;
+  void SetAnalyzeTs(bool analyze);
+
+  std::string GetPublishInput() const;  // empty if input not shared
+  void SetPublishInput(const std::string& socket_path);
+
  private:
   StreamType type_;
   size_t max_restart_attempts_;
   ttl_t ttl_sec_;
+  bool analyze_ts_;
+  std::string publish_input_;
 
   input_t input_;
   output_t output_;
@@ -32,18 +32,76 @@ namespace {
 
 const size_t kDefaultRestartAttempts = 10;
 
-template <typename T>
-void CheckAndSetValue(const utils::ArgsMap& args, const std::string& name, std::map<std::string, T>* map) {
-  if (!map) {
-    return;
-  }
-
-  T result = T();
-  if (utils::ArgsGetValue(args, name, &result)) {
-    map->insert(std::make_pair(name, result));
-  }
+enum EncoderArgType { INTEGER_ARG, STRING_ARG, FLAG_ARG };
+
+typedef std::map<std::string, EncoderArgType> encoder_args_table_t;
+
+const encoder_args_table_t& GetVideoEncodersArgsTable() {
+  static const encoder_args_table_t kArgs = {
+      // nvh264enc
+      {NV_H264_ENC_PRESET, INTEGER_ARG},
+      // mfxh264enc
+      {MFX_H264_ENC_PRESET, INTEGER_ARG},
+      {MFX_H264_GOP_SIZE, INTEGER_ARG},
+      // x264enc
+      {X264_ENC_SPEED_PRESET, INTEGER_ARG},
+      {X264_ENC_THREADS, INTEGER_ARG},
+      {X264_ENC_TUNE, INTEGER_ARG},
+      {X264_ENC_KEY_INT_MAX, INTEGER_ARG},
+      {X264_ENC_VBV_BUF_CAPACITY, INTEGER_ARG},
+      {X264_ENC_RC_LOOKAHED, INTEGER_ARG},
+      {X264_ENC_QP_MAX, INTEGER_ARG},
+      {X264_ENC_PASS, INTEGER_ARG},
+      {X264_ENC_ME, INTEGER_ARG},
+      {X264_ENC_SLICED_THREADS, INTEGER_ARG},
+      {X264_ENC_B_ADAPT, INTEGER_ARG},
+      {X264_ENC_BYTE_STREAM, INTEGER_ARG},
+      {X264_ENC_QUANTIZER, INTEGER_ARG},
+      {X264_ENC_PROFILE, STRING_ARG},
+      {X264_ENC_STREAM_FORMAT, STRING_ARG},
+      {X264_ENC_OPTION_STRING, STRING_ARG},
+      {X264_ENC_INTERLACED, FLAG_ARG},
+      {X264_ENC_DCT8X8, FLAG_ARG},
+      // vaapih264enc
+      {VAAPI_H264_ENC_KEYFRAME_PERIOD, INTEGER_ARG},
+      {VAAPI_H264_ENC_TUNE, INTEGER_ARG},
+      {VAAPI_H264_ENC_MAX_BFRAMES, INTEGER_ARG},
+      {VAAPI_H264_ENC_NUM_SLICES, INTEGER_ARG},
+      {VAAPI_H264_ENC_INIT_QP, INTEGER_ARG},
+      {VAAPI_H264_ENC_MIN_QP, INTEGER_ARG},
+      {VAAPI_H264_ENC_RATE_CONTROL, INTEGER_ARG},
+      {VAAPI_H264_ENC_CABAC, INTEGER_ARG},
+      {VAAPI_H264_ENC_DCT8X8, INTEGER_ARG},
+      {VAAPI_H264_ENC_CPB_LENGTH, INTEGER_ARG},
+      // openh264enc
+      {OPEN_H264_ENC_MUTLITHREAD, INTEGER_ARG},
+      {OPEN_H264_ENC_COMPLEXITY, INTEGER_ARG},
+      {OPEN_H264_ENC_RATE_CONTROL, INTEGER_ARG},
+      {OPEN_H264_ENC_GOP_SIZE, INTEGER_ARG},
+      // eavcenc
+      {EAVC_ENC_PRESET, INTEGER_ARG},
+      {EAVC_ENC_PROFILE, INTEGER_ARG},
+      {EAVC_ENC_PERFORMANCE, INTEGER_ARG},
+      {EAVC_ENC_BITRATE_MODE, INTEGER_ARG},
+      {EAVC_ENC_BITRATE_PASS, INTEGER_ARG},
+      {EAVC_ENC_BITRATE_MAX, INTEGER_ARG},
+      {EAVC_ENC_VBV_SIZE, INTEGER_ARG},
+      {EAVC_ENC_PICTURE_MODE, INTEGER_ARG},
+      {EAVC_ENC_ENTROPY_MODE, INTEGER_ARG},
+      {EAVC_ENC_GOP_MAX_BCOUNT, INTEGER_ARG},
+      {EAVC_ENC_GOP_MAX_LENGTH, INTEGER_ARG},
+      {EAVC_ENC_GOP_MIN_LENGTH, INTEGER_ARG},
+      {EAVC_ENC_LEVEL, INTEGER_ARG},
+      {EAVC_ENC_DEBLOCK_MODE, INTEGER_ARG},
+      {EAVC_ENC_DEBLOCK_ALPHA, INTEGER_ARG},
+      {EAVC_ENC_DEBLOCK_BETA, INTEGER_ARG},
+      {EAVC_ENC_INITIAL_DELAY, INTEGER_ARG},
+      {EAVC_ENC_FIELD_ORDER, INTEGER_ARG},
+      {EAVC_ENC_GOP_ADAPTIVE, FLAG_ARG}};
+  return kArgs;
 }
 
+// one pass over config options instead of lookup per known encoder property
 bool InitVideoEncodersWithArgs(const utils::ArgsMap& config,
                                video_encoders_args_t* video_encoder_args,
                                video_encoders_str_args_t* video_encoder_str_args) {
@@ -51,85 +109,28 @@ bool InitVideoEncodersWithArgs(const utils::ArgsMap& config,
     return false;
   }
 
+  const encoder_args_table_t& table = GetVideoEncodersArgsTable();
   video_encoders_args_t video_encoder_args_;
   video_encoders_str_args_t video_encoder_str_args_;
+  for (auto it = config.begin(); it != config.end(); ++it) {
+    auto arg = table.find(it->first);
+    if (arg == table.end()) {
+      continue;
+    }
 
-  // nvh264enc
-  CheckAndSetValue(config, NV_H264_ENC_PRESET, &video_encoder_args_);
-
-  // mfxh264enc
-  CheckAndSetValue(config, MFX_H264_ENC_PRESET, &video_encoder_args_);
-  CheckAndSetValue(config, MFX_H264_GOP_SIZE, &video_encoder_args_);
-
-  // x264enc
-  CheckAndSetValue(config, X264_ENC_SPEED_PRESET, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_THREADS, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_TUNE, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_KEY_INT_MAX, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_VBV_BUF_CAPACITY, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_RC_LOOKAHED, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_QP_MAX, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_PASS, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_ME, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_SLICED_THREADS, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_B_ADAPT, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_BYTE_STREAM, &video_encoder_args_);
-  CheckAndSetValue(config, X264_ENC_QUANTIZER, &video_encoder_args_);
-
-  CheckAndSetValue(config, X264_ENC_PROFILE, &video_encoder_str_args_);
-  CheckAndSetValue(config, X264_ENC_STREAM_FORMAT, &video_encoder_str_args_);
-  CheckAndSetValue(config, X264_ENC_OPTION_STRING, &video_encoder_str_args_);
-
-  bool x264_enc_inter = false;
-  if (utils::ArgsGetValue(config, X264_ENC_INTERLACED, &x264_enc_inter) && x264_enc_inter) {
-    video_encoder_args_[X264_ENC_INTERLACED] = 1;
-  }
-
-  bool x264_enc_dct = false;
-  if (utils::ArgsGetValue(config, X264_ENC_DCT8X8, &x264_enc_dct) && x264_enc_dct) {
-    video_encoder_args_[X264_ENC_DCT8X8] = 1;
-  }
-
-  // vaapih264enc
-  CheckAndSetValue(config, VAAPI_H264_ENC_KEYFRAME_PERIOD, &video_encoder_args_);
-  CheckAndSetValue(config, VAAPI_H264_ENC_TUNE, &video_encoder_args_);
-  CheckAndSetValue(config, VAAPI_H264_ENC_MAX_BFRAMES, &video_encoder_args_);
-  CheckAndSetValue(config, VAAPI_H264_ENC_NUM_SLICES, &video_encoder_args_);
-  CheckAndSetValue(config, VAAPI_H264_ENC_INIT_QP, &video_encoder_args_);
-  CheckAndSetValue(config, VAAPI_H264_ENC_MIN_QP, &video_encoder_args_);
-  CheckAndSetValue(config, VAAPI_H264_ENC_RATE_CONTROL, &video_encoder_args_);
-  CheckAndSetValue(config, VAAPI_H264_ENC_CABAC, &video_encoder_args_);
-  CheckAndSetValue(config, VAAPI_H264_ENC_DCT8X8, &video_encoder_args_);
-  CheckAndSetValue(config, VAAPI_H264_ENC_CPB_LENGTH, &video_encoder_args_);
-
-  // openh264enc
-  CheckAndSetValue(config, OPEN_H264_ENC_MUTLITHREAD, &video_encoder_args_);
-  CheckAndSetValue(config, OPEN_H264_ENC_COMPLEXITY, &video_encoder_args_);
-  CheckAndSetValue(config, OPEN_H264_ENC_RATE_CONTROL, &video_encoder_args_);
-  CheckAndSetValue(config, OPEN_H264_ENC_GOP_SIZE, &video_encoder_args_);
-
-  // eavcenc
-  CheckAndSetValue(config, EAVC_ENC_PRESET, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_PROFILE, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_PERFORMANCE, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_BITRATE_MODE, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_BITRATE_PASS, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_BITRATE_MAX, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_VBV_SIZE, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_PICTURE_MODE, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_ENTROPY_MODE, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_GOP_MAX_BCOUNT, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_GOP_MAX_LENGTH, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_GOP_MIN_LENGTH, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_LEVEL, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_DEBLOCK_MODE, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_DEBLOCK_ALPHA, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_DEBLOCK_BETA, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_INITIAL_DELAY, &video_encoder_args_);
-  CheckAndSetValue(config, EAVC_ENC_FIELD_ORDER, &video_encoder_args_);
-  bool eabc_enc_gop = false;
-  if (utils::ArgsGetValue(config, EAVC_ENC_GOP_ADAPTIVE, &eabc_enc_gop) && eabc_enc_gop) {
-    video_encoder_args_[EAVC_ENC_GOP_ADAPTIVE] = 1;
+    if (arg->second == INTEGER_ARG) {
+      video_encoders_args_t::mapped_type value;
+      if (common::ConvertFromString(it->second, &value)) {
+        video_encoder_args_[it->first] = value;
+      }
+    } else if (arg->second == STRING_ARG) {
+      video_encoder_str_args_[it->first] = it->second;
+    } else if (arg->second == FLAG_ARG) {
+      bool flag = false;
+      if (common::ConvertFromString(it->second, &flag) && flag) {
+        video_encoder_args_[it->first] = 1;
+      }
+    }
   }
 
   *video_encoder_args = video_encoder_args_;
@@ -139,22 +140,24 @@ bool InitVideoEncodersWithArgs(const utils::ArgsMap& config,
 
 }  // namespace
 
-common::Error make_config(const utils::ArgsMap& config_args, Config** config) {
+common::Error make_config(const StreamConfig& stream_config, Config** config) {
   if (!config) {
     return common::make_error_inval();
   }
 
-  uint8_t stream_type;
-  if (!utils::ArgsGetValue(config_args, TYPE_FIELD, &stream_type)) {
-    return common::make_error("Define " TYPE_FIELD " variable and make it valid");
+  if (!stream_config.IsValid()) {
+    return common::make_error("Define " ID_FIELD ", " TYPE_FIELD " variables and make it valid");
   }
 
+  const utils::ArgsMap& config_args = stream_config.args;
+  const StreamType stream_type = stream_config.type;
+
   if (stream_type == PROXY) {
     return common::make_error("Proxy streams not handled for now");
   }
 
-  input_t input_urls;
-  if (!read_input(config_args, &input_urls)) {
+  const input_t input_urls = stream_config.input;
+  if (input_urls.empty()) {
     return common::make_error("Define " INPUT_FIELD " variable and make it valid");
   }
 
@@ -164,9 +167,10 @@ common::Error make_config(const utils::ArgsMap& config_args, Config** config) {
 
   output_t output_urls;
   if (!is_timeshift_and_rec) {
-    if (!read_output(config_args, &output_urls)) {
+    if (stream_config.output.empty()) {
       return common::make_error("Define " OUTPUT_FIELD " variable and make it valid");
     }
+    output_urls = stream_config.output;
   }
 
   size_t max_restart_attempts;
@@ -175,13 +179,23 @@ common::Error make_config(const utils::ArgsMap& config_args, Config** config) {
   }
   CHECK(max_restart_attempts > 0) << "restart attempts must be grether than 0";
 
-  Config conf(static_cast<StreamType>(stream_type), max_restart_attempts, input_urls, output_urls);
+  Config conf(stream_type, max_restart_attempts, input_urls, output_urls);
 
   time_t ttl_sec;
   if (utils::ArgsGetValue(config_args, AUTO_EXIT_TIME_FIELD, &ttl_sec)) {
     conf.SetTimeToLigeStream(ttl_sec);
   }
 
+  bool analyze_ts;
+  if (utils::ArgsGetValue(config_args, ANALYZE_TS_FIELD, &analyze_ts)) {
+    conf.SetAnalyzeTs(analyze_ts);
+  }
+
+  std::string publish_input;
+  if (utils::ArgsGetValue(config_args, PUBLISH_INPUT_FIELD, &publish_input)) {
+    conf.SetPublishInput(publish_input);
+  }
+
   streams::AudioVideoConfig aconf(conf);
   bool have_video;
   if (utils::ArgsGetValue(config_args, HAVE_VIDEO_FIELD, &have_video)) {
@@ -270,6 +284,16 @@ common::Error make_config(const utils::ArgsMap& config_args, Config** config) {
       econfig->SetAudioEncoder(audio_codec);
     }
 
+    // format of input, lets build demuxer and decoders without decodebin
+    std::string video_parser;
+    if (utils::ArgsGetValue(config_args, VIDEO_PARSER_FIELD, &video_parser)) {
+      econfig->SetInputVideoParser(video_parser);
+    }
+    std::string audio_parser;
+    if (utils::ArgsGetValue(config_args, AUDIO_PARSER_FIELD, &audio_parser)) {
+      econfig->SetInputAudioParser(audio_parser);
+    }
+
     int audio_channels;
     if (utils::ArgsGetValue(config_args, AUDIO_CHANNELS_FIELD, &audio_channels)) {
       econfig->SetAudioChannelsCount(audio_channels);
@@ -346,7 +370,7 @@ common::Error make_config(const utils::ArgsMap& config_args, Config** config) {
     return common::Error();
   }
 
-  return common::make_error("Unknown stream type: " + common::ConvertToString(stream_type));
+  return common::make_error("Unknown stream type: " + common::ConvertToString(static_cast<int>(stream_type)));
 }
 
 }  // namespace stream
@@ -16,13 +16,13 @@
 
 #include <common/error.h>
 
-#include "utils/arg_reader.h"
+#include "base/stream_config.h"
 
 namespace iptv_cloud {
 namespace stream {
 
 class Config;
-common::Error make_config(const utils::ArgsMap& config_args, Config** config) WARN_UNUSED_RESULT;
+common::Error make_config(const StreamConfig& stream_config, Config** config) WARN_UNUSED_RESULT;
 
 }  // namespace stream
 }  // namespace iptv_cloud
@@ -237,6 +237,10 @@ void ElementQueue::SetMaxSizeBytes(guint64 val) {
   SetProperty("max-size-bytes", val);
 }
 
+void ElementQueue::SetLeaky(gint leaky) {
+  SetProperty("leaky", leaky);
+}
+
 void ElementCapsFilter::SetCaps(GstCaps* caps) {
   SetProperty("caps", caps);
 }
@@ -423,6 +427,11 @@ DECLARE_ELEMENT_TRAITS_SPECIALIZATION(VAAPI_DECODEBIN)
 DECLARE_ELEMENT_TRAITS_SPECIALIZATION(VAAPI_POST_PROC)
 DECLARE_ELEMENT_TRAITS_SPECIALIZATION(MFX_VPP)
 DECLARE_ELEMENT_TRAITS_SPECIALIZATION(MFX_H264_DEC)
+DECLARE_ELEMENT_TRAITS_SPECIALIZATION(SHM_SRC)
+DECLARE_ELEMENT_TRAITS_SPECIALIZATION(SHM_SINK)
+DECLARE_ELEMENT_TRAITS_SPECIALIZATION(APP_SINK)
+DECLARE_ELEMENT_TRAITS_SPECIALIZATION(FLV_DEMUX)
+DECLARE_ELEMENT_TRAITS_SPECIALIZATION(AVDEC_AAC)
 
 }  // namespace elements
 }  // namespace stream
@@ -122,6 +122,11 @@ enum SupportedElements {
   ELEMENT_VAAPI_POST_PROC,
   ELEMENT_MFX_VPP,
   ELEMENT_MFX_H264_DEC,
+  ELEMENT_SHM_SRC,
+  ELEMENT_SHM_SINK,
+  ELEMENT_APP_SINK,
+  ELEMENT_FLV_DEMUX,
+  ELEMENT_AVDEC_AAC,
   ELEMENTS_COUNT
 };
 
@@ -334,6 +339,12 @@ class ElementAvdecAc3Fixed : public ElementEx<ELEMENT_AVDEC_AC3_FIXED> {
   using base_class::base_class;
 };
 
+class ElementAvdecAAC : public ElementEx<ELEMENT_AVDEC_AAC> {
+ public:
+  typedef ElementEx<ELEMENT_AVDEC_AAC> base_class;
+  using base_class::base_class;
+};
+
 // demuxer elements
 class ElementHlsDemux : public ElementBinEx<ELEMENT_HLS_DEMUX> {
  public:
@@ -341,14 +352,32 @@ class ElementHlsDemux : public ElementBinEx<ELEMENT_HLS_DEMUX> {
   using base_class::base_class;
 };
 
-class ElementTsDemux : public ElementBinEx<ELEMENT_TS_DEMUX> {
+template <SupportedElements el>
+class ElementDemuxEx : public ElementEx<el> {
  public:
-  typedef ElementBinEx<ELEMENT_TS_DEMUX> base_class;
+  typedef ElementEx<el> base_class;
+  typedef void (*pad_added_callback_t)(GstElement* src, GstPad* new_pad, gpointer user_data);
+  using base_class::base_class;
+
+  gboolean RegisterPadAddedCallback(pad_added_callback_t cb, gpointer user_data) WARN_UNUSED_RESULT {
+    return base_class::RegisterCallback("pad-added", G_CALLBACK(cb), user_data);
+  }
+};
+
+class ElementTsDemux : public ElementDemuxEx<ELEMENT_TS_DEMUX> {
+ public:
+  typedef ElementDemuxEx<ELEMENT_TS_DEMUX> base_class;
   using base_class::base_class;
 
   void SetParsePrivateSections(gboolean parse_private_sections = true);  // Default value: true
 };
 
+class ElementFLVDemux : public ElementDemuxEx<ELEMENT_FLV_DEMUX> {
+ public:
+  typedef ElementDemuxEx<ELEMENT_FLV_DEMUX> base_class;
+  using base_class::base_class;
+};
+
 // common elements
 class ElementQueue : public ElementEx<ELEMENT_QUEUE> {
  public:
@@ -358,6 +387,7 @@ class ElementQueue : public ElementEx<ELEMENT_QUEUE> {
   void SetMaxSizeBuffers(guint val = 200);         // 0 - 4294967295 Default: 200
   void SetMaxSizeTime(guint val = 10485760);       // 0 - 4294967295 Default: 10485760
   void SetMaxSizeBytes(guint64 val = 1000000000);  // 0 - 18446744073709551615 Default: 1000000000
+  void SetLeaky(gint leaky = 0);                   // 0 - no, 1 - upstream, 2 - downstream Default: 0
 };
 
 class ElementQueue2 : public ElementEx<ELEMENT_QUEUE2> {
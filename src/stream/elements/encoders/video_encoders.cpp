@@ -224,6 +224,27 @@ elements_line_t build_video_convert(deinterlace_t deinterlace, ILinker* linker,
   return {first, last};
 }
 
+void set_video_bitrate(Element* codec_element, int video_bitrate) {
+  if (codec_element->GetPluginName() == ElementEAVCEnc::GetPluginName()) {
+    codec_element->SetProperty("bitrate-avg", video_bitrate * 1024);
+    return;
+  }
+
+  int bitrate = video_bitrate;
+  if (codec_element->GetPluginName() == ElementOpenH264Enc::GetPluginName()) {
+    bitrate *= 1024;
+  } else if (codec_element->GetPluginName() == ElementNvX264Enc::GetPluginName()) {
+    // bitrate *= 1024;
+    codec_element->SetProperty("rc-mode", 2);  // constant
+  } else if (codec_element->GetPluginName() == ElementVAAPIH264Enc::GetPluginName()) {
+    codec_element->SetProperty("rate-control", 2);  // constant
+  } else if (codec_element->GetPluginName() == ElementMFXH264Enc::GetPluginName()) {
+    codec_element->SetProperty("rate-control", 1);  // constant
+  }
+
+  codec_element->SetProperty("bitrate", bitrate);
+}
+
 elements_line_t build_video_encoder(const std::string& codec,
                                     bit_rate_t video_bitrate,
                                     const video_encoders_args_t& video_args,
@@ -235,23 +256,7 @@ elements_line_t build_video_encoder(const std::string& codec,
   linker->ElementAdd(codec_element);
 
   if (video_bitrate) {
-    if (codec_element->GetPluginName() == ElementEAVCEnc::GetPluginName()) {
-      codec_element->SetProperty("bitrate-avg", *video_bitrate * 1024);
-    } else {
-      int bitrate = *video_bitrate;
-      if (codec_element->GetPluginName() == ElementOpenH264Enc::GetPluginName()) {
-        bitrate *= 1024;
-      } else if (codec_element->GetPluginName() == ElementNvX264Enc::GetPluginName()) {
-        // bitrate *= 1024;
-        codec_element->SetProperty("rc-mode", 2);  // constant
-      } else if (codec_element->GetPluginName() == ElementVAAPIH264Enc::GetPluginName()) {
-        codec_element->SetProperty("rate-control", 2);  // constant
-      } else if (codec_element->GetPluginName() == ElementMFXH264Enc::GetPluginName()) {
-        codec_element->SetProperty("rate-control", 1);  // constant
-      }
-
-      codec_element->SetProperty("bitrate", bitrate);
-    }
+    set_video_bitrate(codec_element, *video_bitrate);
   }
 
   // https://en.wikibooks.org/wiki/MeGUI/x264_Settings
@@ -117,6 +117,9 @@ Element* make_video_encoder(const std::string& codec, const std::string& name);
 
 elements_line_t build_video_convert(deinterlace_t deinterlace, ILinker* linker, element_id_t video_convert_id);
 
+// also used on a playing encoder, x264enc/nvh264enc/vaapi pick up the new value without restart
+void set_video_bitrate(Element* codec_element, int video_bitrate);
+
 elements_line_t build_video_encoder(const std::string& codec,
                                     bit_rate_t video_bitrate,
                                     const video_encoders_args_t& video_args,
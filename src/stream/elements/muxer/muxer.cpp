@@ -14,6 +14,8 @@
 
 #include "stream/elements/muxer/muxer.h"
 
+#include "base/output_uri.h"  // for OutputUri, IsShmOutputUrl
+
 namespace iptv_cloud {
 namespace stream {
 namespace elements {
@@ -48,6 +50,15 @@ Element* make_muxer(common::uri::Url::scheme scheme, element_id_t muxer_id) {
   return nullptr;
 }
 
+Element* make_muxer(const OutputUri& output, element_id_t muxer_id) {
+  if (IsShmOutputUrl(output)) {
+    return make_mpegtsmux(muxer_id);
+  }
+
+  common::uri::Url uri = output.GetOutput();
+  return make_muxer(uri.GetScheme(), muxer_id);
+}
+
 void ElementFLVMux::SetStreamable(bool streamable) {
   SetProperty("streamable", streamable);
 }
@@ -21,6 +21,7 @@
 #include "stream/stypes.h"
 
 namespace iptv_cloud {
+class OutputUri;
 namespace stream {
 namespace elements {
 namespace muxer {
@@ -51,6 +52,7 @@ ElementRTPMux* make_rtpmux(element_id_t muxer_id);
 ElementMPEGTSMux* make_mpegtsmux(element_id_t muxer_id);
 
 Element* make_muxer(common::uri::Url::scheme scheme, element_id_t muxer_id);
+Element* make_muxer(const OutputUri& output, element_id_t muxer_id);
 
 }  // namespace muxer
 }  // namespace elements
@@ -20,10 +20,12 @@
 
 #include "base/output_uri.h"  // for OutputUri, IsFakeUrl
 
-#include "stream/elements/sink/http.h"  // for build_http_sink, HlsOutput
-#include "stream/elements/sink/rtmp.h"  // for build_rtmp_sink
+#include "stream/elements/sink/http.h"      // for build_http_sink, HlsOutput
+#include "stream/elements/sink/ll_hls.h"    // for make_ll_hls_sink
+#include "stream/elements/sink/rtmp.h"      // for build_rtmp_sink
+#include "stream/elements/sink/shm_ring.h"  // for make_shm_ring_sink
 #include "stream/elements/sink/tcp.h"
-#include "stream/elements/sink/udp.h"  // for build_udp_sink
+#include "stream/elements/sink/udp.h"       // for build_udp_sink
 
 namespace iptv_cloud {
 namespace stream {
@@ -31,6 +33,12 @@ namespace elements {
 namespace sink {
 
 Element* build_output(const OutputUri& output, element_id_t sink_id, bool is_vod) {
+  std::string ring_name;
+  if (IsShmOutputUrl(output, &ring_name)) {
+    // shm://channel_1, read by shm:// inputs of other streams
+    return elements::sink::make_shm_ring_sink(ring_name, sink_id);
+  }
+
   common::uri::Url uri = output.GetOutput();
   common::uri::Url::scheme scheme = uri.GetScheme();
 
@@ -63,6 +71,11 @@ Element* build_output(const OutputUri& output, element_id_t sink_id, bool is_vod
       NOTREACHED() << "Empty playlist name, please create urls like http://localhost/master.m3u8!";
       return nullptr;
     }
+    const OutputUri::hls_type_t hls_type = output.GetHlsType();
+    if (!is_vod && (hls_type == OutputUri::LL_HLS || hls_type == OutputUri::HLS_MEMORY)) {
+      return elements::sink::make_ll_hls_sink(sink_id, http_root.GetPath(), filename,
+                                              hls_type == OutputUri::HLS_MEMORY);
+    }
     elements::sink::HlsOutput hout =
         is_vod ? MakeVodHlsOutput(uri, http_root, filename) : MakeHlsOutput(uri, http_root, filename);
     ElementHLSSink* http_sink = elements::sink::make_http_sink(sink_id, hout);
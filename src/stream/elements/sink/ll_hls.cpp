@@ -0,0 +1,121 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream/elements/sink/ll_hls.h"
+
+#include <memory>
+#include <string>
+
+#include <gst/app/gstappsink.h>
+#include <gst/video/video.h>
+
+#include "utils/hls_shm.h"
+#include "utils/ll_hls.h"
+
+namespace iptv_cloud {
+namespace stream {
+namespace elements {
+namespace sink {
+
+namespace {
+struct LLHlsOutput {
+  LLHlsOutput(utils::IHlsStore* store, const std::string& playlist_name)
+      : store(store), packager(playlist_name, store) {}
+
+  std::unique_ptr<utils::IHlsStore> store;
+  utils::LLHlsPackager packager;
+};
+
+GstFlowReturn new_sample_callback(GstAppSink* sink, gpointer user_data) {
+  LLHlsOutput* output = static_cast<LLHlsOutput*>(user_data);
+  GstSample* sample = gst_app_sink_pull_sample(sink);
+  if (!sample) {
+    return GST_FLOW_EOS;
+  }
+
+  GstBuffer* buffer = gst_sample_get_buffer(sample);
+  GstMapInfo map;
+  if (buffer && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+    common::ErrnoError err = output->packager.Feed(map.data, map.size);
+    if (err) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+    }
+    gst_buffer_unmap(buffer, &map);
+  }
+
+  // encoders cut gop for segment, relays without encoder ignore it
+  if (output->packager.TakeKeyframeRequest()) {
+    GstEvent* event = gst_video_event_new_upstream_force_key_unit(GST_CLOCK_TIME_NONE, TRUE, 0);
+    gst_element_send_event(GST_ELEMENT(sink), event);
+  }
+  gst_sample_unref(sample);
+  return GST_FLOW_OK;
+}
+
+void destroy_output(gpointer user_data) {
+  LLHlsOutput* output = static_cast<LLHlsOutput*>(user_data);
+  delete output;
+}
+}  // namespace
+
+ElementLLHlsSink::ElementLLHlsSink(const std::string& name) : base_class(name), opened_(false) {}
+
+common::ErrnoError ElementLLHlsSink::OpenPackager(const std::string& directory,
+                                                  const std::string& playlist_name,
+                                                  bool in_memory) {
+  if (opened_) {
+    return common::make_errno_error("Packager already opened.", EINVAL);
+  }
+
+  if (directory.empty() || playlist_name.empty()) {
+    return common::make_errno_error_inval();
+  }
+
+  utils::IHlsStore* store = nullptr;
+  if (in_memory) {
+    utils::HlsShmStoreWriter* shm_store = new utils::HlsShmStoreWriter(utils::MakeHlsShmName(directory));
+    common::ErrnoError err = shm_store->Open();
+    if (err) {
+      delete shm_store;
+      return err;
+    }
+    store = shm_store;
+  } else {
+    store = new utils::HlsDirectoryStore(directory);
+  }
+
+  LLHlsOutput* output = new LLHlsOutput(store, playlist_name);
+  GstAppSinkCallbacks callbacks = {nullptr, nullptr, new_sample_callback, {nullptr}};
+  gst_app_sink_set_callbacks(GST_APP_SINK(GetGstElement()), &callbacks, output, destroy_output);
+  opened_ = true;
+  return common::ErrnoError();
+}
+
+ElementLLHlsSink* make_ll_hls_sink(element_id_t sink_id,
+                                   const std::string& directory,
+                                   const std::string& filename,
+                                   bool in_memory) {
+  ElementLLHlsSink* hls_out = make_sink<ElementLLHlsSink>(sink_id);
+  hls_out->SetSync(false);
+  common::ErrnoError err = hls_out->OpenPackager(directory, filename, in_memory);
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+  }
+  return hls_out;
+}
+
+}  // namespace sink
+}  // namespace elements
+}  // namespace stream
+}  // namespace iptv_cloud
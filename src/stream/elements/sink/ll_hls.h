@@ -0,0 +1,53 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+
+#include <common/error.h>
+
+#include "stream/elements/element.h"    // for SupportedElements::ELEMENT_APP_SINK
+#include "stream/elements/sink/sink.h"  // for ElementSync
+
+namespace iptv_cloud {
+namespace stream {
+namespace elements {
+namespace sink {
+
+// muxed ts packaged to low latency hls (parts, preload hints) in http_root or in shared memory
+// store named after http_root, playlist is served with blocking reload by http server of daemon
+class ElementLLHlsSink : public ElementSync<ELEMENT_APP_SINK> {
+ public:
+  typedef ElementSync<ELEMENT_APP_SINK> base_class;
+  explicit ElementLLHlsSink(const std::string& name);
+
+  // packager is owned by gst element, it lives while element is in pipeline
+  common::ErrnoError OpenPackager(const std::string& directory,
+                                  const std::string& playlist_name,
+                                  bool in_memory) WARN_UNUSED_RESULT;
+
+ private:
+  bool opened_;
+};
+
+ElementLLHlsSink* make_ll_hls_sink(element_id_t sink_id,
+                                   const std::string& directory,
+                                   const std::string& filename,
+                                   bool in_memory);
+
+}  // namespace sink
+}  // namespace elements
+}  // namespace stream
+}  // namespace iptv_cloud
@@ -0,0 +1,62 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream/elements/sink/shm.h"
+
+#include <string>
+
+namespace {
+const guint kShmSinkSize = 16 * 1024 * 1024;  // ~4s of 30Mbps for readers behind
+}
+
+namespace iptv_cloud {
+namespace stream {
+namespace elements {
+namespace sink {
+
+void ElementShmSink::SetSocketPath(const std::string& path) {
+  SetProperty("socket-path", path);
+}
+
+void ElementShmSink::SetShmSize(guint size) {
+  SetProperty("shm-size", size);
+}
+
+void ElementShmSink::SetWaitForConnection(bool wait_for_connection) {
+  SetProperty("wait-for-connection", wait_for_connection);
+}
+
+namespace {
+ElementShmSink* setup_shm_sink(ElementShmSink* shm_out, const std::string& socket_path) {
+  shm_out->SetSocketPath(socket_path);
+  shm_out->SetShmSize(kShmSinkSize);
+  shm_out->SetWaitForConnection(false);  // writer never waits for readers
+  shm_out->SetSync(false);
+  return shm_out;
+}
+}  // namespace
+
+ElementShmSink* make_shm_sink(const std::string& socket_path, element_id_t sink_id) {
+  return setup_shm_sink(make_sink<ElementShmSink>(sink_id), socket_path);
+}
+
+ElementShmSink* make_publish_input_sink(const std::string& socket_path, element_id_t input_id) {
+  ElementShmSink* shm_out = make_element<ElementShmSink>(common::MemSPrintf(PUBLISH_INPUT_SINK_NAME_1U, input_id));
+  return setup_shm_sink(shm_out, socket_path);
+}
+
+}  // namespace sink
+}  // namespace elements
+}  // namespace stream
+}  // namespace iptv_cloud
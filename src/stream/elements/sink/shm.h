@@ -0,0 +1,46 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+
+// for element_id_t
+
+#include "stream/elements/element.h"    // for SupportedElements::ELEMENT_SHM_SINK
+#include "stream/elements/sink/sink.h"  // for ElementSync
+
+namespace iptv_cloud {
+namespace stream {
+namespace elements {
+namespace sink {
+
+class ElementShmSink : public ElementSync<ELEMENT_SHM_SINK> {
+ public:
+  typedef ElementSync<ELEMENT_SHM_SINK> base_class;
+  using base_class::base_class;
+
+  void SetSocketPath(const std::string& path);                // String. Default: null
+  void SetShmSize(guint size = 67108864);                     // 0 - 4294967295 Default: 67108864
+  void SetWaitForConnection(bool wait_for_connection = true);  // Default: true
+};
+
+ElementShmSink* make_shm_sink(const std::string& socket_path, element_id_t sink_id);
+// raw input of the stream published for other streams of the service
+ElementShmSink* make_publish_input_sink(const std::string& socket_path, element_id_t input_id);
+
+}  // namespace sink
+}  // namespace elements
+}  // namespace stream
+}  // namespace iptv_cloud
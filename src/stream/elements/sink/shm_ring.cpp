@@ -0,0 +1,91 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream/elements/sink/shm_ring.h"
+
+#include <string>
+
+#include <gst/app/gstappsink.h>
+
+namespace iptv_cloud {
+namespace stream {
+namespace elements {
+namespace sink {
+
+namespace {
+GstFlowReturn new_sample_callback(GstAppSink* sink, gpointer user_data) {
+  utils::ShmRingWriter* writer = static_cast<utils::ShmRingWriter*>(user_data);
+  GstSample* sample = gst_app_sink_pull_sample(sink);
+  if (!sample) {
+    return GST_FLOW_EOS;
+  }
+
+  GstBuffer* buffer = gst_sample_get_buffer(sample);
+  GstMapInfo map;
+  if (buffer && gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+    writer->Write(map.data, map.size);  // readers lapped by too big buffer just jump to live edge
+    gst_buffer_unmap(buffer, &map);
+  }
+  gst_sample_unref(sample);
+  return GST_FLOW_OK;
+}
+
+void destroy_writer(gpointer user_data) {
+  utils::ShmRingWriter* writer = static_cast<utils::ShmRingWriter*>(user_data);
+  delete writer;
+}
+}  // namespace
+
+ElementShmRingSink::ElementShmRingSink(const std::string& name) : base_class(name), writer_(nullptr) {}
+
+common::ErrnoError ElementShmRingSink::OpenRing(const std::string& ring_name, size_t capacity) {
+  if (writer_) {
+    return common::make_errno_error("Shared ring already opened.", EINVAL);
+  }
+
+  utils::ShmRingWriter* writer = new utils::ShmRingWriter(ring_name);
+  common::ErrnoError err = writer->Open(capacity);
+  if (err) {
+    delete writer;
+    return err;
+  }
+
+  GstAppSinkCallbacks callbacks = {nullptr, nullptr, new_sample_callback, {nullptr}};
+  gst_app_sink_set_callbacks(GST_APP_SINK(GetGstElement()), &callbacks, writer, destroy_writer);
+  writer_ = writer;
+  return common::ErrnoError();
+}
+
+utils::ShmRingFanout ElementShmRingSink::GetFanout() const {
+  if (!writer_) {
+    utils::ShmRingFanout empty = {0, 0, 0, 0};
+    return empty;
+  }
+  return writer_->GetFanout();
+}
+
+ElementShmRingSink* make_shm_ring_sink(const std::string& ring_name, element_id_t sink_id) {
+  ElementShmRingSink* shm_out = make_sink<ElementShmRingSink>(sink_id);
+  shm_out->SetSync(false);
+  common::ErrnoError err = shm_out->OpenRing(ring_name);
+  if (err) {
+    DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_ERR);
+  }
+  return shm_out;
+}
+
+}  // namespace sink
+}  // namespace elements
+}  // namespace stream
+}  // namespace iptv_cloud
@@ -0,0 +1,51 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+
+#include <common/error.h>
+
+#include "stream/elements/element.h"    // for SupportedElements::ELEMENT_APP_SINK
+#include "stream/elements/sink/sink.h"  // for ElementSync
+
+#include "utils/shm_ring.h"
+
+namespace iptv_cloud {
+namespace stream {
+namespace elements {
+namespace sink {
+
+// muxed stream written to shared ring for other streams of the node, see shm:// inputs
+class ElementShmRingSink : public ElementSync<ELEMENT_APP_SINK> {
+ public:
+  typedef ElementSync<ELEMENT_APP_SINK> base_class;
+  explicit ElementShmRingSink(const std::string& name);
+
+  // ring is owned by gst element, it lives while element is in pipeline
+  common::ErrnoError OpenRing(const std::string& ring_name,
+                              size_t capacity = utils::ShmRingWriter::DEFAULT_CAPACITY) WARN_UNUSED_RESULT;
+  utils::ShmRingFanout GetFanout() const;
+
+ private:
+  utils::ShmRingWriter* writer_;
+};
+
+ElementShmRingSink* make_shm_ring_sink(const std::string& ring_name, element_id_t sink_id);
+
+}  // namespace sink
+}  // namespace elements
+}  // namespace stream
+}  // namespace iptv_cloud
@@ -14,13 +14,95 @@
 
 #include "stream/elements/sink/tcp.h"
 
+#include <gio/gio.h>
+#include <gst/gst.h>
+
 #include <string>
 
+#include "stream/pad/pad.h"
+
+#include "utils/mpegts.h"
+
 namespace iptv_cloud {
 namespace stream {
 namespace elements {
 namespace sink {
 
+namespace {
+const gint kSyncLatestKeyframe = 2;
+const gint kUnitsFormatTime = 3;
+const gint64 kGopCacheMaxDuration = 10 * GST_SECOND;  // keyframe searched only so far back
+const char kGopCacheKey[] = "gop-cache";
+
+// only the keyframe buffer is not delta one of gop, so the sink bursts a decodable start to new clients,
+// live data is passed as is, muxer repeats tables itself
+GstBuffer* gop_cache_buffer(utils::mpegts::GopCache* cache, GstBuffer* buffer) {
+  GstMapInfo map;
+  if (!gst_buffer_map(buffer, &map, GST_MAP_READ)) {
+    return buffer;
+  }
+
+  const utils::mpegts::GopCache::Action action = cache->Feed(map.data, map.size);
+  gst_buffer_unmap(buffer, &map);
+  if (action == utils::mpegts::GopCache::GOP_UNKNOWN) {
+    return buffer;
+  }
+
+  const bool delta = action == utils::mpegts::GopCache::GOP_CONTINUE;
+  const bool flagged = GST_BUFFER_FLAG_IS_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  if (delta == flagged) {
+    return buffer;
+  }
+
+  buffer = gst_buffer_make_writable(buffer);
+  if (delta) {
+    GST_BUFFER_FLAG_SET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  } else {
+    GST_BUFFER_FLAG_UNSET(buffer, GST_BUFFER_FLAG_DELTA_UNIT);
+  }
+  return buffer;
+}
+
+gboolean gop_cache_list_buffer(GstBuffer** buffer, guint idx, gpointer user_data) {
+  UNUSED(idx);
+  utils::mpegts::GopCache* cache = static_cast<utils::mpegts::GopCache*>(user_data);
+  *buffer = gop_cache_buffer(cache, *buffer);
+  return TRUE;
+}
+
+GstPadProbeReturn gop_cache_probe(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  UNUSED(pad);
+  utils::mpegts::GopCache* cache = static_cast<utils::mpegts::GopCache*>(user_data);
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER) {
+    info->data = gop_cache_buffer(cache, GST_PAD_PROBE_INFO_BUFFER(info));
+  } else if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList* list = gst_buffer_list_make_writable(GST_PAD_PROBE_INFO_BUFFER_LIST(info));
+    gst_buffer_list_foreach(list, gop_cache_list_buffer, cache);
+    info->data = list;
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+// emitted by the sink thread which also writes to clients, so tables go before the burst,
+// continuity counters of them are rewritten by cache to precede the ones of the gop
+void gop_cache_client_added(GstElement* sink, GObject* socket, gpointer user_data) {
+  UNUSED(sink);
+  utils::mpegts::GopCache* cache = static_cast<utils::mpegts::GopCache*>(user_data);
+  uint8_t tables[utils::mpegts::GopCache::TABLES_SIZE];
+  const size_t tables_size = cache->GetTables(tables);
+  if (!tables_size || !G_IS_SOCKET(socket)) {
+    return;
+  }
+
+  g_socket_send(G_SOCKET(socket), reinterpret_cast<const gchar*>(tables), tables_size, nullptr, nullptr);
+}
+
+void destroy_gop_cache(gpointer user_data) {
+  utils::mpegts::GopCache* cache = static_cast<utils::mpegts::GopCache*>(user_data);
+  delete cache;
+}
+}  // namespace
+
 void ElementTCPServerSink::SetHost(const std::string& host) {
   SetProperty("host", host);
 }
@@ -29,10 +111,45 @@ void ElementTCPServerSink::SetPort(uint16_t port) {
   SetProperty("port", port);
 }
 
+void ElementTCPServerSink::SetSyncMethod(gint method) {
+  SetProperty("sync-method", method);
+}
+
+void ElementTCPServerSink::SetUnitsFormat(gint format) {
+  SetProperty("units-format", format);
+}
+
+void ElementTCPServerSink::SetUnitsSoftMax(gint64 units) {
+  SetProperty("units-soft-max", units);
+}
+
+void ElementTCPServerSink::EnableGopCache() {
+  pad::Pad* sink_pad = StaticPad("sink");
+  if (!sink_pad->IsValid()) {
+    delete sink_pad;
+    return;
+  }
+
+  // the sink keeps queued buffers back to the last keyframe, probe only prepares them
+  SetSyncMethod(kSyncLatestKeyframe);
+  SetUnitsFormat(kUnitsFormatTime);
+  SetUnitsSoftMax(kGopCacheMaxDuration);
+  // owned by element, probe and signal handler are gone before it is finalized
+  utils::mpegts::GopCache* cache = new utils::mpegts::GopCache;
+  GstElement* element = GetGstElement();
+  g_object_set_data_full(G_OBJECT(element), kGopCacheKey, cache, destroy_gop_cache);
+  gst_pad_add_probe(sink_pad->GetGstPad(),
+                    static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST),
+                    gop_cache_probe, cache, nullptr);
+  g_signal_connect(element, "client-added", G_CALLBACK(gop_cache_client_added), cache);
+  delete sink_pad;
+}
+
 ElementTCPServerSink* make_tcp_server_sink(const common::net::HostAndPort& host, element_id_t sink_id) {
   ElementTCPServerSink* tcp_out = make_sink<ElementTCPServerSink>(sink_id);
   tcp_out->SetHost(host.GetHost());
   tcp_out->SetPort(host.GetPort());
+  tcp_out->EnableGopCache();
   return tcp_out;
 }
 
@@ -39,6 +39,13 @@ class ElementTCPServerSink : public ElementSync<ELEMENT_TCP_SERVER_SINK> {
 
   void SetHost(const std::string& host = "localhost");  // String; Default: "localhost"
   void SetPort(uint16_t port = 5004);                   // 0 - 65535; Default: 5004
+  void SetSyncMethod(gint method = 0);                  // 0 - latest, 2 - latest-keyframe; Default: 0
+  void SetUnitsFormat(gint format = 4);                 // 2 - bytes, 3 - time, 4 - buffers; Default: 4
+  void SetUnitsSoftMax(gint64 units = -1);              // -1 - 9223372036854775807; Default: -1
+
+  // new clients get PAT/PMT and everything since the last keyframe first, mpeg-ts only,
+  // live data is not changed
+  void EnableGopCache();
 };
 
 ElementTCPServerSink* make_tcp_server_sink(const common::net::HostAndPort& host, element_id_t sink_id);
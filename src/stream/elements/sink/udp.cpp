@@ -16,6 +16,10 @@
 
 #include <string>
 
+namespace {
+const gint kUdpSendBufferSize = 4 * 1024 * 1024;
+}
+
 namespace iptv_cloud {
 namespace stream {
 namespace elements {
@@ -29,10 +33,16 @@ void ElementUDPSink::SetPort(uint16_t port) {
   SetProperty("port", port);
 }
 
+void ElementUDPSink::SetBufferSize(gint size) {
+  SetProperty("buffer-size", size);
+}
+
 ElementUDPSink* make_udp_sink(const common::net::HostAndPort& host, element_id_t sink_id) {
   ElementUDPSink* udp_out = make_sink<ElementUDPSink>(sink_id);
   udp_out->SetHost(host.GetHost());
   udp_out->SetPort(host.GetPort());
+  // buffer lists are sent by one sendmmsg, socket buffer takes the whole burst
+  udp_out->SetBufferSize(kUdpSendBufferSize);
   return udp_out;
 }
 
@@ -39,6 +39,7 @@ class ElementUDPSink : public ElementSync<ELEMENT_UDP_SINK> {
 
   void SetHost(const std::string& host = "localhost");  // String; Default: "localhost"
   void SetPort(uint16_t port = 5004);                   // 0 - 65535; Default: 5004
+  void SetBufferSize(gint size = 0);                    // 0 - 2147483647; Default: 0
 };
 
 ElementUDPSink* make_udp_sink(const common::net::HostAndPort& host, element_id_t sink_id);
@@ -19,6 +19,8 @@
 #include "stream/elements/sources/filesrc.h"
 #include "stream/elements/sources/httpsrc.h"
 #include "stream/elements/sources/rtmpsrc.h"
+#include "stream/elements/sources/shmringsrc.h"
+#include "stream/elements/sources/shmsrc.h"
 #include "stream/elements/sources/tcpsrc.h"
 #include "stream/elements/sources/udpsrc.h"
 
@@ -33,6 +35,18 @@ namespace elements {
 namespace sources {
 
 Element* make_src(const InputUri& uri, element_id_t input_id, gint timeout_secs) {
+  std::string socket_path;
+  if (IsInternalInputUrl(uri, &socket_path)) {
+    // internal:///tmp/iptv_cloud_service_input_0123456789abcdef.sock
+    return make_shm_src(socket_path, input_id);
+  }
+
+  std::string ring_name;
+  if (IsShmInputUrl(uri, &ring_name)) {
+    // shm://channel_1, muxed output of other stream of the node
+    return make_shm_ring_src(ring_name, input_id);
+  }
+
   common::uri::Url url = uri.GetInput();
   common::uri::Url::scheme scheme = url.GetScheme();
   if (scheme == common::uri::Url::file) {
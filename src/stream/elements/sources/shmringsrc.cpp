@@ -0,0 +1,136 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream/elements/sources/shmringsrc.h"
+
+#include <string>
+
+#include <gst/app/gstappsrc.h>
+
+#include "utils/shm_ring.h"
+
+namespace {
+const gsize kReadSize = 188 * 348;        // whole ts packets, ~64Kb
+const guint32 kWaitMsec = 20;             // sleep on ring while writer is quiet, then check flushing
+const guint kReopenIdleWaits = 50;        // ~1s without data, check writer restart
+const gulong kOpenRetryUsec = 100000;     // between attempts while writer not started
+const char kMpegTsCaps[] = "video/mpegts, systemstream=(boolean)true, packetsize=(int)188";
+}  // namespace
+
+namespace iptv_cloud {
+namespace stream {
+namespace elements {
+namespace sources {
+
+namespace {
+bool is_flushing(GstAppSrc* src) {
+  GstPad* pad = GST_BASE_SRC_PAD(src);
+  GST_OBJECT_LOCK(pad);
+  const bool flushing = GST_PAD_IS_FLUSHING(pad);
+  GST_OBJECT_UNLOCK(pad);
+  return flushing;
+}
+
+// runs on appsrc streaming thread, blocks until data or flushing because need-data isn't emitted twice
+void need_data_callback(GstAppSrc* src, guint length, gpointer user_data) {
+  UNUSED(length);
+  utils::ShmRingReader* reader = static_cast<utils::ShmRingReader*>(user_data);
+  GstBuffer* buffer = gst_buffer_new_allocate(nullptr, kReadSize, nullptr);
+  GstMapInfo map;
+  if (!gst_buffer_map(buffer, &map, GST_MAP_WRITE)) {
+    gst_buffer_unref(buffer);
+    return;
+  }
+
+  gsize readed = 0;
+  guint idle = 0;
+  while (!is_flushing(src)) {
+    if (!reader->IsOpened()) {
+      common::ErrnoError err = reader->Open();
+      if (err) {
+        g_usleep(kOpenRetryUsec);
+        continue;
+      }
+      idle = 0;
+    }
+
+    readed = reader->Read(map.data, map.size);
+    if (readed) {
+      break;
+    }
+
+    if (reader->Wait(kWaitMsec)) {
+      idle = 0;
+      continue;
+    }
+
+    if (++idle >= kReopenIdleWaits && reader->IsStale()) {
+      reader->Close();
+    }
+  }
+
+  gst_buffer_unmap(buffer, &map);
+  if (!readed) {
+    gst_buffer_unref(buffer);
+    return;
+  }
+
+  gst_buffer_set_size(buffer, readed);
+  gst_app_src_push_buffer(src, buffer);
+}
+
+void destroy_reader(gpointer user_data) {
+  utils::ShmRingReader* reader = static_cast<utils::ShmRingReader*>(user_data);
+  delete reader;
+}
+}  // namespace
+
+void ElementShmRingSrc::SetIsLive(bool live) {
+  SetProperty("is-live", live);
+}
+
+void ElementShmRingSrc::SetDoTimestamp(bool timestamp) {
+  SetProperty("do-timestamp", timestamp);
+}
+
+void ElementShmRingSrc::SetFormat(GstFormat format) {
+  SetProperty("format", static_cast<gint>(format));
+}
+
+void ElementShmRingSrc::SetCaps(GstCaps* caps) {
+  SetProperty("caps", caps);
+}
+
+void ElementShmRingSrc::AttachRing(const std::string& ring_name) {
+  utils::ShmRingReader* reader = new utils::ShmRingReader(ring_name);
+  GstAppSrcCallbacks callbacks = {need_data_callback, nullptr, nullptr, {nullptr}};
+  gst_app_src_set_callbacks(GST_APP_SRC(GetGstElement()), &callbacks, reader, destroy_reader);
+}
+
+ElementShmRingSrc* make_shm_ring_src(const std::string& ring_name, element_id_t input_id) {
+  ElementShmRingSrc* shm_src = make_sources<ElementShmRingSrc>(input_id);
+  GstCaps* caps = gst_caps_from_string(kMpegTsCaps);
+  shm_src->SetCaps(caps);
+  gst_caps_unref(caps);
+  shm_src->SetIsLive(true);
+  shm_src->SetDoTimestamp(true);  // writer timestamps belong to other pipeline clock
+  shm_src->SetFormat(GST_FORMAT_TIME);
+  shm_src->AttachRing(ring_name);
+  return shm_src;
+}
+
+}  // namespace sources
+}  // namespace elements
+}  // namespace stream
+}  // namespace iptv_cloud
@@ -0,0 +1,52 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+
+#include <gst/gstcaps.h>
+#include <gst/gstformat.h>
+
+// for element_id_t
+
+#include "stream/elements/element.h"  // for ElementEx, SupportedElements::ELEMENT_APP_SRC
+#include "stream/elements/sources/sources.h"
+
+namespace iptv_cloud {
+namespace stream {
+namespace elements {
+namespace sources {
+
+// reads muxed stream of other stream from shared ring, see shm:// outputs
+class ElementShmRingSrc : public ElementEx<ELEMENT_APP_SRC> {
+ public:
+  typedef ElementEx<ELEMENT_APP_SRC> base_class;
+  using base_class::base_class;
+
+  void SetIsLive(bool live = false);            // Default: false
+  void SetDoTimestamp(bool timestamp = false);  // Default: false
+  void SetFormat(GstFormat format = GST_FORMAT_BYTES);  // Default: bytes
+  void SetCaps(GstCaps* caps);
+
+  // reader is owned by gst element, ring can be opened later than element and reopened after writer restart
+  void AttachRing(const std::string& ring_name);
+};
+
+ElementShmRingSrc* make_shm_ring_src(const std::string& ring_name, element_id_t input_id);
+
+}  // namespace sources
+}  // namespace elements
+}  // namespace stream
+}  // namespace iptv_cloud
@@ -14,6 +14,10 @@
 
 #include "stream/elements/sources/udpsrc.h"
 
+namespace {
+const gint kUdpReceiveBufferSize = 4 * 1024 * 1024;  // ~1s of 30Mbps without drops while streaming thread is busy
+}
+
 namespace iptv_cloud {
 namespace stream {
 namespace elements {
@@ -31,10 +35,24 @@ void ElementUDPSrc::SetPort(uint16_t port) {
   SetProperty("port", port);
 }
 
+void ElementUDPSrc::SetBufferSize(gint size) {
+  SetProperty("buffer-size", size);
+}
+
+#if GST_CHECK_VERSION(1, 16, 0)
+void ElementUDPSrc::SetRetrieveSenderAddress(bool retrieve) {
+  SetProperty("retrieve-sender-address", retrieve);
+}
+#endif
+
 ElementUDPSrc* make_udp_src(const common::net::HostAndPort& host, element_id_t input_id) {
   ElementUDPSrc* udpsrc = make_sources<ElementUDPSrc>(input_id);
   udpsrc->SetAddress(host.GetHost());
   udpsrc->SetPort(host.GetPort());
+  udpsrc->SetBufferSize(kUdpReceiveBufferSize);
+#if GST_CHECK_VERSION(1, 16, 0)
+  udpsrc->SetRetrieveSenderAddress(false);  // no GSocketAddress per datagram
+#endif
   return udpsrc;
 }
 
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <gst/gstversion.h>
+
 #include <string>
 
 #include <common/net/types.h>
@@ -36,6 +38,10 @@ class ElementUDPSrc : public ElementEx<ELEMENT_UDP_SRC> {
   void SetAddress(const std::string& host);
   void SetPort(uint16_t port);
   void SetUri(const std::string& uri = "udp://0.0.0.0:5004");  // String. Default: "udp://0.0.0.0:5004"
+  void SetBufferSize(gint size = 0);                           // 0 - 2147483647 Default: 0
+#if GST_CHECK_VERSION(1, 16, 0)
+  void SetRetrieveSenderAddress(bool retrieve = true);  // Default: true
+#endif
 };
 
 ElementUDPSrc* make_udp_src(const common::net::HostAndPort& host, element_id_t input_id);
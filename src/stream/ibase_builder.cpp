@@ -49,6 +49,10 @@ elements::Element* IBaseBuilder::GetElementByName(const std::string& name) const
   return nullptr;
 }
 
+elements_line_t IBaseBuilder::GetElements() const {
+  return pipeline_elements_;
+}
+
 bool IBaseBuilder::ElementAdd(elements::Element* elem) {
   GstBin* pipeline = GST_BIN(pipeline_);
   bool res = gst_bin_add(pipeline, elem->GetGstElement());
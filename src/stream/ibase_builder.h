@@ -44,6 +44,7 @@ class IBaseBuilder : public ILinker {
   bool CreatePipeLine(GstElement** pipeline, elements_line_t* elements) WARN_UNUSED_RESULT;
 
   elements::Element* GetElementByName(const std::string& name) const;
+  elements_line_t GetElements() const;
 
   bool ElementAdd(elements::Element* elem) override;
   bool ElementLink(elements::Element* src, elements::Element* dest) override;
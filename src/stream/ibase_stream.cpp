@@ -22,6 +22,7 @@
 
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -31,6 +32,7 @@
 
 #include "stream/dumpers/dumpers_factory.h"
 #include "stream/elements/element.h"
+#include "stream/elements/sink/shm_ring.h"  // for ElementShmRingSink
 #include "stream/gstreamer_utils.h"
 #include "stream/ibase_builder.h"
 #include "stream/probes.h"  // for Probe (ptr only), PROBE_IN, PROBE_OUT
@@ -68,6 +70,20 @@ struct ctx_holder {
   }
 };
 
+struct ReconfigureTask {
+  ReconfigureTask(iptv_cloud::stream::IBaseStream* stream, const iptv_cloud::stream::Config* config)
+      : stream(stream), config(config) {}
+
+  iptv_cloud::stream::IBaseStream* const stream;
+  const iptv_cloud::stream::Config* config;  // owned by task
+};
+
+void reconfigure_destroy_callback(gpointer user_data) {
+  ReconfigureTask* task = static_cast<ReconfigureTask*>(user_data);
+  destroy(&task->config);
+  delete task;
+}
+
 void RedirectGstLog(GstDebugCategory* category,
                     GstDebugLevel level,
                     const gchar* file,
@@ -169,9 +185,17 @@ IBaseStream::IBaseStream(const Config* config, IStreamClient* client, StreamStru
       probe_out_(),
       loop_(g_main_loop_new(ctx_holder::instance()->ctx, FALSE)),
       pipeline_(nullptr),
+      builder_(nullptr),
+      pipeline_elements_(),
+      reconfigure_mutex_(),
+      reconfigure_source_(nullptr),
+      profiler_(),
+      profile_requested_msec_(0),
       status_tick_(0),
       no_data_panic_tick_(0),
       stats_(stats),
+      live_outputs_(),
+      live_outputs_mutex_(),
       last_exit_status_(EXIT_INNER),
       is_live_(false),
       flags_(INITED_NOTHING),
@@ -187,6 +211,9 @@ IBaseStream::IBaseStream(const Config* config, IStreamClient* client, StreamStru
 
 void IBaseStream::LinkInputPad(GstPad* pad, element_id_t id) {
   Probe* probe = new Probe(PROBE_IN, id, this);
+  if (config_->IsAnalyzeTs()) {
+    probe->EnableTsAnalyzer();
+  }
   probe->LinkPads(pad);
   probe_in_.push_back(probe);
 }
@@ -204,7 +231,8 @@ void IBaseStream::PreExecCleanup() {
     common::uri::Url uri = output.GetOutput();
     common::uri::Url::scheme scheme = uri.GetScheme();
 
-    if (scheme == common::uri::Url::http) {
+    // memory outputs have nothing on disk
+    if (scheme == common::uri::Url::http && output.GetHlsType() != OutputUri::HLS_MEMORY) {
       const common::file_system::ascii_directory_string_path http_path = output.GetHttpRoot();
       utils::RemoveOldFilesByTime(http_path, max_life_time / 1000, CHUNK_EXT);
     }
@@ -224,11 +252,98 @@ bool IBaseStream::InitPipeLine() {
     client_->OnPipelineCreated(this);
   }
 
-  delete builder;
+  builder_ = builder;  // keep for live reconfiguration
   DEBUG_LOG() << "Pipeline for: " << ClassName() << " created";
   return true;
 }
 
+bool IBaseStream::Reconfigure(const Config* config) {
+  if (!config || config->GetType() != GetType()) {
+    return false;
+  }
+
+  if (!IsActive()) {  // pipeline not playing yet, nothing to patch
+    return false;
+  }
+
+  std::unique_lock<std::mutex> lock(reconfigure_mutex_);
+  if (reconfigure_source_) {  // previous one not applied yet
+    return false;
+  }
+
+  GSource* source = g_idle_source_new();
+  g_source_set_callback(source, reconfigure_callback, new ReconfigureTask(this, config), reconfigure_destroy_callback);
+  g_source_attach(source, ctx_holder::instance()->ctx);
+  reconfigure_source_ = source;
+  return true;
+}
+
+void IBaseStream::CancelReconfigure() {
+  std::unique_lock<std::mutex> lock(reconfigure_mutex_);
+  if (reconfigure_source_) {
+    g_source_destroy(reconfigure_source_);
+    g_source_unref(reconfigure_source_);
+    reconfigure_source_ = nullptr;
+  }
+}
+
+bool IBaseStream::ApplyReconfigure(const Config* config) {
+  if (!builder_) {
+    return false;
+  }
+
+  bool res = HandleReconfigure(config);
+  SyncPipelineElements();
+  return res;
+}
+
+void IBaseStream::SyncPipelineElements() {
+  if (builder_) {
+    pipeline_elements_ = builder_->GetElements();
+  }
+}
+
+void IBaseStream::AddOutputStats(element_id_t id, channel_id_t cid) {
+  if (id < stats_->output.size()) {
+    stats_->output[id] = ChannelStats(cid);
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(live_outputs_mutex_);
+  live_outputs_[id] = ChannelStats(cid);
+}
+
+StreamStruct IBaseStream::GetReportStats() const {
+  StreamStruct stats = *stats_;
+  std::unique_lock<std::mutex> lock(live_outputs_mutex_);
+  for (auto it = live_outputs_.begin(); it != live_outputs_.end(); ++it) {
+    stats.output.push_back(it->second);
+  }
+  return stats;
+}
+
+bool IBaseStream::HandleReconfigure(const Config* config) {
+  UNUSED(config);
+  return false;
+}
+
+void IBaseStream::RemoveOutputProbes(element_id_t id) {
+  {
+    std::unique_lock<std::mutex> lock(live_outputs_mutex_);
+    live_outputs_.erase(id);
+  }
+
+  for (auto it = probe_out_.begin(); it != probe_out_.end();) {
+    Probe* probe = *it;
+    if (probe->GetID() == id) {
+      delete probe;
+      it = probe_out_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
 void IBaseStream::ClearOutProbes() {
   for (Probe* probe : probe_out_) {
     delete probe;
@@ -294,6 +409,7 @@ const char* IBaseStream::ClassName() const {
 }
 
 IBaseStream::~IBaseStream() {
+  CancelReconfigure();
   g_main_loop_unref(loop_);
   ClearOutProbes();
   ClearInProbes();
@@ -304,10 +420,12 @@ IBaseStream::~IBaseStream() {
   // pipeline
 
   SetPipelineState(GST_STATE_NULL);
+  profiler_.Detach();
   if (pipeline_) {
     g_object_unref(pipeline_);
     pipeline_ = nullptr;
   }
+  destroy(&builder_);
   SetStatus(NEW);
 }
 
@@ -538,6 +656,18 @@ void IBaseStream::OnInputDataFailed() {
 void IBaseStream::OnInputDataOK() {}
 
 gboolean IBaseStream::HandleMainTimerTick() {
+  // probes cost on every buffer, so they are on only while somebody reads profile
+  const common::time64_t now_msec = common::time::current_utc_mstime();
+  const common::time64_t requested_msec = profile_requested_msec_.load();
+  if (requested_msec && now_msec - requested_msec < profile_window_sec * 1000) {
+    if (!profiler_.IsAttached()) {
+      profiler_.Attach(pipeline_);
+    }
+    profiler_.Sample(now_msec);
+  } else if (profiler_.IsAttached()) {
+    profiler_.Detach();
+  }
+
   const time_t up_time = GetElipsedTime();
   const size_t diff = (no_data_panic_sec - no_data_panic_tick_ + up_time) + 1;
 
@@ -551,12 +681,33 @@ gboolean IBaseStream::HandleMainTimerTick() {
     checkpoint_desire_in_total += stats_->input[i].GetDesireBytesPerSecond();
   }
 
+  for (Probe* probe : probe_in_) {
+    utils::mpegts::TsQuality quality;
+    if (probe->GetID() < input_stream_count && probe->SampleTsQuality(&quality)) {
+      stats_->input[probe->GetID()].SetTsQuality(quality);
+    }
+  }
+
   size_t checkpoint_diff_out_total = 0;
   size_t output_stream_count = stats_->output.size();
   for (size_t i = 0; i < output_stream_count; ++i) {
     size_t checkpoint_diff_out_stream = stats_->output[i].GetDiffTotalBytes();
     stats_->output[i].UpdateBps(diff);
     checkpoint_diff_out_total += checkpoint_diff_out_stream;
+
+    elements::sink::ElementShmRingSink* shm_sink =
+        dynamic_cast<elements::sink::ElementShmRingSink*>(FindElementByName(common::MemSPrintf(SINK_NAME_1U, i)));
+    if (shm_sink) {
+      stats_->output[i].SetShmFanout(shm_sink->GetFanout());
+    }
+  }
+
+  {
+    std::unique_lock<std::mutex> lock(live_outputs_mutex_);
+    for (auto it = live_outputs_.begin(); it != live_outputs_.end(); ++it) {
+      checkpoint_diff_out_total += it->second.GetDiffTotalBytes();
+      it->second.UpdateBps(diff);
+    }
   }
 
   if (up_time > no_data_panic_tick_) {  // check is stream in noraml state
@@ -674,16 +825,27 @@ void IBaseStream::HandleProbeEvent(Probe* probe, GstEvent* event) {
 }
 
 elements::Element* IBaseStream::GetElementByName(const std::string& name) const {
+  elements::Element* el = FindElementByName(name);
+  if (!el) {
+    NOTREACHED() << "Not founded element name: " << name;
+  }
+  return el;
+}
+
+elements::Element* IBaseStream::FindElementByName(const std::string& name) const {
   for (elements::Element* el : pipeline_elements_) {
     if (el->GetName() == name) {
       return el;
     }
   }
 
-  NOTREACHED() << "Not founded element name: " << name;
   return nullptr;
 }
 
+IBaseBuilder* IBaseStream::GetBuilder() const {
+  return builder_;
+}
+
 void IBaseStream::HandleBufferingMessage(GstMessage* message) {
   UNUSED(message);
 }
@@ -739,6 +901,13 @@ void IBaseStream::UpdateStats(const Probe* probe, gsize size) {
     if (probe->GetID() < stats_->output.size()) {
       const size_t prev_total = stats_->output[probe->GetID()].GetTotalBytes();
       stats_->output[probe->GetID()].SetTotalBytes(prev_total + size);
+      return;
+    }
+
+    std::unique_lock<std::mutex> lock(live_outputs_mutex_);
+    auto it = live_outputs_.find(probe->GetID());
+    if (it != live_outputs_.end()) {
+      it->second.SetTotalBytes(it->second.GetTotalBytes() + size);
     }
   }
 }
@@ -757,6 +926,17 @@ gboolean IBaseStream::async_bus_callback(GstBus* bus, GstMessage* message, gpoin
   return stream->HandleAsyncBusMessageReceived(bus, message);
 }
 
+gboolean IBaseStream::reconfigure_callback(gpointer user_data) {
+  ReconfigureTask* task = static_cast<ReconfigureTask*>(user_data);
+  IBaseStream* stream = task->stream;
+  bool applied = stream->ApplyReconfigure(task->config);
+  stream->CancelReconfigure();  // source is dispatched, only drops our ref
+  if (stream->client_) {
+    stream->client_->OnReconfigured(stream, applied);
+  }
+  return G_SOURCE_REMOVE;
+}
+
 bool IBaseStream::DumpIntoFile(const common::file_system::ascii_file_string_path& path) const {
   if (!path.IsValid()) {
     return false;
@@ -770,5 +950,10 @@ bool IBaseStream::DumpIntoFile(const common::file_system::ascii_file_string_path
   return dumper->Dump(GST_BIN(pipeline_), path);
 }
 
+std::vector<ElementProfile> IBaseStream::GetProfile() const {
+  profile_requested_msec_ = common::time::current_utc_mstime();
+  return profiler_.GetProfile();
+}
+
 }  // namespace stream
 }  // namespace iptv_cloud
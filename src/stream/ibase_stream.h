@@ -16,6 +16,9 @@
 
 #include <gst/gstevent.h>
 
+#include <atomic>
+#include <map>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -27,6 +30,7 @@
 #include "base/stream_struct.h"  // for StreamStatus, StreamStruct (ptr only)
 #include "stream/gst_types.h"
 #include "stream/ibase_builder_observer.h"
+#include "stream/pipeline_profiler.h"
 
 namespace iptv_cloud {
 namespace stream {
@@ -54,6 +58,8 @@ class IBaseStream : public common::IMetaClassInfo, public IBaseBuilderObserver {
     virtual GstPadProbeInfo* OnCheckReveivedData(IBaseStream* stream, Probe* probe, GstPadProbeInfo* info) = 0;
     virtual void OnInputChanged(const InputUri& uri) = 0;
     virtual void OnPipelineCreated(IBaseStream* stream) = 0;
+    // called in pipeline loop thread after Reconfigure, not called if stream quits before
+    virtual void OnReconfigured(IBaseStream* stream, bool applied) = 0;
     virtual ~IStreamClient();
   };
 
@@ -62,7 +68,8 @@ class IBaseStream : public common::IMetaClassInfo, public IBaseBuilderObserver {
     main_timer_msecs = 1000,
     no_data_panic_sec = 60,
     src_timeout_sec = no_data_panic_sec * 2,
-    cleanup_period_sec = 24 * 60 * 60
+    cleanup_period_sec = 24 * 60 * 60,
+    profile_window_sec = PipelineProfiler::history_size  // probes kept after last profile request
   };
 
   // channel_id_t not empty
@@ -72,11 +79,14 @@ class IBaseStream : public common::IMetaClassInfo, public IBaseBuilderObserver {
 
   ExitStatus Exec();
   void Restart();
+  // schedule apply of config on the playing pipeline, takes config if true, result in IStreamClient::OnReconfigured
+  bool Reconfigure(const Config* config) WARN_UNUSED_RESULT;
 
   bool IsLive() const;
 
   void Quit(ExitStatus status);
   StreamStruct* GetStats() const;
+  StreamStruct GetReportStats() const;  // stats with outputs added by live reconfigure
 
   time_t GetElipsedTime() const;  // stream life time sec
 
@@ -102,9 +112,13 @@ class IBaseStream : public common::IMetaClassInfo, public IBaseBuilderObserver {
   size_t CountOutEOS() const;
 
   bool DumpIntoFile(const common::file_system::ascii_file_string_path& path) const;
+  // any thread, profiler is attached by first call and detached when nobody asks for profile_window_sec
+  std::vector<ElementProfile> GetProfile() const;
 
  protected:
   elements::Element* GetElementByName(const std::string& name) const;
+  elements::Element* FindElementByName(const std::string& name) const;  // nullptr if not in pipeline
+  IBaseBuilder* GetBuilder() const;
 
   bool IsAudioInited() const;
   bool IsVideoInited() const;
@@ -119,6 +133,11 @@ class IBaseStream : public common::IMetaClassInfo, public IBaseBuilderObserver {
   void OnOutputSinkPadCreated(common::uri::Url::scheme scheme, pad::Pad* sink_pad, element_id_t id) override = 0;
 
   virtual IBaseBuilder* CreateBuilder() = 0;
+  // called in pipeline loop thread, config type equal to current
+  virtual bool HandleReconfigure(const Config* config);
+  void RemoveOutputProbes(element_id_t id);
+  void AddOutputStats(element_id_t id, channel_id_t cid);  // live added output, stats indexed by branch id
+  void SyncPipelineElements();                             // builder changed pipeline outside of reconfigure
 
   virtual void PreLoop() = 0;
   virtual void PostLoop(ExitStatus status) = 0;
@@ -156,6 +175,8 @@ class IBaseStream : public common::IMetaClassInfo, public IBaseBuilderObserver {
   std::vector<Probe*> probe_out_;
 
   bool InitPipeLine();
+  bool ApplyReconfigure(const Config* config);
+  void CancelReconfigure();
   void ClearOutProbes();
   void ClearInProbes();
   void ResetDataWait();
@@ -163,16 +184,25 @@ class IBaseStream : public common::IMetaClassInfo, public IBaseBuilderObserver {
   static GstBusSyncReply sync_bus_callback(GstBus* bus, GstMessage* message, gpointer user_data);
   static gboolean main_timer_callback(gpointer user_data);
   static gboolean async_bus_callback(GstBus* bus, GstMessage* message, gpointer user_data);
+  static gboolean reconfigure_callback(gpointer user_data);
 
   //! Gstreamer loop pointer. You set it up with you custom run-loop.
   GMainLoop* const loop_;
   GstElement* pipeline_;
+  IBaseBuilder* builder_;
   elements_line_t pipeline_elements_;
+  std::mutex reconfigure_mutex_;
+  GSource* reconfigure_source_;  // pending live reconfigure, guarded by reconfigure_mutex_
+  PipelineProfiler profiler_;
+  mutable std::atomic<common::time64_t> profile_requested_msec_;  // 0 - profiling off
 
   time_t status_tick_;
   time_t no_data_panic_tick_;
 
   StreamStruct* const stats_;
+  // stats_ lives in memory shared with service, outputs added live are kept here and reported over pipe
+  std::map<element_id_t, ChannelStats> live_outputs_;
+  mutable std::mutex live_outputs_mutex_;
 
   ExitStatus last_exit_status_;
   bool is_live_;
@@ -0,0 +1,376 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream/logo_overlay.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include <cairo.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define HAVE_X86_KERNELS
+#endif
+
+namespace {
+
+// dst = src + dst * inv_alpha / 255, exact rounding, same result for all kernels
+void BlendRowScalar(uint8_t* dst, const uint8_t* src, const uint8_t* inv_alpha, int count) {
+  for (int i = 0; i < count; ++i) {
+    const unsigned t = dst[i] * inv_alpha[i] + 128;
+    const unsigned value = src[i] + ((t + (t >> 8)) >> 8);
+    dst[i] = value > 255 ? 255 : value;
+  }
+}
+
+#if defined(HAVE_X86_KERNELS)
+__attribute__((target("sse4.1"))) void BlendRowSse4(uint8_t* dst,
+                                                    const uint8_t* src,
+                                                    const uint8_t* inv_alpha,
+                                                    int count) {
+  const __m128i round = _mm_set1_epi16(128);
+  int i = 0;
+  for (; i + 16 <= count; i += 16) {
+    const __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i*>(dst + i));
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(inv_alpha + i));
+    const __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+
+    __m128i lo = _mm_add_epi16(_mm_mullo_epi16(_mm_cvtepu8_epi16(d), _mm_cvtepu8_epi16(a)), round);
+    __m128i hi = _mm_add_epi16(
+        _mm_mullo_epi16(_mm_cvtepu8_epi16(_mm_srli_si128(d, 8)), _mm_cvtepu8_epi16(_mm_srli_si128(a, 8))), round);
+    lo = _mm_srli_epi16(_mm_add_epi16(lo, _mm_srli_epi16(lo, 8)), 8);
+    hi = _mm_srli_epi16(_mm_add_epi16(hi, _mm_srli_epi16(hi, 8)), 8);
+
+    const __m128i result = _mm_adds_epu8(_mm_packus_epi16(lo, hi), s);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), result);
+  }
+  BlendRowScalar(dst + i, src + i, inv_alpha + i, count - i);
+}
+
+__attribute__((target("avx2"))) void BlendRowAvx2(uint8_t* dst,
+                                                  const uint8_t* src,
+                                                  const uint8_t* inv_alpha,
+                                                  int count) {
+  const __m256i round = _mm256_set1_epi16(128);
+  int i = 0;
+  for (; i + 32 <= count; i += 32) {
+    const __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(dst + i));
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(inv_alpha + i));
+    const __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+
+    __m256i lo = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_castsi256_si128(d)),
+                                                     _mm256_cvtepu8_epi16(_mm256_castsi256_si128(a))),
+                                  round);
+    __m256i hi = _mm256_add_epi16(_mm256_mullo_epi16(_mm256_cvtepu8_epi16(_mm256_extracti128_si256(d, 1)),
+                                                     _mm256_cvtepu8_epi16(_mm256_extracti128_si256(a, 1))),
+                                  round);
+    lo = _mm256_srli_epi16(_mm256_add_epi16(lo, _mm256_srli_epi16(lo, 8)), 8);
+    hi = _mm256_srli_epi16(_mm256_add_epi16(hi, _mm256_srli_epi16(hi, 8)), 8);
+
+    // packus works per 128 bit lane, restore byte order
+    const __m256i packed = _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xD8);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_adds_epu8(packed, s));
+  }
+  BlendRowSse4(dst + i, src + i, inv_alpha + i, count - i);
+}
+#endif
+
+typedef void (*blend_row_t)(uint8_t* dst, const uint8_t* src, const uint8_t* inv_alpha, int count);
+
+blend_row_t GetBlendRow(iptv_cloud::stream::LogoOverlay::Kernel kernel) {
+#if defined(HAVE_X86_KERNELS)
+  if (kernel == iptv_cloud::stream::LogoOverlay::KERNEL_AVX2) {
+    return BlendRowAvx2;
+  } else if (kernel == iptv_cloud::stream::LogoOverlay::KERNEL_SSE4) {
+    return BlendRowSse4;
+  }
+#else
+  UNUSED(kernel);
+#endif
+  return BlendRowScalar;
+}
+
+uint8_t ToByte(float value) {
+  return static_cast<uint8_t>(std::min(255L, std::max(0L, lroundf(value))));
+}
+
+}  // namespace
+
+namespace iptv_cloud {
+namespace stream {
+
+LogoOverlay::LogoOverlay()
+    : origin_x_(0),
+      origin_y_(0),
+      width_(0),
+      height_(0),
+      luma_(),
+      cb_(),
+      cr_(),
+      alpha_(),
+      kernel_(GetBestKernel()),
+      prepared_(false),
+      frame_(),
+      luma_plane_(),
+      u_plane_(),
+      v_plane_(),
+      frame_valid_(false),
+      caps_frame_() {}
+
+void LogoOverlay::SetImage(const uint32_t* argb,
+                           int width,
+                           int height,
+                           int stride,
+                           const common::draw::Point& position,
+                           alpha_t alpha) {
+  // even origin keeps 2x2 chroma blocks aligned with frame
+  const int pad_x = position.x & 1;
+  const int pad_y = position.y & 1;
+  origin_x_ = position.x - pad_x;
+  origin_y_ = position.y - pad_y;
+  width_ = (width + pad_x + 1) & ~1;
+  height_ = (height + pad_y + 1) & ~1;
+
+  const size_t size = width_ * height_;
+  luma_.assign(size, 0);
+  cb_.assign(size, 0);
+  cr_.assign(size, 0);
+  alpha_.assign(size, 0);
+
+  const float global_alpha = static_cast<float>(std::min(1.0, std::max(0.0, alpha)));
+  for (int y = 0; y < height; ++y) {
+    const uint32_t* row = argb + y * (stride / 4);
+    for (int x = 0; x < width; ++x) {
+      const uint32_t pixel = row[x];
+      const float scale = global_alpha / 255;
+      const float a = (pixel >> 24) * scale;
+      const float r = ((pixel >> 16) & 0xFF) * scale;
+      const float g = ((pixel >> 8) & 0xFF) * scale;
+      const float b = (pixel & 0xFF) * scale;
+
+      // bt.601 limited range, on premultiplied rgb
+      const size_t idx = (y + pad_y) * width_ + x + pad_x;
+      luma_[idx] = a * 16 + 65.481f * r + 128.553f * g + 24.966f * b;
+      cb_[idx] = a * 128 - 37.797f * r - 74.203f * g + 112.0f * b;
+      cr_[idx] = a * 128 + 112.0f * r - 93.786f * g - 18.214f * b;
+      alpha_[idx] = a;
+    }
+  }
+  prepared_ = false;
+}
+
+common::Error LogoOverlay::LoadPng(const std::string& path, const common::draw::Point& position, alpha_t alpha) {
+  cairo_surface_t* surface = cairo_image_surface_create_from_png(path.c_str());
+  if (cairo_surface_status(surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy(surface);
+    return common::make_error("Can't load logo: " + path);
+  }
+
+  cairo_surface_flush(surface);
+  const cairo_format_t format = cairo_image_surface_get_format(surface);
+  const int width = cairo_image_surface_get_width(surface);
+  const int height = cairo_image_surface_get_height(surface);
+  const int stride = cairo_image_surface_get_stride(surface);
+  const uint32_t* data = reinterpret_cast<const uint32_t*>(cairo_image_surface_get_data(surface));
+  if (format == CAIRO_FORMAT_ARGB32) {
+    SetImage(data, width, height, stride, position, alpha);
+  } else if (format == CAIRO_FORMAT_RGB24) {
+    std::vector<uint32_t> opaque(width * height);
+    for (int y = 0; y < height; ++y) {
+      for (int x = 0; x < width; ++x) {
+        opaque[y * width + x] = data[y * (stride / 4) + x] | 0xFF000000;
+      }
+    }
+    SetImage(opaque.data(), width, height, width * 4, position, alpha);
+  } else {
+    cairo_surface_destroy(surface);
+    return common::make_error("Unsupported logo format: " + path);
+  }
+
+  cairo_surface_destroy(surface);
+  return common::Error();
+}
+
+bool LogoOverlay::Blend(const YuvFrameInfo& frame, uint8_t* data, size_t size) {
+  YuvPlanes planes;
+  if (!MapYuvPlanes(frame, data, size, &planes)) {
+    return false;
+  }
+
+  if (!prepared_ || frame != frame_) {
+    Prepare(frame);
+  }
+
+  BlendPlane(luma_plane_, planes.luma, planes.luma_stride);
+  BlendPlane(u_plane_, planes.chroma_u, planes.chroma_stride);
+  if (planes.chroma_v) {
+    BlendPlane(v_plane_, planes.chroma_v, planes.chroma_stride);
+  }
+  return true;
+}
+
+LogoOverlay::Kernel LogoOverlay::GetBestKernel() {
+#if defined(HAVE_X86_KERNELS)
+  __builtin_cpu_init();
+  if (__builtin_cpu_supports("avx2")) {
+    return KERNEL_AVX2;
+  } else if (__builtin_cpu_supports("sse4.1")) {
+    return KERNEL_SSE4;
+  }
+#endif
+  return KERNEL_SCALAR;
+}
+
+LogoOverlay::Kernel LogoOverlay::GetKernel() const {
+  return kernel_;
+}
+
+void LogoOverlay::SetKernel(Kernel kernel) {
+  kernel_ = std::min(kernel, GetBestKernel());
+}
+
+void LogoOverlay::Prepare(const YuvFrameInfo& frame) {
+  frame_ = frame;
+  prepared_ = true;
+
+  // luma, clipped to frame
+  const int x_start = std::max(origin_x_, 0);
+  const int y_start = std::max(origin_y_, 0);
+  const int x_end = std::min(origin_x_ + width_, frame.width & ~1);
+  const int y_end = std::min(origin_y_ + height_, frame.height & ~1);
+  const int width = std::max(0, x_end - x_start);
+  const int height = std::max(0, y_end - y_start);
+
+  luma_plane_.x = x_start;
+  luma_plane_.y = y_start;
+  luma_plane_.width = width;
+  luma_plane_.height = height;
+  luma_plane_.premultiplied.resize(width * height);
+  luma_plane_.inv_alpha.resize(width * height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const size_t src = (y + y_start - origin_y_) * width_ + x + x_start - origin_x_;
+      const uint8_t alpha = ToByte(alpha_[src] * 255);
+      luma_plane_.premultiplied[y * width + x] = std::min(alpha, ToByte(luma_[src]));
+      luma_plane_.inv_alpha[y * width + x] = 255 - alpha;
+    }
+  }
+
+  // chroma, 2x2 average of premultiplied values
+  const bool interleaved = frame.format == YUV_NV12;
+  const int chroma_width = width / 2;
+  const int chroma_height = height / 2;
+  const int bytes_per_sample = interleaved ? 2 : 1;
+  u_plane_.x = x_start / 2 * bytes_per_sample;
+  u_plane_.y = y_start / 2;
+  u_plane_.width = chroma_width * bytes_per_sample;
+  u_plane_.height = chroma_height;
+  u_plane_.premultiplied.resize(u_plane_.width * chroma_height);
+  u_plane_.inv_alpha.resize(u_plane_.width * chroma_height);
+  v_plane_.x = x_start / 2;
+  v_plane_.y = u_plane_.y;
+  v_plane_.width = interleaved ? 0 : chroma_width;
+  v_plane_.height = interleaved ? 0 : chroma_height;
+  v_plane_.premultiplied.resize(v_plane_.width * v_plane_.height);
+  v_plane_.inv_alpha.resize(v_plane_.width * v_plane_.height);
+
+  for (int y = 0; y < chroma_height; ++y) {
+    for (int x = 0; x < chroma_width; ++x) {
+      float cb = 0;
+      float cr = 0;
+      float alpha = 0;
+      for (int k = 0; k < 4; ++k) {
+        const size_t src = (y * 2 + k / 2 + y_start - origin_y_) * width_ + x * 2 + k % 2 + x_start - origin_x_;
+        cb += cb_[src];
+        cr += cr_[src];
+        alpha += alpha_[src];
+      }
+
+      const uint8_t inv_alpha = 255 - ToByte(alpha / 4 * 255);
+      const size_t idx = y * u_plane_.width + x * bytes_per_sample;
+      u_plane_.premultiplied[idx] = ToByte(cb / 4);
+      u_plane_.inv_alpha[idx] = inv_alpha;
+      if (interleaved) {
+        u_plane_.premultiplied[idx + 1] = ToByte(cr / 4);
+        u_plane_.inv_alpha[idx + 1] = inv_alpha;
+      } else {
+        v_plane_.premultiplied[y * chroma_width + x] = ToByte(cr / 4);
+        v_plane_.inv_alpha[y * chroma_width + x] = inv_alpha;
+      }
+    }
+  }
+}
+
+void LogoOverlay::BlendPlane(const Plane& plane, uint8_t* data, int stride) const {
+  const blend_row_t blend_row = GetBlendRow(kernel_);
+  for (int y = 0; y < plane.height; ++y) {
+    uint8_t* dst = data + (plane.y + y) * stride + plane.x;
+    blend_row(dst, &plane.premultiplied[y * plane.width], &plane.inv_alpha[y * plane.width], plane.width);
+  }
+}
+
+bool LogoOverlay::AttachToPad(GstPad* pad, LogoOverlay* overlay) {
+  if (!pad || !overlay) {
+    delete overlay;
+    return false;
+  }
+
+  gulong id_probe = gst_pad_add_probe(
+      pad, static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM),
+      probe_callback, overlay, destroy_callback);
+  return id_probe != 0;
+}
+
+GstPadProbeReturn LogoOverlay::probe_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  UNUSED(pad);
+  LogoOverlay* overlay = reinterpret_cast<LogoOverlay*>(user_data);
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+    if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+      GstCaps* caps = nullptr;
+      gst_event_parse_caps(event, &caps);
+      overlay->frame_valid_ = GetYuvFrameFromCaps(caps, &overlay->caps_frame_);
+    }
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (!overlay->frame_valid_) {
+    return GST_PAD_PROBE_OK;
+  }
+
+  GstBuffer* buffer = gst_buffer_make_writable(GST_PAD_PROBE_INFO_BUFFER(info));
+  GST_PAD_PROBE_INFO_DATA(info) = buffer;
+  if (!SetYuvFrameLayout(buffer, &overlay->caps_frame_)) {
+    return GST_PAD_PROBE_OK;
+  }
+
+  GstMapInfo map;
+  if (!gst_buffer_map(buffer, &map, GST_MAP_WRITE)) {
+    return GST_PAD_PROBE_OK;
+  }
+
+  overlay->Blend(overlay->caps_frame_, map.data, map.size);
+  gst_buffer_unmap(buffer, &map);
+  return GST_PAD_PROBE_OK;
+}
+
+void LogoOverlay::destroy_callback(gpointer user_data) {
+  LogoOverlay* overlay = reinterpret_cast<LogoOverlay*>(user_data);
+  delete overlay;
+}
+
+}  // namespace stream
+}  // namespace iptv_cloud
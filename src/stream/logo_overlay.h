@@ -0,0 +1,95 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <gst/gst.h>
+
+#include <common/draw/types.h>
+#include <common/error.h>
+
+#include "base/types.h"
+
+#include "stream/yuv_frame.h"
+
+namespace iptv_cloud {
+namespace stream {
+
+// blends logo into I420/NV12 frames in place, logo converted once to premultiplied yuv
+// planes clipped to frame, per frame work limited to logo bounding box rows.
+class LogoOverlay {
+ public:
+  enum Kernel { KERNEL_SCALAR = 0, KERNEL_SSE4 = 1, KERNEL_AVX2 = 2 };
+
+  LogoOverlay();
+
+  // cairo ARGB32 layout: native endian premultiplied 0xAARRGGBB
+  void SetImage(const uint32_t* argb, int width, int height, int stride, const common::draw::Point& position,
+                alpha_t alpha);
+  common::Error LoadPng(const std::string& path, const common::draw::Point& position, alpha_t alpha)
+      WARN_UNUSED_RESULT;
+
+  bool Blend(const YuvFrameInfo& frame, uint8_t* data, size_t size);
+
+  static Kernel GetBestKernel();
+  Kernel GetKernel() const;
+  void SetKernel(Kernel kernel);
+
+  // takes ownership of overlay, blends buffers passing pad
+  static bool AttachToPad(GstPad* pad, LogoOverlay* overlay) WARN_UNUSED_RESULT;
+
+ private:
+  struct Plane {
+    int x;  // in plane samples
+    int y;
+    int width;  // in bytes
+    int height;
+    std::vector<uint8_t> premultiplied;
+    std::vector<uint8_t> inv_alpha;  // 255 - alpha
+  };
+
+  void Prepare(const YuvFrameInfo& frame);
+  void BlendPlane(const Plane& plane, uint8_t* data, int stride) const;
+
+  static GstPadProbeReturn probe_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+  static void destroy_callback(gpointer user_data);
+
+  // premultiplied yuv + alpha of logo, full resolution, positioned at even origin
+  int origin_x_;
+  int origin_y_;
+  int width_;
+  int height_;
+  std::vector<float> luma_;
+  std::vector<float> cb_;
+  std::vector<float> cr_;
+  std::vector<float> alpha_;
+
+  Kernel kernel_;
+  bool prepared_;
+  YuvFrameInfo frame_;
+  Plane luma_plane_;
+  Plane u_plane_;  // interleaved uv for NV12
+  Plane v_plane_;
+
+  bool frame_valid_;
+  YuvFrameInfo caps_frame_;
+};
+
+}  // namespace stream
+}  // namespace iptv_cloud
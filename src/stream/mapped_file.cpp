@@ -0,0 +1,212 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream/mapped_file.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+#include <common/macros.h>
+
+namespace {
+
+struct Mapping {
+  void* data;
+  size_t size;
+};
+
+void unmap_callback(gpointer user_data) {
+  Mapping* mapping = static_cast<Mapping*>(user_data);
+  munmap(mapping->data, mapping->size);
+  delete mapping;
+}
+
+size_t PageSize() {
+  static const size_t page_size = sysconf(_SC_PAGESIZE);
+  return page_size;
+}
+
+}  // namespace
+
+namespace iptv_cloud {
+namespace stream {
+
+MappedFile::MappedFile() : fd_(INVALID_DESCRIPTOR), memory_(nullptr), data_(nullptr), size_(0), position_(0) {}
+
+MappedFile::~MappedFile() {
+  Close();
+}
+
+common::ErrnoError MappedFile::Open(const std::string& path) {
+  Close();
+
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  struct stat sb;
+  if (fstat(fd, &sb) == ERROR_RESULT_VALUE) {
+    int err = errno;
+    close(fd);
+    return common::make_errno_error(err);
+  }
+
+  if (!S_ISREG(sb.st_mode) || sb.st_size == 0) {
+    close(fd);
+    return common::make_errno_error("Not regular or empty file", EINVAL);
+  }
+
+  const size_t size = sb.st_size;
+  fd_ = fd;  // size checks and copies
+  size_ = size;
+  position_ = 0;
+  if (time(nullptr) - sb.st_mtime < settled_sec) {
+    posix_fadvise(fd, 0, size, POSIX_FADV_SEQUENTIAL);
+    return common::ErrnoError();
+  }
+
+  void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (data == MAP_FAILED) {
+    return common::ErrnoError();  // copies still work
+  }
+
+  madvise(data, size, MADV_SEQUENTIAL);
+  Mapping* mapping = new Mapping{data, size};
+  memory_ = gst_memory_new_wrapped(GST_MEMORY_FLAG_READONLY, data, size, 0, size, mapping, unmap_callback);
+  data_ = static_cast<uint8_t*>(data);
+  return common::ErrnoError();
+}
+
+bool MappedFile::IsOpen() const {
+  return fd_ != INVALID_DESCRIPTOR;
+}
+
+void MappedFile::Close() {
+  if (memory_) {
+    gst_memory_unref(memory_);  // unmapped after last slice freed
+    memory_ = nullptr;
+  }
+  if (fd_ != INVALID_DESCRIPTOR) {
+    close(fd_);
+    fd_ = INVALID_DESCRIPTOR;
+  }
+  data_ = nullptr;
+  size_ = 0;
+  position_ = 0;
+}
+
+size_t MappedFile::GetSize() const {
+  return size_;
+}
+
+size_t MappedFile::GetPosition() const {
+  return position_;
+}
+
+size_t MappedFile::GetRemaining() const {
+  return size_ - position_;
+}
+
+bool MappedFile::IsEnd() const {
+  return position_ >= size_;
+}
+
+bool MappedFile::IsMapped() const {
+  return memory_ != nullptr;
+}
+
+GstBuffer* MappedFile::ReadBuffer(size_t max_size) {
+  if (!IsOpen() || max_size == 0) {
+    return nullptr;
+  }
+
+  CheckTruncated();
+  if (IsEnd()) {
+    return nullptr;
+  }
+
+  const size_t size = std::min(max_size, GetRemaining());
+  if (!memory_) {
+    return CopyBuffer(size);
+  }
+
+  GstMemory* slice = gst_memory_share(memory_, position_, size);
+  position_ += size;
+
+  // fault in next slice ahead of demuxer
+  const size_t page_size = PageSize();
+  const size_t ahead_start = position_ / page_size * page_size;
+  const size_t ahead_size = std::min(size, size_ - ahead_start);
+  if (ahead_size) {
+    madvise(data_ + ahead_start, ahead_size, MADV_WILLNEED);
+  }
+
+  GstBuffer* buffer = gst_buffer_new();
+  gst_buffer_append_memory(buffer, slice);
+  return buffer;
+}
+
+GstBuffer* MappedFile::CopyBuffer(size_t size) {
+  GstBuffer* buffer = gst_buffer_new_allocate(nullptr, size, nullptr);
+  GstMapInfo map;
+  if (!buffer || !gst_buffer_map(buffer, &map, GST_MAP_WRITE)) {
+    if (buffer) {
+      gst_buffer_unref(buffer);
+    }
+    size_ = position_;
+    return nullptr;
+  }
+
+  const ssize_t read_size = pread(fd_, map.data, size, position_);
+  gst_buffer_unmap(buffer, &map);
+  if (read_size <= 0) {
+    gst_buffer_unref(buffer);
+    size_ = position_;
+    return nullptr;
+  }
+
+  gst_buffer_set_size(buffer, read_size);
+  position_ += read_size;
+  return buffer;
+}
+
+void MappedFile::CheckTruncated() {
+  struct stat sb;
+  if (fstat(fd_, &sb) == ERROR_RESULT_VALUE || static_cast<size_t>(sb.st_size) >= size_) {
+    return;  // grown file is fed up to size at open
+  }
+
+  const size_t size = std::max<size_t>(sb.st_size, position_);
+  WARNING_LOG() << "File truncated while reading, size: " << sb.st_size << ", position: " << position_;
+  size_ = size;
+}
+
+void MappedFile::Prefetch(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd == INVALID_DESCRIPTOR) {
+    return;
+  }
+
+  posix_fadvise(fd, 0, prefetch_size, POSIX_FADV_WILLNEED);
+  close(fd);
+}
+
+}  // namespace stream
+}  // namespace iptv_cloud
@@ -0,0 +1,70 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+
+#include <gst/gst.h>
+
+#include <common/error.h>
+
+namespace iptv_cloud {
+namespace stream {
+
+// read only mapping of file, read buffers are slices over mapping without copy,
+// mapping released when file closed and last buffer freed.
+// Touching mapping beyond end of truncated file raises SIGBUS, so only settled files (not modified
+// for settled_sec) are mapped, recent ones are copied with pread; size is checked before every
+// buffer and file truncated meanwhile ends early.
+class MappedFile {
+ public:
+  enum { prefetch_size = 8 * 1024 * 1024, settled_sec = 60 };
+
+  MappedFile();
+  ~MappedFile();
+
+  common::ErrnoError Open(const std::string& path) WARN_UNUSED_RESULT;
+  bool IsOpen() const;
+  void Close();
+
+  size_t GetSize() const;
+  size_t GetPosition() const;
+  size_t GetRemaining() const;
+  bool IsEnd() const;
+  bool IsMapped() const;
+
+  // nullptr at end of file or on read error, file is at end then
+  GstBuffer* ReadBuffer(size_t max_size);
+
+  // asks kernel to read head of file into page cache
+  static void Prefetch(const std::string& path);
+
+ private:
+  DISALLOW_COPY_AND_ASSIGN(MappedFile);
+
+  GstBuffer* CopyBuffer(size_t size);
+  void CheckTruncated();
+
+  int fd_;
+  GstMemory* memory_;
+  uint8_t* data_;
+  size_t size_;
+  size_t position_;
+};
+
+}  // namespace stream
+}  // namespace iptv_cloud
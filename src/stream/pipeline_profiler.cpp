@@ -0,0 +1,395 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream/pipeline_profiler.h"
+
+#include <time.h>
+
+#include <utility>
+
+namespace {
+
+// sink pad entries of elements on current streaming thread, consumed by the first output
+struct ThreadEntry {
+  uint64_t stats_id;
+  uint64_t nsec;
+};
+
+const size_t kMaxThreadEntries = 32;  // elements of one streaming thread, stale ones are dropped first
+thread_local std::vector<ThreadEntry> g_thread_entries;
+std::atomic<uint64_t> g_stats_id(0);
+
+uint64_t monotonic_nsec() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return static_cast<uint64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+void SetThreadEntry(uint64_t stats_id, uint64_t nsec) {
+  for (ThreadEntry& entry : g_thread_entries) {
+    if (entry.stats_id == stats_id) {
+      entry.nsec = nsec;
+      return;
+    }
+  }
+
+  if (g_thread_entries.size() == kMaxThreadEntries) {
+    g_thread_entries.erase(g_thread_entries.begin());
+  }
+  g_thread_entries.push_back({stats_id, nsec});
+}
+
+uint64_t TakeThreadEntry(uint64_t stats_id) {
+  for (auto it = g_thread_entries.begin(); it != g_thread_entries.end(); ++it) {
+    if (it->stats_id == stats_id) {
+      const uint64_t nsec = it->nsec;
+      g_thread_entries.erase(it);
+      return nsec;
+    }
+  }
+  return 0;
+}
+
+void foreach_and_free(GstIterator* it, GstIteratorForeachFunction func, gpointer user_data) {
+  while (gst_iterator_foreach(it, func, user_data) == GST_ITERATOR_RESYNC) {
+    gst_iterator_resync(it);
+  }
+  gst_iterator_free(it);
+}
+
+}  // namespace
+
+namespace iptv_cloud {
+namespace stream {
+
+// owned by profiler and by each pad probe, probes of removed element are removed with it
+struct PipelineProfiler::ElementStats {
+  explicit ElementStats(GstElement* el)
+      : element(GST_ELEMENT(gst_object_ref(el))),
+        name(GST_ELEMENT_NAME(el)),
+        factory(),
+        is_queue(g_object_class_find_property(G_OBJECT_GET_CLASS(el), "current-level-time") != nullptr),
+        id(++g_stats_id),
+        refs(1),
+        probes_mutex(),
+        probes(),
+        dropped(false),
+        buffers(0),
+        bytes(0),
+        busy_nsec(0),
+        max_nsec(0),
+        prev_buffers(0),
+        prev_bytes(0),
+        prev_busy_nsec(0),
+        history_pos(0),
+        history_count(0) {
+    GstElementFactory* el_factory = gst_element_get_factory(el);
+    if (el_factory) {
+      factory = GST_OBJECT_NAME(el_factory);
+    }
+  }
+
+  ~ElementStats() { gst_object_unref(element); }
+
+  void Enter() { SetThreadEntry(id, monotonic_nsec()); }
+
+  void Leave(uint64_t count, uint64_t size) {
+    buffers += count;
+    bytes += size;
+    // no entry: source, async push from own thread or next output of the same input
+    const uint64_t entry = TakeThreadEntry(id);
+    const uint64_t now = monotonic_nsec();
+    if (entry == 0 || entry > now) {
+      return;
+    }
+
+    const uint64_t spent = now - entry;
+    busy_nsec += spent;
+    uint64_t max = max_nsec.load(std::memory_order_relaxed);
+    while (spent > max && !max_nsec.compare_exchange_weak(max, spent, std::memory_order_relaxed)) {
+    }
+  }
+
+  GstElement* const element;
+  const std::string name;
+  std::string factory;
+  const bool is_queue;
+  const uint64_t id;  // key of thread entries, unlike address never reused
+  std::atomic<int> refs;
+
+  std::mutex probes_mutex;
+  std::vector<std::pair<GstPad*, gulong>> probes;
+  bool dropped;
+
+  // streaming threads
+  std::atomic<uint64_t> buffers;
+  std::atomic<uint64_t> bytes;
+  std::atomic<uint64_t> busy_nsec;
+  std::atomic<uint64_t> max_nsec;
+
+  // guarded by profiler mutex
+  uint64_t prev_buffers;
+  uint64_t prev_bytes;
+  uint64_t prev_busy_nsec;
+  ProfileSample history[history_size];
+  size_t history_pos;
+  size_t history_count;
+
+  DISALLOW_COPY_AND_ASSIGN(ElementStats);
+};
+
+PipelineProfiler::PipelineProfiler()
+    : mutex_(), elements_(), pipeline_(nullptr), element_added_id_(0), element_removed_id_(0) {}
+
+PipelineProfiler::~PipelineProfiler() {
+  Detach();
+}
+
+void PipelineProfiler::Attach(GstElement* pipeline) {
+  Detach();
+  if (!pipeline) {
+    return;
+  }
+
+  pipeline_ = GST_ELEMENT(gst_object_ref(pipeline));
+  // decodebin and friends create elements while playing, removed outputs drop theirs
+  element_added_id_ =
+      g_signal_connect(pipeline_, "deep-element-added", G_CALLBACK(deep_element_added_callback), this);
+  element_removed_id_ =
+      g_signal_connect(pipeline_, "deep-element-removed", G_CALLBACK(deep_element_removed_callback), this);
+
+  foreach_and_free(gst_bin_iterate_recurse(GST_BIN(pipeline_)), element_foreach_callback, this);
+}
+
+void PipelineProfiler::Detach() {
+  if (pipeline_) {
+    g_signal_handler_disconnect(pipeline_, element_added_id_);
+    g_signal_handler_disconnect(pipeline_, element_removed_id_);
+    element_added_id_ = 0;
+    element_removed_id_ = 0;
+    gst_object_unref(pipeline_);
+    pipeline_ = nullptr;
+  }
+
+  std::vector<ElementStats*> elements;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    elements.swap(elements_);
+  }
+  for (ElementStats* stats : elements) {
+    DropStats(stats);
+  }
+}
+
+bool PipelineProfiler::IsAttached() const {
+  return pipeline_ != nullptr;
+}
+
+void PipelineProfiler::Sample(fastotv::timestamp_t timestamp) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (ElementStats* stats : elements_) {
+    const uint64_t buffers = stats->buffers.load(std::memory_order_relaxed);
+    const uint64_t bytes = stats->bytes.load(std::memory_order_relaxed);
+    const uint64_t busy_nsec = stats->busy_nsec.load(std::memory_order_relaxed);
+
+    ProfileSample sample;
+    sample.timestamp = timestamp;
+    sample.buffers = buffers - stats->prev_buffers;
+    sample.bytes = bytes - stats->prev_bytes;
+    sample.busy_nsec = busy_nsec - stats->prev_busy_nsec;
+    sample.max_nsec = stats->max_nsec.exchange(0, std::memory_order_relaxed);
+    if (stats->is_queue) {
+      guint queue_buffers = 0;
+      guint64 queue_nsec = 0;
+      g_object_get(stats->element, "current-level-buffers", &queue_buffers, "current-level-time", &queue_nsec,
+                   nullptr);
+      sample.queue_buffers = queue_buffers;
+      sample.queue_nsec = queue_nsec;
+    }
+
+    stats->prev_buffers = buffers;
+    stats->prev_bytes = bytes;
+    stats->prev_busy_nsec = busy_nsec;
+    stats->history[stats->history_pos] = sample;
+    stats->history_pos = (stats->history_pos + 1) % history_size;
+    if (stats->history_count < history_size) {
+      stats->history_count++;
+    }
+  }
+}
+
+std::vector<ElementProfile> PipelineProfiler::GetProfile() const {
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::vector<ElementProfile> result;
+  result.reserve(elements_.size());
+  for (const ElementStats* stats : elements_) {
+    ElementProfile profile;
+    profile.name = stats->name;
+    profile.factory = stats->factory;
+    profile.samples.reserve(stats->history_count);
+    const size_t oldest = (stats->history_pos + history_size - stats->history_count) % history_size;
+    for (size_t i = 0; i < stats->history_count; ++i) {
+      profile.samples.push_back(stats->history[(oldest + i) % history_size]);
+    }
+    result.push_back(profile);
+  }
+  return result;
+}
+
+void PipelineProfiler::AddElement(GstElement* element) {
+  if (GST_IS_BIN(element)) {
+    return;  // children profiled, ghost pads would count twice
+  }
+
+  ElementStats* stats = new ElementStats(element);
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (const ElementStats* exist : elements_) {
+      if (exist->element == element) {
+        delete stats;
+        return;
+      }
+    }
+    elements_.push_back(stats);
+  }
+
+  g_signal_connect(element, "pad-added", G_CALLBACK(pad_added_callback), stats);
+  foreach_and_free(gst_element_iterate_pads(element), pad_foreach_callback, stats);
+}
+
+void PipelineProfiler::RemoveElement(GstElement* element) {
+  ElementStats* stats = nullptr;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (auto it = elements_.begin(); it != elements_.end(); ++it) {
+      if ((*it)->element == element) {
+        stats = *it;
+        elements_.erase(it);
+        break;
+      }
+    }
+  }
+
+  if (stats) {
+    DropStats(stats);
+  }
+}
+
+void PipelineProfiler::AddPad(ElementStats* stats, GstPad* pad) {
+  const GstPadProbeType type =
+      static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER | GST_PAD_PROBE_TYPE_BUFFER_LIST);
+  GstPadProbeCallback callback = nullptr;
+  if (GST_PAD_IS_SINK(pad)) {
+    callback = sink_probe_callback;
+  } else if (GST_PAD_IS_SRC(pad)) {
+    callback = src_probe_callback;
+  } else {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock(stats->probes_mutex);
+  if (stats->dropped) {
+    return;
+  }
+
+  stats->refs++;
+  const gulong probe_id = gst_pad_add_probe(pad, type, callback, stats, release_stats_callback);
+  if (probe_id) {
+    stats->probes.push_back(std::make_pair(GST_PAD(gst_object_ref(pad)), probe_id));
+  }
+}
+
+void PipelineProfiler::DropStats(ElementStats* stats) {
+  g_signal_handlers_disconnect_by_data(stats->element, stats);
+  {
+    // probe in call releases its reference after return, profiler one keeps stats alive here
+    std::unique_lock<std::mutex> lock(stats->probes_mutex);
+    for (const auto& probe : stats->probes) {
+      gst_pad_remove_probe(probe.first, probe.second);
+      gst_object_unref(probe.first);
+    }
+    stats->probes.clear();
+    stats->dropped = true;
+  }
+  release_stats_callback(stats);
+}
+
+void PipelineProfiler::release_stats_callback(gpointer user_data) {
+  ElementStats* stats = static_cast<ElementStats*>(user_data);
+  if (--stats->refs == 0) {
+    delete stats;
+  }
+}
+
+GstPadProbeReturn PipelineProfiler::sink_probe_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  UNUSED(pad);
+  UNUSED(info);
+  ElementStats* stats = static_cast<ElementStats*>(user_data);
+  stats->Enter();
+  return GST_PAD_PROBE_OK;
+}
+
+GstPadProbeReturn PipelineProfiler::src_probe_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  UNUSED(pad);
+  ElementStats* stats = static_cast<ElementStats*>(user_data);
+  if (info->type & GST_PAD_PROBE_TYPE_BUFFER_LIST) {
+    GstBufferList* list = GST_PAD_PROBE_INFO_BUFFER_LIST(info);
+    const guint len = gst_buffer_list_length(list);
+    uint64_t size = 0;
+    for (guint i = 0; i < len; ++i) {
+      size += gst_buffer_get_size(gst_buffer_list_get(list, i));
+    }
+    stats->Leave(len, size);
+  } else {
+    stats->Leave(1, gst_buffer_get_size(GST_PAD_PROBE_INFO_BUFFER(info)));
+  }
+  return GST_PAD_PROBE_OK;
+}
+
+void PipelineProfiler::deep_element_added_callback(GstBin* bin,
+                                                   GstBin* sub_bin,
+                                                   GstElement* element,
+                                                   gpointer user_data) {
+  UNUSED(bin);
+  UNUSED(sub_bin);
+  PipelineProfiler* profiler = static_cast<PipelineProfiler*>(user_data);
+  profiler->AddElement(element);
+}
+
+void PipelineProfiler::deep_element_removed_callback(GstBin* bin,
+                                                     GstBin* sub_bin,
+                                                     GstElement* element,
+                                                     gpointer user_data) {
+  UNUSED(bin);
+  UNUSED(sub_bin);
+  PipelineProfiler* profiler = static_cast<PipelineProfiler*>(user_data);
+  profiler->RemoveElement(element);
+}
+
+void PipelineProfiler::element_foreach_callback(const GValue* item, gpointer user_data) {
+  PipelineProfiler* profiler = static_cast<PipelineProfiler*>(user_data);
+  profiler->AddElement(GST_ELEMENT(g_value_get_object(item)));
+}
+
+void PipelineProfiler::pad_foreach_callback(const GValue* item, gpointer user_data) {
+  AddPad(static_cast<ElementStats*>(user_data), GST_PAD(g_value_get_object(item)));
+}
+
+void PipelineProfiler::pad_added_callback(GstElement* element, GstPad* pad, gpointer user_data) {
+  UNUSED(element);
+  AddPad(static_cast<ElementStats*>(user_data), pad);
+}
+
+}  // namespace stream
+}  // namespace iptv_cloud
@@ -0,0 +1,76 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include <gst/gst.h>
+
+#include <common/macros.h>
+
+#include "stream_commands_info/profile_info.h"
+
+namespace iptv_cloud {
+namespace stream {
+
+// per element buffer timings from pad probes, sink pad entry to the first src pad exit on the same
+// streaming thread, so downstream chains (tee, demuxers) are not counted. Async elements (queues,
+// aggregators) push from own thread and report only buffers, bytes and queue level.
+// Sampled by main timer into fixed size history ring, attached only while profile is requested.
+class PipelineProfiler {
+ public:
+  enum { history_size = 60 };
+
+  PipelineProfiler();
+  ~PipelineProfiler();
+
+  void Attach(GstElement* pipeline);
+  void Detach();  // any pipeline state, probes running now keep their stats alive
+  bool IsAttached() const;
+
+  void Sample(fastotv::timestamp_t timestamp);
+  std::vector<ElementProfile> GetProfile() const;
+
+ private:
+  struct ElementStats;
+
+  void AddElement(GstElement* element);
+  void RemoveElement(GstElement* element);
+  static void AddPad(ElementStats* stats, GstPad* pad);
+  static void DropStats(ElementStats* stats);
+  static void release_stats_callback(gpointer user_data);
+
+  static GstPadProbeReturn sink_probe_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+  static GstPadProbeReturn src_probe_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+  static void deep_element_added_callback(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer user_data);
+  static void deep_element_removed_callback(GstBin* bin, GstBin* sub_bin, GstElement* element, gpointer user_data);
+  static void element_foreach_callback(const GValue* item, gpointer user_data);
+  static void pad_foreach_callback(const GValue* item, gpointer user_data);
+  static void pad_added_callback(GstElement* element, GstPad* pad, gpointer user_data);
+
+  mutable std::mutex mutex_;
+  std::vector<ElementStats*> elements_;
+  GstElement* pipeline_;
+  gulong element_added_id_;
+  gulong element_removed_id_;
+
+  DISALLOW_COPY_AND_ASSIGN(PipelineProfiler);
+};
+
+}  // namespace stream
+}  // namespace iptv_cloud
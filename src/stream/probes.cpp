@@ -14,11 +14,28 @@
 
 #include "stream/probes.h"
 
+#include <gst/gstbuffer.h>
+#include <gst/gstbufferlist.h>
+#include <gst/gstversion.h>
+
 #include "stream/ibase_stream.h"
 
 namespace iptv_cloud {
 namespace stream {
 
+gsize GetBufferListSize(GstBufferList* list) {
+#if GST_CHECK_VERSION(1, 14, 0)
+  return gst_buffer_list_calculate_size(list);
+#else
+  gsize size = 0;
+  const guint len = gst_buffer_list_length(list);
+  for (guint i = 0; i < len; ++i) {
+    size += gst_buffer_get_size(gst_buffer_list_get(list, i));
+  }
+  return size;
+#endif
+}
+
 Consistency::Consistency()
     : segment(FALSE),
       eos(TRUE),
@@ -28,12 +45,20 @@ Consistency::Consistency()
       saw_serialized_event(FALSE) {}
 
 Probe::Probe(const std::string& name, element_id_t id, IBaseStream* stream)
-    : stream_(stream), name_(name), id_(id), id_buffer_(0), pad_(nullptr), consistency_() {
+    : stream_(stream),
+      name_(name),
+      id_(id),
+      id_buffer_(0),
+      pad_(nullptr),
+      consistency_(),
+      analyzer_(nullptr),
+      last_sample_usec_(0) {
   CHECK(stream);
 }
 
 Probe::~Probe() {
   Clear();
+  delete analyzer_;
 }
 
 const std::string& Probe::GetName() const {
@@ -102,6 +127,44 @@ Consistency Probe::GetConsistency() const {
   return consistency_;
 }
 
+void Probe::EnableTsAnalyzer() {
+  if (analyzer_) {
+    return;
+  }
+
+  analyzer_ = new utils::mpegts::TsAnalyzer;
+  last_sample_usec_ = g_get_monotonic_time();
+}
+
+bool Probe::IsTsAnalyzerEnabled() const {
+  return analyzer_;
+}
+
+bool Probe::SampleTsQuality(utils::mpegts::TsQuality* quality) {
+  if (!analyzer_ || !quality) {
+    return false;
+  }
+
+  const gint64 now = g_get_monotonic_time();
+  analyzer_->Sample((now - last_sample_usec_) / 1000, quality);
+  last_sample_usec_ = now;
+  return true;
+}
+
+void Probe::AnalyzeBuffer(GstBuffer* buffer, gint64 arrival_usec) {
+  // memories are mapped one by one, merging them would copy
+  const guint count = gst_buffer_n_memory(buffer);
+  for (guint i = 0; i < count; ++i) {
+    GstMemory* memory = gst_buffer_peek_memory(buffer, i);
+    GstMapInfo map;
+    if (!gst_memory_map(memory, &map, GST_MAP_READ)) {
+      continue;
+    }
+    analyzer_->Feed(map.data, map.size, arrival_usec);
+    gst_memory_unmap(memory, &map);
+  }
+}
+
 void Probe::destroy_callback_probe(gpointer user_data) {
   Probe* probe = reinterpret_cast<Probe*>(user_data);
   probe->ClearInner();
@@ -119,6 +182,19 @@ GstPadProbeReturn Probe::source_callback_probe_buffer(GstPad* pad, GstPadProbeIn
   if (GST_IS_BUFFER(data)) {
     GstBuffer* buffer = GST_PAD_PROBE_INFO_BUFFER(checked_info);
     stream->UpdateStats(probe, gst_buffer_get_size(buffer));
+    if (probe->analyzer_) {
+      probe->AnalyzeBuffer(buffer, g_get_monotonic_time());
+    }
+  } else if (GST_IS_BUFFER_LIST(data)) {
+    GstBufferList* buffer_list = GST_PAD_PROBE_INFO_BUFFER_LIST(checked_info);
+    stream->UpdateStats(probe, GetBufferListSize(buffer_list));
+    if (probe->analyzer_) {
+      const gint64 arrival_usec = g_get_monotonic_time();
+      const guint len = gst_buffer_list_length(buffer_list);
+      for (guint i = 0; i < len; ++i) {
+        probe->AnalyzeBuffer(gst_buffer_list_get(buffer_list, i), arrival_usec);
+      }
+    }
   } else if (GST_IS_EVENT(data)) {
     GstEvent* event = GST_EVENT(data);
     const gchar* event_name = GST_EVENT_TYPE_NAME(event);
@@ -213,11 +289,7 @@ GstPadProbeReturn Probe::sink_callback_probe_buffer(GstPad* pad, GstPadProbeInfo
     stream->UpdateStats(probe, gst_buffer_get_size(buffer));
   } else if (GST_IS_BUFFER_LIST(data)) {
     GstBufferList* buffer_list = GST_PAD_PROBE_INFO_BUFFER_LIST(checked_info);
-    guint len = gst_buffer_list_length(buffer_list);
-    for (guint i = 0; i < len; ++i) {
-      GstBuffer* buffer = gst_buffer_list_get(buffer_list, i);
-      stream->UpdateStats(probe, gst_buffer_get_size(buffer));
-    }
+    stream->UpdateStats(probe, GetBufferListSize(buffer_list));
   } else if (GST_IS_EVENT(data)) {
     GstEvent* event = GST_EVENT(data);
     const gchar* event_name = GST_EVENT_TYPE_NAME(event);
@@ -22,6 +22,8 @@
 
 #include "stream/stypes.h"
 
+#include "utils/mpegts.h"
+
 #define PROBE_IN "in"
 #define PROBE_OUT "out"
 
@@ -30,6 +32,9 @@ namespace stream {
 
 class IBaseStream;
 
+// payload bytes of all buffers, the list is accounted at once
+gsize GetBufferListSize(GstBufferList* list);
+
 struct Consistency {
   Consistency();
 
@@ -54,6 +59,12 @@ class Probe {
   GstPad* GetPad() const;
   Consistency GetConsistency() const;
 
+  // zero copy ts analyzer on buffers of this probe, streaming thread only feeds it
+  void EnableTsAnalyzer();
+  bool IsTsAnalyzerEnabled() const;
+  // main loop thread, false if analyzer disabled
+  bool SampleTsQuality(utils::mpegts::TsQuality* quality);
+
  private:
   static GstPadProbeReturn sink_callback_probe_buffer(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
   static GstPadProbeReturn source_callback_probe_buffer(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
@@ -62,6 +73,7 @@ class Probe {
   void Link(GstPad* pad);
   void Clear();
   void ClearInner();
+  void AnalyzeBuffer(GstBuffer* buffer, gint64 arrival_usec);
 
   IBaseStream* const stream_;
 
@@ -70,6 +82,8 @@ class Probe {
   gulong id_buffer_;
   GstPad* pad_;
   Consistency consistency_;
+  utils::mpegts::TsAnalyzer* analyzer_;
+  gint64 last_sample_usec_;
 
   DISALLOW_COPY_AND_ASSIGN(Probe);
 };
@@ -15,8 +15,11 @@
 #include "stream/stream_controller.h"
 
 #include <math.h>
+#include <signal.h>
+#include <unistd.h>
 
 #include <gst/gstcompat.h>
+#include <json-c/json_tokener.h>
 
 #include <common/file_system/string_path_utils.h>
 #include <common/system_info/system_info.h>
@@ -36,10 +39,14 @@
 #include "stream/streams_factory.h"  // for isTimeshiftP...
 
 #include "stream_commands_info/changed_sources_info.h"
+#include "stream_commands_info/profile_info.h"
+#include "stream_commands_info/reconfigure_info.h"
 #include "stream_commands_info/restart_info.h"
+#include "stream_commands_info/restart_schedule_info.h"
 #include "stream_commands_info/statistic_info.h"
 #include "stream_commands_info/stop_info.h"
 
+#include "utils/adopt_socket.h"
 #include "utils/arg_converter.h"
 
 namespace iptv_cloud {
@@ -68,6 +75,27 @@ TimeShiftInfo make_timeshift_info(const utils::ArgsMap& args) {
   return tinfo;
 }
 
+bool IsTimeshiftStream(StreamType type) {
+  return type == TIMESHIFT_RECORDER || type == TIMESHIFT_PLAYER || type == CATCHUP;
+}
+
+// volume, logo and video bitrate are patched on playing pipeline, outputs are added/removed as tee branches,
+// everything else needs a new pipeline
+bool IsLiveReconfigurable(const StreamConfig& current, const StreamConfig& next) {
+  if (current.id != next.id || current.type != next.type || current.feedback_dir != next.feedback_dir ||
+      current.log_level != next.log_level || current.input != next.input) {
+    return false;
+  }
+
+  utils::ArgsMap current_args = current.args;
+  utils::ArgsMap next_args = next.args;
+  for (const char* field : {VOLUME_FIELD, LOGO_FIELD, VIDEO_BIT_RATE_FIELD}) {
+    current_args.erase(field);
+    next_args.erase(field);
+  }
+  return current_args == next_args;
+}
+
 bool PrepareStatus(StreamStruct* stats, double cpu_load, std::string* status_out) {
   if (!stats || !status_out) {
     return false;
@@ -96,7 +124,8 @@ class StreamServer : public common::libev::IoLoop {
   typedef common::libev::IoLoop base_class;
   explicit StreamServer(common::libev::IoClient* command_client, common::libev::IoLoopObserver* observer = nullptr)
       : base_class(new common::libev::LibEvLoop, observer),
-        command_client_(static_cast<protocol::protocol_client_t*>(command_client)) {
+        command_client_(static_cast<protocol::protocol_client_t*>(command_client)),
+        command_client_attached_(false) {
     CHECK(command_client);
   }
 
@@ -118,18 +147,34 @@ class StreamServer : public common::libev::IoLoop {
     return nullptr;
   }
 
+  // client is detached while its pipes are replaced
+  void AttachCommandClient() {
+    if (!command_client_attached_) {
+      RegisterClient(command_client_);
+      command_client_attached_ = true;
+    }
+  }
+
+  void DetachCommandClient() {
+    if (command_client_attached_) {
+      UnRegisterClient(command_client_);
+      command_client_attached_ = false;
+    }
+  }
+
   void Started(common::libev::LibEvLoop* loop) override {
-    RegisterClient(command_client_);
+    AttachCommandClient();
     base_class::Started(loop);
   }
 
   void Stopped(common::libev::LibEvLoop* loop) override {
-    UnRegisterClient(command_client_);
+    DetachCommandClient();
     base_class::Stopped(loop);
   }
 
  private:
   protocol::protocol_client_t* const command_client_;
+  bool command_client_attached_;
 };
 
 }  // namespace
@@ -139,16 +184,27 @@ StreamController::StreamController(const std::string& feedback_dir,
                                    StreamStruct* mem)
     : IBaseStream::IStreamClient(),
       feedback_dir_(feedback_dir),
+      stream_config_(),
       config_(nullptr),
       timeshift_info_(),
+      pending_config_(nullptr),
+      pending_timeshift_info_(),
       restart_attempts_(0),
       stop_mutex_(),
       stop_cond_(),
       stop_(false),
+      resume_(false),
+      restart_requested_(false),
       ev_thread_(),
       loop_(new StreamServer(command_client, this)),
       ttl_master_timer_(0),
       libev_started_(2),
+      adopt_socket_(),
+      command_read_fd_(INVALID_DESCRIPTOR),
+      command_write_fd_(INVALID_DESCRIPTOR),
+      service_pid_(0),
+      service_timer_(0),
+      orphan_time_(0),
       mem_(mem),
       origin_(nullptr),
       id_(0) {
@@ -156,22 +212,29 @@ StreamController::StreamController(const std::string& feedback_dir,
   loop_->SetName("main");
 }
 
-common::Error StreamController::Init(const utils::ArgsMap& config_args) {
+void StreamController::SetAdoptSocket(const std::string& path, int command_read_fd, int command_write_fd) {
+  adopt_socket_ = path;
+  command_read_fd_ = command_read_fd;
+  command_write_fd_ = command_write_fd;
+  service_pid_ = getppid();
+}
+
+common::Error StreamController::Init(const StreamConfig& config) {
   Config* lconfig = nullptr;
-  common::Error err = make_config(config_args, &lconfig);
+  common::Error err = make_config(config, &lconfig);
   if (err) {
     return err;
   }
 
+  stream_config_ = config;
   config_ = lconfig;
-  StreamType stream_type = config_->GetType();
-  if (stream_type == TIMESHIFT_RECORDER || stream_type == TIMESHIFT_PLAYER || stream_type == CATCHUP) {
-    timeshift_info_ = make_timeshift_info(config_args);
+  if (IsTimeshiftStream(config_->GetType())) {
+    timeshift_info_ = make_timeshift_info(config.args);
   }
 
   EncoderType enc = CPU;
   std::string video_codec;
-  if (utils::ArgsGetValue(config_args, VIDEO_CODEC_FIELD, &video_codec)) {
+  if (utils::ArgsGetValue(config.args, VIDEO_CODEC_FIELD, &video_codec)) {
     EncoderType lenc;
     if (GetEncoderType(video_codec, &lenc)) {
       enc = lenc;
@@ -188,6 +251,7 @@ StreamController::~StreamController() {
 
   destroy(&loop_);
   streams_deinit();
+  destroy(&pending_config_);
   destroy(&config_);
 }
 
@@ -199,6 +263,16 @@ int StreamController::Exec() {
   libev_started_.Wait();
 
   while (!stop_) {
+    {
+      std::unique_lock<std::mutex> lock(stop_mutex_);
+      if (pending_config_) {
+        destroy(&config_);
+        config_ = pending_config_;
+        timeshift_info_ = pending_timeshift_info_;
+        pending_config_ = nullptr;
+      }
+    }
+
     chunk_index_t start_chunk_index = invalid_chunk_index;
     if (config_->GetType() == TIMESHIFT_PLAYER) {  // if timeshift player or cathcup player
       const streams::TimeshiftConfig* tconfig = static_cast<const streams::TimeshiftConfig*>(config_);
@@ -243,8 +317,16 @@ int StreamController::Exec() {
     fastotv::timestamp_t diff_utc_time = end_utc_now - start_utc_now;
     INFO_LOG() << "Stream exit with status: " << (stabled_status ? "FAILURE" : "SUCCESS")
                << ", signal: " << signal_number << ", working time: " << diff_utc_time << " msec.";
-    if (is_vod) {
-      break;
+    if (is_vod) {  // reported to service as exit status of process
+      return stabled_status;
+    }
+
+    {
+      std::unique_lock<std::mutex> lock(stop_mutex_);
+      if (restart_requested_) {  // back-off of previous failures not carried over
+        restart_requested_ = false;
+        restart_attempts_ = 0;
+      }
     }
 
     if (stabled_status == EXIT_SUCCESS) {
@@ -257,24 +339,29 @@ int StreamController::Exec() {
       continue;
     }
 
-    size_t wait_time = 0;
     if (++restart_attempts_ == config_->GetMaxRestartAttempts()) {
       restart_attempts_ = 0;
       mem_->status = FROZEN;
       DumpStreamStatus(mem_);
-      wait_time = restart_after_frozen_sec;
-    } else {
-      wait_time = restart_attempts_ * (restart_after_frozen_sec / config_->GetMaxRestartAttempts());
     }
 
-    INFO_LOG() << "Automatically restarted after " << wait_time << " seconds, stream restarts: " << mem_->restarts
+    // back-off decided by service for all streams of node
+    INFO_LOG() << "Waiting restart permission, stream restarts: " << mem_->restarts
                << ", attempts: " << restart_attempts_;
+    {
+      std::unique_lock<std::mutex> lock(stop_mutex_);
+      resume_ = false;
+    }
+    RequestRestartPermission();
 
     std::unique_lock<std::mutex> lock(stop_mutex_);
-    std::cv_status interrupt_status = stop_cond_.wait_for(lock, std::chrono::seconds(wait_time));
-    if (interrupt_status == std::cv_status::no_timeout) {  // if notify
-      restart_attempts_ = 0;
+    bool resumed = stop_cond_.wait_for(lock, std::chrono::seconds(restart_permission_timeout_sec),
+                                       [this] { return stop_ || resume_; });
+    if (!resumed) {
+      WARNING_LOG() << "Restart permission not received in " << restart_permission_timeout_sec
+                    << " seconds, restarting.";
     }
+    resume_ = false;
   }
 
   return EXIT_SUCCESS;
@@ -292,6 +379,8 @@ void StreamController::Stop() {
 void StreamController::Restart() {
   {
     std::unique_lock<std::mutex> lock(stop_mutex_);
+    resume_ = true;
+    restart_requested_ = true;
     stop_cond_.notify_all();
   }
   StopStream();
@@ -304,6 +393,9 @@ void StreamController::PreLooped(common::libev::IoLoop* loop) {
     ttl_master_timer_ = loop_->CreateTimer(*ttl_sec, false);
     NOTICE_LOG() << "Set stream ttl: " << *ttl_sec;
   }
+  if (!adopt_socket_.empty()) {
+    service_timer_ = loop_->CreateTimer(service_check_sec, true);
+  }
 
   libev_started_.Wait();
   INFO_LOG() << "Child listening started!";
@@ -314,6 +406,9 @@ void StreamController::PostLooped(common::libev::IoLoop* loop) {
   if (ttl_master_timer_) {
     loop_->RemoveTimer(ttl_master_timer_);
   }
+  if (service_timer_) {
+    loop_->RemoveTimer(service_timer_);
+  }
   INFO_LOG() << "Child listening finished!";
 }
 
@@ -337,6 +432,10 @@ common::ErrnoError StreamController::StreamDataRecived(common::libev::IoClient*
   common::ErrnoError err = pclient->ReadCommand(&input_command);
   if (err) {  // i don't want handle spam, command must be formated according
               // protocol
+    if (WaitAdoption()) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+      return common::ErrnoError();
+    }
     return err;
   }
 
@@ -391,9 +490,82 @@ void StreamController::TimerEmited(common::libev::IoLoop* loop, common::libev::t
       NOTICE_LOG() << "Timeout notified ttl was: " << *ttl_sec;
     }
     Stop();
+  } else if (id == service_timer_) {
+    // pipes of service may stay open in other children, so its exit is noticed by pid
+    if (!orphan_time_) {
+      if (kill(service_pid_, 0) == ERROR_RESULT_VALUE && errno == ESRCH) {
+        WaitAdoption();
+      }
+      return;
+    }
+
+    common::ErrnoError err = TryAdoption();
+    if (!err) {
+      orphan_time_ = 0;
+      static_cast<StreamServer*>(loop_)->AttachCommandClient();
+      NOTICE_LOG() << "Stream adopted by service pid: " << service_pid_;
+      return;
+    }
+
+    const fastotv::timestamp_t orphan_msec = common::time::current_utc_mstime() - orphan_time_;
+    if (orphan_msec > utils::AdoptListener::WAIT_SECONDS * 1000) {
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+      WARNING_LOG() << "Stream not adopted in " << utils::AdoptListener::WAIT_SECONDS << " seconds, stopping.";
+      Stop();
+    }
   }
 }
 
+bool StreamController::WaitAdoption() {
+  if (adopt_socket_.empty()) {
+    return false;
+  }
+
+  if (!orphan_time_) {  // service is gone, the next instance may adopt stream
+    static_cast<StreamServer*>(loop_)->DetachCommandClient();
+    orphan_time_ = common::time::current_utc_mstime();
+    WARNING_LOG() << "Service pid: " << service_pid_ << " lost, waiting adoption on: " << adopt_socket_;
+  }
+  return true;
+}
+
+common::ErrnoError StreamController::TryAdoption() {
+  std::string hello;
+  if (!PrepareStatus(mem_, common::system_info::GetCpuLoad(getpid()), &hello)) {
+    return common::make_errno_error("Failed to prepare adopt request.", EINVAL);
+  }
+
+  int command_pipe[2];
+  if (pipe(command_pipe) == ERROR_RESULT_VALUE) {
+    return common::make_errno_error(errno);
+  }
+
+  int responce_pipe[2];
+  if (pipe(responce_pipe) == ERROR_RESULT_VALUE) {
+    const int err = errno;
+    close(command_pipe[0]);
+    close(command_pipe[1]);
+    return common::make_errno_error(err);
+  }
+
+  // service reads responces and writes commands, kernel passes it own copies
+  pid_t service_pid = 0;
+  common::ErrnoError err =
+      utils::SendAdoptRequest(adopt_socket_, hello, responce_pipe[0], command_pipe[1], &service_pid);
+  close(responce_pipe[0]);
+  close(command_pipe[1]);
+  if (!err && (dup2(command_pipe[0], command_read_fd_) == ERROR_RESULT_VALUE ||
+               dup2(responce_pipe[1], command_write_fd_) == ERROR_RESULT_VALUE)) {
+    err = common::make_errno_error(errno);
+  }
+  close(command_pipe[0]);
+  close(responce_pipe[1]);
+  if (!err) {
+    service_pid_ = service_pid;
+  }
+  return err;
+}
+
 void StreamController::Accepted(common::libev::IoChild* child) {
   UNUSED(child);
 }
@@ -413,6 +585,12 @@ common::ErrnoError StreamController::HandleRequestCommand(common::libev::IoClien
     return HandleRequestStopStream(client, req);
   } else if (req->method == RESTART_STREAM) {
     return HandleRequestRestartStream(client, req);
+  } else if (req->method == RECONFIGURE_STREAM) {
+    return HandleRequestReconfigureStream(client, req);
+  } else if (req->method == RESUME_STREAM) {
+    return HandleRequestResumeStream(client, req);
+  } else if (req->method == GET_PROFILE_STREAM) {
+    return HandleRequestGetProfileStream(client, req);
   }
 
   WARNING_LOG() << "Received unknown command: " << req->method;
@@ -460,6 +638,106 @@ common::ErrnoError StreamController::HandleRequestRestartStream(common::libev::I
   return common::ErrnoError();
 }
 
+common::ErrnoError StreamController::HandleRequestResumeStream(common::libev::IoClient* client,
+                                                               protocol::request_t* req) {
+  CHECK(loop_->IsLoopThread());
+  protocol::protocol_client_t* pclient = static_cast<protocol::protocol_client_t*>(client);
+  protocol::response_t resp = ResumeStreamResponceSuccess(req->id);
+  pclient->WriteResponce(resp);
+
+  std::unique_lock<std::mutex> lock(stop_mutex_);
+  resume_ = true;
+  stop_cond_.notify_all();
+  return common::ErrnoError();
+}
+
+common::ErrnoError StreamController::HandleRequestGetProfileStream(common::libev::IoClient* client,
+                                                                   protocol::request_t* req) {
+  CHECK(loop_->IsLoopThread());
+  protocol::protocol_client_t* pclient = static_cast<protocol::protocol_client_t*>(client);
+  std::vector<ElementProfile> elements;
+  if (origin_) {
+    elements = origin_->GetProfile();
+  }
+
+  ProfileInfo profile(mem_->id, elements);
+  std::string profile_json;
+  common::Error err = profile.SerializeToString(&profile_json);
+  if (err) {
+    const std::string err_str = err->GetDescription();
+    protocol::response_t resp = GetProfileStreamResponceFail(req->id, err_str);
+    pclient->WriteResponce(resp);
+    return common::make_errno_error(err_str, EAGAIN);
+  }
+
+  protocol::response_t resp = GetProfileStreamResponceSuccess(req->id, profile_json);
+  pclient->WriteResponce(resp);
+  return common::ErrnoError();
+}
+
+common::ErrnoError StreamController::HandleRequestReconfigureStream(common::libev::IoClient* client,
+                                                                    protocol::request_t* req) {
+  CHECK(loop_->IsLoopThread());
+  if (!req->params) {
+    return common::make_errno_error_inval();
+  }
+
+  const char* params_ptr = req->params->c_str();
+  json_object* jreconfigure = json_tokener_parse(params_ptr);
+  if (!jreconfigure) {
+    return common::make_errno_error_inval();
+  }
+
+  ReconfigureInfo reconfigure_info;
+  common::Error err = reconfigure_info.DeSerialize(jreconfigure);
+  json_object_put(jreconfigure);
+  if (err) {
+    const std::string err_str = err->GetDescription();
+    return common::make_errno_error(err_str, EAGAIN);
+  }
+
+  const StreamConfig new_stream_config = reconfigure_info.GetConfig();
+  Config* new_config = nullptr;
+  err = make_config(new_stream_config, &new_config);
+  if (err) {
+    const std::string err_str = err->GetDescription();
+    return common::make_errno_error(err_str, EAGAIN);
+  }
+
+  bool scheduled = false;
+  if (IsLiveReconfigurable(stream_config_, new_stream_config) && origin_) {
+    Config* live_config = nullptr;  // owned by pipeline loop till applied
+    common::Error err_live = make_config(new_stream_config, &live_config);
+    if (!err_live) {
+      scheduled = origin_->Reconfigure(live_config);
+      if (!scheduled) {
+        destroy(&live_config);
+      }
+    }
+  }
+
+  stream_config_ = new_stream_config;
+  {
+    std::unique_lock<std::mutex> lock(stop_mutex_);
+    destroy(&pending_config_);
+    pending_config_ = new_config;  // next pipeline built from new config in any case
+    if (IsTimeshiftStream(new_stream_config.type)) {
+      pending_timeshift_info_ = make_timeshift_info(new_stream_config.args);
+    }
+  }
+
+  protocol::protocol_client_t* pclient = static_cast<protocol::protocol_client_t*>(client);
+  protocol::response_t resp = ReconfigureStreamResponceSuccess(req->id);
+  pclient->WriteResponce(resp);
+  if (scheduled) {  // result in OnReconfigured
+    return common::ErrnoError();
+  }
+
+  INFO_LOG() << "Stream reconfiguration requires restart.";
+  Restart();
+  return common::ErrnoError();
+}
+
 void StreamController::StopStream() {
   if (origin_) {
     origin_->Quit(EXIT_SELF);
@@ -474,7 +752,8 @@ void StreamController::RestartStream() {
 
 void StreamController::OnStatusChanged(IBaseStream* stream, StreamStatus status) {
   UNUSED(status);
-  DumpStreamStatus(stream->GetStats());
+  StreamStruct stats = stream->GetReportStats();
+  DumpStreamStatus(&stats);
 }
 
 GstPadProbeInfo* StreamController::OnCheckReveivedData(IBaseStream* stream, Probe* probe, GstPadProbeInfo* info) {
@@ -504,7 +783,8 @@ void StreamController::OnPipelineEOS(IBaseStream* stream) {
 }
 
 void StreamController::OnTimeoutUpdated(IBaseStream* stream) {
-  DumpStreamStatus(stream->GetStats());
+  StreamStruct stats = stream->GetReportStats();
+  DumpStreamStatus(&stats);
 }
 
 void StreamController::OnASyncMessageReceived(IBaseStream* stream, GstMessage* message) {
@@ -529,6 +809,17 @@ void StreamController::OnInputChanged(const InputUri& uri) {
   static_cast<StreamServer*>(loop_)->WriteRequest(req);
 }
 
+void StreamController::OnReconfigured(IBaseStream* stream, bool applied) {
+  UNUSED(stream);
+  if (applied) {
+    INFO_LOG() << "Stream reconfigured without restart.";
+    return;
+  }
+
+  INFO_LOG() << "Stream reconfiguration not applied, restarting.";
+  Restart();  // pending config already set
+}
+
 void StreamController::OnPipelineCreated(IBaseStream* stream) {
   common::file_system::ascii_directory_string_path feedback_dir(feedback_dir_);
   auto dump_file = feedback_dir.MakeFileStringPath(DUMP_FILE_NAME);
@@ -537,6 +828,24 @@ void StreamController::OnPipelineCreated(IBaseStream* stream) {
   }
 }
 
+void StreamController::RequestRestartPermission() {
+  std::string upstream_host;
+  const input_t input = config_->GetInput();
+  if (!input.empty()) {
+    upstream_host = input[0].GetInput().GetHost();
+  }
+
+  RestartScheduleInfo schedule(mem_->id, upstream_host, restart_attempts_);
+  std::string schedule_json;
+  common::Error err = schedule.SerializeToString(&schedule_json);
+  if (err) {
+    return;
+  }
+
+  protocol::request_t req = RestartScheduleStreamBroadcast(schedule_json);
+  static_cast<StreamServer*>(loop_)->WriteRequest(req);
+}
+
 void StreamController::DumpStreamStatus(StreamStruct* stat) {
   std::string status_json;
   if (PrepareStatus(stat, common::system_info::GetCpuLoad(getpid()), &status_json)) {
@@ -21,6 +21,7 @@
 #include <common/libev/io_loop_observer.h>
 #include <common/threads/barrier.h>
 
+#include "base/stream_config.h"
 #include "protocol/types.h"
 #include "stream/ibase_stream.h"
 #include "stream/timeshift.h"
@@ -32,11 +33,19 @@ namespace stream {
 
 class StreamController : public common::libev::IoLoopObserver, public IBaseStream::IStreamClient {
  public:
-  enum constants : uint32_t { restart_after_frozen_sec = 60 };
+  enum constants : uint32_t {
+    restart_after_frozen_sec = 60,
+    restart_permission_timeout_sec = 600,
+    service_check_sec = 1
+  };
 
   StreamController(const std::string& feedback_dir, common::libev::IoClient* command_client, StreamStruct* mem);
 
-  common::Error Init(const utils::ArgsMap& config_args);
+  // when service is gone stream keeps working and waits for the next service instance,
+  // new pipes replace the lost ones behind descriptors of command client
+  void SetAdoptSocket(const std::string& path, int command_read_fd, int command_write_fd);
+
+  common::Error Init(const StreamConfig& config);
 
   ~StreamController() override;
 
@@ -55,6 +64,12 @@ class StreamController : public common::libev::IoLoopObserver, public IBaseStrea
                                              protocol::request_t* req) WARN_UNUSED_RESULT;
   common::ErrnoError HandleRequestRestartStream(common::libev::IoClient* client,
                                                 protocol::request_t* req) WARN_UNUSED_RESULT;
+  common::ErrnoError HandleRequestReconfigureStream(common::libev::IoClient* client,
+                                                    protocol::request_t* req) WARN_UNUSED_RESULT;
+  common::ErrnoError HandleRequestResumeStream(common::libev::IoClient* client,
+                                               protocol::request_t* req) WARN_UNUSED_RESULT;
+  common::ErrnoError HandleRequestGetProfileStream(common::libev::IoClient* client,
+                                                   protocol::request_t* req) WARN_UNUSED_RESULT;
 
   void Stop();
   void Restart();
@@ -75,6 +90,8 @@ class StreamController : public common::libev::IoLoopObserver, public IBaseStrea
   void DataReadyToWrite(common::libev::IoClient* client) override;
 
   common::ErrnoError StreamDataRecived(common::libev::IoClient* client) WARN_UNUSED_RESULT;
+  bool WaitAdoption();
+  common::ErrnoError TryAdoption() WARN_UNUSED_RESULT;
   void StopStream();
   void RestartStream();
 
@@ -89,25 +106,39 @@ class StreamController : public common::libev::IoLoopObserver, public IBaseStrea
   void OnInputChanged(const InputUri& uri) override;
 
   void OnPipelineCreated(IBaseStream* stream) override;
+  void OnReconfigured(IBaseStream* stream, bool applied) override;
 
   common::ErrnoError SendResponceToParent(const std::string& cmd) WARN_UNUSED_RESULT;
 
+  void RequestRestartPermission();
   void DumpStreamStatus(StreamStruct* stat);
 
   const std::string feedback_dir_;
+  StreamConfig stream_config_;  // last requested, libev thread only
   const Config* config_;
   TimeShiftInfo timeshift_info_;
+  const Config* pending_config_;  // used by next stream after restart, guarded by stop_mutex_
+  TimeShiftInfo pending_timeshift_info_;
   size_t restart_attempts_;
 
   std::mutex stop_mutex_;
   std::condition_variable stop_cond_;
   bool stop_;
+  bool resume_;  // restart permitted, guarded by stop_mutex_
+  bool restart_requested_;  // restart requested by client, guarded by stop_mutex_
 
   std::thread ev_thread_;
   common::libev::IoLoop* loop_;
   common::libev::timer_id_t ttl_master_timer_;
   common::threads::barrier libev_started_;
 
+  std::string adopt_socket_;
+  int command_read_fd_;
+  int command_write_fd_;
+  pid_t service_pid_;
+  common::libev::timer_id_t service_timer_;
+  fastotv::timestamp_t orphan_time_;  // 0 while service is alive
+
   StreamStruct* mem_;
 
   //
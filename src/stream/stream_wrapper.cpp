@@ -26,26 +26,43 @@
 #include <common/file_system/string_path_utils.h>
 
 #include "base/config_fields.h"
+#include "base/stream_config.h"
 
 #include "stream/stream_controller.h"
-
-#include "utils/arg_converter.h"
+#include "utils/async_logger.h"
 
 namespace {
 
 const size_t kMaxSizeLogFile = 1024 * 1024;  // 1 MB
+const size_t kLogRecordsCount = 1024;       // ~0.5 MB per stream
+const size_t kDebugLogRecordsCount = 4096;  // debug level logs every buffer of some elements
 
 int start_stream(const std::string& process_name,
+                 const cmd_args* args,
                  const std::string& feedback_dir,
                  common::logging::LOG_LEVEL logs_level,
-                 const iptv_cloud::utils::ArgsMap& config_args,
+                 const iptv_cloud::StreamConfig& config_args,
                  common::libev::IoClient* command_client,
                  iptv_cloud::StreamStruct* mem) {
   const std::string logs_path = common::file_system::make_path(feedback_dir, LOGS_FILE_NAME);
-  common::logging::INIT_LOGGER(process_name, logs_path, logs_level);  // initialization of logging system
+  // gstreamer streaming threads log through async logger ring and never wait for log file
+  common::logging::INIT_LOGGER(process_name, logs_level);  // initialization of logging system
+  const size_t records_count =
+      logs_level >= common::logging::LOG_LEVEL_DEBUG ? kDebugLogRecordsCount : kLogRecordsCount;
+  iptv_cloud::utils::AsyncLogger async_logger(logs_path, kMaxSizeLogFile, records_count);
+  common::ErrnoError errn = async_logger.Start();
+  if (errn) {  // logging library handles file as before
+    common::logging::INIT_LOGGER(process_name, logs_path, logs_level);
+    WARNING_LOG() << "Async logging disabled, error: " << errn->GetDescription();
+  } else {
+    async_logger.AttachStreams();
+  }
   NOTICE_LOG() << "Running " PROJECT_VERSION_HUMAN;
 
   iptv_cloud::stream::StreamController proc(feedback_dir, command_client, mem);
+  if (args->adopt_socket) {
+    proc.SetAdoptSocket(args->adopt_socket, args->command_read_fd, args->command_write_fd);
+  }
   common::Error err = proc.Init(config_args);
   if (err) {
     WARNING_LOG() << err->GetDescription();
@@ -70,7 +87,7 @@ int stream_exec(const char* process_name,
     return EXIT_FAILURE;
   }
 
-  const iptv_cloud::utils::ArgsMap* config_args_map = static_cast<const iptv_cloud::utils::ArgsMap*>(config_args);
+  const iptv_cloud::StreamConfig* stream_config = static_cast<const iptv_cloud::StreamConfig*>(config_args);
   const char* feedback_dir_ptr = args->feedback_dir;
   if (!feedback_dir_ptr) {
     CRITICAL_LOG() << "Define " FEEDBACK_DIR_FIELD " variable and make it valid.";
@@ -80,5 +97,5 @@ int stream_exec(const char* process_name,
   common::logging::LOG_LEVEL logs_level = static_cast<common::logging::LOG_LEVEL>(args->log_level);
   common::libev::IoClient* client = static_cast<common::libev::IoClient*>(command_client);
   iptv_cloud::StreamStruct* smem = static_cast<iptv_cloud::StreamStruct*>(mem);
-  return start_stream(process_name, feedback_dir_ptr, logs_level, *config_args_map, client, smem);
+  return start_stream(process_name, args, feedback_dir_ptr, logs_level, *stream_config, client, smem);
 }
@@ -27,11 +27,33 @@
 #include "stream/elements/parser/video_parsers.h"
 #include "stream/elements/sink/screen.h"
 #include "stream/elements/video/video.h"
+#include "stream/logo_overlay.h"
 
 #include "stream/pad/pad.h"
 
 namespace iptv_cloud {
 namespace stream {
+namespace {
+elements::Element* make_demuxed_video_decoder(const std::string& parser, element_id_t decoder_id) {
+  const std::string name = common::MemSPrintf(VIDEO_DECODER_NAME_1U, decoder_id);
+  if (parser == elements::parser::ElementH264Parse::GetPluginName()) {
+    return new elements::ElementAvdecH264(name);
+  }
+
+  return nullptr;
+}
+
+elements::Element* make_demuxed_audio_decoder(const std::string& parser, element_id_t decoder_id) {
+  const std::string name = common::MemSPrintf(AUDIO_DECODER_NAME_1U, decoder_id);
+  if (parser == elements::parser::ElementAACParse::GetPluginName()) {
+    return new elements::ElementAvdecAAC(name);
+  } else if (parser == elements::parser::ElementAC3Parse::GetPluginName()) {
+    return new elements::ElementAvdecAc3(name);
+  }
+
+  return nullptr;
+}
+}  // namespace
 namespace streams {
 namespace builders {
 
@@ -88,6 +110,49 @@ SupportedAudioCodec EncodingStreamBuilder::GetAudioCodecType() const {
   return AUDIO_MPEG_CODEC;
 }
 
+bool EncodingStreamBuilder::IsKnownInputFormat() const {
+  const EncodingConfig* conf = static_cast<const EncodingConfig*>(GetConfig());
+  if (conf->IsAvFormat() || conf->IsGpu()) {  // hardware decoders picked by decodebin
+    return false;
+  }
+
+  if (conf->HaveVideo() && !IsKnownVideoInput(conf->GetInputVideoParser(), conf->GetRelayVideo())) {
+    return false;
+  }
+
+  if (conf->HaveAudio() && !IsKnownAudioInput(conf->GetInputAudioParser(), conf->GetRelayAudio())) {
+    return false;
+  }
+
+  return true;
+}
+
+elements_line_t EncodingStreamBuilder::BuildVideoDemuxedLine() {
+  const EncodingConfig* conf = static_cast<const EncodingConfig*>(GetConfig());
+  const std::string video_parser = conf->GetInputVideoParser();
+  elements::Element* parser =
+      elements::parser::make_video_parser(video_parser, common::MemSPrintf(DEMUXED_VIDEO_PARSER_NAME_1U, 0));
+  if (conf->GetRelayVideo()) {  // parsed stream goes to output as is
+    return {parser};
+  }
+
+  elements::Element* decoder = make_demuxed_video_decoder(video_parser, 0);
+  return {parser, decoder};
+}
+
+elements_line_t EncodingStreamBuilder::BuildAudioDemuxedLine() {
+  const EncodingConfig* conf = static_cast<const EncodingConfig*>(GetConfig());
+  const std::string audio_parser = conf->GetInputAudioParser();
+  elements::Element* parser =
+      elements::parser::make_audio_parser(audio_parser, common::MemSPrintf(DEMUXED_AUDIO_PARSER_NAME_1U, 0));
+  if (conf->GetRelayAudio()) {
+    return {parser};
+  }
+
+  elements::Element* decoder = make_demuxed_audio_decoder(audio_parser, 0);
+  return {parser, decoder};
+}
+
 Connector EncodingStreamBuilder::BuildConverter(Connector conn) {
   const EncodingConfig* config = static_cast<const EncodingConfig*>(GetConfig());
   if (config->HaveVideo()) {
@@ -197,6 +262,31 @@ elements_line_t EncodingStreamBuilder::BuildVideoPostProc(element_id_t video_id)
     common::uri::Url logo_uri = logo.GetPath();
     common::draw::Point logo_point = logo.GetPosition();
     alpha_t alpha = logo.GetAlpha();
+    if (!conf->IsGpu() && logo_uri.GetScheme() == common::uri::Url::file) {
+      // system memory frames, blend in place without rgb round trip
+      LogoOverlay* overlay = new LogoOverlay;
+      common::Error err = overlay->LoadPng(logo_uri.GetPath().GetPath(), logo_point, alpha);
+      if (!err) {
+        elements::ElementCapsFilter* videologo =
+            new elements::ElementCapsFilter(common::MemSPrintf(VIDEO_LOGO_NAME_1U, video_id));
+        ElementAdd(videologo);
+        ElementLink(last, videologo);
+        GstCaps* logo_caps = gst_caps_from_string("video/x-raw, format=(string){ I420, NV12 }");
+        videologo->SetCaps(logo_caps);
+        gst_caps_unref(logo_caps);
+
+        pad::Pad* src_pad = videologo->StaticPad("src");
+        if (!LogoOverlay::AttachToPad(src_pad->GetGstPad(), overlay)) {
+          WARNING_LOG() << "Can't attach logo overlay to: " << videologo->GetName();
+        }
+        delete src_pad;
+        return {first, videologo};
+      }
+
+      DEBUG_MSG_ERROR(err, common::logging::LOG_LEVEL_WARNING);
+      delete overlay;
+    }
+
     elements::video::ElementGDKPixBufOverlay* videologo =
         new elements::video::ElementGDKPixBufOverlay(common::MemSPrintf(VIDEO_LOGO_NAME_1U, video_id));
     common::uri::Url::scheme scheme = logo_uri.GetScheme();
@@ -35,6 +35,10 @@ class EncodingStreamBuilder : public SrcDecodeStreamBuilder {
   SupportedVideoCodec GetVideoCodecType() const override;
   SupportedAudioCodec GetAudioCodecType() const override;
 
+  bool IsKnownInputFormat() const override;
+  elements_line_t BuildVideoDemuxedLine() override;
+  elements_line_t BuildAudioDemuxedLine() override;
+
  protected:
   virtual elements_line_t BuildVideoPostProc(element_id_t video_id);
   virtual elements_line_t BuildAudioPostProc(element_id_t audio_id);
@@ -184,13 +184,17 @@ bool MosaicStreamBuilder::InitPipeline() {
 
   Connector conn{vmix, amix};
   if (config->HaveVideo()) {
-    elements::video::ElementCairoOverlay* cairo =
-        new elements::video::ElementCairoOverlay(common::MemSPrintf(CAIRO_NAME_1U, 0));
-    ElementAdd(cairo);
-    ElementLink(conn.video, cairo);
-
-    HandleCairoCreated(cairo, options);
-    conn.video = cairo;
+    // meters drawn by MosaicStream straight into mixer output, mixer blends natively in I420
+    elements::ElementCapsFilter* meter =
+        new elements::ElementCapsFilter(common::MemSPrintf(MOSAIC_METER_NAME_1U, 0));
+    ElementAdd(meter);
+    ElementLink(conn.video, meter);
+    GstCaps* meter_caps = gst_caps_new_simple("video/x-raw", "format", G_TYPE_STRING, "I420", nullptr);
+    meter->SetCaps(meter_caps);
+    gst_caps_unref(meter_caps);
+
+    HandleMeterCreated(meter, options);
+    conn.video = meter;
 
     elements_line_t first_last = elements::encoders::build_video_convert(config->GetDeinterlace(), this, 0);
     ElementLink(conn.video, first_last.front());
@@ -276,7 +280,7 @@ void MosaicStreamBuilder::BuildOutput(elements::Element* video, elements::Elemen
     common::uri::Url::scheme scheme = uri.GetScheme();
     bool is_rtp_out = scheme == common::uri::Url::udp;
     const std::string vcodec = config->GetVideoEncoder();
-    elements::Element* mux = elements::muxer::make_muxer(scheme, i);
+    elements::Element* mux = elements::muxer::make_muxer(output, i);
     ElementAdd(mux);
 
     if (config->HaveVideo()) {
@@ -389,11 +393,10 @@ void MosaicStreamBuilder::HandleDecodebinCreated(elements::ElementDecodebin* dec
   }
 }
 
-void MosaicStreamBuilder::HandleCairoCreated(elements::video::ElementCairoOverlay* cairo,
-                                             const MosaicImageOptions& options) {
+void MosaicStreamBuilder::HandleMeterCreated(elements::ElementCapsFilter* meter, const MosaicImageOptions& options) {
   MosaicStream* stream = static_cast<MosaicStream*>(GetObserver());
   if (stream) {
-    stream->OnCairoCreated(cairo, options);
+    stream->OnMeterCreated(meter, options);
   }
 }
 
@@ -27,10 +27,8 @@ class ElementDecodebin;
 }
 
 namespace elements {
-namespace video {
-class ElementCairoOverlay;
+class ElementCapsFilter;
 }
-}  // namespace elements
 
 namespace streams {
 class MosaicStream;
@@ -41,7 +39,7 @@ class MosaicStreamBuilder : public IBaseBuilder {
 
  protected:
   void HandleDecodebinCreated(elements::ElementDecodebin* decodebin);
-  void HandleCairoCreated(elements::video::ElementCairoOverlay* cairo, const MosaicImageOptions& options);
+  void HandleMeterCreated(elements::ElementCapsFilter* meter, const MosaicImageOptions& options);
 
   bool InitPipeline() override;
   virtual void BuildOutput(elements::Element* video, elements::Element* audio);
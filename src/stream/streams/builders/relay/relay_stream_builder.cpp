@@ -79,6 +79,24 @@ SupportedAudioCodec RelayStreamBuilder::GetAudioCodecType() const {
   return AUDIO_MPEG_CODEC;
 }
 
+bool RelayStreamBuilder::IsKnownInputFormat() const {
+  const RelayConfig* conf = static_cast<const RelayConfig*>(GetConfig());
+  if (conf->IsAvFormat()) {
+    return false;
+  }
+
+  // udb parsers take elementary streams from demuxer, so codecs must come from config, not defaults
+  if (conf->HaveVideo() && (!conf->HaveVideoParser() || !IsKnownVideoInput(conf->GetVideoParser(), true))) {
+    return false;
+  }
+
+  if (conf->HaveAudio() && (!conf->HaveAudioParser() || !IsKnownAudioInput(conf->GetAudioParser(), true))) {
+    return false;
+  }
+
+  return true;
+}
+
 Connector RelayStreamBuilder::BuildConverter(Connector conn) {
   const RelayConfig* config = static_cast<const RelayConfig*>(GetConfig());
   if (config->HaveVideo()) {
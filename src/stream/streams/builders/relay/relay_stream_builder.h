@@ -33,6 +33,8 @@ class RelayStreamBuilder : public SrcDecodeStreamBuilder {
   SupportedVideoCodec GetVideoCodecType() const override;
   SupportedAudioCodec GetAudioCodecType() const override;
 
+  bool IsKnownInputFormat() const override;
+
   Connector BuildPostProc(Connector conn) override;
   Connector BuildConverter(Connector conn) override;
 };
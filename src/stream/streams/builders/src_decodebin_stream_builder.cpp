@@ -14,10 +14,25 @@
 
 #include "stream/streams/builders/src_decodebin_stream_builder.h"
 
+#include <errno.h>
+#include <gst/gst.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
 #include <common/sprintf.h>
 
 #include "stream/ibase_stream.h"
 
+#include "stream/elements/sink/shm.h"
 #include "stream/elements/sources/build_input.h"
 
 #include "stream/streams/src_decodebin_stream.h"
@@ -27,6 +42,8 @@
 #include "stream/streams/configs/audio_video_config.h"
 
 #include "stream/elements/muxer/muxer.h"
+#include "stream/elements/parser/audio_parsers.h"
+#include "stream/elements/parser/video_parsers.h"
 #include "stream/elements/pay/audio_pay.h"
 #include "stream/elements/pay/video_pay.h"
 
@@ -58,15 +75,114 @@ elements::Element* make_audio_pay(SupportedAudioCodec acodec, element_id_t pay_i
   NOTREACHED() << "Please add rtp pay for audio codec type: " << acodec;
   return nullptr;
 }
+
+// socket of previous pipeline is removed, live one (other publisher of the same upstream) or other file is kept
+bool RemoveStaleSocket(const std::string& path) {
+  struct stat st;
+  if (lstat(path.c_str(), &st) == -1) {
+    return errno == ENOENT;
+  }
+
+  struct sockaddr_un addr;
+  if (!S_ISSOCK(st.st_mode) || path.size() >= sizeof(addr.sun_path)) {
+    return false;
+  }
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd == -1) {
+    return false;
+  }
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  memcpy(addr.sun_path, path.data(), path.size());
+  const bool alive = connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == 0 || errno != ECONNREFUSED;
+  close(fd);
+  return !alive && unlink(path.c_str()) == 0;
+}
+
+const guint tee_release_timeout_sec = 2;
 }  // namespace
 namespace streams {
 namespace builders {
 
+bool IsKnownVideoInput(const std::string& parser, bool relay) {
+  if (parser.empty()) {
+    return false;
+  }
+
+  if (relay) {
+    return parser == elements::parser::ElementH264Parse::GetPluginName() ||
+           parser == elements::parser::ElementH265Parse::GetPluginName() ||
+           parser == elements::parser::ElementMpegParse::GetPluginName();
+  }
+  return parser == elements::parser::ElementH264Parse::GetPluginName();
+}
+
+bool IsKnownAudioInput(const std::string& parser, bool relay) {
+  if (parser.empty()) {
+    return false;
+  }
+
+  if (relay) {
+    return parser == elements::parser::ElementAACParse::GetPluginName() ||
+           parser == elements::parser::ElementAC3Parse::GetPluginName() ||
+           parser == elements::parser::ElementMPEGAudioParse::GetPluginName();
+  }
+  return parser == elements::parser::ElementAACParse::GetPluginName() ||
+         parser == elements::parser::ElementAC3Parse::GetPluginName();
+}
+
+struct SrcDecodeStreamBuilder::BranchRemoval {
+  BranchRemoval(SrcDecodeStreamBuilder* builder, const OutputBranch& branch)
+      : builder(builder),
+        branch(branch),
+        mutex(),
+        pending_pads(0),
+        cancelled(false),
+        finish(nullptr),
+        timeout(nullptr) {}
+
+  SrcDecodeStreamBuilder* const builder;
+  const OutputBranch branch;
+  std::mutex mutex;
+  size_t pending_pads;  // tee pads not released yet
+  bool cancelled;       // builder destroyed
+  GSource* finish;      // idle in pipeline loop after last tee pad released
+  GSource* timeout;     // flushes branch blocked downstream
+};
+
 SrcDecodeStreamBuilder::SrcDecodeStreamBuilder(const AudioVideoConfig* config, SrcDecodeBinStream* observer)
-    : GstBaseBuilder(config, observer) {}
+    : GstBaseBuilder(config, observer),
+      demuxed_(false),
+      demux_conn_({nullptr, nullptr}),
+      output_conn_({nullptr, nullptr}),
+      output_branches_(),
+      next_branch_id_(0),
+      removals_() {}
+
+SrcDecodeStreamBuilder::~SrcDecodeStreamBuilder() {
+  // pipeline is destroyed with not released branches, only sources must not run anymore
+  for (auto removal : removals_) {
+    std::unique_lock<std::mutex> lock(removal->mutex);
+    removal->cancelled = true;
+    for (GSource** source : {&removal->finish, &removal->timeout}) {
+      if (*source) {
+        g_source_destroy(*source);
+        g_source_unref(*source);
+        *source = nullptr;
+      }
+    }
+  }
+}
 
 Connector SrcDecodeStreamBuilder::BuildInput() {
   elements::Element* src = BuildInputSrc();
+  demuxed_ = IsKnownInputFormat() && BuildDemuxer(src);
+  if (demuxed_) {
+    return {nullptr, nullptr};
+  }
+
   elements::ElementDecodebin* decodebin = new elements::ElementDecodebin(common::MemSPrintf(DECODEBIN_NAME_1U, 0));
   ElementAdd(decodebin);
   ElementLink(src, decodebin);
@@ -75,6 +191,37 @@ Connector SrcDecodeStreamBuilder::BuildInput() {
   return {nullptr, nullptr};
 }
 
+bool SrcDecodeStreamBuilder::BuildDemuxer(elements::Element* src) {
+  const AudioVideoConfig* config = static_cast<const AudioVideoConfig*>(GetConfig());
+  input_t input = config->GetInput();
+  if (input.size() != 1 || config->GetAudioSelect()) {  // track select by decodebin pad names
+    return false;
+  }
+
+  SupportedDemuxer demuxer_type;
+  if (!GetDemuxerFromUrl(input[0].GetInput(), &demuxer_type)) {
+    return false;
+  }
+
+  const std::string demuxer_name = common::MemSPrintf(DEMUXER_NAME_1U, 0);
+  if (demuxer_type == VIDEO_MPEGTS_DEMUXER) {
+    elements::ElementTsDemux* demuxer = new elements::ElementTsDemux(demuxer_name);
+    ElementAdd(demuxer);
+    ElementLink(src, demuxer);
+    HandleDemuxerCreated(demuxer);
+  } else if (demuxer_type == VIDEO_FLV_DEMUXER) {
+    elements::ElementFLVDemux* demuxer = new elements::ElementFLVDemux(demuxer_name);
+    ElementAdd(demuxer);
+    ElementLink(src, demuxer);
+    HandleDemuxerCreated(demuxer);
+  } else {
+    return false;
+  }
+
+  INFO_LOG() << "Input format known, decodebin skipped.";
+  return true;
+}
+
 void SrcDecodeStreamBuilder::HandleDecodebinCreated(elements::ElementDecodebin* decodebin) {
   SrcDecodeBinStream* stream = static_cast<SrcDecodeBinStream*>(GetObserver());
   if (stream) {
@@ -82,6 +229,45 @@ void SrcDecodeStreamBuilder::HandleDecodebinCreated(elements::ElementDecodebin*
   }
 }
 
+template <typename T>
+void SrcDecodeStreamBuilder::HandleDemuxerCreated(T* demuxer) {
+  SrcDecodeBinStream* stream = static_cast<SrcDecodeBinStream*>(GetObserver());
+  if (stream) {
+    stream->OnDemuxerCreated(demuxer);
+  }
+}
+
+bool SrcDecodeStreamBuilder::IsKnownInputFormat() const {
+  return false;
+}
+
+elements_line_t SrcDecodeStreamBuilder::BuildVideoDemuxedLine() {
+  return elements_line_t();
+}
+
+elements_line_t SrcDecodeStreamBuilder::BuildAudioDemuxedLine() {
+  return elements_line_t();
+}
+
+Connector SrcDecodeStreamBuilder::GetDemuxedConnector() const {
+  return demux_conn_;
+}
+
+elements::Element* SrcDecodeStreamBuilder::LinkDemuxedLine(const elements_line_t& line, elements::Element* udb) {
+  if (line.empty()) {
+    return udb;
+  }
+
+  for (size_t i = 0; i < line.size(); ++i) {
+    ElementAdd(line[i]);
+    if (i != 0) {
+      ElementLink(line[i - 1], line[i]);
+    }
+  }
+  ElementLink(line.back(), udb);
+  return line.front();
+}
+
 elements::Element* SrcDecodeStreamBuilder::BuildInputSrc() {
   const Config* config = GetConfig();
   input_t prepared = config->GetInput();
@@ -94,7 +280,37 @@ elements::Element* SrcDecodeStreamBuilder::BuildInputSrc() {
   }
   delete src_pad;
   ElementAdd(src);
-  return src;
+
+  const std::string publish_input = config->GetPublishInput();
+  if (publish_input.empty()) {
+    return src;
+  }
+
+  if (!RemoveStaleSocket(publish_input)) {
+    WARNING_LOG() << "Publish input socket " << publish_input << " is in use, input is not shared.";
+    return src;
+  }
+
+  // upstream shared with other streams of the service:
+  // src -> tee -> queue -> decodebin
+  //            -> leaky queue -> shmsink
+  elements::ElementTee* tee = new elements::ElementTee(common::MemSPrintf(PUBLISH_INPUT_TEE_NAME_1U, 0));
+  ElementAdd(tee);
+  ElementLink(src, tee);
+
+  elements::ElementQueue* publish_queue =
+      new elements::ElementQueue(common::MemSPrintf(PUBLISH_INPUT_QUEUE_NAME_1U, 0));
+  publish_queue->SetLeaky(2);  // slow readers lose data, own decoding never stalls
+  ElementAdd(publish_queue);
+  ElementLink(tee, publish_queue);
+  elements::sink::ElementShmSink* publish_sink = elements::sink::make_publish_input_sink(publish_input, 0);
+  ElementAdd(publish_sink);
+  ElementLink(publish_queue, publish_sink);
+
+  elements::ElementQueue* decode_queue = new elements::ElementQueue(common::MemSPrintf(DECODE_INPUT_QUEUE_NAME_1U, 0));
+  ElementAdd(decode_queue);
+  ElementLink(tee, decode_queue);
+  return decode_queue;
 }
 
 elements::Element* SrcDecodeStreamBuilder::BuildVideoUdbConnection() {
@@ -116,12 +332,18 @@ Connector SrcDecodeStreamBuilder::BuildUdbConnections(Connector conn) {
     CHECK(vudb);
     ElementAdd(vudb);
     conn.video = vudb;
+    if (demuxed_) {
+      demux_conn_.video = LinkDemuxedLine(BuildVideoDemuxedLine(), vudb);
+    }
   }
   if (config->HaveAudio()) {
     elements::Element* audb = BuildAudioUdbConnection();
     CHECK(audb);
     ElementAdd(audb);
     conn.audio = audb;
+    if (demuxed_) {
+      demux_conn_.audio = LinkDemuxedLine(BuildAudioDemuxedLine(), audb);
+    }
   }
   return conn;
 }
@@ -129,59 +351,270 @@ Connector SrcDecodeStreamBuilder::BuildUdbConnections(Connector conn) {
 Connector SrcDecodeStreamBuilder::BuildOutput(Connector conn) {
   const AudioVideoConfig* config = static_cast<const AudioVideoConfig*>(GetConfig());
   output_t out = config->GetOutput();
+  output_conn_ = conn;
+  next_branch_id_ = out.size();
   for (size_t i = 0; i < out.size(); ++i) {
     const OutputUri output = out[i];
-    SinkDeviceType dt;
-    if (IsDeviceOutUrl(output.GetOutput(), &dt)) {  // monitor
-      CRITICAL_LOG() << "Decklink not supported for encoding based streams!";
+    OutputBranch branch;
+    if (!BuildOutputBranch(output, i, &branch)) {
       continue;
     }
 
-    common::uri::Url uri = output.GetOutput();
-    common::uri::Url::scheme scheme = uri.GetScheme();
-    bool is_rtp_out = scheme == common::uri::Url::udp;
-    elements::Element* mux = elements::muxer::make_muxer(scheme, i);
-    ElementAdd(mux);
-
-    if (config->HaveVideo()) {
-      elements::ElementQueue* video_tee_queue =
-          new elements::ElementQueue(common::MemSPrintf(VIDEO_TEE_QUEUE_NAME_1U, i));
-      ElementAdd(video_tee_queue);
-      elements::Element* next = video_tee_queue;
-      ElementLink(conn.video, next);
-
-      if (is_rtp_out) {
-        elements::Element* rtp_pay = make_video_pay(GetVideoCodecType(), i);
-        ElementAdd(rtp_pay);
-        ElementLink(next, rtp_pay);
-        next = rtp_pay;
-      }
+    LinkOutputBranch(conn, branch);
+    output_branches_[output.GetID()] = branch;
+  }
+  return conn;
+}
+
+bool SrcDecodeStreamBuilder::BuildOutputBranch(const OutputUri& output,
+                                               element_id_t branch_id,
+                                               OutputBranch* branch) {
+  const AudioVideoConfig* config = static_cast<const AudioVideoConfig*>(GetConfig());
+  SinkDeviceType dt;
+  if (IsDeviceOutUrl(output.GetOutput(), &dt)) {  // monitor
+    CRITICAL_LOG() << "Decklink not supported for encoding based streams!";
+    return false;
+  }
+
+  const size_t elements_before = GetElements().size();
+  OutputBranch lbranch;
+  lbranch.id = branch_id;
+  lbranch.output = output;
+  lbranch.video_queue = nullptr;
+  lbranch.audio_queue = nullptr;
+
+  common::uri::Url uri = output.GetOutput();
+  common::uri::Url::scheme scheme = uri.GetScheme();
+  bool is_rtp_out = scheme == common::uri::Url::udp;
+  elements::Element* mux = elements::muxer::make_muxer(output, branch_id);
+  ElementAdd(mux);
 
-      ElementLink(next, mux);
+  if (config->HaveVideo()) {
+    elements::ElementQueue* video_tee_queue =
+        new elements::ElementQueue(common::MemSPrintf(VIDEO_TEE_QUEUE_NAME_1U, branch_id));
+    ElementAdd(video_tee_queue);
+    lbranch.video_queue = video_tee_queue;
+    elements::Element* next = video_tee_queue;
+
+    if (is_rtp_out) {
+      elements::Element* rtp_pay = make_video_pay(GetVideoCodecType(), branch_id);
+      ElementAdd(rtp_pay);
+      ElementLink(next, rtp_pay);
+      next = rtp_pay;
+    }
+
+    ElementLink(next, mux);
+  }
+
+  if (config->HaveAudio()) {
+    elements::ElementQueue* audio_tee_queue =
+        new elements::ElementQueue(common::MemSPrintf(AUDIO_TEE_QUEUE_NAME_1U, branch_id));
+    ElementAdd(audio_tee_queue);
+    lbranch.audio_queue = audio_tee_queue;
+    elements::Element* next = audio_tee_queue;
+
+    if (is_rtp_out) {
+      elements::Element* rtp_pay = make_audio_pay(GetAudioCodecType(), branch_id);
+      ElementAdd(rtp_pay);
+      ElementLink(next, rtp_pay);
+      next = rtp_pay;
     }
 
-    if (config->HaveAudio()) {
-      elements::ElementQueue* audio_tee_queue =
-          new elements::ElementQueue(common::MemSPrintf(AUDIO_TEE_QUEUE_NAME_1U, i));
-      ElementAdd(audio_tee_queue);
-      elements::Element* next = audio_tee_queue;
-      ElementLink(conn.audio, next);
-
-      if (is_rtp_out) {
-        elements::Element* rtp_pay = make_audio_pay(GetAudioCodecType(), i);
-        ElementAdd(rtp_pay);
-        ElementLink(next, rtp_pay);
-        next = rtp_pay;
+    ElementLink(next, mux);
+  }
+
+  elements::Element* sink = BuildGenericOutput(output, branch_id);
+  ElementAdd(sink);
+  ElementLink(mux, sink);
+
+  const elements_line_t all = GetElements();
+  lbranch.elements = elements_line_t(all.begin() + elements_before, all.end());
+  *branch = lbranch;
+  return true;
+}
+
+void SrcDecodeStreamBuilder::LinkOutputBranch(Connector conn, const OutputBranch& branch) {
+  if (branch.video_queue) {
+    ElementLink(conn.video, branch.video_queue);
+  }
+  if (branch.audio_queue) {
+    ElementLink(conn.audio, branch.audio_queue);
+  }
+}
+
+output_t SrcDecodeStreamBuilder::GetActiveOutputs() const {
+  output_t outputs;
+  for (auto it = output_branches_.begin(); it != output_branches_.end(); ++it) {
+    outputs.push_back(it->second.output);
+  }
+  return outputs;
+}
+
+bool SrcDecodeStreamBuilder::GetOutputBranchID(OutputUri::uri_id_t oid, element_id_t* branch_id) const {
+  auto it = output_branches_.find(oid);
+  if (it == output_branches_.end() || !branch_id) {
+    return false;
+  }
+
+  *branch_id = it->second.id;
+  return true;
+}
+
+bool SrcDecodeStreamBuilder::AddOutput(const OutputUri& output) {
+  if (!output_conn_.video && !output_conn_.audio) {
+    return false;
+  }
+
+  if (output_branches_.find(output.GetID()) != output_branches_.end()) {
+    return false;
+  }
+
+  OutputBranch branch;
+  if (!BuildOutputBranch(output, next_branch_id_, &branch)) {
+    return false;
+  }
+  next_branch_id_++;
+
+  // sink first, so tee never pushes into a not ready branch
+  for (auto it = branch.elements.rbegin(); it != branch.elements.rend(); ++it) {
+    gst_element_sync_state_with_parent((*it)->GetGstElement());
+  }
+
+  LinkOutputBranch(output_conn_, branch);
+  output_branches_[output.GetID()] = branch;
+  return true;
+}
+
+bool SrcDecodeStreamBuilder::RemoveOutput(OutputUri::uri_id_t oid) {
+  auto it = output_branches_.find(oid);
+  if (it == output_branches_.end()) {
+    return false;
+  }
+
+  std::shared_ptr<BranchRemoval> removal = std::make_shared<BranchRemoval>(this, it->second);
+  output_branches_.erase(it);
+
+  std::vector<GstPad*> tee_pads;
+  for (elements::Element* queue : {removal->branch.video_queue, removal->branch.audio_queue}) {
+    if (!queue) {
+      continue;
+    }
+
+    GstPad* sink_pad = gst_element_get_static_pad(queue->GetGstElement(), "sink");
+    if (!sink_pad) {
+      continue;
+    }
+
+    GstPad* tee_pad = gst_pad_get_peer(sink_pad);
+    gst_object_unref(sink_pad);
+    if (tee_pad) {
+      tee_pads.push_back(tee_pad);
+    }
+  }
+
+  if (tee_pads.empty()) {
+    FinishRemoveOutput(removal);
+    return true;
+  }
+
+  // pipeline loop is not blocked, branch leaves pipeline when tee pads are released in streaming threads
+  removal->pending_pads = tee_pads.size();
+  removal->timeout = g_timeout_source_new_seconds(tee_release_timeout_sec);
+  g_source_set_callback(removal->timeout, removal_timeout_callback, new std::shared_ptr<BranchRemoval>(removal),
+                        removal_destroy_callback);
+  g_source_attach(removal->timeout, nullptr);
+  removals_.push_back(removal);
+  for (GstPad* tee_pad : tee_pads) {  // idle probe can be called right here
+    gst_pad_add_probe(tee_pad, GST_PAD_PROBE_TYPE_IDLE, release_tee_pad_callback,
+                      new std::shared_ptr<BranchRemoval>(removal), removal_destroy_callback);
+    gst_object_unref(tee_pad);
+  }
+  return true;
+}
+
+void SrcDecodeStreamBuilder::FinishRemoveOutput(std::shared_ptr<BranchRemoval> removal) {
+  {
+    std::unique_lock<std::mutex> lock(removal->mutex);
+    for (GSource** source : {&removal->finish, &removal->timeout}) {
+      if (*source) {
+        g_source_destroy(*source);
+        g_source_unref(*source);
+        *source = nullptr;
       }
+    }
+  }
+  removals_.erase(std::remove(removals_.begin(), removals_.end(), removal), removals_.end());
+
+  const OutputBranch& branch = removal->branch;
+  for (elements::Element* el : branch.elements) {
+    gst_element_set_state(el->GetGstElement(), GST_STATE_NULL);
+  }
+
+  for (elements::Element* el : branch.elements) {
+    GstElement* gst_el = GST_ELEMENT(gst_object_ref(el->GetGstElement()));
+    ElementRemove(el);
+    gst_object_unref(gst_el);
+  }
 
-      ElementLink(next, mux);
+  SrcDecodeBinStream* stream = static_cast<SrcDecodeBinStream*>(GetObserver());
+  if (stream) {
+    stream->OnOutputBranchRemoved(branch.id);
+  }
+}
+
+GstPadProbeReturn SrcDecodeStreamBuilder::release_tee_pad_callback(GstPad* pad,
+                                                                   GstPadProbeInfo* info,
+                                                                   gpointer user_data) {
+  UNUSED(info);
+  std::shared_ptr<BranchRemoval> removal = *static_cast<std::shared_ptr<BranchRemoval>*>(user_data);
+  GstPad* peer = gst_pad_get_peer(pad);
+  if (peer) {
+    gst_pad_unlink(pad, peer);
+    gst_object_unref(peer);
+  }
+
+  GstElement* tee = gst_pad_get_parent_element(pad);
+  if (tee) {
+    gst_element_release_request_pad(tee, pad);
+    gst_object_unref(tee);
+  }
+
+  std::unique_lock<std::mutex> lock(removal->mutex);
+  if (--removal->pending_pads == 0 && !removal->cancelled) {
+    removal->finish = g_idle_source_new();
+    g_source_set_callback(removal->finish, finish_removal_callback, new std::shared_ptr<BranchRemoval>(removal),
+                          removal_destroy_callback);
+    g_source_attach(removal->finish, nullptr);
+  }
+  return GST_PAD_PROBE_REMOVE;
+}
+
+gboolean SrcDecodeStreamBuilder::finish_removal_callback(gpointer user_data) {
+  std::shared_ptr<BranchRemoval> removal = *static_cast<std::shared_ptr<BranchRemoval>*>(user_data);
+  removal->builder->FinishRemoveOutput(removal);
+  return G_SOURCE_REMOVE;
+}
+
+gboolean SrcDecodeStreamBuilder::removal_timeout_callback(gpointer user_data) {
+  std::shared_ptr<BranchRemoval> removal = *static_cast<std::shared_ptr<BranchRemoval>*>(user_data);
+  {
+    std::unique_lock<std::mutex> lock(removal->mutex);
+    if (removal->timeout) {
+      g_source_unref(removal->timeout);
+      removal->timeout = nullptr;
     }
+  }
 
-    elements::Element* sink = BuildGenericOutput(output, i);
-    ElementAdd(sink);
-    ElementLink(mux, sink);
+  // downstream is blocked, flushing branch unblocks tee and idle probes run
+  WARNING_LOG() << "Tee pads of output branch " << removal->branch.id << " not released, flushing branch.";
+  for (elements::Element* el : removal->branch.elements) {
+    gst_element_set_state(el->GetGstElement(), GST_STATE_NULL);
   }
-  return conn;
+  return G_SOURCE_REMOVE;
+}
+
+void SrcDecodeStreamBuilder::removal_destroy_callback(gpointer user_data) {
+  delete static_cast<std::shared_ptr<BranchRemoval>*>(user_data);
 }
 
 }  // namespace builders
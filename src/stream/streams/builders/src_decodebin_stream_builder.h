@@ -14,6 +14,13 @@
 
 #pragma once
 
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/output_uri.h"
+
 #include "stream/streams/builders/gst_base_builder.h"
 
 namespace iptv_cloud {
@@ -26,13 +33,24 @@ class SrcDecodeBinStream;
 class AudioVideoConfig;
 namespace builders {
 
+// parsers demuxed lines start with, relay - parsed stream goes to output without decoder
+bool IsKnownVideoInput(const std::string& parser, bool relay);
+bool IsKnownAudioInput(const std::string& parser, bool relay);
+
 class SrcDecodeStreamBuilder : public GstBaseBuilder {
  public:
   SrcDecodeStreamBuilder(const AudioVideoConfig* config, SrcDecodeBinStream* observer);
+  ~SrcDecodeStreamBuilder() override;
 
   Connector BuildInput() override;
   virtual elements::Element* BuildInputSrc();
 
+  // demuxer and decoders built directly when input format known, decodebin otherwise
+  virtual bool IsKnownInputFormat() const;
+  virtual elements_line_t BuildVideoDemuxedLine();  // empty - demuxer linked to video udb
+  virtual elements_line_t BuildAudioDemuxedLine();  // empty - demuxer linked to audio udb
+  Connector GetDemuxedConnector() const;             // first elements after demuxer, nullptr for decodebin
+
   Connector BuildUdbConnections(Connector conn) override;
   virtual elements::Element* BuildVideoUdbConnection();
   virtual elements::Element* BuildAudioUdbConnection();
@@ -44,8 +62,45 @@ class SrcDecodeStreamBuilder : public GstBaseBuilder {
   virtual SupportedVideoCodec GetVideoCodecType() const = 0;
   virtual SupportedAudioCodec GetAudioCodecType() const = 0;
 
+  // live output changes on the playing pipeline, branches hang on the output tees
+  output_t GetActiveOutputs() const;
+  bool AddOutput(const OutputUri& output) WARN_UNUSED_RESULT;
+  bool RemoveOutput(OutputUri::uri_id_t oid) WARN_UNUSED_RESULT;  // branch leaves pipeline asynchronously
+  bool GetOutputBranchID(OutputUri::uri_id_t oid, element_id_t* branch_id) const WARN_UNUSED_RESULT;
+
  protected:
+  struct OutputBranch {
+    element_id_t id;
+    OutputUri output;
+    elements::Element* video_queue;  // linked from video tee
+    elements::Element* audio_queue;  // linked from audio tee
+    elements_line_t elements;
+  };
+
   void HandleDecodebinCreated(elements::ElementDecodebin* decodebin);
+  template <typename T>
+  void HandleDemuxerCreated(T* demuxer);
+  elements::Element* LinkDemuxedLine(const elements_line_t& line, elements::Element* udb);
+  bool BuildOutputBranch(const OutputUri& output, element_id_t branch_id, OutputBranch* branch);
+  void LinkOutputBranch(Connector conn, const OutputBranch& branch);
+
+ private:
+  struct BranchRemoval;
+
+  bool BuildDemuxer(elements::Element* src);
+  void FinishRemoveOutput(std::shared_ptr<BranchRemoval> removal);
+
+  static GstPadProbeReturn release_tee_pad_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
+  static gboolean finish_removal_callback(gpointer user_data);
+  static gboolean removal_timeout_callback(gpointer user_data);
+  static void removal_destroy_callback(gpointer user_data);
+
+  bool demuxed_;
+  Connector demux_conn_;
+  Connector output_conn_;
+  std::map<OutputUri::uri_id_t, OutputBranch> output_branches_;
+  element_id_t next_branch_id_;
+  std::vector<std::shared_ptr<BranchRemoval>> removals_;  // branches waiting for their tee pads
 };
 
 }  // namespace builders
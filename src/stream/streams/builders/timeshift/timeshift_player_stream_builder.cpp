@@ -39,6 +39,10 @@ elements::Element* TimeShiftPlayerBuilder::BuildInputSrc() {
   return multifilesrc;
 }
 
+bool TimeShiftPlayerBuilder::IsKnownInputFormat() const {
+  return false;
+}
+
 }  // namespace builders
 }  // namespace streams
 }  // namespace stream
@@ -32,6 +32,7 @@ class TimeShiftPlayerBuilder : public RelayStreamBuilder {
                          SrcDecodeBinStream* observer);
 
   elements::Element* BuildInputSrc() override;
+  bool IsKnownInputFormat() const override;  // chunks, not config input
 
  private:
   TimeShiftInfo tinfo_;
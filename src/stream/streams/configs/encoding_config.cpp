@@ -45,7 +45,9 @@ EncodingConfig::EncodingConfig(const base_class& config)
       decklink_video_mode_(DEFAULT_DECKLINK_VIDEO_MODE),
       aspect_ratio_(),
       relay_video_(false),
-      relay_audio_(false) {}
+      relay_audio_(false),
+      input_video_parser_(),
+      input_audio_parser_() {}
 
 bool EncodingConfig::GetRelayVideo() const {
   return relay_video_;
@@ -195,6 +197,22 @@ void EncodingConfig::SetDecklinkMode(decklink_video_mode_t decl) {
   decklink_video_mode_ = decl;
 }
 
+std::string EncodingConfig::GetInputVideoParser() const {
+  return input_video_parser_;
+}
+
+void EncodingConfig::SetInputVideoParser(const std::string& parser) {
+  input_video_parser_ = parser;
+}
+
+std::string EncodingConfig::GetInputAudioParser() const {
+  return input_audio_parser_;
+}
+
+void EncodingConfig::SetInputAudioParser(const std::string& parser) {
+  input_audio_parser_ = parser;
+}
+
 VodEncodeConfig::VodEncodeConfig(const base_class& config) : base_class(config), cleanup_ts_(false) {}
 
 bool VodEncodeConfig::GetCleanupTS() const {
@@ -84,6 +84,12 @@ class EncodingConfig : public AudioVideoConfig {
   decklink_video_mode_t GetDecklinkMode() const;  // mosaic
   void SetDecklinkMode(decklink_video_mode_t decl);
 
+  std::string GetInputVideoParser() const;  // encoding, empty - decodebin finds input format
+  void SetInputVideoParser(const std::string& parser);
+
+  std::string GetInputAudioParser() const;  // encoding, empty - decodebin finds input format
+  void SetInputAudioParser(const std::string& parser);
+
  private:
   deinterlace_t deinterlace_;
 
@@ -109,6 +115,9 @@ class EncodingConfig : public AudioVideoConfig {
 
   bool relay_video_;
   bool relay_audio_;
+
+  std::string input_video_parser_;
+  std::string input_audio_parser_;
 };
 
 class VodEncodeConfig : public EncodingConfig {
@@ -27,24 +27,32 @@ namespace stream {
 namespace streams {
 
 RelayConfig::RelayConfig(const base_class& config)
-    : base_class(config), video_parser_(DEFAULT_VIDEO_PARSER), audio_parser_(DEFAULT_AUDIO_PARSER) {}
+    : base_class(config), video_parser_(), audio_parser_() {}
 
 std::string RelayConfig::GetVideoParser() const {
-  return video_parser_;
+  return video_parser_.empty() ? DEFAULT_VIDEO_PARSER : video_parser_;
 }
 
 void RelayConfig::SetVideoParser(const std::string& parser) {
   video_parser_ = parser;
 }
 
+bool RelayConfig::HaveVideoParser() const {
+  return !video_parser_.empty();
+}
+
 std::string RelayConfig::GetAudioParser() const {
-  return audio_parser_;
+  return audio_parser_.empty() ? DEFAULT_AUDIO_PARSER : audio_parser_;
 }
 
 void RelayConfig::SetAudioParser(const std::string& parser) {
   audio_parser_ = parser;
 }
 
+bool RelayConfig::HaveAudioParser() const {
+  return !audio_parser_.empty();
+}
+
 VodRelayConfig::VodRelayConfig(const base_class& config) : base_class(config), cleanup_ts_(false) {}
 
 bool VodRelayConfig::GetCleanupTS() const {
@@ -29,9 +29,11 @@ class RelayConfig : public AudioVideoConfig {
 
   std::string GetVideoParser() const;  // relay
   void SetVideoParser(const std::string& parser);
+  bool HaveVideoParser() const;  // false - default parser, input codec unknown
 
   std::string GetAudioParser() const;  // relay
   void SetAudioParser(const std::string& parser);
+  bool HaveAudioParser() const;  // false - default parser, input codec unknown
 
  private:
   std::string video_parser_;
@@ -21,8 +21,11 @@
 #include "base/constants.h"
 #include "base/gst_constants.h"
 
+#include "stream/elements/audio/audio.h"
+#include "stream/elements/encoders/video_encoders.h"
 #include "stream/elements/parser/audio_parsers.h"
 #include "stream/elements/parser/video_parsers.h"
+#include "stream/elements/video/video.h"
 #include "stream/gstreamer_utils.h"
 #include "stream/pad/pad.h"
 #include "stream/streams/builders/encoding/encoding_stream_builder.h"
@@ -37,12 +40,64 @@ IBaseBuilder* EncodingStream::CreateBuilder() {
 }
 
 EncodingStream::EncodingStream(const EncodingConfig* config, IStreamClient* client, StreamStruct* stats)
-    : base_class(config, client, stats) {}
+    : base_class(config, client, stats), video_bitrate_(config->GetVideoBitrate()) {}
 
 const char* EncodingStream::ClassName() const {
   return "EncodingStream";
 }
 
+bool EncodingStream::HandleReconfigure(const Config* config) {
+  const EncodingConfig* econf = static_cast<const EncodingConfig*>(config);
+  elements::Element* volume = FindElementByName(common::MemSPrintf(VOLUME_NAME_1U, 0));
+  elements::Element* logo = FindElementByName(common::MemSPrintf(VIDEO_LOGO_NAME_1U, 0));
+  elements::Element* video_encoder = FindElementByName(common::MemSPrintf(VIDEO_CODEC_NAME_1U, 0));
+
+  // check all before change anything, elements can't be inserted into playing chain
+  const auto new_volume = econf->GetVolume();
+  if (new_volume && !volume) {
+    return false;
+  }
+
+  const Logo new_logo = econf->GetLogo();
+  if (new_logo.IsValid() && (!logo || new_logo.GetPath().GetScheme() != common::uri::Url::file)) {
+    return false;
+  }
+
+  const auto new_video_bitrate = econf->GetVideoBitrate();
+  if (new_video_bitrate && !video_encoder) {
+    return false;
+  }
+
+  if (!new_video_bitrate && video_bitrate_) {  // encoder default can't be restored
+    return false;
+  }
+
+  if (volume) {
+    static_cast<elements::audio::ElementVolume*>(volume)->SetVolume(new_volume ? *new_volume : 1);
+  }
+
+  if (logo) {
+    elements::video::ElementGDKPixBufOverlay* videologo = static_cast<elements::video::ElementGDKPixBufOverlay*>(logo);
+    if (new_logo.IsValid()) {
+      common::uri::Upath upath = new_logo.GetPath().GetPath();
+      common::draw::Point logo_point = new_logo.GetPosition();
+      videologo->SetLocation(upath.GetPath());
+      videologo->SetOffsetX(logo_point.x);
+      videologo->SetOffsetY(logo_point.y);
+      videologo->SetAlpha(new_logo.GetAlpha());
+    } else {
+      videologo->SetAlpha(0);
+    }
+  }
+
+  if (new_video_bitrate && video_encoder) {
+    elements::encoders::set_video_bitrate(video_encoder, *new_video_bitrate);
+    video_bitrate_ = new_video_bitrate;
+  }
+
+  return base_class::HandleReconfigure(config);
+}
+
 void EncodingStream::HandleBufferingMessage(GstMessage* message) {
   if (IsLive()) {
     return;
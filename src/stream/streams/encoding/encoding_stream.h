@@ -31,6 +31,7 @@ class EncodingStream : public SrcDecodeBinStream {
 
  protected:
   IBaseBuilder* CreateBuilder() override;
+  bool HandleReconfigure(const Config* config) override;  // volume, logo, video bitrate, outputs
 
   void HandleBufferingMessage(GstMessage* message) override;
   gboolean HandleDecodeBinAutoplugger(GstElement* elem, GstPad* pad, GstCaps* caps) override;
@@ -44,6 +45,9 @@ class EncodingStream : public SrcDecodeBinStream {
 
   void HandleDecodeBinElementAdded(GstBin* bin, GstElement* element) override;
   void HandleDecodeBinElementRemoved(GstBin* bin, GstElement* element) override;
+
+ private:
+  bit_rate_t video_bitrate_;  // applied to encoder, config keeps the one pipeline was built with
 };
 
 }  // namespace streams
@@ -0,0 +1,232 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream/streams/mosaic_meter.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+namespace {
+
+struct YuvColor {
+  uint8_t y;
+  uint8_t cb;
+  uint8_t cr;
+  uint8_t alpha;
+};
+
+// bt.601 limited range
+YuvColor MakeColor(double r, double g, double b, double a) {
+  YuvColor color;
+  color.y = static_cast<uint8_t>(lround(16 + 65.481 * r + 128.553 * g + 24.966 * b));
+  color.cb = static_cast<uint8_t>(lround(128 - 37.797 * r - 74.203 * g + 112.0 * b));
+  color.cr = static_cast<uint8_t>(lround(128 + 112.0 * r - 93.786 * g - 18.214 * b));
+  color.alpha = static_cast<uint8_t>(lround(a * 255));
+  return color;
+}
+
+const YuvColor kGreen = MakeColor(0.0, 1.0, 0.0, 1.0);
+const YuvColor kYellow = MakeColor(1.0, 1.0, 0.0, 1.0);
+const YuvColor kRed = MakeColor(1.0, 0.0, 0.0, 1.0);
+const YuvColor kUnlit = MakeColor(1.0, 1.0, 1.0, 0.7);
+
+int LitChunks(const iptv_cloud::stream::streams::SoundInfo& sound, size_t channel) {
+  if (sound.channels.size() <= channel) {
+    return 0;
+  }
+
+  const double val = sound.channels[channel].rms_dB / -10;
+  if (!(val >= 1)) {
+    return 0;
+  }
+  if (val >= iptv_cloud::stream::streams::MosaicMeterRenderer::COUNT_CHUNKS) {
+    return iptv_cloud::stream::streams::MosaicMeterRenderer::COUNT_CHUNKS;
+  }
+  return static_cast<int>(val);
+}
+
+inline uint8_t BlendPixel(uint8_t src, uint8_t dst, uint8_t alpha) {
+  return static_cast<uint8_t>((src * alpha + dst * (255 - alpha) + 127) / 255);
+}
+
+}  // namespace
+
+namespace iptv_cloud {
+namespace stream {
+namespace streams {
+
+MosaicMeterRenderer::MosaicMeterRenderer() : frame_(), meters_(), rasterize_count_(0) {}
+
+bool MosaicMeterRenderer::Draw(const MosaicImageOptions& options,
+                               const YuvFrameInfo& frame,
+                               uint8_t* data,
+                               size_t size) {
+  YuvPlanes planes;
+  if (!MapYuvPlanes(frame, data, size, &planes)) {
+    return false;
+  }
+
+  if (!options.isValid()) {
+    return true;
+  }
+
+  if (frame != frame_) {
+    frame_ = frame;
+    meters_.clear();
+  }
+
+  meters_.resize(options.sreams.size());
+  for (size_t i = 0; i < options.sreams.size(); ++i) {
+    const StreamInfo& stream = options.sreams[i];
+    TileMeter* meter = &meters_[i];
+
+    std::vector<int> levels;
+    for (size_t j = 0; j < CHANNELS; ++j) {
+      levels.push_back(LitChunks(stream.sound, j));
+    }
+
+    const int x0 = stream.img.x_y.x + stream.img.size.width - options.right_padding;
+    const int y0 = stream.img.x_y.y;
+    const bool geometry_changed = meter->x != x0 || meter->y != y0 || meter->width != options.right_padding ||
+                                  meter->height != stream.img.size.height;
+    if (!meter->rasterized || geometry_changed || levels != meter->levels) {
+      meter->rasterized = true;
+      meter->levels = levels;
+      meter->x = x0;
+      meter->y = y0;
+      meter->width = options.right_padding;
+      meter->height = stream.img.size.height;
+      Rasterize(options, stream, frame, meter);
+    }
+
+    Blend(meter->sprite, frame, planes);
+  }
+  return true;
+}
+
+size_t MosaicMeterRenderer::GetRasterizeCount() const {
+  return rasterize_count_;
+}
+
+void MosaicMeterRenderer::Rasterize(const MosaicImageOptions& options,
+                                    const StreamInfo& stream,
+                                    const YuvFrameInfo& frame,
+                                    TileMeter* meter) {
+  rasterize_count_++;
+  Sprite* sprite = &meter->sprite;
+  const int x_start = std::max(0, meter->x) & ~1;
+  const int y_start = std::max(0, meter->y) & ~1;
+  const int x_end = std::min(frame.width & ~1, (meter->x + meter->width + 1) & ~1);
+  const int y_end = std::min(frame.height & ~1, (meter->y + meter->height + 1) & ~1);
+  sprite->x = x_start;
+  sprite->y = y_start;
+  sprite->width = std::max(0, x_end - x_start);
+  sprite->height = std::max(0, y_end - y_start);
+
+  const size_t luma_size = sprite->width * sprite->height;
+  sprite->luma.assign(luma_size, 0);
+  sprite->luma_alpha.assign(luma_size, 0);
+  std::vector<uint8_t> cb(luma_size, 0);
+  std::vector<uint8_t> cr(luma_size, 0);
+
+  // same chunk layout as former cairo meter
+  const int width_chunk = options.right_padding / (2 * CHANNELS);
+  const int padding = width_chunk;
+  const int height_chunk = stream.img.size.height / (COUNT_CHUNKS * 2);
+  for (int i = 0; i < COUNT_CHUNKS * 2; i += 2) {
+    for (int j = 0; j < CHANNELS; ++j) {
+      const int pos = (COUNT_CHUNKS * 2 - i) / 2;  // backward
+      YuvColor color = kUnlit;
+      if (pos <= meter->levels[j]) {
+        color = pos <= 5 ? kGreen : pos <= 8 ? kYellow : kRed;
+      }
+
+      const int cx = meter->x + padding + width_chunk * j + (padding / 2 * j);
+      const int cy = meter->y + height_chunk + height_chunk * i;
+      for (int y = std::max(cy, y_start); y < std::min(cy + height_chunk, y_end); ++y) {
+        for (int x = std::max(cx, x_start); x < std::min(cx + width_chunk, x_end); ++x) {
+          const size_t idx = (y - y_start) * sprite->width + (x - x_start);
+          sprite->luma[idx] = color.y;
+          sprite->luma_alpha[idx] = color.alpha;
+          cb[idx] = color.cb;
+          cr[idx] = color.cr;
+        }
+      }
+    }
+  }
+
+  // 2x2 subsampled chroma, weighted by alpha
+  const size_t chroma_size = (sprite->width / 2) * (sprite->height / 2);
+  sprite->cb.assign(chroma_size, 0);
+  sprite->cr.assign(chroma_size, 0);
+  sprite->chroma_alpha.assign(chroma_size, 0);
+  for (int y = 0; y < sprite->height / 2; ++y) {
+    for (int x = 0; x < sprite->width / 2; ++x) {
+      unsigned alpha_sum = 0;
+      unsigned cb_sum = 0;
+      unsigned cr_sum = 0;
+      for (int k = 0; k < 4; ++k) {
+        const size_t idx = (y * 2 + k / 2) * sprite->width + x * 2 + k % 2;
+        alpha_sum += sprite->luma_alpha[idx];
+        cb_sum += cb[idx] * sprite->luma_alpha[idx];
+        cr_sum += cr[idx] * sprite->luma_alpha[idx];
+      }
+
+      const size_t cidx = y * (sprite->width / 2) + x;
+      sprite->chroma_alpha[cidx] = alpha_sum / 4;
+      if (alpha_sum) {
+        sprite->cb[cidx] = cb_sum / alpha_sum;
+        sprite->cr[cidx] = cr_sum / alpha_sum;
+      }
+    }
+  }
+}
+
+void MosaicMeterRenderer::Blend(const Sprite& sprite, const YuvFrameInfo& frame, const YuvPlanes& planes) {
+  for (int y = 0; y < sprite.height; ++y) {
+    uint8_t* row = planes.luma + (sprite.y + y) * planes.luma_stride + sprite.x;
+    const uint8_t* src = &sprite.luma[y * sprite.width];
+    const uint8_t* alpha = &sprite.luma_alpha[y * sprite.width];
+    for (int x = 0; x < sprite.width; ++x) {
+      if (alpha[x]) {
+        row[x] = BlendPixel(src[x], row[x], alpha[x]);
+      }
+    }
+  }
+
+  const int chroma_width = sprite.width / 2;
+  const int chroma_x = sprite.x / 2;
+  const int chroma_y = sprite.y / 2;
+  for (int y = 0; y < sprite.height / 2; ++y) {
+    const size_t offset = (chroma_y + y) * planes.chroma_stride;
+    for (int x = 0; x < chroma_width; ++x) {
+      const size_t idx = y * chroma_width + x;
+      const uint8_t alpha = sprite.chroma_alpha[idx];
+      if (!alpha) {
+        continue;
+      }
+
+      uint8_t* cb = frame.format == YUV_NV12 ? planes.chroma_u + offset + (chroma_x + x) * 2
+                                             : planes.chroma_u + offset + chroma_x + x;
+      uint8_t* cr = frame.format == YUV_NV12 ? cb + 1 : planes.chroma_v + offset + chroma_x + x;
+      *cb = BlendPixel(sprite.cb[idx], *cb, alpha);
+      *cr = BlendPixel(sprite.cr[idx], *cr, alpha);
+    }
+  }
+}
+
+}  // namespace streams
+}  // namespace stream
+}  // namespace iptv_cloud
@@ -0,0 +1,75 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "stream/yuv_frame.h"
+
+#include "stream/streams/mosaic_options.h"
+
+namespace iptv_cloud {
+namespace stream {
+namespace streams {
+
+// draws audio level meters of mosaic tiles straight into planar yuv frames,
+// meter sprite rasterized only when quantized levels change, blended only inside meter rectangle.
+class MosaicMeterRenderer {
+ public:
+  enum { COUNT_CHUNKS = 10, CHANNELS = 2 };
+
+  MosaicMeterRenderer();
+
+  // returns false if frame not large enough for format
+  bool Draw(const MosaicImageOptions& options, const YuvFrameInfo& frame, uint8_t* data, size_t size);
+
+  size_t GetRasterizeCount() const;
+
+ private:
+  struct Sprite {
+    int x;  // even, clipped to frame
+    int y;
+    int width;
+    int height;
+    std::vector<uint8_t> luma;
+    std::vector<uint8_t> luma_alpha;
+    std::vector<uint8_t> cb;
+    std::vector<uint8_t> cr;
+    std::vector<uint8_t> chroma_alpha;
+  };
+
+  struct TileMeter {
+    bool rasterized;
+    std::vector<int> levels;  // lit chunks per channel
+    int x;
+    int y;
+    int width;
+    int height;
+    Sprite sprite;
+  };
+
+  void Rasterize(const MosaicImageOptions& options, const StreamInfo& stream, const YuvFrameInfo& frame, TileMeter* meter);
+  static void Blend(const Sprite& sprite, const YuvFrameInfo& frame, const YuvPlanes& planes);
+
+  YuvFrameInfo frame_;
+  std::vector<TileMeter> meters_;
+  size_t rasterize_count_;
+};
+
+}  // namespace streams
+}  // namespace stream
+}  // namespace iptv_cloud
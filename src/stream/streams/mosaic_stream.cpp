@@ -23,15 +23,12 @@
 #include "base/gst_constants.h"
 #include "stream/gstreamer_utils.h"
 
-#include "stream/elements/video/video.h"
+#include "stream/elements/element.h"
 
 #include "stream/streams/builders/mosaic_stream_builder.h"
 
 #include "stream/pad/pad.h"
 
-#define COUNT_CHUNKS 10
-#define CHANNELS 2
-
 namespace iptv_cloud {
 namespace stream {
 namespace streams {
@@ -50,10 +47,21 @@ void MosaicStream::ConnectDecodebinSignals(elements::ElementDecodebin* decodebin
   DCHECK(element_added);
 }
 
-void MosaicStream::ConnectCairoSignals(elements::video::ElementCairoOverlay* cairo, const MosaicImageOptions& options) {
-  options_ = options;
-  gboolean cairo_draw = cairo->RegisterDrawCallback(cairo_draw_callback, this);
-  DCHECK(cairo_draw);
+void MosaicStream::ConnectMeterProbe(elements::ElementCapsFilter* meter, const MosaicImageOptions& options) {
+  {
+    std::unique_lock<std::mutex> lock(options_mutex_);
+    options_ = options;
+  }
+
+  pad::Pad* src_pad = meter->StaticPad("src");
+  if (src_pad->IsValid()) {
+    gulong id_probe = gst_pad_add_probe(src_pad->GetGstPad(),
+                                        static_cast<GstPadProbeType>(GST_PAD_PROBE_TYPE_BUFFER |
+                                                                     GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM),
+                                        meter_probe_callback, this, nullptr);
+    DCHECK(id_probe);
+  }
+  delete src_pad;
 }
 
 gboolean MosaicStream::HandleDecodeBinAutoplugger(GstElement* elem, GstPad* pad, GstCaps* caps) {
@@ -163,6 +171,7 @@ void MosaicStream::HandleDecodeBinPadAdded(GstElement* src, GstPad* new_pad) {
       GstStructure* pad_struct = gst_caps_get_structure(caps, 0);
       if (pad_struct) {
         gint channels = 0;
+        std::unique_lock<std::mutex> lock(options_mutex_);
         if (gst_structure_get_int(pad_struct, "channels", &channels)) {
           for (gint i = 0; i < channels; ++i) {
             if (options_.sreams.size() > elem_id) {
@@ -220,64 +229,54 @@ GValueArray* MosaicStream::HandleAutoplugSort(GstElement* bin, GstPad* pad, GstC
   return nullptr;
 }
 
-void MosaicStream::HandleCairoDraw(GstElement* overlay, cairo_t* cr, guint64 timestamp, guint64 duration) {
-  UNUSED(overlay);
-  UNUSED(duration);
-  UNUSED(timestamp);
-
-  if (!options_.isValid()) {
-    return;
-  }
+GstPadProbeReturn MosaicStream::HandleMeterProbe(GstPad* pad, GstPadProbeInfo* info) {
+  UNUSED(pad);
 
-  int right_padding = options_.right_padding;
-  int width_chunk = options_.right_padding / (2 * CHANNELS);
-  int padding = width_chunk;
-
-  for (const StreamInfo& stream : options_.sreams) {
-    ImageInfo img = stream.img;
-    SoundInfo sound = stream.sound;
-
-    common::draw::Size sz = img.size;
-    common::draw::Point xy = img.x_y;
-    int x0 = xy.x + sz.width - right_padding;
-    int y0 = xy.y;
-    int height_chuk = sz.height / (COUNT_CHUNKS * 2);
-    int x_padding = padding;
-    int y_padding = height_chuk;
-
-    for (size_t i = 0; i < COUNT_CHUNKS * 2; i += 2) {
-      for (size_t j = 0; j < CHANNELS; ++j) {
-        // AudioChannelInfo chan = sound.channels[j];
-        double val = 0.0;
-        if (sound.channels.size() > j) {
-          val = sound.channels[j].rms_dB / -10;
-        }
-        int pos = (COUNT_CHUNKS * 2 - i) / 2;  // backward
-        cairo_rectangle(cr, (x0 + x_padding) + (width_chunk * j) + (x_padding / 2 * j),
-                        (y0 + y_padding) + (height_chuk * i), width_chunk, height_chuk);
-        if (pos <= val) {
-          if (pos <= 5) {
-            cairo_set_source_rgba(cr, 0.0, 1.0, 0.0, 1);
-          } else if (pos <= 8) {
-            cairo_set_source_rgba(cr, 1.0, 1.0, 0.0, 1);
-          } else {
-            cairo_set_source_rgba(cr, 1.0, 0.0, 0.0, 1);
-          }
-        } else {
-          cairo_set_source_rgba(cr, 1.0, 1.0, 1.0, 0.7);
-        }
-        cairo_fill(cr);
+  if (info->type & GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM) {
+    GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+    if (GST_EVENT_TYPE(event) == GST_EVENT_CAPS) {
+      GstCaps* caps = nullptr;
+      gst_event_parse_caps(event, &caps);
+      meter_frame_valid_ = GetYuvFrameFromCaps(caps, &meter_frame_);
+      if (!meter_frame_valid_) {
+        gchar* caps_str = gst_caps_to_string(caps);
+        WARNING_LOG() << "Mosaic meters not supported for caps: " << caps_str;
+        g_free(caps_str);
       }
     }
+    return GST_PAD_PROBE_OK;
+  }
+
+  if (!meter_frame_valid_) {
+    return GST_PAD_PROBE_OK;
+  }
+
+  GstBuffer* buffer = gst_buffer_make_writable(GST_PAD_PROBE_INFO_BUFFER(info));
+  GST_PAD_PROBE_INFO_DATA(info) = buffer;
+  if (!SetYuvFrameLayout(buffer, &meter_frame_)) {
+    return GST_PAD_PROBE_OK;  // meta of other geometry or format
+  }
+
+  GstMapInfo map;
+  if (!gst_buffer_map(buffer, &map, GST_MAP_WRITE)) {
+    return GST_PAD_PROBE_OK;
+  }
 
-    // cairo_rectangle(cr, x0, y0, right_padding, sz.height);
-    // cairo_set_source_rgba(cr, 0.9, 0.0, 0.1, 0.7);
-    // cairo_fill(cr);
+  {
+    std::unique_lock<std::mutex> lock(options_mutex_);
+    meter_renderer_.Draw(options_, meter_frame_, map.data, map.size);
   }
+  gst_buffer_unmap(buffer, &map);
+  return GST_PAD_PROBE_OK;
 }
 
 MosaicStream::MosaicStream(const EncodingConfig* config, IStreamClient* client, StreamStruct* stats)
-    : IBaseStream(config, client, stats), options_() {}
+    : IBaseStream(config, client, stats),
+      options_mutex_(),
+      options_(),
+      meter_renderer_(),
+      meter_frame_(),
+      meter_frame_valid_(false) {}
 
 const char* MosaicStream::ClassName() const {
   return "MosaicStream";
@@ -297,8 +296,8 @@ void MosaicStream::OnDecodebinCreated(elements::ElementDecodebin* decodebin) {
   ConnectDecodebinSignals(decodebin);
 }
 
-void MosaicStream::OnCairoCreated(elements::video::ElementCairoOverlay* cairo, const MosaicImageOptions& options) {
-  ConnectCairoSignals(cairo, options);
+void MosaicStream::OnMeterCreated(elements::ElementCapsFilter* meter, const MosaicImageOptions& options) {
+  ConnectMeterProbe(meter, options);
 }
 
 IBaseBuilder* MosaicStream::CreateBuilder() {
@@ -335,6 +334,7 @@ gboolean MosaicStream::HandleAsyncBusMessageReceived(GstBus* bus, GstMessage* me
   array_val = gst_structure_get_value(s, "decay");
   GValueArray* decay_arr = static_cast<GValueArray*>(g_value_get_boxed(array_val));
 
+  std::unique_lock<std::mutex> lock(options_mutex_);
   for (guint i = 0; i < rms_arr->n_values; ++i) {
     if (options_.sreams.size() > elem_id) {
       const GValue* value = g_value_array_get_nth(rms_arr, i);
@@ -347,6 +347,7 @@ gboolean MosaicStream::HandleAsyncBusMessageReceived(GstBus* bus, GstMessage* me
       options_.sreams[elem_id].sound.channels[i].decay_dB = g_value_get_double(value);
     }
   }
+  lock.unlock();
   return IBaseStream::HandleAsyncBusMessageReceived(bus, message);
 }
 
@@ -375,13 +376,9 @@ gboolean MosaicStream::decodebin_autoplugger_callback(GstElement* elem,
   return stream->HandleDecodeBinAutoplugger(elem, pad, caps);
 }
 
-void MosaicStream::cairo_draw_callback(GstElement* overlay,
-                                       cairo_t* cr,
-                                       guint64 timestamp,
-                                       guint64 duration,
-                                       gpointer user_data) {
+GstPadProbeReturn MosaicStream::meter_probe_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
   MosaicStream* stream = reinterpret_cast<MosaicStream*>(user_data);
-  return stream->HandleCairoDraw(overlay, cr, timestamp, duration);
+  return stream->HandleMeterProbe(pad, info);
 }
 
 GValueArray* MosaicStream::decodebin_autoplug_sort_callback(GstElement* bin,
@@ -14,13 +14,14 @@
 
 #pragma once
 
-#include <cairo.h>
+#include <mutex>
 
 #include <gst/gst.h>
 
 #include "stream/ibase_stream.h"
 #include "stream/streams/configs/encoding_config.h"
 
+#include "stream/streams/mosaic_meter.h"
 #include "stream/streams/mosaic_options.h"
 
 namespace iptv_cloud {
@@ -35,10 +36,8 @@ class ElementDecodebin;
 }
 
 namespace elements {
-namespace video {
-class ElementCairoOverlay;
+class ElementCapsFilter;
 }
-}  // namespace elements
 
 namespace streams {
 
@@ -58,7 +57,7 @@ class MosaicStream : public IBaseStream {
   void OnOutputSinkPadCreated(common::uri::Url::scheme scheme, pad::Pad* sink_pad, element_id_t id) override;
 
   virtual void OnDecodebinCreated(elements::ElementDecodebin* decodebin);
-  virtual void OnCairoCreated(elements::video::ElementCairoOverlay* cairo, const MosaicImageOptions& options);
+  virtual void OnMeterCreated(elements::ElementCapsFilter* meter, const MosaicImageOptions& options);
 
   IBaseBuilder* CreateBuilder() override;
 
@@ -66,7 +65,7 @@ class MosaicStream : public IBaseStream {
   void PostLoop(ExitStatus status) override;
 
   virtual void ConnectDecodebinSignals(elements::ElementDecodebin* decodebin);
-  virtual void ConnectCairoSignals(elements::video::ElementCairoOverlay* cairo, const MosaicImageOptions& options);
+  virtual void ConnectMeterProbe(elements::ElementCapsFilter* meter, const MosaicImageOptions& options);
 
   gboolean HandleAsyncBusMessageReceived(GstBus* bus, GstMessage* message) override;
   virtual gboolean HandleDecodeBinAutoplugger(GstElement* elem, GstPad* pad, GstCaps* caps);
@@ -74,7 +73,7 @@ class MosaicStream : public IBaseStream {
   virtual GValueArray* HandleAutoplugSort(GstElement* bin, GstPad* pad, GstCaps* caps, GValueArray* factories);
   virtual void HandleElementAdded(GstBin* bin, GstElement* element);
 
-  virtual void HandleCairoDraw(GstElement* overlay, cairo_t* cr, guint64 timestamp, guint64 duration);
+  virtual GstPadProbeReturn HandleMeterProbe(GstPad* pad, GstPadProbeInfo* info);
 
  private:
   static void decodebin_pad_added_callback(GstElement* src, GstPad* new_pad, gpointer user_data);
@@ -86,13 +85,13 @@ class MosaicStream : public IBaseStream {
                                                        gpointer user_data);
   static void decodebin_element_added_callback(GstBin* bin, GstElement* element, gpointer user_data);
 
-  static void cairo_draw_callback(GstElement* overlay,
-                                  cairo_t* cr,
-                                  guint64 timestamp,
-                                  guint64 duration,
-                                  gpointer user_data);
+  static GstPadProbeReturn meter_probe_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
 
+  std::mutex options_mutex_;  // levels updated from bus, meters drawn in streaming thread
   MosaicImageOptions options_;
+  MosaicMeterRenderer meter_renderer_;
+  YuvFrameInfo meter_frame_;
+  bool meter_frame_valid_;
 };
 
 }  // namespace streams
@@ -14,6 +14,7 @@
 
 #include "stream/streams/relay/playlist_relay_stream.h"
 
+#include <algorithm>
 #include <string>
 
 #include <gst/app/gstappsrc.h>  // for GST_APP_SRC
@@ -23,20 +24,27 @@
 
 #include "stream/streams/builders/relay/playlist_relay_stream_builder.h"
 
-#define BUFFER_SIZE 4096
+// whole ts packets, ~6 buffers per second for 10 Mbps input
+#define BUFFER_SIZE (188 * 1024)
 
 namespace iptv_cloud {
 namespace stream {
 namespace streams {
 
 PlaylistRelayStream::PlaylistRelayStream(const PlaylistRelayConfig* config, IStreamClient* client, StreamStruct* stats)
-    : RelayStream(config, client, stats), app_src_(nullptr), current_file_(nullptr), curent_pos_(0) {}
+    : RelayStream(config, client, stats),
+      app_src_(nullptr),
+      current_file_(),
+      current_path_(),
+      curent_pos_(0),
+      next_prefetched_(false),
+      file_start_msec_(0),
+      file_buffers_(0),
+      total_bytes_(0),
+      total_buffers_(0) {}
 
 PlaylistRelayStream::~PlaylistRelayStream() {
-  if (current_file_) {
-    fclose(current_file_);
-    current_file_ = nullptr;
-  }
+  current_file_.Close();
 }
 
 const char* PlaylistRelayStream::ClassName() const {
@@ -57,6 +65,11 @@ IBaseBuilder* PlaylistRelayStream::CreateBuilder() {
 void PlaylistRelayStream::PreLoop() {}
 
 void PlaylistRelayStream::PostLoop(ExitStatus status) {
+  if (current_file_.IsOpen()) {
+    ReportFileDone();
+    current_file_.Close();
+  }
+  INFO_LOG() << "Playlist feeder pushed " << total_bytes_ << " bytes in " << total_buffers_ << " buffers";
   RelayStream::PostLoop(status);
 }
 
@@ -64,32 +77,32 @@ void PlaylistRelayStream::HandleNeedData(GstElement* pipeline, guint rsize) {
   UNUSED(pipeline);
   UNUSED(rsize);
 
-  char* ptr = static_cast<char*>(calloc(BUFFER_SIZE, sizeof(char)));
-  if (!ptr) {
-    app_src_->SendEOS();  // send  eos
-    return;
-  }
-
-  size_t size = 0;
-  while (size == 0) {
-    if (!current_file_) {
-      current_file_ = OpenNextFile();
+  if (current_file_.IsEnd()) {
+    if (current_file_.IsOpen()) {
+      ReportFileDone();
+      current_file_.Close();
     }
 
-    if (!current_file_) {
+    if (!OpenNextFile()) {
       app_src_->SendEOS();  // send  eos
-      free(ptr);
       return;
     }
+  }
 
-    size = fread(ptr, sizeof(char), BUFFER_SIZE, current_file_);
-    if (size == 0) {
-      fclose(current_file_);
-      current_file_ = nullptr;
-    }
+  GstBuffer* buffer = current_file_.ReadBuffer(BUFFER_SIZE);
+  if (!buffer) {  // truncated or unreadable file is at end, continue with next one
+    HandleNeedData(pipeline, rsize);
+    return;
+  }
+
+  const gsize size = gst_buffer_get_size(buffer);
+  file_buffers_++;
+  total_buffers_++;
+  total_bytes_ += size;
+  if (!next_prefetched_ && current_file_.GetRemaining() <= MappedFile::prefetch_size) {
+    PrefetchNextFile();
   }
 
-  GstBuffer* buffer = gst_buffer_new_wrapped(ptr, size);
   GstFlowReturn ret = app_src_->PushBuffer(buffer);
   if (ret != GST_FLOW_OK) {
     WARNING_LOG() << "gst_app_src_push_buffer failed: " << gst_flow_get_name(ret);
@@ -102,37 +115,74 @@ void PlaylistRelayStream::need_data_callback(GstElement* pipeline, guint size, g
   return stream->HandleNeedData(pipeline, size);
 }
 
-FILE* PlaylistRelayStream::OpenNextFile() {
+bool PlaylistRelayStream::GetNextInput(size_t* pos, InputUri* iuri) const {
   const PlaylistRelayConfig* rconf = static_cast<const PlaylistRelayConfig*>(GetConfig());
-  const bool loop = rconf->GetLoop();
-
-  if (!loop) {
-    input_t input = rconf->GetInput();
-    if (curent_pos_ >= input.size()) {
-      INFO_LOG() << "No more files for playing";
-      return nullptr;  // EOS
+  input_t input = rconf->GetInput();
+  size_t cur = *pos;
+  if (cur >= input.size()) {
+    if (!rconf->GetLoop() || input.empty()) {
+      return false;
     }
+    cur = 0;
   }
 
-  input_t input = rconf->GetInput();
-  if (curent_pos_ >= input.size()) {
-    curent_pos_ = 0;
-  }
+  *iuri = input[cur];
+  *pos = cur + 1;
+  return true;
+}
+
+bool PlaylistRelayStream::OpenNextFile() {
+  const PlaylistRelayConfig* rconf = static_cast<const PlaylistRelayConfig*>(GetConfig());
+  const size_t files_count = rconf->GetInput().size();
+  // skip unreadable files, but at most one playlist round
+  for (size_t i = 0; i < files_count; ++i) {
+    InputUri iuri;
+    if (!GetNextInput(&curent_pos_, &iuri)) {
+      break;
+    }
+
+    common::uri::Url uri = iuri.GetInput();
+    common::uri::Upath path = uri.GetPath();
+    std::string cur_path = path.GetPath();
+    common::ErrnoError err = current_file_.Open(cur_path);
+    if (err) {
+      WARNING_LOG() << "File " << cur_path << " can't open for playing: " << err->GetDescription();
+      continue;
+    }
 
-  InputUri iuri = input[curent_pos_++];
-  common::uri::Url uri = iuri.GetInput();
-  common::uri::Upath path = uri.GetPath();
-  std::string cur_path = path.GetPath();
-  FILE* file = fopen(cur_path.c_str(), "rb");
-  if (file) {
     INFO_LOG() << "File " << cur_path << " open for playing";
+    current_path_ = cur_path;
+    next_prefetched_ = false;
+    file_start_msec_ = common::time::current_mstime();
+    file_buffers_ = 0;
     if (client_) {
       client_->OnInputChanged(iuri);
     }
-  } else {
-    WARNING_LOG() << "File " << cur_path << "can't open for playing";
+    return true;
+  }
+
+  INFO_LOG() << "No more files for playing";
+  return false;
+}
+
+void PlaylistRelayStream::PrefetchNextFile() {
+  next_prefetched_ = true;
+  size_t pos = curent_pos_;
+  InputUri iuri;
+  if (!GetNextInput(&pos, &iuri)) {
+    return;
   }
-  return file;
+
+  common::uri::Url uri = iuri.GetInput();
+  common::uri::Upath path = uri.GetPath();
+  MappedFile::Prefetch(path.GetPath());
+}
+
+void PlaylistRelayStream::ReportFileDone() {
+  const common::time64_t elapsed_msec = std::max<common::time64_t>(common::time::current_mstime() - file_start_msec_, 1);
+  const size_t size = current_file_.GetPosition();
+  INFO_LOG() << "File " << current_path_ << " fed " << size << " bytes in " << file_buffers_ << " buffers, "
+             << size * 8 / elapsed_msec << " kbps";
 }
 
 }  // namespace streams
@@ -14,6 +14,9 @@
 
 #pragma once
 
+#include <common/time.h>
+
+#include "stream/mapped_file.h"
 #include "stream/streams/relay/relay_stream.h"
 
 namespace iptv_cloud {
@@ -52,11 +55,22 @@ class PlaylistRelayStream : public RelayStream {
  private:
   static void need_data_callback(GstElement* pipeline, guint size, gpointer user_data);
 
-  FILE* OpenNextFile();
+  bool OpenNextFile();
+  bool GetNextInput(size_t* pos, InputUri* iuri) const;
+  void PrefetchNextFile();
+  void ReportFileDone();
 
   elements::sources::ElementAppSrc* app_src_;
-  FILE* current_file_;
+  MappedFile current_file_;
+  std::string current_path_;
   size_t curent_pos_;
+  bool next_prefetched_;
+
+  // feeder throughput
+  common::time64_t file_start_msec_;
+  uint64_t file_buffers_;
+  uint64_t total_bytes_;
+  uint64_t total_buffers_;
 };
 
 }  // namespace streams
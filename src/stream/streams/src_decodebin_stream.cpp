@@ -14,8 +14,15 @@
 
 #include "stream/streams/src_decodebin_stream.h"
 
+#include <string.h>
+
+#include <algorithm>
+#include <string>
+
 #include "stream/config.h"
+#include "stream/gstreamer_utils.h"  // for pad_get_type
 #include "stream/pad/pad.h"
+#include "stream/streams/builders/src_decodebin_stream_builder.h"
 
 namespace iptv_cloud {
 namespace stream {
@@ -101,6 +108,25 @@ void SrcDecodeBinStream::decodebin_element_removed_callback(GstBin* bin, GstElem
   return stream->HandleDecodeBinElementRemoved(bin, element);
 }
 
+void SrcDecodeBinStream::demuxer_pad_added_callback(GstElement* src, GstPad* new_pad, gpointer user_data) {
+  SrcDecodeBinStream* stream = reinterpret_cast<SrcDecodeBinStream*>(user_data);
+  stream->HandleDemuxerPadAdded(src, new_pad);
+}
+
+GstPadProbeReturn SrcDecodeBinStream::demuxed_caps_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data) {
+  UNUSED(pad);
+  GstEvent* event = GST_PAD_PROBE_INFO_EVENT(info);
+  if (GST_EVENT_TYPE(event) != GST_EVENT_CAPS) {
+    return GST_PAD_PROBE_OK;
+  }
+
+  SrcDecodeBinStream* stream = reinterpret_cast<SrcDecodeBinStream*>(user_data);
+  GstCaps* caps = nullptr;
+  gst_event_parse_caps(event, &caps);
+  stream->HandleDemuxedCaps(caps);
+  return GST_PAD_PROBE_OK;
+}
+
 void SrcDecodeBinStream::OnInpudSrcPadCreated(common::uri::Url::scheme scheme, pad::Pad* src_pad, element_id_t id) {
   UNUSED(scheme);
   LinkInputPad(src_pad->GetGstPad(), id);
@@ -111,10 +137,145 @@ void SrcDecodeBinStream::OnOutputSinkPadCreated(common::uri::Url::scheme scheme,
   LinkOutputPad(sink_pad->GetGstPad(), id);
 }
 
+bool SrcDecodeBinStream::HandleReconfigure(const Config* config) {
+  builders::SrcDecodeStreamBuilder* builder = static_cast<builders::SrcDecodeStreamBuilder*>(GetBuilder());
+  const output_t active = builder->GetActiveOutputs();
+  const output_t next = config->GetOutput();
+
+  // changed output removed and added again with new branch
+  for (const OutputUri& output : active) {
+    if (std::find(next.begin(), next.end(), output) != next.end()) {
+      continue;
+    }
+
+    element_id_t branch_id;
+    if (builder->GetOutputBranchID(output.GetID(), &branch_id)) {
+      RemoveOutputProbes(branch_id);
+    }
+    if (!builder->RemoveOutput(output.GetID())) {
+      return false;
+    }
+    INFO_LOG() << "Output " << output.GetID() << " removing without restart.";
+  }
+
+  for (const OutputUri& output : next) {
+    if (std::find(active.begin(), active.end(), output) != active.end()) {
+      continue;
+    }
+
+    element_id_t branch_id;
+    if (!builder->AddOutput(output) || !builder->GetOutputBranchID(output.GetID(), &branch_id)) {
+      return false;
+    }
+    AddOutputStats(branch_id, output.GetID());
+    INFO_LOG() << "Output " << output.GetID() << " added without restart.";
+  }
+
+  return true;
+}
+
+void SrcDecodeBinStream::OnOutputBranchRemoved(element_id_t id) {
+  SyncPipelineElements();
+  INFO_LOG() << "Output branch " << id << " left pipeline.";
+}
+
 void SrcDecodeBinStream::OnDecodebinCreated(elements::ElementDecodebin* decodebin) {
   ConnectDecodebinSignals(decodebin);
 }
 
+void SrcDecodeBinStream::OnDemuxerCreated(elements::ElementTsDemux* demuxer) {
+  gboolean pad_added = demuxer->RegisterPadAddedCallback(demuxer_pad_added_callback, this);
+  DCHECK(pad_added);
+}
+
+void SrcDecodeBinStream::OnDemuxerCreated(elements::ElementFLVDemux* demuxer) {
+  gboolean pad_added = demuxer->RegisterPadAddedCallback(demuxer_pad_added_callback, this);
+  DCHECK(pad_added);
+}
+
+void SrcDecodeBinStream::HandleDemuxerPadAdded(GstElement* src, GstPad* new_pad) {
+  const gchar* new_pad_type = pad_get_type(new_pad);
+  if (!new_pad_type) {
+    DNOTREACHED();
+    return;
+  }
+
+  builders::SrcDecodeStreamBuilder* builder = static_cast<builders::SrcDecodeStreamBuilder*>(GetBuilder());
+  const Connector conn = builder->GetDemuxedConnector();
+  bool is_video = strncmp(new_pad_type, "video", 5) == 0;
+  bool is_audio = strncmp(new_pad_type, "audio", 5) == 0;
+  INFO_LOG() << "Demuxed pad added: " << new_pad_type;
+  elements::Element* dest = nullptr;
+  if (is_video) {
+    if (conn.video && !IsVideoInited()) {
+      dest = conn.video;
+    }
+  } else if (is_audio) {
+    if (conn.audio && !IsAudioInited()) {
+      dest = conn.audio;
+    }
+  } else {
+    // something else
+  }
+
+  if (!dest) {
+    return;
+  }
+
+  pad::Pad* sink_pad = dest->StaticPad("sink");
+  if (!sink_pad->IsValid()) {
+    delete sink_pad;
+    return;
+  }
+
+  GstPadLinkReturn ret = gst_pad_link(new_pad, sink_pad->GetGstPad());
+  delete sink_pad;
+  if (GST_PAD_LINK_FAILED(ret)) {
+    WARNING_LOG() << "Demuxed " << new_pad_type << " can't be linked to " << dest->GetName()
+                  << ", please check input parsers or remove them to use decodebin.";
+    return;
+  }
+
+  DEBUG_LOG() << "Pad emitted: " << GST_ELEMENT_NAME(src) << " " << GST_PAD_NAME(new_pad) << " " << new_pad_type;
+  pad::Pad* src_pad = dest->StaticPad("src");
+  if (src_pad->IsValid()) {  // parsed caps, same stats as decodebin autoplugging gives
+    gst_pad_add_probe(src_pad->GetGstPad(), GST_PAD_PROBE_TYPE_EVENT_DOWNSTREAM, demuxed_caps_callback, this,
+                      nullptr);
+  }
+  delete src_pad;
+
+  if (is_video) {
+    SetVideoInited(true);
+  } else if (is_audio) {
+    SetAudioInited(true);
+  }
+}
+
+void SrcDecodeBinStream::HandleDemuxedCaps(GstCaps* caps) {
+  std::string type_title;
+  std::string type_full;
+  if (!get_type_from_caps(caps, &type_title, &type_full)) {
+    return;
+  }
+
+  SupportedAudioCodec saudio;
+  SupportedVideoCodec svideo;
+  GstStructure* pad_struct = gst_caps_get_structure(caps, 0);
+  if (IsVideoCodecFromType(type_title, &svideo)) {
+    gint width = 0;
+    gint height = 0;
+    if (pad_struct && gst_structure_get_int(pad_struct, "width", &width) &&
+        gst_structure_get_int(pad_struct, "height", &height)) {
+      RegisterVideoCaps(svideo, caps, 0);
+    }
+  } else if (IsAudioCodecFromType(type_title, &saudio)) {
+    gint rate = 0;
+    if (pad_struct && gst_structure_get_int(pad_struct, "rate", &rate)) {
+      RegisterAudioCaps(saudio, caps, 0);
+    }
+  }
+}
+
 }  // namespace streams
 }  // namespace stream
 }  // namespace iptv_cloud
@@ -38,8 +38,12 @@ class SrcDecodeBinStream : public IBaseStream {
   void OnInpudSrcPadCreated(common::uri::Url::scheme scheme, pad::Pad* src_pad, element_id_t id) override;
   void OnOutputSinkPadCreated(common::uri::Url::scheme scheme, pad::Pad* sink_pad, element_id_t id) override;
   virtual void OnDecodebinCreated(elements::ElementDecodebin* decodebin);
+  virtual void OnDemuxerCreated(elements::ElementTsDemux* demuxer);
+  virtual void OnDemuxerCreated(elements::ElementFLVDemux* demuxer);
 
   IBaseBuilder* CreateBuilder() override = 0;
+  bool HandleReconfigure(const Config* config) override;  // outputs add/remove
+  void OnOutputBranchRemoved(element_id_t id);             // removed output left pipeline
 
   void PreLoop() override;
   void PostLoop(ExitStatus status) override;
@@ -57,7 +61,12 @@ class SrcDecodeBinStream : public IBaseStream {
   virtual void HandleDecodeBinElementAdded(GstBin* bin, GstElement* element) = 0;
   virtual void HandleDecodeBinElementRemoved(GstBin* bin, GstElement* element) = 0;
 
+  virtual void HandleDemuxerPadAdded(GstElement* src, GstPad* new_pad);
+  virtual void HandleDemuxedCaps(GstCaps* caps);
+
  private:
+  static void demuxer_pad_added_callback(GstElement* src, GstPad* new_pad, gpointer user_data);
+  static GstPadProbeReturn demuxed_caps_callback(GstPad* pad, GstPadProbeInfo* info, gpointer user_data);
   static void decodebin_pad_added_callback(GstElement* src, GstPad* new_pad, gpointer user_data);
   static gboolean decodebin_autoplugger_callback(GstElement* elem, GstPad* pad, GstCaps* caps, gpointer user_data);
 
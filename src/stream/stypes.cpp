@@ -19,6 +19,8 @@
 #include <common/convert2string.h>
 #include <common/sprintf.h>
 
+#include "base/constants.h"
+
 #define APPLICATION_HLS "application/x-hls"
 #define APPLICATION_ICY "application/x-icy"
 #define APPLICATION_TELETEXT "application/x-teletext"
@@ -41,6 +43,12 @@
 #define RAW_VIDEO "video/x-raw"
 #define RAW_AUDIO "audio/x-raw"
 
+namespace {
+bool HasExtension(const std::string& path, const std::string& ext) {
+  return path.size() > ext.size() && path.compare(path.size() - ext.size(), ext.size(), ext) == 0;
+}
+}  // namespace
+
 namespace iptv_cloud {
 namespace stream {
 
@@ -159,6 +167,40 @@ bool IsDemuxerFromType(const std::string& type, SupportedDemuxer* dc) {
   return false;
 }
 
+bool GetDemuxerFromUrl(const common::uri::Url& url, SupportedDemuxer* dc) {
+  if (!dc) {
+    return false;
+  }
+
+  const common::uri::Url::scheme scheme = url.GetScheme();
+  if (scheme == common::uri::Url::udp || scheme == common::uri::Url::tcp) {
+    *dc = VIDEO_MPEGTS_DEMUXER;
+    return true;
+  } else if (scheme == common::uri::Url::rtmp) {
+    *dc = VIDEO_FLV_DEMUXER;
+    return true;
+  } else if (scheme == common::uri::Url::file || scheme == common::uri::Url::http ||
+             scheme == common::uri::Url::https) {
+    const std::string path = url.GetPath().GetPath();
+    if (HasExtension(path, ".ts")) {
+      *dc = VIDEO_MPEGTS_DEMUXER;
+      return true;
+    } else if (HasExtension(path, ".flv")) {
+      *dc = VIDEO_FLV_DEMUXER;
+      return true;
+    }
+    return false;
+  }
+
+  const std::string raw = url.GetUrl();
+  if (raw.compare(0, SIZEOFMASS(SHM_URL) - 1, SHM_URL) == 0) {  // muxed by other stream
+    *dc = VIDEO_MPEGTS_DEMUXER;
+    return true;
+  }
+
+  return false;
+}
+
 bool IsVideoCodecFromType(const std::string& type, SupportedVideoCodec* vc) {
   if (type.empty() || !vc) {
     return false;
@@ -44,6 +44,7 @@
 #define VIDEOMIXER_NAME_1U "videomixer_%lu"
 #define INTERLIVE_NAME_1U "interlive_%lu"
 #define CAIRO_NAME_1U "cairo_%lu"
+#define MOSAIC_METER_NAME_1U "mosaic_meter_%lu"
 #define QUEUE2_NAME_1U "queue2_%lu"
 
 #define AUDIO_CONVERT_CAPS_FILTER_NAME_1U "audio_convert_capsfilter_%lu"
@@ -66,6 +67,11 @@
 #define MPEG_AUDIO_PARSE_NAME_1U "mpegaudioparse_%lu"
 
 #define DECODEBIN_NAME_1U "decodebin_%lu"
+#define DEMUXER_NAME_1U "demuxer_%lu"
+#define DEMUXED_VIDEO_PARSER_NAME_1U "demuxed_video_parser_%lu"
+#define DEMUXED_AUDIO_PARSER_NAME_1U "demuxed_audio_parser_%lu"
+#define VIDEO_DECODER_NAME_1U "video_decoder_%lu"
+#define AUDIO_DECODER_NAME_1U "audio_decoder_%lu"
 #define VIDEOBOX_NAME_1U "videobox_%lu"
 
 #define VIDEO_DECODEBIN_NAME_1U "video_decodebin_%lu"
@@ -87,6 +93,11 @@
 
 #define AUDIO_LEVEL_NAME_1U "level_%lu"
 
+#define PUBLISH_INPUT_TEE_NAME_1U "publish_input_tee_%lu"
+#define PUBLISH_INPUT_QUEUE_NAME_1U "publish_input_queue_%lu"
+#define PUBLISH_INPUT_SINK_NAME_1U "publish_input_sink_%lu"
+#define DECODE_INPUT_QUEUE_NAME_1U "decode_input_queue_%lu"
+
 #define TS_TEMPLATE "%05d" CHUNK_EXT
 
 // devices
@@ -148,6 +159,8 @@ enum SupportedRawStream {
 
 bool IsOtherFromType(const std::string& type, SupportedOtherType* oc);
 bool IsDemuxerFromType(const std::string& type, SupportedDemuxer* dc);
+// container known without typefind: udp/tcp/shm - mpegts, rtmp - flv, files and http by extension
+bool GetDemuxerFromUrl(const common::uri::Url& url, SupportedDemuxer* dc);
 bool IsVideoCodecFromType(const std::string& type, SupportedVideoCodec* vc);
 bool IsAudioCodecFromType(const std::string& type, SupportedAudioCodec* ac);
 bool IsRawStreamFromType(const std::string& type, SupportedRawStream* rc);
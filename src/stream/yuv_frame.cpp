@@ -0,0 +1,173 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream/yuv_frame.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#include <gst/video/video.h>
+
+namespace {
+int RoundUp4(int value) {
+  return (value + 3) & ~3;
+}
+
+int RoundUp2(int value) {
+  return (value + 1) & ~1;
+}
+
+struct PlanesLayout {
+  int count;
+  int strides[3];
+  size_t offsets[3];
+};
+
+// gst_video_info_set_format strides and offsets for default layout
+PlanesLayout GetPlanesLayout(const iptv_cloud::stream::YuvFrameInfo& frame) {
+  PlanesLayout layout;
+  const bool nv12 = frame.format == iptv_cloud::stream::YUV_NV12;
+  layout.count = nv12 ? 2 : 3;
+  if (frame.strides[0] != 0) {
+    for (int i = 0; i < 3; ++i) {
+      layout.strides[i] = frame.strides[i];
+      layout.offsets[i] = frame.offsets[i];
+    }
+    return layout;
+  }
+
+  const size_t chroma_height = RoundUp2(frame.height) / 2;
+  layout.strides[0] = RoundUp4(frame.width);
+  layout.offsets[0] = 0;
+  layout.offsets[1] = static_cast<size_t>(layout.strides[0]) * RoundUp2(frame.height);
+  if (nv12) {
+    layout.strides[1] = layout.strides[0];
+    layout.strides[2] = 0;
+    layout.offsets[2] = 0;
+    return layout;
+  }
+
+  layout.strides[1] = RoundUp4(RoundUp2(frame.width) / 2);
+  layout.strides[2] = layout.strides[1];
+  layout.offsets[2] = layout.offsets[1] + layout.strides[1] * chroma_height;
+  return layout;
+}
+}  // namespace
+
+namespace iptv_cloud {
+namespace stream {
+
+bool operator==(const YuvFrameInfo& left, const YuvFrameInfo& right) {
+  return left.format == right.format && left.width == right.width && left.height == right.height;
+}
+
+size_t GetYuvFrameSize(const YuvFrameInfo& frame) {
+  if (frame.width <= 0 || frame.height <= 0) {
+    return 0;
+  }
+
+  const PlanesLayout layout = GetPlanesLayout(frame);
+  const size_t chroma_height = RoundUp2(frame.height) / 2;
+  const size_t chroma_row = frame.format == YUV_NV12 ? RoundUp2(frame.width) : RoundUp2(frame.width) / 2;
+  size_t size = 0;
+  for (int i = 0; i < layout.count; ++i) {
+    const size_t row = i == 0 ? frame.width : chroma_row;
+    const size_t rows = i == 0 ? frame.height : chroma_height;
+    if (layout.strides[i] < 0 || static_cast<size_t>(layout.strides[i]) < row) {
+      return 0;
+    }
+
+    // last row of plane without stride padding
+    size = std::max(size, layout.offsets[i] + layout.strides[i] * (rows - 1) + row);
+  }
+  return size;
+}
+
+bool MapYuvPlanes(const YuvFrameInfo& frame, uint8_t* data, size_t size, YuvPlanes* planes) {
+  const size_t frame_size = GetYuvFrameSize(frame);
+  if (!data || !planes || frame_size == 0 || size < frame_size) {
+    return false;
+  }
+
+  const PlanesLayout layout = GetPlanesLayout(frame);
+  if (frame.format == YUV_I420 && layout.strides[1] != layout.strides[2]) {
+    return false;  // planes share chroma stride
+  }
+
+  planes->luma = data + layout.offsets[0];
+  planes->luma_stride = layout.strides[0];
+  planes->chroma_u = data + layout.offsets[1];
+  planes->chroma_stride = layout.strides[1];
+  planes->chroma_v = frame.format == YUV_NV12 ? nullptr : data + layout.offsets[2];
+  return true;
+}
+
+bool GetYuvFrameFromCaps(GstCaps* caps, YuvFrameInfo* frame) {
+  if (!caps || !frame) {
+    return false;
+  }
+
+  GstStructure* caps_struct = gst_caps_get_structure(caps, 0);
+  if (!caps_struct) {
+    return false;
+  }
+
+  const gchar* format = gst_structure_get_string(caps_struct, "format");
+  YuvFrameInfo result = YuvFrameInfo();
+  if (!format || !gst_structure_get_int(caps_struct, "width", &result.width) ||
+      !gst_structure_get_int(caps_struct, "height", &result.height)) {
+    return false;
+  }
+
+  if (strcmp(format, "I420") == 0) {
+    result.format = YUV_I420;
+  } else if (strcmp(format, "NV12") == 0) {
+    result.format = YUV_NV12;
+  } else {
+    return false;
+  }
+
+  *frame = result;
+  return true;
+}
+
+bool SetYuvFrameLayout(GstBuffer* buffer, YuvFrameInfo* frame) {
+  if (!buffer || !frame) {
+    return false;
+  }
+
+  GstVideoMeta* meta = gst_buffer_get_video_meta(buffer);
+  if (!meta) {
+    memset(frame->strides, 0, sizeof(frame->strides));
+    memset(frame->offsets, 0, sizeof(frame->offsets));
+    return true;
+  }
+
+  const GstVideoFormat format = frame->format == YUV_NV12 ? GST_VIDEO_FORMAT_NV12 : GST_VIDEO_FORMAT_I420;
+  const guint planes = frame->format == YUV_NV12 ? 2 : 3;
+  if (meta->format != format || meta->n_planes != planes || static_cast<int>(meta->width) != frame->width ||
+      static_cast<int>(meta->height) != frame->height || meta->stride[0] <= 0) {
+    return false;
+  }
+
+  for (guint i = 0; i < 3; ++i) {
+    frame->strides[i] = i < planes ? meta->stride[i] : 0;
+    frame->offsets[i] = i < planes ? meta->offset[i] : 0;
+  }
+  return true;
+}
+
+}  // namespace stream
+}  // namespace iptv_cloud
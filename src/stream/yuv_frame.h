@@ -0,0 +1,61 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <gst/gst.h>
+
+#include <common/macros.h>
+
+namespace iptv_cloud {
+namespace stream {
+
+// raw planar yuv frame, default gstreamer layout (4 bytes aligned strides) or planes of video meta,
+// used by elements drawing straight into mapped buffers.
+enum YuvFormat { YUV_I420 = 0, YUV_NV12 = 1 };
+
+struct YuvFrameInfo {
+  YuvFormat format;
+  int width;
+  int height;
+  int strides[3];     // all 0 - default layout, otherwise from video meta of current buffer
+  size_t offsets[3];  // of planes from buffer start
+};
+
+struct YuvPlanes {
+  uint8_t* luma;
+  uint8_t* chroma_u;  // interleaved uv for NV12
+  uint8_t* chroma_v;  // nullptr for NV12
+  int luma_stride;
+  int chroma_stride;
+};
+
+// geometry only, layout may change per buffer
+bool operator==(const YuvFrameInfo& left, const YuvFrameInfo& right);
+inline bool operator!=(const YuvFrameInfo& left, const YuvFrameInfo& right) {
+  return !(left == right);
+}
+
+size_t GetYuvFrameSize(const YuvFrameInfo& frame);  // 0 if layout is invalid
+bool MapYuvPlanes(const YuvFrameInfo& frame, uint8_t* data, size_t size, YuvPlanes* planes) WARN_UNUSED_RESULT;
+bool GetYuvFrameFromCaps(GstCaps* caps, YuvFrameInfo* frame) WARN_UNUSED_RESULT;
+// layout of buffer: video meta if any (padded strides of hardware decoders, pools), default otherwise,
+// false if meta doesn't describe the frame, such buffer should be skipped
+bool SetYuvFrameLayout(GstBuffer* buffer, YuvFrameInfo* frame) WARN_UNUSED_RESULT;
+
+}  // namespace stream
+}  // namespace iptv_cloud
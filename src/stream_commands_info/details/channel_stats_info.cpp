@@ -22,6 +22,130 @@
 #define FIELD_STATS_TOTAL_BYTES "total_bytes"
 #define FIELD_STATS_BYTES_PER_SECOND "bps"
 #define FIELD_STATS_DESIRE_BYTES_PER_SECOND "dbps"
+#define FIELD_STATS_TS_QUALITY "ts"
+#define FIELD_STATS_SHM_FANOUT "shm"
+#define FIELD_STATS_DROPPED "dropped"
+
+#define FIELD_TS_PACKETS "packets"
+#define FIELD_TS_SYNC_LOSSES "sync_losses"
+#define FIELD_TS_SYNC_BYTE_ERRORS "sync_byte_errors"
+#define FIELD_TS_PAT_ERRORS "pat_errors"
+#define FIELD_TS_CC_ERRORS "cc_errors"
+#define FIELD_TS_TRANSPORT_ERRORS "transport_errors"
+#define FIELD_TS_PCR_REPETITION_ERRORS "pcr_repetition_errors"
+#define FIELD_TS_PCR_DISCONTINUITY_ERRORS "pcr_discontinuity_errors"
+#define FIELD_TS_PCR_PID "pcr_pid"
+#define FIELD_TS_PCR_INTERVAL_MAX "pcr_interval_max_msec"
+#define FIELD_TS_PCR_JITTER "pcr_jitter_usec"
+#define FIELD_TS_PCR_JITTER_MAX "pcr_jitter_max_usec"
+#define FIELD_TS_PIDS "pids"
+#define FIELD_TS_PID "pid"
+#define FIELD_TS_PID_BYTES_PER_SECOND "bps"
+
+#define FIELD_SHM_CAPACITY "capacity"
+#define FIELD_SHM_READERS "readers"
+#define FIELD_SHM_MAX_LAG_BYTES "max_lag_bytes"
+#define FIELD_SHM_OVERRUNS "overruns"
+
+namespace {
+
+struct TsCounterField {
+  const char* name;
+  uint64_t iptv_cloud::utils::mpegts::TsQuality::*field;
+};
+
+const TsCounterField kTsCounterFields[] = {
+    {FIELD_TS_PACKETS, &iptv_cloud::utils::mpegts::TsQuality::packets},
+    {FIELD_TS_SYNC_LOSSES, &iptv_cloud::utils::mpegts::TsQuality::sync_losses},
+    {FIELD_TS_SYNC_BYTE_ERRORS, &iptv_cloud::utils::mpegts::TsQuality::sync_byte_errors},
+    {FIELD_TS_PAT_ERRORS, &iptv_cloud::utils::mpegts::TsQuality::pat_errors},
+    {FIELD_TS_CC_ERRORS, &iptv_cloud::utils::mpegts::TsQuality::cc_errors},
+    {FIELD_TS_TRANSPORT_ERRORS, &iptv_cloud::utils::mpegts::TsQuality::transport_errors},
+    {FIELD_TS_PCR_REPETITION_ERRORS, &iptv_cloud::utils::mpegts::TsQuality::pcr_repetition_errors},
+    {FIELD_TS_PCR_DISCONTINUITY_ERRORS, &iptv_cloud::utils::mpegts::TsQuality::pcr_discontinuity_errors},
+    {FIELD_TS_PCR_INTERVAL_MAX, &iptv_cloud::utils::mpegts::TsQuality::pcr_interval_max_msec},
+    {FIELD_TS_PCR_JITTER, &iptv_cloud::utils::mpegts::TsQuality::pcr_jitter_usec},
+    {FIELD_TS_PCR_JITTER_MAX, &iptv_cloud::utils::mpegts::TsQuality::pcr_jitter_max_usec}};
+
+json_object* MakeTsQualityJson(const iptv_cloud::utils::mpegts::TsQuality& quality) {
+  json_object* obj = json_object_new_object();
+  for (size_t i = 0; i < SIZEOFMASS(kTsCounterFields); ++i) {
+    json_object_object_add(obj, kTsCounterFields[i].name, json_object_new_int64(quality.*kTsCounterFields[i].field));
+  }
+  json_object_object_add(obj, FIELD_TS_PCR_PID, json_object_new_int(quality.pcr_pid));
+
+  json_object* jpids = json_object_new_array();
+  for (size_t i = 0; i < quality.pids_count; ++i) {
+    json_object* jpid = json_object_new_object();
+    json_object_object_add(jpid, FIELD_TS_PID, json_object_new_int(quality.pids[i].pid));
+    json_object_object_add(jpid, FIELD_TS_PID_BYTES_PER_SECOND, json_object_new_int64(quality.pids[i].bytes_per_second));
+    json_object_array_add(jpids, jpid);
+  }
+  json_object_object_add(obj, FIELD_TS_PIDS, jpids);
+  return obj;
+}
+
+iptv_cloud::utils::mpegts::TsQuality ParseTsQualityJson(json_object* obj) {
+  iptv_cloud::utils::mpegts::TsQuality quality;
+  for (size_t i = 0; i < SIZEOFMASS(kTsCounterFields); ++i) {
+    json_object* jfield = nullptr;
+    if (json_object_object_get_ex(obj, kTsCounterFields[i].name, &jfield)) {
+      quality.*kTsCounterFields[i].field = json_object_get_int64(jfield);
+    }
+  }
+
+  json_object* jpcr_pid = nullptr;
+  if (json_object_object_get_ex(obj, FIELD_TS_PCR_PID, &jpcr_pid)) {
+    quality.pcr_pid = json_object_get_int(jpcr_pid);
+  }
+
+  json_object* jpids = nullptr;
+  if (json_object_object_get_ex(obj, FIELD_TS_PIDS, &jpids)) {
+    int len = json_object_array_length(jpids);
+    for (int i = 0; i < len && quality.pids_count < iptv_cloud::utils::mpegts::TsQuality::MAX_PIDS; ++i) {
+      json_object* jpid = json_object_array_get_idx(jpids, i);
+      json_object* jvalue = nullptr;
+      iptv_cloud::utils::mpegts::TsPidBitrate rate = {iptv_cloud::utils::mpegts::TS_NULL_PID, 0};
+      if (json_object_object_get_ex(jpid, FIELD_TS_PID, &jvalue)) {
+        rate.pid = json_object_get_int(jvalue);
+      }
+      if (json_object_object_get_ex(jpid, FIELD_TS_PID_BYTES_PER_SECOND, &jvalue)) {
+        rate.bytes_per_second = json_object_get_int64(jvalue);
+      }
+      quality.pids[quality.pids_count++] = rate;
+    }
+  }
+  return quality;
+}
+
+json_object* MakeShmFanoutJson(const iptv_cloud::utils::ShmRingFanout& fanout) {
+  json_object* obj = json_object_new_object();
+  json_object_object_add(obj, FIELD_SHM_CAPACITY, json_object_new_int64(fanout.capacity));
+  json_object_object_add(obj, FIELD_SHM_READERS, json_object_new_int(fanout.readers));
+  json_object_object_add(obj, FIELD_SHM_MAX_LAG_BYTES, json_object_new_int64(fanout.max_lag_bytes));
+  json_object_object_add(obj, FIELD_SHM_OVERRUNS, json_object_new_int64(fanout.overruns));
+  return obj;
+}
+
+iptv_cloud::utils::ShmRingFanout ParseShmFanoutJson(json_object* obj) {
+  iptv_cloud::utils::ShmRingFanout fanout = {0, 0, 0, 0};
+  json_object* jfield = nullptr;
+  if (json_object_object_get_ex(obj, FIELD_SHM_CAPACITY, &jfield)) {
+    fanout.capacity = json_object_get_int64(jfield);
+  }
+  if (json_object_object_get_ex(obj, FIELD_SHM_READERS, &jfield)) {
+    fanout.readers = json_object_get_int(jfield);
+  }
+  if (json_object_object_get_ex(obj, FIELD_SHM_MAX_LAG_BYTES, &jfield)) {
+    fanout.max_lag_bytes = json_object_get_int64(jfield);
+  }
+  if (json_object_object_get_ex(obj, FIELD_SHM_OVERRUNS, &jfield)) {
+    fanout.overruns = json_object_get_int64(jfield);
+  }
+  return fanout;
+}
+
+}  // namespace
 
 namespace iptv_cloud {
 namespace details {
@@ -54,6 +178,21 @@ common::Error ChannelStatsInfo::SerializeFields(json_object* out) const {
   std::string dbps_str = common::ConvertToString(dbps);
   json_object_object_add(out, FIELD_STATS_DESIRE_BYTES_PER_SECOND, json_object_new_string(dbps_str.c_str()));
 
+  const utils::mpegts::TsQuality quality = stats_.GetTsQuality();
+  if (quality.packets) {
+    json_object_object_add(out, FIELD_STATS_TS_QUALITY, MakeTsQualityJson(quality));
+  }
+
+  const utils::ShmRingFanout fanout = stats_.GetShmFanout();
+  if (fanout.capacity) {
+    json_object_object_add(out, FIELD_STATS_SHM_FANOUT, MakeShmFanoutJson(fanout));
+  }
+
+  const uint64_t dropped = stats_.GetDropped();
+  if (dropped) {
+    json_object_object_add(out, FIELD_STATS_DROPPED, json_object_new_int64(dropped));
+  }
+
   return common::Error();
 }
 
@@ -96,6 +235,24 @@ common::Error ChannelStatsInfo::DoDeSerialize(json_object* serialized) {
     stats.SetDesireBytesPerSecond(dbps);
   }
 
+  json_object* jts = nullptr;
+  json_bool jts_exists = json_object_object_get_ex(serialized, FIELD_STATS_TS_QUALITY, &jts);
+  if (jts_exists) {
+    stats.SetTsQuality(ParseTsQualityJson(jts));
+  }
+
+  json_object* jshm = nullptr;
+  json_bool jshm_exists = json_object_object_get_ex(serialized, FIELD_STATS_SHM_FANOUT, &jshm);
+  if (jshm_exists) {
+    stats.SetShmFanout(ParseShmFanoutJson(jshm));
+  }
+
+  json_object* jdropped = nullptr;
+  json_bool jdropped_exists = json_object_object_get_ex(serialized, FIELD_STATS_DROPPED, &jdropped);
+  if (jdropped_exists) {
+    stats.SetDropped(json_object_get_int64(jdropped));
+  }
+
   *this = ChannelStatsInfo(stats);
   return common::Error();
 }
@@ -0,0 +1,144 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_commands_info/profile_info.h"
+
+#define PROFILE_ID_FIELD "id"
+#define PROFILE_ELEMENTS_FIELD "elements"
+
+#define PROFILE_ELEMENT_NAME_FIELD "name"
+#define PROFILE_ELEMENT_FACTORY_FIELD "factory"
+#define PROFILE_ELEMENT_SAMPLES_FIELD "samples"
+
+#define PROFILE_SAMPLE_TIMESTAMP_FIELD "timestamp"
+#define PROFILE_SAMPLE_BUFFERS_FIELD "buffers"
+#define PROFILE_SAMPLE_BYTES_FIELD "bytes"
+#define PROFILE_SAMPLE_BUSY_FIELD "busy_ns"
+#define PROFILE_SAMPLE_MAX_FIELD "max_ns"
+#define PROFILE_SAMPLE_QUEUE_BUFFERS_FIELD "queue_buffers"
+#define PROFILE_SAMPLE_QUEUE_TIME_FIELD "queue_ns"
+
+namespace {
+
+int64_t GetInt64Field(json_object* obj, const char* field) {
+  json_object* jfield = nullptr;
+  json_bool jfield_exists = json_object_object_get_ex(obj, field, &jfield);
+  if (!jfield_exists) {
+    return 0;
+  }
+  return json_object_get_int64(jfield);
+}
+
+std::string GetStringField(json_object* obj, const char* field) {
+  json_object* jfield = nullptr;
+  json_bool jfield_exists = json_object_object_get_ex(obj, field, &jfield);
+  if (!jfield_exists) {
+    return std::string();
+  }
+  return json_object_get_string(jfield);
+}
+
+}  // namespace
+
+namespace iptv_cloud {
+
+ProfileSample::ProfileSample()
+    : timestamp(0), buffers(0), bytes(0), busy_nsec(0), max_nsec(0), queue_buffers(0), queue_nsec(0) {}
+
+ProfileInfo::ProfileInfo() : base_class(), id_(), elements_() {}
+
+ProfileInfo::ProfileInfo(stream_id_t sid, const elements_t& elements) : base_class(), id_(sid), elements_(elements) {}
+
+stream_id_t ProfileInfo::GetStreamID() const {
+  return id_;
+}
+
+ProfileInfo::elements_t ProfileInfo::GetElements() const {
+  return elements_;
+}
+
+common::Error ProfileInfo::SerializeFields(json_object* out) const {
+  json_object* jelements = json_object_new_array();
+  for (const ElementProfile& element : elements_) {
+    json_object* jsamples = json_object_new_array();
+    for (const ProfileSample& sample : element.samples) {
+      json_object* jsample = json_object_new_object();
+      json_object_object_add(jsample, PROFILE_SAMPLE_TIMESTAMP_FIELD, json_object_new_int64(sample.timestamp));
+      json_object_object_add(jsample, PROFILE_SAMPLE_BUFFERS_FIELD, json_object_new_int64(sample.buffers));
+      json_object_object_add(jsample, PROFILE_SAMPLE_BYTES_FIELD, json_object_new_int64(sample.bytes));
+      json_object_object_add(jsample, PROFILE_SAMPLE_BUSY_FIELD, json_object_new_int64(sample.busy_nsec));
+      json_object_object_add(jsample, PROFILE_SAMPLE_MAX_FIELD, json_object_new_int64(sample.max_nsec));
+      json_object_object_add(jsample, PROFILE_SAMPLE_QUEUE_BUFFERS_FIELD, json_object_new_int64(sample.queue_buffers));
+      json_object_object_add(jsample, PROFILE_SAMPLE_QUEUE_TIME_FIELD, json_object_new_int64(sample.queue_nsec));
+      json_object_array_add(jsamples, jsample);
+    }
+
+    json_object* jelement = json_object_new_object();
+    json_object_object_add(jelement, PROFILE_ELEMENT_NAME_FIELD, json_object_new_string(element.name.c_str()));
+    json_object_object_add(jelement, PROFILE_ELEMENT_FACTORY_FIELD, json_object_new_string(element.factory.c_str()));
+    json_object_object_add(jelement, PROFILE_ELEMENT_SAMPLES_FIELD, jsamples);
+    json_object_array_add(jelements, jelement);
+  }
+
+  json_object_object_add(out, PROFILE_ID_FIELD, json_object_new_string(id_.c_str()));
+  json_object_object_add(out, PROFILE_ELEMENTS_FIELD, jelements);
+  return common::Error();
+}
+
+common::Error ProfileInfo::DoDeSerialize(json_object* serialized) {
+  json_object* jid = nullptr;
+  json_bool jid_exists = json_object_object_get_ex(serialized, PROFILE_ID_FIELD, &jid);
+  if (!jid_exists) {
+    return common::make_error_inval();
+  }
+
+  ProfileInfo inf;
+  inf.id_ = json_object_get_string(jid);
+
+  json_object* jelements = nullptr;
+  json_bool jelements_exists = json_object_object_get_ex(serialized, PROFILE_ELEMENTS_FIELD, &jelements);
+  if (jelements_exists) {
+    const size_t len = json_object_array_length(jelements);
+    for (size_t i = 0; i < len; ++i) {
+      json_object* jelement = json_object_array_get_idx(jelements, i);
+      ElementProfile element;
+      element.name = GetStringField(jelement, PROFILE_ELEMENT_NAME_FIELD);
+      element.factory = GetStringField(jelement, PROFILE_ELEMENT_FACTORY_FIELD);
+
+      json_object* jsamples = nullptr;
+      json_bool jsamples_exists = json_object_object_get_ex(jelement, PROFILE_ELEMENT_SAMPLES_FIELD, &jsamples);
+      if (jsamples_exists) {
+        const size_t samples_len = json_object_array_length(jsamples);
+        for (size_t j = 0; j < samples_len; ++j) {
+          json_object* jsample = json_object_array_get_idx(jsamples, j);
+          ProfileSample sample;
+          sample.timestamp = GetInt64Field(jsample, PROFILE_SAMPLE_TIMESTAMP_FIELD);
+          sample.buffers = GetInt64Field(jsample, PROFILE_SAMPLE_BUFFERS_FIELD);
+          sample.bytes = GetInt64Field(jsample, PROFILE_SAMPLE_BYTES_FIELD);
+          sample.busy_nsec = GetInt64Field(jsample, PROFILE_SAMPLE_BUSY_FIELD);
+          sample.max_nsec = GetInt64Field(jsample, PROFILE_SAMPLE_MAX_FIELD);
+          sample.queue_buffers = GetInt64Field(jsample, PROFILE_SAMPLE_QUEUE_BUFFERS_FIELD);
+          sample.queue_nsec = GetInt64Field(jsample, PROFILE_SAMPLE_QUEUE_TIME_FIELD);
+          element.samples.push_back(sample);
+        }
+      }
+      inf.elements_.push_back(element);
+    }
+  }
+
+  *this = inf;
+  return common::Error();
+}
+
+}  // namespace iptv_cloud
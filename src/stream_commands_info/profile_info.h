@@ -0,0 +1,64 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <common/serializer/json_serializer.h>
+
+#include "base/types.h"
+
+namespace iptv_cloud {
+
+struct ProfileSample {  // one main timer period
+  ProfileSample();
+
+  fastotv::timestamp_t timestamp;  // utc msec
+  uint64_t buffers;                // left element
+  uint64_t bytes;
+  uint64_t busy_nsec;              // sum of input to first output times on one thread, 0 for async elements
+  uint64_t max_nsec;               // slowest buffer
+  uint64_t queue_buffers;          // queue elements only
+  uint64_t queue_nsec;
+};
+
+struct ElementProfile {
+  std::string name;
+  std::string factory;
+  std::vector<ProfileSample> samples;  // oldest first
+};
+
+class ProfileInfo : public common::serializer::JsonSerializer<ProfileInfo> {
+ public:
+  typedef JsonSerializer<ProfileInfo> base_class;
+  typedef std::vector<ElementProfile> elements_t;
+
+  ProfileInfo();
+  ProfileInfo(stream_id_t sid, const elements_t& elements);
+
+  stream_id_t GetStreamID() const;
+  elements_t GetElements() const;
+
+ protected:
+  common::Error SerializeFields(json_object* out) const override;
+  common::Error DoDeSerialize(json_object* serialized) override;
+
+ private:
+  stream_id_t id_;
+  elements_t elements_;
+};
+
+}  // namespace iptv_cloud
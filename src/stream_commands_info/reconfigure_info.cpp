@@ -0,0 +1,137 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_commands_info/reconfigure_info.h"
+
+#include <string>
+#include <vector>
+
+#include "base/config_fields.h"
+
+#define RECONFIGURE_INFO_URLS_FIELD "urls"
+#define RECONFIGURE_INFO_ARGS_FIELD "args"
+
+namespace iptv_cloud {
+namespace {
+template <typename T>
+common::Error serialize_urls(const std::vector<T>& urls, json_object** out) {
+  json_object* jurls = json_object_new_array();
+  for (const T& url : urls) {
+    json_object* jurl = nullptr;
+    common::Error err = url.Serialize(&jurl);
+    if (err) {
+      json_object_put(jurls);
+      return err;
+    }
+    json_object_array_add(jurls, jurl);
+  }
+
+  json_object* jobj = json_object_new_object();
+  json_object_object_add(jobj, RECONFIGURE_INFO_URLS_FIELD, jurls);
+  *out = jobj;
+  return common::Error();
+}
+}  // namespace
+
+ReconfigureInfo::ReconfigureInfo() : base_class(), config_() {}
+
+ReconfigureInfo::ReconfigureInfo(const StreamConfig& config) : base_class(), config_(config) {}
+
+StreamConfig ReconfigureInfo::GetConfig() const {
+  return config_;
+}
+
+common::Error ReconfigureInfo::SerializeFields(json_object* out) const {
+  json_object* jinput = nullptr;
+  common::Error err = serialize_urls(config_.input, &jinput);
+  if (err) {
+    return err;
+  }
+
+  json_object* joutput = nullptr;
+  err = serialize_urls(config_.output, &joutput);
+  if (err) {
+    json_object_put(jinput);
+    return err;
+  }
+
+  json_object* jargs = json_object_new_object();
+  for (auto it = config_.args.begin(); it != config_.args.end(); ++it) {
+    json_object_object_add(jargs, it->first.c_str(), json_object_new_string(it->second.c_str()));
+  }
+
+  json_object_object_add(out, ID_FIELD, json_object_new_string(config_.id.c_str()));
+  json_object_object_add(out, TYPE_FIELD, json_object_new_int(config_.type));
+  json_object_object_add(out, FEEDBACK_DIR_FIELD, json_object_new_string(config_.feedback_dir.c_str()));
+  json_object_object_add(out, LOG_LEVEL_FIELD, json_object_new_int(config_.log_level));
+  json_object_object_add(out, INPUT_FIELD, jinput);
+  json_object_object_add(out, OUTPUT_FIELD, joutput);
+  json_object_object_add(out, RECONFIGURE_INFO_ARGS_FIELD, jargs);
+  return common::Error();
+}
+
+common::Error ReconfigureInfo::DoDeSerialize(json_object* serialized) {
+  json_object* jid = nullptr;
+  json_bool jid_exists = json_object_object_get_ex(serialized, ID_FIELD, &jid);
+  if (!jid_exists) {
+    return common::make_error_inval();
+  }
+
+  json_object* jtype = nullptr;
+  json_bool jtype_exists = json_object_object_get_ex(serialized, TYPE_FIELD, &jtype);
+  if (!jtype_exists) {
+    return common::make_error_inval();
+  }
+
+  ReconfigureInfo inf;
+  inf.config_.id = json_object_get_string(jid);
+  inf.config_.type = static_cast<StreamType>(json_object_get_int(jtype));
+
+  json_object* jfeedback_dir = nullptr;
+  json_bool jfeedback_dir_exists = json_object_object_get_ex(serialized, FEEDBACK_DIR_FIELD, &jfeedback_dir);
+  if (jfeedback_dir_exists) {
+    inf.config_.feedback_dir = json_object_get_string(jfeedback_dir);
+  }
+
+  json_object* jlog_level = nullptr;
+  json_bool jlog_level_exists = json_object_object_get_ex(serialized, LOG_LEVEL_FIELD, &jlog_level);
+  if (jlog_level_exists) {
+    inf.config_.log_level = json_object_get_int(jlog_level);
+  }
+
+  json_object* jinput = nullptr;
+  json_bool jinput_exists = json_object_object_get_ex(serialized, INPUT_FIELD, &jinput);
+  if (!jinput_exists || !read_input(jinput, &inf.config_.input)) {
+    return common::make_error_inval();
+  }
+
+  json_object* joutput = nullptr;
+  json_bool joutput_exists = json_object_object_get_ex(serialized, OUTPUT_FIELD, &joutput);
+  if (joutput_exists) {
+    read_output(joutput, &inf.config_.output);
+  }
+
+  json_object* jargs = nullptr;
+  json_bool jargs_exists = json_object_object_get_ex(serialized, RECONFIGURE_INFO_ARGS_FIELD, &jargs);
+  if (jargs_exists) {
+    json_object_object_foreach(jargs, key, val) {
+      inf.config_.args[key] = json_object_get_string(val);
+    }
+  }
+
+  *this = inf;
+  return common::Error();
+}
+
+}  // namespace iptv_cloud
@@ -0,0 +1,73 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "stream_commands_info/restart_schedule_info.h"
+
+#define RESTART_SCHEDULE_ID_FIELD "id"
+#define RESTART_SCHEDULE_UPSTREAM_HOST_FIELD "upstream_host"
+#define RESTART_SCHEDULE_ATTEMPTS_FIELD "attempts"
+
+namespace iptv_cloud {
+
+RestartScheduleInfo::RestartScheduleInfo() : base_class(), id_(), upstream_host_(), attempts_(0) {}
+
+RestartScheduleInfo::RestartScheduleInfo(stream_id_t sid, const std::string& upstream_host, size_t attempts)
+    : base_class(), id_(sid), upstream_host_(upstream_host), attempts_(attempts) {}
+
+stream_id_t RestartScheduleInfo::GetStreamID() const {
+  return id_;
+}
+
+std::string RestartScheduleInfo::GetUpstreamHost() const {
+  return upstream_host_;
+}
+
+size_t RestartScheduleInfo::GetAttempts() const {
+  return attempts_;
+}
+
+common::Error RestartScheduleInfo::SerializeFields(json_object* out) const {
+  json_object_object_add(out, RESTART_SCHEDULE_ID_FIELD, json_object_new_string(id_.c_str()));
+  json_object_object_add(out, RESTART_SCHEDULE_UPSTREAM_HOST_FIELD, json_object_new_string(upstream_host_.c_str()));
+  json_object_object_add(out, RESTART_SCHEDULE_ATTEMPTS_FIELD, json_object_new_int64(attempts_));
+  return common::Error();
+}
+
+common::Error RestartScheduleInfo::DoDeSerialize(json_object* serialized) {
+  json_object* jid = nullptr;
+  json_bool jid_exists = json_object_object_get_ex(serialized, RESTART_SCHEDULE_ID_FIELD, &jid);
+  if (!jid_exists) {
+    return common::make_error_inval();
+  }
+
+  RestartScheduleInfo inf;
+  inf.id_ = json_object_get_string(jid);
+
+  json_object* jhost = nullptr;
+  json_bool jhost_exists = json_object_object_get_ex(serialized, RESTART_SCHEDULE_UPSTREAM_HOST_FIELD, &jhost);
+  if (jhost_exists) {
+    inf.upstream_host_ = json_object_get_string(jhost);
+  }
+
+  json_object* jattempts = nullptr;
+  json_bool jattempts_exists = json_object_object_get_ex(serialized, RESTART_SCHEDULE_ATTEMPTS_FIELD, &jattempts);
+  if (jattempts_exists) {
+    inf.attempts_ = json_object_get_int64(jattempts);
+  }
+
+  *this = inf;
+  return common::Error();
+}
+
+}  // namespace iptv_cloud
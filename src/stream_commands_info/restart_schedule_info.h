@@ -0,0 +1,45 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <string>
+
+#include <common/serializer/json_serializer.h>
+
+#include "base/types.h"
+
+namespace iptv_cloud {
+
+class RestartScheduleInfo : public common::serializer::JsonSerializer<RestartScheduleInfo> {
+ public:
+  typedef JsonSerializer<RestartScheduleInfo> base_class;
+  RestartScheduleInfo();
+  explicit RestartScheduleInfo(stream_id_t sid, const std::string& upstream_host, size_t attempts);
+
+  stream_id_t GetStreamID() const;
+  std::string GetUpstreamHost() const;
+  size_t GetAttempts() const;
+
+ protected:
+  common::Error DoDeSerialize(json_object* serialized) override;
+  common::Error SerializeFields(json_object* out) const override;
+
+ private:
+  stream_id_t id_;
+  std::string upstream_host_;
+  size_t attempts_;
+};
+
+}  // namespace iptv_cloud
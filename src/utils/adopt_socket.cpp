@@ -0,0 +1,320 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utils/adopt_socket.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace iptv_cloud {
+namespace utils {
+
+namespace {
+const char kAccepted = 1;
+const char kRejected = 0;
+const time_t kReceiveTimeoutSec = 1;
+const time_t kReplyTimeoutSec = 3;  // service polls listener once per second
+
+bool MakeAddress(const std::string& path, struct sockaddr_un* addr) {
+  if (path.empty() || path.size() >= sizeof(addr->sun_path)) {
+    return false;
+  }
+
+  memset(addr, 0, sizeof(struct sockaddr_un));
+  addr->sun_family = AF_UNIX;
+  memcpy(addr->sun_path, path.data(), path.size());
+  return true;
+}
+
+void SetTimeouts(int fd, time_t sec) {
+  struct timeval tv = {sec, 0};
+  setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+  setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+void CloseDescriptor(int* fd) {
+  if (*fd != INVALID_DESCRIPTOR) {
+    close(*fd);
+    *fd = INVALID_DESCRIPTOR;
+  }
+}
+
+common::ErrnoError ReceiveHello(int fd, std::string* hello, int* read_fd, int* write_fd) {
+  std::vector<char> buffer(AdoptListener::MAX_HELLO_SIZE);
+  struct iovec iov = {buffer.data(), buffer.size()};
+  union {
+    char buf[CMSG_SPACE(sizeof(int) * 2)];
+    struct cmsghdr align;
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  ssize_t nread = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+  if (nread < 0) {
+    return common::make_errno_error(errno);
+  }
+
+  int fds[2] = {INVALID_DESCRIPTOR, INVALID_DESCRIPTOR};
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  if (cmsg && cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+    const size_t count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+    memcpy(fds, CMSG_DATA(cmsg), std::min<size_t>(count, 2) * sizeof(int));
+    if (count != 2) {
+      CloseDescriptor(&fds[0]);
+      CloseDescriptor(&fds[1]);
+      return common::make_errno_error("Adopt request without pipes.", EINVAL);
+    }
+  }
+
+  if (fds[0] == INVALID_DESCRIPTOR || fds[1] == INVALID_DESCRIPTOR || nread == 0 ||
+      (msg.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+    CloseDescriptor(&fds[0]);
+    CloseDescriptor(&fds[1]);
+    return common::make_errno_error("Invalid adopt request.", EINVAL);
+  }
+
+  hello->assign(buffer.data(), nread);
+  *read_fd = fds[0];
+  *write_fd = fds[1];
+  return common::ErrnoError();
+}
+}  // namespace
+
+AdoptRequest::AdoptRequest()
+    : pid(0),
+      uid(0),
+      hello(),
+      read_fd(INVALID_DESCRIPTOR),
+      write_fd(INVALID_DESCRIPTOR),
+      connection(INVALID_DESCRIPTOR) {}
+
+AdoptListener::AdoptListener(const std::string& path) : path_(path), fd_(INVALID_DESCRIPTOR) {}
+
+AdoptListener::~AdoptListener() {
+  Close();
+}
+
+common::ErrnoError AdoptListener::Listen() {
+  if (IsListening()) {
+    return common::make_errno_error("Adopt socket already listening.", EINVAL);
+  }
+
+  struct sockaddr_un addr;
+  if (!MakeAddress(path_, &addr)) {
+    return common::make_errno_error_inval();
+  }
+
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  unlink(path_.c_str());
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1 ||
+      chmod(path_.c_str(), S_IRUSR | S_IWUSR) == -1 || listen(fd, SOMAXCONN) == -1) {
+    const int err = errno;
+    close(fd);
+    unlink(path_.c_str());
+    return common::make_errno_error(err);
+  }
+
+  fd_ = fd;
+  return common::ErrnoError();
+}
+
+void AdoptListener::Close() {
+  if (!IsListening()) {
+    return;
+  }
+
+  close(fd_);
+  fd_ = INVALID_DESCRIPTOR;
+  unlink(path_.c_str());
+}
+
+bool AdoptListener::IsListening() const {
+  return fd_ != INVALID_DESCRIPTOR;
+}
+
+common::ErrnoError AdoptListener::Accept(AdoptRequest* request) {
+  if (!request || !IsListening()) {
+    return common::make_errno_error_inval();
+  }
+
+  int connection = accept4(fd_, nullptr, nullptr, SOCK_CLOEXEC);
+  if (connection == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  struct ucred cred;
+  socklen_t cred_len = sizeof(cred);
+  if (getsockopt(connection, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) == -1) {
+    const int err = errno;
+    close(connection);
+    return common::make_errno_error(err);
+  }
+
+  // child sends request right after connect, stalled one can't hold service loop longer
+  SetTimeouts(connection, kReceiveTimeoutSec);
+  AdoptRequest lrequest;
+  common::ErrnoError err = ReceiveHello(connection, &lrequest.hello, &lrequest.read_fd, &lrequest.write_fd);
+  if (err) {
+    close(connection);
+    return err;
+  }
+
+  lrequest.pid = cred.pid;
+  lrequest.uid = cred.uid;
+  lrequest.connection = connection;
+  *request = lrequest;
+  return common::ErrnoError();
+}
+
+void AdoptListener::Reply(AdoptRequest* request, bool accepted) {
+  if (!request) {
+    return;
+  }
+
+  if (request->connection != INVALID_DESCRIPTOR) {
+    const char reply = accepted ? kAccepted : kRejected;
+    ssize_t nwrite = send(request->connection, &reply, sizeof(reply), MSG_NOSIGNAL);
+    UNUSED(nwrite);
+    CloseDescriptor(&request->connection);
+  }
+
+  if (!accepted) {
+    CloseDescriptor(&request->read_fd);
+    CloseDescriptor(&request->write_fd);
+  }
+}
+
+common::ErrnoError SendAdoptRequest(const std::string& path,
+                                    const std::string& hello,
+                                    int read_fd,
+                                    int write_fd,
+                                    pid_t* service_pid) {
+  struct sockaddr_un addr;
+  if (!MakeAddress(path, &addr) || hello.empty() || hello.size() > AdoptListener::MAX_HELLO_SIZE ||
+      read_fd == INVALID_DESCRIPTOR || write_fd == INVALID_DESCRIPTOR || !service_pid) {
+    return common::make_errno_error_inval();
+  }
+
+  int fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  SetTimeouts(fd, kReplyTimeoutSec);
+  if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) == -1) {
+    const int err = errno;
+    close(fd);
+    return common::make_errno_error(err);
+  }
+
+  struct ucred cred;
+  socklen_t cred_len = sizeof(cred);
+  if (getsockopt(fd, SOL_SOCKET, SO_PEERCRED, &cred, &cred_len) == -1) {
+    const int err = errno;
+    close(fd);
+    return common::make_errno_error(err);
+  }
+
+  struct iovec iov = {const_cast<char*>(hello.data()), hello.size()};
+  union {
+    char buf[CMSG_SPACE(sizeof(int) * 2)];
+    struct cmsghdr align;
+  } control;
+  memset(&control, 0, sizeof(control));
+
+  struct msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control.buf;
+  msg.msg_controllen = sizeof(control.buf);
+
+  struct cmsghdr* cmsg = CMSG_FIRSTHDR(&msg);
+  cmsg->cmsg_level = SOL_SOCKET;
+  cmsg->cmsg_type = SCM_RIGHTS;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(int) * 2);
+  const int fds[2] = {read_fd, write_fd};
+  memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+
+  if (sendmsg(fd, &msg, MSG_NOSIGNAL) == -1) {
+    const int err = errno;
+    close(fd);
+    return common::make_errno_error(err);
+  }
+
+  char reply = kRejected;
+  ssize_t nread = recv(fd, &reply, sizeof(reply), 0);
+  const int err = errno;
+  close(fd);
+  if (nread < 0) {
+    return common::make_errno_error(err);
+  }
+
+  if (nread == 0 || reply != kAccepted) {
+    return common::make_errno_error("Adopt request rejected by service.", EPERM);
+  }
+
+  *service_pid = cred.pid;
+  return common::ErrnoError();
+}
+
+void CloseInheritedDescriptors(const std::vector<int>& keep) {
+  std::vector<int> fds;
+  DIR* dir = opendir("/proc/self/fd");
+  if (dir) {
+    const int dir_fd = dirfd(dir);
+    struct dirent* entry = nullptr;
+    while ((entry = readdir(dir)) != nullptr) {
+      char* end = nullptr;
+      const long fd = strtol(entry->d_name, &end, 10);
+      if (end != entry->d_name && *end == 0 && fd != dir_fd) {
+        fds.push_back(static_cast<int>(fd));
+      }
+    }
+    closedir(dir);
+  } else {  // no procfs
+    const long max_fd = sysconf(_SC_OPEN_MAX);
+    for (long fd = 0; fd < max_fd; ++fd) {
+      fds.push_back(static_cast<int>(fd));
+    }
+  }
+
+  for (int fd : fds) {
+    if (fd > STDERR_FILENO && std::find(keep.begin(), keep.end(), fd) == keep.end()) {
+      close(fd);
+    }
+  }
+}
+
+}  // namespace utils
+}  // namespace iptv_cloud
@@ -0,0 +1,79 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <string>
+#include <vector>
+
+#include <common/error.h>
+#include <common/macros.h>
+
+namespace iptv_cloud {
+namespace utils {
+
+// Stream children outlive the service process: when its pipes are lost a child creates new ones and
+// passes the service ends to the next service instance over unix seqpacket socket together with its
+// statistic, the service answers with one byte. Both sides wait for each other at most WAIT_SECONDS.
+struct AdoptRequest {
+  AdoptRequest();
+
+  pid_t pid;  // of connected process, from kernel credentials
+  uid_t uid;
+  std::string hello;
+  int read_fd;     // service reads responces of child
+  int write_fd;    // service writes commands to child
+  int connection;  // until reply
+};
+
+class AdoptListener {
+ public:
+  enum : uint32_t { WAIT_SECONDS = 60, MAX_HELLO_SIZE = 64 * 1024 };
+
+  explicit AdoptListener(const std::string& path);
+  ~AdoptListener();
+
+  // non blocking, previous socket with the same path is replaced
+  common::ErrnoError Listen() WARN_UNUSED_RESULT;
+  // unlinks socket
+  void Close();
+  bool IsListening() const;
+
+  // EAGAIN if nobody waits, every accepted request must be replied
+  common::ErrnoError Accept(AdoptRequest* request) WARN_UNUSED_RESULT;
+  // rejected request descriptors are closed, accepted ones belong to caller
+  static void Reply(AdoptRequest* request, bool accepted);
+
+ private:
+  const std::string path_;
+  int fd_;
+
+  DISALLOW_COPY_AND_ASSIGN(AdoptListener);
+};
+
+// child side, blocking, EPERM if service rejected request; descriptors stay owned by caller
+common::ErrnoError SendAdoptRequest(const std::string& path,
+                                    const std::string& hello,
+                                    int read_fd,
+                                    int write_fd,
+                                    pid_t* service_pid) WARN_UNUSED_RESULT;
+
+// forked child outlives the service, it must not hold listening sockets and other descriptors of service:
+// closes all descriptors except standard streams and keep
+void CloseInheritedDescriptors(const std::vector<int>& keep);
+
+}  // namespace utils
+}  // namespace iptv_cloud
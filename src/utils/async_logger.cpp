@@ -0,0 +1,450 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utils/async_logger.h"
+
+#include <ctype.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdio.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+
+#include <common/time.h>
+
+namespace iptv_cloud {
+namespace utils {
+
+namespace {
+
+// lines of one thread are collected here until new line
+thread_local std::string g_line;
+
+size_t RoundUpPowerOfTwo(size_t value) {
+  size_t result = 2;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+// records differing only in leading time stamp are repeats
+const char* SkipTimeStamp(const char* data, const char* end) {
+  while (data != end && (isdigit(*data) || strchr(" :-./[]", *data))) {
+    data++;
+  }
+  return data;
+}
+
+}  // namespace
+
+class AsyncLogger::StreamBuf : public std::streambuf {
+ public:
+  explicit StreamBuf(AsyncLogger* logger) : logger_(logger) { g_line.clear(); }
+
+ protected:
+  int_type overflow(int_type c) override {
+    if (c != traits_type::eof()) {
+      g_line.push_back(static_cast<char>(c));
+      if (c == '\n') {
+        Commit();
+      }
+    }
+    return traits_type::not_eof(c);
+  }
+
+  std::streamsize xsputn(const char* s, std::streamsize n) override {
+    g_line.append(s, n);
+    if (g_line.find('\n') != std::string::npos) {
+      Commit();
+    }
+    return n;
+  }
+
+  int sync() override {
+    if (!g_line.empty()) {
+      g_line.push_back('\n');
+      Commit();
+    }
+    return 0;
+  }
+
+ private:
+  void Commit() {
+    size_t start = 0;
+    size_t end = g_line.find('\n');
+    while (end != std::string::npos) {
+      logger_->Push(g_line.data() + start, end - start + 1);
+      start = end + 1;
+      end = g_line.find('\n', start);
+    }
+    g_line.erase(0, start);
+  }
+
+  AsyncLogger* const logger_;
+};
+
+AsyncLogger::AsyncLogger(const std::string& path, size_t max_file_size, size_t records_count)
+    : path_(path),
+      max_file_size_(max_file_size),
+      fd_(INVALID_DESCRIPTOR),
+      file_size_(0),
+      event_fd_(INVALID_DESCRIPTOR),
+      slots_(nullptr),
+      mask_(RoundUpPowerOfTwo(records_count) - 1),
+      enqueue_pos_(0),
+      dequeue_pos_(0),
+      running_(false),
+      writer_waiting_(false),
+      writer_(),
+      iov_(),
+      batch_slots_(),
+      notes_(WRITE_BATCH + 1),
+      notes_count_(0),
+      last_key_(),
+      last_time_(0),
+      repeats_(0),
+      long_line_(false),
+      written_(0),
+      suppressed_(0),
+      dropped_(0),
+      dropped_unreported_(0),
+      stream_buf_(nullptr),
+      prev_cout_(nullptr),
+      prev_cerr_(nullptr) {
+  slots_ = new Slot[mask_ + 1];
+  for (size_t i = 0; i <= mask_; ++i) {
+    slots_[i].sequence.store(i, std::memory_order_relaxed);
+    slots_[i].size = 0;
+    slots_[i].continued = false;
+  }
+  iov_.reserve(notes_.size() * 2 + 1);
+  batch_slots_.reserve(WRITE_BATCH);
+  for (std::string& note : notes_) {
+    note.reserve(96);
+  }
+  last_key_.reserve(RECORD_SIZE);
+}
+
+AsyncLogger::~AsyncLogger() {
+  Stop();
+  delete[] slots_;
+}
+
+common::ErrnoError AsyncLogger::Start() {
+  if (running_) {
+    return common::make_errno_error("Async logger already started.", EINVAL);
+  }
+
+  int fd = open(path_.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  int event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (event_fd == INVALID_DESCRIPTOR) {
+    common::ErrnoError err = common::make_errno_error(errno);
+    ::close(fd);
+    return err;
+  }
+
+  off_t size = lseek(fd, 0, SEEK_END);
+  fd_ = fd;
+  event_fd_ = event_fd;
+  file_size_ = size < 0 ? 0 : size;
+  running_ = true;
+  writer_ = std::thread(&AsyncLogger::WriteLoop, this);
+  return common::ErrnoError();
+}
+
+void AsyncLogger::AttachStreams() {
+  if (stream_buf_) {
+    return;
+  }
+
+  stream_buf_ = new StreamBuf(this);
+  prev_cout_ = std::cout.rdbuf(stream_buf_);
+  prev_cerr_ = std::cerr.rdbuf(stream_buf_);
+}
+
+void AsyncLogger::Stop() {
+  if (stream_buf_) {
+    std::cout.rdbuf(prev_cout_);
+    std::cerr.rdbuf(prev_cerr_);
+    delete stream_buf_;
+    stream_buf_ = nullptr;
+  }
+
+  if (!running_) {
+    return;
+  }
+
+  running_ = false;
+  Wakeup();
+  writer_.join();
+  ::close(fd_);
+  fd_ = INVALID_DESCRIPTOR;
+  ::close(event_fd_);
+  event_fd_ = INVALID_DESCRIPTOR;
+}
+
+bool AsyncLogger::Push(const char* data, size_t size) {
+  static const char truncated[] = "...\n";
+  const size_t max_records = std::min(static_cast<size_t>(MAX_LINE_RECORDS), mask_ + 1);
+  size_t count = std::max((size + RECORD_SIZE - 1) / RECORD_SIZE, static_cast<size_t>(1));
+  const bool cut = count > max_records;
+  if (cut) {
+    count = max_records;
+    size = count * RECORD_SIZE;
+  }
+
+  // all records of line are claimed at once, so lines of other threads never get between them
+  size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+  while (true) {
+    intptr_t diff = 0;
+    for (size_t i = 0; i < count && diff == 0; ++i) {
+      const size_t seq = slots_[(pos + i) & mask_].sequence.load(std::memory_order_acquire);
+      diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + i);
+    }
+
+    if (diff == 0) {
+      if (enqueue_pos_.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed)) {
+        break;
+      }
+    } else if (diff < 0) {  // writer is behind, never wait for it
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      dropped_unreported_.fetch_add(1, std::memory_order_relaxed);
+      return false;
+    } else {
+      pos = enqueue_pos_.load(std::memory_order_relaxed);
+    }
+  }
+
+  for (size_t i = 0; i < count; ++i) {
+    Slot* slot = &slots_[(pos + i) & mask_];
+    const size_t offset = i * RECORD_SIZE;
+    const size_t part = std::min(size - offset, static_cast<size_t>(RECORD_SIZE));
+    memcpy(slot->data, data + offset, part);
+    if (cut && i + 1 == count) {
+      memcpy(slot->data + RECORD_SIZE - sizeof(truncated) + 1, truncated, sizeof(truncated) - 1);
+    }
+    slot->size = static_cast<uint32_t>(part);
+    slot->continued = i + 1 != count;
+    slot->sequence.store(pos + i + 1, std::memory_order_release);
+  }
+
+  std::atomic_thread_fence(std::memory_order_seq_cst);  // pairs with WaitRecords
+  if (writer_waiting_.load(std::memory_order_relaxed)) {
+    Wakeup();
+  }
+  return true;
+}
+
+AsyncLogger::Stats AsyncLogger::GetStats() const {
+  Stats stats;
+  stats.written = written_.load(std::memory_order_relaxed);
+  stats.suppressed = suppressed_.load(std::memory_order_relaxed);
+  stats.dropped = dropped_.load(std::memory_order_relaxed);
+  return stats;
+}
+
+void AsyncLogger::WriteLoop() {
+  while (true) {
+    const bool running = running_.load(std::memory_order_acquire);
+    const size_t drained = DrainBatch();
+    if (drained == WRITE_BATCH) {
+      continue;
+    }
+
+    if (!running && drained == 0) {
+      break;
+    }
+
+    if (drained == 0) {
+      WaitRecords();
+    }
+  }
+
+  FlushRepeats();
+  WriteBatch();
+}
+
+void AsyncLogger::WaitRecords() {
+  writer_waiting_.store(true, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  const Slot& slot = slots_[dequeue_pos_ & mask_];
+  const bool ready = slot.sequence.load(std::memory_order_acquire) == dequeue_pos_ + 1;
+  if (!ready && running_.load(std::memory_order_acquire)) {
+    struct pollfd event = {event_fd_, POLLIN, 0};
+    poll(&event, 1, repeats_ ? static_cast<int>(suppress_window_msec) : -1);
+  }
+  writer_waiting_.store(false, std::memory_order_relaxed);
+
+  uint64_t value;
+  ssize_t res = read(event_fd_, &value, sizeof(value));
+  UNUSED(res);
+}
+
+void AsyncLogger::Wakeup() {
+  const uint64_t value = 1;
+  ssize_t res = write(event_fd_, &value, sizeof(value));
+  UNUSED(res);
+}
+
+size_t AsyncLogger::DrainBatch() {
+  const int64_t now = common::time::current_mstime();
+  const uint64_t dropped = dropped_unreported_.exchange(0, std::memory_order_relaxed);
+  if (dropped) {
+    AddNote("async logger: %llu records dropped\n", dropped);
+  }
+
+  size_t drained = 0;
+  while (drained < WRITE_BATCH) {
+    Slot* slot = &slots_[dequeue_pos_ & mask_];
+    const size_t seq = slot->sequence.load(std::memory_order_acquire);
+    if (seq != dequeue_pos_ + 1) {
+      break;
+    }
+
+    bool accepted = true;
+    if (slot->continued || long_line_) {
+      if (!long_line_) {  // first part
+        FlushRepeats();
+        last_key_.clear();
+      }
+      long_line_ = slot->continued;
+    } else {
+      accepted = AcceptRecord(*slot, now);
+    }
+
+    if (accepted) {
+      struct iovec vec = {slot->data, slot->size};
+      iov_.push_back(vec);
+      batch_slots_.push_back(dequeue_pos_);
+    } else {
+      slot->sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+    }
+    dequeue_pos_++;
+    drained++;
+  }
+
+  if (drained == 0 && repeats_ && now - last_time_ >= suppress_window_msec) {
+    FlushRepeats();
+  }
+
+  WriteBatch();
+  return drained;
+}
+
+bool AsyncLogger::AcceptRecord(const Slot& slot, int64_t now) {
+  const char* end = slot.data + slot.size;
+  const char* key = SkipTimeStamp(slot.data, end);
+  const size_t key_size = end - key;
+  const bool same = last_key_.size() == key_size && memcmp(last_key_.data(), key, key_size) == 0;
+  if (same && now - last_time_ < suppress_window_msec) {
+    repeats_++;
+    suppressed_.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  FlushRepeats();
+  if (!same) {
+    last_key_.assign(key, key_size);
+  }
+  last_time_ = now;
+  return true;
+}
+
+void AsyncLogger::AddNote(const char* fmt, uint64_t value) {
+  if (notes_count_ == notes_.size()) {
+    WriteBatch();
+  }
+
+  char buff[96];
+  int len = snprintf(buff, sizeof(buff), fmt, static_cast<unsigned long long>(value));
+  if (len <= 0) {
+    return;
+  }
+
+  std::string* note = &notes_[notes_count_++];
+  note->assign(buff, std::min(static_cast<size_t>(len), sizeof(buff) - 1));
+  struct iovec vec = {const_cast<char*>(note->data()), note->size()};
+  iov_.push_back(vec);
+}
+
+void AsyncLogger::FlushRepeats() {
+  if (!repeats_) {
+    return;
+  }
+
+  AddNote("last message repeated %llu times\n", repeats_);
+  repeats_ = 0;
+}
+
+void AsyncLogger::WriteBatch() {
+  if (iov_.empty()) {
+    return;
+  }
+
+  size_t total = 0;
+  for (const struct iovec& vec : iov_) {
+    total += vec.iov_len;
+  }
+
+  if (max_file_size_ && file_size_ + total > max_file_size_) {
+    if (ftruncate(fd_, 0) == 0) {
+      file_size_ = 0;
+    }
+  }
+
+  size_t offset = 0;
+  while (offset < iov_.size()) {
+    const int count = static_cast<int>(std::min(iov_.size() - offset, static_cast<size_t>(IOV_MAX)));
+    ssize_t res = writev(fd_, iov_.data() + offset, count);
+    if (res < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;  // nothing to report to, log file is the report
+    }
+    file_size_ += res;
+    // skip fully written vectors, finish partial one
+    size_t left = res;
+    while (offset < iov_.size() && left >= iov_[offset].iov_len) {
+      left -= iov_[offset].iov_len;
+      offset++;
+    }
+    if (left) {
+      iov_[offset].iov_base = static_cast<char*>(iov_[offset].iov_base) + left;
+      iov_[offset].iov_len -= left;
+    }
+  }
+
+  for (size_t pos : batch_slots_) {
+    slots_[pos & mask_].sequence.store(pos + mask_ + 1, std::memory_order_release);
+  }
+  written_.fetch_add(batch_slots_.size(), std::memory_order_relaxed);
+  batch_slots_.clear();
+  iov_.clear();
+  notes_count_ = 0;
+}
+
+}  // namespace utils
+}  // namespace iptv_cloud
@@ -0,0 +1,120 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <sys/uio.h>
+
+#include <atomic>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <common/error.h>
+#include <common/macros.h>
+
+namespace iptv_cloud {
+namespace utils {
+
+// asynchronous sink for common::logging output:
+// producers push preformatted lines into a bounded lock-free MPSC ring and never wait,
+// a writer thread drains the ring with batched writev, folds repeated lines and reports dropped ones.
+// Line longer than record spills into consecutive records, up to MAX_LINE_RECORDS of them.
+class AsyncLogger {
+ public:
+  enum : size_t { DEFAULT_RECORDS_COUNT = 2048, RECORD_SIZE = 512, MAX_LINE_RECORDS = 16, WRITE_BATCH = 64 };
+  enum : uint32_t { suppress_window_msec = 1000 };
+
+  struct Stats {
+    uint64_t written;
+    uint64_t suppressed;
+    uint64_t dropped;
+  };
+
+  // records_count is rounded up to power of two, max_file_size 0 means unlimited
+  AsyncLogger(const std::string& path, size_t max_file_size, size_t records_count = DEFAULT_RECORDS_COUNT);
+  ~AsyncLogger();
+
+  common::ErrnoError Start() WARN_UNUSED_RESULT;
+  // route std::cout/std::cerr (console sink of common::logging) into the ring until Stop
+  void AttachStreams();
+  // writes all pushed records and restores streams
+  void Stop();
+
+  // any thread, false if ring is full and record was dropped
+  bool Push(const char* data, size_t size);
+
+  Stats GetStats() const;
+
+ private:
+  class StreamBuf;
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    uint32_t size;
+    bool continued;  // line goes on in next record
+    char data[RECORD_SIZE];
+  };
+
+  void WriteLoop();
+  // sleeps till producer wakes it up, or till end of suppress window if repeats are not reported
+  void WaitRecords();
+  void Wakeup();
+  size_t DrainBatch();
+  // false if record repeats the previous one inside suppress window
+  bool AcceptRecord(const Slot& slot, int64_t now);
+  void AddNote(const char* fmt, uint64_t value);
+  void FlushRepeats();
+  void WriteBatch();
+
+  const std::string path_;
+  const size_t max_file_size_;
+  int fd_;
+  size_t file_size_;
+  int event_fd_;
+
+  Slot* slots_;
+  const size_t mask_;
+  std::atomic<size_t> enqueue_pos_;
+  size_t dequeue_pos_;
+
+  std::atomic<bool> running_;
+  std::atomic<bool> writer_waiting_;
+  std::thread writer_;
+
+  // writer thread state
+  std::vector<struct iovec> iov_;
+  std::vector<size_t> batch_slots_;
+  std::vector<std::string> notes_;
+  size_t notes_count_;
+  std::string last_key_;
+  int64_t last_time_;  // msec
+  uint64_t repeats_;
+  bool long_line_;  // previous record continues, parts of long lines are never folded
+
+  std::atomic<uint64_t> written_;
+  std::atomic<uint64_t> suppressed_;
+  std::atomic<uint64_t> dropped_;
+  std::atomic<uint64_t> dropped_unreported_;
+
+  StreamBuf* stream_buf_;
+  std::streambuf* prev_cout_;
+  std::streambuf* prev_cerr_;
+
+  DISALLOW_COPY_AND_ASSIGN(AsyncLogger);
+};
+
+}  // namespace utils
+}  // namespace iptv_cloud
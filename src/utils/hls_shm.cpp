@@ -0,0 +1,563 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utils/hls_shm.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <vector>
+
+#include <common/sprintf.h>
+
+namespace iptv_cloud {
+namespace utils {
+
+namespace {
+const uint32_t kHlsShmMagic = 0x48534d53;  // HSMS
+const uint32_t kHlsShmVersion = 1;
+const size_t kMaxFiles = 128;
+const size_t kMaxFileName = 64;
+const size_t kMaxReadAttempts = 4;
+const char kShmDirectory[] = "/dev/shm";  // glibc keeps posix shared memory here, segments are renamed in it
+const char kGrowSuffix[] = ".grow";
+
+COMPILE_ASSERT(ATOMIC_LLONG_LOCK_FREE == 2, "Hls shared store needs lock free 64 bit atomics");
+}  // namespace
+
+struct HlsShmFile {
+  std::atomic<uint32_t> sequence;  // seqlock, odd while writer changes the file
+  uint32_t size;
+  uint64_t position;        // of data in ring, monotonic
+  char name[kMaxFileName];  // empty - free slot
+};
+
+struct HlsShmHeader {
+  std::atomic<uint32_t> magic;  // set last by writer
+  uint32_t version;
+  uint64_t capacity;
+  std::atomic<uint64_t> reserve_position;  // end of file being written
+  HlsShmFile files[kMaxFiles];
+
+  char* GetData() { return reinterpret_cast<char*>(this + 1); }
+  const char* GetData() const { return reinterpret_cast<const char*>(this + 1); }
+};
+
+namespace {
+std::string MakeSegmentName(const std::string& name) {
+  return "/" + name;
+}
+
+// new zeroed segment with ring of capacity (power of two), name must not exist
+common::ErrnoError CreateSegment(const std::string& segment,
+                                 size_t capacity,
+                                 int* out_fd,
+                                 HlsShmHeader** out_header,
+                                 size_t* out_mapped_size) {
+  int fd = shm_open(segment.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  const size_t mapped_size = sizeof(HlsShmHeader) + capacity;
+  if (ftruncate(fd, mapped_size) == -1) {
+    const int err = errno;
+    close(fd);
+    shm_unlink(segment.c_str());
+    return common::make_errno_error(err);
+  }
+
+  void* mem = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    const int err = errno;
+    close(fd);
+    shm_unlink(segment.c_str());
+    return common::make_errno_error(err);
+  }
+
+  // ftruncate zeroed segment, atomics are valid as zero and all files are free
+  HlsShmHeader* header = static_cast<HlsShmHeader*>(mem);
+  header->version = kHlsShmVersion;
+  header->capacity = capacity;
+  header->reserve_position.store(0, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic.store(kHlsShmMagic, std::memory_order_release);
+
+  *out_fd = fd;
+  *out_header = header;
+  *out_mapped_size = mapped_size;
+  return common::ErrnoError();
+}
+
+size_t RoundUpPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+void UpdateFile(HlsShmFile* file, const std::string& name, uint64_t position, uint32_t size) {
+  const uint32_t sequence = file->sequence.load(std::memory_order_relaxed);
+  file->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  memset(file->name, 0, sizeof(file->name));
+  memcpy(file->name, name.data(), name.size());
+  file->position = position;
+  file->size = size;
+  file->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+bool IsValidFileName(const std::string& name) {
+  return !name.empty() && name.size() < kMaxFileName && name.find('/') == std::string::npos;
+}
+
+void CopyFromRing(const HlsShmHeader* header, uint64_t position, size_t size, char* out) {
+  const uint64_t capacity = header->capacity;
+  const size_t offset = position & (capacity - 1);
+  const size_t first = std::min<size_t>(size, capacity - offset);
+  const char* ring = header->GetData();
+  memcpy(out, ring + offset, first);
+  if (first < size) {
+    memcpy(out + first, ring, size - first);
+  }
+}
+
+// the same check as readers do when write reaches end_position
+bool IsOverwritten(const HlsShmFile* file, uint64_t capacity, uint64_t end_position) {
+  return file->name[0] && end_position - file->position > capacity;
+}
+}  // namespace
+
+HlsShmStoreWriter::HlsShmStoreWriter(const std::string& name)
+    : name_(name),
+      fd_(INVALID_DESCRIPTOR),
+      header_(nullptr),
+      mapped_size_(0),
+      write_position_(0),
+      max_capacity_(0),
+      eviction_warned_(false) {}
+
+HlsShmStoreWriter::~HlsShmStoreWriter() {
+  Close();
+}
+
+common::ErrnoError HlsShmStoreWriter::Open(size_t capacity, size_t max_capacity) {
+  if (IsOpened()) {
+    return common::make_errno_error("Hls shared store already opened.", EINVAL);
+  }
+
+  if (name_.empty() || name_.find('/') != std::string::npos || !capacity || max_capacity < capacity) {
+    return common::make_errno_error_inval();
+  }
+
+  // readers of replaced segment (previous run of stream) see it as stale and reopen
+  const std::string segment = MakeSegmentName(name_);
+  shm_unlink(segment.c_str());
+  int fd;
+  HlsShmHeader* header;
+  size_t mapped_size;
+  common::ErrnoError err = CreateSegment(segment, RoundUpPowerOfTwo(capacity), &fd, &header, &mapped_size);
+  if (err) {
+    return err;
+  }
+
+  fd_ = fd;
+  header_ = header;
+  mapped_size_ = mapped_size;
+  write_position_ = 0;
+  max_capacity_ = RoundUpPowerOfTwo(max_capacity);
+  return common::ErrnoError();
+}
+
+void HlsShmStoreWriter::Close() {
+  if (!IsOpened()) {
+    return;
+  }
+
+  shm_unlink(MakeSegmentName(name_).c_str());
+  munmap(header_, mapped_size_);
+  close(fd_);
+  fd_ = INVALID_DESCRIPTOR;
+  header_ = nullptr;
+  mapped_size_ = 0;
+}
+
+bool HlsShmStoreWriter::IsOpened() const {
+  return header_ != nullptr;
+}
+
+size_t HlsShmStoreWriter::GetCapacity() const {
+  return IsOpened() ? header_->capacity : 0;
+}
+
+common::ErrnoError HlsShmStoreWriter::Put(const std::string& name, const uint8_t* data, size_t size) {
+  if (!IsOpened()) {
+    return common::make_errno_error("Hls shared store not opened.", EINVAL);
+  }
+
+  if (!IsValidFileName(name) || (!data && size)) {
+    return common::make_errno_error_inval();
+  }
+
+  if (size > max_capacity_) {
+    return common::make_errno_error(common::MemSPrintf("File %s is bigger than hls shared store.", name), EFBIG);
+  }
+
+  MakeRoom(name, size);
+  if (size > header_->capacity) {
+    return common::make_errno_error(common::MemSPrintf("File %s is bigger than hls shared store.", name), EFBIG);
+  }
+
+  Write(name, reinterpret_cast<const char*>(data), size);
+  return common::ErrnoError();
+}
+
+void HlsShmStoreWriter::MakeRoom(const std::string& name, size_t size) {
+  // file with the same name is replaced, its old bytes are free
+  uint64_t capacity = header_->capacity;
+  uint64_t live_size = size;
+  bool overwrites = size > capacity;
+  for (size_t i = 0; i < kMaxFiles; ++i) {
+    const HlsShmFile* file = &header_->files[i];
+    if (!file->name[0] || name == file->name) {
+      continue;
+    }
+
+    live_size += file->size;
+    overwrites |= IsOverwritten(file, capacity, write_position_ + size);
+  }
+
+  if (!overwrites) {
+    return;
+  }
+
+  // twice of live files, so the next segments fit without another copy
+  const size_t grow_capacity = std::min<size_t>(RoundUpPowerOfTwo(live_size * 2), max_capacity_);
+  if (grow_capacity > capacity) {
+    common::ErrnoError err = Grow(grow_capacity);
+    if (err) {
+      DEBUG_MSG_ERROR(err, LOG_LEVEL_WARNING);
+    }
+    capacity = header_->capacity;
+  }
+
+  bool evicted = false;
+  for (size_t i = 0; i < kMaxFiles; ++i) {
+    HlsShmFile* file = &header_->files[i];
+    if (name != file->name && IsOverwritten(file, capacity, write_position_ + size)) {
+      UpdateFile(file, std::string(), 0, 0);
+      evicted = true;
+    }
+  }
+
+  if (evicted && !eviction_warned_) {
+    WARNING_LOG() << "Hls shared store " << name_ << " is full (" << capacity
+                  << " bytes), listed files are evicted, playlist references missing files.";
+    eviction_warned_ = true;
+  }
+}
+
+common::ErrnoError HlsShmStoreWriter::Grow(size_t capacity) {
+  // new segment is filled under temporary name and renamed over the live one, so the name
+  // always resolves to a complete store, readers of the old one reopen it as stale
+  const std::string segment = MakeSegmentName(name_);
+  const std::string grow_segment = segment + kGrowSuffix;
+  shm_unlink(grow_segment.c_str());  // left by killed writer
+  int fd;
+  HlsShmHeader* header;
+  size_t mapped_size;
+  common::ErrnoError err = CreateSegment(grow_segment, RoundUpPowerOfTwo(capacity), &fd, &header, &mapped_size);
+  if (err) {
+    return err;
+  }
+
+  HlsShmHeader* old_header = header_;
+  const int old_fd = fd_;
+  const size_t old_mapped_size = mapped_size_;
+  const uint64_t old_write_position = write_position_;
+  header_ = header;
+  fd_ = fd;
+  mapped_size_ = mapped_size;
+  write_position_ = 0;
+
+  std::vector<const HlsShmFile*> files;
+  for (size_t i = 0; i < kMaxFiles; ++i) {
+    const HlsShmFile* file = &old_header->files[i];
+    if (file->name[0] && !IsOverwritten(file, old_header->capacity, old_write_position)) {
+      files.push_back(file);
+    }
+  }
+  std::sort(files.begin(), files.end(),
+            [](const HlsShmFile* left, const HlsShmFile* right) { return left->position < right->position; });
+
+  std::string data;
+  for (const HlsShmFile* file : files) {
+    data.resize(file->size);
+    CopyFromRing(old_header, file->position, file->size, &data[0]);
+    Write(std::string(file->name, strnlen(file->name, kMaxFileName)), data.data(), data.size());
+  }
+
+  const std::string shm_directory = kShmDirectory;
+  if (rename((shm_directory + grow_segment).c_str(), (shm_directory + segment).c_str()) == -1) {
+    // keep serving the old segment, caller evicts instead
+    const int rename_errno = errno;
+    munmap(header_, mapped_size_);
+    close(fd_);
+    shm_unlink(grow_segment.c_str());
+    header_ = old_header;
+    fd_ = old_fd;
+    mapped_size_ = old_mapped_size;
+    write_position_ = old_write_position;
+    return common::make_errno_error(rename_errno);
+  }
+
+  munmap(old_header, old_mapped_size);
+  close(old_fd);
+  return common::ErrnoError();
+}
+
+void HlsShmStoreWriter::Write(const std::string& name, const char* data, size_t size) {
+  // seqlock style: readers validate copied bytes against reserve position
+  const uint64_t capacity = header_->capacity;
+  const uint64_t position = write_position_;
+  header_->reserve_position.store(position + size, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const size_t offset = position & (capacity - 1);
+  const size_t first = std::min<size_t>(size, capacity - offset);
+  char* ring = header_->GetData();
+  memcpy(ring + offset, data, first);
+  if (first < size) {
+    memcpy(ring, data + first, size - first);
+  }
+  write_position_ += size;
+
+  UpdateFile(&header_->files[FindSlot(name)], name, position, size);
+}
+
+common::ErrnoError HlsShmStoreWriter::Remove(const std::string& name) {
+  if (!IsOpened()) {
+    return common::make_errno_error("Hls shared store not opened.", EINVAL);
+  }
+
+  if (!IsValidFileName(name)) {
+    return common::make_errno_error_inval();
+  }
+
+  for (size_t i = 0; i < kMaxFiles; ++i) {
+    HlsShmFile* file = &header_->files[i];
+    if (name == file->name) {
+      UpdateFile(file, std::string(), 0, 0);
+      break;
+    }
+  }
+  return common::ErrnoError();
+}
+
+size_t HlsShmStoreWriter::FindSlot(const std::string& name) const {
+  // the same name (playlist), free slot or the oldest file
+  size_t free_slot = kMaxFiles;
+  size_t oldest_slot = 0;
+  for (size_t i = 0; i < kMaxFiles; ++i) {
+    const HlsShmFile* file = &header_->files[i];
+    if (name == file->name) {
+      return i;
+    }
+
+    if (!file->name[0]) {
+      if (free_slot == kMaxFiles) {
+        free_slot = i;
+      }
+    } else if (file->position < header_->files[oldest_slot].position) {
+      oldest_slot = i;
+    }
+  }
+  return free_slot != kMaxFiles ? free_slot : oldest_slot;
+}
+
+HlsShmStoreReader::HlsShmStoreReader(const std::string& name)
+    : name_(name), fd_(INVALID_DESCRIPTOR), header_(nullptr), mapped_size_(0), inode_(0) {}
+
+HlsShmStoreReader::~HlsShmStoreReader() {
+  Close();
+}
+
+common::ErrnoError HlsShmStoreReader::Open() {
+  if (IsOpened()) {
+    return common::make_errno_error("Hls shared store already opened.", EINVAL);
+  }
+
+  if (name_.empty() || name_.find('/') != std::string::npos) {
+    return common::make_errno_error_inval();
+  }
+
+  int fd = shm_open(MakeSegmentName(name_).c_str(), O_RDONLY, 0);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(HlsShmHeader)) {
+    close(fd);
+    return common::make_errno_error("Hls shared store not ready.", EAGAIN);
+  }
+
+  const size_t mapped_size = st.st_size;
+  void* mem = mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    const int err = errno;
+    close(fd);
+    return common::make_errno_error(err);
+  }
+
+  const HlsShmHeader* header = static_cast<const HlsShmHeader*>(mem);
+  if (header->magic.load(std::memory_order_acquire) != kHlsShmMagic || header->version != kHlsShmVersion ||
+      sizeof(HlsShmHeader) + header->capacity > mapped_size) {
+    munmap(mem, mapped_size);
+    close(fd);
+    return common::make_errno_error("Hls shared store not ready.", EAGAIN);
+  }
+
+  fd_ = fd;
+  header_ = header;
+  mapped_size_ = mapped_size;
+  inode_ = st.st_ino;
+  return common::ErrnoError();
+}
+
+void HlsShmStoreReader::Close() {
+  if (!IsOpened()) {
+    return;
+  }
+
+  munmap(const_cast<HlsShmHeader*>(header_), mapped_size_);
+  close(fd_);
+  fd_ = INVALID_DESCRIPTOR;
+  header_ = nullptr;
+  mapped_size_ = 0;
+}
+
+bool HlsShmStoreReader::IsOpened() const {
+  return header_ != nullptr;
+}
+
+bool HlsShmStoreReader::IsStale() const {
+  if (!IsOpened()) {
+    return false;
+  }
+
+  int fd = shm_open(MakeSegmentName(name_).c_str(), O_RDONLY, 0);
+  if (fd == INVALID_DESCRIPTOR) {
+    return true;
+  }
+
+  struct stat st;
+  const bool replaced = fstat(fd, &st) == -1 || st.st_ino != inode_;
+  close(fd);
+  return replaced;
+}
+
+bool HlsShmStoreReader::Get(const std::string& file_name, std::string* data) const {
+  uint64_t position;
+  uint32_t size;
+  if (!data || !FindFile(file_name, &position, &size)) {
+    return false;
+  }
+
+  std::string copy(size, 0);
+  if (size) {
+    CopyFromRing(header_, position, size, &copy[0]);
+  }
+
+  // writer could overwrite copied bytes meanwhile
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header_->reserve_position.load(std::memory_order_relaxed) - position > header_->capacity) {
+    return false;
+  }
+
+  *data = copy;
+  return true;
+}
+
+bool HlsShmStoreReader::Exists(const std::string& file_name) const {
+  uint64_t position;
+  uint32_t size;
+  return FindFile(file_name, &position, &size);
+}
+
+bool HlsShmStoreReader::FindFile(const std::string& file_name, uint64_t* position, uint32_t* size) const {
+  if (!IsOpened() || !IsValidFileName(file_name)) {
+    return false;
+  }
+
+  for (size_t i = 0; i < kMaxFiles; ++i) {
+    const HlsShmFile* file = &header_->files[i];
+    for (size_t attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+      const uint32_t sequence = file->sequence.load(std::memory_order_acquire);
+      if (sequence & 1) {
+        continue;
+      }
+
+      char name[kMaxFileName];
+      memcpy(name, file->name, sizeof(name));
+      const uint64_t lposition = file->position;
+      const uint32_t lsize = file->size;
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (file->sequence.load(std::memory_order_relaxed) != sequence) {
+        continue;
+      }
+
+      name[kMaxFileName - 1] = 0;
+      if (file_name != name) {
+        break;
+      }
+
+      // already overwritten by newer files
+      if (header_->reserve_position.load(std::memory_order_acquire) - lposition > header_->capacity) {
+        return false;
+      }
+
+      *position = lposition;
+      *size = lsize;
+      return true;
+    }
+  }
+  return false;
+}
+
+std::string MakeHlsShmName(const std::string& directory) {
+  std::string path = directory;
+  while (path.size() > 1 && path.back() == '/') {
+    path.pop_back();
+  }
+
+  // fnv-1a keeps name short and unambiguous for any directory
+  uint64_t hash = 14695981039346656037ULL;
+  for (char c : path) {
+    hash ^= static_cast<uint8_t>(c);
+    hash *= 1099511628211ULL;
+  }
+  return common::MemSPrintf("iptv_hls_%016llx", static_cast<unsigned long long>(hash));
+}
+
+}  // namespace utils
+}  // namespace iptv_cloud
@@ -0,0 +1,102 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <string>
+
+#include <common/error.h>
+#include <common/macros.h>
+
+#include "utils/ll_hls.h"
+
+namespace iptv_cloud {
+namespace utils {
+
+struct HlsShmHeader;
+
+// Files of one hls output (playlist, segments, parts) in posix shared memory: data goes to a byte ring,
+// names to a small index. Stream child writes, http server of daemon serves them without disk,
+// old files are evicted by packager (segment count), ring overwrites only files already removed.
+// Needed space depends on bitrate (parts and segments hold the same media twice), so ring grows
+// when a listed file would be overwritten and evicts listed files only at max capacity.
+class HlsShmStoreWriter : public IHlsStore {
+ public:
+  enum : size_t { DEFAULT_CAPACITY = 64 * 1024 * 1024, MAX_CAPACITY = 1024 * 1024 * 1024 };
+
+  explicit HlsShmStoreWriter(const std::string& name);  // name without slashes, see MakeHlsShmName
+  ~HlsShmStoreWriter() override;
+
+  // capacities are rounded up to power of two, previous segment with the same name is replaced
+  common::ErrnoError Open(size_t capacity = DEFAULT_CAPACITY,
+                          size_t max_capacity = MAX_CAPACITY) WARN_UNUSED_RESULT;
+  // unlinks segment, attached readers notice it by IsStale
+  void Close();
+  bool IsOpened() const;
+  size_t GetCapacity() const;
+
+  common::ErrnoError Put(const std::string& name, const uint8_t* data, size_t size) override WARN_UNUSED_RESULT;
+  common::ErrnoError Remove(const std::string& name) override WARN_UNUSED_RESULT;
+
+ private:
+  size_t FindSlot(const std::string& name) const;
+  // grows ring or evicts listed files which put of size bytes would overwrite
+  void MakeRoom(const std::string& name, size_t size);
+  // live files are copied compacted to new segment which replaces the named one by rename,
+  // on error old segment stays
+  common::ErrnoError Grow(size_t capacity) WARN_UNUSED_RESULT;
+  void Write(const std::string& name, const char* data, size_t size);
+
+  const std::string name_;
+  int fd_;
+  HlsShmHeader* header_;
+  size_t mapped_size_;
+  uint64_t write_position_;
+  size_t max_capacity_;
+  bool eviction_warned_;
+};
+
+// read only side, lock free: copies are validated against writer and dropped if overwritten meanwhile
+class HlsShmStoreReader {
+ public:
+  explicit HlsShmStoreReader(const std::string& name);
+  ~HlsShmStoreReader();
+
+  common::ErrnoError Open() WARN_UNUSED_RESULT;
+  void Close();
+  bool IsOpened() const;
+  // writer closed or replaced segment (stream restarted)
+  bool IsStale() const;
+
+  // false if there is no such file or it was overwritten
+  bool Get(const std::string& file_name, std::string* data) const;
+  bool Exists(const std::string& file_name) const;
+
+ private:
+  bool FindFile(const std::string& file_name, uint64_t* position, uint32_t* size) const;
+
+  const std::string name_;
+  int fd_;
+  const HlsShmHeader* header_;
+  size_t mapped_size_;
+  ino_t inode_;
+};
+
+// shared memory name of http_root directory of output, the same for child and daemon
+std::string MakeHlsShmName(const std::string& directory);
+
+}  // namespace utils
+}  // namespace iptv_cloud
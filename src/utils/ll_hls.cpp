@@ -0,0 +1,498 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utils/ll_hls.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <common/convert2string.h>
+#include <common/sprintf.h>
+
+namespace iptv_cloud {
+namespace utils {
+
+namespace {
+const char kTsExtension[] = ".ts";
+const char kTmpExtension[] = ".tmp";
+const char kPlaylistHeader[] = "#EXTM3U";
+const char kMediaSequenceTag[] = "#EXT-X-MEDIA-SEQUENCE:";
+const char kTargetDurationTag[] = "#EXT-X-TARGETDURATION:";
+const char kSegmentTag[] = "#EXTINF:";
+const char kPartTag[] = "#EXT-X-PART:";
+const char kMsnParam[] = "_HLS_msn";
+const char kPartParam[] = "_HLS_part";
+const uint64_t kPcrPerMsec = mpegts::TS_PCR_HZ / 1000;
+const uint64_t kMaxPcrStepMsec = 1000;  // bigger steps are discontinuities, clock is not moved
+
+bool StartsWith(const std::string& line, const char* prefix, size_t prefix_size) {
+  return line.compare(0, prefix_size - 1, prefix) == 0;
+}
+
+bool ParseNumber(const std::string& str, uint64_t* number) {
+  if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos) {
+    return false;
+  }
+
+  *number = strtoull(str.c_str(), nullptr, 10);
+  return true;
+}
+
+bool IsNumber(const std::string& str) {
+  uint64_t number;
+  return ParseNumber(str, &number);
+}
+
+std::string GetStem(const std::string& playlist_name) {
+  const size_t dot = playlist_name.rfind('.');
+  return dot == std::string::npos ? playlist_name : playlist_name.substr(0, dot);
+}
+
+std::string FormatDuration(double duration) {
+  return common::MemSPrintf("%.3f", duration);
+}
+}  // namespace
+
+IHlsStore::~IHlsStore() {}
+
+HlsDirectoryStore::HlsDirectoryStore(const std::string& directory) : directory_(directory) {}
+
+common::ErrnoError HlsDirectoryStore::Put(const std::string& name, const uint8_t* data, size_t size) {
+  if (name.empty() || name.find('/') != std::string::npos || (!data && size)) {
+    return common::make_errno_error_inval();
+  }
+
+  const std::string path = directory_ + "/" + name;
+  const std::string tmp_path = path + kTmpExtension;
+  int fd = open(tmp_path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  size_t written = 0;
+  while (written < size) {
+    ssize_t res = write(fd, data + written, size - written);
+    if (res == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      const int err = errno;
+      close(fd);
+      unlink(tmp_path.c_str());
+      return common::make_errno_error(err);
+    }
+    written += res;
+  }
+
+  close(fd);
+  if (rename(tmp_path.c_str(), path.c_str()) == -1) {
+    const int err = errno;
+    unlink(tmp_path.c_str());
+    return common::make_errno_error(err);
+  }
+  return common::ErrnoError();
+}
+
+common::ErrnoError HlsDirectoryStore::Remove(const std::string& name) {
+  if (name.empty() || name.find('/') != std::string::npos) {
+    return common::make_errno_error_inval();
+  }
+
+  const std::string path = directory_ + "/" + name;
+  if (unlink(path.c_str()) == -1 && errno != ENOENT) {
+    return common::make_errno_error(errno);
+  }
+  return common::ErrnoError();
+}
+
+LLHlsPackager::LLHlsPackager(const std::string& playlist_name, IHlsStore* store)
+    : playlist_name_(playlist_name),
+      stem_(GetStem(playlist_name)),
+      store_(store),
+      gop_(),
+      have_pcr_(false),
+      last_pcr_(0),
+      clock_msec_(0),
+      started_(false),
+      current_(),
+      segment_start_msec_(0),
+      part_start_msec_(0),
+      part_independent_(true),
+      keyframe_requested_(false),
+      keyframe_request_(false),
+      forced_cut_warned_(false),
+      segment_data_(),
+      part_data_(),
+      segments_(),
+      evicted_() {
+  current_.msn = 0;
+  current_.duration = 0;
+  current_.independent = true;
+}
+
+common::ErrnoError LLHlsPackager::Feed(const uint8_t* data, size_t size) {
+  if (!store_ || !data || size % mpegts::TS_PACKET_SIZE) {
+    return common::make_errno_error_inval();
+  }
+
+  const mpegts::GopCache::Action action = gop_.Feed(data, size);
+  uint8_t tables[mpegts::GopCache::TABLES_SIZE];
+  const bool audio_only = gop_.GetTables(tables) && gop_.GetVideoPid() == mpegts::TS_NULL_PID;
+  // audio only streams can be cut on any packet
+  const bool boundary = action == mpegts::GopCache::GOP_START || audio_only;
+  UpdateClock(data, size);
+
+  bool changed = false;
+  if (!started_) {
+    // first segment waits for keyframe to be independent
+    if (!boundary) {
+      return common::ErrnoError();
+    }
+    started_ = true;
+    StartSegment(true);
+  } else if ((boundary && clock_msec_ - segment_start_msec_ >= SEGMENT_MIN_MSEC) ||
+             clock_msec_ - segment_start_msec_ >= SEGMENT_MAX_MSEC) {
+    if (!boundary && !forced_cut_warned_) {
+      WARNING_LOG() << "Hls segment " << GetSegmentName(current_.msn)
+                    << " reached target duration without keyframe, keyframes are not forced upstream.";
+      forced_cut_warned_ = true;
+    }
+
+    common::ErrnoError err = ClosePart(boundary);
+    if (err) {
+      return err;
+    }
+
+    err = CloseSegment(boundary);
+    if (err) {
+      return err;
+    }
+    changed = true;
+  } else if (clock_msec_ - part_start_msec_ >= PART_CUT_MSEC) {
+    common::ErrnoError err = ClosePart(boundary);
+    if (err) {
+      return err;
+    }
+    changed = true;
+  }
+
+  if (started_ && !keyframe_requested_ && clock_msec_ - segment_start_msec_ >= SEGMENT_MIN_MSEC) {
+    keyframe_requested_ = true;
+    keyframe_request_ = true;
+  }
+
+  segment_data_.insert(segment_data_.end(), data, data + size);
+  part_data_.insert(part_data_.end(), data, data + size);
+  if (!changed) {
+    return common::ErrnoError();
+  }
+
+  const std::string playlist = GetPlaylist();
+  return store_->Put(playlist_name_, reinterpret_cast<const uint8_t*>(playlist.data()), playlist.size());
+}
+
+bool LLHlsPackager::TakeKeyframeRequest() {
+  const bool request = keyframe_request_;
+  keyframe_request_ = false;
+  return request;
+}
+
+std::string LLHlsPackager::GetPlaylist() const {
+  std::string playlist = std::string(kPlaylistHeader) + "\n#EXT-X-VERSION:6\n";
+  playlist += kTargetDurationTag + common::ConvertToString(GetTargetDuration()) + "\n";
+  playlist += "#EXT-X-SERVER-CONTROL:CAN-BLOCK-RELOAD=YES,PART-HOLD-BACK=" +
+              FormatDuration(PART_TARGET_MSEC * 3 / 1000.0) + "\n";
+  playlist += "#EXT-X-PART-INF:PART-TARGET=" + FormatDuration(PART_TARGET_MSEC / 1000.0) + "\n";
+  playlist += kMediaSequenceTag + common::ConvertToString(GetMediaSequence()) + "\n";
+  if (IsIndependent()) {
+    playlist += "#EXT-X-INDEPENDENT-SEGMENTS\n";
+  }
+
+  auto add_parts = [this, &playlist](const LLHlsSegment& segment) {
+    for (size_t i = 0; i < segment.parts.size(); ++i) {
+      const LLHlsPart& part = segment.parts[i];
+      playlist += kPartTag + std::string("DURATION=") + FormatDuration(part.duration) + ",URI=\"" +
+                  GetPartName(segment.msn, i) + "\"" + (part.independent ? ",INDEPENDENT=YES" : "") + "\n";
+    }
+  };
+
+  for (size_t i = 0; i < segments_.size(); ++i) {
+    const LLHlsSegment& segment = segments_[i];
+    if (i + PART_SEGMENTS >= segments_.size()) {
+      add_parts(segment);
+    }
+    playlist += kSegmentTag + FormatDuration(segment.duration) + ",\n" + GetSegmentName(segment.msn) + "\n";
+  }
+
+  if (started_) {
+    add_parts(current_);
+    playlist += "#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"" + GetPartName(current_.msn, current_.parts.size()) + "\"\n";
+  }
+  return playlist;
+}
+
+size_t LLHlsPackager::GetTargetDuration() const {
+  return TARGET_DURATION;
+}
+
+std::string LLHlsPackager::GetSegmentName(uint64_t msn) const {
+  return stem_ + "_" + common::ConvertToString(msn) + kTsExtension;
+}
+
+std::string LLHlsPackager::GetPartName(uint64_t msn, size_t part) const {
+  return stem_ + "_" + common::ConvertToString(msn) + "." + common::ConvertToString(part) + kTsExtension;
+}
+
+uint64_t LLHlsPackager::GetMediaSequence() const {
+  return segments_.empty() ? current_.msn : segments_.front().msn;
+}
+
+const std::vector<LLHlsSegment>& LLHlsPackager::GetSegments() const {
+  return segments_;
+}
+
+bool LLHlsPackager::IsIndependent() const {
+  for (const LLHlsSegment& segment : segments_) {
+    if (!segment.independent) {
+      return false;
+    }
+  }
+  return !started_ || current_.independent;
+}
+
+void LLHlsPackager::UpdateClock(const uint8_t* data, size_t size) {
+  for (size_t pos = 0; pos + mpegts::TS_PACKET_SIZE <= size; pos += mpegts::TS_PACKET_SIZE) {
+    uint64_t pcr;
+    if (!mpegts::GetPcr(data + pos, &pcr)) {
+      continue;
+    }
+
+    if (have_pcr_ && pcr > last_pcr_) {
+      const uint64_t step_msec = (pcr - last_pcr_) / kPcrPerMsec;
+      if (step_msec <= kMaxPcrStepMsec) {
+        clock_msec_ += step_msec;
+        last_pcr_ += step_msec * kPcrPerMsec;  // keep remainder for next step
+        continue;
+      }
+    }
+    have_pcr_ = true;
+    last_pcr_ = pcr;
+  }
+}
+
+common::ErrnoError LLHlsPackager::ClosePart(bool independent_next) {
+  if (part_data_.empty()) {
+    return common::ErrnoError();
+  }
+
+  common::ErrnoError err = store_->Put(GetPartName(current_.msn, current_.parts.size()), part_data_.data(),
+                                       part_data_.size());
+  if (err) {
+    return err;
+  }
+
+  LLHlsPart part;
+  part.duration = (clock_msec_ - part_start_msec_) / 1000.0;
+  part.independent = part_independent_;
+  current_.parts.push_back(part);
+  part_data_.clear();
+  part_start_msec_ = clock_msec_;
+  part_independent_ = independent_next;
+  return common::ErrnoError();
+}
+
+common::ErrnoError LLHlsPackager::CloseSegment(bool independent_next) {
+  common::ErrnoError err = store_->Put(GetSegmentName(current_.msn), segment_data_.data(), segment_data_.size());
+  if (err) {
+    return err;
+  }
+
+  current_.duration = (clock_msec_ - segment_start_msec_) / 1000.0;
+  segments_.push_back(current_);
+  segment_data_.clear();
+  current_.msn++;
+  StartSegment(independent_next);
+  return Evict();
+}
+
+common::ErrnoError LLHlsPackager::Evict() {
+  while (segments_.size() > PLAYLIST_SEGMENTS) {
+    evicted_.push_back(segments_.front());
+    segments_.erase(segments_.begin());
+  }
+
+  common::ErrnoError err;
+  while (evicted_.size() > EVICT_DELAY_SEGMENTS) {
+    const LLHlsSegment& segment = evicted_.front();
+    for (size_t i = 0; i < segment.parts.size(); ++i) {
+      common::ErrnoError rerr = store_->Remove(GetPartName(segment.msn, i));
+      if (rerr) {
+        err = rerr;
+      }
+    }
+    common::ErrnoError rerr = store_->Remove(GetSegmentName(segment.msn));
+    if (rerr) {
+      err = rerr;
+    }
+    evicted_.erase(evicted_.begin());
+  }
+  return err;
+}
+
+void LLHlsPackager::StartSegment(bool independent) {
+  current_.duration = 0;
+  current_.independent = independent;
+  current_.parts.clear();
+  segment_start_msec_ = clock_msec_;
+  part_start_msec_ = clock_msec_;
+  part_independent_ = independent;
+  keyframe_requested_ = false;
+  keyframe_request_ = false;
+
+  // every segment and its first part start with tables, players may join on them
+  uint8_t tables[mpegts::GopCache::TABLES_SIZE];
+  const size_t tables_size = gop_.GetTables(tables);
+  segment_data_.assign(tables, tables + tables_size);
+  part_data_.assign(tables, tables + tables_size);
+}
+
+LLHlsPlaylistState::LLHlsPlaylistState() : media_sequence(0), next_msn(0), next_part(0), target_duration(0) {}
+
+bool ParseLLHlsPlaylist(const std::string& playlist, LLHlsPlaylistState* state) {
+  if (!state || !StartsWith(playlist, kPlaylistHeader, sizeof(kPlaylistHeader))) {
+    return false;
+  }
+
+  LLHlsPlaylistState result;
+  bool have_sequence = false;
+  uint64_t segments = 0;
+  size_t start = 0;
+  while (start < playlist.size()) {
+    size_t end = playlist.find('\n', start);
+    if (end == std::string::npos) {
+      end = playlist.size();
+    }
+    std::string line = playlist.substr(start, end - start);
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    start = end + 1;
+
+    if (StartsWith(line, kMediaSequenceTag, sizeof(kMediaSequenceTag))) {
+      have_sequence = ParseNumber(line.substr(sizeof(kMediaSequenceTag) - 1), &result.media_sequence);
+    } else if (StartsWith(line, kTargetDurationTag, sizeof(kTargetDurationTag))) {
+      uint64_t target_duration;
+      if (ParseNumber(line.substr(sizeof(kTargetDurationTag) - 1), &target_duration)) {
+        result.target_duration = target_duration;
+      }
+    } else if (StartsWith(line, kSegmentTag, sizeof(kSegmentTag))) {
+      segments++;
+      result.next_part = 0;
+    } else if (StartsWith(line, kPartTag, sizeof(kPartTag))) {
+      result.next_part++;
+    }
+  }
+
+  if (!have_sequence) {
+    return false;
+  }
+
+  result.next_msn = result.media_sequence + segments;
+  *state = result;
+  return true;
+}
+
+bool ParseBlockingReload(const std::string& query, uint64_t* msn, int64_t* part) {
+  if (!msn || !part) {
+    return false;
+  }
+
+  bool have_msn = false;
+  uint64_t lmsn = 0;
+  int64_t lpart = -1;
+  size_t start = 0;
+  while (start <= query.size()) {
+    size_t end = query.find('&', start);
+    if (end == std::string::npos) {
+      end = query.size();
+    }
+    const std::string param = query.substr(start, end - start);
+    start = end + 1;
+
+    const size_t eq = param.find('=');
+    if (eq == std::string::npos) {
+      continue;
+    }
+    const std::string key = param.substr(0, eq);
+    const std::string value = param.substr(eq + 1);
+    uint64_t number;
+    if (key == kMsnParam) {
+      if (!ParseNumber(value, &lmsn)) {
+        return false;
+      }
+      have_msn = true;
+    } else if (key == kPartParam) {
+      if (!ParseNumber(value, &number)) {
+        return false;
+      }
+      lpart = number;
+    }
+  }
+
+  // _HLS_part without _HLS_msn is bad request
+  if (!have_msn) {
+    return false;
+  }
+
+  *msn = lmsn;
+  *part = lpart;
+  return true;
+}
+
+BlockingReload CheckBlockingReload(const LLHlsPlaylistState& state, uint64_t msn, int64_t part) {
+  if (msn > state.next_msn + 1) {
+    return BLOCKING_TOO_FAR;
+  }
+
+  if (msn < state.next_msn) {
+    return BLOCKING_READY;
+  }
+
+  if (part >= 0 && msn == state.next_msn && static_cast<uint64_t>(part) < state.next_part) {
+    return BLOCKING_READY;
+  }
+  return BLOCKING_WAIT;
+}
+
+bool IsLLHlsPartName(const std::string& file_name) {
+  const size_t ext_size = sizeof(kTsExtension) - 1;
+  if (file_name.size() <= ext_size || file_name.compare(file_name.size() - ext_size, ext_size, kTsExtension) != 0) {
+    return false;
+  }
+
+  const std::string name = file_name.substr(0, file_name.size() - ext_size);
+  const size_t dot = name.rfind('.');
+  if (dot == std::string::npos || !IsNumber(name.substr(dot + 1))) {
+    return false;
+  }
+
+  const size_t underscore = name.rfind('_', dot);
+  return underscore != std::string::npos && IsNumber(name.substr(underscore + 1, dot - underscore - 1));
+}
+
+}  // namespace utils
+}  // namespace iptv_cloud
@@ -0,0 +1,157 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+#include <common/error.h>
+#include <common/macros.h>
+
+#include "utils/mpegts.h"
+
+namespace iptv_cloud {
+namespace utils {
+
+// destination of packaged playlist, segments and parts, names are relative to playlist
+class IHlsStore {
+ public:
+  virtual common::ErrnoError Put(const std::string& name, const uint8_t* data, size_t size) WARN_UNUSED_RESULT = 0;
+  virtual common::ErrnoError Remove(const std::string& name) WARN_UNUSED_RESULT = 0;
+  virtual ~IHlsStore();
+};
+
+// files of http_root, written under temporary name and renamed so http server never sends half of file
+class HlsDirectoryStore : public IHlsStore {
+ public:
+  explicit HlsDirectoryStore(const std::string& directory);
+
+  common::ErrnoError Put(const std::string& name, const uint8_t* data, size_t size) override WARN_UNUSED_RESULT;
+  common::ErrnoError Remove(const std::string& name) override WARN_UNUSED_RESULT;
+
+ private:
+  const std::string directory_;
+};
+
+struct LLHlsPart {
+  double duration;
+  bool independent;  // starts with keyframe
+};
+
+struct LLHlsSegment {
+  uint64_t msn;  // media sequence number
+  double duration;
+  bool independent;  // starts with keyframe
+  std::vector<LLHlsPart> parts;
+};
+
+// Low latency hls (rfc8216bis) packager of muxed ts: segments are cut on keyframes of video,
+// every segment is published also as partial segments while it grows, playlist has EXT-X-PART
+// of last segments and preload hint of the next part. One thread feeds.
+// Keyframe is requested from upstream once segment reaches its minimum, sources which can't force
+// them (relays) get segments cut at target duration without keyframe, target duration never changes.
+// Such segment and its first part are not independent.
+class LLHlsPackager {
+ public:
+  enum {
+    TARGET_DURATION = 4,                        // seconds, fixed for whole playlist (rfc 8216 4.3.3.1)
+    SEGMENT_MIN_MSEC = 2000,                    // segment is closed on first keyframe after it
+    SEGMENT_MAX_MSEC = TARGET_DURATION * 1000,  // or without keyframe when it reaches target
+    PART_TARGET_MSEC = 1000,
+    PART_CUT_MSEC = 800,  // part is closed on first buffer after it, so parts stay under target
+    PLAYLIST_SEGMENTS = 6,
+    PART_SEGMENTS = 3,        // last segments listed with parts
+    EVICT_DELAY_SEGMENTS = 2  // evicted segments are kept a bit for clients with older playlist
+  };
+
+  // playlist_name like "master.m3u8", segments and parts are named after its stem
+  LLHlsPackager(const std::string& playlist_name, IHlsStore* store);
+
+  // data must be aligned to packets, every closed part updates playlist
+  common::ErrnoError Feed(const uint8_t* data, size_t size) WARN_UNUSED_RESULT;
+
+  // true once per segment when it needs keyframe to be closed, caller forces key unit upstream
+  bool TakeKeyframeRequest();
+
+  std::string GetPlaylist() const;
+  size_t GetTargetDuration() const;
+  std::string GetSegmentName(uint64_t msn) const;
+  std::string GetPartName(uint64_t msn, size_t part) const;
+
+  uint64_t GetMediaSequence() const;
+  const std::vector<LLHlsSegment>& GetSegments() const;  // closed ones in playlist
+
+ private:
+  void UpdateClock(const uint8_t* data, size_t size);
+  common::ErrnoError ClosePart(bool independent_next) WARN_UNUSED_RESULT;
+  common::ErrnoError CloseSegment(bool independent_next) WARN_UNUSED_RESULT;
+  common::ErrnoError Evict() WARN_UNUSED_RESULT;
+  void StartSegment(bool independent);
+  bool IsIndependent() const;  // all listed segments start with keyframe
+
+  const std::string playlist_name_;
+  const std::string stem_;
+  IHlsStore* const store_;
+
+  mpegts::GopCache gop_;
+  bool have_pcr_;
+  uint64_t last_pcr_;
+  uint64_t clock_msec_;  // pcr based, monotonic over wraps and discontinuities
+
+  bool started_;
+  LLHlsSegment current_;
+  uint64_t segment_start_msec_;
+  uint64_t part_start_msec_;
+  bool part_independent_;
+  bool keyframe_requested_;  // for current segment
+  bool keyframe_request_;    // not taken by caller yet
+  bool forced_cut_warned_;
+  std::vector<uint8_t> segment_data_;
+  std::vector<uint8_t> part_data_;
+
+  std::vector<LLHlsSegment> segments_;
+  std::vector<LLHlsSegment> evicted_;
+};
+
+// what daemon needs from child playlist to answer blocking playlist reload
+struct LLHlsPlaylistState {
+  LLHlsPlaylistState();
+
+  uint64_t media_sequence;
+  uint64_t next_msn;  // msn of segment being built
+  size_t next_part;   // its parts already listed
+  size_t target_duration;
+};
+
+bool ParseLLHlsPlaylist(const std::string& playlist, LLHlsPlaylistState* state) WARN_UNUSED_RESULT;
+
+// _HLS_msn and optional _HLS_part (-1 if not set) of request query
+bool ParseBlockingReload(const std::string& query, uint64_t* msn, int64_t* part) WARN_UNUSED_RESULT;
+
+enum BlockingReload {
+  BLOCKING_READY,   // playlist already has requested segment or part
+  BLOCKING_WAIT,    // hold request until playlist changes
+  BLOCKING_TOO_FAR  // more than one segment ahead, 400 per spec
+};
+
+BlockingReload CheckBlockingReload(const LLHlsPlaylistState& state, uint64_t msn, int64_t part);
+
+// <stem>_<msn>.<part>.ts
+bool IsLLHlsPartName(const std::string& file_name);
+
+}  // namespace utils
+}  // namespace iptv_cloud
@@ -0,0 +1,652 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utils/mpegts.h"
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+const uint64_t kPcrWrap = (UINT64_C(1) << 33) * 300;
+const uint64_t kPcrTicksPerMsec = iptv_cloud::utils::mpegts::TS_PCR_HZ / 1000;
+const uint64_t kPcrTicksPerUsec = iptv_cloud::utils::mpegts::TS_PCR_HZ / 1000000;
+
+const uint8_t kPatTableId = 0x00;
+const uint8_t kPmtTableId = 0x02;
+
+// section of packet with payload_unit_start_indicator or nullptr, end is the packet end
+const uint8_t* GetSection(const uint8_t* packet) {
+  if (!(packet[1] & 0x40) || !iptv_cloud::utils::mpegts::HasPayload(packet)) {
+    return nullptr;
+  }
+
+  size_t offset = 4;
+  if (iptv_cloud::utils::mpegts::HasAdaptationField(packet)) {
+    offset += 1 + packet[4];
+  }
+  if (offset >= iptv_cloud::utils::mpegts::TS_PACKET_SIZE) {
+    return nullptr;
+  }
+
+  offset += 1 + packet[offset];  // pointer_field
+  if (offset + 3 > iptv_cloud::utils::mpegts::TS_PACKET_SIZE) {
+    return nullptr;
+  }
+  return packet + offset;
+}
+
+// section_length without crc, 0 if the section does not fit the packet
+size_t GetSectionBodyEnd(const uint8_t* packet, const uint8_t* section) {
+  const size_t section_length = ((section[1] & 0x0F) << 8) | section[2];
+  const size_t end = (section - packet) + 3 + section_length;
+  if (section_length < 9 || end > iptv_cloud::utils::mpegts::TS_PACKET_SIZE) {
+    return 0;
+  }
+  return end - 4;
+}
+
+bool IsVideoStreamType(uint8_t stream_type) {
+  return stream_type == 0x01 || stream_type == 0x02 || stream_type == 0x10 || stream_type == 0x1B ||
+         stream_type == 0x24;  // mpeg1/2, mpeg4 part 2, h264, h265
+}
+}
+
+namespace iptv_cloud {
+namespace utils {
+namespace mpegts {
+
+bool IsDiscontinuity(const uint8_t* packet) {
+  if (!HasAdaptationField(packet) || packet[4] == 0) {
+    return false;
+  }
+
+  return packet[5] & 0x80;
+}
+
+bool IsRandomAccess(const uint8_t* packet) {
+  if (!HasAdaptationField(packet) || packet[4] == 0) {
+    return false;
+  }
+
+  return packet[5] & 0x40;
+}
+
+bool GetPcr(const uint8_t* packet, uint64_t* pcr) {
+  if (!pcr || !HasAdaptationField(packet)) {
+    return false;
+  }
+
+  const uint8_t af_length = packet[4];
+  if (af_length < 7 || !(packet[5] & 0x10)) {
+    return false;
+  }
+
+  const uint64_t base = (static_cast<uint64_t>(packet[6]) << 25) | (static_cast<uint64_t>(packet[7]) << 17) |
+                        (static_cast<uint64_t>(packet[8]) << 9) | (static_cast<uint64_t>(packet[9]) << 1) |
+                        (packet[10] >> 7);
+  const uint64_t ext = ((packet[10] & 0x01) << 8) | packet[11];
+  *pcr = base * 300 + ext;
+  return true;
+}
+
+const uint8_t* FindSyncByte(const uint8_t* data, size_t size) {
+  size_t i = 0;
+#if defined(__SSE2__)
+  const __m128i sync = _mm_set1_epi8(TS_SYNC_BYTE);
+  for (; i + 16 <= size; i += 16) {
+    const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    const int mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, sync));
+    if (mask) {
+      return data + i + __builtin_ctz(mask);
+    }
+  }
+#endif
+  const void* found = memchr(data + i, TS_SYNC_BYTE, size - i);
+  return static_cast<const uint8_t*>(found);
+}
+
+ContinuityChecker::ContinuityChecker() : last_cc_(), duplicate_(), errors_(0), packets_(0) {
+  Reset();
+}
+
+size_t ContinuityChecker::Check(const uint8_t* data, size_t size) {
+  size_t errors = 0;
+  for (size_t i = 0; i + TS_PACKET_SIZE <= size; i += TS_PACKET_SIZE) {
+    if (!CheckPacket(data + i)) {
+      errors++;
+    }
+  }
+  return errors;
+}
+
+bool ContinuityChecker::CheckPacket(const uint8_t* packet) {
+  packets_++;
+  if (!IsSyncPacket(packet)) {
+    errors_++;
+    return false;
+  }
+
+  const uint16_t pid = GetPid(packet);
+  if (pid == TS_NULL_PID || !HasPayload(packet)) {  // cc not incremented without payload
+    return true;
+  }
+
+  const uint8_t cc = GetContinuityCounter(packet);
+  const uint8_t last = last_cc_[pid];
+  last_cc_[pid] = cc;
+  if (last == CC_UNKNOWN || IsDiscontinuity(packet)) {
+    duplicate_[pid] = false;
+    return true;
+  }
+
+  if (cc == last) {  // one duplicate packet allowed
+    if (duplicate_[pid]) {
+      errors_++;
+      return false;
+    }
+    duplicate_[pid] = true;
+    return true;
+  }
+
+  duplicate_[pid] = false;
+  if (cc != ((last + 1) & 0x0F)) {
+    errors_++;
+    return false;
+  }
+
+  return true;
+}
+
+uint64_t ContinuityChecker::GetErrors() const {
+  return errors_;
+}
+
+uint64_t ContinuityChecker::GetPackets() const {
+  return packets_;
+}
+
+void ContinuityChecker::Reset() {
+  memset(last_cc_, CC_UNKNOWN, sizeof(last_cc_));
+  memset(duplicate_, 0, sizeof(duplicate_));
+  errors_ = 0;
+  packets_ = 0;
+}
+
+PcrPacer::PcrPacer(int64_t max_jitter_usec)
+    : max_jitter_usec_(max_jitter_usec), locked_(false), base_pcr_(0), base_time_usec_(0), resets_(0) {}
+
+int64_t PcrPacer::GetSendTime(uint64_t pcr, int64_t now_usec) {
+  if (!locked_) {
+    locked_ = true;
+    base_pcr_ = pcr;
+    base_time_usec_ = now_usec;
+    return now_usec;
+  }
+
+  const uint64_t diff = (pcr + kPcrWrap - base_pcr_) % kPcrWrap;
+  if (diff > kPcrWrap / 2) {  // pcr moved backward
+    resets_++;
+    locked_ = false;
+    return GetSendTime(pcr, now_usec);
+  }
+
+  const int64_t send_time = base_time_usec_ + static_cast<int64_t>(diff / (TS_PCR_HZ / 1000000));
+  const int64_t drift = send_time - now_usec;
+  if (drift > max_jitter_usec_ || drift < -max_jitter_usec_) {
+    resets_++;
+    locked_ = false;
+    return GetSendTime(pcr, now_usec);
+  }
+
+  return send_time;
+}
+
+bool PcrPacer::IsLocked() const {
+  return locked_;
+}
+
+uint64_t PcrPacer::GetResets() const {
+  return resets_;
+}
+
+void PcrPacer::Reset() {
+  locked_ = false;
+  base_pcr_ = 0;
+  base_time_usec_ = 0;
+}
+
+TsQuality::TsQuality()
+    : packets(0),
+      sync_losses(0),
+      sync_byte_errors(0),
+      pat_errors(0),
+      cc_errors(0),
+      transport_errors(0),
+      pcr_repetition_errors(0),
+      pcr_discontinuity_errors(0),
+      pcr_pid(TS_NULL_PID),
+      pcr_interval_max_msec(0),
+      pcr_jitter_usec(0),
+      pcr_jitter_max_usec(0),
+      pids_count(0),
+      pids() {}
+
+TsAnalyzer::TsAnalyzer()
+    : cc_checker_(),
+      locked_(false),
+      corrupted_in_row_(0),
+      pending_(),
+      pending_size_(0),
+      pat_timer_started_(false),
+      last_pat_usec_(0),
+      have_pcr_(false),
+      last_pcr_(0),
+      last_pcr_usec_(0),
+      jitter_usec_(0),
+      packets_(0),
+      sync_losses_(0),
+      sync_byte_errors_(0),
+      pat_errors_(0),
+      cc_errors_(0),
+      transport_errors_(0),
+      pcr_repetition_errors_(0),
+      pcr_discontinuity_errors_(0),
+      pcr_pid_(TS_NULL_PID),
+      pcr_interval_max_msec_(0),
+      pcr_jitter_usec_(0),
+      pcr_jitter_max_usec_(0),
+      prev_pid_bytes_() {
+  for (size_t i = 0; i < TS_PID_COUNT; ++i) {
+    pid_bytes_[i].store(0, std::memory_order_relaxed);
+  }
+}
+
+void TsAnalyzer::Feed(const uint8_t* data, size_t size, int64_t arrival_usec) {
+  if (!data || !size) {
+    return;
+  }
+
+  if (pending_size_) {  // tail of previous data, not enough bytes for decision
+    const size_t old_size = pending_size_;
+    const size_t take = std::min(size, sizeof(pending_) - old_size);
+    memcpy(pending_ + old_size, data, take);
+    const size_t total = old_size + take;
+    const size_t processed = Process(pending_, total, arrival_usec);
+    if (processed < old_size) {  // all data is in pending_
+      memmove(pending_, pending_ + processed, total - processed);
+      pending_size_ = total - processed;
+      return;
+    }
+
+    pending_size_ = 0;
+    data += processed - old_size;
+    size -= processed - old_size;
+  }
+
+  const size_t processed = Process(data, size, arrival_usec);
+  pending_size_ = size - processed;
+  memcpy(pending_, data + processed, pending_size_);
+}
+
+bool TsAnalyzer::IsLocked() const {
+  return locked_;
+}
+
+void TsAnalyzer::Sample(uint64_t elapsed_msec, TsQuality* quality) {
+  if (!quality) {
+    return;
+  }
+
+  quality->packets = packets_.load(std::memory_order_relaxed);
+  quality->sync_losses = sync_losses_.load(std::memory_order_relaxed);
+  quality->sync_byte_errors = sync_byte_errors_.load(std::memory_order_relaxed);
+  quality->pat_errors = pat_errors_.load(std::memory_order_relaxed);
+  quality->cc_errors = cc_errors_.load(std::memory_order_relaxed);
+  quality->transport_errors = transport_errors_.load(std::memory_order_relaxed);
+  quality->pcr_repetition_errors = pcr_repetition_errors_.load(std::memory_order_relaxed);
+  quality->pcr_discontinuity_errors = pcr_discontinuity_errors_.load(std::memory_order_relaxed);
+  quality->pcr_pid = pcr_pid_.load(std::memory_order_relaxed);
+  quality->pcr_interval_max_msec = pcr_interval_max_msec_.load(std::memory_order_relaxed);
+  quality->pcr_jitter_usec = pcr_jitter_usec_.load(std::memory_order_relaxed);
+  quality->pcr_jitter_max_usec = pcr_jitter_max_usec_.load(std::memory_order_relaxed);
+
+  // keeps MAX_PIDS biggest pids sorted by bitrate
+  quality->pids_count = 0;
+  for (size_t pid = 0; pid < TS_PID_COUNT; ++pid) {
+    const uint64_t bytes = pid_bytes_[pid].load(std::memory_order_relaxed);
+    const uint64_t diff = bytes - prev_pid_bytes_[pid];
+    prev_pid_bytes_[pid] = bytes;
+    if (!diff || !elapsed_msec) {
+      continue;
+    }
+
+    const TsPidBitrate rate = {static_cast<uint16_t>(pid), diff * 1000 / elapsed_msec};
+    size_t pos = quality->pids_count;
+    while (pos && quality->pids[pos - 1].bytes_per_second < rate.bytes_per_second) {
+      if (pos < TsQuality::MAX_PIDS) {
+        quality->pids[pos] = quality->pids[pos - 1];
+      }
+      pos--;
+    }
+    if (pos < TsQuality::MAX_PIDS) {
+      quality->pids[pos] = rate;
+      if (quality->pids_count < TsQuality::MAX_PIDS) {
+        quality->pids_count++;
+      }
+    }
+  }
+}
+
+size_t TsAnalyzer::Process(const uint8_t* data, size_t size, int64_t arrival_usec) {
+  size_t pos = 0;
+  while (pos < size) {
+    if (!locked_) {
+      const uint8_t* sync = FindSyncByte(data + pos, size - pos);
+      if (!sync) {
+        return size;
+      }
+
+      pos = sync - data;
+      if (size - pos < LOCK_BYTES) {
+        return pos;
+      }
+
+      bool aligned = true;
+      for (size_t i = 1; i < LOCK_PACKETS && aligned; ++i) {
+        aligned = IsSyncPacket(data + pos + i * TS_PACKET_SIZE);
+      }
+      if (!aligned) {
+        pos++;
+        continue;
+      }
+
+      locked_ = true;
+      corrupted_in_row_ = 0;
+    }
+
+    if (size - pos < TS_PACKET_SIZE) {
+      return pos;
+    }
+
+    const uint8_t* packet = data + pos;
+    if (!IsSyncPacket(packet)) {
+      Increment(&sync_byte_errors_);
+      if (++corrupted_in_row_ >= LOST_PACKETS) {
+        Increment(&sync_losses_);
+        locked_ = false;
+        pos++;
+        continue;
+      }
+      pos += TS_PACKET_SIZE;
+      continue;
+    }
+
+    corrupted_in_row_ = 0;
+    AnalyzePacket(packet, arrival_usec);
+    pos += TS_PACKET_SIZE;
+  }
+
+  return pos;
+}
+
+void TsAnalyzer::AnalyzePacket(const uint8_t* packet, int64_t arrival_usec) {
+  Increment(&packets_);
+  if (HasTransportError(packet)) {
+    Increment(&transport_errors_);
+  }
+
+  const uint16_t pid = GetPid(packet);
+  Increment(&pid_bytes_[pid], TS_PACKET_SIZE);
+  if (!cc_checker_.CheckPacket(packet)) {
+    Increment(&cc_errors_);
+  }
+
+  // every packet checks PAT interval, so stopped PAT is counted too (once per interval)
+  if (!pat_timer_started_) {  // stream without any PAT fails from its first packet
+    pat_timer_started_ = true;
+    last_pat_usec_ = arrival_usec;
+  }
+  if (arrival_usec - last_pat_usec_ > PAT_MAX_INTERVAL_MSEC * 1000) {
+    Increment(&pat_errors_);
+    last_pat_usec_ = arrival_usec;
+  }
+  if (pid == TS_PAT_PID) {
+    last_pat_usec_ = arrival_usec;
+  }
+
+  uint64_t pcr;
+  if (GetPcr(packet, &pcr)) {
+    uint16_t pcr_pid = pcr_pid_.load(std::memory_order_relaxed);
+    if (pcr_pid == TS_NULL_PID) {  // first pid with pcr
+      pcr_pid = pid;
+      pcr_pid_.store(pcr_pid, std::memory_order_relaxed);
+    }
+    if (pid == pcr_pid) {
+      AnalyzePcr(packet, pcr, arrival_usec);
+    }
+  }
+}
+
+void TsAnalyzer::AnalyzePcr(const uint8_t* packet, uint64_t pcr, int64_t arrival_usec) {
+  const bool have_prev = have_pcr_ && !IsDiscontinuity(packet);
+  const uint64_t prev_pcr = last_pcr_;
+  const int64_t prev_usec = last_pcr_usec_;
+  have_pcr_ = true;
+  last_pcr_ = pcr;
+  last_pcr_usec_ = arrival_usec;
+  if (!have_prev) {
+    return;
+  }
+
+  const uint64_t diff = (pcr + kPcrWrap - prev_pcr) % kPcrWrap;  // backward jump is huge diff
+  if (diff > PCR_MAX_JUMP_MSEC * kPcrTicksPerMsec) {
+    Increment(&pcr_discontinuity_errors_);
+    return;
+  }
+
+  const uint64_t interval_msec = diff / kPcrTicksPerMsec;
+  if (interval_msec > PCR_MAX_INTERVAL_MSEC) {
+    Increment(&pcr_repetition_errors_);
+  }
+  if (interval_msec > pcr_interval_max_msec_.load(std::memory_order_relaxed)) {
+    pcr_interval_max_msec_.store(interval_msec, std::memory_order_relaxed);
+  }
+
+  // rfc 3550 style interarrival jitter
+  const int64_t deviation = (arrival_usec - prev_usec) - static_cast<int64_t>(diff / kPcrTicksPerUsec);
+  const int64_t abs_deviation = deviation < 0 ? -deviation : deviation;
+  jitter_usec_ += (abs_deviation - jitter_usec_) / 16;
+  pcr_jitter_usec_.store(jitter_usec_, std::memory_order_relaxed);
+  if (static_cast<uint64_t>(abs_deviation) > pcr_jitter_max_usec_.load(std::memory_order_relaxed)) {
+    pcr_jitter_max_usec_.store(abs_deviation, std::memory_order_relaxed);
+  }
+}
+
+void TsAnalyzer::Increment(counter_t* counter, uint64_t value) {
+  // one writer, so no atomic read-modify-write
+  counter->store(counter->load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+GopCache::GopCache()
+    : tables_mutex_(),
+      pat_(),
+      pmt_(),
+      have_pat_(false),
+      have_pmt_(false),
+      pat_cc_(CC_UNKNOWN),
+      pmt_cc_(CC_UNKNOWN),
+      gop_pat_cc_(CC_UNKNOWN),
+      gop_pmt_cc_(CC_UNKNOWN),
+      pmt_pid_(TS_NULL_PID),
+      video_pid_(TS_NULL_PID),
+      gop_bytes_(0),
+      gops_(0) {}
+
+GopCache::Action GopCache::Feed(const uint8_t* data, size_t size) {
+  std::unique_lock<std::mutex> lock(tables_mutex_);
+  // sinks start clients from beginning of keyframe data, tables of it go after injected ones
+  const uint8_t pat_cc = pat_cc_;
+  const uint8_t pmt_cc = pmt_cc_;
+  bool keyframe = false;
+  for (size_t pos = 0; pos + TS_PACKET_SIZE <= size; pos += TS_PACKET_SIZE) {
+    keyframe |= FeedPacket(data + pos);
+  }
+
+  if (video_pid_ == TS_NULL_PID) {
+    return GOP_UNKNOWN;
+  }
+
+  if (keyframe) {
+    gop_pat_cc_ = pat_cc;
+    gop_pmt_cc_ = pmt_cc;
+    gop_bytes_ = size;
+    gops_++;
+    return GOP_START;
+  }
+
+  gop_bytes_ += size;
+  return GOP_CONTINUE;
+}
+
+bool GopCache::FeedPacket(const uint8_t* packet) {
+  if (!IsSyncPacket(packet) || HasTransportError(packet)) {
+    return false;
+  }
+
+  const uint16_t pid = GetPid(packet);
+  if (pid == TS_PAT_PID) {
+    pat_cc_ = GetContinuityCounter(packet);
+    ParsePat(packet);
+    return false;
+  } else if (pid == pmt_pid_ && pmt_pid_ != TS_NULL_PID) {
+    pmt_cc_ = GetContinuityCounter(packet);
+    ParsePmt(packet);
+    return false;
+  }
+
+  return pid == video_pid_ && (packet[1] & 0x40) && IsRandomAccess(packet);
+}
+
+void GopCache::ParsePat(const uint8_t* packet) {
+  const uint8_t* section = GetSection(packet);
+  if (!section || section[0] != kPatTableId) {
+    return;
+  }
+
+  const size_t end = GetSectionBodyEnd(packet, section);
+  for (size_t pos = (section - packet) + 8; pos + 4 <= end; pos += 4) {
+    const uint16_t program_number = (packet[pos] << 8) | packet[pos + 1];
+    if (program_number == 0) {  // network pid
+      continue;
+    }
+
+    const uint16_t pmt_pid = ((packet[pos + 2] & 0x1F) << 8) | packet[pos + 3];
+    if (pmt_pid != pmt_pid_) {  // program changed
+      pmt_pid_ = pmt_pid;
+      have_pmt_ = false;
+      pmt_cc_ = CC_UNKNOWN;
+      video_pid_ = TS_NULL_PID;
+    }
+    memcpy(pat_, packet, TS_PACKET_SIZE);
+    have_pat_ = true;
+    return;
+  }
+}
+
+void GopCache::ParsePmt(const uint8_t* packet) {
+  const uint8_t* section = GetSection(packet);
+  if (!section || section[0] != kPmtTableId) {
+    return;
+  }
+
+  const size_t end = GetSectionBodyEnd(packet, section);
+  if (end == 0) {
+    return;
+  }
+
+  const size_t start = section - packet;
+  const size_t program_info_length = ((section[10] & 0x0F) << 8) | section[11];
+  uint16_t video_pid = TS_NULL_PID;
+  for (size_t pos = start + 12 + program_info_length; pos + 5 <= end;) {
+    const uint8_t stream_type = packet[pos];
+    const uint16_t es_pid = ((packet[pos + 1] & 0x1F) << 8) | packet[pos + 2];
+    const size_t es_info_length = ((packet[pos + 3] & 0x0F) << 8) | packet[pos + 4];
+    if (IsVideoStreamType(stream_type)) {
+      video_pid = es_pid;
+      break;
+    }
+    pos += 5 + es_info_length;
+  }
+
+  memcpy(pmt_, packet, TS_PACKET_SIZE);
+  have_pmt_ = true;
+  video_pid_ = video_pid;
+}
+
+size_t GopCache::GetTables(uint8_t* out) const {
+  if (!out) {
+    return 0;
+  }
+
+  std::unique_lock<std::mutex> lock(tables_mutex_);
+  // without video any data can start, so tables go in front of next one
+  const bool have_video = video_pid_ != TS_NULL_PID;
+  const uint8_t pat_cc = have_video ? gop_pat_cc_ : pat_cc_;
+  const uint8_t pmt_cc = have_video ? gop_pmt_cc_ : pmt_cc_;
+  if (!have_pat_ || !have_pmt_ || pat_cc == CC_UNKNOWN || pmt_cc == CC_UNKNOWN) {
+    return 0;  // tables of first gop are inside it
+  }
+
+  memcpy(out, pat_, TS_PACKET_SIZE);
+  out[3] = (out[3] & 0xF0) | pat_cc;
+  memcpy(out + TS_PACKET_SIZE, pmt_, TS_PACKET_SIZE);
+  out[TS_PACKET_SIZE + 3] = (out[TS_PACKET_SIZE + 3] & 0xF0) | pmt_cc;
+  return TABLES_SIZE;
+}
+
+uint16_t GopCache::GetVideoPid() const {
+  std::unique_lock<std::mutex> lock(tables_mutex_);
+  return video_pid_;
+}
+
+uint64_t GopCache::GetGopBytes() const {
+  return gop_bytes_;
+}
+
+uint64_t GopCache::GetGops() const {
+  return gops_;
+}
+
+void GopCache::Reset() {
+  std::unique_lock<std::mutex> lock(tables_mutex_);
+  have_pat_ = false;
+  have_pmt_ = false;
+  pat_cc_ = CC_UNKNOWN;
+  pmt_cc_ = CC_UNKNOWN;
+  gop_pat_cc_ = CC_UNKNOWN;
+  gop_pmt_cc_ = CC_UNKNOWN;
+  pmt_pid_ = TS_NULL_PID;
+  video_pid_ = TS_NULL_PID;
+  gop_bytes_ = 0;
+  gops_ = 0;
+}
+
+}  // namespace mpegts
+}  // namespace utils
+}  // namespace iptv_cloud
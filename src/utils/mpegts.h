@@ -0,0 +1,260 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <mutex>
+
+namespace iptv_cloud {
+namespace utils {
+namespace mpegts {
+
+enum {
+  TS_PACKET_SIZE = 188,
+  TS_SYNC_BYTE = 0x47,
+  TS_PID_COUNT = 0x2000,
+  TS_NULL_PID = 0x1FFF,
+  TS_PAT_PID = 0x0000,
+  TS_PCR_HZ = 27000000
+};
+
+inline bool IsSyncPacket(const uint8_t* packet) {
+  return packet[0] == TS_SYNC_BYTE;
+}
+
+inline bool HasTransportError(const uint8_t* packet) {
+  return packet[1] & 0x80;
+}
+
+inline uint16_t GetPid(const uint8_t* packet) {
+  return ((packet[1] & 0x1F) << 8) | packet[2];
+}
+
+inline bool HasPayload(const uint8_t* packet) {
+  return packet[3] & 0x10;
+}
+
+inline bool HasAdaptationField(const uint8_t* packet) {
+  return packet[3] & 0x20;
+}
+
+inline uint8_t GetContinuityCounter(const uint8_t* packet) {
+  return packet[3] & 0x0F;
+}
+
+// discontinuity_indicator of adaptation field
+bool IsDiscontinuity(const uint8_t* packet);
+
+// random_access_indicator of adaptation field, set by muxers on keyframes
+bool IsRandomAccess(const uint8_t* packet);
+
+// pcr in 27MHz units
+bool GetPcr(const uint8_t* packet, uint64_t* pcr);
+
+// first TS_SYNC_BYTE in data or nullptr, sse2 scan where available
+const uint8_t* FindSyncByte(const uint8_t* data, size_t size);
+
+// counts continuity counter errors of every pid (ISO/IEC 13818-1 2.4.3.3)
+class ContinuityChecker {
+ public:
+  ContinuityChecker();
+
+  // returns errors found in data, data must be aligned to packets
+  size_t Check(const uint8_t* data, size_t size);
+  bool CheckPacket(const uint8_t* packet);
+
+  uint64_t GetErrors() const;
+  uint64_t GetPackets() const;
+
+  void Reset();
+
+ private:
+  enum { CC_UNKNOWN = 0xFF };
+  uint8_t last_cc_[TS_PID_COUNT];
+  bool duplicate_[TS_PID_COUNT];
+
+  uint64_t errors_;
+  uint64_t packets_;
+};
+
+// maps pcr to local time (microseconds) to send data with input bitrate
+class PcrPacer {
+ public:
+  enum { DEFAULT_MAX_JITTER_USEC = 500000 };
+
+  explicit PcrPacer(int64_t max_jitter_usec = DEFAULT_MAX_JITTER_USEC);
+
+  // returns local time when data with this pcr should be sent
+  int64_t GetSendTime(uint64_t pcr, int64_t now_usec);
+
+  bool IsLocked() const;
+  uint64_t GetResets() const;
+
+  void Reset();
+
+ private:
+  const int64_t max_jitter_usec_;
+
+  bool locked_;
+  uint64_t base_pcr_;
+  int64_t base_time_usec_;
+  uint64_t resets_;
+};
+
+struct TsPidBitrate {
+  uint16_t pid;
+  uint64_t bytes_per_second;
+};
+
+// TR 101 290 priority 1/2 subset, only compile time size fields (part of ChannelStats)
+struct TsQuality {
+  enum { MAX_PIDS = 8 };
+
+  TsQuality();
+
+  uint64_t packets;
+  uint64_t sync_losses;               // 1.1 TS_sync_loss
+  uint64_t sync_byte_errors;          // 1.2 Sync_byte_error
+  uint64_t pat_errors;                // 1.3 PAT_error, pat interval > 500ms
+  uint64_t cc_errors;                 // 1.4 Continuity_count_error
+  uint64_t transport_errors;          // 2.1 Transport_error
+  uint64_t pcr_repetition_errors;     // 2.3a PCR_repetition_error, pcr interval > 40ms
+  uint64_t pcr_discontinuity_errors;  // 2.3b PCR_discontinuity_indicator_error, pcr jump > 100ms
+  uint16_t pcr_pid;
+  uint64_t pcr_interval_max_msec;
+  uint64_t pcr_jitter_usec;  // smoothed difference of pcr and arrival intervals
+  uint64_t pcr_jitter_max_usec;
+
+  size_t pids_count;  // pids with most bytes during last interval
+  TsPidBitrate pids[MAX_PIDS];
+};
+
+// Analyzes ts fed by one thread (any alignment, packets may be split between calls),
+// Sample is called by another one, counters are lock free.
+class TsAnalyzer {
+ public:
+  enum {
+    LOCK_PACKETS = 5,  // sync acquired after 5 sync bytes in a row
+    LOST_PACKETS = 2,  // and lost after 2 corrupted ones
+    PAT_MAX_INTERVAL_MSEC = 500,
+    PCR_MAX_INTERVAL_MSEC = 40,
+    PCR_MAX_JUMP_MSEC = 100
+  };
+
+  TsAnalyzer();
+
+  // feeding thread, arrival in microseconds of monotonic clock
+  void Feed(const uint8_t* data, size_t size, int64_t arrival_usec);
+  bool IsLocked() const;
+
+  // reader thread, pids bitrate over elapsed time since previous call
+  void Sample(uint64_t elapsed_msec, TsQuality* quality);
+
+ private:
+  typedef std::atomic<uint64_t> counter_t;
+  enum { LOCK_BYTES = LOCK_PACKETS * TS_PACKET_SIZE };
+
+  size_t Process(const uint8_t* data, size_t size, int64_t arrival_usec);
+  void AnalyzePacket(const uint8_t* packet, int64_t arrival_usec);
+  void AnalyzePcr(const uint8_t* packet, uint64_t pcr, int64_t arrival_usec);
+  static void Increment(counter_t* counter, uint64_t value = 1);
+
+  // feeding thread
+  ContinuityChecker cc_checker_;
+  bool locked_;
+  size_t corrupted_in_row_;
+  uint8_t pending_[LOCK_BYTES * 2];
+  size_t pending_size_;
+  bool pat_timer_started_;
+  int64_t last_pat_usec_;  // last PAT or PAT_error, interval starts here
+  bool have_pcr_;
+  uint64_t last_pcr_;
+  int64_t last_pcr_usec_;
+  int64_t jitter_usec_;
+
+  counter_t packets_;
+  counter_t sync_losses_;
+  counter_t sync_byte_errors_;
+  counter_t pat_errors_;
+  counter_t cc_errors_;
+  counter_t transport_errors_;
+  counter_t pcr_repetition_errors_;
+  counter_t pcr_discontinuity_errors_;
+  std::atomic<uint16_t> pcr_pid_;
+  counter_t pcr_interval_max_msec_;
+  counter_t pcr_jitter_usec_;
+  counter_t pcr_jitter_max_usec_;
+  counter_t pid_bytes_[TS_PID_COUNT];
+
+  // reader thread
+  uint64_t prev_pid_bytes_[TS_PID_COUNT];
+};
+
+// Follows PAT/PMT of the first program and keyframes of its video pid, lets sinks
+// start new clients from the last keyframe with tables in front (one thread feeds,
+// tables can be taken by another one).
+class GopCache {
+ public:
+  enum Action {
+    GOP_UNKNOWN,   // no video pid yet, data passed as is
+    GOP_CONTINUE,  // data inside current gop
+    GOP_START      // data with keyframe, new gop
+  };
+  enum { TABLES_SIZE = TS_PACKET_SIZE * 2 };  // pat and pmt, sections in one packet
+
+  GopCache();
+
+  // data must be aligned to packets
+  Action Feed(const uint8_t* data, size_t size);
+
+  // copies pat and pmt to put in front of current gop (TABLES_SIZE bytes), continuity counters
+  // rewritten to the ones sent before gop, so tables of gop follow them, 0 if no gop yet,
+  // streams without video get counters of last tables
+  size_t GetTables(uint8_t* out) const;
+  uint16_t GetVideoPid() const;
+
+  uint64_t GetGopBytes() const;  // since last keyframe
+  uint64_t GetGops() const;
+
+  void Reset();
+
+ private:
+  bool FeedPacket(const uint8_t* packet);
+  void ParsePat(const uint8_t* packet);
+  void ParsePmt(const uint8_t* packet);
+
+  enum { CC_UNKNOWN = 0xFF };
+  mutable std::mutex tables_mutex_;
+  uint8_t pat_[TS_PACKET_SIZE];
+  uint8_t pmt_[TS_PACKET_SIZE];
+  bool have_pat_;
+  bool have_pmt_;
+  uint8_t pat_cc_;  // last sent
+  uint8_t pmt_cc_;
+  uint8_t gop_pat_cc_;  // last sent before current gop
+  uint8_t gop_pmt_cc_;
+  uint16_t pmt_pid_;
+  uint16_t video_pid_;
+
+  std::atomic<uint64_t> gop_bytes_;
+  std::atomic<uint64_t> gops_;
+};
+
+}  // namespace mpegts
+}  // namespace utils
+}  // namespace iptv_cloud
@@ -0,0 +1,421 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "utils/shm_ring.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <linux/futex.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+namespace iptv_cloud {
+namespace utils {
+
+namespace {
+const uint32_t kShmRingMagic = 0x53524e47;  // SRNG
+const uint32_t kShmRingVersion = 2;
+const size_t kMaxReaders = 32;
+
+COMPILE_ASSERT(ATOMIC_LLONG_LOCK_FREE == 2, "Shared ring needs lock free 64 bit atomics");
+}  // namespace
+
+struct ShmRingReaderSlot {
+  std::atomic<int32_t> pid;  // 0 - free
+  std::atomic<uint64_t> position;
+  std::atomic<uint64_t> overruns;
+};
+
+struct ShmRingHeader {
+  std::atomic<uint32_t> magic;  // set last by writer
+  uint32_t version;
+  uint64_t capacity;
+  std::atomic<uint64_t> reserve_position;  // end of buffer being written
+  std::atomic<uint64_t> write_position;    // end of last complete buffer
+  std::atomic<int32_t> writer_pid;         // segment of dead writer can be replaced
+  std::atomic<uint32_t> write_seq;         // futex word, bumped by every write
+  std::atomic<uint32_t> waiters;           // readers sleeping on write_seq
+  ShmRingReaderSlot readers[kMaxReaders];
+
+  char* GetData() { return reinterpret_cast<char*>(this + 1); }
+};
+
+namespace {
+std::string MakeSegmentName(const std::string& name) {
+  return "/" + name;
+}
+
+size_t RoundUpPowerOfTwo(size_t value) {
+  size_t result = 1;
+  while (result < value) {
+    result <<= 1;
+  }
+  return result;
+}
+
+bool IsProcessAlive(int32_t pid) {
+  return kill(pid, 0) == 0 || errno != ESRCH;
+}
+
+// not private futex, word is shared between processes
+long Futex(std::atomic<uint32_t>* word, int op, uint32_t value, const struct timespec* timeout) {
+  COMPILE_ASSERT(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "Futex word must be plain 32 bit");
+  return syscall(SYS_futex, reinterpret_cast<uint32_t*>(word), op, value, timeout, nullptr, 0);
+}
+
+void WakeReaders(ShmRingHeader* header) {
+  header->write_seq.fetch_add(1, std::memory_order_seq_cst);
+  if (header->waiters.load(std::memory_order_seq_cst)) {
+    Futex(&header->write_seq, FUTEX_WAKE, INT_MAX, nullptr);
+  }
+}
+
+bool HasLiveWriter(const std::string& segment) {
+  int fd = shm_open(segment.c_str(), O_RDONLY, 0);
+  if (fd == INVALID_DESCRIPTOR) {
+    return false;
+  }
+
+  bool live = false;
+  struct stat st;
+  if (fstat(fd, &st) != -1 && static_cast<size_t>(st.st_size) >= sizeof(ShmRingHeader)) {
+    void* mem = mmap(nullptr, sizeof(ShmRingHeader), PROT_READ, MAP_SHARED, fd, 0);
+    if (mem != MAP_FAILED) {
+      const ShmRingHeader* header = static_cast<const ShmRingHeader*>(mem);
+      const int32_t pid = header->writer_pid.load(std::memory_order_acquire);
+      live = header->magic.load(std::memory_order_acquire) == kShmRingMagic && header->version == kShmRingVersion &&
+             pid && IsProcessAlive(pid);
+      munmap(mem, sizeof(ShmRingHeader));
+    }
+  }
+  close(fd);
+  return live;
+}
+}  // namespace
+
+ShmRingWriter::ShmRingWriter(const std::string& name)
+    : name_(name), fd_(INVALID_DESCRIPTOR), header_(nullptr), mapped_size_(0) {}
+
+ShmRingWriter::~ShmRingWriter() {
+  Close();
+}
+
+common::ErrnoError ShmRingWriter::Open(size_t capacity) {
+  if (IsOpened()) {
+    return common::make_errno_error("Shared ring already opened.", EINVAL);
+  }
+
+  if (name_.empty() || name_.find('/') != std::string::npos || !capacity) {
+    return common::make_errno_error_inval();
+  }
+
+  const std::string segment = MakeSegmentName(name_);
+  if (HasLiveWriter(segment)) {
+    return common::make_errno_error("Shared ring has live writer.", EEXIST);
+  }
+
+  // segment left by dead writer, its readers see it as stale and reopen
+  shm_unlink(segment.c_str());
+  int fd = shm_open(segment.c_str(), O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  const size_t ring_capacity = RoundUpPowerOfTwo(capacity);
+  const size_t mapped_size = sizeof(ShmRingHeader) + ring_capacity;
+  if (ftruncate(fd, mapped_size) == -1) {
+    const int err = errno;
+    close(fd);
+    shm_unlink(segment.c_str());
+    return common::make_errno_error(err);
+  }
+
+  void* mem = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    const int err = errno;
+    close(fd);
+    shm_unlink(segment.c_str());
+    return common::make_errno_error(err);
+  }
+
+  // ftruncate zeroed segment, atomics are valid as zero
+  ShmRingHeader* header = static_cast<ShmRingHeader*>(mem);
+  header->version = kShmRingVersion;
+  header->capacity = ring_capacity;
+  header->reserve_position.store(0, std::memory_order_relaxed);
+  header->write_position.store(0, std::memory_order_relaxed);
+  header->writer_pid.store(getpid(), std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  header->magic.store(kShmRingMagic, std::memory_order_release);
+
+  fd_ = fd;
+  header_ = header;
+  mapped_size_ = mapped_size;
+  return common::ErrnoError();
+}
+
+void ShmRingWriter::Close() {
+  if (!IsOpened()) {
+    return;
+  }
+
+  shm_unlink(MakeSegmentName(name_).c_str());
+  header_->writer_pid.store(0, std::memory_order_release);
+  WakeReaders(header_);  // sleeping readers check for stale segment sooner
+  munmap(header_, mapped_size_);
+  close(fd_);
+  fd_ = INVALID_DESCRIPTOR;
+  header_ = nullptr;
+  mapped_size_ = 0;
+}
+
+bool ShmRingWriter::IsOpened() const {
+  return header_ != nullptr;
+}
+
+bool ShmRingWriter::Write(const void* data, size_t size) {
+  if (!IsOpened() || size > header_->capacity) {
+    return false;
+  }
+
+  const uint64_t capacity = header_->capacity;
+  const uint64_t position = header_->write_position.load(std::memory_order_relaxed);
+  // seqlock style: readers validate copied bytes against reserve position
+  header_->reserve_position.store(position + size, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  const size_t offset = position & (capacity - 1);
+  const size_t first = std::min<size_t>(size, capacity - offset);
+  char* ring = header_->GetData();
+  memcpy(ring + offset, data, first);
+  if (first < size) {
+    memcpy(ring, static_cast<const char*>(data) + first, size - first);
+  }
+
+  header_->write_position.store(position + size, std::memory_order_release);
+  WakeReaders(header_);
+  return true;
+}
+
+ShmRingFanout ShmRingWriter::GetFanout() const {
+  ShmRingFanout fanout = {0, 0, 0, 0};
+  if (!IsOpened()) {
+    return fanout;
+  }
+
+  fanout.capacity = header_->capacity;
+  const uint64_t position = header_->write_position.load(std::memory_order_acquire);
+  for (size_t i = 0; i < kMaxReaders; ++i) {
+    ShmRingReaderSlot* slot = &header_->readers[i];
+    int32_t pid = slot->pid.load(std::memory_order_acquire);
+    if (!pid) {
+      continue;
+    }
+
+    if (!IsProcessAlive(pid)) {
+      slot->pid.compare_exchange_strong(pid, 0, std::memory_order_acq_rel);
+      continue;
+    }
+
+    const uint64_t reader_position = slot->position.load(std::memory_order_relaxed);
+    if (position > reader_position) {
+      fanout.max_lag_bytes = std::max<uint64_t>(fanout.max_lag_bytes, position - reader_position);
+    }
+    fanout.overruns += slot->overruns.load(std::memory_order_relaxed);
+    fanout.readers++;
+  }
+  return fanout;
+}
+
+ShmRingReader::ShmRingReader(const std::string& name)
+    : name_(name),
+      fd_(INVALID_DESCRIPTOR),
+      header_(nullptr),
+      mapped_size_(0),
+      inode_(0),
+      slot_(0),
+      position_(0),
+      overruns_(0) {}
+
+ShmRingReader::~ShmRingReader() {
+  Close();
+}
+
+common::ErrnoError ShmRingReader::Open() {
+  if (IsOpened()) {
+    return common::make_errno_error("Shared ring already opened.", EINVAL);
+  }
+
+  if (name_.empty() || name_.find('/') != std::string::npos) {
+    return common::make_errno_error_inval();
+  }
+
+  int fd = shm_open(MakeSegmentName(name_).c_str(), O_RDWR, 0);
+  if (fd == INVALID_DESCRIPTOR) {
+    return common::make_errno_error(errno);
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) == -1 || static_cast<size_t>(st.st_size) < sizeof(ShmRingHeader)) {
+    close(fd);
+    return common::make_errno_error("Shared ring not ready.", EAGAIN);
+  }
+
+  const size_t mapped_size = st.st_size;
+  void* mem = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mem == MAP_FAILED) {
+    const int err = errno;
+    close(fd);
+    return common::make_errno_error(err);
+  }
+
+  ShmRingHeader* header = static_cast<ShmRingHeader*>(mem);
+  if (header->magic.load(std::memory_order_acquire) != kShmRingMagic ||
+      header->version != kShmRingVersion || sizeof(ShmRingHeader) + header->capacity > mapped_size) {
+    munmap(mem, mapped_size);
+    close(fd);
+    return common::make_errno_error("Shared ring not ready.", EAGAIN);
+  }
+
+  const int32_t pid = getpid();
+  for (size_t i = 0; i < kMaxReaders; ++i) {
+    int32_t expected = 0;
+    if (header->readers[i].pid.compare_exchange_strong(expected, pid, std::memory_order_acq_rel)) {
+      fd_ = fd;
+      header_ = header;
+      mapped_size_ = mapped_size;
+      inode_ = st.st_ino;
+      slot_ = i;
+      header_->readers[slot_].overruns.store(0, std::memory_order_relaxed);
+      overruns_ = 0;
+      JumpToLiveEdge(false);
+      return common::ErrnoError();
+    }
+  }
+
+  munmap(mem, mapped_size);
+  close(fd);
+  return common::make_errno_error("Too many shared ring readers.", EBUSY);
+}
+
+void ShmRingReader::Close() {
+  if (!IsOpened()) {
+    return;
+  }
+
+  header_->readers[slot_].pid.store(0, std::memory_order_release);
+  munmap(header_, mapped_size_);
+  close(fd_);
+  fd_ = INVALID_DESCRIPTOR;
+  header_ = nullptr;
+  mapped_size_ = 0;
+}
+
+bool ShmRingReader::IsOpened() const {
+  return header_ != nullptr;
+}
+
+bool ShmRingReader::IsStale() const {
+  if (!IsOpened()) {
+    return false;
+  }
+
+  int fd = shm_open(MakeSegmentName(name_).c_str(), O_RDONLY, 0);
+  if (fd == INVALID_DESCRIPTOR) {
+    return true;
+  }
+
+  struct stat st;
+  const bool replaced = fstat(fd, &st) == -1 || st.st_ino != inode_;
+  close(fd);
+  return replaced;
+}
+
+size_t ShmRingReader::Read(void* data, size_t size) {
+  if (!IsOpened() || !size) {
+    return 0;
+  }
+
+  const uint64_t capacity = header_->capacity;
+  const uint64_t position = header_->write_position.load(std::memory_order_acquire);
+  if (position == position_) {
+    return 0;
+  }
+
+  if (position - position_ > capacity) {
+    JumpToLiveEdge(true);
+    return 0;
+  }
+
+  const size_t count = std::min<uint64_t>(size, position - position_);
+  const size_t offset = position_ & (capacity - 1);
+  const size_t first = std::min<size_t>(count, capacity - offset);
+  const char* ring = header_->GetData();
+  memcpy(data, ring + offset, first);
+  if (first < count) {
+    memcpy(static_cast<char*>(data) + first, ring, count - first);
+  }
+
+  // writer could overwrite copied bytes meanwhile
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (header_->reserve_position.load(std::memory_order_relaxed) - position_ > capacity) {
+    JumpToLiveEdge(true);
+    return 0;
+  }
+
+  position_ += count;
+  header_->readers[slot_].position.store(position_, std::memory_order_relaxed);
+  return count;
+}
+
+bool ShmRingReader::Wait(uint32_t timeout_msec) {
+  if (!IsOpened()) {
+    return false;
+  }
+
+  // waiters counted before seq is read, so writer either sees waiter or changes seq before futex wait
+  header_->waiters.fetch_add(1, std::memory_order_seq_cst);
+  const uint32_t seq = header_->write_seq.load(std::memory_order_seq_cst);
+  if (header_->write_position.load(std::memory_order_acquire) == position_) {
+    const struct timespec timeout = {static_cast<time_t>(timeout_msec / 1000),
+                                     static_cast<long>(timeout_msec % 1000) * 1000000};
+    Futex(&header_->write_seq, FUTEX_WAIT, seq, &timeout);
+  }
+  header_->waiters.fetch_sub(1, std::memory_order_seq_cst);
+  return header_->write_position.load(std::memory_order_acquire) != position_;
+}
+
+uint64_t ShmRingReader::GetOverruns() const {
+  return overruns_;
+}
+
+void ShmRingReader::JumpToLiveEdge(bool lapped) {
+  if (lapped) {
+    overruns_++;
+    header_->readers[slot_].overruns.store(overruns_, std::memory_order_relaxed);
+  }
+  position_ = header_->write_position.load(std::memory_order_acquire);
+  header_->readers[slot_].position.store(position_, std::memory_order_relaxed);
+}
+
+}  // namespace utils
+}  // namespace iptv_cloud
@@ -0,0 +1,105 @@
+/*  Copyright (C) 2014-2019 FastoGT. All right reserved.
+    This file is part of iptv_cloud.
+    iptv_cloud is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+    iptv_cloud is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+    You should have received a copy of the GNU General Public License
+    along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include <sys/types.h>
+
+#include <atomic>
+#include <string>
+
+#include <common/error.h>
+#include <common/macros.h>
+
+namespace iptv_cloud {
+namespace utils {
+
+// readers of ShmRingWriter, filled only for shm:// outputs
+struct ShmRingFanout {
+  uint64_t capacity;
+  uint32_t readers;
+  uint64_t max_lag_bytes;  // bytes behind writer of the slowest reader
+  uint64_t overruns;       // times readers were lapped and jumped to live edge
+};
+
+struct ShmRingHeader;
+
+// single writer, many readers byte ring in posix shared memory for chaining streams of one node:
+// writer never waits, readers follow write position without locks and jump to the live edge
+// when writer laps them. Writer puts whole muxed buffers, so after a jump readers stay on packet boundary.
+// Idle readers sleep on a futex in the segment, writer wakes them only when someone sleeps.
+class ShmRingWriter {
+ public:
+  enum : size_t { DEFAULT_CAPACITY = 8 * 1024 * 1024 };
+
+  explicit ShmRingWriter(const std::string& name);  // name without slashes
+  ~ShmRingWriter();
+
+  // capacity is rounded up to power of two, EEXIST while other writer of the name is alive,
+  // segment left by dead writer is replaced
+  common::ErrnoError Open(size_t capacity = DEFAULT_CAPACITY) WARN_UNUSED_RESULT;
+  // unlinks segment, attached readers notice it by IsStale
+  void Close();
+  bool IsOpened() const;
+
+  // false if buffer bigger than ring
+  bool Write(const void* data, size_t size);
+
+  // also releases slots of dead reader processes
+  ShmRingFanout GetFanout() const;
+
+ private:
+  const std::string name_;
+  int fd_;
+  ShmRingHeader* header_;
+  size_t mapped_size_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShmRingWriter);
+};
+
+class ShmRingReader {
+ public:
+  explicit ShmRingReader(const std::string& name);
+  ~ShmRingReader();
+
+  // starts from live edge, fails if writer not opened yet or all reader slots taken
+  common::ErrnoError Open() WARN_UNUSED_RESULT;
+  void Close();
+  bool IsOpened() const;
+  // writer closed or replaced segment, reader should reopen
+  bool IsStale() const;
+
+  // copies up to size bytes, 0 if nothing new or reader was lapped
+  size_t Read(void* data, size_t size);
+  // sleeps till writer writes or closes, false on timeout without new data
+  bool Wait(uint32_t timeout_msec);
+  uint64_t GetOverruns() const;
+
+ private:
+  void JumpToLiveEdge(bool lapped);
+
+  const std::string name_;
+  int fd_;
+  ShmRingHeader* header_;
+  size_t mapped_size_;
+  ino_t inode_;
+  size_t slot_;
+  uint64_t position_;
+  uint64_t overruns_;
+
+  DISALLOW_COPY_AND_ASSIGN(ShmRingReader);
+};
+
+}  // namespace utils
+}  // namespace iptv_cloud
@@ -12,11 +12,46 @@
     along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
 
+#include "base/config_fields.h"
 #include "base/constants.h"
+#include "base/gst_constants.h"
+#include "base/stream_config.h"
 
+#include "server/child_table.h"
+#include "server/cpu_placement.h"
+#include "server/daemon/commands.h"
+#include "server/daemon/commands_info/service/sync_delta_info.h"
+#include "server/daemon/commands_info/stream/quit_status_info.h"
+#include "server/input_broker.h"
+#include "server/log_uploader.h"
+#include "server/metrics_registry.h"
 #include "server/options/options.h"
+#include "server/pipe/pipe_client.h"
+#include "server/relay/relay_engine.h"
+#include "server/restart_scheduler.h"
+#include "server/stream_history.h"
+#include "server/sync_finder.h"
+#include "server/vods/vods_cache.h"
 #include "utils/arg_converter.h"
 
 #define LOGO_FIELD "logo"
@@ -28,6 +63,32 @@ const char kTimeshiftRecorderConfig[] = R"({
     "output" : {"urls" : [ {"id" : 80, "timeshift_dir" : "/var/www/html/live/14"} ]},
     "type" : 3
   })";
+
+const char kEncodeConfig[] = R"({
+    "id" : "test_2",
+    "type" : 2,
+    "feedback_directory" : "/tmp/test_2",
+    "input" : {"urls" : [ {"id" : 1, "uri" : "udp://239.0.0.1:5000"}, {"id" : 2, "uri" : "udp://239.0.0.2:5000"} ]},
+    "output" : {"urls" : [ {"id" : 80, "uri" : "udp://239.0.1.1:5000"} ]},
+    "video_codec" : "x264enc",
+    "audio_codec" : "faac",
+    "volume" : 1.0,
+    "video_bitrate" : 4000,
+    "x264enc.speed-preset" : 1,
+    "x264enc.threads" : 4,
+    "x264enc.key-int-max" : 50
+  })";
+
+const size_t kIngestStreamsCount = 500;
+
+iptv_cloud::StreamConfig MakeRelayConfig(const std::string& sid, const std::string& input) {
+  iptv_cloud::StreamConfig config;
+  config.id = sid;
+  config.type = iptv_cloud::RELAY;
+  config.input.push_back(iptv_cloud::InputUri(1, common::uri::Url(input)));
+  config.output.push_back(iptv_cloud::OutputUri(80, common::uri::Url("udp://239.0.1.1:5000")));
+  return config;
+}
 }
 
 TEST(Options, logo_path) {
@@ -44,3 +105,1051 @@ TEST(Options, cfgs) {
   auto args = iptv_cloud::server::options::ValidateConfig(kTimeshiftRecorderConfig);
   ASSERT_EQ(args.size(), 4);
 }
+
+TEST(Options, stream_config) {
+  iptv_cloud::StreamConfig config;
+  common::Error err = iptv_cloud::server::options::ParseStreamConfig(kEncodeConfig, &config);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(config.id, "test_2");
+  ASSERT_EQ(config.type, iptv_cloud::ENCODE);
+  ASSERT_EQ(config.input.size(), 2);
+  ASSERT_EQ(config.output.size(), 1);
+
+  iptv_cloud::StreamConfig legacy;
+  ASSERT_TRUE(iptv_cloud::MakeStreamConfig(iptv_cloud::server::options::ValidateConfig(kEncodeConfig), &legacy));
+  ASSERT_EQ(config.id, legacy.id);
+  ASSERT_EQ(config.type, legacy.type);
+  ASSERT_EQ(config.feedback_dir, legacy.feedback_dir);
+  ASSERT_EQ(config.input.size(), legacy.input.size());
+  ASSERT_EQ(config.output.size(), legacy.output.size());
+  ASSERT_EQ(config.args, legacy.args);
+
+  err = iptv_cloud::server::options::ParseStreamConfig("{\"type\" : 1}", &config);
+  ASSERT_TRUE(err);
+
+  const std::string input = "\"" INPUT_FIELD "\" : {\"urls\" : [{\"id\" : 1, \"uri\" : \"udp://239.0.0.1:5000\"}]}";
+  const std::string output = "\"" OUTPUT_FIELD "\" : {\"urls\" : [{\"id\" : 80, \"uri\" : \"udp://239.0.1.1:5000\"}]}";
+  const std::string encode = "{\"id\" : \"test_3\", \"type\" : 2, ";
+  err = iptv_cloud::server::options::ParseStreamConfig(encode + output + "}", &config);
+  ASSERT_TRUE(err);
+  err = iptv_cloud::server::options::ParseStreamConfig(encode + input + "}", &config);
+  ASSERT_TRUE(err);
+  err = iptv_cloud::server::options::ParseStreamConfig(encode + input + ", \"" OUTPUT_FIELD "\" : 1}", &config);
+  ASSERT_TRUE(err);
+  err = iptv_cloud::server::options::ParseStreamConfig(encode + input + ", " + output + "}", &config);
+  ASSERT_FALSE(err);
+
+  // timeshift recorder and catchup have no outputs
+  err = iptv_cloud::server::options::ParseStreamConfig("{\"id\" : \"test_4\", \"type\" : 4, " + input + "}", &config);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(config.type, iptv_cloud::TIMESHIFT_RECORDER);
+}
+
+TEST(Options, DISABLED_stream_config_ingest_benchmark) {
+  typedef std::chrono::steady_clock clock_t;
+  const auto legacy_start = clock_t::now();
+  for (size_t i = 0; i < kIngestStreamsCount; ++i) {
+    iptv_cloud::utils::ArgsMap args = iptv_cloud::server::options::ValidateConfig(kEncodeConfig);
+    iptv_cloud::input_t input;
+    iptv_cloud::output_t output;
+    ASSERT_TRUE(iptv_cloud::read_input(args, &input));
+    ASSERT_TRUE(iptv_cloud::read_output(args, &output));
+  }
+  const auto legacy_time = std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - legacy_start);
+
+  const auto typed_start = clock_t::now();
+  for (size_t i = 0; i < kIngestStreamsCount; ++i) {
+    iptv_cloud::StreamConfig config;
+    common::Error err = iptv_cloud::server::options::ParseStreamConfig(kEncodeConfig, &config);
+    ASSERT_FALSE(err);
+  }
+  const auto typed_time = std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - typed_start);
+
+  std::cout << kIngestStreamsCount << " configs, ArgsMap: " << legacy_time.count()
+            << " us, StreamConfig: " << typed_time.count() << " us" << std::endl;
+}
+
+TEST(RestartScheduler, upstream_group) {
+  iptv_cloud::server::RestartScheduler scheduler(2, 1);
+  const std::string cdn = "cdn.example.com:80";
+  for (size_t i = 0; i < 5; ++i) {
+    scheduler.ScheduleRestart("cdn_" + std::to_string(i), cdn, 0);
+  }
+  scheduler.ScheduleRestart("file_0", std::string(), 0);
+  ASSERT_EQ(scheduler.GetWaitingCount(), 6);
+  ASSERT_TRUE(scheduler.CollectReady(0).empty());
+
+  // one probe per group after back-off
+  auto ready = scheduler.CollectReady(iptv_cloud::server::RestartScheduler::base_delay_msec);
+  ASSERT_EQ(ready.size(), 2);
+  ASSERT_EQ(scheduler.GetStartingCount(), 2);
+  std::string probe;
+  for (const auto& sid : ready) {
+    if (sid != "file_0") {
+      probe = sid;
+    }
+  }
+  ASSERT_FALSE(probe.empty());
+  scheduler.OnStreamStarted("file_0", 1000);
+
+  // failed probe doubles back-off for whole group
+  scheduler.ScheduleRestart(probe, cdn, 1000);
+  ASSERT_EQ(scheduler.GetStartingCount(), 0);
+  ASSERT_TRUE(scheduler.CollectReady(1000 + iptv_cloud::server::RestartScheduler::base_delay_msec - 1).empty());
+  ready = scheduler.CollectReady(1000 + 2 * iptv_cloud::server::RestartScheduler::base_delay_msec);
+  ASSERT_EQ(ready.size(), 1);
+
+  // recovered, rest of group restarts within budget
+  scheduler.OnStreamStarted(ready[0], 3000);
+  ready = scheduler.CollectReady(3000);
+  ASSERT_EQ(ready.size(), 2);
+  ASSERT_TRUE(scheduler.CollectReady(3000).empty());
+  for (const auto& sid : ready) {
+    scheduler.OnStreamStarted(sid, 4000);
+  }
+  ASSERT_EQ(scheduler.CollectReady(4000).size(), 2);
+  ASSERT_EQ(scheduler.GetWaitingCount(), 0);
+}
+
+TEST(RestartScheduler, startup_timeout) {
+  iptv_cloud::server::RestartScheduler scheduler(1, 1);
+  scheduler.ScheduleRestart("test_1", "host:80", 0);
+  scheduler.ScheduleRestart("test_2", "host:80", 0);
+  const auto ready = scheduler.CollectReady(iptv_cloud::server::RestartScheduler::base_delay_msec);
+  ASSERT_EQ(ready.size(), 1);
+  ASSERT_TRUE(scheduler.IsStarting(ready[0]));
+
+  // probe did not start in time, slot released and group backs off again
+  const fastotv::timestamp_t timeout =
+      iptv_cloud::server::RestartScheduler::base_delay_msec + iptv_cloud::server::RestartScheduler::startup_timeout_msec;
+  ASSERT_TRUE(scheduler.CollectReady(timeout).empty());
+  ASSERT_FALSE(scheduler.IsStarting(ready[0]));
+  ASSERT_EQ(scheduler.GetStartingCount(), 0);
+  ASSERT_EQ(scheduler.GetWaitingCount(), 1);
+
+  scheduler.RemoveStream("test_1");
+  scheduler.RemoveStream("test_2");
+  ASSERT_EQ(scheduler.GetWaitingCount(), 0);
+}
+
+TEST(VodsCache, states) {
+  iptv_cloud::StreamConfig config;
+  common::Error err = iptv_cloud::server::options::ParseStreamConfig(kEncodeConfig, &config);
+  ASSERT_FALSE(err);
+
+  iptv_cloud::server::VodsCache cache;
+  const iptv_cloud::server::VodsCache::http_root_t root("/var/www/html/vods/test_2/");
+  cache.AddVod(root, config);
+  ASSERT_TRUE(cache.IsVodStream(config.id));
+  ASSERT_FALSE(cache.IsComplete(root));
+
+  iptv_cloud::StreamConfig found;
+  iptv_cloud::server::VodsCache::VodState state;
+  ASSERT_TRUE(cache.FindVod(root, &found, &state));
+  ASSERT_EQ(state, iptv_cloud::server::VodsCache::ABSENT);
+  ASSERT_FALSE(cache.IsPending(root));  // nothing runs, requests are not held
+
+  cache.SetStreamState(config.id, iptv_cloud::server::VodsCache::IN_PROGRESS);
+  ASSERT_EQ(cache.GetStats().in_progress, 1);
+  ASSERT_TRUE(cache.IsPending(root));
+  cache.SetRootState(root, iptv_cloud::server::VodsCache::COMPLETE);
+  ASSERT_TRUE(cache.IsComplete(root));
+  ASSERT_FALSE(cache.IsPending(root));
+
+  cache.ResetCompleted();
+  ASSERT_FALSE(cache.IsComplete(root));
+  ASSERT_FALSE(cache.IsPending(root));
+  ASSERT_EQ(cache.GetStats().absent, 1);
+
+  cache.RemoveStream(config.id);
+  ASSERT_FALSE(cache.FindVod(root, &found, &state));
+}
+
+TEST(VodsCache, cold_request_held) {
+  iptv_cloud::StreamConfig config;
+  common::Error err = iptv_cloud::server::options::ParseStreamConfig(kEncodeConfig, &config);
+  ASSERT_FALSE(err);
+
+  iptv_cloud::server::VodsCache cache;
+  const iptv_cloud::server::VodsCache::http_root_t root("/var/www/html/vods/test_2/");
+  const iptv_cloud::server::VodsCache::http_root_t unknown("/var/www/html/vods/unknown/");
+  cache.AddVod(root, config);
+  ASSERT_FALSE(cache.MarkRequested(unknown));
+  ASSERT_FALSE(cache.IsPending(unknown));
+
+  // first request marks vod before loop starts transcode, so handler holds it
+  ASSERT_TRUE(cache.MarkRequested(root));
+  ASSERT_TRUE(cache.IsPending(root));
+  ASSERT_FALSE(cache.MarkRequested(root));  // next requests don't start transcode again
+
+  // loop started child, transcode finished with full playlist, held request is served
+  cache.SetStreamState(config.id, iptv_cloud::server::VodsCache::IN_PROGRESS);
+  ASSERT_TRUE(cache.IsPending(root));
+  cache.SetStreamState(config.id, iptv_cloud::server::VodsCache::ABSENT);
+  cache.SetRootState(root, iptv_cloud::server::VodsCache::COMPLETE);
+  ASSERT_FALSE(cache.IsPending(root));
+  ASSERT_TRUE(cache.IsComplete(root));
+  ASSERT_FALSE(cache.MarkRequested(root));
+}
+
+TEST(SyncDeltaInfo, serialize) {
+  iptv_cloud::server::service::SyncDeltaInfo delta(1, 2);
+  delta.SetAddedStreams({kEncodeConfig});
+  delta.SetUpdatedStreams({kTimeshiftRecorderConfig});
+  delta.SetRemovedStreams({"test_0"});
+  delta.SetAddedUsers({"{}"});
+  delta.SetRemovedUsers({"user_0"});
+
+  std::string delta_str;
+  common::Error err = delta.SerializeToString(&delta_str);
+  ASSERT_FALSE(err);
+
+  iptv_cloud::server::service::SyncDeltaInfo ldelta;
+  err = ldelta.DeSerializeFromString(delta_str);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(ldelta.GetBaseVersion(), 1);
+  ASSERT_EQ(ldelta.GetVersion(), 2);
+  ASSERT_EQ(ldelta.GetAddedStreams(), delta.GetAddedStreams());
+  ASSERT_EQ(ldelta.GetUpdatedStreams(), delta.GetUpdatedStreams());
+  ASSERT_EQ(ldelta.GetRemovedStreams(), delta.GetRemovedStreams());
+  ASSERT_EQ(ldelta.GetAddedUsers(), delta.GetAddedUsers());
+  ASSERT_TRUE(ldelta.GetUpdatedUsers().empty());
+  ASSERT_EQ(ldelta.GetRemovedUsers(), delta.GetRemovedUsers());
+
+  // lists are optional, version must move forward
+  err = ldelta.DeSerializeFromString("{\"base_version\" : 2, \"version\" : 3}");
+  ASSERT_FALSE(err);
+  ASSERT_TRUE(ldelta.GetAddedStreams().empty());
+  ASSERT_TRUE(ldelta.GetRemovedUsers().empty());
+  err = ldelta.DeSerializeFromString("{\"base_version\" : 3, \"version\" : 3}");
+  ASSERT_TRUE(err);
+  err = ldelta.DeSerializeFromString("{\"version\" : 4}");
+  ASSERT_TRUE(err);
+  ASSERT_EQ(ldelta.GetVersion(), 3);
+
+  iptv_cloud::server::service::SyncAckInfo ack(ldelta.GetVersion());
+  std::string ack_str;
+  err = ack.SerializeToString(&ack_str);
+  ASSERT_FALSE(err);
+  iptv_cloud::server::service::SyncAckInfo lack;
+  err = lack.DeSerializeFromString(ack_str);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(lack.GetVersion(), 3);
+
+  iptv_cloud::server::service::SyncInfo sync;
+  err = sync.DeSerializeFromString("{\"streams\" : [], \"subscribers\" : []}");
+  ASSERT_FALSE(err);
+  ASSERT_EQ(sync.GetVersion(), 0);  // not versioned
+  err = sync.DeSerializeFromString("{\"version\" : 5, \"streams\" : [], \"subscribers\" : []}");
+  ASSERT_FALSE(err);
+  ASSERT_EQ(sync.GetVersion(), 5);
+}
+
+TEST(SyncDeltaInfo, apply_users) {
+  typedef iptv_cloud::server::SyncFinder::user_t user_t;
+  auto make_user = [](const std::string& uid, const std::string& password,
+                      iptv_cloud::server::subscribers::commands_info::Status state) {
+    return user_t(uid, "user_" + uid, password, fastotv::commands_info::ChannelsInfo(), user_t::devices_t(), state);
+  };
+  iptv_cloud::server::SyncFinder finder;
+  finder.AddUser(make_user("1", "pass", iptv_cloud::server::subscribers::commands_info::ACTIVE));
+  finder.AddUser(make_user("2", "pass", iptv_cloud::server::subscribers::commands_info::ACTIVE));
+
+  std::string updated_str;
+  const user_t updated = make_user("1", "new_pass", iptv_cloud::server::subscribers::commands_info::BANNED);
+  common::Error err = updated.SerializeToString(&updated_str);
+  ASSERT_FALSE(err);
+  std::string added_str;
+  err = make_user("3", "pass", iptv_cloud::server::subscribers::commands_info::ACTIVE).SerializeToString(&added_str);
+  ASSERT_FALSE(err);
+
+  iptv_cloud::server::service::SyncDeltaInfo delta(1, 2);
+  delta.SetAddedUsers({added_str});
+  delta.SetUpdatedUsers({updated_str});
+  delta.SetRemovedUsers({"user_2"});
+  std::string delta_str;
+  err = delta.SerializeToString(&delta_str);
+  ASSERT_FALSE(err);
+
+  // same order as service applies sync_service_delta
+  iptv_cloud::server::service::SyncDeltaInfo ldelta;
+  err = ldelta.DeSerializeFromString(delta_str);
+  ASSERT_FALSE(err);
+  for (const fastotv::login_t& login : ldelta.GetRemovedUsers()) {
+    finder.RemoveUser(login);
+  }
+  for (const std::string& user : ldelta.GetAddedUsers()) {
+    user_t uinf;
+    ASSERT_FALSE(uinf.DeSerializeFromString(user));
+    finder.UpdateUser(uinf);
+  }
+  for (const std::string& user : ldelta.GetUpdatedUsers()) {
+    user_t uinf;
+    ASSERT_FALSE(uinf.DeSerializeFromString(user));
+    finder.UpdateUser(uinf);
+  }
+
+  user_t found;
+  err = finder.FindUser(fastotv::commands_info::AuthInfo("user_1", "new_pass", "device"), &found);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(found.GetPassword(), "new_pass");
+  ASSERT_TRUE(found.IsBanned());
+  err = finder.FindUser(fastotv::commands_info::AuthInfo("user_2", "pass", "device"), &found);
+  ASSERT_TRUE(err);
+  err = finder.FindUser(fastotv::commands_info::AuthInfo("user_3", "pass", "device"), &found);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(found.GetUserID(), "3");
+}
+
+namespace {
+int ListenLoopback(uint16_t* port) {
+  int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+  if (fd == -1) {
+    return -1;
+  }
+
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t len = sizeof(addr);
+  if (bind(fd, reinterpret_cast<struct sockaddr*>(&addr), len) != 0 || listen(fd, 4) != 0 ||
+      getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len) != 0) {
+    close(fd);
+    return -1;
+  }
+  *port = ntohs(addr.sin_port);
+  return fd;
+}
+
+// false till terminating chunk received
+bool ParseChunkedRequest(const std::string& request, std::string* body, std::vector<size_t>* chunks) {
+  size_t pos = request.find("\r\n\r\n");
+  if (pos == std::string::npos) {
+    return false;
+  }
+
+  pos += 4;
+  body->clear();
+  chunks->clear();
+  while (true) {
+    const size_t line_end = request.find("\r\n", pos);
+    if (line_end == std::string::npos) {
+      return false;
+    }
+    const size_t size = strtoul(request.c_str() + pos, nullptr, 16);
+    if (size == 0) {
+      return request.size() >= line_end + 4;
+    }
+    if (request.size() < line_end + 2 + size + 2) {
+      return false;
+    }
+    body->append(request, line_end + 2, size);
+    chunks->push_back(size);
+    pos = line_end + 2 + size + 2;
+  }
+}
+
+// accepts one upload and answers 200
+std::string ServeUpload(int listener, std::string* body, std::vector<size_t>* chunks) {
+  int fd = accept(listener, nullptr, nullptr);
+  if (fd == -1) {
+    return std::string();
+  }
+
+  std::string request;
+  char buff[4096];
+  while (!ParseChunkedRequest(request, body, chunks)) {
+    ssize_t nread = recv(fd, buff, sizeof(buff), 0);
+    if (nread <= 0) {
+      break;
+    }
+    request.append(buff, nread);
+  }
+
+  const char responce[] = "HTTP/1.1 200 OK\r\nContent-Length: 0\r\n\r\n";
+  ignore_result(send(fd, responce, sizeof(responce) - 1, MSG_NOSIGNAL));
+  close(fd);
+  return request;
+}
+
+std::string Gunzip(const std::string& data) {
+  z_stream zs;
+  memset(&zs, 0, sizeof(zs));
+  if (inflateInit2(&zs, 15 + 16) != Z_OK) {
+    return std::string();
+  }
+
+  zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+  zs.avail_in = data.size();
+  std::string out;
+  char buff[4096];
+  int res = Z_OK;
+  while (res == Z_OK) {
+    zs.next_out = reinterpret_cast<Bytef*>(buff);
+    zs.avail_out = sizeof(buff);
+    res = inflate(&zs, Z_NO_FLUSH);
+    out.append(buff, sizeof(buff) - zs.avail_out);
+  }
+  inflateEnd(&zs);
+  return res == Z_STREAM_END ? out : std::string();
+}
+
+std::string WriteTempFile(const std::string& content) {
+  char path[] = "/tmp/log_uploader_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd == -1) {
+    return std::string();
+  }
+  ssize_t nwrite = write(fd, content.data(), content.size());
+  close(fd);
+  return nwrite == static_cast<ssize_t>(content.size()) ? path : std::string();
+}
+}  // namespace
+
+TEST(LogUploader, gzip_chunked_body) {
+  std::string content;
+  srand(1);
+  for (size_t i = 0; i < 4 * iptv_cloud::server::LogUploader::chunk_size; ++i) {
+    content.push_back(static_cast<char>(rand()));  // incompressible, deflate output spans many chunks
+  }
+  const std::string path = WriteTempFile(content);
+  ASSERT_FALSE(path.empty());
+  uint16_t port = 0;
+  int listener = ListenLoopback(&port);
+  ASSERT_NE(listener, -1);
+
+  std::string whole_body, tail_body;
+  std::vector<size_t> whole_chunks, tail_chunks;
+  std::string whole_request, tail_request;
+  std::thread server([&]() {
+    whole_request = ServeUpload(listener, &whole_body, &whole_chunks);
+    tail_request = ServeUpload(listener, &tail_body, &tail_chunks);
+  });
+  const iptv_cloud::server::LogUploader::file_path_t file(path);
+  const common::net::HostAndPort host("127.0.0.1", port);
+  common::Error err = iptv_cloud::server::LogUploader::UploadFile(file, host, "/logs/test_1", 0);
+  ASSERT_FALSE(err);
+  err = iptv_cloud::server::LogUploader::UploadFile(file, host, "/logs/test_1", 1000);
+  ASSERT_FALSE(err);
+  server.join();
+  close(listener);
+  unlink(path.c_str());
+
+  ASSERT_EQ(whole_request.compare(0, 28, "POST /logs/test_1 HTTP/1.1\r\n"), 0);
+  ASSERT_NE(whole_request.find("Content-Encoding: gzip\r\n"), std::string::npos);
+  ASSERT_NE(whole_request.find("Transfer-Encoding: chunked\r\n"), std::string::npos);
+  ASSERT_GT(whole_chunks.size(), 1u);
+  for (size_t chunk : whole_chunks) {
+    ASSERT_LE(chunk, static_cast<size_t>(iptv_cloud::server::LogUploader::chunk_size));
+  }
+  ASSERT_TRUE(Gunzip(whole_body) == content);
+  ASSERT_TRUE(Gunzip(tail_body) == content.substr(content.size() - 1000));
+}
+
+TEST(LogUploader, queue_full_and_stop) {
+  const std::string path = WriteTempFile("log line\n");
+  ASSERT_FALSE(path.empty());
+  uint16_t port = 0;
+  int listener = ListenLoopback(&port);  // never accepts, upload hangs waiting for status
+  ASSERT_NE(listener, -1);
+
+  std::mutex errors_mutex;
+  std::vector<common::Error> errors;
+  auto done = [&errors_mutex, &errors](common::Error err) {
+    std::unique_lock<std::mutex> lock(errors_mutex);
+    errors.push_back(err);
+  };
+  const iptv_cloud::server::LogUploader::file_path_t file(path);
+  const common::net::HostAndPort host("127.0.0.1", port);
+  iptv_cloud::server::LogUploader uploader(1, 1);
+  common::ErrnoError errn = uploader.Post(file, host, "/", 0, done);
+  ASSERT_TRUE(errn);  // not started
+  ASSERT_EQ(errn->GetErrorCode(), EINVAL);
+
+  uploader.Start();
+  errn = uploader.Post(file, host, "/", 0, done);
+  ASSERT_FALSE(errn);
+  for (size_t i = 0; i < 500 && uploader.GetPendingCount(); ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  ASSERT_EQ(uploader.GetPendingCount(), 0u);  // taken by the worker
+  errn = uploader.Post(file, host, "/", 0, done);
+  ASSERT_FALSE(errn);
+  errn = uploader.Post(file, host, "/", 0, done);
+  ASSERT_TRUE(errn);
+  ASSERT_EQ(errn->GetErrorCode(), EAGAIN);
+
+  auto start = std::chrono::steady_clock::now();
+  uploader.Stop();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+  ASSERT_LT(elapsed, std::chrono::seconds(iptv_cloud::server::LogUploader::io_timeout_sec / 2));
+  ASSERT_EQ(errors.size(), 2u);  // running upload canceled, queued one dropped
+  ASSERT_TRUE(errors[0]);
+  ASSERT_TRUE(errors[1]);
+  close(listener);
+  unlink(path.c_str());
+}
+
+namespace {
+const size_t kMetricsStreamsCount = 500;
+
+std::string RenderMetrics(iptv_cloud::server::MetricsRegistry* metrics) {
+  size_t size = 0;
+  const char* text = metrics->Render(&size);
+  return std::string(text, size);
+}
+
+iptv_cloud::StreamStruct MakeMetricsStream(size_t i) {
+  iptv_cloud::ChannelStats in(i);
+  in.SetTotalBytes(1000000 + i);
+  in.SetBps(500000);
+  iptv_cloud::ChannelStats out(i);
+  out.SetTotalBytes(2000000 + i);
+  out.SetBps(400000);
+  return iptv_cloud::StreamStruct("stream_" + std::to_string(i), iptv_cloud::ENCODE, iptv_cloud::PLAYING, {in}, {out},
+                                  0, 0, i % 3);
+}
+}  // namespace
+
+TEST(MetricsRegistry, render) {
+  iptv_cloud::server::MetricsRegistry metrics;
+  ASSERT_EQ(RenderMetrics(&metrics).find("iptv_stream_status{"), std::string::npos);
+
+  metrics.UpdateStream(MakeMetricsStream(7), 12.5, 4096);
+  iptv_cloud::StreamStruct quoted = MakeMetricsStream(8);
+  quoted.id = "a\"b";
+  metrics.UpdateStream(quoted, 1, 1);
+  iptv_cloud::server::OnlineMetrics online = {1, 25, 2, 3};
+  metrics.SetOnline(online);
+  ASSERT_EQ(RenderMetrics(&metrics).find("iptv_stream_status{"), std::string::npos);  // not published yet
+
+  metrics.Publish(5000);
+  const std::string text = RenderMetrics(&metrics);
+  ASSERT_NE(text.find("iptv_online_clients{server=\"http\"} 25\n"), std::string::npos);
+  ASSERT_NE(text.find("iptv_online_clients{server=\"subscribers\"} 3\n"), std::string::npos);
+  ASSERT_NE(text.find("iptv_streams 2\n"), std::string::npos);
+  ASSERT_NE(text.find("iptv_stream_status{stream=\"stream_7\"} 4\n"), std::string::npos);
+  ASSERT_NE(text.find("iptv_stream_restarts_total{stream=\"stream_7\"} 1\n"), std::string::npos);
+  ASSERT_NE(text.find("iptv_stream_cpu_load{stream=\"stream_7\"} 12.500\n"), std::string::npos);
+  ASSERT_NE(text.find("iptv_stream_rss_bytes{stream=\"stream_7\"} 4096\n"), std::string::npos);
+  ASSERT_NE(text.find("iptv_stream_input_bytes_total{stream=\"stream_7\",channel=\"7\"} 1000007\n"), std::string::npos);
+  ASSERT_NE(text.find("iptv_stream_output_bytes_per_second{stream=\"stream_7\",channel=\"7\"} 400000\n"),
+            std::string::npos);
+  ASSERT_NE(text.find("iptv_stream_status{stream=\"a\\\"b\"} 4\n"), std::string::npos);
+
+  metrics.RemoveStream("stream_7");
+  metrics.Publish(6000);
+  ASSERT_EQ(RenderMetrics(&metrics).find("stream_7"), std::string::npos);
+}
+
+TEST(MetricsRegistry, DISABLED_scrape_benchmark) {
+  typedef std::chrono::steady_clock clock_t;
+  iptv_cloud::server::MetricsRegistry metrics;
+  for (size_t i = 0; i < kMetricsStreamsCount; ++i) {
+    metrics.UpdateStream(MakeMetricsStream(i), 3.5, 64 * 1024 * 1024);
+  }
+  metrics.Publish(1000);
+  size_t text_size = 0;
+  metrics.Render(&text_size);
+
+  const size_t scrapes = 100;
+  const auto start = clock_t::now();
+  for (size_t i = 0; i < scrapes; ++i) {
+    metrics.Publish(1000 + i);
+    metrics.Render(&text_size);
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(clock_t::now() - start);
+
+  std::cout << kMetricsStreamsCount << " streams, publish + render: " << elapsed.count() / scrapes << " us, "
+            << text_size << " bytes" << std::endl;
+}
+
+TEST(StreamHistory, encode_query) {
+  iptv_cloud::server::StreamHistory history;
+  iptv_cloud::server::StreamHistory::Sample sample = {500000, 400000, iptv_cloud::PLAYING, 0};
+  const time_t start = 1557000000;
+  for (time_t t = start; t < start + 150; ++t) {
+    sample.input_bps = 500000 + (t % 7) * 1000;
+    sample.output_bps = 400000 - (t % 5) * 1000;
+    if (t == start + 70) {
+      sample.status = iptv_cloud::FROZEN;
+      sample.restarts = 1;
+    }
+    history.Append(t, sample);
+  }
+  history.Append(start + 149, sample);  // same second
+  history.Append(start + 200, sample);  // gap
+  ASSERT_EQ(history.GetSamplesCount(), 151u);
+  ASSERT_EQ(history.GetLastTime(), start + 200);
+
+  std::vector<iptv_cloud::server::stream::HistoryRun> runs;
+  history.Query(start + 60, start + 300, &runs);
+  ASSERT_EQ(runs.size(), 2u);
+  ASSERT_EQ(runs[0].start, (start + 60) * 1000);
+  ASSERT_EQ(runs[0].input_bps.size(), 90u);
+  ASSERT_EQ(runs[0].input_bps[5], 500000u + ((start + 65) % 7) * 1000);
+  ASSERT_EQ(runs[0].output_bps[5], 400000u - ((start + 65) % 5) * 1000);
+  ASSERT_EQ(runs[0].status[9], iptv_cloud::PLAYING);
+  ASSERT_EQ(runs[0].status[10], iptv_cloud::FROZEN);
+  ASSERT_EQ(runs[0].restarts[10], 1u);
+  ASSERT_EQ(runs[1].start, (start + 200) * 1000);
+  ASSERT_EQ(runs[1].input_bps.size(), 1u);
+
+  history.DropBefore(start + 120);
+  runs.clear();
+  history.Query(0, start + 300, &runs);
+  ASSERT_EQ(runs[0].start, (start + 120) * 1000);
+}
+
+TEST(StreamHistory, hold_between_reports) {
+  iptv_cloud::server::StreamHistory history;
+  const time_t start = 1557000000;
+  history.Append(start, {500000, 400000, iptv_cloud::PLAYING, 0});
+  history.Append(start + 10, {600000, 500000, iptv_cloud::PLAYING, 0});
+  ASSERT_EQ(history.GetSamplesCount(), 11u);
+
+  std::vector<iptv_cloud::server::stream::HistoryRun> runs;
+  history.Query(start, start + 10, &runs);
+  ASSERT_EQ(runs.size(), 1u);
+  ASSERT_EQ(runs[0].input_bps[9], 500000u);
+  ASSERT_EQ(runs[0].input_bps[10], 600000u);
+
+  // stream silent longer than hold
+  history.Append(start + 11 + iptv_cloud::server::StreamHistory::hold_samples, {0, 0, iptv_cloud::FROZEN, 1});
+  ASSERT_EQ(history.GetSamplesCount(), 12u);
+}
+
+TEST(HistoryStore, budget) {
+  const time_t start = 1557000000;
+  const size_t day = iptv_cloud::server::StreamHistory::max_samples;
+  iptv_cloud::server::StreamHistory day_history;
+  for (size_t i = 0; i < day; ++i) {
+    iptv_cloud::server::StreamHistory::Sample sample = {500000 + (i * 7919) % 20000, 450000 + (i * 104729) % 20000,
+                                                        iptv_cloud::PLAYING, 0};
+    day_history.Append(start + i, sample);
+  }
+  std::cout << "24h of one stream: " << day_history.GetMemoryUsage() << " bytes" << std::endl;
+  ASSERT_EQ(day_history.GetSamplesCount(), day);
+
+  const size_t streams = 20;
+  iptv_cloud::server::HistoryStore store(256 * 1024);
+  for (size_t i = 0; i < 3600; ++i) {
+    for (size_t j = 0; j < streams; ++j) {
+      iptv_cloud::server::StreamHistory::Sample sample = {400000 + (i * j) % 9000, 300000, iptv_cloud::PLAYING, 0};
+      store.Append("stream_" + std::to_string(j), start + i, sample);
+    }
+  }
+  ASSERT_LE(store.GetMemoryUsage(), store.GetBudget());
+
+  std::vector<iptv_cloud::server::stream::HistoryRun> runs;
+  ASSERT_TRUE(store.Query("stream_3", 0, start + 3600, &runs));
+  ASSERT_EQ(runs.size(), 1u);
+  ASSERT_EQ(runs[0].start + static_cast<int64_t>(runs[0].input_bps.size()) * 1000, (start + 3600) * 1000);
+  ASSERT_FALSE(store.Query("unknown", 0, start, &runs));
+
+  store.RemoveStale(start + 3600 + day);
+  ASSERT_EQ(store.GetMemoryUsage(), 0u);
+}
+
+TEST(RelayEngine, restart_keeps_totals) {
+  iptv_cloud::server::relay::RelayEngine engine(1);
+  ASSERT_FALSE(engine.Start());
+  iptv_cloud::StreamInfo info = {"relay", iptv_cloud::RELAY, {1}, {2}};
+  const iptv_cloud::input_t input = {iptv_cloud::InputUri(1, common::uri::Url("udp://127.0.0.1:41000"))};
+  const iptv_cloud::output_t output = {iptv_cloud::OutputUri(2, common::uri::Url("udp://127.0.0.1:41001"))};
+  int out_fd = socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_NE(out_fd, -1);
+  struct sockaddr_in addr = {};
+  addr.sin_family = AF_INET;
+  addr.sin_port = htons(41001);
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(out_fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+  ASSERT_FALSE(engine.AddStream(info, input, output));
+
+  int fd = socket(AF_INET, SOCK_DGRAM, 0);
+  ASSERT_NE(fd, -1);
+  addr.sin_port = htons(41000);
+  uint8_t datagram[188 * 7] = {};
+  for (size_t i = 0; i < sizeof(datagram); i += 188) {  // null packets
+    datagram[i] = 0x47;
+    datagram[i + 1] = 0x1F;
+    datagram[i + 2] = 0xFF;
+    datagram[i + 3] = 0x10;
+  }
+  datagram[188 * 6 + 1] = 0x01;  // pid 0x100 with the same cc in every datagram
+  datagram[188 * 6 + 2] = 0x00;
+
+  size_t total = 0;
+  size_t sent = 0;
+  for (int i = 0; i < 200 && total == 0; ++i) {
+    sendto(fd, datagram, sizeof(datagram), 0, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    sent += sizeof(datagram);
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    std::vector<iptv_cloud::StreamStruct> stats = engine.CollectStatistic(1);
+    ASSERT_EQ(stats.size(), 1u);
+    total = stats[0].input[0].GetTotalBytes();
+  }
+  ASSERT_GT(total, 0u);
+
+  // datagrams queued in input socket are read by new channel, totals and bitrate continue
+  for (int i = 0; i < 4; ++i) {
+    sendto(fd, datagram, sizeof(datagram), 0, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+    sent += sizeof(datagram);
+  }
+  close(fd);
+  ASSERT_FALSE(engine.RestartStream("relay"));
+  std::vector<iptv_cloud::StreamStruct> stats = engine.CollectStatistic(1);
+  ASSERT_EQ(stats.size(), 1u);
+  ASSERT_EQ(stats[0].restarts, 1u);
+  ASSERT_GE(stats[0].input[0].GetTotalBytes(), total);
+  ASSERT_LE(stats[0].input[0].GetBps(), sizeof(datagram) * 200);
+  ASSERT_LE(stats[0].output[0].GetBps(), sizeof(datagram) * 200);
+  for (int i = 0; i < 200 && stats[0].output[0].GetTotalBytes() != sent; ++i) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    stats = engine.CollectStatistic(1);
+  }
+  ASSERT_EQ(stats[0].input[0].GetTotalBytes(), sent);
+  ASSERT_EQ(stats[0].output[0].GetTotalBytes(), sent);
+
+  const iptv_cloud::utils::mpegts::TsQuality quality = stats[0].input[0].GetTsQuality();
+  ASSERT_EQ(quality.packets, sent / 188);
+  ASSERT_GT(quality.cc_errors, 0u);
+  ASSERT_EQ(stats[0].output[0].GetDropped(), 0u);
+
+  // reconfigure starts statistic from zero
+  ASSERT_FALSE(engine.ReconfigureStream(info, input, output));
+  stats = engine.CollectStatistic(1);
+  ASSERT_EQ(stats.size(), 1u);
+  ASSERT_EQ(stats[0].restarts, 0u);
+  ASSERT_EQ(stats[0].input[0].GetTotalBytes(), 0u);
+  engine.Stop();
+  close(out_fd);
+}
+
+TEST(InputBroker, publisher_failover) {
+  iptv_cloud::server::InputBroker broker("/tmp/test_input_");
+  const std::string upstream = "http://example.com/live/1.ts";
+
+  iptv_cloud::StreamConfig first = MakeRelayConfig("first", upstream);
+  ASSERT_TRUE(broker.Attach(&first));
+  ASSERT_TRUE(broker.IsPublisher("first"));
+  ASSERT_EQ(first.input[0].GetInput().GetUrl(), upstream);
+  const std::string socket_path = first.args[PUBLISH_INPUT_FIELD];
+  ASSERT_EQ(socket_path.find("/tmp/test_input_"), 0u);
+
+  iptv_cloud::StreamConfig second = MakeRelayConfig("second", upstream);
+  iptv_cloud::StreamConfig third = MakeRelayConfig("third", upstream);
+  ASSERT_TRUE(broker.Attach(&second));
+  ASSERT_TRUE(broker.Attach(&third));
+  std::string reader_socket;
+  ASSERT_TRUE(iptv_cloud::IsInternalInputUrl(second.input[0], &reader_socket));
+  ASSERT_EQ(reader_socket, socket_path);
+  ASSERT_EQ(second.args.count(PUBLISH_INPUT_FIELD), 0u);
+  ASSERT_EQ(broker.GetReadersCount("first"), 2u);
+
+  iptv_cloud::StreamConfig other = MakeRelayConfig("other", "udp://239.0.0.1:5000");
+  ASSERT_TRUE(broker.Attach(&other));
+  ASSERT_EQ(broker.GetSharedInputsCount(), 2u);
+  iptv_cloud::StreamConfig file = MakeRelayConfig("file", "file:///tmp/1.ts");
+  ASSERT_FALSE(broker.Attach(&file));
+
+  // publisher exits, oldest reader publishes on the same socket with upstream url
+  iptv_cloud::StreamConfig promoted;
+  ASSERT_TRUE(broker.Detach("first", &promoted));
+  ASSERT_EQ(promoted.id, "second");
+  ASSERT_EQ(promoted.input[0].GetInput().GetUrl(), upstream);
+  ASSERT_EQ(promoted.args[PUBLISH_INPUT_FIELD], socket_path);
+  ASSERT_TRUE(broker.IsPublisher("second"));
+  ASSERT_EQ(broker.GetReadersCount("second"), 1u);
+
+  // restarted stream joins as reader
+  first = MakeRelayConfig("first", upstream);
+  ASSERT_TRUE(broker.Attach(&first));
+  ASSERT_TRUE(broker.IsReader("first"));
+
+  // reconfigure with the same upstream keeps role, new upstream does not
+  iptv_cloud::StreamConfig updated = MakeRelayConfig("second", upstream);
+  ASSERT_TRUE(broker.Update(&updated));
+  ASSERT_EQ(updated.args[PUBLISH_INPUT_FIELD], socket_path);
+  updated = MakeRelayConfig("second", "http://example.com/live/2.ts");
+  ASSERT_FALSE(broker.Update(&updated));
+
+  ASSERT_FALSE(broker.Detach("third", &promoted));
+  ASSERT_FALSE(broker.Detach("first", &promoted));
+  ASSERT_FALSE(broker.Detach("second", &promoted));
+  ASSERT_FALSE(broker.Detach("other", &promoted));
+  ASSERT_EQ(broker.GetSharedInputsCount(), 0u);
+}
+
+TEST(InputBroker, restore_roles) {
+  const std::string upstream = "http://example.com/live/1.ts";
+  iptv_cloud::server::InputBroker previous("/tmp/test_input_");
+  iptv_cloud::StreamConfig first = MakeRelayConfig("first", upstream);
+  iptv_cloud::StreamConfig second = MakeRelayConfig("second", upstream);
+  ASSERT_TRUE(previous.Attach(&first));
+  ASSERT_TRUE(previous.Attach(&second));
+
+  iptv_cloud::StreamConfig original;
+  bool publisher = false;
+  ASSERT_TRUE(previous.GetRole("first", &original, &publisher));
+  ASSERT_TRUE(publisher);
+  ASSERT_EQ(original.input[0].GetInput().GetUrl(), upstream);
+  ASSERT_TRUE(previous.GetRole("second", &original, &publisher));
+  ASSERT_FALSE(publisher);
+  ASSERT_FALSE(previous.GetRole("unknown", &original, &publisher));
+
+  // next instance: new stream on the same upstream reads adopted publisher
+  iptv_cloud::server::InputBroker broker("/tmp/test_input_");
+  iptv_cloud::StreamConfig promoted;
+  ASSERT_FALSE(broker.Restore(MakeRelayConfig("first", upstream), true, &promoted));
+  ASSERT_FALSE(broker.Restore(MakeRelayConfig("second", upstream), false, &promoted));
+  ASSERT_FALSE(broker.Restore(MakeRelayConfig("second", upstream), false, &promoted));
+  ASSERT_TRUE(broker.IsPublisher("first"));
+  ASSERT_TRUE(broker.IsReader("second"));
+  iptv_cloud::StreamConfig third = MakeRelayConfig("third", upstream);
+  ASSERT_TRUE(broker.Attach(&third));
+  ASSERT_TRUE(broker.IsReader("third"));
+  ASSERT_EQ(broker.GetSharedInputsCount(), 1u);
+
+  // adopted publisher exits, its reader is promoted
+  ASSERT_TRUE(broker.Detach("first", &promoted));
+  ASSERT_EQ(promoted.id, "second");
+  ASSERT_EQ(promoted.args[PUBLISH_INPUT_FIELD], first.args[PUBLISH_INPUT_FIELD]);
+
+  // publisher exited while service was down, surviving reader must publish
+  iptv_cloud::server::InputBroker orphan("/tmp/test_input_");
+  ASSERT_TRUE(orphan.Restore(MakeRelayConfig("second", upstream), false, &promoted));
+  ASSERT_EQ(promoted.id, "second");
+  ASSERT_EQ(promoted.input[0].GetInput().GetUrl(), upstream);
+  ASSERT_EQ(promoted.args[PUBLISH_INPUT_FIELD], first.args[PUBLISH_INPUT_FIELD]);
+  ASSERT_TRUE(orphan.IsPublisher("second"));
+  ASSERT_FALSE(orphan.Restore(MakeRelayConfig("file", "file:///tmp/1.ts"), true, &promoted));
+}
+
+TEST(ChildTable, save_load) {
+  const std::string path = "/tmp/unit_test_child_table.json";
+  iptv_cloud::server::ChildTable table;
+  table.Add("first", 100);
+  table.Add("second", 200);
+  table.Add("first", 101);  // restarted
+  ASSERT_EQ(table.GetSize(), 2u);
+  ASSERT_FALSE(table.Save(path));
+
+  iptv_cloud::server::ChildTable loaded;
+  ASSERT_FALSE(loaded.Load(path));
+  pid_t pid = 0;
+  ASSERT_TRUE(loaded.Find("first", &pid));
+  ASSERT_EQ(pid, 101);
+  ASSERT_TRUE(loaded.Find("second", &pid));
+  ASSERT_EQ(pid, 200);
+  loaded.Remove("second");
+  ASSERT_FALSE(loaded.Find("second", &pid));
+  ASSERT_EQ(loaded.GetEntries().size(), 1u);
+
+  loaded.SetSharedInput("first", R"({"id" : "first"})", true);
+  loaded.SetSharedInput("unknown", R"({"id" : "unknown"})", true);
+  ASSERT_FALSE(loaded.Save(path));
+  ASSERT_FALSE(table.Load(path));
+  ASSERT_EQ(table.GetSize(), 1u);
+  ASSERT_EQ(table.GetEntries()[0].shared_input, R"({"id" : "first"})");
+  ASSERT_TRUE(table.GetEntries()[0].publisher);
+
+  ASSERT_FALSE(loaded.Parse("{}"));
+  ASSERT_FALSE(loaded.Parse(R"([{"id" : "third"}])"));
+  ASSERT_FALSE(loaded.Parse(R"([{"id" : "third", "pid" : 0}])"));
+  ASSERT_EQ(loaded.GetSize(), 1u);
+  ASSERT_TRUE(loaded.Parse("[]"));
+  ASSERT_EQ(loaded.GetSize(), 0u);
+  remove(path.c_str());
+  ASSERT_TRUE(loaded.Load(path));
+}
+
+TEST(ProtocoledPipeClient, quit_status_before_exit) {
+  int pipefd[2];
+  ASSERT_EQ(pipe(pipefd), 0);
+  iptv_cloud::server::pipe::ProtocoledPipeClient service(nullptr, pipefd[0], -1);
+  iptv_cloud::server::pipe::ProtocoledPipeClient child(nullptr, -1, pipefd[1]);
+  ASSERT_FALSE(service.IsReadReady());
+
+  std::string quit_json;
+  ASSERT_FALSE(iptv_cloud::server::stream::QuitStatusInfo("vod", EXIT_SUCCESS, 0).SerializeToString(&quit_json));
+  ASSERT_FALSE(child.WriteRequest(iptv_cloud::server::QuitStatusStreamBroadcast(quit_json)));
+  ASSERT_FALSE(child.Close());
+  ASSERT_TRUE(service.IsReadReady());
+
+  std::string command;
+  ASSERT_FALSE(service.ReadCommand(&command));
+  iptv_cloud::protocol::request_t* req = nullptr;
+  iptv_cloud::protocol::response_t* resp = nullptr;
+  ASSERT_FALSE(common::protocols::json_rpc::ParseJsonRPC(command, &req, &resp));
+  ASSERT_TRUE(req);
+  ASSERT_EQ(req->method, STREAM_QUIT_STATUS_STREAM);
+
+  json_object* jquit = json_tokener_parse(req->params->c_str());
+  ASSERT_TRUE(jquit);
+  iptv_cloud::server::stream::QuitStatusInfo quit_info;
+  ASSERT_FALSE(quit_info.DeSerialize(jquit));
+  json_object_put(jquit);
+  ASSERT_EQ(quit_info.GetStreamID(), "vod");
+  ASSERT_EQ(quit_info.GetExitStatus(), EXIT_SUCCESS);
+  delete req;
+
+  ASSERT_TRUE(service.IsReadReady());  // end of pipe
+  ASSERT_TRUE(service.ReadCommand(&command));
+  ASSERT_FALSE(service.Close());
+}
+
+TEST(CpuPlacement, numa_nodes) {
+  typedef iptv_cloud::server::CpuPlacement CpuPlacement;
+  CpuPlacement::topology_t topology;
+  for (int i = 0; i < 8; ++i) {
+    topology.push_back({i, i / 4});
+  }
+  CpuPlacement placement(topology);
+  ASSERT_EQ(placement.GetNodesCount(), 2u);
+
+  CpuPlacement::Assignment first = placement.Assign("first", 2);
+  ASSERT_EQ(first.node, 0);
+  ASSERT_EQ(first.cpus, std::vector<int>({0, 1}));
+  CpuPlacement::Assignment second = placement.Assign("second", 2);  // spread over nodes
+  ASSERT_EQ(second.node, 1);
+  ASSERT_EQ(second.cpus, std::vector<int>({4, 5}));
+  CpuPlacement::Assignment third = placement.Assign("third", 2);
+  ASSERT_EQ(third.node, 0);
+  ASSERT_EQ(third.cpus, std::vector<int>({2, 3}));
+  CpuPlacement::Assignment big = placement.Assign("big", 16);  // never spans nodes
+  ASSERT_EQ(big.node, 1);
+  ASSERT_EQ(big.cpus, std::vector<int>({4, 5, 6, 7}));
+
+  CpuPlacement::Assignment relay = placement.Assign("relay", 0);
+  ASSERT_EQ(relay.node, 0);
+  ASSERT_EQ(relay.cpus, std::vector<int>({0, 1, 2, 3}));
+  ASSERT_EQ(placement.GetPlacedCount(), 5u);
+
+  // restart moves stream to cores freed meanwhile
+  placement.Release("big");
+  placement.Release("first");
+  first = placement.Assign("first", 2);
+  ASSERT_EQ(first.node, 1);
+  ASSERT_EQ(first.cpus, std::vector<int>({6, 7}));
+  placement.Release("first");
+  placement.Release("second");
+  placement.Release("third");
+  placement.Release("relay");
+  for (uint32_t load : placement.GetCpusLoad()) {
+    ASSERT_EQ(load, 0u);
+  }
+
+  // adopted streams keep their cores
+  placement.Restore("adopted", {4, 5});
+  placement.Restore("adopted_relay", {0, 1, 2, 3});
+  CpuPlacement::Assignment restored;
+  ASSERT_TRUE(placement.Find("adopted", &restored));
+  ASSERT_EQ(restored.node, 1);
+  ASSERT_EQ(placement.Assign("next", 2).cpus, std::vector<int>({1, 2}));
+  ASSERT_FALSE(placement.Find("first", &restored));
+
+  CpuPlacement empty((CpuPlacement::topology_t()));
+  ASSERT_TRUE(empty.Assign("first", 2).cpus.empty());
+}
+
+TEST(CpuPlacement, required_cpus) {
+  typedef iptv_cloud::server::CpuPlacement CpuPlacement;
+  iptv_cloud::StreamConfig config;
+  common::Error err = iptv_cloud::server::options::ParseStreamConfig(kEncodeConfig, &config);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(CpuPlacement::GetRequiredCpus(config.type, config.args), 4u);
+
+  iptv_cloud::utils::ArgsMap args;
+  ASSERT_EQ(CpuPlacement::GetRequiredCpus(iptv_cloud::ENCODE, args), CpuPlacement::DEFAULT_ENCODE_CPUS);
+  ASSERT_EQ(CpuPlacement::GetRequiredCpus(iptv_cloud::RELAY, args), 0u);
+  args[VIDEO_CODEC_FIELD] = NV_H264_ENC;
+  ASSERT_EQ(CpuPlacement::GetRequiredCpus(iptv_cloud::ENCODE, args), 0u);
+  args[VIDEO_CODEC_FIELD] = X264_ENC;
+  args[RELAY_VIDEO_FIELD] = "true";
+  ASSERT_EQ(CpuPlacement::GetRequiredCpus(iptv_cloud::ENCODE, args), 0u);
+
+  CpuPlacement::topology_t topology = CpuPlacement::ReadMachineTopology();
+  ASSERT_FALSE(topology.empty());
+}
+
+TEST(CpuPlacement, remove_cpuset_cgroup) {
+  typedef iptv_cloud::server::CpuPlacement CpuPlacement;
+  char root[] = "/tmp/cpuset_XXXXXX";
+  ASSERT_TRUE(mkdtemp(root));
+  const std::string stream_dir = std::string(root) + "/test_1";
+  ASSERT_EQ(mkdir(stream_dir.c_str(), S_IRWXU), 0);
+
+  common::ErrnoError err = CpuPlacement::RemoveCpusetCgroup(root, "test_1");
+  ASSERT_FALSE(err);
+  struct stat st;
+  ASSERT_NE(stat(stream_dir.c_str(), &st), 0);
+  err = CpuPlacement::RemoveCpusetCgroup(root, "test_1");  // stream never placed or already removed
+  ASSERT_FALSE(err);
+  err = CpuPlacement::RemoveCpusetCgroup(std::string(), "test_1");
+  ASSERT_TRUE(err);
+  ASSERT_EQ(rmdir(root), 0);
+}
+
+namespace {
+const size_t kBenchEncodeThreads = 2;
+
+// wall milliseconds of concurrent x264 encodes, pinned if placement is given
+double RunX264Encodes(size_t count, iptv_cloud::server::CpuPlacement* placement) {
+  std::vector<pid_t> pids;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < count; ++i) {
+    iptv_cloud::server::CpuPlacement::Assignment assignment = {-1, std::vector<int>()};
+    if (placement) {
+      assignment = placement->Assign("encode_" + std::to_string(i), kBenchEncodeThreads);
+    }
+
+    pid_t pid = fork();
+    if (pid == 0) {
+      if (iptv_cloud::server::CpuPlacement::SetAffinity(0, assignment)) {
+        _exit(EXIT_FAILURE);
+      }
+      execlp("gst-launch-1.0", "gst-launch-1.0", "-q", "videotestsrc", "num-buffers=250", "!",
+             "video/x-raw,width=1280,height=720", "!", "x264enc", "threads=2", "speed-preset=faster", "!", "fakesink",
+             static_cast<char*>(nullptr));
+      _exit(EXIT_FAILURE);
+    } else if (pid > 0) {
+      pids.push_back(pid);
+    }
+  }
+
+  bool success = pids.size() == count;
+  for (pid_t pid : pids) {
+    int status = 0;
+    if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+      success = false;
+    }
+  }
+  const auto elapsed =
+      std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+
+  if (placement) {
+    for (size_t i = 0; i < count; ++i) {
+      placement->Release("encode_" + std::to_string(i));
+    }
+  }
+  return success ? static_cast<double>(elapsed.count()) : -1;
+}
+}  // namespace
+
+TEST(CpuPlacement, DISABLED_x264_encodes_benchmark) {
+  if (system("gst-inspect-1.0 x264enc > /dev/null 2>&1") != EXIT_SUCCESS) {
+    return;
+  }
+
+  iptv_cloud::server::CpuPlacement placement(iptv_cloud::server::CpuPlacement::ReadMachineTopology());
+  const size_t cpus = placement.GetCpusIds().size();
+  const size_t encodes = std::max<size_t>(2, cpus / kBenchEncodeThreads);
+  const double free_ms = RunX264Encodes(encodes, nullptr);
+  const double placed_ms = RunX264Encodes(encodes, &placement);
+  ASSERT_GE(free_ms, 0);
+  ASSERT_GE(placed_ms, 0);
+  std::cout << encodes << " x264 encodes on " << cpus << " cpus, " << placement.GetNodesCount()
+            << " nodes, no placement: " << free_ms << " ms, placed: " << placed_ms << " ms" << std::endl;
+}
@@ -18,11 +18,12 @@
 #include "base/constants.h"
 #include "base/inputs_outputs.h"
 
+#include "stream/config.h"
 #include "stream/configs_factory.h"
 #include "stream/stypes.h"
 
 TEST(Api, init) {
-  iptv_cloud::utils::ArgsMap emp;
+  iptv_cloud::StreamConfig emp;
   iptv_cloud::stream::Config* empty_api = nullptr;
   common::Error err = iptv_cloud::stream::make_config(emp, &empty_api);
   ASSERT_TRUE(err);
@@ -31,6 +32,18 @@ TEST(Api, init) {
   uri.SetOutput(common::uri::Url("screen"));
   ouri.push_back(uri);
 
+  iptv_cloud::StreamConfig screen;
+  screen.id = "screen";
+  screen.type = iptv_cloud::SCREEN;
+  screen.feedback_dir = "~";
+  screen.input.push_back(iptv_cloud::InputUri(0, common::uri::Url(SCREEN_URL)));
+  screen.output = ouri;
+  iptv_cloud::stream::Config* screen_api = nullptr;
+  err = iptv_cloud::stream::make_config(screen, &screen_api);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(screen_api->GetType(), iptv_cloud::SCREEN);
+  destroy(&screen_api);
+
   ASSERT_TRUE(iptv_cloud::IsTestInputUrl(iptv_cloud::InputUri(0, common::uri::Url(TEST_URL))));
 
   ASSERT_TRUE(iptv_cloud::stream::IsScreenUrl(common::uri::Url(SCREEN_URL)));
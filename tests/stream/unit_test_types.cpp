@@ -12,9 +12,33 @@
     along with iptv_cloud.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+#include <gst/video/video.h>
 #include <gtest/gtest.h>
 
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "stream/elements/parser/audio_parsers.h"
+#include "stream/elements/parser/video_parsers.h"
+#include "stream/elements/sink/fake.h"
+#include "stream/elements/sink/tcp.h"
+#include "stream/logo_overlay.h"
+#include "stream/mapped_file.h"
+#include "stream/probes.h"
 #include "stream/stypes.h"
+#include "stream/streams/builders/encoding/encoding_stream_builder.h"
+#include "stream/streams/builders/relay/relay_stream_builder.h"
+#include "stream/streams/mosaic_meter.h"
+#include "stream/streams/screen_stream.h"
 
 TEST(element_id_t, GetElementId) {
   iptv_cloud::stream::element_id_t id;
@@ -60,3 +84,613 @@ TEST(m3u8, GetIndexFromHttpTsTemplate) {
   uint64_t ind3;
   ASSERT_FALSE(iptv_cloud::stream::GetIndexFromHttpTsTemplate("123_g.ts", &ind3));
 }
+
+TEST(SupportedDemuxer, GetDemuxerFromUrl) {
+  iptv_cloud::stream::SupportedDemuxer dem;
+  ASSERT_FALSE(iptv_cloud::stream::GetDemuxerFromUrl(common::uri::Url("udp://239.0.0.1:5000"), nullptr));
+  ASSERT_TRUE(iptv_cloud::stream::GetDemuxerFromUrl(common::uri::Url("udp://239.0.0.1:5000"), &dem));
+  ASSERT_EQ(dem, iptv_cloud::stream::VIDEO_MPEGTS_DEMUXER);
+  ASSERT_TRUE(iptv_cloud::stream::GetDemuxerFromUrl(common::uri::Url("rtmp://localhost/live/1"), &dem));
+  ASSERT_EQ(dem, iptv_cloud::stream::VIDEO_FLV_DEMUXER);
+  ASSERT_TRUE(iptv_cloud::stream::GetDemuxerFromUrl(common::uri::Url("file:///home/video/1.ts"), &dem));
+  ASSERT_EQ(dem, iptv_cloud::stream::VIDEO_MPEGTS_DEMUXER);
+  ASSERT_TRUE(iptv_cloud::stream::GetDemuxerFromUrl(common::uri::Url("http://localhost/1.flv"), &dem));
+  ASSERT_EQ(dem, iptv_cloud::stream::VIDEO_FLV_DEMUXER);
+  ASSERT_FALSE(iptv_cloud::stream::GetDemuxerFromUrl(common::uri::Url("http://localhost/master.m3u8"), &dem));
+  ASSERT_FALSE(iptv_cloud::stream::GetDemuxerFromUrl(common::uri::Url("file:///home/video/1.mp4"), &dem));
+}
+
+TEST(MosaicMeterRenderer, rasterize_on_level_change) {
+  iptv_cloud::stream::streams::MosaicImageOptions options;
+  options.screen_size = common::draw::Size(640, 360);
+  options.right_padding = 40;
+  iptv_cloud::stream::streams::StreamInfo stream;
+  stream.img.x_y = common::draw::Point(0, 0);
+  stream.img.size = common::draw::Size(320, 180);
+  stream.sound.channels.push_back({-30.0, 0.0, 0.0});
+  stream.sound.channels.push_back({-30.0, 0.0, 0.0});
+  options.sreams.push_back(stream);
+
+  const iptv_cloud::stream::YuvFrameInfo frame = {iptv_cloud::stream::YUV_I420, 640, 360};
+  std::vector<uint8_t> data(iptv_cloud::stream::GetYuvFrameSize(frame), 16);
+  iptv_cloud::stream::streams::MosaicMeterRenderer renderer;
+  ASSERT_TRUE(renderer.Draw(options, frame, data.data(), data.size()));
+  ASSERT_TRUE(renderer.Draw(options, frame, data.data(), data.size()));
+  ASSERT_EQ(renderer.GetRasterizeCount(), 1);
+  ASSERT_EQ(data[0], 16);  // outside of meter
+
+  options.sreams[0].sound.channels[0].rms_dB = -31.0;  // same lit chunks
+  ASSERT_TRUE(renderer.Draw(options, frame, data.data(), data.size()));
+  ASSERT_EQ(renderer.GetRasterizeCount(), 1);
+
+  options.sreams[0].sound.channels[0].rms_dB = -80.0;
+  ASSERT_TRUE(renderer.Draw(options, frame, data.data(), data.size()));
+  ASSERT_EQ(renderer.GetRasterizeCount(), 2);
+  ASSERT_FALSE(renderer.Draw(options, frame, data.data(), data.size() - 1));
+}
+
+namespace {
+
+std::vector<uint32_t> MakeTestLogo(int width, int height) {
+  std::vector<uint32_t> logo(width * height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const uint32_t alpha = (x * 255 / width + y) & 0xFF;
+      const uint32_t red = alpha * ((x * 7) & 0xFF) / 255;
+      const uint32_t green = alpha * ((y * 5) & 0xFF) / 255;
+      const uint32_t blue = alpha / 2;
+      logo[y * width + x] = alpha << 24 | red << 16 | green << 8 | blue;
+    }
+  }
+  return logo;
+}
+
+std::vector<uint8_t> MakeTestFrame(const iptv_cloud::stream::YuvFrameInfo& frame) {
+  std::vector<uint8_t> data(iptv_cloud::stream::GetYuvFrameSize(frame));
+  for (size_t i = 0; i < data.size(); ++i) {
+    data[i] = static_cast<uint8_t>(i * 31 + (i >> 7));
+  }
+  return data;
+}
+
+// straight alpha, per pixel float conversion over whole logo rectangle, like generic overlay elements do
+void BlendReference(const iptv_cloud::stream::YuvFrameInfo& frame,
+                    uint8_t* data,
+                    const std::vector<uint32_t>& logo,
+                    int width,
+                    int height,
+                    int left,
+                    int top) {
+  iptv_cloud::stream::YuvPlanes planes;
+  iptv_cloud::stream::MapYuvPlanes(frame, data, iptv_cloud::stream::GetYuvFrameSize(frame), &planes);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x) {
+      const uint32_t pixel = logo[y * width + x];
+      const float alpha = (pixel >> 24) / 255.0f;
+      const float inv = alpha > 0 ? 1 / (alpha * 255) : 0;
+      const float r = ((pixel >> 16) & 0xFF) * inv;
+      const float g = ((pixel >> 8) & 0xFF) * inv;
+      const float b = (pixel & 0xFF) * inv;
+      uint8_t* luma = planes.luma + (top + y) * planes.luma_stride + left + x;
+      *luma = static_cast<uint8_t>(*luma * (1 - alpha) + (16 + 65.481f * r + 128.553f * g + 24.966f * b) * alpha);
+      if (((x | y) & 1) == 0) {
+        const int offset = (top + y) / 2 * planes.chroma_stride + (left + x) / 2;
+        uint8_t* u = planes.chroma_u + offset;
+        uint8_t* v = planes.chroma_v + offset;
+        *u = static_cast<uint8_t>(*u * (1 - alpha) + (128 - 37.797f * r - 74.203f * g + 112.0f * b) * alpha);
+        *v = static_cast<uint8_t>(*v * (1 - alpha) + (128 + 112.0f * r - 93.786f * g - 18.214f * b) * alpha);
+      }
+    }
+  }
+}
+
+}  // namespace
+
+TEST(LogoOverlay, kernels_match_scalar) {
+  const std::vector<uint32_t> logo = MakeTestLogo(77, 41);
+  const iptv_cloud::stream::YuvFormat formats[] = {iptv_cloud::stream::YUV_I420, iptv_cloud::stream::YUV_NV12};
+  for (iptv_cloud::stream::YuvFormat format : formats) {
+    const iptv_cloud::stream::YuvFrameInfo frame = {format, 320, 180};
+    const std::vector<uint8_t> original = MakeTestFrame(frame);
+
+    iptv_cloud::stream::LogoOverlay overlay;
+    overlay.SetImage(logo.data(), 77, 41, 77 * 4, common::draw::Point(275, 151), 0.8);  // clipped by frame
+    overlay.SetKernel(iptv_cloud::stream::LogoOverlay::KERNEL_SCALAR);
+    std::vector<uint8_t> expected = original;
+    ASSERT_TRUE(overlay.Blend(frame, expected.data(), expected.size()));
+    ASSERT_NE(expected, original);
+    ASSERT_EQ(expected[0], original[0]);  // outside of logo
+
+    for (int kernel = iptv_cloud::stream::LogoOverlay::KERNEL_SSE4;
+         kernel <= iptv_cloud::stream::LogoOverlay::GetBestKernel(); ++kernel) {
+      overlay.SetKernel(static_cast<iptv_cloud::stream::LogoOverlay::Kernel>(kernel));
+      std::vector<uint8_t> result = original;
+      ASSERT_TRUE(overlay.Blend(frame, result.data(), result.size()));
+      ASSERT_EQ(result, expected);
+    }
+    ASSERT_FALSE(overlay.Blend(frame, expected.data(), expected.size() - 1));
+  }
+}
+
+TEST(LogoOverlay, video_meta_strides) {
+  gst_init(nullptr, nullptr);
+
+  const std::vector<uint32_t> logo = MakeTestLogo(77, 41);
+  iptv_cloud::stream::YuvFrameInfo frame = {iptv_cloud::stream::YUV_I420, 320, 180};
+  const std::vector<uint8_t> original = MakeTestFrame(frame);
+  iptv_cloud::stream::LogoOverlay overlay;
+  overlay.SetImage(logo.data(), 77, 41, 77 * 4, common::draw::Point(200, 100), 0.8);
+  std::vector<uint8_t> expected = original;
+  ASSERT_TRUE(overlay.Blend(frame, expected.data(), expected.size()));
+
+  // padded rows and gaps between planes, like pools of hardware decoders
+  const gsize offsets[GST_VIDEO_MAX_PLANES] = {64, 64 + 384 * 180 + 128, 64 + 384 * 180 + 128 + 192 * 90};
+  const gint strides[GST_VIDEO_MAX_PLANES] = {384, 192, 192};
+  const gsize buffer_size = offsets[2] + 192 * 90;
+  GstBuffer* buffer = gst_buffer_new_allocate(nullptr, buffer_size, nullptr);
+  gst_buffer_memset(buffer, 0, 0xAB, buffer_size);
+  ASSERT_TRUE(gst_buffer_add_video_meta_full(buffer, GST_VIDEO_FRAME_FLAG_NONE, GST_VIDEO_FORMAT_I420, 320, 180, 3,
+                                             const_cast<gsize*>(offsets), const_cast<gint*>(strides)));
+  ASSERT_TRUE(iptv_cloud::stream::SetYuvFrameLayout(buffer, &frame));
+  ASSERT_EQ(frame.strides[0], 384);
+
+  iptv_cloud::stream::YuvFrameInfo default_frame = {iptv_cloud::stream::YUV_I420, 320, 180};
+  iptv_cloud::stream::YuvPlanes source;
+  ASSERT_TRUE(iptv_cloud::stream::MapYuvPlanes(default_frame, const_cast<uint8_t*>(original.data()), original.size(),
+                                               &source));
+  GstMapInfo map;
+  ASSERT_TRUE(gst_buffer_map(buffer, &map, GST_MAP_WRITE));
+  iptv_cloud::stream::YuvPlanes padded;
+  ASSERT_TRUE(iptv_cloud::stream::MapYuvPlanes(frame, map.data, map.size, &padded));
+  for (int y = 0; y < 180; ++y) {
+    memcpy(padded.luma + y * padded.luma_stride, source.luma + y * source.luma_stride, 320);
+    if (y < 90) {
+      memcpy(padded.chroma_u + y * padded.chroma_stride, source.chroma_u + y * source.chroma_stride, 160);
+      memcpy(padded.chroma_v + y * padded.chroma_stride, source.chroma_v + y * source.chroma_stride, 160);
+    }
+  }
+
+  ASSERT_TRUE(overlay.Blend(frame, map.data, map.size));
+  ASSERT_TRUE(iptv_cloud::stream::MapYuvPlanes(default_frame, expected.data(), expected.size(), &source));
+  for (int y = 0; y < 180; ++y) {
+    ASSERT_EQ(memcmp(padded.luma + y * padded.luma_stride, source.luma + y * source.luma_stride, 320), 0);
+    ASSERT_EQ(padded.luma[y * padded.luma_stride + 320], 0xAB);  // padding untouched
+    if (y < 90) {
+      ASSERT_EQ(memcmp(padded.chroma_u + y * padded.chroma_stride, source.chroma_u + y * source.chroma_stride, 160), 0);
+      ASSERT_EQ(memcmp(padded.chroma_v + y * padded.chroma_stride, source.chroma_v + y * source.chroma_stride, 160), 0);
+    }
+  }
+  ASSERT_EQ(map.data[0], 0xAB);
+  gst_buffer_unmap(buffer, &map);
+
+  // meta of other geometry, frame is skipped
+  iptv_cloud::stream::YuvFrameInfo other = {iptv_cloud::stream::YUV_I420, 640, 360};
+  ASSERT_FALSE(iptv_cloud::stream::SetYuvFrameLayout(buffer, &other));
+  gst_buffer_unref(buffer);
+}
+
+TEST(LogoOverlay, DISABLED_blend_benchmark) {
+  const int frames = 200;
+  const int logo_width = 200;
+  const int logo_height = 100;
+  const int left = 1680;
+  const int top = 40;
+  const std::vector<uint32_t> logo = MakeTestLogo(logo_width, logo_height);
+  const iptv_cloud::stream::YuvFrameInfo frame = {iptv_cloud::stream::YUV_I420, 1920, 1080};
+  std::vector<uint8_t> data = MakeTestFrame(frame);
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < frames; ++i) {
+    BlendReference(frame, data.data(), logo, logo_width, logo_height, left, top);
+  }
+  const auto reference_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  std::cout << "reference: " << reference_ns.count() / frames << " ns/frame" << std::endl;
+
+  iptv_cloud::stream::LogoOverlay overlay;
+  overlay.SetImage(logo.data(), logo_width, logo_height, logo_width * 4, common::draw::Point(left, top), 1.0);
+  for (int kernel = iptv_cloud::stream::LogoOverlay::KERNEL_SCALAR;
+       kernel <= iptv_cloud::stream::LogoOverlay::GetBestKernel(); ++kernel) {
+    overlay.SetKernel(static_cast<iptv_cloud::stream::LogoOverlay::Kernel>(kernel));
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < frames; ++i) {
+      ASSERT_TRUE(overlay.Blend(frame, data.data(), data.size()));
+    }
+    const auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+    std::cout << "kernel " << kernel << ": " << ns.count() / frames << " ns/frame" << std::endl;
+  }
+}
+
+TEST(MappedFile, read_slices) {
+  gst_init(nullptr, nullptr);
+
+  char path[] = "/tmp/mapped_file_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(fd, -1);
+  std::vector<uint8_t> content(1000);
+  for (size_t i = 0; i < content.size(); ++i) {
+    content[i] = static_cast<uint8_t>(i);
+  }
+  ASSERT_EQ(write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+
+  iptv_cloud::stream::MappedFile file;
+  common::ErrnoError err = file.Open(path);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(file.GetSize(), content.size());
+
+  std::vector<GstBuffer*> buffers;
+  while (!file.IsEnd()) {
+    buffers.push_back(file.ReadBuffer(300));
+  }
+  ASSERT_EQ(buffers.size(), 4);
+  ASSERT_FALSE(file.ReadBuffer(300));
+  file.Close();  // slices keep mapping
+
+  std::vector<uint8_t> result;
+  for (GstBuffer* buffer : buffers) {
+    GstMapInfo map;
+    ASSERT_TRUE(gst_buffer_map(buffer, &map, GST_MAP_READ));
+    result.insert(result.end(), map.data, map.data + map.size);
+    gst_buffer_unmap(buffer, &map);
+    gst_buffer_unref(buffer);
+  }
+  ASSERT_EQ(result, content);
+
+  ASSERT_EQ(ftruncate(fd, 0), 0);
+  err = file.Open(path);
+  ASSERT_TRUE(err);
+  ASSERT_FALSE(file.IsOpen());
+  close(fd);
+  unlink(path);
+}
+
+TEST(MappedFile, truncated) {
+  gst_init(nullptr, nullptr);
+
+  char path[] = "/tmp/mapped_file_XXXXXX";
+  int fd = mkstemp(path);
+  ASSERT_NE(fd, -1);
+  const std::vector<uint8_t> content(1000, 0x47);
+  for (bool settled : {false, true}) {
+    ASSERT_EQ(ftruncate(fd, 0), 0);
+    ASSERT_EQ(pwrite(fd, content.data(), content.size(), 0), static_cast<ssize_t>(content.size()));
+    if (settled) {
+      const time_t mtime = time(nullptr) - 2 * iptv_cloud::stream::MappedFile::settled_sec;
+      const struct timespec times[2] = {{0, UTIME_OMIT}, {mtime, 0}};
+      ASSERT_EQ(futimens(fd, times), 0);
+    }
+
+    iptv_cloud::stream::MappedFile file;
+    ASSERT_FALSE(file.Open(path));
+    ASSERT_EQ(file.IsMapped(), settled);  // recent file may be still written
+    GstBuffer* buffer = file.ReadBuffer(300);
+    ASSERT_TRUE(buffer);
+    gst_buffer_unref(buffer);
+
+    // writer truncates file, reading ends at its new size instead of faulting on mapping
+    ASSERT_EQ(ftruncate(fd, 500), 0);
+    size_t read_size = 300;
+    while ((buffer = file.ReadBuffer(300))) {
+      read_size += gst_buffer_get_size(buffer);
+      gst_buffer_unref(buffer);
+    }
+    ASSERT_EQ(read_size, 500u);
+    ASSERT_TRUE(file.IsEnd());
+  }
+  close(fd);
+  unlink(path);
+}
+
+namespace {
+GstFlowReturn DropChain(GstPad* pad, GstObject* parent, GstBuffer* buffer) {
+  UNUSED(pad);
+  UNUSED(parent);
+  gst_buffer_unref(buffer);
+  return GST_FLOW_OK;
+}
+
+GstFlowReturn DropChainList(GstPad* pad, GstObject* parent, GstBufferList* list) {
+  UNUSED(pad);
+  UNUSED(parent);
+  gst_buffer_list_unref(list);
+  return GST_FLOW_OK;
+}
+}  // namespace
+
+TEST(Probe, DISABLED_buffer_list_benchmark) {
+  gst_init(nullptr, nullptr);
+  const size_t packets = 200000;
+  const size_t datagram_size = 1316;
+  const guint batch = 32;
+
+  iptv_cloud::output_t output;
+  iptv_cloud::OutputUri uri;
+  uri.SetOutput(common::uri::Url("screen"));
+  output.push_back(uri);
+  iptv_cloud::stream::streams::AudioVideoConfig config(
+      iptv_cloud::stream::Config(iptv_cloud::SCREEN, 1, iptv_cloud::input_t(), output));
+  iptv_cloud::StreamStruct stats(iptv_cloud::StreamInfo{"probe_bench", iptv_cloud::SCREEN, {0}, {0}});
+  iptv_cloud::stream::IBaseStream* stream =
+      new iptv_cloud::stream::streams::ScreenStream(&config, nullptr, &stats);
+
+  GstPad* src = gst_pad_new("src", GST_PAD_SRC);
+  GstPad* sink = gst_pad_new("sink", GST_PAD_SINK);
+  gst_pad_set_chain_function(sink, DropChain);
+  gst_pad_set_chain_list_function(sink, DropChainList);
+  gst_pad_set_active(src, TRUE);
+  gst_pad_set_active(sink, TRUE);
+  ASSERT_EQ(gst_pad_link(src, sink), GST_PAD_LINK_OK);
+  stream->LinkInputPad(src, 0);
+
+  GstSegment segment;
+  gst_segment_init(&segment, GST_FORMAT_BYTES);
+  gst_pad_push_event(src, gst_event_new_stream_start("probe_bench"));
+  gst_pad_push_event(src, gst_event_new_segment(&segment));
+
+  GstBuffer* datagram = gst_buffer_new_allocate(nullptr, datagram_size, nullptr);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < packets; ++i) {
+    ASSERT_EQ(gst_pad_push(src, gst_buffer_ref(datagram)), GST_FLOW_OK);
+  }
+  auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  std::cout << "buffers: " << packets * 1000000000ULL / ns.count() << " packets/s per core" << std::endl;
+  ASSERT_EQ(stats.input[0].GetTotalBytes(), packets * datagram_size);
+
+  start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < packets; i += batch) {
+    GstBufferList* list = gst_buffer_list_new_sized(batch);
+    for (guint j = 0; j < batch; ++j) {
+      gst_buffer_list_add(list, gst_buffer_ref(datagram));
+    }
+    ASSERT_EQ(gst_pad_push_list(src, list), GST_FLOW_OK);
+  }
+  ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+  std::cout << "buffer lists of " << batch << ": " << packets * 1000000000ULL / ns.count() << " packets/s per core"
+            << std::endl;
+  ASSERT_EQ(stats.input[0].GetTotalBytes(), 2 * packets * datagram_size);
+
+  gst_buffer_unref(datagram);
+  delete stream;
+  gst_object_unref(src);
+  gst_object_unref(sink);
+}
+
+namespace {
+bool HaveElements(const std::vector<const char*>& names) {
+  for (const char* name : names) {
+    GstElementFactory* factory = gst_element_factory_find(name);
+    if (!factory) {
+      std::cout << "skipped, no " << name << std::endl;
+      return false;
+    }
+    gst_object_unref(factory);
+  }
+  return true;
+}
+
+void link_pad_added_callback(GstElement* element, GstPad* pad, gpointer user_data) {
+  UNUSED(element);
+  GstElement* next = static_cast<GstElement*>(user_data);
+  GstPad* sink_pad = gst_element_get_static_pad(next, "sink");
+  if (!gst_pad_is_linked(sink_pad)) {
+    gst_pad_link(pad, sink_pad);  // first compatible pad wins, others stay unlinked
+  }
+  gst_object_unref(sink_pad);
+}
+
+// input part of the builder pipeline: src ! demuxer ! demuxed video line ! fakesink or src ! decodebin ! fakesink
+GstElement* BuildInputPipeline(iptv_cloud::stream::streams::builders::EncodingStreamBuilder* builder) {
+  builder->BuildInput();
+  iptv_cloud::stream::elements::Element* demuxer =
+      builder->GetElementByName(common::MemSPrintf(DEMUXER_NAME_1U, 0));
+  iptv_cloud::stream::elements::Element* dynamic =
+      demuxer ? demuxer : builder->GetElementByName(common::MemSPrintf(DECODEBIN_NAME_1U, 0));
+  if (!dynamic) {
+    return nullptr;
+  }
+
+  iptv_cloud::stream::elements::Element* sink = iptv_cloud::stream::elements::sink::make_fake_sink(0);
+  builder->ElementAdd(sink);
+  iptv_cloud::stream::elements::Element* head = sink;
+  if (demuxer) {
+    iptv_cloud::stream::elements_line_t line = builder->BuildVideoDemuxedLine();
+    line.push_back(sink);
+    for (size_t i = 0; i + 1 < line.size(); ++i) {
+      builder->ElementAdd(line[i]);
+    }
+    for (size_t i = 0; i + 1 < line.size(); ++i) {
+      builder->ElementLink(line[i], line[i + 1]);
+    }
+    head = line.front();
+  }
+  g_signal_connect(dynamic->GetGstElement(), "pad-added", G_CALLBACK(link_pad_added_callback), head->GetGstElement());
+  return GST_ELEMENT(gst_element_get_parent(head->GetGstElement()));
+}
+
+// seconds from NULL to PLAYING, sink prerolled means first buffer arrived
+double MeasureRestart(GstElement* pipeline, size_t restarts) {
+  if (!pipeline) {
+    return -1;
+  }
+
+  GstBus* bus = gst_element_get_bus(pipeline);
+  auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < restarts; ++i) {
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    const GstMessageType types = static_cast<GstMessageType>(GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+    GstMessage* msg = gst_bus_timed_pop_filtered(bus, 5 * GST_SECOND, types);
+    bool prerolled = msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ASYNC_DONE;
+    if (msg) {
+      gst_message_unref(msg);
+    }
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    if (!prerolled) {
+      gst_object_unref(bus);
+      gst_object_unref(pipeline);
+      return -1;
+    }
+  }
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  gst_object_unref(bus);
+  gst_object_unref(pipeline);
+  return static_cast<double>(ms.count()) / restarts;
+}
+}  // namespace
+
+TEST(SrcDecodeStreamBuilder, known_input_format) {
+  gst_init(nullptr, nullptr);
+  const iptv_cloud::input_t input = {iptv_cloud::InputUri(0, common::uri::Url("udp://239.0.0.1:5000"))};
+  const iptv_cloud::stream::Config config(iptv_cloud::RELAY, 10, input, iptv_cloud::output_t());
+  const iptv_cloud::stream::streams::AudioVideoConfig av_config(config);
+  const std::string h264 = iptv_cloud::stream::elements::parser::ElementH264Parse::GetPluginName();
+  const std::string h265 = iptv_cloud::stream::elements::parser::ElementH265Parse::GetPluginName();
+  const std::string aac = iptv_cloud::stream::elements::parser::ElementAACParse::GetPluginName();
+
+  iptv_cloud::stream::streams::RelayConfig relay(av_config);
+  iptv_cloud::stream::streams::builders::RelayStreamBuilder relay_builder(&relay, nullptr);
+  ASSERT_FALSE(relay_builder.IsKnownInputFormat());  // default parsers are guesses
+  relay.SetVideoParser(h264);
+  ASSERT_FALSE(relay_builder.IsKnownInputFormat());
+  relay.SetAudioParser(aac);
+  ASSERT_TRUE(relay_builder.IsKnownInputFormat());
+  relay.SetVideoParser(iptv_cloud::stream::elements::parser::ElementTsParse::GetPluginName());
+  ASSERT_FALSE(relay_builder.IsKnownInputFormat());
+  relay.SetVideoParser(h265);
+  ASSERT_TRUE(relay_builder.IsKnownInputFormat());
+  relay.SetIsAvFormat(true);
+  ASSERT_FALSE(relay_builder.IsKnownInputFormat());
+
+  iptv_cloud::stream::streams::EncodingConfig encoding(av_config);
+  iptv_cloud::stream::streams::builders::EncodingStreamBuilder encoding_builder(&encoding, nullptr);
+  ASSERT_FALSE(encoding_builder.IsKnownInputFormat());
+  encoding.SetInputVideoParser(h265);
+  encoding.SetInputAudioParser(aac);
+  ASSERT_FALSE(encoding_builder.IsKnownInputFormat());  // no demuxed decoder for h265
+  encoding.SetRelayVideo(true);
+  ASSERT_TRUE(encoding_builder.IsKnownInputFormat());
+  encoding.SetRelayVideo(false);
+  encoding.SetInputVideoParser(h264);
+  ASSERT_TRUE(encoding_builder.IsKnownInputFormat());
+  encoding.SetHaveAudio(false);
+  encoding.SetInputAudioParser(std::string());
+  ASSERT_TRUE(encoding_builder.IsKnownInputFormat());
+}
+
+TEST(Pipeline, DISABLED_restart_latency_benchmark) {
+  gst_init(nullptr, nullptr);
+  if (!HaveElements({"videotestsrc", "x264enc", "mpegtsmux", "decodebin", "tsdemux", "h264parse", "avdec_h264"})) {
+    return;
+  }
+
+  char path[] = "/tmp/restart_bench_XXXXXX.ts";
+  int fd = mkstemps(path, 3);
+  ASSERT_NE(fd, -1);
+  close(fd);
+  GstElement* gen = gst_parse_launch(
+      common::MemSPrintf("videotestsrc num-buffers=50 ! video/x-raw,width=640,height=360 ! x264enc ! mpegtsmux ! "
+                         "filesink location=%s",
+                         path)
+          .c_str(),
+      nullptr);
+  ASSERT_TRUE(gen);
+  gst_element_set_state(gen, GST_STATE_PLAYING);
+  GstBus* bus = gst_element_get_bus(gen);
+  const GstMessageType types = static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR);
+  GstMessage* msg = gst_bus_timed_pop_filtered(bus, 30 * GST_SECOND, types);
+  ASSERT_TRUE(msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_EOS);
+  gst_message_unref(msg);
+  gst_object_unref(bus);
+  gst_element_set_state(gen, GST_STATE_NULL);
+  gst_object_unref(gen);
+
+  const iptv_cloud::input_t input = {iptv_cloud::InputUri(0, common::uri::Url(std::string("file://") + path))};
+  const iptv_cloud::stream::Config config(iptv_cloud::ENCODE, 10, input, iptv_cloud::output_t());
+  iptv_cloud::stream::streams::EncodingConfig decodebin_config((iptv_cloud::stream::streams::AudioVideoConfig(config)));
+  decodebin_config.SetHaveAudio(false);
+  iptv_cloud::stream::streams::EncodingConfig demuxer_config(decodebin_config);
+  demuxer_config.SetInputVideoParser(iptv_cloud::stream::elements::parser::ElementH264Parse::GetPluginName());
+  iptv_cloud::stream::streams::builders::EncodingStreamBuilder decodebin_builder(&decodebin_config, nullptr);
+  iptv_cloud::stream::streams::builders::EncodingStreamBuilder demuxer_builder(&demuxer_config, nullptr);
+  ASSERT_FALSE(decodebin_builder.IsKnownInputFormat());
+  ASSERT_TRUE(demuxer_builder.IsKnownInputFormat());
+
+  const size_t restarts = 20;
+  double decodebin_ms = MeasureRestart(BuildInputPipeline(&decodebin_builder), restarts);
+  double demuxer_ms = MeasureRestart(BuildInputPipeline(&demuxer_builder), restarts);
+  unlink(path);
+  ASSERT_GE(decodebin_ms, 0);
+  ASSERT_GE(demuxer_ms, 0);
+  std::cout << "decodebin: " << decodebin_ms << " ms per restart" << std::endl;
+  std::cout << "tsdemux: " << demuxer_ms << " ms per restart" << std::endl;
+}
+
+namespace {
+// milliseconds from connect of a new client to its first decoded frame
+double MeasureZap(gint port) {
+  const std::string launch = common::MemSPrintf(
+      "tcpclientsrc host=127.0.0.1 port=%d ! tsdemux ! h264parse ! avdec_h264 output-corrupt=false ! fakesink", port);
+  GstElement* client = gst_parse_launch(launch.c_str(), nullptr);
+  if (!client) {
+    return -1;
+  }
+
+  GstBus* bus = gst_element_get_bus(client);
+  auto start = std::chrono::steady_clock::now();
+  gst_element_set_state(client, GST_STATE_PLAYING);
+  const GstMessageType types = static_cast<GstMessageType>(GST_MESSAGE_ASYNC_DONE | GST_MESSAGE_ERROR);
+  GstMessage* msg = gst_bus_timed_pop_filtered(bus, 10 * GST_SECOND, types);
+  auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+  bool decoded = msg && GST_MESSAGE_TYPE(msg) == GST_MESSAGE_ASYNC_DONE;
+  if (msg) {
+    gst_message_unref(msg);
+  }
+  gst_element_set_state(client, GST_STATE_NULL);
+  gst_object_unref(bus);
+  gst_object_unref(client);
+  return decoded ? static_cast<double>(ms.count()) : -1;
+}
+}  // namespace
+
+TEST(Pipeline, DISABLED_zap_time_benchmark) {
+  gst_init(nullptr, nullptr);
+  if (!HaveElements({"videotestsrc", "x264enc", "mpegtsmux", "tcpserversink", "tcpclientsrc", "tsdemux", "h264parse",
+                     "avdec_h264"})) {
+    return;
+  }
+
+  const size_t zaps = 5;
+  for (bool gop_cache : {false, true}) {
+    GstElement* pipeline = gst_parse_launch(
+        "videotestsrc is-live=true ! video/x-raw,width=640,height=360,framerate=25/1 ! "
+        "x264enc tune=zerolatency speed-preset=ultrafast key-int-max=50 ! mpegtsmux name=mux",
+        nullptr);
+    ASSERT_TRUE(pipeline);
+    iptv_cloud::stream::elements::sink::ElementTCPServerSink* sink =
+        iptv_cloud::stream::elements::sink::make_sink<iptv_cloud::stream::elements::sink::ElementTCPServerSink>(0);
+    sink->SetHost("127.0.0.1");
+    sink->SetPort(0);
+    if (gop_cache) {
+      sink->EnableGopCache();
+    }
+    gst_bin_add(GST_BIN(pipeline), sink->GetGstElement());
+    GstElement* mux = gst_bin_get_by_name(GST_BIN(pipeline), "mux");
+    ASSERT_TRUE(gst_element_link(mux, sink->GetGstElement()));
+    gst_object_unref(mux);
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    gst_element_get_state(pipeline, nullptr, nullptr, 5 * GST_SECOND);
+
+    gint port = 0;
+    g_object_get(sink->GetGstElement(), "current-port", &port, nullptr);
+    double total_ms = 0;
+    for (size_t i = 0; i < zaps; ++i) {
+      usleep(700000);  // new clients come at any point of 2 seconds gop
+      double ms = MeasureZap(port);
+      ASSERT_GE(ms, 0);
+      total_ms += ms;
+    }
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    delete sink;
+    gst_object_unref(pipeline);
+    std::cout << (gop_cache ? "gop cache" : "no cache") << ": " << total_ms / zaps << " ms to first frame" << std::endl;
+  }
+}
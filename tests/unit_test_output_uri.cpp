@@ -46,3 +46,21 @@ TEST(OutputUri, ConvertFromString) {
   ASSERT_FALSE(err);
   // ASSERT_EQ(conv, uri_json);
 }
+
+TEST(OutputUri, HlsType) {
+  const std::string uri_json = "{ \"id\": 2, \"uri\": \"http://localhost/master.m3u8\", \"http_root\": \"" HTTP_OUTPUT
+                               "\", \"hls_type\": 1 }";
+  iptv_cloud::OutputUri uri;
+  common::Error err = uri.DeSerializeFromString(uri_json);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(uri.GetHlsType(), iptv_cloud::OutputUri::LL_HLS);
+
+  std::string conv;
+  err = uri.SerializeToString(&conv);
+  ASSERT_FALSE(err);
+  iptv_cloud::OutputUri copy;
+  err = copy.DeSerializeFromString(conv);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(copy, uri);
+  ASSERT_EQ(iptv_cloud::OutputUri().GetHlsType(), iptv_cloud::OutputUri::HLS_PULL);
+}
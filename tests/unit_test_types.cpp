@@ -14,6 +14,7 @@
 
 #include <gtest/gtest.h>
 
+#include "stream_commands_info/profile_info.h"
 #include "stream_commands_info/statistic_info.h"
 
 TEST(StreamStructInfo, SerializeDeSerialize) {
@@ -45,3 +46,40 @@ TEST(StreamStructInfo, SerializeDeSerialize) {
 
   json_object_put(serialized);
 }
+
+TEST(ProfileInfo, SerializeDeSerialize) {
+  iptv_cloud::ElementProfile element;
+  element.name = "videoconvert0";
+  element.factory = "videoconvert";
+  iptv_cloud::ProfileSample sample;
+  sample.timestamp = 1000;
+  sample.buffers = 25;
+  sample.bytes = 25 * 3110400;
+  sample.busy_nsec = 450000000;
+  sample.max_nsec = 30000000;
+  element.samples.push_back(sample);
+  sample.timestamp = 2000;
+  sample.queue_buffers = 3;
+  sample.queue_nsec = 120000000;
+  element.samples.push_back(sample);
+
+  iptv_cloud::ProfileInfo pinf("test", {element});
+  json_object* serialized = NULL;
+  common::Error err = pinf.Serialize(&serialized);
+  ASSERT_FALSE(err);
+
+  iptv_cloud::ProfileInfo pinf2;
+  err = pinf2.DeSerialize(serialized);
+  ASSERT_FALSE(err);
+  ASSERT_EQ(pinf.GetStreamID(), pinf2.GetStreamID());
+  const iptv_cloud::ProfileInfo::elements_t elements = pinf2.GetElements();
+  ASSERT_EQ(elements.size(), 1);
+  ASSERT_EQ(elements[0].name, element.name);
+  ASSERT_EQ(elements[0].factory, element.factory);
+  ASSERT_EQ(elements[0].samples.size(), 2);
+  ASSERT_EQ(elements[0].samples[0].busy_nsec, 450000000);
+  ASSERT_EQ(elements[0].samples[1].timestamp, 2000);
+  ASSERT_EQ(elements[0].samples[1].queue_nsec, 120000000);
+
+  json_object_put(serialized);
+}
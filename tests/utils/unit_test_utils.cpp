@@ -1,11 +1,842 @@
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
 #include <gtest/gtest.h>
 
+#include "utils/adopt_socket.h"
+#include "utils/async_logger.h"
 #include "utils/chunk_info.h"
+#include "utils/hls_shm.h"
+#include "utils/ll_hls.h"
+#include "utils/mpegts.h"
+#include "utils/shm_ring.h"
 
 #define TEST_PLAYLIST PROJECT_TEST_SOURCES_DIR "/playlist.m3u8"
 #define NEW_PLAYLIST PROJECT_TEST_SOURCES_DIR "/test_write.m3u8"
+#define ASYNC_LOG "/tmp/async_logger_test.log"
+#define SHM_RING "unit_test_shm_ring"
+#define HLS_SHM_STORE "unit_test_hls_shm"
+#define ADOPT_SOCKET "/tmp/unit_test_adopt.sock"
 
 TEST(ChunkInfo, double) {
   iptv_cloud::utils::ChunkInfo ch("1497615343667_segment10012.ts", 11.43 * iptv_cloud::utils::ChunkInfo::SECOND, 10012);
   ASSERT_EQ(ch.GetDurationInSecconds(), 11.43);
 }
+
+namespace {
+void MakeTsPacket(uint8_t* packet, uint16_t pid, uint8_t cc) {
+  memset(packet, 0xFF, iptv_cloud::utils::mpegts::TS_PACKET_SIZE);
+  packet[0] = iptv_cloud::utils::mpegts::TS_SYNC_BYTE;
+  packet[1] = (pid >> 8) & 0x1F;
+  packet[2] = pid & 0xFF;
+  packet[3] = 0x10 | (cc & 0x0F);
+}
+}  // namespace
+
+TEST(MpegTs, continuity) {
+  uint8_t packet[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  iptv_cloud::utils::mpegts::ContinuityChecker checker;
+  for (uint8_t cc = 0; cc < 20; ++cc) {
+    MakeTsPacket(packet, 256, cc);
+    ASSERT_TRUE(checker.CheckPacket(packet));
+  }
+  ASSERT_EQ(checker.GetErrors(), 0u);
+
+  MakeTsPacket(packet, 256, 3);  // duplicate allowed once
+  ASSERT_TRUE(checker.CheckPacket(packet));
+  ASSERT_FALSE(checker.CheckPacket(packet));
+  MakeTsPacket(packet, 256, 7);  // lost packets
+  ASSERT_FALSE(checker.CheckPacket(packet));
+  MakeTsPacket(packet, iptv_cloud::utils::mpegts::TS_NULL_PID, 0);
+  ASSERT_TRUE(checker.CheckPacket(packet));
+  ASSERT_EQ(checker.GetErrors(), 2u);
+}
+
+TEST(MpegTs, pcr) {
+  uint8_t packet[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  MakeTsPacket(packet, 256, 0);
+  uint64_t pcr = 0;
+  ASSERT_FALSE(iptv_cloud::utils::mpegts::GetPcr(packet, &pcr));
+
+  const uint64_t base = 90000;  // 1 second
+  packet[3] = 0x30;
+  packet[4] = 7;
+  packet[5] = 0x10;
+  packet[6] = (base >> 25) & 0xFF;
+  packet[7] = (base >> 17) & 0xFF;
+  packet[8] = (base >> 9) & 0xFF;
+  packet[9] = (base >> 1) & 0xFF;
+  packet[10] = ((base & 0x01) << 7) | 0x7E;
+  packet[11] = 0;
+  ASSERT_TRUE(iptv_cloud::utils::mpegts::GetPcr(packet, &pcr));
+  ASSERT_EQ(pcr, base * 300);
+
+  iptv_cloud::utils::mpegts::PcrPacer pacer;
+  ASSERT_EQ(pacer.GetSendTime(pcr, 1000), 1000);
+  ASSERT_EQ(pacer.GetSendTime(pcr + iptv_cloud::utils::mpegts::TS_PCR_HZ / 10, 1000), 101000);
+  ASSERT_EQ(pacer.GetSendTime(pcr + iptv_cloud::utils::mpegts::TS_PCR_HZ * 10, 2000), 2000);  // jump
+  ASSERT_EQ(pacer.GetResets(), 1u);
+}
+
+namespace {
+void SetTsPcr(uint8_t* packet, uint64_t pcr) {
+  const uint64_t base = pcr / 300;
+  packet[3] |= 0x20;
+  packet[4] = 7;
+  packet[5] = 0x10;
+  packet[6] = (base >> 25) & 0xFF;
+  packet[7] = (base >> 17) & 0xFF;
+  packet[8] = (base >> 9) & 0xFF;
+  packet[9] = (base >> 1) & 0xFF;
+  packet[10] = ((base & 0x01) << 7) | 0x7E | ((pcr % 300) >> 8);
+  packet[11] = (pcr % 300) & 0xFF;
+}
+}  // namespace
+
+TEST(MpegTs, analyzer) {
+  const size_t packet_size = iptv_cloud::utils::mpegts::TS_PACKET_SIZE;
+  const uint64_t pcr_step = iptv_cloud::utils::mpegts::TS_PCR_HZ / 50;  // 20ms
+  std::vector<uint8_t> ts(37, 0x47);  // garbage before sync
+  uint8_t packet[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  uint8_t video_cc = 0;
+  for (size_t i = 0; i < 100; ++i) {
+    MakeTsPacket(packet, 0, i & 0x0F);
+    ts.insert(ts.end(), packet, packet + packet_size);
+    MakeTsPacket(packet, 256, video_cc++);
+    if (i == 50) {  // lost video packet
+      video_cc++;
+    }
+    SetTsPcr(packet, pcr_step * i + (i == 70 ? pcr_step * 3 / 2 : 0));  // 50ms gap, then backward
+    ts.insert(ts.end(), packet, packet + packet_size);
+    MakeTsPacket(packet, 257, i & 0x0F);
+    if (i == 80) {
+      packet[1] |= 0x80;  // transport error indicator
+    } else if (i == 90) {
+      packet[0] = 0;  // corrupted sync byte
+    }
+    ts.insert(ts.end(), packet, packet + packet_size);
+  }
+
+  iptv_cloud::utils::mpegts::TsAnalyzer analyzer;
+  for (size_t pos = 0, chunk = 1; pos < ts.size(); pos += chunk, chunk = chunk * 7 % 1000 + 1) {
+    analyzer.Feed(ts.data() + pos, std::min(chunk, ts.size() - pos), pos * 100);
+  }
+  ASSERT_TRUE(analyzer.IsLocked());
+  ASSERT_EQ(iptv_cloud::utils::mpegts::FindSyncByte(ts.data() + 41, 100), nullptr);
+  ASSERT_EQ(iptv_cloud::utils::mpegts::FindSyncByte(ts.data() + 41, 300), ts.data() + 37 + packet_size);
+
+  iptv_cloud::utils::mpegts::TsQuality quality;
+  analyzer.Sample(1000, &quality);
+  ASSERT_EQ(quality.packets, 299u);
+  ASSERT_EQ(quality.sync_byte_errors, 1u);
+  ASSERT_EQ(quality.sync_losses, 0u);
+  ASSERT_EQ(quality.cc_errors, 2u);  // lost packet and skipped corrupted one
+  ASSERT_EQ(quality.pat_errors, 0u);
+  ASSERT_EQ(quality.pcr_pid, 256);
+  ASSERT_EQ(quality.transport_errors, 1u);
+  ASSERT_EQ(quality.pcr_repetition_errors, 1u);
+  ASSERT_EQ(quality.pcr_interval_max_msec, 50u);
+  ASSERT_EQ(quality.pcr_discontinuity_errors, 1u);
+  ASSERT_EQ(quality.pids_count, 3u);
+  ASSERT_EQ(quality.pids[0].bytes_per_second, 100 * packet_size);
+  ASSERT_EQ(quality.pids[2].pid, 257);
+  ASSERT_EQ(quality.pids[2].bytes_per_second, 99 * packet_size);
+
+  analyzer.Sample(1000, &quality);  // no new data
+  ASSERT_EQ(quality.pids_count, 0u);
+}
+
+TEST(MpegTs, analyzer_pat_stopped) {
+  uint8_t packet[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  iptv_cloud::utils::mpegts::TsAnalyzer analyzer;
+  uint8_t pat_cc = 0;
+  uint8_t video_cc = 0;
+  for (size_t i = 0; i < 300; ++i) {  // packet every 10ms, PAT every 100ms during first second
+    if (i < 100 && i % 10 == 0) {
+      MakeTsPacket(packet, 0, pat_cc++);
+    } else {
+      MakeTsPacket(packet, 256, video_cc++);
+    }
+    analyzer.Feed(packet, sizeof(packet), i * 10000);
+  }
+
+  iptv_cloud::utils::mpegts::TsQuality quality;
+  analyzer.Sample(3000, &quality);
+  ASSERT_EQ(quality.packets, 300u);
+  ASSERT_EQ(quality.pat_errors, 4u);  // last PAT at 900ms, then errors at 1410, 1920, 2430 and 2940ms
+}
+
+namespace {
+void MakePsiPacket(uint8_t* packet, uint16_t pid, const std::vector<uint8_t>& section) {
+  MakeTsPacket(packet, pid, 0);
+  packet[1] |= 0x40;  // payload_unit_start_indicator
+  packet[4] = 0;      // pointer_field
+  memcpy(packet + 5, section.data(), section.size());
+}
+}  // namespace
+
+TEST(MpegTs, gop_cache) {
+  const size_t packet_size = iptv_cloud::utils::mpegts::TS_PACKET_SIZE;
+  uint8_t pat[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  // program 1 on pmt pid 0x1000, crc not checked
+  MakePsiPacket(pat, 0, {0x00, 0xB0, 0x0D, 0x00, 0x01, 0xC1, 0x00, 0x00, 0x00, 0x01, 0xF0, 0x00, 0, 0, 0, 0});
+  uint8_t pmt[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  // pcr 0x100, aac 0x101, h264 0x100
+  MakePsiPacket(pmt, 0x1000, {0x02, 0xB0, 0x17, 0x00, 0x01, 0xC1, 0x00, 0x00, 0xE1, 0x00, 0xF0, 0x00, 0x0F, 0xE1,
+                              0x01, 0xF0, 0x00, 0x1B, 0xE1, 0x00, 0xF0, 0x00, 0, 0, 0, 0});
+  uint8_t key[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  MakeTsPacket(key, 0x100, 0);
+  key[1] |= 0x40;
+  key[3] |= 0x20;
+  key[4] = 1;
+  key[5] = 0x40;  // random_access_indicator
+  uint8_t delta[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  MakeTsPacket(delta, 0x100, 1);
+  uint8_t audio_key[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  memcpy(audio_key, key, packet_size);
+  audio_key[2] = 0x01;
+
+  iptv_cloud::utils::mpegts::GopCache cache;
+  uint8_t tables[iptv_cloud::utils::mpegts::GopCache::TABLES_SIZE];
+  ASSERT_EQ(cache.Feed(key, packet_size), iptv_cloud::utils::mpegts::GopCache::GOP_UNKNOWN);
+  ASSERT_EQ(cache.GetTables(tables), 0u);
+  ASSERT_EQ(cache.Feed(pat, packet_size), iptv_cloud::utils::mpegts::GopCache::GOP_UNKNOWN);
+  ASSERT_EQ(cache.Feed(pmt, packet_size), iptv_cloud::utils::mpegts::GopCache::GOP_CONTINUE);
+  ASSERT_EQ(cache.GetVideoPid(), 0x100);
+  ASSERT_EQ(cache.GetTables(tables), 0u);  // no gop yet
+
+  std::vector<uint8_t> gop(delta, delta + packet_size);
+  gop.insert(gop.end(), key, key + packet_size);  // keyframe in the middle of buffer
+  ASSERT_EQ(cache.Feed(gop.data(), gop.size()), iptv_cloud::utils::mpegts::GopCache::GOP_START);
+  ASSERT_EQ(cache.GetTables(tables), sizeof(tables));
+  ASSERT_EQ(memcmp(tables, pat, packet_size), 0);
+  ASSERT_EQ(memcmp(tables + packet_size, pmt, packet_size), 0);
+  ASSERT_EQ(cache.Feed(delta, packet_size), iptv_cloud::utils::mpegts::GopCache::GOP_CONTINUE);
+  ASSERT_EQ(cache.Feed(audio_key, packet_size), iptv_cloud::utils::mpegts::GopCache::GOP_CONTINUE);
+  ASSERT_EQ(cache.GetGopBytes(), 4 * packet_size);
+  ASSERT_EQ(cache.GetGops(), 1u);
+
+  // tables repeated inside gop, injected ones keep counters sent before gop
+  pat[3] = (pat[3] & 0xF0) | 1;
+  pmt[3] = (pmt[3] & 0xF0) | 1;
+  ASSERT_EQ(cache.Feed(pat, packet_size), iptv_cloud::utils::mpegts::GopCache::GOP_CONTINUE);
+  ASSERT_EQ(cache.Feed(pmt, packet_size), iptv_cloud::utils::mpegts::GopCache::GOP_CONTINUE);
+  ASSERT_EQ(cache.GetTables(tables), sizeof(tables));
+  ASSERT_EQ(iptv_cloud::utils::mpegts::GetContinuityCounter(tables), 0);
+  ASSERT_EQ(iptv_cloud::utils::mpegts::GetContinuityCounter(tables + packet_size), 0);
+
+  // keyframe buffer with tables in front, injected ones go before them
+  std::vector<uint8_t> next_gop(pat, pat + packet_size);
+  next_gop[3] = (next_gop[3] & 0xF0) | 2;
+  next_gop.insert(next_gop.end(), key, key + packet_size);
+  ASSERT_EQ(cache.Feed(next_gop.data(), next_gop.size()), iptv_cloud::utils::mpegts::GopCache::GOP_START);
+  ASSERT_EQ(cache.GetTables(tables), sizeof(tables));
+  ASSERT_EQ(iptv_cloud::utils::mpegts::GetContinuityCounter(tables), 1);
+  ASSERT_EQ(iptv_cloud::utils::mpegts::GetContinuityCounter(tables + packet_size), 1);
+  ASSERT_EQ(memcmp(tables + packet_size, pmt, packet_size), 0);
+
+  cache.Reset();
+  ASSERT_EQ(cache.Feed(key, packet_size), iptv_cloud::utils::mpegts::GopCache::GOP_UNKNOWN);
+
+  // aac 0x101 only, tables go in front of any data
+  uint8_t audio_pmt[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  MakePsiPacket(audio_pmt, 0x1000, {0x02, 0xB0, 0x12, 0x00, 0x01, 0xC1, 0x00, 0x00, 0xE1, 0x01, 0xF0, 0x00, 0x0F,
+                                    0xE1, 0x01, 0xF0, 0x00, 0, 0, 0, 0});
+  ASSERT_EQ(cache.Feed(pat, packet_size), iptv_cloud::utils::mpegts::GopCache::GOP_UNKNOWN);
+  ASSERT_EQ(cache.Feed(audio_pmt, packet_size), iptv_cloud::utils::mpegts::GopCache::GOP_UNKNOWN);
+  ASSERT_EQ(cache.GetVideoPid(), iptv_cloud::utils::mpegts::TS_NULL_PID);
+  ASSERT_EQ(cache.GetTables(tables), sizeof(tables));
+  ASSERT_EQ(iptv_cloud::utils::mpegts::GetContinuityCounter(tables), 1);
+}
+
+namespace {
+class MemoryHlsStore : public iptv_cloud::utils::IHlsStore {
+ public:
+  common::ErrnoError Put(const std::string& name, const uint8_t* data, size_t size) override {
+    files[name] = std::string(reinterpret_cast<const char*>(data), size);
+    return common::ErrnoError();
+  }
+
+  common::ErrnoError Remove(const std::string& name) override {
+    files.erase(name);
+    return common::ErrnoError();
+  }
+
+  std::map<std::string, std::string> files;
+};
+}  // namespace
+
+TEST(LLHls, packager) {
+  const size_t packet_size = iptv_cloud::utils::mpegts::TS_PACKET_SIZE;
+  uint8_t pat[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  MakePsiPacket(pat, 0, {0x00, 0xB0, 0x0D, 0x00, 0x01, 0xC1, 0x00, 0x00, 0x00, 0x01, 0xF0, 0x00, 0, 0, 0, 0});
+  uint8_t pmt[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  MakePsiPacket(pmt, 0x1000, {0x02, 0xB0, 0x17, 0x00, 0x01, 0xC1, 0x00, 0x00, 0xE1, 0x00, 0xF0, 0x00, 0x0F, 0xE1,
+                              0x01, 0xF0, 0x00, 0x1B, 0xE1, 0x00, 0xF0, 0x00, 0, 0, 0, 0});
+
+  MemoryHlsStore store;
+  iptv_cloud::utils::LLHlsPackager packager("master.m3u8", &store);
+  ASSERT_FALSE(packager.Feed(pat, packet_size));
+  ASSERT_FALSE(packager.Feed(pmt, packet_size));
+
+  // video frame every 100ms, keyframe every 2s
+  auto feed_until = [&packager](uint64_t from_msec, uint64_t to_msec) {
+    for (uint64_t msec = from_msec; msec <= to_msec; msec += 100) {
+      uint8_t frame[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+      MakeTsPacket(frame, 0x100, msec / 100);
+      SetTsPcr(frame, msec * (iptv_cloud::utils::mpegts::TS_PCR_HZ / 1000));
+      if (msec % 2000 == 0) {
+        frame[1] |= 0x40;
+        frame[5] |= 0x40;  // random_access_indicator
+      }
+      ASSERT_FALSE(packager.Feed(frame, sizeof(frame)));
+    }
+  };
+
+  feed_until(0, 4500);
+  ASSERT_EQ(packager.GetSegments().size(), 2u);
+  ASSERT_EQ(packager.GetSegments()[0].parts.size(), 3u);  // 0.8 + 0.8 + 0.4
+  ASSERT_TRUE(store.files.count("master_0.ts"));
+  ASSERT_TRUE(store.files.count("master_0.2.ts"));
+  ASSERT_TRUE(store.files.count("master_2.0.ts") == 0);  // preload hint
+  ASSERT_EQ(store.files["master_1.ts"].compare(0, packet_size, std::string(pat, pat + packet_size)), 0);
+
+  const std::string playlist = store.files["master.m3u8"];
+  ASSERT_NE(playlist.find("#EXT-X-PART:DURATION=0.800,URI=\"master_0.0.ts\",INDEPENDENT=YES\n"), std::string::npos);
+  ASSERT_NE(playlist.find("#EXTINF:2.000,\nmaster_0.ts\n"), std::string::npos);
+  ASSERT_NE(playlist.find("#EXT-X-PRELOAD-HINT:TYPE=PART,URI=\"master_2.0.ts\"\n"), std::string::npos);
+
+  iptv_cloud::utils::LLHlsPlaylistState state;
+  ASSERT_TRUE(iptv_cloud::utils::ParseLLHlsPlaylist(playlist, &state));
+  ASSERT_EQ(state.media_sequence, 0u);
+  ASSERT_EQ(state.next_msn, 2u);
+  ASSERT_EQ(state.next_part, 0u);
+  ASSERT_EQ(state.target_duration, 4u);
+  ASSERT_EQ(iptv_cloud::utils::CheckBlockingReload(state, 1, -1), iptv_cloud::utils::BLOCKING_READY);
+  ASSERT_EQ(iptv_cloud::utils::CheckBlockingReload(state, 2, 0), iptv_cloud::utils::BLOCKING_WAIT);
+  ASSERT_EQ(iptv_cloud::utils::CheckBlockingReload(state, 3, -1), iptv_cloud::utils::BLOCKING_WAIT);
+  ASSERT_EQ(iptv_cloud::utils::CheckBlockingReload(state, 4, -1), iptv_cloud::utils::BLOCKING_TOO_FAR);
+
+  feed_until(4600, 4800);
+  ASSERT_TRUE(iptv_cloud::utils::ParseLLHlsPlaylist(store.files["master.m3u8"], &state));
+  ASSERT_EQ(state.next_part, 1u);
+  ASSERT_EQ(iptv_cloud::utils::CheckBlockingReload(state, 2, 0), iptv_cloud::utils::BLOCKING_READY);
+
+  feed_until(4900, 20000);
+  ASSERT_EQ(packager.GetMediaSequence(), 4u);
+  ASSERT_EQ(packager.GetSegments().size(), static_cast<size_t>(iptv_cloud::utils::LLHlsPackager::PLAYLIST_SEGMENTS));
+  ASSERT_TRUE(store.files.count("master_1.ts") == 0);
+  ASSERT_TRUE(store.files.count("master_1.0.ts") == 0);
+  ASSERT_TRUE(store.files.count("master_2.ts"));  // evicted, but kept for a while
+}
+
+TEST(LLHls, long_gop) {
+  const size_t packet_size = iptv_cloud::utils::mpegts::TS_PACKET_SIZE;
+  uint8_t pat[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  MakePsiPacket(pat, 0, {0x00, 0xB0, 0x0D, 0x00, 0x01, 0xC1, 0x00, 0x00, 0x00, 0x01, 0xF0, 0x00, 0, 0, 0, 0});
+  uint8_t pmt[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  MakePsiPacket(pmt, 0x1000, {0x02, 0xB0, 0x17, 0x00, 0x01, 0xC1, 0x00, 0x00, 0xE1, 0x00, 0xF0, 0x00, 0x0F, 0xE1,
+                              0x01, 0xF0, 0x00, 0x1B, 0xE1, 0x00, 0xF0, 0x00, 0, 0, 0, 0});
+
+  MemoryHlsStore store;
+  iptv_cloud::utils::LLHlsPackager packager("master.m3u8", &store);
+  ASSERT_FALSE(packager.Feed(pat, packet_size));
+  ASSERT_FALSE(packager.Feed(pmt, packet_size));
+
+  // keyframe every 6s, source ignores requested ones
+  size_t requests = 0;
+  for (uint64_t msec = 0; msec <= 12000; msec += 100) {
+    uint8_t frame[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+    MakeTsPacket(frame, 0x100, msec / 100);
+    SetTsPcr(frame, msec * (iptv_cloud::utils::mpegts::TS_PCR_HZ / 1000));
+    if (msec % 6000 == 0) {
+      frame[1] |= 0x40;
+      frame[5] |= 0x40;  // random_access_indicator
+    }
+    ASSERT_FALSE(packager.Feed(frame, sizeof(frame)));
+    if (packager.TakeKeyframeRequest()) {
+      ASSERT_EQ(msec % 6000, 2000u);  // once segment reached its minimum
+      requests++;
+    }
+  }
+
+  // cut at target duration without keyframe, then on keyframe: 4 + 2 + 4 + 2 seconds
+  ASSERT_EQ(requests, 2u);
+  const std::vector<iptv_cloud::utils::LLHlsSegment>& segments = packager.GetSegments();
+  ASSERT_EQ(segments.size(), 4u);
+  ASSERT_EQ(segments[0].duration, 4.0);
+  ASSERT_TRUE(segments[0].independent);
+  ASSERT_EQ(segments[1].duration, 2.0);
+  ASSERT_FALSE(segments[1].independent);
+  ASSERT_FALSE(segments[1].parts[0].independent);
+  ASSERT_TRUE(segments[2].independent);
+  ASSERT_FALSE(segments[3].independent);
+  ASSERT_EQ(packager.GetTargetDuration(), 4u);
+
+  const std::string playlist = store.files["master.m3u8"];
+  ASSERT_EQ(playlist.find("#EXT-X-INDEPENDENT-SEGMENTS"), std::string::npos);
+  iptv_cloud::utils::LLHlsPlaylistState state;
+  ASSERT_TRUE(iptv_cloud::utils::ParseLLHlsPlaylist(playlist, &state));
+  ASSERT_EQ(state.target_duration, 4u);
+}
+
+TEST(LLHls, blocking_reload) {
+  uint64_t msn = 0;
+  int64_t part = 0;
+  ASSERT_TRUE(iptv_cloud::utils::ParseBlockingReload("_HLS_msn=5&_HLS_part=2", &msn, &part));
+  ASSERT_EQ(msn, 5u);
+  ASSERT_EQ(part, 2);
+  ASSERT_TRUE(iptv_cloud::utils::ParseBlockingReload("_HLS_skip=YES&_HLS_msn=7", &msn, &part));
+  ASSERT_EQ(msn, 7u);
+  ASSERT_EQ(part, -1);
+  ASSERT_FALSE(iptv_cloud::utils::ParseBlockingReload("_HLS_part=2", &msn, &part));
+  ASSERT_FALSE(iptv_cloud::utils::ParseBlockingReload("_HLS_msn=x", &msn, &part));
+
+  ASSERT_TRUE(iptv_cloud::utils::IsLLHlsPartName("master_2.0.ts"));
+  ASSERT_FALSE(iptv_cloud::utils::IsLLHlsPartName("master_2.ts"));
+  ASSERT_FALSE(iptv_cloud::utils::IsLLHlsPartName("master.m3u8"));
+}
+
+namespace {
+std::string ReadLog() {
+  std::ifstream file(ASYNC_LOG);
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+void PushLine(iptv_cloud::utils::AsyncLogger* logger, const std::string& line) {
+  logger->Push(line.data(), line.size());
+}
+}  // namespace
+
+TEST(AsyncLogger, suppress_and_drop) {
+  unlink(ASYNC_LOG);
+  iptv_cloud::utils::AsyncLogger logger(ASYNC_LOG, 0, 8);
+  PushLine(&logger, "2019-05-01 10:00:01 [info] ping\n");
+  PushLine(&logger, "2019-05-01 10:00:02 [info] ping\n");
+  PushLine(&logger, "2019-05-01 10:00:03 [info] ping\n");
+  for (size_t i = 0; i < 5; ++i) {
+    PushLine(&logger, "request\n");
+  }
+  for (size_t i = 0; i < 4; ++i) {  // ring is full, writer isn't started
+    PushLine(&logger, "lost\n");
+  }
+  ASSERT_EQ(logger.GetStats().dropped, 4u);
+
+  ASSERT_FALSE(logger.Start());
+  while (logger.GetStats().written + logger.GetStats().suppressed < 8) {  // ring is free again
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  logger.AttachStreams();
+  std::cout << "console line" << std::endl;
+  logger.Stop();
+
+  const std::string expected =
+      "async logger: 4 records dropped\n"
+      "2019-05-01 10:00:01 [info] ping\n"
+      "last message repeated 2 times\n"
+      "request\n"
+      "last message repeated 4 times\n"
+      "console line\n";
+  ASSERT_EQ(ReadLog(), expected);
+  const iptv_cloud::utils::AsyncLogger::Stats stats = logger.GetStats();
+  ASSERT_EQ(stats.written, 3u);
+  ASSERT_EQ(stats.suppressed, 6u);
+
+  const size_t record_size = iptv_cloud::utils::AsyncLogger::RECORD_SIZE;
+  const std::string long_line = std::string(record_size * 2 + 10, 'x') + "\n";
+  const std::string longest(record_size * (iptv_cloud::utils::AsyncLogger::MAX_LINE_RECORDS + 1), 'y');
+  iptv_cloud::utils::AsyncLogger spilled(ASYNC_LOG, 0, 32);
+  ASSERT_FALSE(spilled.Start());
+  PushLine(&spilled, long_line);
+  PushLine(&spilled, long_line);  // parts of long lines aren't folded
+  PushLine(&spilled, longest);
+  spilled.Stop();
+  const std::string content = ReadLog();
+  ASSERT_EQ(content.substr(0, expected.size() + long_line.size() * 2), expected + long_line + long_line);
+  const std::string cut = content.substr(expected.size() + long_line.size() * 2);
+  ASSERT_EQ(cut.size(), record_size * iptv_cloud::utils::AsyncLogger::MAX_LINE_RECORDS);
+  ASSERT_EQ(cut.substr(cut.size() - 4), "...\n");
+  ASSERT_EQ(spilled.GetStats().suppressed, 0u);
+  unlink(ASYNC_LOG);
+}
+
+TEST(AsyncLogger, producers) {
+  unlink(ASYNC_LOG);
+  const size_t threads_count = 4;
+  const size_t records_count = 20000;
+  iptv_cloud::utils::AsyncLogger logger(ASYNC_LOG, 0);
+  ASSERT_FALSE(logger.Start());
+  std::vector<std::thread> threads;
+  for (size_t t = 0; t < threads_count; ++t) {
+    threads.push_back(std::thread([&logger, t, records_count]() {
+      for (size_t i = 0; i < records_count; ++i) {
+        PushLine(&logger, "thread " + std::to_string(t) + " record " + std::to_string(i) + "\n");
+      }
+    }));
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  logger.Stop();
+
+  const iptv_cloud::utils::AsyncLogger::Stats stats = logger.GetStats();
+  ASSERT_EQ(stats.written + stats.dropped, threads_count * records_count);
+  ASSERT_EQ(stats.suppressed, 0u);
+
+  std::ifstream file(ASYNC_LOG);
+  std::string line;
+  size_t records = 0;
+  while (std::getline(file, line)) {
+    if (line.compare(0, 7, "thread ") == 0) {
+      records++;
+    }
+  }
+  ASSERT_EQ(records, stats.written);
+  std::cout << threads_count * records_count << " records, written: " << stats.written
+            << ", dropped: " << stats.dropped << std::endl;
+  unlink(ASYNC_LOG);
+}
+
+TEST(ShmRing, fanout) {
+  uint8_t packet[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  uint8_t data[iptv_cloud::utils::mpegts::TS_PACKET_SIZE * 4];
+  iptv_cloud::utils::ShmRingReader not_ready(SHM_RING);
+  ASSERT_TRUE(not_ready.Open());
+
+  iptv_cloud::utils::ShmRingWriter writer(SHM_RING);
+  ASSERT_FALSE(writer.Open(sizeof(packet) * 8));
+  ASSERT_EQ(writer.GetFanout().capacity, 2048u);  // rounded up
+  iptv_cloud::utils::ShmRingWriter second(SHM_RING);
+  common::ErrnoError err = second.Open(sizeof(packet) * 8);
+  ASSERT_TRUE(err);  // live writer owns the name
+  ASSERT_EQ(err->GetErrorCode(), EEXIST);
+
+  iptv_cloud::utils::ShmRingReader fast(SHM_RING);
+  iptv_cloud::utils::ShmRingReader slow(SHM_RING);
+  ASSERT_FALSE(fast.Open());
+  ASSERT_FALSE(slow.Open());
+  ASSERT_EQ(fast.Read(data, sizeof(data)), 0u);
+
+  for (uint8_t cc = 0; cc < 20; ++cc) {
+    MakeTsPacket(packet, 0x100, cc);
+    ASSERT_TRUE(writer.Write(packet, sizeof(packet)));
+    ASSERT_EQ(fast.Read(data, sizeof(data)), sizeof(packet));
+    ASSERT_EQ(data[3] & 0x0F, cc & 0x0F);
+  }
+  iptv_cloud::utils::ShmRingFanout fanout = writer.GetFanout();
+  ASSERT_EQ(fanout.readers, 2u);
+  ASSERT_EQ(fanout.max_lag_bytes, sizeof(packet) * 20);
+  ASSERT_EQ(fanout.overruns, 0u);
+
+  // slow reader was lapped, continues from live edge on packet boundary
+  ASSERT_EQ(slow.Read(data, sizeof(data)), 0u);
+  ASSERT_EQ(slow.GetOverruns(), 1u);
+  MakeTsPacket(packet, 0x100, 20);
+  ASSERT_TRUE(writer.Write(packet, sizeof(packet)));
+  ASSERT_EQ(slow.Read(data, sizeof(data)), sizeof(packet));
+  ASSERT_EQ(data[0], iptv_cloud::utils::mpegts::TS_SYNC_BYTE);
+  ASSERT_EQ(data[3] & 0x0F, 20 & 0x0F);
+  fanout = writer.GetFanout();
+  ASSERT_EQ(fanout.max_lag_bytes, sizeof(packet));
+  ASSERT_EQ(fanout.overruns, 1u);
+  ASSERT_FALSE(writer.Write(data, fanout.capacity + 1));
+
+  slow.Close();
+  ASSERT_EQ(writer.GetFanout().readers, 1u);
+
+  // restarted writer replaces segment
+  ASSERT_FALSE(fast.IsStale());
+  writer.Close();
+  ASSERT_TRUE(fast.IsStale());
+  ASSERT_FALSE(writer.Open());
+  ASSERT_TRUE(fast.IsStale());
+  fast.Close();
+  ASSERT_FALSE(fast.Open());
+  ASSERT_FALSE(fast.IsStale());
+  ASSERT_TRUE(writer.Write(packet, sizeof(packet)));
+  ASSERT_EQ(fast.Read(data, sizeof(data)), sizeof(packet));
+  writer.Close();
+}
+
+TEST(ShmRing, concurrent_reader) {
+  const size_t packets_count = 100000;
+  iptv_cloud::utils::ShmRingWriter writer(SHM_RING);
+  ASSERT_FALSE(writer.Open(iptv_cloud::utils::mpegts::TS_PACKET_SIZE * 64));
+  iptv_cloud::utils::ShmRingReader reader(SHM_RING);
+  ASSERT_FALSE(reader.Open());
+
+  size_t received = 0;
+  size_t broken = 0;
+  std::atomic<bool> stop(false);
+  std::thread consumer([&]() {
+    uint8_t data[iptv_cloud::utils::mpegts::TS_PACKET_SIZE * 7];
+    while (true) {
+      const bool last = stop.load();
+      size_t readed = 0;
+      while ((readed = reader.Read(data, sizeof(data))) != 0) {
+        for (size_t i = 0; i < readed; i += iptv_cloud::utils::mpegts::TS_PACKET_SIZE) {
+          received++;
+          if (data[i] != iptv_cloud::utils::mpegts::TS_SYNC_BYTE || data[i + 1] != 0x01) {
+            broken++;
+          }
+        }
+      }
+      if (last) {
+        break;
+      }
+      reader.Wait(10);
+    }
+  });
+
+  uint8_t packet[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  for (size_t i = 0; i < packets_count; ++i) {
+    MakeTsPacket(packet, 0x100, i);
+    ASSERT_TRUE(writer.Write(packet, sizeof(packet)));
+    if (i % 16 == 0) {
+      std::this_thread::yield();
+    }
+  }
+  stop = true;
+  consumer.join();
+
+  ASSERT_EQ(broken, 0u);
+  ASSERT_GT(received, 0u);
+  ASSERT_LE(received, packets_count);
+  std::cout << packets_count << " packets, received: " << received << ", overruns: " << reader.GetOverruns()
+            << std::endl;
+  reader.Close();
+  writer.Close();
+}
+
+TEST(ShmRing, wait) {
+  uint8_t packet[iptv_cloud::utils::mpegts::TS_PACKET_SIZE];
+  iptv_cloud::utils::ShmRingWriter writer(SHM_RING);
+  ASSERT_FALSE(writer.Open(sizeof(packet) * 8));
+  iptv_cloud::utils::ShmRingReader reader(SHM_RING);
+  ASSERT_FALSE(reader.Open());
+  ASSERT_FALSE(reader.Wait(10));  // timeout without data
+
+  MakeTsPacket(packet, 0x100, 0);
+  std::thread producer([&writer, &packet]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    writer.Write(packet, sizeof(packet));
+  });
+  auto start = std::chrono::steady_clock::now();
+  ASSERT_TRUE(reader.Wait(10000));
+  ASSERT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));  // woken, not timed out
+  producer.join();
+  ASSERT_TRUE(reader.Wait(10000));  // unread data returns at once
+
+  uint8_t data[sizeof(packet)];
+  ASSERT_EQ(reader.Read(data, sizeof(data)), sizeof(packet));
+  reader.Close();
+  writer.Close();
+}
+
+TEST(HlsShmStore, put_get) {
+  iptv_cloud::utils::HlsShmStoreReader not_ready(HLS_SHM_STORE);
+  ASSERT_TRUE(not_ready.Open());
+
+  iptv_cloud::utils::HlsShmStoreWriter writer(HLS_SHM_STORE);
+  ASSERT_FALSE(writer.Open(4000, 4000));  // 4096, no growth
+  iptv_cloud::utils::HlsShmStoreReader reader(HLS_SHM_STORE);
+  ASSERT_FALSE(reader.Open());
+
+  const std::string playlist = "#EXTM3U\n";
+  const std::string segment(1500, 's');
+  ASSERT_FALSE(writer.Put("master.m3u8", reinterpret_cast<const uint8_t*>(playlist.data()), playlist.size()));
+  ASSERT_FALSE(writer.Put("master_0.ts", reinterpret_cast<const uint8_t*>(segment.data()), segment.size()));
+  ASSERT_TRUE(writer.Put("bad/name.ts", reinterpret_cast<const uint8_t*>(segment.data()), segment.size()));
+  std::string data;
+  ASSERT_TRUE(reader.Get("master.m3u8", &data));
+  ASSERT_EQ(data, playlist);
+  ASSERT_TRUE(reader.Get("master_0.ts", &data));
+  ASSERT_EQ(data, segment);
+  ASSERT_FALSE(reader.Exists("master_1.ts"));
+
+  const std::string new_playlist = "#EXTM3U\n#EXT-X-MEDIA-SEQUENCE:1\n";
+  ASSERT_FALSE(writer.Put("master.m3u8", reinterpret_cast<const uint8_t*>(new_playlist.data()), new_playlist.size()));
+  ASSERT_TRUE(reader.Get("master.m3u8", &data));
+  ASSERT_EQ(data, new_playlist);
+
+  // ring at max capacity evicts the first segment
+  ASSERT_FALSE(writer.Put("master_1.ts", reinterpret_cast<const uint8_t*>(segment.data()), segment.size()));
+  ASSERT_FALSE(writer.Put("master_2.ts", reinterpret_cast<const uint8_t*>(segment.data()), segment.size()));
+  ASSERT_FALSE(reader.Get("master_0.ts", &data));
+  ASSERT_TRUE(reader.Get("master_2.ts", &data));
+  ASSERT_EQ(data, segment);
+  ASSERT_FALSE(writer.Remove("master_2.ts"));
+  ASSERT_FALSE(reader.Exists("master_2.ts"));
+
+  ASSERT_FALSE(reader.IsStale());
+  writer.Close();
+  ASSERT_TRUE(reader.IsStale());
+  reader.Close();
+  ASSERT_EQ(iptv_cloud::utils::MakeHlsShmName("/hls/1/"), iptv_cloud::utils::MakeHlsShmName("/hls/1"));
+  ASSERT_NE(iptv_cloud::utils::MakeHlsShmName("/hls/1_2"), iptv_cloud::utils::MakeHlsShmName("/hls/1/2"));
+}
+
+TEST(HlsShmStore, grow) {
+  iptv_cloud::utils::HlsShmStoreWriter writer(HLS_SHM_STORE);
+  ASSERT_FALSE(writer.Open(4096, 16384));
+  iptv_cloud::utils::HlsShmStoreReader reader(HLS_SHM_STORE);
+  ASSERT_FALSE(reader.Open());
+
+  const std::string segment(1500, 's');
+  const std::string big(20000, 'b');
+  ASSERT_TRUE(writer.Put("big.ts", reinterpret_cast<const uint8_t*>(big.data()), big.size()));
+  for (size_t i = 0; i < 3; ++i) {
+    const std::string name = "master_" + std::to_string(i) + ".ts";
+    ASSERT_FALSE(writer.Put(name, reinterpret_cast<const uint8_t*>(segment.data()), segment.size()));
+  }
+
+  // the third segment would overwrite the first one, new segment has room for twice of listed files
+  ASSERT_EQ(writer.GetCapacity(), 16384u);
+  ASSERT_TRUE(reader.IsStale());
+  std::string data;
+  ASSERT_TRUE(reader.Get("master_1.ts", &data));  // old segment is still readable until reopen
+  reader.Close();
+  ASSERT_FALSE(reader.Open());
+  for (size_t i = 0; i < 3; ++i) {
+    ASSERT_TRUE(reader.Get("master_" + std::to_string(i) + ".ts", &data));
+    ASSERT_EQ(data, segment);
+  }
+
+  // removed by packager files free space, listed ones stay readable
+  for (size_t i = 3; i < 30; ++i) {
+    ASSERT_FALSE(writer.Remove("master_" + std::to_string(i - 3) + ".ts"));
+    const std::string name = "master_" + std::to_string(i) + ".ts";
+    ASSERT_FALSE(writer.Put(name, reinterpret_cast<const uint8_t*>(segment.data()), segment.size()));
+  }
+  ASSERT_EQ(writer.GetCapacity(), 16384u);
+  ASSERT_FALSE(reader.IsStale());
+  for (size_t i = 27; i < 30; ++i) {
+    ASSERT_TRUE(reader.Get("master_" + std::to_string(i) + ".ts", &data));
+  }
+
+  // at max capacity the oldest listed files are evicted
+  for (size_t i = 30; i < 40; ++i) {
+    const std::string name = "master_" + std::to_string(i) + ".ts";
+    ASSERT_FALSE(writer.Put(name, reinterpret_cast<const uint8_t*>(segment.data()), segment.size()));
+  }
+  ASSERT_EQ(writer.GetCapacity(), 16384u);
+  ASSERT_FALSE(reader.Exists("master_27.ts"));
+  ASSERT_TRUE(reader.Get("master_39.ts", &data));
+  ASSERT_EQ(data, segment);
+
+  reader.Close();
+  writer.Close();
+}
+
+TEST(AdoptSocket, pass_pipes) {
+  iptv_cloud::utils::AdoptListener listener(ADOPT_SOCKET);
+  ASSERT_FALSE(listener.Listen());
+  iptv_cloud::utils::AdoptRequest request;
+  common::ErrnoError err = listener.Accept(&request);
+  ASSERT_TRUE(err);
+  ASSERT_EQ(err->GetErrorCode(), EAGAIN);
+
+  for (bool accept : {false, true}) {
+    int pipefd[2];
+    ASSERT_EQ(pipe(pipefd), 0);
+    common::ErrnoError child_err;
+    pid_t service_pid = 0;
+    std::thread child([&child_err, &service_pid, pipefd] {
+      child_err =
+          iptv_cloud::utils::SendAdoptRequest(ADOPT_SOCKET, "{\"id\":\"1\"}", pipefd[0], pipefd[1], &service_pid);
+    });
+    while ((err = listener.Accept(&request)) && err->GetErrorCode() == EAGAIN) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    ASSERT_FALSE(err);
+    ASSERT_EQ(request.pid, getpid());
+    ASSERT_EQ(request.hello, "{\"id\":\"1\"}");
+    ASSERT_NE(request.read_fd, pipefd[0]);
+    iptv_cloud::utils::AdoptListener::Reply(&request, accept);
+    child.join();
+    ASSERT_EQ(static_cast<bool>(child_err), !accept);
+    if (accept) {  // passed descriptors are the same pipe
+      ASSERT_EQ(service_pid, getpid());
+      ASSERT_EQ(write(request.write_fd, "x", 1), 1);
+      char c = 0;
+      ASSERT_EQ(read(pipefd[0], &c, 1), 1);
+      ASSERT_EQ(c, 'x');
+      close(request.read_fd);
+      close(request.write_fd);
+    } else {
+      ASSERT_EQ(request.read_fd, INVALID_DESCRIPTOR);
+      ASSERT_EQ(request.write_fd, INVALID_DESCRIPTOR);
+    }
+    close(pipefd[0]);
+    close(pipefd[1]);
+  }
+  listener.Close();
+  pid_t service_pid = 0;
+  ASSERT_TRUE(iptv_cloud::utils::SendAdoptRequest(ADOPT_SOCKET, "{}", 0, 1, &service_pid));
+}
+
+TEST(AdoptSocket, child_closes_service_sockets) {
+  int listener = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_NE(listener, INVALID_DESCRIPTOR);
+  const int reuse = 1;
+  ASSERT_EQ(setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)), 0);
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  ASSERT_EQ(bind(listener, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)), 0);
+  ASSERT_EQ(listen(listener, SOMAXCONN), 0);
+  socklen_t addr_len = sizeof(addr);
+  ASSERT_EQ(getsockname(listener, reinterpret_cast<struct sockaddr*>(&addr), &addr_len), 0);
+
+  int ready[2];
+  ASSERT_EQ(pipe(ready), 0);
+  pid_t pid = fork();
+  ASSERT_NE(pid, -1);
+  if (pid == 0) {  // stream child waits for service restart
+    iptv_cloud::utils::CloseInheritedDescriptors({ready[1]});
+    const char c = fcntl(listener, F_GETFD) == -1 ? 1 : 0;
+    if (write(ready[1], &c, 1) != 1) {
+      _exit(EXIT_FAILURE);
+    }
+    pause();
+    _exit(EXIT_SUCCESS);
+  }
+  close(ready[1]);
+  char closed = 0;
+  ASSERT_EQ(read(ready[0], &closed, 1), 1);
+  close(ready[0]);
+  ASSERT_EQ(closed, 1);
+
+  // service restarted, binds the same port
+  close(listener);
+  int rebind = socket(AF_INET, SOCK_STREAM, 0);
+  ASSERT_NE(rebind, INVALID_DESCRIPTOR);
+  ASSERT_EQ(setsockopt(rebind, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)), 0);
+  const int bound = bind(rebind, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr));
+  const int listened = listen(rebind, SOMAXCONN);
+  close(rebind);
+  kill(pid, SIGKILL);
+  waitpid(pid, nullptr, 0);
+  ASSERT_EQ(bound, 0);
+  ASSERT_EQ(listened, 0);
+}